@@ -11,4 +11,28 @@ enum class FileMode
 bool LoadDataFromFile(const wchar_t* pFilePath, FileMode fileMode, std::vector<char>& loadedByteData);
 i64 GetFileSizeInBytes(HANDLE hFile);
 const std::wstring ExtractFileExtension(const std::wstring& filePath);
-const std::wstring ExtractFileNameWithExtension(const std::wstring& filePath);
\ No newline at end of file
+const std::wstring ExtractFileNameWithExtension(const std::wstring& filePath);
+
+// Read-only view of the whole file mapped into the address space of the process.
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile();
+	~MemoryMappedFile();
+
+	MemoryMappedFile(const MemoryMappedFile&) = delete;
+	MemoryMappedFile& operator= (const MemoryMappedFile&) = delete;
+
+	bool Open(const wchar_t* pFilePath);
+	void Close();
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const u8* GetData() const { return m_pData; }
+	u64 GetSizeInBytes() const { return m_SizeInBytes; }
+
+private:
+	HANDLE m_hFile;
+	HANDLE m_hFileMapping;
+	const u8* m_pData;
+	u64 m_SizeInBytes;
+};
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Common/Common.h"
+
+// Number of threads used by ParallelFor, including the calling thread.
+u32 GetNumWorkerThreads();
+
+// Calls func(itemIndex) for each item in [0, numItems) on the worker threads and returns when all the items have been processed.
+// Items are handed out one at a time, so items of different cost are balanced across the threads.
+// Items should not write to shared data without synchronization.
+void ParallelFor(u32 numItems, const std::function<void(u32 itemIndex)>& func);
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Common/Common.h"
+
+// Sub-allocates ranges of elements from a fixed capacity, such as the elements of a shared buffer.
+// Free ranges are kept sorted by offset and merged with their neighbours when a range is freed. Allocation is first fit.
+class RangeAllocator
+{
+public:
+	static const u32 kInvalidOffset = ~0u;
+
+	RangeAllocator(u32 capacity);
+
+	// Returns kInvalidOffset if there is no free range large enough.
+	u32 Allocate(u32 size);
+	void Free(u32 offset, u32 size);
+
+	u32 GetCapacity() const { return m_Capacity; }
+	u32 GetNumFreeElements() const { return m_NumFreeElements; }
+
+private:
+	u32 m_Capacity;
+	u32 m_NumFreeElements;
+	std::map<u32, u32> m_FreeRanges;
+};
\ No newline at end of file
@@ -524,14 +524,26 @@ struct TextureCopyLocation : public D3D12_TEXTURE_COPY_LOCATION
 	TextureCopyLocation(GraphicsResource* pGraphicsResource, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint);
 };
 
-template <typename DestBufferDesc>
-void UploadData(RenderEnv* pRenderEnv, Buffer* pDestBuffer, DestBufferDesc destBufferDesc,
-	D3D12_RESOURCE_STATES destBufferStateAfter, const void* pUploadData, SIZE_T numUploadBytes)
+// Lets writeFunc fill the mapped upload buffer directly, so the data does not need to be assembled in an intermediate buffer first.
+// writeFunc is called with void* pointer to numUploadBytes bytes of write-only memory.
+template <typename DestBufferDesc, typename WriteFunc>
+void UploadDataInPlace(RenderEnv* pRenderEnv, Buffer* pDestBuffer, DestBufferDesc destBufferDesc,
+	D3D12_RESOURCE_STATES destBufferStateAfter, SIZE_T numUploadBytes, WriteFunc writeFunc)
 {
 	destBufferDesc.Flags = D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
 
 	Buffer* pUploadBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pUploadHeapProps, &destBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, L"UploadData::pUploadBuffer");
-	pUploadBuffer->Write(pUploadData, numUploadBytes);
+	{
+		const UINT subresource = 0;
+
+		const MemoryRange readRange(0, 0);
+		void* pUploadData = pUploadBuffer->Map(subresource, &readRange);
+
+		writeFunc(pUploadData);
+
+		const MemoryRange writtenRange(0, numUploadBytes);
+		pUploadBuffer->Unmap(subresource, &writtenRange);
+	}
 
 	ResourceTransitionBarrier resourceTransitionBarrier(pDestBuffer, D3D12_RESOURCE_STATE_COPY_DEST, destBufferStateAfter);
 
@@ -546,4 +558,12 @@ void UploadData(RenderEnv* pRenderEnv, Buffer* pDestBuffer, DestBufferDesc destB
 	pRenderEnv->m_pFence->WaitForSignalOnCPU(pRenderEnv->m_LastSubmissionFenceValue);
 
 	SafeDelete(pUploadBuffer);
+}
+
+template <typename DestBufferDesc>
+void UploadData(RenderEnv* pRenderEnv, Buffer* pDestBuffer, DestBufferDesc destBufferDesc,
+	D3D12_RESOURCE_STATES destBufferStateAfter, const void* pUploadData, SIZE_T numUploadBytes)
+{
+	UploadDataInPlace(pRenderEnv, pDestBuffer, destBufferDesc, destBufferStateAfter, numUploadBytes,
+		[pUploadData, numUploadBytes](void* pMappedData) { CopyMemory(pMappedData, pUploadData, numUploadBytes); });
 } 
\ No newline at end of file
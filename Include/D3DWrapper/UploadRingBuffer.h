@@ -0,0 +1,45 @@
+#pragma once
+
+#include "D3DWrapper/Common.h"
+
+struct RenderEnv;
+class Buffer;
+class Fence;
+
+// Persistently mapped upload buffer which is sub-allocated as a ring, so that per-frame uploads
+// can be recorded into the frame command list without creating a buffer or waiting on CPU.
+// Allocations made before FinishFrame are reused once the fence has reached the value passed to FinishFrame.
+class UploadRingBuffer
+{
+public:
+	UploadRingBuffer(RenderEnv* pRenderEnv, UINT64 sizeInBytes, LPCWSTR pName);
+	~UploadRingBuffer();
+
+	// Returns the CPU address of the allocation and its offset in the buffer in pOffsetInBytes.
+	// Returns nullptr if the ring has no room until the uploads of earlier frames have completed on GPU.
+	u8* Allocate(UINT64 sizeInBytes, UINT64 alignment, UINT64* pOffsetInBytes);
+
+	// Tags the allocations since the previous call with the fence value signaled after the frame which reads them.
+	void FinishFrame(UINT64 fenceValue);
+	void ReleaseCompletedFrames(Fence* pFence);
+
+	Buffer* GetBuffer() { return m_pBuffer; }
+	UINT64 GetSizeInBytes() const { return m_SizeInBytes; }
+
+private:
+	struct FrameAllocations
+	{
+		UINT64 m_FenceValue;
+		UINT64 m_EndOffset;
+		UINT64 m_SizeInBytes;
+	};
+
+	Buffer* m_pBuffer;
+	u8* m_pMappedData;
+	UINT64 m_SizeInBytes;
+	UINT64 m_HeadOffset;
+	UINT64 m_TailOffset;
+	UINT64 m_NumUsedBytes;
+	UINT64 m_NumCurrentFrameBytes;
+	std::queue<FrameAllocations> m_PendingFrames;
+};
\ No newline at end of file
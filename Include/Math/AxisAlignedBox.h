@@ -2,6 +2,8 @@
 
 #include "Math/Vector3.h"
 
+struct Matrix4f;
+
 struct AxisAlignedBox
 {
 	AxisAlignedBox();
@@ -12,3 +14,8 @@ struct AxisAlignedBox
     Vector3f m_Center;
     Vector3f m_Radius;
 };
+
+
+// Bounds of the box transformed with the affine matrix, found without transforming the box corners
+// (Jim Arvo, "Transforming Axis-Aligned Bounding Boxes").
+const AxisAlignedBox TransformAxisAlignedBox(const AxisAlignedBox& box, const Matrix4f& matrix);
\ No newline at end of file
@@ -111,4 +111,8 @@ f32 SmootherStep(f32 minValue, f32 maxValue, f32 value);
 f64 SmootherStep(f64 minValue, f64 maxValue, f64 value);
 
 f32 SmoothestStep(f32 minValue, f32 maxValue, f32 value);
-f64 SmoothestStep(f64 minValue, f64 maxValue, f64 value);
\ No newline at end of file
+f64 SmoothestStep(f64 minValue, f64 maxValue, f64 value);
+
+// Interleaves the lower 10 bits of the coordinates into a 30-bit Morton code, so that sorting by the code
+// keeps nearby points close together.
+u32 EncodeMortonCode(u32 x, u32 y, u32 z);
\ No newline at end of file
@@ -11,4 +11,8 @@ struct OrientedBox
 	Vector3f m_Center;
 	BasisAxes m_Orientation;
 	Vector3f m_Radius;
-};
\ No newline at end of file
+};
+
+// Box transformed with the affine matrix. The transformed axes are orthonormalized and the radius is extended
+// to enclose the transformed box, so the result is exact for rotation, translation and uniform scaling.
+const OrientedBox TransformOrientedBox(const OrientedBox& box, const Matrix4f& matrix);
\ No newline at end of file
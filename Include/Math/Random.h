@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Common/Common.h"
+
+// PCG32 generator (M. E. O'Neill, "PCG: A Family of Simple Fast Space-Efficient Statistically Good Algorithms for Random Number Generation").
+// Sequences with different stream indices are independent for the same seed.
+class Random
+{
+public:
+	Random(u64 seed, u64 streamIndex);
+
+	u32 NextU32();
+	// Uniform in [0, bound).
+	u32 NextU32(u32 bound);
+	// Uniform in [0, 1).
+	f32 NextFloat();
+	f32 NextFloat(f32 minValue, f32 maxValue);
+	// Standard normal distribution.
+	f32 NextGaussian();
+
+private:
+	u64 m_State;
+	u64 m_Increment;
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "D3DWrapper/GraphicsResource.h"
+#include "RenderPasses/ShadowMapAtlas.h"
 
 struct RenderEnv;
 class CommandList;
@@ -43,6 +44,7 @@ public:
 		ColorTexture* m_pExpShadowMaps = nullptr;
 		u32 m_StandardShadowMapIndex = -1;
 		u32 m_ExpShadowMapIndex = -1;
+		ShadowMapTile m_ExpShadowMapTile;
 	};
 
 	CreateExpShadowMapPass(InitParams* pParams);
@@ -61,7 +63,4 @@ private:
 	PipelineState* m_pPipelineState = nullptr;
 	DescriptorHandle m_SRVHeapStart;
 	ResourceStates m_OutputResourceStates;
-
-	u32 m_NumThreadGroupsX = 0;
-	u32 m_NumThreadGroupsY = 0;
 };
\ No newline at end of file
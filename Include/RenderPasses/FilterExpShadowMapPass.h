@@ -1,6 +1,7 @@
 #pragma once
 
 #include "D3DWrapper/GraphicsResource.h"
+#include "RenderPasses/ShadowMapAtlas.h"
 
 struct RenderEnv;
 class CommandList;
@@ -20,6 +21,7 @@ public:
 		RenderEnv* m_pRenderEnv = nullptr;
 		ResourceStates m_InputResourceStates;
 		u32 m_MaxNumActiveExpShadowMaps = 0;
+		u32 m_MaxExpShadowMapSize = 0;
 		ColorTexture* m_pExpShadowMaps = nullptr;
 	};
 
@@ -28,7 +30,7 @@ public:
 		RenderEnv* m_pRenderEnv = nullptr;
 		CommandList* m_pCommandList = nullptr;
 		ColorTexture* m_pExpShadowMaps = nullptr;
-		u32 m_ExpShadowMapIndex = -1;
+		ShadowMapTile m_ExpShadowMapTile;
 		u32 m_IntermediateResultIndex = -1;
 	};
 
@@ -49,8 +51,6 @@ private:
 	DescriptorHandle m_SRVHeapStartX;
 	PipelineState* m_pPipelineStateY = nullptr;
 	DescriptorHandle m_SRVHeapStartY;
-	u32 m_NumThreadGroupsX = 0;
-	u32 m_NumThreadGroupsY = 0;
 
 	ColorTexture* m_pIntermediateResults = nullptr;
 	ResourceStates m_OutputResourceStates;
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "D3DWrapper/PipelineState.h"
+#include "Math/AxisAlignedBox.h"
+#include "Scene/MeshBatch.h"
 
 class Buffer;
-class MeshBatch;
+class CommandList;
+class UploadRingBuffer;
 struct RenderEnv;
 
 struct MeshRenderInfo
@@ -28,10 +31,57 @@ struct MeshRenderInfo
 	i32 m_BaseVertexLocation;
 };
 
+// Vertex attribute streams of a vertex range. Attributes which are not part of the vertex format are nullptr.
+struct MeshVertexStreams
+{
+	const Vector3f* m_pPositions = nullptr;
+	const Vector3f* m_pNormals = nullptr;
+	const Vector4f* m_pColors = nullptr;
+	const Vector3f* m_pTangents = nullptr;
+	const Vector2f* m_pTexCoords = nullptr;
+};
+
+// Vertices and indices of a mesh range in the GPU format of the mesh type
+// together with their destination in the vertex and index buffers.
+struct MeshGeometryUpload
+{
+	u32 m_MeshType;
+	u32 m_FirstVertex;
+	u32 m_NumVertices;
+	u32 m_FirstIndex;
+	u32 m_NumIndices;
+	const u8* m_pVertexData;
+	const u8* m_pPositionData;
+	const void* m_pIndexData;
+};
+
+// New draw arguments of the mesh. meshIndex is relative to the first mesh of the first mesh type.
+struct MeshRenderInfoUpdate
+{
+	MeshRenderInfoUpdate(u32 meshIndex, u32 numInstances, u32 startIndexLocation, i32 baseVertexLocation)
+		: m_MeshIndex(meshIndex)
+		, m_NumInstances(numInstances)
+		, m_StartIndexLocation(startIndexLocation)
+		, m_BaseVertexLocation(baseVertexLocation)
+	{}
+	u32 m_MeshIndex;
+	u32 m_NumInstances;
+	u32 m_StartIndexLocation;
+	i32 m_BaseVertexLocation;
+};
+
 class MeshRenderResources
 {
 public:
+	// The vertex and index streams of the mesh batches are not read once the constructor returns,
+	// so they can be released afterwards (see MeshBatch::ReleaseGeometry).
 	MeshRenderResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType);
+
+	// Streaming mode. The vertex and index buffers of all mesh types share geometryBudgetInBytes in proportion to the size
+	// of their full geometry and are left empty. Every mesh starts with zero instances, so that the culling passes skip it
+	// until its geometry has been uploaded with UpdateStreamedMeshes. Instance buffers are uploaded in full as in the default mode.
+	MeshRenderResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType, u64 geometryBudgetInBytes);
+
 	~MeshRenderResources();
 
 	u32 GetNumMeshTypes() const { return m_NumMeshTypes; }
@@ -43,22 +93,63 @@ public:
 	Buffer* GetInstanceWorldMatrixBuffer() { return m_pInstanceWorldMatrixBuffer; }
 	Buffer* GetInstanceWorldAABBBuffer() { return m_pInstanceWorldAABBBuffer; }
 	Buffer* GetInstanceWorldOBBMatrixBuffer() { return m_pInstanceWorldOBBMatrixBuffer; }
+	// Dequantization ranges of the mesh of each instance, as vertex shaders only know the instance index.
+	Buffer* GetInstanceVertexQuantizationBuffer() { return m_pInstanceVertexQuantizationBuffer; }
 
+	// Current draw arguments of the mesh, which follow the residency of the mesh in streaming mode. meshIndex is relative to the first mesh of the first mesh type.
+	const MeshRenderInfo& GetMeshRenderInfo(u32 meshIndex) const { return m_MeshInfos[meshIndex]; }
 	u32 GetMeshTypeOffset(u32 meshType) const { return m_MeshTypeOffsets[meshType]; }
+	u32 GetNumMeshes(u32 meshType) const { return ((meshType + 1 < m_NumMeshTypes) ? m_MeshTypeOffsets[meshType + 1] : m_TotalNumMeshes) - m_MeshTypeOffsets[meshType]; }
+	// Index of the first instance of the mesh type in the instance buffers.
+	u32 GetMeshTypeInstanceOffset(u32 meshType) const { return m_MeshTypeInstanceOffsets[meshType]; }
 	const InputLayoutDesc& GetInputLayout(u32 meshType) const { return m_InputLayouts[meshType]; }
+	// Input layout of the vertex buffer which contains only positions, for the passes which output depth only.
+	const InputLayoutDesc& GetPositionInputLayout(u32 meshType) const { return m_PositionInputLayouts[meshType]; }
+	u8 GetVertexFormatFlags(u32 meshType) const { return m_VertexFormatFlags[meshType]; }
+	u8 GetVertexCompressionFlags(u32 meshType) const { return m_VertexCompressionFlags[meshType]; }
 	D3D12_PRIMITIVE_TOPOLOGY_TYPE GetPrimitiveTopologyType(u32 meshType) const { return m_PrimitiveTopologyTypes[meshType]; }
 	D3D12_PRIMITIVE_TOPOLOGY GetPrimitiveTopology(u32 meshType) const { return m_PrimitiveTopologies[meshType]; }
 	Buffer* GetVertexBuffer(u32 meshType) { return m_VertexBuffers[meshType]; }
+	Buffer* GetPositionVertexBuffer(u32 meshType) { return m_PositionVertexBuffers[meshType]; }
 	Buffer* GetIndexBuffer(u32 meshType) { return m_IndexBuffers[meshType]; }
+	u32 GetVertexStrideInBytes(u32 meshType) const { return m_VertexStrideInBytes[meshType]; }
+	u32 GetPositionVertexStrideInBytes(u32 meshType) const { return m_PositionVertexStrideInBytes[meshType]; }
+	u32 GetIndexStrideInBytes(u32 meshType) const { return m_IndexStrideInBytes[meshType]; }
+	u32 GetVertexCapacity(u32 meshType) const { return m_VertexCapacities[meshType]; }
+	u32 GetIndexCapacity(u32 meshType) const { return m_IndexCapacities[meshType]; }
+	
+	// Encodes the vertices of the mesh into the interleaved layout of the vertex buffer and into the layout of the position only vertex buffer.
+	// meshIndex is relative to the first mesh of the mesh type and selects the quantization ranges.
+	// pVertexData should have room for numVertices * GetVertexStrideInBytes(meshType) bytes
+	// and pPositionData for numVertices * GetPositionVertexStrideInBytes(meshType) bytes.
+	// Only reads the vertex layout, so it can be called from any thread.
+	void EncodeVertices(u32 meshType, u32 meshIndex, u32 numVertices, const MeshVertexStreams& streams, u8* pVertexData, u8* pPositionData) const;
+
+	// Copies world matrices and world bounds of the given instances of the mesh type to the instance buffers.
+	// The arrays are indexed as the instances of the mesh batch (see SceneSnapshot::GetMeshInstanceWorldMatrices).
+	// Only the ranges are uploaded, the rest of the buffers is left untouched.
+	// The data is written to pUploadRing and the copies are recorded into pCommandList, which should be the frame command list
+	// executed before the passes reading the instance buffers. The caller calls FinishFrame on the ring with the fence value of the frame.
+	void UpdateMeshInstances(CommandList* pCommandList, UploadRingBuffer* pUploadRing, u32 meshType, const Matrix4f* pInstanceWorldMatrices,
+		const AxisAlignedBox* pInstanceWorldAABBs, const OrientedBox* pInstanceWorldOBBs, const std::vector<MeshBatch::MeshInstanceRange>& instanceRanges);
+
+	// Streaming mode only. Copies the geometry into the vertex and index buffers and then replaces the draw arguments of the meshes.
+	// The data is written to pUploadRing and the copies are recorded into pCommandList as in UpdateMeshInstances.
+	// Geometry of a mesh should be uploaded before or together with the update which gives the mesh instances.
+	// A buffer range should be reused only after the meshes drawn from it have been given zero instances
+	// and the frames which drew them have completed on GPU.
+	void UpdateStreamedMeshes(CommandList* pCommandList, UploadRingBuffer* pUploadRing, const std::vector<MeshGeometryUpload>& geometryUploads,
+		const std::vector<MeshRenderInfoUpdate>& meshInfoUpdates);
 
 private:
-	void InitPerMeshResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType);
+	void InitPerMeshResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType, bool streaming);
 	void InitPerMeshInstanceResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType);
-	void InitPerMeshTypeResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType);
+	void InitPerMeshTypeResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType, const u64* pGeometryBudgetInBytes);
 
 	void InitInputLayout(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch);
 	void InitVertexBuffer(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch);
 	void InitIndexBuffer(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch);
+	void InitEmptyGeometryBuffers(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch);
 
 private:
 	u32 m_NumMeshTypes;
@@ -70,15 +161,49 @@ private:
 	Buffer* m_pInstanceWorldMatrixBuffer;
 	Buffer* m_pInstanceWorldAABBBuffer;
 	Buffer* m_pInstanceWorldOBBMatrixBuffer;
+	Buffer* m_pInstanceVertexQuantizationBuffer;
+	std::vector<MeshRenderInfo> m_MeshInfos;
+	std::vector<VertexQuantization> m_MeshVertexQuantizations;
 
 	using InputElements = std::vector<InputElementDesc>;
 	
 	std::vector<u32> m_MeshTypeOffsets;
+	std::vector<u32> m_MeshTypeInstanceOffsets;
 	std::vector<u32> m_VertexStrideInBytes;
+	std::vector<u32> m_PositionVertexStrideInBytes;
+	std::vector<u32> m_IndexStrideInBytes;
+	std::vector<u32> m_VertexCapacities;
+	std::vector<u32> m_IndexCapacities;
+	std::vector<u8> m_VertexFormatFlags;
+	std::vector<u8> m_VertexCompressionFlags;
 	std::vector<InputElements> m_InputElements;
 	std::vector<InputLayoutDesc> m_InputLayouts;
+	std::vector<InputElements> m_PositionInputElements;
+	std::vector<InputLayoutDesc> m_PositionInputLayouts;
 	std::vector<D3D12_PRIMITIVE_TOPOLOGY_TYPE> m_PrimitiveTopologyTypes;
 	std::vector<D3D12_PRIMITIVE_TOPOLOGY> m_PrimitiveTopologies;
 	std::vector<Buffer*> m_VertexBuffers;
+	std::vector<Buffer*> m_PositionVertexBuffers;
 	std::vector<Buffer*> m_IndexBuffers;
 };
+
+// Shader defines which select vertex attribute decoding of the mesh type in VertexDecoding.hlsl.
+class VertexDecodingDefines
+{
+public:
+	VertexDecodingDefines(const MeshRenderResources* pMeshRenderResources, u32 meshType);
+
+	VertexDecodingDefines(const VertexDecodingDefines&) = delete;
+	VertexDecodingDefines& operator= (const VertexDecodingDefines&) = delete;
+
+	const ShaderDefine* GetDefines() const { return m_Defines.data(); }
+	u32 GetNumDefines() const { return m_Defines.size(); }
+
+private:
+	std::wstring m_PositionUNORM16Str;
+	std::wstring m_NormalOctahedralStr;
+	std::wstring m_TangentOctahedralStr;
+	std::wstring m_TexCoordUNORM16Str;
+	std::wstring m_HasTexCoordsStr;
+	std::vector<ShaderDefine> m_Defines;
+};
\ No newline at end of file
@@ -74,7 +74,7 @@ private:
 private:
 	std::string m_Name;
 	RootSignature* m_pRootSignature = nullptr;
-	PipelineState* m_pPipelineState = nullptr;
+	std::vector<PipelineState*> m_PipelineStates;
 	CommandSignature* m_pCommandSignature = nullptr;
 	DescriptorHandle m_SRVHeapStartVS;
 	DescriptorHandle m_RTVHeapStart;
@@ -16,6 +16,12 @@ struct ShadowMapCommand
 	DrawIndexedArguments m_Args;
 };
 
+struct ShadowMapCommandRange
+{
+	UINT64 m_FirstCommand = 0;
+	UINT m_NumCommands = 0;
+};
+
 class RenderSpotLightShadowMapPass
 {
 public:
@@ -46,11 +52,15 @@ public:
 		CommandList* m_pCommandList = nullptr;
 		MeshRenderResources* m_pMeshRenderResources = nullptr;
 		DepthTexture* m_pSpotLightShadowMaps = nullptr;
+		// State of the rendered slice. The slice is left in the output state.
+		D3D12_RESOURCE_STATES m_SpotLightShadowMapState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
 		Buffer* m_pRenderCommandBuffer = nullptr;
-		UINT64 m_FirstRenderCommand = 0;
-		UINT m_NumRenderCommands = 0;
+		// One command range per mesh type. Empty ranges are skipped.
+		const ShadowMapCommandRange* m_pRenderCommandRanges = nullptr;
 		UINT m_SpotLightIndex = -1;
 		UINT m_ShadowMapIndex = -1;
+		UINT m_ShadowMapSize = 0;
+		bool m_ClearShadowMap = true;
 	};
 
 	RenderSpotLightShadowMapPass(InitParams* pParams);
@@ -67,7 +77,7 @@ private:
 
 private:
 	RootSignature* m_pRootSignature = nullptr;
-	PipelineState* m_pPipelineState = nullptr;
+	std::vector<PipelineState*> m_PipelineStates;
 	CommandSignature* m_pCommandSignature = nullptr;
 	DescriptorHandle m_SRVHeapStartVS;
 	ResourceStates m_OutputResourceStates;
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Common/RangeAllocator.h"
+#include "RenderPasses/MeshRenderResources.h"
+#include "Scene/SceneChunks.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Scene;
+class CommandList;
+class Fence;
+class UploadRingBuffer;
+struct RenderEnv;
+
+struct SceneStreamingParams
+{
+	// Edge length of the grid cells the scene is split into, in world units.
+	f32 m_ChunkSize = 100.0f;
+	// Chunks whose bounds are farther from the camera are not kept resident.
+	f32 m_StreamingDistance = 1000.0f;
+	// Size of the vertex and index buffers shared by the resident chunks.
+	u64 m_GPUMemoryBudgetInBytes = 256ull << 20;
+	// Chunk data read and encoded on the worker thread which has not been uploaded yet.
+	u64 m_CPUMemoryBudgetInBytes = 64ull << 20;
+	// Chunk geometry is read from the chunk file only, so the vertex and index streams of the mesh batches
+	// can be released once the file has been opened (see MeshBatch::ReleaseGeometry).
+	bool m_ReleaseMeshBatchGeometry = false;
+};
+
+// Keeps the geometry of the scene chunks nearest to the camera resident within the GPU memory budget.
+// The chunks are sub-allocated from the shared vertex and index buffers of the mesh render resources, which are created in streaming mode.
+// Chunk geometry is read from the chunk file and encoded into the GPU vertex format on a worker thread,
+// and uploaded on the calling thread by Update. Meshes of the chunks which are not resident have zero instances and are not drawn.
+class SceneStreamer
+{
+public:
+	// The chunk file is written from the mesh batches if it does not exist or was written for a different chunk layout.
+	// If the file can be neither written nor opened, the geometry of all the chunks is kept resident instead of being streamed,
+	// regardless of the GPU memory budget.
+	SceneStreamer(RenderEnv* pRenderEnv, Scene* pScene, const wchar_t* pChunkFilePath, const SceneStreamingParams& params);
+	~SceneStreamer();
+
+	SceneStreamer(const SceneStreamer&) = delete;
+	SceneStreamer& operator= (const SceneStreamer&) = delete;
+
+	MeshRenderResources* GetMeshRenderResources() { return m_pMeshRenderResources; }
+	bool IsStreaming() const { return (m_pChunkFile != nullptr); }
+
+	// Should be called once a frame before the passes are recorded. Unloads the chunks which no longer fit into the budget
+	// around the camera, uploads the chunks loaded since the last call and requests the nearest missing chunks from the worker thread.
+	// The uploads are recorded into pCommandList, which should be executed before the passes drawing the meshes.
+	// Returns true if the draw arguments of any mesh have changed.
+	bool Update(RenderEnv* pRenderEnv, CommandList* pCommandList, UploadRingBuffer* pUploadRing, const Vector3f& cameraWorldPosition);
+
+	// Should be called once the frame which recorded Update has been submitted with fenceValue.
+	// The buffer ranges of the chunks evicted in the frame are reused only after the fence has been signaled.
+	void FinishFrame(UINT64 fenceValue);
+
+	u32 GetNumChunks() const { return m_Chunks.size(); }
+	const SceneChunk& GetChunk(u32 chunkIndex) const { return m_Chunks[chunkIndex]; }
+	bool IsChunkResident(u32 chunkIndex) const { return (m_ChunkStates[chunkIndex].m_State == ChunkState::Resident); }
+
+	// Number of resident chunks which reference the material, so that material resources can follow the chunk residency.
+	u32 GetMaterialRefCount(u32 materialID) const { return m_MaterialRefCounts[materialID]; }
+
+	u32 GetNumResidentChunks() const { return m_NumResidentChunks; }
+	u64 GetResidentSizeInBytes() const { return m_ResidentSizeInBytes; }
+
+private:
+	enum class ChunkState
+	{
+		Unloaded,
+		Loading,
+		Resident
+	};
+
+	struct ChunkStreamingState
+	{
+		ChunkState m_State = ChunkState::Unloaded;
+		bool m_Wanted = false;
+		// The free space of the mesh type was too fragmented for the chunk and no ranges were being freed.
+		// The chunk is not requested again until a range of its mesh type has been freed.
+		bool m_AwaitingFree = false;
+		f32 m_CameraDistance = 0.0f;
+		u32 m_FirstVertex = RangeAllocator::kInvalidOffset;
+		u32 m_FirstIndex = RangeAllocator::kInvalidOffset;
+		u64 m_SizeInBytes = 0;
+	};
+
+	struct PendingFree
+	{
+		UINT64 m_FenceValue = 0;
+		u32 m_MeshType = 0;
+		u32 m_FirstVertex = 0;
+		u32 m_NumVertices = 0;
+		u32 m_FirstIndex = 0;
+		u32 m_NumIndices = 0;
+	};
+
+	struct LoadedChunk
+	{
+		u32 m_ChunkIndex;
+		std::vector<u8> m_VertexData;
+		std::vector<u8> m_PositionData;
+		std::vector<u8> m_IndexData;
+	};
+
+	void InitChunkSizes();
+	void MakeAllChunksResident();
+	void SelectWantedChunks(const Vector3f& cameraWorldPosition);
+	void CancelLoadRequests();
+	bool AllocateChunk(u32 chunkIndex, std::vector<MeshRenderInfoUpdate>* pMeshInfoUpdates);
+	void MakeChunkResident(u32 chunkIndex, std::vector<MeshRenderInfoUpdate>* pMeshInfoUpdates);
+	void EvictChunk(u32 chunkIndex, std::vector<MeshRenderInfoUpdate>* pMeshInfoUpdates);
+	void ReleaseCompletedFrees(Fence* pFence);
+	bool HasPendingFrees(u32 meshType) const;
+	void RequestChunkLoads();
+
+	void RunWorkerThread();
+	LoadedChunk* LoadChunk(u32 chunkIndex) const;
+
+private:
+	SceneStreamingParams m_Params;
+	Scene* m_pScene;
+	MeshRenderResources* m_pMeshRenderResources;
+	SceneChunkFile* m_pChunkFile;
+	
+	std::vector<SceneChunk> m_Chunks;
+	std::vector<ChunkStreamingState> m_ChunkStates;
+	std::vector<u32> m_ChunksByDistance;
+	std::vector<RangeAllocator> m_VertexAllocators;
+	std::vector<RangeAllocator> m_IndexAllocators;
+	std::vector<u32> m_MaterialRefCounts;
+	u32 m_NumResidentChunks;
+	u64 m_ResidentSizeInBytes;
+	u64 m_LoadingSizeInBytes;
+	std::vector<PendingFree> m_UnsubmittedFrees;
+	std::deque<PendingFree> m_PendingFrees;
+
+	// Shared with the worker thread.
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkerCondition;
+	std::deque<u32> m_LoadRequests;
+	std::vector<LoadedChunk*> m_LoadedChunks;
+	bool m_ExitWorkerThread;
+	std::thread m_WorkerThread;
+};
\ No newline at end of file
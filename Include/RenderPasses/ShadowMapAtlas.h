@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Math/Vector3.h"
+#include "Math/Vector4.h"
+#include "Math/Sphere.h"
+
+struct ShadowMapTile
+{
+	u32 m_X = 0;
+	u32 m_Y = 0;
+	u32 m_Size = 0;
+};
+
+// Packs square power-of-two shadow map tiles into a single square atlas using a quad-tree.
+// Each light owns at most one tile. Tiles are kept in place between updates as long as
+// the requested size of the light does not change, so only lights with a new tile need their shadow map re-rendered.
+// The class is independent of the graphics API.
+
+class ShadowMapAtlas
+{
+public:
+	ShadowMapAtlas(u32 atlasSize, u32 minTileSize, u32 maxTileSize, u32 numLights);
+
+	// Lights which are not listed as active release their tiles.
+	// Indices of lights which have been assigned a new tile are returned in pReallocatedLightIndices.
+	void Update(u32 numActiveLights, const u32* pActiveLightIndices, const u32* pRequestedTileSizes,
+		std::vector<u32>* pReallocatedLightIndices);
+
+	u32 GetAtlasSize() const { return m_AtlasSize; }
+	bool HasTile(u32 lightIndex) const { return (m_LightTiles[lightIndex].m_Size > 0); }
+	const ShadowMapTile& GetTile(u32 lightIndex) const { return m_LightTiles[lightIndex]; }
+
+	// Returns offset (xy) and scale (zw) which map [0, 1] shadow map texture coordinates to the texel centers of the light tile in the atlas.
+	Vector4f CalcTileTexCoordRect(u32 lightIndex) const;
+
+private:
+	enum NodeState : u8
+	{
+		NodeState_Free = 0,
+		NodeState_Split,
+		NodeState_Allocated
+	};
+
+	bool AllocateTile(u32 tileSize, ShadowMapTile* pTile);
+	bool AllocateNode(u32 nodeIndex, u32 nodeX, u32 nodeY, u32 nodeSize, u32 tileSize, ShadowMapTile* pTile);
+
+	void FreeTile(const ShadowMapTile& tile);
+	void FreeNode(u32 nodeIndex, u32 nodeX, u32 nodeY, u32 nodeSize, const ShadowMapTile& tile);
+
+	void Repack(u32 numActiveLights, const u32* pActiveLightIndices, std::vector<u32>* pReallocatedLightIndices);
+
+private:
+	u32 m_AtlasSize;
+	u32 m_MinTileSize;
+	u32 m_MaxTileSize;
+
+	// Complete quad-tree stored in breadth-first order. Children of node i are 4 * i + 1, ..., 4 * i + 4.
+	std::vector<u8> m_NodeStates;
+
+	std::vector<ShadowMapTile> m_LightTiles;
+	std::vector<u32> m_LightRequestedTileSizes;
+	std::vector<u8> m_IsLightActive;
+};
+
+// Chooses power-of-two shadow map size proportional to the screen height covered by the light bounds.
+u32 CalcSpotLightShadowMapSize(const Sphere& lightWorldBounds, const Vector3f& cameraWorldPos, f32 cameraProjMatrix11,
+	u32 screenHeight, u32 minShadowMapSize, u32 maxShadowMapSize);
\ No newline at end of file
@@ -1,16 +1,20 @@
 #pragma once
 
 #include "D3DWrapper/GraphicsResource.h"
+#include "RenderPasses/RenderSpotLightShadowMapPass.h"
+#include "Math/Frustum.h"
+#include "Math/Vector4.h"
+#include "Scene/MeshBatch.h"
 
 struct RenderEnv;
 class SpotLight;
-class MeshBatch;
 class MeshRenderResources;
 class CommandList;
+class UploadRingBuffer;
 
-class RenderSpotLightShadowMapPass;
 class CreateExpShadowMapPass;
 class FilterExpShadowMapPass;
+class ShadowMapAtlas;
 
 class SpotLightShadowMapRenderer
 {
@@ -30,7 +34,9 @@ public:
 		u32 m_NumStaticMeshTypes;
 		MeshBatch** m_ppStaticMeshBatches;
 		MeshRenderResources* m_pStaticMeshRenderResources;
+		u32 m_MinShadowMapSize;
 		u32 m_ShadowMapSize;
+		u32 m_ShadowMapAtlasSize;
 	};
 
 	struct RenderParams
@@ -45,6 +51,19 @@ public:
 	SpotLightShadowMapRenderer(InitParams* pParams);
 	~SpotLightShadowMapRenderer();
 
+	// Assigns atlas tiles to the active lights. Should be called before Record for the same set of active lights.
+	void UpdateShadowMapAtlas(u32 numActiveSpotLights, const u32* pActiveSpotLightIndices, const u32* pRequestedShadowMapSizes);
+	Vector4f CalcShadowMapAtlasRect(u32 lightIndex) const;
+
+	// Should be called when the draw arguments of the static meshes have changed, e.g. after SceneStreamer::Update has returned true.
+	// Records the upload of the shadow caster commands into pCommandList and invalidates the cached shadow maps of the affected lights.
+	void UpdateMeshResidency(CommandList* pCommandList, UploadRingBuffer* pUploadRing, const MeshRenderResources* pMeshRenderResources);
+
+	// Should be called with the instances of the mesh type moved since the last call (see MeshBatch::ExtractDirtyMeshInstanceRanges)
+	// and the world bounds of all the instances of the mesh type. Only the lights whose frustum overlaps the previous
+	// or the new bounds of a moved dynamic instance get their shadow maps refreshed.
+	void UpdateMeshInstances(u32 meshType, const AxisAlignedBox* pMeshInstanceWorldAABBs, const std::vector<MeshBatch::MeshInstanceRange>& instanceRanges);
+
 	void Record(RenderParams* pParams);
 	const ResourceStates* GetOutputResourceStates() const { return &m_OutputResourceStates; }
 
@@ -56,27 +75,46 @@ private:
 		UpToDate,
 		Outdated
 	};
-	struct CommandRange
-	{
-		UINT64 m_FirstCommand;
-		UINT m_NumCommands;
-	};
-
 	void InitResources(InitParams* pParams);
 	void InitRenderSpotLightShadowMapPass(InitParams* pParams);
 	void InitCreateExpShadowMapPass(InitParams* pParams);
 	void InitFilterExpShadowMapPass(InitParams* pParams);
 
+	void RenderStaticShadowMap(RenderParams* pParams, u32 lightIndex, u32 shadowMapSize);
+	void CopyStaticShadowMap(RenderParams* pParams, u32 lightIndex, u32 activeShadowMapIndex);
+
 private:
 	DepthTexture* m_pActiveShadowMaps = nullptr;
+
+	// Depth of static shadow casters only, one slice per light.
+	// Each time the shadow map is refreshed, the cached depth is copied into the active shadow map
+	// and only dynamic shadow casters are rendered on top of it.
+	DepthTexture* m_pStaticShadowMaps = nullptr;
+	std::vector<ShadowMapState> m_StaticShadowMapStates;
+	std::vector<u32> m_StaticShadowMapSizes;
 			
-	Buffer* m_pStaticMeshCommandBuffer = nullptr;
-	std::vector<CommandRange> m_StaticMeshCommandRanges;
-	Buffer* m_pStaticMeshInstanceIndexBuffer = nullptr;
+	// Commands are grouped by mesh type, as each mesh type is drawn with its own vertex and index buffers.
+	// Static mesh command ranges are stored per light, one range per mesh type.
+	Buffer* m_pShadowCasterCommandBuffer = nullptr;
+	std::vector<ShadowMapCommand> m_ShadowCasterCommands;
+	std::vector<u32> m_ShadowCasterCommandMeshIndices;
+	std::vector<u32> m_ShadowCasterCommandNumInstances;
+	u32 m_NumStaticMeshTypes = 0;
+	std::vector<ShadowMapCommandRange> m_StaticMeshCommandRanges;
+	std::vector<ShadowMapCommandRange> m_DynamicMeshCommandRanges;
+	
+	// Sorted dynamic instance indices per mesh type and their world bounds when the shadow maps were last invalidated.
+	std::vector<std::vector<u32>> m_DynamicMeshInstanceIndices;
+	std::vector<std::vector<AxisAlignedBox>> m_DynamicMeshInstanceWorldAABBs;
+	std::vector<Frustum> m_SpotLightWorldFrustums;
+	Buffer* m_pShadowCasterInstanceIndexBuffer = nullptr;
 	
+	// Exp shadow maps of all the lights share one atlas. Tile size depends on the screen coverage of the light.
 	ColorTexture* m_pSpotLightShadowMaps = nullptr;
+	ShadowMapAtlas* m_pShadowMapAtlas = nullptr;
 	std::vector<ShadowMapState> m_SpotLightShadowMapStates;
 	std::vector<u32> m_OutdatedSpotLightShadowMapIndices;
+	std::vector<u32> m_ReallocatedSpotLightIndices;
 
 	ResourceStates m_OutputResourceStates;
 
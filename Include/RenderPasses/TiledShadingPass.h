@@ -2,6 +2,7 @@
 
 #include "D3DWrapper/GraphicsResource.h"
 #include "Math/Vector3.h"
+#include "Math/Vector4.h"
 #include "Math/Matrix4.h"
 
 struct RenderEnv;
@@ -23,6 +24,7 @@ struct SpotLightProps
 	f32 m_RcpViewClipRange;
 	f32 m_NegativeExpShadowMapConstant;
 	u32 m_LightID;
+	Vector4f m_ShadowMapAtlasRect;
 };
 
 class TiledShadingPass
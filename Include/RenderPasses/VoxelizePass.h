@@ -79,7 +79,7 @@ private:
 
 private:
 	RootSignature* m_pRootSignature = nullptr;
-	PipelineState* m_pPipelineState = nullptr;
+	std::vector<PipelineState*> m_PipelineStates;
 	CommandSignature* m_pCommandSignature = nullptr;
 	DescriptorHandle m_SRVHeapStartVS;
 	DescriptorHandle m_SRVHeapStartPS;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Common/FileUtilities.h"
+
+class Scene;
+
+// Binary scene format which stores the data in the layout of MeshBatch streams.
+// Every block starts at kCookedSceneBlockAlignment, so the streams are read in place from the memory mapped file without parsing.
+// A file with a different version is rejected and the scene needs to be cooked again.
+
+static const u32 kCookedSceneMagic = 0x4E435352; // "RSCN"
+static const u32 kCookedSceneVersion = 5;
+static const u32 kCookedSceneBlockAlignment = 16;
+
+struct CookedSceneHeader
+{
+	u32 m_Magic;
+	u32 m_Version;
+	u64 m_SizeInBytes;
+};
+
+class CookedSceneWriter
+{
+public:
+	CookedSceneWriter();
+
+	template <typename T>
+	void WriteValue(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Value should be trivially copyable");
+		WriteBlock(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void WriteArray(std::size_t numElements, const T* pElements)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Array elements should be trivially copyable");
+		WriteValue(u64(numElements));
+		WriteBlock(pElements, numElements * sizeof(T));
+	}
+
+	template <typename T>
+	void WriteArray(const std::vector<T>& elements)
+	{
+		WriteArray(elements.size(), elements.data());
+	}
+
+	void WriteString(const std::wstring& str);
+	bool SaveToFile(const wchar_t* pFilePath);
+
+	// Offset of the next block from the start of the file.
+	u64 GetOffset() const { return m_Data.size(); }
+
+private:
+	void WriteBlock(const void* pData, std::size_t sizeInBytes);
+
+private:
+	std::vector<u8> m_Data;
+};
+
+class CookedSceneReader
+{
+public:
+	CookedSceneReader();
+
+	// Returns false if the file does not exist or was written with a different version.
+	bool Open(const wchar_t* pFilePath);
+
+	// Reads past the end of the file return zero values and empty arrays, and the reader stays failed from then on.
+	// The data read before the check should be discarded if the reader has failed.
+	bool HasFailed() const { return m_Failed; }
+
+	const std::wstring& GetFilePath() const { return m_FilePath; }
+
+	// Offset of the next block from the start of the file.
+	u64 GetOffset() const { return m_Offset; }
+	// Moves to the block at the offset returned by GetOffset of the writer or the reader of the same file.
+	// Returns false if the offset is outside the file.
+	bool Seek(u64 offset);
+
+	template <typename T>
+	const T& ReadValue()
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Value should be trivially copyable");
+		alignas(T) static const u8 zeroValue[sizeof(T)] = {};
+
+		const u8* pBlock = ReadBlock(1, sizeof(T));
+		return *(const T*)((pBlock != nullptr) ? pBlock : zeroValue);
+	}
+
+	// Returns the pointer to the elements inside the memory mapped file.
+	template <typename T>
+	const T* ReadArray(std::size_t* pNumElements)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Array elements should be trivially copyable");
+		const u64 numElements = ReadValue<u64>();
+
+		const T* pFirstElement = (const T*)ReadBlock(numElements, sizeof(T));
+		*pNumElements = (pFirstElement != nullptr) ? std::size_t(numElements) : 0;
+
+		return pFirstElement;
+	}
+
+	template <typename T>
+	void ReadArray(std::vector<T>* pElements)
+	{
+		std::size_t numElements = 0;
+		const T* pFirstElement = ReadArray<T>(&numElements);
+		if (pFirstElement != nullptr)
+			pElements->assign(pFirstElement, pFirstElement + numElements);
+		else
+			pElements->clear();
+	}
+
+	const std::wstring ReadString();
+
+private:
+	// Returns nullptr if the block does not fit into the file.
+	const u8* ReadBlock(u64 numElements, std::size_t elementSizeInBytes);
+
+private:
+	std::wstring m_FilePath;
+	MemoryMappedFile m_File;
+	u64 m_Offset;
+	bool m_Failed;
+};
+
+// Writes the meshes, materials, lights and camera of the scene.
+// The geometry of the mesh batches should be resident. Once the file has been written,
+// it becomes the source the mesh batches read their geometry back from (see MeshBatch::ReleaseGeometry).
+bool WriteCookedScene(const wchar_t* pFilePath, Scene* pScene);
+
+// Returns nullptr if the file cannot be loaded.
+Scene* LoadCookedScene(const wchar_t* pFilePath);
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Math/Matrix4.h"
+#include "Scene/SceneLoader.h"
+
+class Scene;
+
+// Native reader of glTF 2.0 files, binary (.glb) or text (.gltf) with external buffers.
+// Vertex and index data is read from the memory-mapped buffers straight into the mesh batch streams.
+// Tightly packed float attributes are copied as is. Other layouts and the quantized component types
+// of KHR_mesh_quantization are converted to floats with SSE2 on the way.
+// Each mesh primitive becomes a mesh of the batch with an instance per node which references the mesh.
+// Primitives without texture coordinates go to a separate batch with a vertex format without them.
+// The scene is converted to the left-handed coordinate system the same way as the scenes imported by Assimp.
+// Texture coordinate transforms of KHR_texture_transform are applied to the texture coordinates.
+// Instances of the nodes selected by the dynamic object params are flagged as dynamic.
+// Only m_SortMeshesByMortonCode of the mesh processing params is used.
+// Returns nullptr if the file cannot be read or requires an unsupported extension. The scene is owned by the caller.
+Scene* LoadGltfFile(const wchar_t* pFilePath, const Matrix4f& worldMatrix, const MeshProcessingParams& meshProcessingParams = MeshProcessingParams(),
+	const DynamicObjectParams& dynamicObjectParams = DynamicObjectParams());
\ No newline at end of file
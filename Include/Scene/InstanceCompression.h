@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Math/Vector3.h"
+#include "Math/Vector4.h"
+#include "Math/Matrix4.h"
+#include "Math/AxisAlignedBox.h"
+
+// Compact encodings of the instance data stored in GPU instance buffers. Decoding on GPU is in InstanceDecoding.hlsl.
+// Affine transform: 3 x float4, the transposed matrix without its constant last column. 48 bytes instead of 64.
+// Similarity transform: rotation quaternion, translation and uniform scale. 32 bytes instead of 64.
+// AABB: corners quantized to 16 bits relative to the scene bounds and rounded outwards. 12 bytes instead of 24.
+
+struct AffineTransform
+{
+	// Row i holds column i of the matrix, so that world space point is (dot(m_Rows[0], p), dot(m_Rows[1], p), dot(m_Rows[2], p)) for p = (x, y, z, 1).
+	Vector4f m_Rows[3];
+};
+
+struct SimilarityTransform
+{
+	Vector4f m_Rotation;
+	Vector3f m_Translation;
+	f32 m_Scale;
+};
+
+struct QuantizedAABB
+{
+	u16 m_MinPoint[3];
+	u16 m_MaxPoint[3];
+};
+
+static_assert(sizeof(AffineTransform) == 48, "AffineTransform is read as 3 x float4 in shaders");
+static_assert(sizeof(SimilarityTransform) == 32, "SimilarityTransform is read as 2 x float4 in shaders");
+static_assert(sizeof(QuantizedAABB) == 12, "QuantizedAABB is read as 3 x uint in shaders");
+
+// Packers of affine transforms and AABBs use SSE2. The last column of the matrices is expected to be (0, 0, 0, 1).
+void PackAffineTransforms(u32 numInstances, const Matrix4f* pMatrices, AffineTransform* pTransforms);
+void QuantizeAABBs(u32 numInstances, const AxisAlignedBox* pAABBs, const AxisAlignedBox& sceneBounds, QuantizedAABB* pQuantizedAABBs);
+
+// Only rotation, uniform scale and translation can be encoded. See IsSimilarityTransform.
+void PackSimilarityTransforms(u32 numInstances, const Matrix4f* pMatrices, SimilarityTransform* pTransforms);
+
+const Matrix4f UnpackAffineTransform(const AffineTransform& transform);
+const Matrix4f UnpackSimilarityTransform(const SimilarityTransform& transform);
+const AxisAlignedBox DequantizeAABB(const QuantizedAABB& quantizedAABB, const AxisAlignedBox& sceneBounds);
+
+// Checks that the matrix is affine, its axes are orthogonal, have the same length within the relative tolerance and are not mirrored.
+bool IsSimilarityTransform(const Matrix4f& matrix, f32 maxRelativeError = 1e-4f);
\ No newline at end of file
@@ -1,13 +1,13 @@
 #pragma once
 
 #include "D3DWrapper/Common.h"
+#include "Math/Vector2.h"
+#include "Math/Vector3.h"
+#include "Math/Vector4.h"
 
 struct AxisAlignedBox;
 struct OrientedBox;
 struct Material;
-struct Vector2f;
-struct Vector3f;
-struct Vector4f;
 struct Matrix4f;
 
 class VertexData
@@ -15,6 +15,11 @@ class VertexData
 public:
 	VertexData(u32 numVertices, const Vector3f* pPositions, const Vector3f* pNormals = nullptr,
 		const Vector2f* pTexCoords = nullptr, const Vector4f* pColors = nullptr, const Vector3f* pTangents = nullptr);
+
+	// Adopts the attribute buffers without copying. Empty buffers stand for missing attributes.
+	VertexData(std::vector<Vector3f>&& positions, std::vector<Vector3f>&& normals = {},
+		std::vector<Vector2f>&& texCoords = {}, std::vector<Vector4f>&& colors = {}, std::vector<Vector3f>&& tangents = {});
+	
 	~VertexData();
 
 	enum FormatFlags
@@ -50,11 +55,11 @@ public:
 private:
 	u32 m_NumVertices;
 	u8 m_FormatFlags;
-	Vector3f* m_pPositions;
-	Vector3f* m_pNormals;
-	Vector2f* m_pTexCoords;
-	Vector4f* m_pColors;
-	Vector3f* m_pTangents;
+	std::vector<Vector3f> m_Positions;
+	std::vector<Vector3f> m_Normals;
+	std::vector<Vector2f> m_TexCoords;
+	std::vector<Vector4f> m_Colors;
+	std::vector<Vector3f> m_Tangents;
 };
 
 class IndexData
@@ -62,6 +67,11 @@ class IndexData
 public:
 	IndexData(u32 numIndices, const u16* p16BitIndices);
 	IndexData(u32 numIndices, const u32* p32BitIndices);
+
+	// Adopts the index buffer without copying.
+	IndexData(std::vector<u16>&& indices);
+	IndexData(std::vector<u32>&& indices);
+	
 	~IndexData();
 
 	IndexData(const IndexData&) = delete;
@@ -79,8 +89,8 @@ public:
 private:
 	DXGI_FORMAT m_Format;
 	u32 m_NumIndices;
-	u16* m_p16BitIndices;
-	u32* m_p32BitIndices;
+	std::vector<u16> m_16BitIndices;
+	std::vector<u32> m_32BitIndices;
 };
 
 class Mesh
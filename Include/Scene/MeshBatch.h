@@ -6,9 +6,13 @@
 #include "Math/Matrix4.h"
 #include "Math/AxisAlignedBox.h"
 #include "Math/OrientedBox.h"
+#include "Scene/MeshCluster.h"
+#include "Scene/VertexCompression.h"
 #include "D3DWrapper/Common.h"
 
 class Mesh;
+class CookedSceneWriter;
+class CookedSceneReader;
 
 struct MeshInfo
 {
@@ -37,6 +41,38 @@ public:
 
 	void AddMesh(const Mesh* pMesh);
 
+	// Builder API which lets converters write mesh data directly into the batch streams.
+	// Reserve sizes the streams up front from the totals of all meshes, so that appending the meshes does not reallocate.
+	void Reserve(u32 numMeshes, u32 numVertices, u32 numIndices, u32 numInstances);
+
+	struct MeshStreams
+	{
+		Vector3f* m_pPositions = nullptr;
+		Vector3f* m_pNormals = nullptr;
+		Vector2f* m_pTexCoords = nullptr;
+		Vector4f* m_pColors = nullptr;
+		Vector3f* m_pTangents = nullptr;
+		u16* m_p16BitIndices = nullptr;
+		u32* m_p32BitIndices = nullptr;
+		Matrix4f* m_pInstanceWorldMatrices = nullptr;
+		// Initialized to MeshInstanceFlag_None.
+		u8* m_pInstanceFlags = nullptr;
+	};
+
+	// Appends a mesh with uninitialized data and returns the locations of its data in the batch streams.
+	// The pointers stay valid while the appended meshes fit into the reserved size.
+	// FinishMesh should be called once the data has been written. Different meshes can be written and finished concurrently.
+	MeshStreams AppendMesh(u32 numVertices, u32 numIndices, u32 numInstances, u32 materialID);
+	
+	// Calculates local bounds of the mesh and world bounds of the mesh instances.
+	void FinishMesh(u32 meshIndex);
+
+	enum MeshInstanceFlags
+	{
+		MeshInstanceFlag_None = 0,
+		MeshInstanceFlag_Dynamic = 1 << 0
+	};
+
 	u8 GetVertexFormatFlags() const { return m_VertexFormatFlags; }
 	DXGI_FORMAT GetIndexFormat() const { return m_IndexFormat; }
 
@@ -52,6 +88,59 @@ public:
 	const OrientedBox* GetMeshInstanceWorldOBBs() const { return m_MeshInstanceWorldOBBs.data(); }
 	const Matrix4f* GetMeshInstanceWorldMatrices() const { return m_MeshInstanceWorldMatrices.data(); }
 
+	// Bounds of the mesh vertices. World bounds of the mesh instances are derived from them by transforming the box.
+	const AxisAlignedBox* GetMeshLocalAABBs() const { return m_MeshLocalAABBs.data(); }
+
+	u8 GetMeshInstanceFlags(u32 instanceIndex) const { return m_MeshInstanceFlags[instanceIndex]; }
+	void SetMeshInstanceFlags(u32 instanceIndex, u8 flags) { m_MeshInstanceFlags[instanceIndex] = flags; }
+	bool IsMeshInstanceDynamic(u32 instanceIndex) const { return (m_MeshInstanceFlags[instanceIndex] & MeshInstanceFlag_Dynamic) != 0; }
+
+	// Splits mesh instances into instances which never move (static) and instances which can move (dynamic).
+	// Instance indices in both sets are sorted in ascending order.
+	void ClassifyMeshInstances(std::vector<u32>* pStaticMeshInstanceIndices, std::vector<u32>* pDynamicMeshInstanceIndices) const;
+
+	// Moves the dynamic mesh instance. meshInstanceIndex is relative to the first instance of the mesh.
+	// World bounds are derived from the local bounds of the mesh in constant time
+	// and the instance is recorded as dirty, so that its GPU data can be updated.
+	void SetMeshInstanceWorldMatrix(u32 meshIndex, u32 meshInstanceIndex, const Matrix4f& worldMatrix);
+
+	struct MeshInstanceRange
+	{
+		u32 m_FirstInstance;
+		u32 m_NumInstances;
+	};
+
+	bool HasDirtyMeshInstances() const { return !m_DirtyMeshInstanceIndices.empty(); }
+	
+	// Returns the instances moved since the last call as sorted, non-overlapping ranges and clears the dirty state.
+	// Ranges separated by at most maxGap clean instances are merged, as copying a few extra instances
+	// is cheaper than issuing a separate copy for each range.
+	void ExtractDirtyMeshInstanceRanges(std::vector<MeshInstanceRange>* pRanges, u32 maxGap = 0);
+
+	// Sorts the instances of each mesh and, if sortMeshes is set, the meshes of the batch by 3D Morton code of their world bounds center,
+	// so that spatially adjacent instances and meshes are stored next to each other. Mesh bounds are the union of its instance bounds.
+	// Instances of a mesh stay contiguous and follow the mesh order. Mesh and instance indices obtained before the call are invalidated.
+	void SortByMortonCode(bool sortMeshes);
+
+	// Splits each mesh into clusters of adjacent triangles and reorders the mesh triangles
+	// so that the triangles of each cluster are stored contiguously. Only triangle lists are supported.
+	// Mesh vertices are then renumbered in the order of first use by the reordered triangles (see OptimizeVertexFetch).
+	// Should be called after all meshes have been added.
+	void BuildMeshClusters(u32 maxNumVerticesPerCluster = kMaxNumVerticesPerMeshCluster, u32 maxNumTrianglesPerCluster = kMaxNumTrianglesPerMeshCluster);
+
+	bool HasMeshClusters() const { return !m_MeshClusterRanges.empty(); }
+	u32 GetNumMeshClusters() const { return m_MeshClusters.size(); }
+	const MeshCluster* GetMeshClusters() const { return m_MeshClusters.data(); }
+	const MeshClusterRange* GetMeshClusterRanges() const { return m_MeshClusterRanges.data(); }
+
+	// Selects compressed GPU vertex formats for the attributes whose encoding error fits into the budget
+	// and calculates the quantization ranges of each mesh. Vertex data on the CPU side is not affected.
+	void SelectVertexCompression(const VertexPrecisionBudget& budget);
+
+	u8 GetVertexCompressionFlags() const { return m_VertexCompressionFlags; }
+	// Empty until SelectVertexCompression is called.
+	const VertexQuantization* GetMeshVertexQuantizations() const { return m_MeshVertexQuantizations.data(); }
+
 	u32 GetNumVertices() const;
 	const Vector3f* GetPositions() const;
 	const Vector3f* GetNormals() const;
@@ -63,8 +152,42 @@ public:
 	const u16* Get16BitIndices() const;
 	const u32* Get32BitIndices() const;
 
+	// CPU side residency of the vertex and index streams. Once the GPU buffers have been created from them,
+	// only tools and rebuilds of the buffers read the streams, so they can be released.
+	// Mesh infos, bounds, instance matrices and flags, and mesh clusters stay resident, as culling and instance updates use them.
+	// The stream getters above should be called only while the geometry is resident; the vertex and index counts are always valid.
+	bool IsGeometryResident() const { return m_GeometryResident; }
+
+	// Cooked scene file the streams are read back from. It is set by Deserialize and by WriteCookedScene,
+	// and cleared by the calls which change the streams (AppendMesh, BuildMeshClusters).
+	bool HasGeometrySource() const { return !m_GeometrySourceFilePath.empty(); }
+	void SetGeometrySource(const wchar_t* pCookedSceneFilePath, u64 geometryOffset);
+
+	// Frees the streams and records their hash. Returns false and keeps them if the batch has no geometry source.
+	bool ReleaseGeometry();
+
+	// Hash of the vertex and index streams and the mesh layout inside them.
+	// For released geometry, the hash recorded by ReleaseGeometry is returned.
+	u64 CalcGeometryHash() const;
+
+	// Reads the released streams back from the geometry source. Returns false if the source cannot be read
+	// or no longer contains the geometry of the batch, in which case the geometry stays released.
+	// The streams read back should match the hash recorded by ReleaseGeometry.
+	bool MaterializeGeometry();
+
+	// Writes and reads all the streams of the batch in the cooked scene format.
+	// Serialize returns the offset of the vertex and index streams in the writer, to be used as the geometry source.
+	u64 Serialize(CookedSceneWriter* pWriter) const;
+	static MeshBatch* Deserialize(CookedSceneReader* pReader);
+
+private:
+	void CalcMeshInstanceWorldBounds(u32 meshIndex, u32 instanceIndex);
+	void ReadGeometry(CookedSceneReader* pReader);
+	void FreeGeometry();
+
 private:
 	u8 m_VertexFormatFlags;
+	u8 m_VertexCompressionFlags;
 	DXGI_FORMAT m_IndexFormat;
 
 	D3D12_PRIMITIVE_TOPOLOGY_TYPE m_PrimitiveTopologyType;
@@ -77,11 +200,24 @@ private:
 	std::vector<Vector3f> m_Tangents;
 	std::vector<u16> m_16BitIndices;
 	std::vector<u32> m_32BitIndices;
+	u32 m_NumVertices;
+	u32 m_NumIndices;
+
+	bool m_GeometryResident;
+	u64 m_ReleasedGeometryHash;
+	std::wstring m_GeometrySourceFilePath;
+	u64 m_GeometrySourceOffset;
 
 	std::vector<MeshInfo> m_MeshInfos;
+	std::vector<AxisAlignedBox> m_MeshLocalAABBs;
+	std::vector<VertexQuantization> m_MeshVertexQuantizations;
+	std::vector<MeshClusterRange> m_MeshClusterRanges;
+	std::vector<MeshCluster> m_MeshClusters;
 	std::vector<AxisAlignedBox> m_MeshInstanceWorldAABBs;
 	std::vector<OrientedBox> m_MeshInstanceWorldOBBs;
 	std::vector<Matrix4f> m_MeshInstanceWorldMatrices;
+	std::vector<u8> m_MeshInstanceFlags;
+	std::vector<u32> m_DirtyMeshInstanceIndices;
 
 	u32 m_MaxNumInstancesPerMesh;
 };
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Math/Vector3.h"
+#include "Math/Sphere.h"
+#include "Math/AxisAlignedBox.h"
+
+struct Frustum;
+struct Matrix4f;
+class MeshBatch;
+
+static const u32 kMaxNumVerticesPerMeshCluster = 64;
+static const u32 kMaxNumTrianglesPerMeshCluster = 124;
+
+// Group of adjacent triangles of a mesh. Triangles of the cluster are stored contiguously
+// in the index buffer, so the cluster can be drawn with a single indexed draw call.
+// Bounds are specified in the local space of the mesh.
+
+struct MeshCluster
+{
+	u32 m_StartIndexLocation;
+	u32 m_IndexCount;
+	u32 m_VertexCount;
+	Sphere m_BoundingSphere;
+	AxisAlignedBox m_AABB;
+
+	// All triangles of the cluster face away from the viewer if Dot(Normalize(m_ConeApex - viewerPos), m_ConeAxis) >= m_ConeCutoff.
+	// The cone is disabled when m_ConeCutoff is greater than 1.
+	Vector3f m_ConeApex;
+	Vector3f m_ConeAxis;
+	f32 m_ConeCutoff;
+};
+
+struct MeshClusterRange
+{
+	u32 m_FirstCluster;
+	u32 m_NumClusters;
+};
+
+// Splits triangle list into clusters and reorders the triangles so that the triangles of each cluster are stored contiguously.
+// Start index location of the clusters is relative to the first index.
+void BuildMeshClusters(const Vector3f* pPositions, u32 numIndices, u16* pIndices,
+	u32 maxNumVerticesPerCluster, u32 maxNumTrianglesPerCluster, std::vector<MeshCluster>* pClusters);
+
+void BuildMeshClusters(const Vector3f* pPositions, u32 numIndices, u32* pIndices,
+	u32 maxNumVerticesPerCluster, u32 maxNumTrianglesPerCluster, std::vector<MeshCluster>* pClusters);
+
+// Low resolution depth buffer of the occluders. Each texel stores the farthest depth of the occluders covering the texel.
+// Depth is expected to increase with the distance to the camera.
+struct OcclusionDepthBuffer
+{
+	u32 m_Width;
+	u32 m_Height;
+	const f32* m_pMaxDepths;
+};
+
+struct MeshClusterCullingParams
+{
+	const Frustum* m_pCameraWorldFrustum = nullptr;
+	Vector3f m_CameraWorldPos = Vector3f::ZERO;
+	bool m_EnableConeCulling = true;
+
+	// Occlusion test is skipped if no occlusion depth buffer is provided.
+	const Matrix4f* m_pCameraViewProjMatrix = nullptr;
+	const OcclusionDepthBuffer* m_pOcclusionDepthBuffer = nullptr;
+};
+
+struct VisibleMeshCluster
+{
+	u32 m_MeshInstanceIndex;
+	u32 m_ClusterIndex;
+};
+
+struct MeshClusterCullingStats
+{
+	u32 m_NumTestedClusters = 0;
+	u32 m_NumFrustumCulledClusters = 0;
+	u32 m_NumBackfaceCulledClusters = 0;
+	u32 m_NumOccludedClusters = 0;
+
+	u32 m_NumTestedTriangles = 0;
+	u32 m_NumFrustumCulledTriangles = 0;
+	u32 m_NumBackfaceCulledTriangles = 0;
+	u32 m_NumOccludedTriangles = 0;
+};
+
+void CullMeshClusters(const MeshBatch* pMeshBatch, const MeshClusterCullingParams& params,
+	std::vector<VisibleMeshCluster>* pVisibleClusters, MeshClusterCullingStats* pStats = nullptr);
\ No newline at end of file
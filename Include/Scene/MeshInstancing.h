@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Math/Vector3.h"
+#include "Math/Matrix4.h"
+
+// Detection of meshes which are copies of the same geometry placed with different transforms,
+// so that they can be rendered as instances of a single mesh.
+
+// FrustumMeshCullingCS, CreateMainDrawCommandsCS and CreateFalseNegativeDrawCommandsCS collect the instances of a mesh
+// in a groupshared array of instance indices, which limits the number of instances per mesh.
+static const u32 kMaxNumInstancesPerMesh = 4096;
+
+// D3D12 limits groupshared memory to 32 KB per thread group. The shaders use one index array and a few counters.
+static const u32 kMaxGroupSharedMemoryInBytes = 32768;
+static const u32 kMaxNumGroupSharedCounters = 8;
+static_assert((kMaxNumInstancesPerMesh + kMaxNumGroupSharedCounters) * sizeof(u32) <= kMaxGroupSharedMemoryInBytes,
+	"Instance indices of a mesh should fit into groupshared memory");
+
+// 64-bit FNV-1a hash. Hash of the previous data can be passed in to combine several arrays.
+static const u64 kHashOffsetBasis = 0xCBF29CE484222325ull;
+u64 HashBytes(const void* pData, std::size_t sizeInBytes, u64 hash = kHashOffsetBasis);
+
+// Finds the affine transform which maps the canonical positions to the instance positions,
+// so that TransformPoint(pCanonicalPositions[i], *pInstanceMatrix) matches pPositions[i] within maxError.
+// The transform is solved from 4 vertices spanning the mesh and verified on all the vertices.
+// Transforms with negative determinant are rejected, as they flip the triangle winding.
+// Only similarity transforms (rotation, uniform scaling and translation) are accepted,
+// as the vertex shaders transform normals with the world matrix.
+bool FindInstanceTransform(u32 numVertices, const Vector3f* pCanonicalPositions, const Vector3f* pPositions,
+	f32 maxError, Matrix4f* pInstanceMatrix);
+
+// Checks that the instance normals are the canonical normals transformed with the instance transform.
+bool AreInstanceNormals(u32 numVertices, const Vector3f* pCanonicalNormals, const Vector3f* pNormals,
+	const Matrix4f& instanceMatrix, f32 maxAngleInDegrees);
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Math/Vector3.h"
+
+// Index and vertex reordering for indexed triangle lists.
+// Recommended order is OptimizeVertexCache, OptimizeOverdraw and then OptimizeVertexFetch.
+
+static const u32 kDefaultVertexCacheSize = 16;
+
+struct VertexCacheStats
+{
+	// Average cache miss ratio: number of transformed vertices per triangle.
+	f32 m_ACMR = 0.0f;
+	// Average transform to vertex ratio: number of transformed vertices per referenced vertex. The optimum is 1.
+	f32 m_ATVR = 0.0f;
+	u32 m_NumTransformedVertices = 0;
+	u32 m_NumTriangles = 0;
+	u32 m_NumReferencedVertices = 0;
+};
+
+// Simulates FIFO post-transform vertex cache.
+VertexCacheStats AnalyzeVertexCache(u32 numVertices, u32 numIndices, const u32* pIndices, u32 cacheSize = kDefaultVertexCacheSize);
+
+// Adds the counters of the mesh stats to the total stats and updates the ratios.
+void AccumulateVertexCacheStats(const VertexCacheStats& meshStats, VertexCacheStats* pTotalStats);
+
+// Reorders triangles to improve post-transform vertex cache hit rate (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+void OptimizeVertexCache(u32 numVertices, u32 numIndices, u32* pIndices);
+
+// Splits the cache optimized triangle sequence into clusters and sorts the clusters so that the ones
+// which are likely to occlude the others are drawn first (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+// Vertex cache miss ratio of a cluster is allowed to grow by at most a factor of threshold.
+void OptimizeOverdraw(const Vector3f* pPositions, u32 numVertices, u32 numIndices, u32* pIndices,
+	f32 threshold = 1.05f, u32 cacheSize = kDefaultVertexCacheSize);
+
+// Renumbers vertices in the order of first use by the index buffer, so vertex fetches become sequential.
+// pVertexRemap receives new index for each old vertex or kUnusedVertex for vertices which are not referenced.
+// Returns the number of referenced vertices.
+static const u32 kUnusedVertex = ~0u;
+u32 OptimizeVertexFetch(u32 numVertices, u32 numIndices, u32* pIndices, std::vector<u32>* pVertexRemap);
+
+// Max number of vertices a mesh can have to be addressed with 16-bit indices.
+// Index 0xFFFF is not used as it is the strip cut value.
+static const u32 kMaxNumVerticesWith16BitIndices = 0xFFFF;
+
+// Moves vertex attributes to the locations returned by OptimizeVertexFetch.
+template <typename T>
+void RemapVertices(u32 numVertices, T* pVertices, u32 numRemappedVertices, const u32* pVertexRemap)
+{
+	std::vector<T> remappedVertices(numRemappedVertices);
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+	{
+		if (pVertexRemap[vertexIndex] != kUnusedVertex)
+			remappedVertices[pVertexRemap[vertexIndex]] = pVertices[vertexIndex];
+	}
+	std::copy(remappedVertices.begin(), remappedVertices.end(), pVertices);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Math/Vector2.h"
+#include "Math/Vector3.h"
+
+// Vertex welding and generation of normals and tangents for indexed triangle lists, which can run for several meshes in parallel.
+// Used in place of the Assimp post-processing steps JoinIdenticalVertices, GenNormals and CalcTangentSpace,
+// but the output is not the same: GenNormals generates flat normals, and CalcTangentSpace does not split vertices by handedness.
+
+// Finds vertices whose position, normal, texture coordinates and tangent are exactly equal. All but the positions are optional.
+// pVertexRemap receives new index for each old vertex, numbered in the order of first occurrence,
+// so attributes can be moved with RemapVertices and indices rewritten through the remap.
+// Returns the number of unique vertices.
+u32 WeldVertices(u32 numVertices, const Vector3f* pPositions, const Vector3f* pNormals, const Vector2f* pTexCoords, const Vector3f* pTangents,
+	std::vector<u32>* pVertexRemap);
+
+// Generates a normal for each triangle corner, that is for each index, as the sum of the normals of the triangles at the same position
+// weighted by the triangle angle at the position. Only the triangles whose normal is within maxSmoothingAngleInRadians
+// of the normal of the corner triangle are summed, so the corners on the two sides of a crease get different normals.
+// Texture seams do not matter, as the corners are grouped by position. Welding the corners afterwards splits the vertices at creases.
+// Front-facing triangles are expected to be ordered so that Cross(p1 - p0, p2 - p0) points to the viewer.
+void GenerateNormals(u32 numVertices, const Vector3f* pPositions, u32 numIndices, const u32* pIndices, f32 maxSmoothingAngleInRadians,
+	Vector3f* pCornerNormals);
+
+// Generates a tangent for each triangle corner in the direction of increasing u following MikkTSpace: triangle tangents are projected
+// onto the tangent plane of the vertex normal, weighted by the triangle angle at the vertex and orthonormalized.
+// As in MikkTSpace, only the triangles with the same handedness of the texture mapping are summed at a vertex, so welding the corners
+// afterwards splits the vertices where mirrored texture mapping meets. The bitangent sign is not output, as the vertex format does not store it.
+void GenerateTangents(u32 numVertices, const Vector3f* pPositions, const Vector3f* pNormals, const Vector2f* pTexCoords,
+	u32 numIndices, const u32* pIndices, Vector3f* pCornerTangents);
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Common/Common.h"
+
+struct aiScene;
+
+// Native reader of Wavefront OBJ files and their MTL material libraries.
+// The file is memory-mapped and split into chunks at line boundaries, which are parsed in parallel,
+// and the meshes are then assembled in parallel.
+// The scene is returned in the form the Assimp importer would produce with the post-processing steps
+// Triangulate, MakeLeftHanded, FlipUVs, FlipWindingOrder and RemoveRedundantMaterials,
+// so that it goes through the same mesh conversion as the scenes imported by Assimp.
+// Face vertices with the same position, texture coordinate and normal indices share the vertex within a mesh,
+// but vertices are not welded by value and missing normals are not generated (see MeshProcessing.h for both).
+// Texture coordinates are only output for the meshes with vt references. Faces without usemtl get a default material without texture maps.
+// Polygons are triangulated as fans.
+// Returns nullptr if the file cannot be read. The scene is owned by the caller.
+aiScene* LoadObjFile(const wchar_t* pFilePath);
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Math/AxisAlignedBox.h"
+
+class Scene;
+
+struct ProceduralSceneParams
+{
+	u32 m_Seed = 1;
+
+	// Instances and lights are placed inside the bounds.
+	AxisAlignedBox m_WorldBounds = AxisAlignedBox(Vector3f(0.0f, 50.0f, 0.0f), Vector3f(500.0f, 50.0f, 500.0f));
+	// With zero clusters, instances and lights are scattered uniformly inside the world bounds.
+	// Otherwise they are placed around cluster centers with a normal distribution of the cluster radius standard deviation.
+	u32 m_NumClusters = 0;
+	f32 m_ClusterRadius = 20.0f;
+
+	// Each mesh is a box or a sphere of random size with the number of instances picked uniformly from [1, m_MaxNumInstancesPerMesh].
+	// The number of instances is capped at kMaxNumInstancesPerMesh.
+	u32 m_NumMeshes = 1024;
+	u32 m_MaxNumInstancesPerMesh = 16;
+	f32 m_MinMeshSize = 0.5f;
+	f32 m_MaxMeshSize = 5.0f;
+	u32 m_NumSphereSegments = 16;
+
+	// All materials use the default textures in the directory, which are loaded once by MaterialRenderResources.
+	u32 m_NumMaterials = 64;
+	std::wstring m_TextureDirectoryPath = L"..\\..\\Resources\\CrytekSponza\\Textures";
+
+	u32 m_NumSpotLights = 16;
+	u32 m_NumPointLights = 64;
+	f32 m_MinLightRange = 5.0f;
+	f32 m_MaxLightRange = 25.0f;
+
+	// Sorts the meshes by Morton code, builds mesh clusters and selects vertex compression as the scene loaders do.
+	// Can be disabled to time the steps separately.
+	bool m_PrepareMeshBatch = true;
+};
+
+// Builds a scene of randomly sized, placed and rotated box and sphere meshes with random materials,
+// spot lights and point lights, together with a camera and a directional light.
+// The generator uses its own random number generator instead of the standard distributions, whose output differs between
+// implementations, and every mesh draws from its own random sequence, so the same parameters always produce the same scene.
+// Mesh geometry is written in parallel. The scene is owned by the caller.
+Scene* GenerateProceduralScene(const ProceduralSceneParams& params);
\ No newline at end of file
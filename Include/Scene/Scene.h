@@ -20,27 +20,38 @@ public:
 	void AddMeshBatch(MeshBatch* pMeshBatch);
 	std::size_t GetNumMeshBatches() const;
 	MeshBatch** GetMeshBatches();
-		
-	void AddMaterial(Material* pMaterial);
+	// Remove* functions do not delete the object and pass its ownership to the caller.
+	// They return false if the object is not part of the scene.
+	bool RemoveMeshBatch(MeshBatch* pMeshBatch);
+	
+	// Material IDs are slot indices, which stay stable when other materials are removed.
+	// A removed material leaves a nullptr slot, which is reused by the next added material.
+	// Meshes should no longer reference a material once it has been removed.
+	u32 AddMaterial(Material* pMaterial);
 	std::size_t GetNumMaterials() const;
 	Material** GetMaterials();
+	bool RemoveMaterial(Material* pMaterial);
 
 	DirectionalLight* GetDirectionalLight();
 	void SetDirectionalLight(DirectionalLight* pDirectionalLight);
+	DirectionalLight* RemoveDirectionalLight();
 
 	void AddPointLight(PointLight* pPointLight);
 	std::size_t GetNumPointLights() const;
 	PointLight** GetPointLights();
+	bool RemovePointLight(PointLight* pPointLight);
 
 	void AddSpotLight(SpotLight* pSpotLight);
 	std::size_t GetNumSpotLights() const;
 	SpotLight** GetSpotLights();
+	bool RemoveSpotLight(SpotLight* pSpotLight);
 		
 private:
 	AxisAlignedBox m_WorldBounds;
 	Camera* m_pCamera;
 	std::vector<MeshBatch*> m_MeshBatches;
 	std::vector<Material*> m_Materials;
+	std::vector<u32> m_FreeMaterialSlots;
 	DirectionalLight* m_pDirectionalLight;
 	std::vector<PointLight*> m_PointLights;
 	std::vector<SpotLight*> m_SpotLights;
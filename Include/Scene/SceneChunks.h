@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Scene/CookedScene.h"
+#include "Math/AxisAlignedBox.h"
+
+class Scene;
+struct Vector2f;
+struct Vector4f;
+
+// Spatial chunk of the scene: the meshes of a mesh batch whose world bounds center falls into the same cell of a uniform grid.
+// A mesh is never split between chunks, so the chunk owns the vertices, indices and instances of its meshes.
+struct SceneChunk
+{
+	u32 m_MeshType;
+	AxisAlignedBox m_WorldBounds;
+	// Mesh indices inside the mesh batch, in the batch order.
+	std::vector<u32> m_MeshIndices;
+	// Materials referenced by the meshes, sorted and unique.
+	std::vector<u32> m_MaterialIDs;
+	u32 m_NumVertices;
+	u32 m_NumIndices;
+	u32 m_NumInstances;
+};
+
+// Groups the meshes of every mesh batch of the scene into chunks on a grid with cells of chunkSize world units.
+// Mesh bounds are the union of its instance world bounds.
+void BuildSceneChunks(Scene* pScene, f32 chunkSize, std::vector<SceneChunk>* pChunks);
+
+// Vertices and indices of the chunk meshes, stored one mesh after another.
+// Indices are relative to the first vertex of their mesh, as in the mesh batch.
+// Attributes which are not part of the vertex format of the mesh batch are nullptr.
+struct SceneChunkGeometry
+{
+	const Vector3f* m_pPositions = nullptr;
+	const Vector3f* m_pNormals = nullptr;
+	const Vector4f* m_pColors = nullptr;
+	const Vector3f* m_pTangents = nullptr;
+	const Vector2f* m_pTexCoords = nullptr;
+	const void* m_pIndices = nullptr;
+};
+
+// A chunk file with a different version is rejected and written again.
+static const u32 kSceneChunkFileVersion = 2;
+
+// Writes the geometry of each chunk contiguously in the cooked scene format,
+// so that a chunk is read with a few sequential reads and the mesh batches do not need to keep the geometry around.
+// The file starts with the version and the hash of the mesh batch geometry it was written from.
+// Mesh batches whose geometry has been released read it back for the duration of the write.
+bool WriteSceneChunkFile(const wchar_t* pFilePath, Scene* pScene, const std::vector<SceneChunk>& chunks);
+
+// Memory maps the chunk file. The geometry of a chunk is paged in on first access,
+// so the chunks can be read concurrently from worker threads.
+class SceneChunkFile
+{
+public:
+	// Returns false if the file does not exist, has a different version, or was written for a different chunk layout or geometry.
+	bool Open(const wchar_t* pFilePath, Scene* pScene, const std::vector<SceneChunk>& chunks);
+
+	const SceneChunkGeometry& GetChunkGeometry(u32 chunkIndex) const { return m_ChunkGeometry[chunkIndex]; }
+
+private:
+	CookedSceneReader m_Reader;
+	std::vector<SceneChunkGeometry> m_ChunkGeometry;
+};
\ No newline at end of file
@@ -1,10 +1,63 @@
 #pragma once
 
+#include "Common/Common.h"
+
 class Scene;
 
+// Optional import stage which merges static meshes with a single instance and the same material into larger meshes,
+// so that fewer meshes are culled and drawn separately.
+struct MeshMergingParams
+{
+	bool m_Enabled = false;
+	// Max size of the merged mesh bounds along each axis, in world space units. Keeps culling granularity reasonable.
+	f32 m_MaxBoundsSize = 5.0f;
+};
+
+// Selects who welds the vertices and generates missing normals and tangents at import.
+struct MeshProcessingParams
+{
+	// Native processing (see MeshProcessing.h) runs for all meshes in parallel
+	// instead of the single-threaded Assimp steps JoinIdenticalVertices, GenNormals, CalcTangentSpace and OptimizeMeshes.
+	// Meshes are not joined by Assimp then; MeshMergingParams controls merging instead.
+	bool m_UseNativeProcessing = false;
+	// OBJ files are read by the native loader (see ObjLoader.h) instead of Assimp.
+	// Used only with native processing, which welds the vertices and generates the normals the loader leaves out.
+	bool m_UseNativeObjLoader = false;
+	// Used only with native processing. Generated normals are smoothed across the edges where the triangle normals differ
+	// by at most the angle, and the vertices are split at sharper edges. Assimp GenNormals generates flat normals instead.
+	f32 m_MaxSmoothingAngleInDegrees = 60.0f;
+	// Tangents are not read by the current shaders, so they are stored in the vertex buffer only when requested.
+	bool m_GenerateTangents = false;
+	// Meshes of each batch are sorted by Morton code of their world bounds together with their instances (see MeshBatch::SortByMortonCode).
+	// Otherwise the meshes keep the file order and only the instances of each mesh are sorted.
+	bool m_SortMeshesByMortonCode = true;
+};
+
+// Selects the mesh instances which can move after loading (see MeshBatch::MeshInstanceFlag_Dynamic).
+// Dynamic instances are kept out of the cached static shadow maps and can be moved with MeshBatch::SetMeshInstanceWorldMatrix.
+struct DynamicObjectParams
+{
+	// Instances of the meshes whose name starts with one of the prefixes are dynamic.
+	// Assimp mesh names are matched, which are the object and group names in OBJ files, and the node names in glTF files.
+	// Nodes targeted by glTF animations are always dynamic, and in glTF the children of dynamic nodes are dynamic as well.
+	std::vector<std::string> m_NamePrefixes;
+
+	bool IsDynamicName(const std::string& name) const;
+};
+
 class SceneLoader
 {
 public:
-	static Scene* LoadCrytekSponza();
-	static Scene* LoadLivingRoom();
+	// Both return nullptr if the scene file cannot be loaded.
+	static Scene* LoadCrytekSponza(const MeshMergingParams& meshMergingParams = MeshMergingParams(),
+		const MeshProcessingParams& meshProcessingParams = MeshProcessingParams(),
+		const DynamicObjectParams& dynamicObjectParams = DynamicObjectParams());
+	static Scene* LoadLivingRoom(const MeshMergingParams& meshMergingParams = MeshMergingParams(),
+		const MeshProcessingParams& meshProcessingParams = MeshProcessingParams(),
+		const DynamicObjectParams& dynamicObjectParams = DynamicObjectParams());
+
+	// Loads .glb or .gltf file with the native glTF loader (see GltfLoader.h), bypassing Assimp.
+	// Only m_SortMeshesByMortonCode of the mesh processing params applies to glTF files.
+	static Scene* LoadGltfScene(const wchar_t* pFilePath, const MeshProcessingParams& meshProcessingParams = MeshProcessingParams(),
+		const DynamicObjectParams& dynamicObjectParams = DynamicObjectParams());
 };
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Scene/Scene.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Immutable view of the scene content at the time it was published.
+// The objects are shared with the other snapshots and are only exposed as const. Their content does not change
+// once they have been added, except for the instance transforms of the mesh batches, which the snapshot copies.
+// Residency of streamed geometry is owned by SceneStreamer and is not part of the snapshot.
+class SceneSnapshot
+{
+public:
+	// Epochs are increasing with each published snapshot.
+	u64 GetEpoch() const { return m_Epoch; }
+	const AxisAlignedBox& GetWorldBounds() const { return m_WorldBounds; }
+
+	std::size_t GetNumMeshBatches() const { return m_MeshBatches.size(); }
+	const MeshBatch* const* GetMeshBatches() const { return m_MeshBatches.data(); }
+
+	// Instances of the mesh batch moved since the previous snapshot, in the format of MeshBatch::ExtractDirtyMeshInstanceRanges.
+	const std::vector<MeshBatch::MeshInstanceRange>& GetMovedMeshInstanceRanges(std::size_t meshBatchIndex) const { return m_MovedMeshInstanceRanges[meshBatchIndex]; }
+
+	// World transforms and bounds of the mesh batch instances at the time of publishing.
+	// They should be read instead of the ones of the mesh batch, which can already have moved on.
+	const Matrix4f* GetMeshInstanceWorldMatrices(std::size_t meshBatchIndex) const { return m_MeshInstances[meshBatchIndex]->m_WorldMatrices.data(); }
+	const AxisAlignedBox* GetMeshInstanceWorldAABBs(std::size_t meshBatchIndex) const { return m_MeshInstances[meshBatchIndex]->m_WorldAABBs.data(); }
+	const OrientedBox* GetMeshInstanceWorldOBBs(std::size_t meshBatchIndex) const { return m_MeshInstances[meshBatchIndex]->m_WorldOBBs.data(); }
+
+	// Slots of removed materials are nullptr (see Scene::AddMaterial).
+	std::size_t GetNumMaterials() const { return m_Materials.size(); }
+	const Material* const* GetMaterials() const { return m_Materials.data(); }
+
+	const DirectionalLight* GetDirectionalLight() const { return m_pDirectionalLight; }
+
+	std::size_t GetNumPointLights() const { return m_PointLights.size(); }
+	const PointLight* const* GetPointLights() const { return m_PointLights.data(); }
+
+	std::size_t GetNumSpotLights() const { return m_SpotLights.size(); }
+	const SpotLight* const* GetSpotLights() const { return m_SpotLights.data(); }
+
+private:
+	friend class SceneSnapshotStore;
+
+	// Shared with the following snapshots until an instance of the mesh batch moves.
+	struct MeshInstances
+	{
+		std::vector<Matrix4f> m_WorldMatrices;
+		std::vector<AxisAlignedBox> m_WorldAABBs;
+		std::vector<OrientedBox> m_WorldOBBs;
+	};
+
+	u64 m_Epoch = 0;
+	u32 m_NumReaders = 0;
+	AxisAlignedBox m_WorldBounds = AxisAlignedBox(Vector3f::ZERO, Vector3f::ZERO);
+	std::vector<MeshBatch*> m_MeshBatches;
+	std::vector<std::vector<MeshBatch::MeshInstanceRange>> m_MovedMeshInstanceRanges;
+	std::vector<std::shared_ptr<const MeshInstances>> m_MeshInstances;
+	std::vector<Material*> m_Materials;
+	DirectionalLight* m_pDirectionalLight = nullptr;
+	std::vector<PointLight*> m_PointLights;
+	std::vector<SpotLight*> m_SpotLights;
+};
+
+// Lets loader and streaming threads add and remove scene objects and move dynamic mesh instances while the render thread reads a consistent snapshot.
+// The edits are applied to the scene under a lock and become visible to the readers with the next Publish,
+// which copies the object lists and the transforms of the moved mesh instances into a new snapshot. Edits do not block the readers, except for the short time a snapshot is swapped in.
+// The render thread acquires the latest snapshot when it starts a frame and releases it once the frame has completed on GPU.
+// Snapshots no one has acquired are deleted as soon as a newer one is published. A removed object is deleted
+// once every snapshot published before the removal has been released (epoch-based reclamation).
+// The camera is not part of the snapshots and stays with the render thread.
+class SceneSnapshotStore
+{
+public:
+	// Takes ownership of the scene and publishes its current content as the first snapshot.
+	SceneSnapshotStore(Scene* pScene);
+	~SceneSnapshotStore();
+
+	SceneSnapshotStore(const SceneSnapshotStore&) = delete;
+	SceneSnapshotStore& operator= (const SceneSnapshotStore&) = delete;
+
+	// Can be called from any thread. The store takes ownership of the added objects.
+	// Removed objects are deleted by the store and should not be added again.
+	// Remove* functions return false and leave the object to the caller if it is not part of the scene.
+	void AddMeshBatch(MeshBatch* pMeshBatch);
+	bool RemoveMeshBatch(MeshBatch* pMeshBatch);
+
+	// Moves the dynamic mesh instance, as MeshBatch::SetMeshInstanceWorldMatrix.
+	void SetMeshInstanceWorldMatrix(MeshBatch* pMeshBatch, u32 meshIndex, u32 meshInstanceIndex, const Matrix4f& worldMatrix);
+
+	// Returns the material ID, as Scene::AddMaterial.
+	u32 AddMaterial(Material* pMaterial);
+	bool RemoveMaterial(Material* pMaterial);
+
+	// The previous directional light is removed.
+	void SetDirectionalLight(DirectionalLight* pDirectionalLight);
+
+	void AddPointLight(PointLight* pPointLight);
+	bool RemovePointLight(PointLight* pPointLight);
+
+	void AddSpotLight(SpotLight* pSpotLight);
+	bool RemoveSpotLight(SpotLight* pSpotLight);
+
+	// Makes the edits since the last call visible to AcquireSnapshot and returns the epoch of the latest snapshot.
+	// No snapshot is created if there have been no edits.
+	u64 Publish();
+
+	// Returns the latest published snapshot, which stays valid until it is released.
+	// Every acquired snapshot should be released once, from any thread.
+	const SceneSnapshot* AcquireSnapshot();
+	void ReleaseSnapshot(const SceneSnapshot* pSnapshot);
+
+private:
+	struct RetiredObjects
+	{
+		std::vector<MeshBatch*> m_MeshBatches;
+		std::vector<Material*> m_Materials;
+		std::vector<DirectionalLight*> m_DirectionalLights;
+		std::vector<PointLight*> m_PointLights;
+		std::vector<SpotLight*> m_SpotLights;
+	};
+
+	struct RetiredObjectsAtEpoch
+	{
+		// The first snapshot which does not reference the objects.
+		u64 m_Epoch;
+		RetiredObjects m_Objects;
+	};
+
+	SceneSnapshot* CreateSnapshot(u64 epoch, const SceneSnapshot* pPrevSnapshot);
+	void CollectUnreferenced(std::vector<SceneSnapshot*>* pSnapshots, RetiredObjects* pObjects);
+	static void DeleteObjects(RetiredObjects* pObjects);
+
+private:
+	// Guards the scene and the objects removed since the last Publish.
+	std::mutex m_EditMutex;
+	Scene* m_pScene;
+	RetiredObjects m_PendingRetiredObjects;
+	bool m_HasEdits;
+
+	// Guards the snapshots and the reader counts. The snapshots are ordered by epoch and the last one is the latest.
+	std::mutex m_SnapshotMutex;
+	std::deque<SceneSnapshot*> m_Snapshots;
+	std::deque<RetiredObjectsAtEpoch> m_RetiredObjects;
+};
\ No newline at end of file
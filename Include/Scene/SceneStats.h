@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Scene/MeshOptimizer.h"
+
+class Scene;
+class MeshBatch;
+
+// Content statistics of the scene geometry, used to track the performance budgets of the assets.
+
+enum MeshStream
+{
+	MeshStream_Positions = 0,
+	MeshStream_Normals,
+	MeshStream_TexCoords,
+	MeshStream_Colors,
+	MeshStream_Tangents,
+	MeshStream_Indices,
+	MeshStream_InstanceWorldMatrices,
+	kNumMeshStreams
+};
+
+const char* GetMeshStreamName(MeshStream stream);
+
+static const u32 kNotDuplicateMesh = ~0u;
+
+struct SceneStatsParams
+{
+	u32 m_VertexCacheSize = kDefaultVertexCacheSize;
+	// A triangle with distinct indices is counted as zero-area if its area is below the epsilon
+	// times the squared length of its longest edge, which makes the test independent of the mesh scale.
+	f32 m_ZeroAreaEpsilon = 1e-6f;
+};
+
+struct MeshStats
+{
+	u32 m_MaterialID = 0;
+	u32 m_NumVertices = 0;
+	u32 m_NumTriangles = 0;
+	u32 m_NumInstances = 0;
+
+	VertexCacheStats m_VertexCacheStats;
+
+	// Triangles which reference the same vertex more than once.
+	u32 m_NumDegenerateTriangles = 0;
+	// Triangles with distinct vertices and no area.
+	u32 m_NumZeroAreaTriangles = 0;
+	// Vertices with all the attributes equal to an earlier vertex of the mesh.
+	u32 m_NumDuplicateVertices = 0;
+	// First mesh of the batch with the same vertices and indices, which could be drawn as an instance of it,
+	// or kNotDuplicateMesh.
+	u32 m_DuplicateOfMeshIndex = kNotDuplicateMesh;
+
+	// Volumes of the bounding shapes of the mesh vertices in the mesh space.
+	// The closer the volumes are to the volume of the mesh, the fewer false positives the culling has.
+	f32 m_AABBVolume = 0.0f;
+	f32 m_OBBVolume = 0.0f;
+	f32 m_SphereVolume = 0.0f;
+
+	u64 m_StreamSizesInBytes[kNumMeshStreams] = {};
+};
+
+struct MeshBatchStats
+{
+	u8 m_VertexFormatFlags = 0;
+	u8 m_VertexCompressionFlags = 0;
+	u32 m_IndexStrideInBytes = 0;
+
+	std::vector<MeshStats> m_MeshStats;
+
+	// Totals over the meshes of the batch.
+	u32 m_NumVertices = 0;
+	u32 m_NumTriangles = 0;
+	u32 m_NumInstances = 0;
+	u32 m_NumDynamicInstances = 0;
+	VertexCacheStats m_VertexCacheStats;
+	u32 m_NumDegenerateTriangles = 0;
+	u32 m_NumZeroAreaTriangles = 0;
+	u32 m_NumDuplicateVertices = 0;
+	u32 m_NumDuplicateMeshes = 0;
+	// Vertex and index bytes of the duplicate meshes, which instancing of the first mesh would save.
+	u64 m_DuplicateMeshSizeInBytes = 0;
+
+	// Instance counts against kMaxNumInstancesPerMesh.
+	u32 m_MaxNumInstancesPerMesh = 0;
+	u32 m_NumSingleInstanceMeshes = 0;
+	u32 m_NumMeshesAtInstanceLimit = 0;
+
+	u64 m_StreamSizesInBytes[kNumMeshStreams] = {};
+	// Size of the vertex buffers on the GPU with the selected vertex compression.
+	u64 m_GPUVertexSizeInBytes = 0;
+};
+
+struct SceneStats
+{
+	std::vector<MeshBatchStats> m_MeshBatchStats;
+
+	u32 m_NumMaterials = 0;
+	u32 m_NumPointLights = 0;
+	u32 m_NumSpotLights = 0;
+};
+
+// Meshes are analyzed in parallel.
+const MeshBatchStats AnalyzeMeshBatch(const MeshBatch* pMeshBatch, const SceneStatsParams& params = SceneStatsParams());
+const SceneStats AnalyzeScene(Scene* pScene, const SceneStatsParams& params = SceneStatsParams());
\ No newline at end of file
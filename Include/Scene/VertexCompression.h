@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Math/Vector2.h"
+#include "Math/Vector3.h"
+
+// Compressed vertex attribute formats used for GPU vertex buffers.
+// Position: R16G16B16A16_UNORM, normalized to the bounds of the mesh vertices.
+// Normal and tangent: R16G16_SNORM, octahedral encoding of the unit vector.
+// Texture coordinates: R16G16_UNORM, normalized to the texture coordinate range of the mesh.
+
+enum VertexCompressionFlags
+{
+	VertexCompressionFlag_None = 0,
+	VertexCompressionFlag_Position = 1 << 0,
+	VertexCompressionFlag_Normal = 1 << 1,
+	VertexCompressionFlag_Tangent = 1 << 2,
+	VertexCompressionFlag_TexCoords = 1 << 3
+};
+
+// Max encoding error allowed for each attribute. An attribute is stored uncompressed if its encoding error exceeds the budget.
+struct VertexPrecisionBudget
+{
+	// In world space units, taking into account the largest scale of the mesh instances.
+	f32 m_MaxPositionError = 1e-3f;
+	f32 m_MaxNormalErrorInDegrees = 0.1f;
+	f32 m_MaxTexCoordError = 1.0f / 4096.0f;
+};
+
+// Ranges of the quantized attributes of a mesh. A value quantized to [0, 1] is decoded as value * scale + bias.
+// Matches the layout of VertexQuantization in VertexDecoding.hlsl.
+struct VertexQuantization
+{
+	Vector3f m_PositionScale = Vector3f::ZERO;
+	Vector3f m_PositionBias = Vector3f::ZERO;
+	Vector2f m_TexCoordScale = Vector2f::ZERO;
+	Vector2f m_TexCoordBias = Vector2f::ZERO;
+};
+
+// pTexCoords can be nullptr if the mesh has no texture coordinates.
+const VertexQuantization CalcVertexQuantization(u32 numVertices, const Vector3f* pPositions, const Vector2f* pTexCoords);
+
+// Encoders process 4 vertices at a time with SSE2.
+void QuantizePositions(u32 numVertices, const Vector3f* pPositions, const VertexQuantization& quantization, u16* pQuantizedPositions);
+void QuantizeTexCoords(u32 numVertices, const Vector2f* pTexCoords, const VertexQuantization& quantization, u16* pQuantizedTexCoords);
+void EncodeOctahedralUnitVectors(u32 numVertices, const Vector3f* pUnitVectors, i16* pEncodedUnitVectors);
+
+const Vector3f DequantizePosition(const u16* pQuantizedPosition, const VertexQuantization& quantization);
+const Vector2f DequantizeTexCoords(const u16* pQuantizedTexCoords, const VertexQuantization& quantization);
+const Vector3f DecodeOctahedralUnitVector(const i16* pEncodedUnitVector);
+
+// Max errors of the encoders for the given vertices.
+f32 CalcPositionQuantizationError(const VertexQuantization& quantization);
+f32 CalcTexCoordQuantizationError(const VertexQuantization& quantization);
+f32 CalcOctahedralEncodingErrorInDegrees(u32 numVertices, const Vector3f* pUnitVectors);
\ No newline at end of file
@@ -86,6 +86,7 @@ DXApplication::~DXApplication()
 void DXApplication::OnInit()
 {
 	Scene* pScene = SceneLoader::LoadLivingRoom();
+	assert(pScene != nullptr);
 
 	InitRenderEnvironment();
 	InitPathTracingPass();
@@ -14,6 +14,7 @@
 #include "D3DWrapper/Fence.h"
 #include "D3DWrapper/RenderEnv.h"
 #include "D3DWrapper/SwapChain.h"
+#include "D3DWrapper/UploadRingBuffer.h"
 
 #include "Profiler/GPUProfiler.h"
 #include "Profiler/CPUProfiler.h"
@@ -30,6 +31,7 @@
 #include "RenderPasses/CubeMapToSHCoefficientsPass.h"
 #include "RenderPasses/FillMeshTypeDepthBufferPass.h"
 #include "RenderPasses/SpotLightShadowMapRenderer.h"
+#include "RenderPasses/ShadowMapAtlas.h"
 #include "RenderPasses/VisualizeNumLightsPerTilePass.h"
 #include "RenderPasses/VisualizeTexturePass.h"
 #include "RenderPasses/VisualizeDepthTexturePass.h"
@@ -45,6 +47,7 @@
 #include "Scene/Camera.h"
 #include "Scene/Scene.h"
 #include "Scene/SceneLoader.h"
+#include "Scene/SceneSnapshot.h"
 
 #include "Math/BasisAxes.h"
 #include "Math/Cone.h"
@@ -258,7 +261,10 @@ enum
 	kBackBufferWidth = kNumTilesX * kTileSize,
 	kBackBufferHeight = kNumTilesY * kTileSize,
 	kMaxNumActiveSpotLights = 6,
-	kShadowMapSize = 1024
+	kMinShadowMapSize = 128,
+	kShadowMapSize = 1024,
+	kShadowMapAtlasSize = 4096,
+	kUploadRingBufferSize = 1 << 20
 };
 
 DXApplication::DXApplication(HINSTANCE hApp)
@@ -280,6 +286,8 @@ DXApplication::~DXApplication()
 {
 	CoUninitialize();
 
+	SafeDelete(m_pSceneSnapshotStore);
+
 	for (u8 index = 0; index < kNumBackBuffers; ++index)
 		SafeDelete(m_VisualizeAccumLightPasses[index]);
 
@@ -331,6 +339,7 @@ DXApplication::~DXApplication()
 	SafeArrayDelete(m_pSpotLights);
 	SafeArrayDelete(m_ppActiveSpotLights);
 	SafeArrayDelete(m_pActiveSpotLightIndices);
+	SafeArrayDelete(m_pActiveSpotLightShadowMapSizes);
 
 	SafeDelete(m_pCPUProfiler);
 	SafeDelete(m_pGPUProfiler);
@@ -338,6 +347,7 @@ DXApplication::~DXApplication()
 	SafeDelete(m_pGeometryBuffer);
 	SafeDelete(m_pMeshRenderResources);
 	SafeDelete(m_pMaterialRenderResources);
+	SafeDelete(m_pUploadRingBuffer);
 		
 	SafeDelete(m_pActiveSpotLightWorldBoundsBuffer);
 	SafeDelete(m_pActiveSpotLightPropsBuffer);
@@ -383,8 +393,10 @@ DXApplication::~DXApplication()
 void DXApplication::OnInit()
 {
 	Scene* pScene = SceneLoader::LoadCrytekSponza();
+	assert(pScene != nullptr);
 
 	InitRenderEnvironment(kBackBufferWidth, kBackBufferHeight);
+	InitAnimatedMeshInstances(pScene);
 	InitScene(kBackBufferWidth, kBackBufferHeight, pScene);		
 	InitDownscaleAndReprojectDepthPass();
 	InitFrustumMeshCullingPass();
@@ -415,12 +427,24 @@ void DXApplication::OnInit()
 	InitVisualizeDepthBufferWithMeshTypePass();
 
 	InitCubeMapToSHCoefficientsPass();
-	SafeDelete(pScene);
+
+	// The store takes ownership of the scene.
+	m_pSceneSnapshotStore = new SceneSnapshotStore(pScene);
 }
 
 void DXApplication::OnUpdate(float deltaTimeInMS)
 {
 	ProcessUserInput(deltaTimeInMS);
+	UpdateAnimatedMeshInstances(deltaTimeInMS);
+
+	assert(m_FrameSceneSnapshots[m_BackBufferIndex] == nullptr);
+	m_pSceneSnapshotStore->Publish();
+
+	const SceneSnapshot* pSceneSnapshot = m_pSceneSnapshotStore->AcquireSnapshot();
+	m_FrameSceneSnapshots[m_BackBufferIndex] = pSceneSnapshot;
+
+	// Light render data is created once in OnInit. Adding or removing spot lights at run time is not supported yet.
+	assert(pSceneSnapshot->GetNumSpotLights() == m_NumSpotLights);
 
 	static Matrix4f prevViewProjMatrix = m_pCamera->GetViewMatrix() * m_pCamera->GetProjMatrix();
 	static Matrix4f prevViewProjInvMatrix = Inverse(prevViewProjMatrix);
@@ -504,6 +528,7 @@ void DXApplication::OnRender()
 	static CommandList* commandListBatch[MAX_NUM_COMMAND_LISTS_IN_BATCH];
 
 	u8 commandListBatchSize = 0;
+	commandListBatch[commandListBatchSize++] = RecordUpdateMeshInstancesPass();
 	commandListBatch[commandListBatchSize++] = RecordDownscaleAndReprojectDepthPass();
 	commandListBatch[commandListBatchSize++] = RecordPreRenderPass();
 	commandListBatch[commandListBatchSize++] = RecordFrustumMeshCullingPass();
@@ -533,6 +558,7 @@ void DXApplication::OnRender()
 
 	++m_pRenderEnv->m_LastSubmissionFenceValue;
 	m_pCommandQueue->ExecuteCommandLists(commandListBatchSize, commandListBatch, m_pFence, m_pRenderEnv->m_LastSubmissionFenceValue);
+	m_pUploadRingBuffer->FinishFrame(m_pRenderEnv->m_LastSubmissionFenceValue);
 	
 	++m_pRenderEnv->m_LastSubmissionFenceValue;
 #ifdef ENABLE_PROFILING
@@ -550,12 +576,27 @@ void DXApplication::OnRender()
 	m_FrameCompletionFenceValues[m_BackBufferIndex] = m_pRenderEnv->m_LastSubmissionFenceValue;
 	m_BackBufferIndex = m_pSwapChain->GetCurrentBackBufferIndex();
 	m_pFence->WaitForSignalOnCPU(m_FrameCompletionFenceValues[m_BackBufferIndex]);
+
+	if (m_FrameSceneSnapshots[m_BackBufferIndex] != nullptr)
+	{
+		m_pSceneSnapshotStore->ReleaseSnapshot(m_FrameSceneSnapshots[m_BackBufferIndex]);
+		m_FrameSceneSnapshots[m_BackBufferIndex] = nullptr;
+	}
 }
 
 void DXApplication::OnDestroy()
 {
 	m_pCommandQueue->Signal(m_pFence, m_pRenderEnv->m_LastSubmissionFenceValue);
 	m_pFence->WaitForSignalOnCPU(m_pRenderEnv->m_LastSubmissionFenceValue);
+
+	for (u8 index = 0; index < kNumBackBuffers; ++index)
+	{
+		if (m_FrameSceneSnapshots[index] != nullptr)
+		{
+			m_pSceneSnapshotStore->ReleaseSnapshot(m_FrameSceneSnapshots[index]);
+			m_FrameSceneSnapshots[index] = nullptr;
+		}
+	}
 }
 
 void DXApplication::ProcessUserInput(float deltaTimeInMS)
@@ -693,6 +734,7 @@ void DXApplication::InitScene(UINT backBufferWidth, UINT backBufferHeight, Scene
 
 	assert(pScene->GetNumMeshBatches() > 0);
 	m_pMeshRenderResources = new MeshRenderResources(m_pRenderEnv, pScene->GetNumMeshBatches(), pScene->GetMeshBatches());
+	m_pUploadRingBuffer = new UploadRingBuffer(m_pRenderEnv, kUploadRingBufferSize, L"m_pUploadRingBuffer");
 
 	assert(pScene->GetNumMaterials() > 0);
 	m_pMaterialRenderResources = new MaterialRenderResources(m_pRenderEnv, pScene->GetNumMaterials(), pScene->GetMaterials());
@@ -701,6 +743,108 @@ void DXApplication::InitScene(UINT backBufferWidth, UINT backBufferHeight, Scene
 		InitSpotLightRenderResources(pScene);
 }
 
+void DXApplication::InitAnimatedMeshInstances(Scene* pScene)
+{
+	// Should be called before the shadow map renderer is created, which splits the instances into static and dynamic ones.
+	assert(m_pSpotLightShadowMapRenderer == nullptr);
+
+	// The hanging vases of Sponza are turned around the vertical axis through their center.
+	for (u32 meshBatchIndex = 0; meshBatchIndex < pScene->GetNumMeshBatches(); ++meshBatchIndex)
+	{
+		MeshBatch* pMeshBatch = pScene->GetMeshBatches()[meshBatchIndex];
+		const MeshInfo* pMeshInfos = pMeshBatch->GetMeshInfos();
+
+		for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+		{
+			const MeshInfo& meshInfo = pMeshInfos[meshIndex];
+			const Material* pMaterial = pScene->GetMaterials()[meshInfo.m_MaterialID];
+			if ((pMaterial == nullptr) || (pMaterial->m_Name != L"vase_hanging"))
+				continue;
+
+			for (u32 meshInstanceIndex = 0; meshInstanceIndex < meshInfo.m_InstanceCount; ++meshInstanceIndex)
+			{
+				const u32 instanceIndex = meshInfo.m_InstanceOffset + meshInstanceIndex;
+				pMeshBatch->SetMeshInstanceFlags(instanceIndex, pMeshBatch->GetMeshInstanceFlags(instanceIndex) | MeshBatch::MeshInstanceFlag_Dynamic);
+
+				AnimatedMeshInstance animatedInstance;
+				animatedInstance.m_pMeshBatch = pMeshBatch;
+				animatedInstance.m_MeshIndex = meshIndex;
+				animatedInstance.m_MeshInstanceIndex = meshInstanceIndex;
+				animatedInstance.m_InitialWorldMatrix = pMeshBatch->GetMeshInstanceWorldMatrices()[instanceIndex];
+				animatedInstance.m_WorldPivotPoint = pMeshBatch->GetMeshInstanceWorldAABBs()[instanceIndex].m_Center;
+
+				m_AnimatedMeshInstances.push_back(animatedInstance);
+			}
+		}
+	}
+}
+
+void DXApplication::UpdateAnimatedMeshInstances(float deltaTimeInMS)
+{
+	if (m_AnimatedMeshInstances.empty())
+		return;
+
+	m_AnimationTimeInMS += deltaTimeInMS;
+	const f32 angleInRadians = 0.0005f * m_AnimationTimeInMS;
+
+	for (const AnimatedMeshInstance& animatedInstance : m_AnimatedMeshInstances)
+	{
+		const Vector3f& pivotPoint = animatedInstance.m_WorldPivotPoint;
+		const Matrix4f worldMatrix = animatedInstance.m_InitialWorldMatrix *
+			CreateTranslationMatrix(-pivotPoint.m_X, -pivotPoint.m_Y, -pivotPoint.m_Z) *
+			CreateRotationYMatrix(angleInRadians) *
+			CreateTranslationMatrix(pivotPoint.m_X, pivotPoint.m_Y, pivotPoint.m_Z);
+
+		m_pSceneSnapshotStore->SetMeshInstanceWorldMatrix(animatedInstance.m_pMeshBatch,
+			animatedInstance.m_MeshIndex, animatedInstance.m_MeshInstanceIndex, worldMatrix);
+	}
+}
+
+CommandList* DXApplication::RecordUpdateMeshInstancesPass()
+{
+	const SceneSnapshot* pSceneSnapshot = m_FrameSceneSnapshots[m_BackBufferIndex];
+	assert(pSceneSnapshot != nullptr);
+
+	CommandList* pCommandList = m_pCommandListPool->Create(L"pUpdateMeshInstancesCommandList");
+	pCommandList->Begin();
+#ifdef ENABLE_PROFILING
+	u32 profileIndex = m_pGPUProfiler->StartProfile(pCommandList, "UpdateMeshInstancesPass");
+#endif // ENABLE_PROFILING
+
+	// The instance data is read from the snapshot, as the animation keeps moving the instances of the mesh batches.
+	// Moved ranges are relative to the previous snapshot. If a snapshot has been skipped, all the instances are uploaded.
+	if (pSceneSnapshot->GetEpoch() != m_LastUploadedSceneEpoch)
+	{
+		const bool uploadAllInstances = (pSceneSnapshot->GetEpoch() != m_LastUploadedSceneEpoch + 1);
+		std::vector<MeshBatch::MeshInstanceRange> allInstanceRanges(1);
+
+		m_pUploadRingBuffer->ReleaseCompletedFrames(m_pFence);
+		for (u32 meshType = 0; meshType < pSceneSnapshot->GetNumMeshBatches(); ++meshType)
+		{
+			const MeshBatch* pMeshBatch = pSceneSnapshot->GetMeshBatches()[meshType];
+			const std::vector<MeshBatch::MeshInstanceRange>* pInstanceRanges = &pSceneSnapshot->GetMovedMeshInstanceRanges(meshType);
+			if (uploadAllInstances)
+			{
+				allInstanceRanges[0] = {0, pMeshBatch->GetNumMeshInstances()};
+				pInstanceRanges = &allInstanceRanges;
+			}
+
+			m_pMeshRenderResources->UpdateMeshInstances(pCommandList, m_pUploadRingBuffer, meshType, pSceneSnapshot->GetMeshInstanceWorldMatrices(meshType),
+				pSceneSnapshot->GetMeshInstanceWorldAABBs(meshType), pSceneSnapshot->GetMeshInstanceWorldOBBs(meshType), *pInstanceRanges);
+			if (m_pSpotLightShadowMapRenderer != nullptr)
+				m_pSpotLightShadowMapRenderer->UpdateMeshInstances(meshType, pSceneSnapshot->GetMeshInstanceWorldAABBs(meshType), *pInstanceRanges);
+		}
+		m_LastUploadedSceneEpoch = pSceneSnapshot->GetEpoch();
+	}
+
+#ifdef ENABLE_PROFILING
+	m_pGPUProfiler->EndProfile(pCommandList, profileIndex);
+#endif // ENABLE_PROFILING
+	pCommandList->End();
+
+	return pCommandList;
+}
+
 void DXApplication::InitDownscaleAndReprojectDepthPass()
 {
 	assert(m_pDownscaleAndReprojectDepthPass == nullptr);
@@ -1546,7 +1690,9 @@ void DXApplication::InitRenderSpotLightShadowMaps(Scene* pScene)
 	params.m_NumStaticMeshTypes = pScene->GetNumMeshBatches();
 	params.m_ppStaticMeshBatches = pScene->GetMeshBatches();
 	params.m_pStaticMeshRenderResources = m_pMeshRenderResources;
+	params.m_MinShadowMapSize = kMinShadowMapSize;
 	params.m_ShadowMapSize = kShadowMapSize;
+	params.m_ShadowMapAtlasSize = kShadowMapAtlasSize;
 	
 	m_pSpotLightShadowMapRenderer = new SpotLightShadowMapRenderer(&params);
 }
@@ -1938,6 +2084,7 @@ void DXApplication::InitSpotLightRenderResources(Scene* pScene)
 	m_pSpotLights = new SpotLightRenderData[m_NumSpotLights];
 	m_ppActiveSpotLights = new SpotLightRenderData*[m_NumSpotLights];
 	m_pActiveSpotLightIndices = new u32[m_NumSpotLights];
+	m_pActiveSpotLightShadowMapSizes = new u32[m_NumSpotLights];
 
 	for (decltype(m_NumSpotLights) lightIndex = 0; lightIndex < m_NumSpotLights; ++lightIndex)
 	{
@@ -2022,6 +2169,17 @@ void DXApplication::SetupSpotLightDataForUpload(const Frustum& cameraWorldFrustu
 		}
 	}
 		
+	// Lights covering larger part of the screen get higher resolution shadow maps.
+	const Vector3f& cameraWorldSpacePos = m_pCamera->GetWorldPosition();
+	const f32 cameraProjMatrix11 = m_pCamera->GetProjMatrix().m_11;
+
+	for (decltype(m_NumActiveSpotLights) lightIndex = 0; lightIndex < m_NumActiveSpotLights; ++lightIndex)
+	{
+		m_pActiveSpotLightShadowMapSizes[lightIndex] = CalcSpotLightShadowMapSize(m_ppActiveSpotLights[lightIndex]->m_WorldBounds,
+			cameraWorldSpacePos, cameraProjMatrix11, kBackBufferHeight, kMinShadowMapSize, kShadowMapSize);
+	}
+	m_pSpotLightShadowMapRenderer->UpdateShadowMapAtlas(m_NumActiveSpotLights, m_pActiveSpotLightIndices, m_pActiveSpotLightShadowMapSizes);
+
 	Sphere* pUploadActiveLightWorldBounds = (Sphere*)m_UploadActiveSpotLightWorldBounds[m_BackBufferIndex];
 	SpotLightProps* pUploadActiveLightProps = (SpotLightProps*)m_UploadActiveSpotLightProps[m_BackBufferIndex];
 	
@@ -2041,6 +2199,7 @@ void DXApplication::SetupSpotLightDataForUpload(const Frustum& cameraWorldFrustu
 		pUploadActiveLightProps[lightIndex].m_RcpViewClipRange = pLightData->m_RcpViewClipRange;
 		pUploadActiveLightProps[lightIndex].m_NegativeExpShadowMapConstant = pLightData->m_NegativeExpShadowMapConstant;
 		pUploadActiveLightProps[lightIndex].m_LightID = pLightData->m_LightID;
+		pUploadActiveLightProps[lightIndex].m_ShadowMapAtlasRect = m_pSpotLightShadowMapRenderer->CalcShadowMapAtlasRect(pLightData->m_LightID);
 	}
 
 #ifdef ENABLE_PROFILING
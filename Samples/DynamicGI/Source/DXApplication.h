@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Common/Application.h"
+#include "Math/Matrix4.h"
+#include "Math/Vector3.h"
 
 struct Frustum;
 struct HeapProperties;
@@ -17,6 +19,7 @@ class DescriptorHeap;
 class ColorTexture;
 class DepthTexture;
 class Buffer;
+class UploadRingBuffer;
 class Fence;
 class Camera;
 class GeometryBuffer;
@@ -40,6 +43,9 @@ class VisualizeDepthTexturePass;
 class VisualizeVoxelReflectancePass;
 class VoxelizePass;
 class Scene;
+class MeshBatch;
+class SceneSnapshot;
+class SceneSnapshotStore;
 class CPUProfiler;
 class GPUProfiler;
 
@@ -71,6 +77,10 @@ private:
 	
 	void InitRenderEnvironment(UINT backBufferWidth, UINT backBufferHeight);
 	void InitScene(UINT backBufferWidth, UINT backBufferHeight, Scene* pScene);
+
+	void InitAnimatedMeshInstances(Scene* pScene);
+	void UpdateAnimatedMeshInstances(float deltaTimeInMS);
+	CommandList* RecordUpdateMeshInstancesPass();
 	
 	void InitDownscaleAndReprojectDepthPass();
 	CommandList* RecordDownscaleAndReprojectDepthPass();
@@ -186,6 +196,26 @@ private:
 	UINT64 m_FrameCompletionFenceValues[kNumBackBuffers] = {0, 0, 0};
 	UINT m_BackBufferIndex = 0;
 
+	// The snapshot a frame was rendered from is held until the frame has completed on GPU.
+	SceneSnapshotStore* m_pSceneSnapshotStore = nullptr;
+	const SceneSnapshot* m_FrameSceneSnapshots[kNumBackBuffers] = {nullptr, nullptr, nullptr};
+
+	struct AnimatedMeshInstance
+	{
+		MeshBatch* m_pMeshBatch;
+		u32 m_MeshIndex;
+		u32 m_MeshInstanceIndex;
+		Matrix4f m_InitialWorldMatrix;
+		Vector3f m_WorldPivotPoint;
+	};
+
+	// Dynamic instances are moved through the snapshot store, and the instance buffers are updated
+	// from the moved ranges of the acquired snapshot, with the data written to the upload ring.
+	std::vector<AnimatedMeshInstance> m_AnimatedMeshInstances;
+	f32 m_AnimationTimeInMS = 0.0f;
+	u64 m_LastUploadedSceneEpoch = 0;
+	UploadRingBuffer* m_pUploadRingBuffer = nullptr;
+
 	Camera* m_pCamera = nullptr;
 	MeshRenderResources* m_pMeshRenderResources = nullptr;
 	MaterialRenderResources* m_pMaterialRenderResources = nullptr;
@@ -224,6 +254,7 @@ private:
 	u32 m_NumActiveSpotLights = 0;
 	SpotLightRenderData** m_ppActiveSpotLights = nullptr;
 	u32* m_pActiveSpotLightIndices = nullptr;
+	u32* m_pActiveSpotLightShadowMapSizes = nullptr;
 		
 	Buffer* m_pActiveSpotLightWorldBoundsBuffer = nullptr;
 	Buffer* m_pActiveSpotLightPropsBuffer = nullptr;
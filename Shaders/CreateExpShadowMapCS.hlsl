@@ -11,11 +11,12 @@ cbuffer Constants32BitBuffer : register(b0)
 {
 	uint g_StandardShadowMapIndex;
 	uint g_ExpShadowMapIndex;
+	uint2 g_ExpShadowMapTileOffset;
 }
 
 Texture2DArray<float> g_StandardShadowMaps : register(t0);
 StructuredBuffer<CreateExpShadowMapParams> g_CreateExpShadowMapParamsBuffer : register(t1);
-RWTexture2DArray<float> g_ExpShadowMaps : register(u0);
+RWTexture2D<float> g_ExpShadowMaps : register(u0);
 
 [numthreads(NUM_THREADS, NUM_THREADS, 1)]
 void Main(uint3 globalThreadId : SV_DispatchThreadID)
@@ -26,5 +27,5 @@ void Main(uint3 globalThreadId : SV_DispatchThreadID)
 	float lightSpaceDepth = params.lightProjMatrix32 / (hardwareDepth - params.lightProjMatrix22);
 	float linearDepth = (lightSpaceDepth - params.lightViewNearPlane) * params.lightRcpViewClipRange;
 
-	g_ExpShadowMaps[uint3(globalThreadId.xy, g_ExpShadowMapIndex)] = exp(params.expShadowMapConstant * linearDepth);
+	g_ExpShadowMaps[g_ExpShadowMapTileOffset + globalThreadId.xy] = exp(params.expShadowMapConstant * linearDepth);
 }
\ No newline at end of file
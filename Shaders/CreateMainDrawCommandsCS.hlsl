@@ -10,11 +10,11 @@ RWStructuredBuffer<DrawCommand> g_DrawCommandBuffer : register(u2);
 RWBuffer<uint> g_NumOccludedInstancesBuffer : register(u3);
 RWBuffer<uint> g_OccludedInstanceIndexBuffer : register(u4);
 
+// Every instance is either visible or occluded, so both lists share one array to fit into the groupshared memory limit.
+// Visible instances are added from the front of the array and occluded instances from the back.
+groupshared uint g_InstanceIndicesPerMesh[MAX_NUM_INSTANCES_PER_MESH];
 groupshared uint g_NumVisibleInstancesPerMesh;
-groupshared uint g_VisibleInstanceIndicesPerMesh[MAX_NUM_INSTANCES_PER_MESH];
-
 groupshared uint g_NumOccludedInstancesPerMesh;
-groupshared uint g_OccludedInstanceIndicesPerMesh[MAX_NUM_INSTANCES_PER_MESH];
 groupshared uint g_OccludedInstanceOffsetPerMesh;
 
 [numthreads(NUM_THREADS_PER_MESH, 1, 1)]
@@ -36,13 +36,13 @@ void Main(uint3 groupId : SV_GroupID, uint localIndex : SV_GroupIndex)
 		{
 			uint listIndex;
 			InterlockedAdd(g_NumVisibleInstancesPerMesh, 1, listIndex);
-			g_VisibleInstanceIndicesPerMesh[listIndex] = instanceIndex;
+			g_InstanceIndicesPerMesh[listIndex] = instanceIndex;
 		}
 		else
 		{
 			uint listIndex;
 			InterlockedAdd(g_NumOccludedInstancesPerMesh, 1, listIndex);
-			g_OccludedInstanceIndicesPerMesh[listIndex] = instanceIndex;
+			g_InstanceIndicesPerMesh[meshInfo.numInstances - 1 - listIndex] = instanceIndex;
 		}
 	}
 	GroupMemoryBarrierWithGroupSync();
@@ -73,8 +73,8 @@ void Main(uint3 groupId : SV_GroupID, uint localIndex : SV_GroupIndex)
 	GroupMemoryBarrierWithGroupSync();
 
 	for (uint index = localIndex; index < g_NumVisibleInstancesPerMesh; index += NUM_THREADS_PER_MESH)
-		g_VisibleInstanceIndexBuffer[meshInfo.instanceOffset + index] = g_VisibleInstanceIndicesPerMesh[index];
+		g_VisibleInstanceIndexBuffer[meshInfo.instanceOffset + index] = g_InstanceIndicesPerMesh[index];
 
 	for (uint index = localIndex; index < g_NumOccludedInstancesPerMesh; index += NUM_THREADS_PER_MESH)
-		g_OccludedInstanceIndexBuffer[g_OccludedInstanceOffsetPerMesh + index] = g_OccludedInstanceIndicesPerMesh[index];
+		g_OccludedInstanceIndexBuffer[g_OccludedInstanceOffsetPerMesh + index] = g_InstanceIndicesPerMesh[meshInfo.numInstances - 1 - index];
 }
@@ -1,4 +1,5 @@
 #include "Foundation.hlsl"
+#include "InstanceDecoding.hlsl"
 
 struct VSInput
 {
@@ -18,7 +19,7 @@ cbuffer AppDataBuffer : register(b0)
 }
 
 Buffer<uint> g_InstanceIndexBuffer : register(t0);
-StructuredBuffer<float4x4> g_InstanceWorldOBBMatrixBuffer : register(t1);
+StructuredBuffer<AffineTransform> g_InstanceWorldOBBMatrixBuffer : register(t1);
 
 VSOutput Main(VSInput input)
 {
@@ -30,7 +31,7 @@ VSOutput Main(VSInput input)
 		((input.vertexId & 4) == 0) ? -1.0f : 1.0f,
 		1.0f);
 
-	float4x4 worldMatrix = g_InstanceWorldOBBMatrixBuffer[instanceIndex];
+	float4x4 worldMatrix = DecodeAffineTransform(g_InstanceWorldOBBMatrixBuffer[instanceIndex]);
 	float4 worldSpacePos = mul(worldMatrix, localSpacePos);
 
 	VSOutput output;
@@ -1,24 +1,55 @@
-static const float g_RcpShadowMapSize = 1.0f / float(SHADOW_MAP_SIZE);
+static const float g_RcpAtlasSize = 1.0f / float(ATLAS_SIZE);
+static const float g_RcpIntermediateResultSize = 1.0f / float(INTERMEDIATE_RESULT_SIZE);
 static const float4 g_FilterWeights = {0.00038771f, 0.01330373f, 0.11098164f, 0.22508352f};
+static const int g_FilterRadius = 3;
 
 cbuffer Constants32BitBuffer : register(b0)
 {
-	uint g_ExpShadowMapIndex;
+	uint2 g_ExpShadowMapTileOffset;
+	uint g_ExpShadowMapTileSize;
 	uint g_IntermediateResultIndex;
 };
 
+// Texels outside of the tile belong to other lights in the atlas.
+// Gather is used where the filter fits into the tile, and loads clamped to the tile edge near the tile border.
+bool IsFilterInsideTile(int texelCoord)
+{
+	return (texelCoord >= g_FilterRadius) && (texelCoord + g_FilterRadius < int(g_ExpShadowMapTileSize));
+}
+
+int ClampToTile(int texelCoord)
+{
+	return clamp(texelCoord, 0, int(g_ExpShadowMapTileSize) - 1);
+}
+
 #ifdef FILTER_X
-Texture2DArray<float> g_ExpShadowMaps : register(t0);
+Texture2D<float> g_ExpShadowMaps : register(t0);
 RWTexture2DArray<float> g_IntermediateResults : register(u0);
 SamplerState g_PointSampler : register(s0);
 
+float LoadExpDepth(int2 texelPos, int offsetX)
+{
+	return g_ExpShadowMaps[g_ExpShadowMapTileOffset + uint2(ClampToTile(texelPos.x + offsetX), texelPos.y)];
+}
+
 [numthreads(NUM_THREADS, NUM_THREADS, 1)]
 void Main(uint3 globalThreadId : SV_DispatchThreadID)
 {
-	float3 texCoord = float3((float2(globalThreadId.xy) + 0.5f) * g_RcpShadowMapSize, g_ExpShadowMapIndex);
+	int2 texelPos = int2(globalThreadId.xy);
 
-	float4 depthValues1 = g_ExpShadowMaps.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2(-1, 0), int2(-2, 0), int2(-3, 0));
-	float4 depthValues2 = g_ExpShadowMaps.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2( 1, 0), int2( 2, 0), int2( 3, 0));
+	float4 depthValues1;
+	float4 depthValues2;
+	if (IsFilterInsideTile(texelPos.x))
+	{
+		float2 texCoord = (float2(g_ExpShadowMapTileOffset + globalThreadId.xy) + 0.5f) * g_RcpAtlasSize;
+		depthValues1 = g_ExpShadowMaps.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2(-1, 0), int2(-2, 0), int2(-3, 0));
+		depthValues2 = g_ExpShadowMaps.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2( 1, 0), int2( 2, 0), int2( 3, 0));
+	}
+	else
+	{
+		depthValues1 = float4(LoadExpDepth(texelPos, 0), LoadExpDepth(texelPos, -1), LoadExpDepth(texelPos, -2), LoadExpDepth(texelPos, -3));
+		depthValues2 = float4(depthValues1.x, LoadExpDepth(texelPos, 1), LoadExpDepth(texelPos, 2), LoadExpDepth(texelPos, 3));
+	}
 
 	float filteredDepthValue = dot(g_FilterWeights.xyzw, depthValues1.xyzw) + dot(g_FilterWeights.yzw, depthValues2.yzw);
 	g_IntermediateResults[uint3(globalThreadId.xy, g_IntermediateResultIndex)] = filteredDepthValue;
@@ -27,18 +58,34 @@ void Main(uint3 globalThreadId : SV_DispatchThreadID)
 
 #ifdef FILTER_Y
 Texture2DArray<float> g_IntermediateResults : register(t0);
-RWTexture2DArray<float> g_FilteredExpShadowMaps : register(u0);
+RWTexture2D<float> g_FilteredExpShadowMaps : register(u0);
 SamplerState g_PointSampler : register(s0);
 
+float LoadIntermediateResult(int2 texelPos, int offsetY)
+{
+	return g_IntermediateResults[uint3(texelPos.x, ClampToTile(texelPos.y + offsetY), g_IntermediateResultIndex)];
+}
+
 [numthreads(NUM_THREADS, NUM_THREADS, 1)]
 void Main(uint3 globalThreadId : SV_DispatchThreadID)
 {
-	float3 texCoord = float3((float2(globalThreadId.xy) + 0.5f) * g_RcpShadowMapSize, g_IntermediateResultIndex);
+	int2 texelPos = int2(globalThreadId.xy);
 
-	float4 depthValues1 = g_IntermediateResults.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2(0, -1), int2(0, -2), int2(0, -3));
-	float4 depthValues2 = g_IntermediateResults.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2(0,  1), int2(0,  2), int2(0,  3));
+	float4 depthValues1;
+	float4 depthValues2;
+	if (IsFilterInsideTile(texelPos.y))
+	{
+		float3 texCoord = float3((float2(globalThreadId.xy) + 0.5f) * g_RcpIntermediateResultSize, g_IntermediateResultIndex);
+		depthValues1 = g_IntermediateResults.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2(0, -1), int2(0, -2), int2(0, -3));
+		depthValues2 = g_IntermediateResults.GatherRed(g_PointSampler, texCoord, int2(0, 0), int2(0,  1), int2(0,  2), int2(0,  3));
+	}
+	else
+	{
+		depthValues1 = float4(LoadIntermediateResult(texelPos, 0), LoadIntermediateResult(texelPos, -1), LoadIntermediateResult(texelPos, -2), LoadIntermediateResult(texelPos, -3));
+		depthValues2 = float4(depthValues1.x, LoadIntermediateResult(texelPos, 1), LoadIntermediateResult(texelPos, 2), LoadIntermediateResult(texelPos, 3));
+	}
 
 	float filteredDepthValue = dot(g_FilterWeights.xyzw, depthValues1.xyzw) + dot(g_FilterWeights.yzw, depthValues2.yzw);
-	g_FilteredExpShadowMaps[uint3(globalThreadId.xy, g_ExpShadowMapIndex)] = filteredDepthValue;
+	g_FilteredExpShadowMaps[g_ExpShadowMapTileOffset + globalThreadId.xy] = filteredDepthValue;
 }
 #endif // FILTER_Y
\ No newline at end of file
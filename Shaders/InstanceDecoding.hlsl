@@ -0,0 +1,78 @@
+#ifndef __INSTANCE_DECODING__
+#define __INSTANCE_DECODING__
+
+// Decoding of the instance data formats produced by InstanceCompression.h.
+
+struct AffineTransform
+{
+	float4 row0;
+	float4 row1;
+	float4 row2;
+};
+
+struct SimilarityTransform
+{
+	float4 rotation;
+	float3 translation;
+	float scale;
+};
+
+struct QuantizedAABB
+{
+	uint minXY;
+	uint minZMaxX;
+	uint maxYZ;
+};
+
+float4x4 DecodeAffineTransform(AffineTransform transform)
+{
+	return float4x4(transform.row0, transform.row1, transform.row2, float4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+float3 TransformPoint(AffineTransform transform, float3 localSpacePos)
+{
+	float4 pos = float4(localSpacePos, 1.0f);
+	return float3(dot(transform.row0, pos), dot(transform.row1, pos), dot(transform.row2, pos));
+}
+
+float3 RotateVector(float4 quat, float3 vec)
+{
+	return vec + 2.0f * cross(quat.xyz, cross(quat.xyz, vec) + quat.w * vec);
+}
+
+float3 TransformPoint(SimilarityTransform transform, float3 localSpacePos)
+{
+	return RotateVector(transform.rotation, transform.scale * localSpacePos) + transform.translation;
+}
+
+// Normals are not affected by uniform scale, so the rotation is enough.
+float3 TransformNormal(SimilarityTransform transform, float3 localSpaceNormal)
+{
+	return RotateVector(transform.rotation, localSpaceNormal);
+}
+
+float4x4 DecodeSimilarityTransform(SimilarityTransform transform)
+{
+	float3 xAxis = transform.scale * RotateVector(transform.rotation, float3(1.0f, 0.0f, 0.0f));
+	float3 yAxis = transform.scale * RotateVector(transform.rotation, float3(0.0f, 1.0f, 0.0f));
+	float3 zAxis = transform.scale * RotateVector(transform.rotation, float3(0.0f, 0.0f, 1.0f));
+
+	return float4x4(
+		float4(xAxis.x, yAxis.x, zAxis.x, transform.translation.x),
+		float4(xAxis.y, yAxis.y, zAxis.y, transform.translation.y),
+		float4(xAxis.z, yAxis.z, zAxis.z, transform.translation.z),
+		float4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+// sceneMinPoint and sceneExtent are the bounds used for quantization. The decoded box encloses the original one.
+void DecodeQuantizedAABB(QuantizedAABB quantizedAABB, float3 sceneMinPoint, float3 sceneExtent, out float3 minPoint, out float3 maxPoint)
+{
+	float3 quantizedMinPoint = float3(quantizedAABB.minXY & 0xFFFF, quantizedAABB.minXY >> 16, quantizedAABB.minZMaxX & 0xFFFF);
+	float3 quantizedMaxPoint = float3(quantizedAABB.minZMaxX >> 16, quantizedAABB.maxYZ & 0xFFFF, quantizedAABB.maxYZ >> 16);
+	
+	float3 step = sceneExtent / 65535.0f;
+	minPoint = sceneMinPoint + quantizedMinPoint * step;
+	maxPoint = sceneMinPoint + quantizedMaxPoint * step;
+}
+
+#endif // __INSTANCE_DECODING__
\ No newline at end of file
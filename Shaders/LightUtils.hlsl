@@ -17,6 +17,7 @@ struct SpotLightProps
 	float rcpViewClipRange;
 	float negativeExpShadowMapConstant;
 	uint lightID;
+	float4 shadowMapAtlasRect;
 };
 
 float CalcDistanceFalloff(float squaredDistToLight, float lightRcpSquaredRange)
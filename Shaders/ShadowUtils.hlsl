@@ -1,7 +1,7 @@
 #ifndef __SHADOW_UTILS__
 #define __SHADOW_UTILS__
 
-float CalcSpotLightVisibility(Texture2DArray<float> lightShadowMaps, uint shadowMapIndex,
+float CalcSpotLightVisibility(Texture2D<float> lightShadowMapAtlas, float4 shadowMapAtlasRect,
 	SamplerState shadowMapSampler, float4x4 lightViewProjMatrix, float lightViewNearPlane,
 	float lightRcpViewClipRange, float negativeExpShadowMapConstant, float3 worldSpacePos)
 {
@@ -11,8 +11,11 @@ float CalcSpotLightVisibility(Texture2DArray<float> lightShadowMaps, uint shadow
 
 	float3 lightPostWDivideProjSpacePos = lightClipSpacePos.xyz / lightClipSpacePos.w;
 	float2 shadowMapCoords = float2(0.5f * (lightPostWDivideProjSpacePos.x + 1.0f), 0.5f * (1.0f - lightPostWDivideProjSpacePos.y));
+	
+	// The rect maps shadow map coordinates to texel centers of the light tile, so bilinear filtering does not pick up neighbor tiles.
+	float2 shadowMapAtlasCoords = shadowMapAtlasRect.xy + saturate(shadowMapCoords) * shadowMapAtlasRect.zw;
 
-	float shadowMapExpDepth = lightShadowMaps.SampleLevel(shadowMapSampler, float3(shadowMapCoords, shadowMapIndex), 0.0f);
+	float shadowMapExpDepth = lightShadowMapAtlas.SampleLevel(shadowMapSampler, shadowMapAtlasCoords, 0.0f);
 	float lightVisibility = saturate(exp(negativeExpShadowMapConstant * linearDepth) * shadowMapExpDepth);
 	
 	return lightVisibility;
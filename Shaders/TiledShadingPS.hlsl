@@ -26,7 +26,7 @@ Texture2D<float4> g_GBuffer4 : register(t4);
 StructuredBuffer<SpotLightProps> g_SpotLightPropsBuffer : register(t5);
 Buffer<uint> g_SpotLightIndexPerTileBuffer : register(t6);
 StructuredBuffer<Range> g_SpotLightRangePerTileBuffer : register(t7);
-Texture2DArray<float> g_SpotLightShadowMaps : register(t8);
+Texture2D<float> g_SpotLightShadowMaps : register(t8);
 #endif // ENABLE_SPOT_LIGHTS
 
 Buffer<uint> g_MaterialTextureIndicesBuffer : register(t9);
@@ -80,7 +80,7 @@ float4 Main(PSInput input) : SV_Target
 		uint lightIndex = g_SpotLightIndexPerTileBuffer[lightIndexPerTile];
 		SpotLightProps lightProps = g_SpotLightPropsBuffer[lightIndex];
 
-		float visibility = CalcSpotLightVisibility(g_SpotLightShadowMaps, lightProps.lightID,
+		float visibility = CalcSpotLightVisibility(g_SpotLightShadowMaps, lightProps.shadowMapAtlasRect,
 			g_ShadowMapSampler, lightProps.viewProjMatrix, lightProps.viewNearPlane, lightProps.rcpViewClipRange,
 			lightProps.negativeExpShadowMapConstant, worldSpacePos);
 
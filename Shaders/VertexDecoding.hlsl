@@ -0,0 +1,82 @@
+#ifndef __VERTEX_DECODING__
+#define __VERTEX_DECODING__
+
+// Decoding of the vertex attribute formats selected by MeshBatch::SelectVertexCompression.
+
+#ifndef POSITION_FORMAT_UNORM16
+#define POSITION_FORMAT_UNORM16 0
+#endif
+
+#ifndef NORMAL_FORMAT_OCTAHEDRAL
+#define NORMAL_FORMAT_OCTAHEDRAL 0
+#endif
+
+#ifndef TANGENT_FORMAT_OCTAHEDRAL
+#define TANGENT_FORMAT_OCTAHEDRAL 0
+#endif
+
+#ifndef TEXCOORD_FORMAT_UNORM16
+#define TEXCOORD_FORMAT_UNORM16 0
+#endif
+
+// Vertex formats without texture coordinates do not have TEXCOORD in the input layout.
+#ifndef VERTEX_HAS_TEXCOORDS
+#define VERTEX_HAS_TEXCOORDS 1
+#endif
+
+// Matches VertexQuantization in VertexCompression.h.
+// Maps [0, 1] range of UNORM positions and texture coordinates to the ranges of the mesh.
+struct VertexQuantization
+{
+	float3 positionScale;
+	float3 positionBias;
+	float2 texCoordScale;
+	float2 texCoordBias;
+};
+
+float3 DecodeOctahedralUnitVector(float2 encodedVector)
+{
+	float3 unitVector = float3(encodedVector.xy, 1.0f - abs(encodedVector.x) - abs(encodedVector.y));
+	if (unitVector.z < 0.0f)
+		unitVector.xy = (1.0f - abs(unitVector.yx)) * ((unitVector.xy >= 0.0f) ? 1.0f : -1.0f);
+	
+	return normalize(unitVector);
+}
+
+float3 DecodePosition(float4 encodedPosition, VertexQuantization quantization)
+{
+#if POSITION_FORMAT_UNORM16 == 1
+	return encodedPosition.xyz * quantization.positionScale + quantization.positionBias;
+#else
+	return encodedPosition.xyz;
+#endif
+}
+
+float3 DecodeNormal(float3 encodedNormal)
+{
+#if NORMAL_FORMAT_OCTAHEDRAL == 1
+	return DecodeOctahedralUnitVector(encodedNormal.xy);
+#else
+	return encodedNormal;
+#endif
+}
+
+float3 DecodeTangent(float3 encodedTangent)
+{
+#if TANGENT_FORMAT_OCTAHEDRAL == 1
+	return DecodeOctahedralUnitVector(encodedTangent.xy);
+#else
+	return encodedTangent;
+#endif
+}
+
+float2 DecodeTexCoords(float2 encodedTexCoords, VertexQuantization quantization)
+{
+#if TEXCOORD_FORMAT_UNORM16 == 1
+	return encodedTexCoords * quantization.texCoordScale + quantization.texCoordBias;
+#else
+	return encodedTexCoords;
+#endif
+}
+
+#endif // __VERTEX_DECODING__
\ No newline at end of file
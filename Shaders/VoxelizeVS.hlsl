@@ -1,9 +1,14 @@
+#include "VertexDecoding.hlsl"
+#include "InstanceDecoding.hlsl"
+
 struct VSInput
 {
 	uint   instanceId			: SV_InstanceID;
-	float3 localSpacePos		: POSITION;
+	float4 localSpacePos		: POSITION;
 	float3 localSpaceNormal		: NORMAL;
+#if VERTEX_HAS_TEXCOORDS == 1
 	float2 texCoord				: TEXCOORD;
+#endif
 };
 
 struct VSOutput
@@ -19,17 +24,25 @@ cbuffer Constants32BitBuffer : register(b1)
 }
 
 Buffer<uint> g_InstanceIndexBuffer : register(t0);
-StructuredBuffer<float4x4> g_InstanceWorldMatrixBuffer : register(t1);
+StructuredBuffer<AffineTransform> g_InstanceWorldMatrixBuffer : register(t1);
+StructuredBuffer<VertexQuantization> g_InstanceVertexQuantizationBuffer : register(t2);
 
 VSOutput Main(VSInput input)
 {
 	uint instanceIndex = g_InstanceIndexBuffer[g_InstanceOffset + input.instanceId];
-	float4x4 worldMatrix = g_InstanceWorldMatrixBuffer[instanceIndex];
+
+	VertexQuantization quantization = g_InstanceVertexQuantizationBuffer[instanceIndex];
+
+	float4x4 worldMatrix = DecodeAffineTransform(g_InstanceWorldMatrixBuffer[instanceIndex]);
 	
 	VSOutput output;
-	output.worldSpacePos = mul(worldMatrix, float4(input.localSpacePos, 1.0f));
-	output.worldSpaceNormal = mul(worldMatrix, float4(input.localSpaceNormal, 0.0f)).xyz;
-	output.texCoord = input.texCoord;
+	output.worldSpacePos = mul(worldMatrix, float4(DecodePosition(input.localSpacePos, quantization), 1.0f));
+	output.worldSpaceNormal = mul(worldMatrix, float4(DecodeNormal(input.localSpaceNormal), 0.0f)).xyz;
+#if VERTEX_HAS_TEXCOORDS == 1
+	output.texCoord = DecodeTexCoords(input.texCoord, quantization);
+#else
+	output.texCoord = float2(0.0f, 0.0f);
+#endif
 
 	return output;
 }
\ No newline at end of file
@@ -55,3 +55,69 @@ const std::wstring ExtractFileNameWithExtension(const std::wstring& filePath)
 	assert(false);
 	return std::wstring();
 }
+
+
+MemoryMappedFile::MemoryMappedFile()
+	: m_hFile(INVALID_HANDLE_VALUE)
+	, m_hFileMapping(nullptr)
+	, m_pData(nullptr)
+	, m_SizeInBytes(0)
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+bool MemoryMappedFile::Open(const wchar_t* pFilePath)
+{
+	assert(pFilePath != nullptr);
+	assert(!IsOpen());
+
+	m_hFile = CreateFile(pFilePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	m_SizeInBytes = (u64)GetFileSizeInBytes(m_hFile);
+	if (m_SizeInBytes == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_hFileMapping = CreateFileMapping(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hFileMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = (const u8*)MapViewOfFile(m_hFileMapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_pData == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+	if (m_pData != nullptr)
+	{
+		VerifyWinAPIResult(UnmapViewOfFile(m_pData));
+		m_pData = nullptr;
+	}
+	if (m_hFileMapping != nullptr)
+	{
+		VerifyWinAPIResult(CloseHandle(m_hFileMapping));
+		m_hFileMapping = nullptr;
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		VerifyWinAPIResult(CloseHandle(m_hFile));
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+	m_SizeInBytes = 0;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "Common/ParallelFor.h"
+#include <atomic>
+#include <thread>
+
+u32 GetNumWorkerThreads()
+{
+	const u32 numHardwareThreads = std::thread::hardware_concurrency();
+	return (numHardwareThreads > 0) ? numHardwareThreads : 1;
+}
+
+void ParallelFor(u32 numItems, const std::function<void(u32 itemIndex)>& func)
+{
+	const u32 numThreads = std::min(GetNumWorkerThreads(), numItems);
+	if (numThreads <= 1)
+	{
+		for (u32 itemIndex = 0; itemIndex < numItems; ++itemIndex)
+			func(itemIndex);
+		return;
+	}
+
+	std::atomic<u32> nextItemIndex(0);
+	auto processItems = [&]()
+	{
+		for (u32 itemIndex = nextItemIndex++; itemIndex < numItems; itemIndex = nextItemIndex++)
+			func(itemIndex);
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+
+	for (u32 threadIndex = 1; threadIndex < numThreads; ++threadIndex)
+		threads.emplace_back(processItems);
+
+	processItems();
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "Common/RangeAllocator.h"
+
+RangeAllocator::RangeAllocator(u32 capacity)
+	: m_Capacity(capacity)
+	, m_NumFreeElements(capacity)
+{
+	if (capacity > 0)
+		m_FreeRanges.emplace(0, capacity);
+}
+
+u32 RangeAllocator::Allocate(u32 size)
+{
+	assert(size > 0);
+	if (size > m_NumFreeElements)
+		return kInvalidOffset;
+
+	for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it)
+	{
+		const u32 rangeOffset = it->first;
+		const u32 rangeSize = it->second;
+
+		if (rangeSize >= size)
+		{
+			m_FreeRanges.erase(it);
+			if (rangeSize > size)
+				m_FreeRanges.emplace(rangeOffset + size, rangeSize - size);
+
+			m_NumFreeElements -= size;
+			return rangeOffset;
+		}
+	}
+	return kInvalidOffset;
+}
+
+void RangeAllocator::Free(u32 offset, u32 size)
+{
+	assert(size > 0);
+	assert(offset + size <= m_Capacity);
+
+	u32 rangeOffset = offset;
+	u32 rangeSize = size;
+
+	auto nextIt = m_FreeRanges.lower_bound(offset);
+	if (nextIt != m_FreeRanges.end())
+	{
+		assert(offset + size <= nextIt->first);
+		if (offset + size == nextIt->first)
+		{
+			rangeSize += nextIt->second;
+			nextIt = m_FreeRanges.erase(nextIt);
+		}
+	}
+	if (nextIt != m_FreeRanges.begin())
+	{
+		auto prevIt = std::prev(nextIt);
+		assert(prevIt->first + prevIt->second <= offset);
+		if (prevIt->first + prevIt->second == offset)
+		{
+			rangeOffset = prevIt->first;
+			rangeSize += prevIt->second;
+			m_FreeRanges.erase(prevIt);
+		}
+	}
+	m_FreeRanges.emplace(rangeOffset, rangeSize);
+	m_NumFreeElements += size;
+}
\ No newline at end of file
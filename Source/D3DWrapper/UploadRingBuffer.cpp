@@ -0,0 +1,93 @@
+#include "D3DWrapper/UploadRingBuffer.h"
+#include "D3DWrapper/GraphicsResource.h"
+#include "D3DWrapper/RenderEnv.h"
+#include "D3DWrapper/Fence.h"
+
+UploadRingBuffer::UploadRingBuffer(RenderEnv* pRenderEnv, UINT64 sizeInBytes, LPCWSTR pName)
+	: m_pBuffer(nullptr)
+	, m_pMappedData(nullptr)
+	, m_SizeInBytes(sizeInBytes)
+	, m_HeadOffset(0)
+	, m_TailOffset(0)
+	, m_NumUsedBytes(0)
+	, m_NumCurrentFrameBytes(0)
+{
+	assert(sizeInBytes > 0);
+
+	RawBufferDesc bufferDesc(sizeInBytes, false, false);
+	bufferDesc.Flags = D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
+
+	m_pBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pUploadHeapProps, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, pName);
+
+	// Upload heap resources can stay mapped for their lifetime.
+	const MemoryRange readRange(0, 0);
+	m_pMappedData = (u8*)m_pBuffer->Map(0, &readRange);
+}
+
+UploadRingBuffer::~UploadRingBuffer()
+{
+	m_pBuffer->Unmap(0);
+	SafeDelete(m_pBuffer);
+}
+
+u8* UploadRingBuffer::Allocate(UINT64 sizeInBytes, UINT64 alignment, UINT64* pOffsetInBytes)
+{
+	assert(sizeInBytes > 0);
+	assert((alignment > 0) && ((alignment & (alignment - 1)) == 0));
+
+	if (m_NumUsedBytes == 0)
+	{
+		m_HeadOffset = 0;
+		m_TailOffset = 0;
+	}
+
+	UINT64 offset = (m_HeadOffset + (alignment - 1)) & ~(alignment - 1);
+	UINT64 numPaddingBytes = offset - m_HeadOffset;
+
+	if ((m_HeadOffset >= m_TailOffset) && (m_NumUsedBytes < m_SizeInBytes))
+	{
+		// The free space is at the end and at the beginning of the buffer. Wrap around if the allocation does not fit at the end.
+		if (offset + sizeInBytes > m_SizeInBytes)
+		{
+			numPaddingBytes = m_SizeInBytes - m_HeadOffset;
+			offset = 0;
+			if (sizeInBytes > m_TailOffset)
+				return nullptr;
+		}
+	}
+	else if (offset + sizeInBytes > m_TailOffset)
+	{
+		return nullptr;
+	}
+
+	m_HeadOffset = offset + sizeInBytes;
+	if (m_HeadOffset == m_SizeInBytes)
+		m_HeadOffset = 0;
+
+	m_NumUsedBytes += numPaddingBytes + sizeInBytes;
+	m_NumCurrentFrameBytes += numPaddingBytes + sizeInBytes;
+
+	*pOffsetInBytes = offset;
+	return m_pMappedData + offset;
+}
+
+void UploadRingBuffer::FinishFrame(UINT64 fenceValue)
+{
+	if (m_NumCurrentFrameBytes == 0)
+		return;
+
+	m_PendingFrames.push({fenceValue, m_HeadOffset, m_NumCurrentFrameBytes});
+	m_NumCurrentFrameBytes = 0;
+}
+
+void UploadRingBuffer::ReleaseCompletedFrames(Fence* pFence)
+{
+	while (!m_PendingFrames.empty() && pFence->ReceivedSignal(m_PendingFrames.front().m_FenceValue))
+	{
+		const FrameAllocations& frame = m_PendingFrames.front();
+		m_TailOffset = frame.m_EndOffset;
+		m_NumUsedBytes -= frame.m_SizeInBytes;
+
+		m_PendingFrames.pop();
+	}
+}
\ No newline at end of file
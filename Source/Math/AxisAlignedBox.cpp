@@ -1,5 +1,6 @@
 #include "Math/AxisAlignedBox.h"
 #include "Math/Math.h"
+#include "Math/Matrix4.h"
 
 AxisAlignedBox::AxisAlignedBox()
 	: AxisAlignedBox(Vector3f::ZERO, Vector3f::ZERO)
@@ -39,3 +40,17 @@ AxisAlignedBox::AxisAlignedBox(const AxisAlignedBox& box1, const AxisAlignedBox&
     m_Center = 0.5f * (minPoint + maxPoint);
     m_Radius = maxPoint - m_Center;
 }
+
+
+const AxisAlignedBox TransformAxisAlignedBox(const AxisAlignedBox& box, const Matrix4f& matrix)
+{
+	const Vector3f center = TransformPoint(box.m_Center, matrix);
+
+	// Each radius component of the transformed box sums up the absolute contributions of the box radius along the matrix rows.
+	const Vector3f radius(
+		std::abs(matrix.m_00) * box.m_Radius.m_X + std::abs(matrix.m_10) * box.m_Radius.m_Y + std::abs(matrix.m_20) * box.m_Radius.m_Z,
+		std::abs(matrix.m_01) * box.m_Radius.m_X + std::abs(matrix.m_11) * box.m_Radius.m_Y + std::abs(matrix.m_21) * box.m_Radius.m_Z,
+		std::abs(matrix.m_02) * box.m_Radius.m_X + std::abs(matrix.m_12) * box.m_Radius.m_Y + std::abs(matrix.m_22) * box.m_Radius.m_Z);
+
+	return AxisAlignedBox(center, radius);
+}
\ No newline at end of file
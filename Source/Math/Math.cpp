@@ -152,3 +152,18 @@ f64 SmoothestStep(f64 minValue, f64 maxValue, f64 value)
 	f64 x = Saturate((value - minValue) / (maxValue - minValue));
 	return ((35.0 - 84.0 * x + 70.0 * x * x - 20.0 * x * x * x) * x * x * x * x);
 }
+
+
+u32 EncodeMortonCode(u32 x, u32 y, u32 z)
+{
+	auto spreadBits = [](u32 value)
+	{
+		value &= 0x000003FF;
+		value = (value ^ (value << 16)) & 0xFF0000FF;
+		value = (value ^ (value << 8)) & 0x0300F00F;
+		value = (value ^ (value << 4)) & 0x030C30C3;
+		value = (value ^ (value << 2)) & 0x09249249;
+		return value;
+	};
+	return (spreadBits(x) << 2) | (spreadBits(y) << 1) | spreadBits(z);
+}
\ No newline at end of file
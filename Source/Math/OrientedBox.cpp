@@ -1,4 +1,5 @@
 #include "Math/OrientedBox.h"
+#include "Math/Matrix4.h"
 
 OrientedBox::OrientedBox()
 	: m_Center(Vector3f::ZERO)
@@ -39,3 +40,36 @@ OrientedBox::OrientedBox(u32 numPoints, const Vector3f* pFirstPoint)
 
 	m_Radius = maxPoint - m_Center;
 }
+
+
+const OrientedBox TransformOrientedBox(const OrientedBox& box, const Matrix4f& matrix)
+{
+	auto transformDirection = [&matrix](const Vector3f& dir)
+	{
+		return Vector3f(
+			dir.m_X * matrix.m_00 + dir.m_Y * matrix.m_10 + dir.m_Z * matrix.m_20,
+			dir.m_X * matrix.m_01 + dir.m_Y * matrix.m_11 + dir.m_Z * matrix.m_21,
+			dir.m_X * matrix.m_02 + dir.m_Y * matrix.m_12 + dir.m_Z * matrix.m_22);
+	};
+
+	const Vector3f transformedAxes[] =
+	{
+		transformDirection(box.m_Orientation.m_XAxis),
+		transformDirection(box.m_Orientation.m_YAxis),
+		transformDirection(box.m_Orientation.m_ZAxis)
+	};
+
+	const Vector3f xAxis = Normalize(transformedAxes[0]);
+	const Vector3f yAxis = Normalize(transformedAxes[1] - Dot(transformedAxes[1], xAxis) * xAxis);
+	const Vector3f zAxis = Cross(xAxis, yAxis);
+
+	Vector3f radius(0.0f);
+	for (u8 index = 0; index < 3; ++index)
+	{
+		radius.m_X += box.m_Radius[index] * std::abs(Dot(transformedAxes[index], xAxis));
+		radius.m_Y += box.m_Radius[index] * std::abs(Dot(transformedAxes[index], yAxis));
+		radius.m_Z += box.m_Radius[index] * std::abs(Dot(transformedAxes[index], zAxis));
+	}
+
+	return OrientedBox(TransformPoint(box.m_Center, matrix), BasisAxes(xAxis, yAxis, zAxis), radius);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "Math/Random.h"
+#include "Math/Math.h"
+
+Random::Random(u64 seed, u64 streamIndex)
+	: m_State(0)
+	, m_Increment((streamIndex << 1) | 1)
+{
+	NextU32();
+	m_State += seed;
+	NextU32();
+}
+
+u32 Random::NextU32()
+{
+	const u64 oldState = m_State;
+	m_State = oldState * 6364136223846793005ull + m_Increment;
+
+	const u32 xorShifted = u32(((oldState >> 18) ^ oldState) >> 27);
+	const u32 rotation = u32(oldState >> 59);
+
+	return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+}
+
+u32 Random::NextU32(u32 bound)
+{
+	assert(bound > 0);
+
+	// Values below the threshold are rejected, so that the result is not biased towards small values.
+	const u32 threshold = (0u - bound) % bound;
+	for (;;)
+	{
+		const u32 value = NextU32();
+		if (value >= threshold)
+			return value % bound;
+	}
+}
+
+f32 Random::NextFloat()
+{
+	return f32(NextU32() >> 8) * (1.0f / 16777216.0f);
+}
+
+f32 Random::NextFloat(f32 minValue, f32 maxValue)
+{
+	return minValue + (maxValue - minValue) * NextFloat();
+}
+
+f32 Random::NextGaussian()
+{
+	// Box-Muller transform.
+	const f32 u1 = 1.0f - NextFloat();
+	const f32 u2 = NextFloat();
+
+	return std::sqrt(-2.0f * std::log(u1)) * std::cos(TWO_PI * u2);
+}
\ No newline at end of file
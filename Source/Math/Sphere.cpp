@@ -15,7 +15,50 @@ Sphere::Sphere(const Vector3f& center, f32 radius)
 
 Sphere::Sphere(u32 numPoints, const Vector3f* pFirstPoint)
 {
-	assert(false);
+	assert(numPoints > 0);
+
+	// Ritter's bounding sphere.
+	// The initial sphere is built from two distant points and then grown to enclose the points outside of it.
+	u32 pointIndexY = 0;
+	f32 maxSqDist = 0.0f;
+	for (u32 pointIndex = 1; pointIndex < numPoints; ++pointIndex)
+	{
+		const f32 sqDist = LengthSquared(pFirstPoint[pointIndex] - pFirstPoint[0]);
+		if (sqDist > maxSqDist)
+		{
+			maxSqDist = sqDist;
+			pointIndexY = pointIndex;
+		}
+	}
+
+	u32 pointIndexZ = pointIndexY;
+	maxSqDist = 0.0f;
+	for (u32 pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+	{
+		const f32 sqDist = LengthSquared(pFirstPoint[pointIndex] - pFirstPoint[pointIndexY]);
+		if (sqDist > maxSqDist)
+		{
+			maxSqDist = sqDist;
+			pointIndexZ = pointIndex;
+		}
+	}
+
+	m_Center = 0.5f * (pFirstPoint[pointIndexY] + pFirstPoint[pointIndexZ]);
+	m_Radius = 0.5f * Sqrt(maxSqDist);
+
+	for (u32 pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+	{
+		const Vector3f centerToPoint = pFirstPoint[pointIndex] - m_Center;
+		const f32 sqDist = LengthSquared(centerToPoint);
+		if (sqDist > Sqr(m_Radius))
+		{
+			const f32 dist = Sqrt(sqDist);
+			const f32 newRadius = 0.5f * (m_Radius + dist);
+
+			m_Center += centerToPoint * ((newRadius - m_Radius) / dist);
+			m_Radius = newRadius;
+		}
+	}
 }
 
 Sphere::Sphere(const Sphere& sphere1, const Sphere& sphere2)
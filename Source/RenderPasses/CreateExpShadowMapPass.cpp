@@ -15,6 +15,8 @@ namespace
 		kRootSRVTableParam,
 		kNumRootParams
 	};
+
+	const u32 kNumThreads = 8;
 }
 
 CreateExpShadowMapPass::CreateExpShadowMapPass(InitParams* pParams)
@@ -32,17 +34,13 @@ CreateExpShadowMapPass::~CreateExpShadowMapPass()
 
 void CreateExpShadowMapPass::Record(RenderParams* pParams)
 {
+	// Exp shadow map atlas is expected to stay in unordered access state while the tiles are being updated.
 	const ResourceTransitionBarrier resourceBarriers[] =
 	{
 		ResourceTransitionBarrier(pParams->m_pStandardShadowMaps,
 			D3D12_RESOURCE_STATE_DEPTH_WRITE,
 			m_OutputResourceStates.m_StandardShadowMapsState,
-			pParams->m_StandardShadowMapIndex),
-
-		ResourceTransitionBarrier(pParams->m_pExpShadowMaps,
-			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-			m_OutputResourceStates.m_ExpShadowMapsState,
-			pParams->m_ExpShadowMapIndex)
+			pParams->m_StandardShadowMapIndex)
 	};
 
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
@@ -53,7 +51,17 @@ void CreateExpShadowMapPass::Record(RenderParams* pParams)
 	u32 profileIndex = pGPUProfiler->StartProfile(pCommandList, "CreateExpShadowMapPass");
 #endif // ENABLE_PROFILING
 
-	const UINT constants32Bit[] = {pParams->m_StandardShadowMapIndex, pParams->m_ExpShadowMapIndex};
+	const ShadowMapTile& expShadowMapTile = pParams->m_ExpShadowMapTile;
+	assert(expShadowMapTile.m_Size <= pParams->m_pStandardShadowMaps->GetWidth());
+
+	const UINT constants32Bit[] =
+	{
+		pParams->m_StandardShadowMapIndex,
+		pParams->m_ExpShadowMapIndex,
+		expShadowMapTile.m_X,
+		expShadowMapTile.m_Y
+	};
+	const u32 numThreadGroups = (u32)Ceil((f32)expShadowMapTile.m_Size / (f32)kNumThreads);
 	
 	pCommandList->SetPipelineState(m_pPipelineState);
 	pCommandList->SetComputeRootSignature(m_pRootSignature);
@@ -61,7 +69,7 @@ void CreateExpShadowMapPass::Record(RenderParams* pParams)
 	pCommandList->ResourceBarrier(ARRAYSIZE(resourceBarriers), resourceBarriers);
 	pCommandList->SetComputeRoot32BitConstants(kRoot32BitConstantsParam, ARRAYSIZE(constants32Bit), constants32Bit, 0);
 	pCommandList->SetComputeRootDescriptorTable(kRootSRVTableParam, m_SRVHeapStart);
-	pCommandList->Dispatch(m_NumThreadGroupsX, m_NumThreadGroupsY, 1);
+	pCommandList->Dispatch(numThreadGroups, numThreadGroups, 1);
 
 #ifdef ENABLE_PROFILING
 	pGPUProfiler->EndProfile(pCommandList, profileIndex);
@@ -74,7 +82,7 @@ void CreateExpShadowMapPass::InitResources(InitParams* pParams)
 
 	assert(pParams->m_InputResourceStates.m_StandardShadowMapsState == D3D12_RESOURCE_STATE_DEPTH_WRITE);
 	assert(pParams->m_InputResourceStates.m_CreateExpShadowMapParamsBufferState == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	assert(pParams->m_InputResourceStates.m_ExpShadowMapsState == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	assert(pParams->m_InputResourceStates.m_ExpShadowMapsState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	
 	m_OutputResourceStates.m_StandardShadowMapsState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
 	m_OutputResourceStates.m_CreateExpShadowMapParamsBufferState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
@@ -98,7 +106,7 @@ void CreateExpShadowMapPass::InitRootSignature(InitParams* pParams)
 	assert(m_pRootSignature == nullptr);
 
 	D3D12_ROOT_PARAMETER rootParams[kNumRootParams];
-	rootParams[kRoot32BitConstantsParam] = Root32BitConstantsParameter(0, D3D12_SHADER_VISIBILITY_ALL, 2);
+	rootParams[kRoot32BitConstantsParam] = Root32BitConstantsParameter(0, D3D12_SHADER_VISIBILITY_ALL, 4);
 
 	const D3D12_DESCRIPTOR_RANGE descriptorRanges[] =
 	{
@@ -123,13 +131,9 @@ void CreateExpShadowMapPass::InitPipelineState(InitParams* pParams)
 
 	assert(pStandardShadowMaps->GetWidth() == pStandardShadowMaps->GetHeight());
 	assert(pExpShadowMaps->GetWidth() == pExpShadowMaps->GetHeight());
-	assert(pStandardShadowMaps->GetWidth() == pExpShadowMaps->GetWidth());
+	assert(pStandardShadowMaps->GetWidth() <= pExpShadowMaps->GetWidth());
 		
-	const u32 numThreads = 8;
-	m_NumThreadGroupsX = (u32)Ceil((f32)pExpShadowMaps->GetWidth() / (f32)numThreads);
-	m_NumThreadGroupsY = m_NumThreadGroupsX;
-
-	std::wstring numThreadsStr = std::to_wstring(numThreads);
+	std::wstring numThreadsStr = std::to_wstring(kNumThreads);
 	const ShaderDefine shaderDefines[] =
 	{
 		ShaderDefine(L"NUM_THREADS", numThreadsStr.c_str())
@@ -15,6 +15,8 @@ namespace
 		kRootSRVTableParam,
 		kNumRootParams
 	};
+
+	const u32 kNumThreads = 8;
 }
 
 FilterExpShadowMapPass::FilterExpShadowMapPass(InitParams* pParams)
@@ -38,7 +40,18 @@ void FilterExpShadowMapPass::Record(RenderParams* pParams)
 	CommandList* pCommandList = pParams->m_pCommandList;
 	GPUProfiler* pGPUProfiler = pRenderEnv->m_pGPUProfiler;
 	
-	const UINT constants32Bit[] = {pParams->m_ExpShadowMapIndex, pParams->m_IntermediateResultIndex};
+	const ShadowMapTile& expShadowMapTile = pParams->m_ExpShadowMapTile;
+	assert(expShadowMapTile.m_Size <= m_pIntermediateResults->GetWidth());
+
+	const UINT constants32Bit[] =
+	{
+		expShadowMapTile.m_X,
+		expShadowMapTile.m_Y,
+		expShadowMapTile.m_Size,
+		pParams->m_IntermediateResultIndex
+	};
+	const u32 numThreadGroups = (u32)Ceil((f32)expShadowMapTile.m_Size / (f32)kNumThreads);
+
 	pCommandList->SetDescriptorHeaps(pRenderEnv->m_pShaderVisibleSRVHeap);
 	pCommandList->SetComputeRootSignature(m_pRootSignature);
 	pCommandList->SetComputeRoot32BitConstants(kRoot32BitConstantsParam, ARRAYSIZE(constants32Bit), constants32Bit, 0);
@@ -52,8 +65,7 @@ void FilterExpShadowMapPass::Record(RenderParams* pParams)
 
 		ResourceTransitionBarrier(pParams->m_pExpShadowMaps,
 			D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-			pParams->m_ExpShadowMapIndex)
+			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
 	};
 
 #ifdef ENABLE_PROFILING
@@ -63,7 +75,7 @@ void FilterExpShadowMapPass::Record(RenderParams* pParams)
 	pCommandList->SetPipelineState(m_pPipelineStateX);
 	pCommandList->ResourceBarrier(ARRAYSIZE(resourceBarriersX), resourceBarriersX);
 	pCommandList->SetComputeRootDescriptorTable(kRootSRVTableParam, m_SRVHeapStartX);
-	pCommandList->Dispatch(m_NumThreadGroupsX, m_NumThreadGroupsY, 1);
+	pCommandList->Dispatch(numThreadGroups, numThreadGroups, 1);
 
 #ifdef ENABLE_PROFILING
 	pGPUProfiler->EndProfile(pCommandList, profileIndex1);
@@ -78,8 +90,7 @@ void FilterExpShadowMapPass::Record(RenderParams* pParams)
 
 		ResourceTransitionBarrier(pParams->m_pExpShadowMaps,
 			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-			D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-			pParams->m_ExpShadowMapIndex)
+			D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
 	};
 
 #ifdef ENABLE_PROFILING
@@ -89,7 +100,7 @@ void FilterExpShadowMapPass::Record(RenderParams* pParams)
 	pCommandList->SetPipelineState(m_pPipelineStateY);
 	pCommandList->ResourceBarrier(ARRAYSIZE(resourceBarriersY), resourceBarriersY);
 	pCommandList->SetComputeRootDescriptorTable(kRootSRVTableParam, m_SRVHeapStartY);
-	pCommandList->Dispatch(m_NumThreadGroupsX, m_NumThreadGroupsY, 1);
+	pCommandList->Dispatch(numThreadGroups, numThreadGroups, 1);
 
 #ifdef ENABLE_PROFILING
 	pGPUProfiler->EndProfile(pCommandList, profileIndex2);
@@ -104,7 +115,7 @@ void FilterExpShadowMapPass::InitResources(InitParams* pParams)
 	m_OutputResourceStates.m_ExpShadowMapsState = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
 	
 	assert(m_pIntermediateResults == nullptr);
-	ColorTexture2DDesc intermediateResultsDesc(pParams->m_pExpShadowMaps->GetFormat(), pParams->m_pExpShadowMaps->GetWidth(), pParams->m_pExpShadowMaps->GetHeight(),
+	ColorTexture2DDesc intermediateResultsDesc(pParams->m_pExpShadowMaps->GetFormat(), pParams->m_MaxExpShadowMapSize, pParams->m_MaxExpShadowMapSize,
 		false/*createRTV*/, true/*createSRV*/, true/*createUAV*/, 1/*mipLevels*/, pParams->m_MaxNumActiveExpShadowMaps/*arraySize*/);
 	m_pIntermediateResults = new ColorTexture(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &intermediateResultsDesc,
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, nullptr/*optimizedClearColor*/, L"FilterExpShadowMapPass::m_pIntermediateResults");
@@ -133,7 +144,7 @@ void FilterExpShadowMapPass::InitRootSignature(InitParams* pParams)
 	assert(m_pRootSignature == nullptr);
 
 	D3D12_ROOT_PARAMETER rootParams[kNumRootParams];
-	rootParams[kRoot32BitConstantsParam] = Root32BitConstantsParameter(0, D3D12_SHADER_VISIBILITY_ALL, 2);
+	rootParams[kRoot32BitConstantsParam] = Root32BitConstantsParameter(0, D3D12_SHADER_VISIBILITY_ALL, 4);
 
 	const D3D12_DESCRIPTOR_RANGE descriptorRanges[] =
 	{
@@ -155,18 +166,16 @@ void FilterExpShadowMapPass::InitPipelineState(InitParams* pParams)
 	ColorTexture* pExpShadowMaps = pParams->m_pExpShadowMaps;
 	assert(pExpShadowMaps->GetWidth() == pExpShadowMaps->GetHeight());
 
-	const u32 numThreads = 8;
-	const std::wstring numThreadsStr = std::to_wstring(numThreads);
-	const std::wstring shadowMapSizeStr = std::to_wstring(pExpShadowMaps->GetWidth());
-
-	m_NumThreadGroupsX = (u32)Ceil((f32)pExpShadowMaps->GetWidth() / (f32)numThreads);
-	m_NumThreadGroupsY = m_NumThreadGroupsX;
+	const std::wstring numThreadsStr = std::to_wstring(kNumThreads);
+	const std::wstring atlasSizeStr = std::to_wstring(pExpShadowMaps->GetWidth());
+	const std::wstring intermediateResultSizeStr = std::to_wstring(pParams->m_MaxExpShadowMapSize);
 
 	{
 		assert(m_pPipelineStateX == nullptr);
 		const ShaderDefine shaderDefines[] =
 		{
-			ShaderDefine(L"SHADOW_MAP_SIZE", shadowMapSizeStr.c_str()),
+			ShaderDefine(L"ATLAS_SIZE", atlasSizeStr.c_str()),
+			ShaderDefine(L"INTERMEDIATE_RESULT_SIZE", intermediateResultSizeStr.c_str()),
 			ShaderDefine(L"FILTER_X", L"1"),
 			ShaderDefine(L"NUM_THREADS", numThreadsStr.c_str())
 		};
@@ -182,7 +191,8 @@ void FilterExpShadowMapPass::InitPipelineState(InitParams* pParams)
 		assert(m_pPipelineStateY == nullptr);
 		const ShaderDefine shaderDefines[] =
 		{
-			ShaderDefine(L"SHADOW_MAP_SIZE", shadowMapSizeStr.c_str()),
+			ShaderDefine(L"ATLAS_SIZE", atlasSizeStr.c_str()),
+			ShaderDefine(L"INTERMEDIATE_RESULT_SIZE", intermediateResultSizeStr.c_str()),
 			ShaderDefine(L"FILTER_Y", L"1"),
 			ShaderDefine(L"NUM_THREADS", numThreadsStr.c_str())
 		};
@@ -34,6 +34,9 @@ MaterialRenderResources::MaterialRenderResources(RenderEnv* pRenderEnv, u16 numM
 	const bool generateMips = true;
 	const u16 maxNumTextures = (1 + numMaterials) * Material::NumTextures;
 
+	// Mesh type here selects the shading permutation of the material in TiledShadingPass and is unrelated
+	// to the vertex format mesh types of MeshRenderResources. RenderGBufferPass writes the same G-buffer layout
+	// for all vertex formats, so every material is shaded the same way.
 	const u16 meshType = 0;
 	const u16 numMeshTypes = 1;
 	std::vector<u16> meshTypePerMaterialID;
@@ -63,7 +66,14 @@ MaterialRenderResources::MaterialRenderResources(RenderEnv* pRenderEnv, u16 numM
 
 	for (u16 materialIndex = 0; materialIndex < numMaterials; ++materialIndex)
 	{
+		// Removed materials keep their slot, so that the material IDs stay valid. No mesh references them.
 		const Material* pMaterial = ppMaterials[materialIndex];
+		if (pMaterial == nullptr)
+		{
+			materialTextureIndices.insert(materialTextureIndices.end(), Material::NumTextures, 0);
+			continue;
+		}
+
 		for (u16 textureIndex = 0; textureIndex < Material::NumTextures; ++textureIndex)
 		{
 			const bool forceSRGB = (textureIndex == Material::BaseColorTextureIndex);
@@ -4,16 +4,20 @@
 #include "D3DWrapper/PipelineState.h"
 #include "D3DWrapper/RenderEnv.h"
 #include "D3DWrapper/GraphicsUtils.h"
+#include "D3DWrapper/UploadRingBuffer.h"
 #include "Math/Vector2.h"
 #include "Math/Vector3.h"
 #include "Math/Vector4.h"
 #include "Math/Transform.h"
 #include "Scene/Mesh.h"
 #include "Scene/MeshBatch.h"
+#include "Scene/VertexCompression.h"
+#include "Scene/InstanceCompression.h"
 
 namespace
 {
 	u32 CalcMaxNumInstancesPerMesh(u32 numMeshTypes, MeshBatch** ppFirstMeshType);
+	void CopyVertexElements(u32 numVertices, const void* pElements, u32 elementSizeInBytes, u32 vertexStrideInBytes, u32 vertexOffset, u8* pVertexData);
 	const Matrix4f ExtractUnitAABBToWorldOBBTransform(const OrientedBox& worldOBB);
 }
 
@@ -26,9 +30,26 @@ MeshRenderResources::MeshRenderResources(RenderEnv* pRenderEnv, u32 numMeshTypes
 	, m_pInstanceWorldMatrixBuffer(nullptr)
 	, m_pInstanceWorldAABBBuffer(nullptr)
 	, m_pInstanceWorldOBBMatrixBuffer(nullptr)
+	, m_pInstanceVertexQuantizationBuffer(nullptr)
 {
-	InitPerMeshTypeResources(pRenderEnv, numMeshTypes, ppFirstMeshType);
-	InitPerMeshResources(pRenderEnv, numMeshTypes, ppFirstMeshType);
+	InitPerMeshTypeResources(pRenderEnv, numMeshTypes, ppFirstMeshType, nullptr);
+	InitPerMeshResources(pRenderEnv, numMeshTypes, ppFirstMeshType, false);
+	InitPerMeshInstanceResources(pRenderEnv, numMeshTypes, ppFirstMeshType);
+}
+
+MeshRenderResources::MeshRenderResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType, u64 geometryBudgetInBytes)
+	: m_NumMeshTypes(numMeshTypes)
+	, m_TotalNumMeshes(0)
+	, m_TotalNumInstances(0)
+	, m_MaxNumInstancesPerMesh(CalcMaxNumInstancesPerMesh(numMeshTypes, ppFirstMeshType))
+	, m_pMeshInfoBuffer(nullptr)
+	, m_pInstanceWorldMatrixBuffer(nullptr)
+	, m_pInstanceWorldAABBBuffer(nullptr)
+	, m_pInstanceWorldOBBMatrixBuffer(nullptr)
+	, m_pInstanceVertexQuantizationBuffer(nullptr)
+{
+	InitPerMeshTypeResources(pRenderEnv, numMeshTypes, ppFirstMeshType, &geometryBudgetInBytes);
+	InitPerMeshResources(pRenderEnv, numMeshTypes, ppFirstMeshType, true);
 	InitPerMeshInstanceResources(pRenderEnv, numMeshTypes, ppFirstMeshType);
 }
 
@@ -38,15 +59,17 @@ MeshRenderResources::~MeshRenderResources()
 	SafeDelete(m_pInstanceWorldMatrixBuffer);
 	SafeDelete(m_pInstanceWorldAABBBuffer);
 	SafeDelete(m_pInstanceWorldOBBMatrixBuffer);
+	SafeDelete(m_pInstanceVertexQuantizationBuffer);
 
 	for (u32 meshType = 0; meshType < m_NumMeshTypes; ++meshType)
 	{
 		SafeDelete(m_VertexBuffers[meshType]);
+		SafeDelete(m_PositionVertexBuffers[meshType]);
 		SafeDelete(m_IndexBuffers[meshType]);
 	}
 }
 
-void MeshRenderResources::InitPerMeshResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType)
+void MeshRenderResources::InitPerMeshResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType, bool streaming)
 {
 	m_TotalNumMeshes = 0;
 	for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
@@ -55,8 +78,8 @@ void MeshRenderResources::InitPerMeshResources(RenderEnv* pRenderEnv, u32 numMes
 		m_TotalNumMeshes += pMeshBatch->GetNumMeshes();
 	}
 
-	std::vector<MeshRenderInfo> meshInfoBufferData;
-	meshInfoBufferData.reserve(m_TotalNumMeshes);
+	m_MeshInfos.clear();
+	m_MeshInfos.reserve(m_TotalNumMeshes);
 	
 	u32 meshTypeOffset = 0;
 	u32 instanceOffset = 0;
@@ -69,18 +92,20 @@ void MeshRenderResources::InitPerMeshResources(RenderEnv* pRenderEnv, u32 numMes
 		const MeshInfo* pFirstMeshInfo = pMeshBatch->GetMeshInfos();
 		for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
 		{
+
 			const MeshInfo& meshInfo = pFirstMeshInfo[meshIndex];
 			const u32 materialID = meshInfo.m_MaterialID + 1;
 
-			meshInfoBufferData.emplace_back(
-				meshInfo.m_InstanceCount,
+			// In streaming mode the mesh is not drawn until its geometry has been uploaded.
+			m_MeshInfos.emplace_back(
+				streaming ? 0 : meshInfo.m_InstanceCount,
 				instanceOffset,
 				meshType,
 				meshTypeOffset,
 				materialID,
 				meshInfo.m_IndexCount,
-				meshInfo.m_StartIndexLocation,
-				meshInfo.m_BaseVertexLocation);
+				streaming ? 0 : meshInfo.m_StartIndexLocation,
+				streaming ? 0 : meshInfo.m_BaseVertexLocation);
 
 			instanceOffset += meshInfo.m_InstanceCount;
 		}
@@ -92,31 +117,44 @@ void MeshRenderResources::InitPerMeshResources(RenderEnv* pRenderEnv, u32 numMes
 		D3D12_RESOURCE_STATE_COPY_DEST, L"MeshRenderResources::m_pMeshInfoBuffer");
 	
 	UploadData(pRenderEnv, m_pMeshInfoBuffer, meshInfoBufferDesc, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		meshInfoBufferData.data(), m_TotalNumMeshes * sizeof(MeshRenderInfo));
+		m_MeshInfos.data(), m_TotalNumMeshes * sizeof(MeshRenderInfo));
 }
 
 void MeshRenderResources::InitPerMeshInstanceResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType)
 {
+	m_MeshTypeInstanceOffsets.resize(numMeshTypes);
+
 	m_TotalNumInstances = 0;
 	for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
 	{
 		const MeshBatch* pMeshBatch = ppFirstMeshType[meshType];
+		m_MeshTypeInstanceOffsets[meshType] = m_TotalNumInstances;
 		m_TotalNumInstances += pMeshBatch->GetNumMeshInstances();
 	}
 
 	std::vector<AxisAlignedBox> instanceWorldAABBBufferData;
 	instanceWorldAABBBufferData.reserve(m_TotalNumInstances);
 
-	std::vector<Matrix4f> instanceWorldOBBMatrixBufferData;
-	instanceWorldOBBMatrixBufferData.reserve(m_TotalNumInstances);
+	// World and OBB transforms are affine, so they are stored as 3x4 matrices.
+	std::vector<AffineTransform> instanceWorldOBBMatrixBufferData(m_TotalNumInstances);
+	std::vector<AffineTransform> instanceWorldMatrixBufferData(m_TotalNumInstances);
 
-	std::vector<Matrix4f> instanceWorldMatrixBufferData;
-	instanceWorldMatrixBufferData.reserve(m_TotalNumInstances);
+	std::vector<VertexQuantization> instanceVertexQuantizationBufferData(m_TotalNumInstances);
 
+	std::vector<Matrix4f> worldOBBMatrices;
 	for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
 	{
 		const MeshBatch* pMeshBatch = ppFirstMeshType[meshType];
 		const u32 numInstances = pMeshBatch->GetNumMeshInstances();
+		const u32 instanceOffset = m_MeshTypeInstanceOffsets[meshType];
+
+		const MeshInfo* pFirstMeshInfo = pMeshBatch->GetMeshInfos();
+		for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+		{
+			const MeshInfo& meshInfo = pFirstMeshInfo[meshIndex];
+			std::fill_n(&instanceVertexQuantizationBufferData[instanceOffset + meshInfo.m_InstanceOffset], meshInfo.m_InstanceCount,
+				m_MeshVertexQuantizations[m_MeshTypeOffsets[meshType] + meshIndex]);
+		}
 
 		const AxisAlignedBox* pFirstInstanceWorldAABB = pMeshBatch->GetMeshInstanceWorldAABBs();
 		instanceWorldAABBBufferData.insert(
@@ -125,17 +163,12 @@ void MeshRenderResources::InitPerMeshInstanceResources(RenderEnv* pRenderEnv, u3
 			pFirstInstanceWorldAABB + numInstances);
 
 		const OrientedBox* pFirstInstanceWorldOBB = pMeshBatch->GetMeshInstanceWorldOBBs();
+		worldOBBMatrices.resize(numInstances);
 		for (u32 instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
-		{
-			const OrientedBox& instanceWorldOBB = pFirstInstanceWorldOBB[instanceIndex];
-			instanceWorldOBBMatrixBufferData.emplace_back(ExtractUnitAABBToWorldOBBTransform(instanceWorldOBB));
-		}
+			worldOBBMatrices[instanceIndex] = ExtractUnitAABBToWorldOBBTransform(pFirstInstanceWorldOBB[instanceIndex]);
 
-		const Matrix4f* pFirstInstanceWorldMatrix = pMeshBatch->GetMeshInstanceWorldMatrices();
-		instanceWorldMatrixBufferData.insert(
-			instanceWorldMatrixBufferData.end(),
-			pFirstInstanceWorldMatrix,
-			pFirstInstanceWorldMatrix + numInstances);
+		PackAffineTransforms(numInstances, worldOBBMatrices.data(), &instanceWorldOBBMatrixBufferData[instanceOffset]);
+		PackAffineTransforms(numInstances, pMeshBatch->GetMeshInstanceWorldMatrices(), &instanceWorldMatrixBufferData[instanceOffset]);
 	}
 
 	StructuredBufferDesc instanceWorldAABBBufferDesc(m_TotalNumInstances, sizeof(AxisAlignedBox), true, false);
@@ -145,48 +178,186 @@ void MeshRenderResources::InitPerMeshInstanceResources(RenderEnv* pRenderEnv, u3
 	UploadData(pRenderEnv, m_pInstanceWorldAABBBuffer, instanceWorldAABBBufferDesc,
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, instanceWorldAABBBufferData.data(), m_TotalNumInstances * sizeof(AxisAlignedBox));
 
-	StructuredBufferDesc instanceWorldOBBMatrixBufferDesc(m_TotalNumInstances, sizeof(Matrix4f), true, false);
+	StructuredBufferDesc instanceWorldOBBMatrixBufferDesc(m_TotalNumInstances, sizeof(AffineTransform), true, false);
 	m_pInstanceWorldOBBMatrixBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps,
 		&instanceWorldOBBMatrixBufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, L"MeshRenderResources::m_pInstanceWorldOBBMatrixBuffer");
 	
 	UploadData(pRenderEnv, m_pInstanceWorldOBBMatrixBuffer, instanceWorldOBBMatrixBufferDesc,
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, instanceWorldOBBMatrixBufferData.data(), m_TotalNumInstances * sizeof(Matrix4f));
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, instanceWorldOBBMatrixBufferData.data(), m_TotalNumInstances * sizeof(AffineTransform));
 
-	StructuredBufferDesc instanceWorldMatrixBufferDesc(m_TotalNumInstances, sizeof(Matrix4f), true, false);
+	StructuredBufferDesc instanceWorldMatrixBufferDesc(m_TotalNumInstances, sizeof(AffineTransform), true, false);
 	m_pInstanceWorldMatrixBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps,
 		&instanceWorldMatrixBufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, L"MeshRenderResources::m_pInstanceWorldMatrixBuffer");
 	
 	UploadData(pRenderEnv, m_pInstanceWorldMatrixBuffer, instanceWorldMatrixBufferDesc,
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, instanceWorldMatrixBufferData.data(), m_TotalNumInstances * sizeof(Matrix4f));
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, instanceWorldMatrixBufferData.data(), m_TotalNumInstances * sizeof(AffineTransform));
+
+	StructuredBufferDesc instanceVertexQuantizationBufferDesc(m_TotalNumInstances, sizeof(VertexQuantization), true, false);
+	m_pInstanceVertexQuantizationBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps,
+		&instanceVertexQuantizationBufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, L"MeshRenderResources::m_pInstanceVertexQuantizationBuffer");
+
+	UploadData(pRenderEnv, m_pInstanceVertexQuantizationBuffer, instanceVertexQuantizationBufferDesc,
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, instanceVertexQuantizationBufferData.data(), m_TotalNumInstances * sizeof(VertexQuantization));
 }
 
-void MeshRenderResources::InitPerMeshTypeResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType)
+void MeshRenderResources::UpdateMeshInstances(CommandList* pCommandList, UploadRingBuffer* pUploadRing, u32 meshType, const Matrix4f* pInstanceWorldMatrices,
+	const AxisAlignedBox* pInstanceWorldAABBs, const OrientedBox* pInstanceWorldOBBs, const std::vector<MeshBatch::MeshInstanceRange>& instanceRanges)
+{
+	if (instanceRanges.empty())
+		return;
+
+	u32 numUpdatedInstances = 0;
+	for (const MeshBatch::MeshInstanceRange& instanceRange : instanceRanges)
+		numUpdatedInstances += instanceRange.m_NumInstances;
+
+	// The upload buffer stores world matrices, world AABBs and world OBB matrices of the updated instances one after another.
+	const UINT64 worldMatrixDataOffset = 0;
+	const UINT64 worldAABBDataOffset = worldMatrixDataOffset + numUpdatedInstances * sizeof(AffineTransform);
+	const UINT64 worldOBBMatrixDataOffset = worldAABBDataOffset + numUpdatedInstances * sizeof(AxisAlignedBox);
+	const UINT64 numUploadBytes = worldOBBMatrixDataOffset + numUpdatedInstances * sizeof(AffineTransform);
+
+	UINT64 uploadBufferOffset = 0;
+	u8* pUploadData = pUploadRing->Allocate(numUploadBytes, sizeof(Vector4f), &uploadBufferOffset);
+	assert(pUploadData != nullptr && "The upload ring should have room for the updates of all frames in flight");
+	{
+		AffineTransform* pWorldMatrixData = (AffineTransform*)(pUploadData + worldMatrixDataOffset);
+		AxisAlignedBox* pWorldAABBData = (AxisAlignedBox*)(pUploadData + worldAABBDataOffset);
+		AffineTransform* pWorldOBBMatrixData = (AffineTransform*)(pUploadData + worldOBBMatrixDataOffset);
+
+		for (const MeshBatch::MeshInstanceRange& instanceRange : instanceRanges)
+		{
+			PackAffineTransforms(instanceRange.m_NumInstances, pInstanceWorldMatrices + instanceRange.m_FirstInstance, pWorldMatrixData);
+			pWorldMatrixData += instanceRange.m_NumInstances;
+
+			for (u32 instanceIndex = instanceRange.m_FirstInstance; instanceIndex < instanceRange.m_FirstInstance + instanceRange.m_NumInstances; ++instanceIndex)
+			{
+				*pWorldAABBData++ = pInstanceWorldAABBs[instanceIndex];
+
+				const Matrix4f worldOBBMatrix = ExtractUnitAABBToWorldOBBTransform(pInstanceWorldOBBs[instanceIndex]);
+				PackAffineTransforms(1, &worldOBBMatrix, pWorldOBBMatrixData++);
+			}
+		}
+	}
+
+	const u32 numBuffers = 3;
+	Buffer* destBuffers[numBuffers] = {m_pInstanceWorldMatrixBuffer, m_pInstanceWorldAABBBuffer, m_pInstanceWorldOBBMatrixBuffer};
+	const UINT64 elementSizesInBytes[numBuffers] = {sizeof(AffineTransform), sizeof(AxisAlignedBox), sizeof(AffineTransform)};
+	const UINT64 uploadDataOffsets[numBuffers] = {worldMatrixDataOffset, worldAABBDataOffset, worldOBBMatrixDataOffset};
+
+	ResourceTransitionBarrier copyDestBarriers[numBuffers];
+	ResourceTransitionBarrier shaderResourceBarriers[numBuffers];
+	for (u32 bufferIndex = 0; bufferIndex < numBuffers; ++bufferIndex)
+	{
+		copyDestBarriers[bufferIndex] = ResourceTransitionBarrier(destBuffers[bufferIndex],
+			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+		shaderResourceBarriers[bufferIndex] = ResourceTransitionBarrier(destBuffers[bufferIndex],
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	}
+
+	pCommandList->ResourceBarrier(numBuffers, copyDestBarriers);
+	for (u32 bufferIndex = 0; bufferIndex < numBuffers; ++bufferIndex)
+	{
+		const UINT64 elementSizeInBytes = elementSizesInBytes[bufferIndex];
+		UINT64 uploadDataOffset = uploadBufferOffset + uploadDataOffsets[bufferIndex];
+
+		for (const MeshBatch::MeshInstanceRange& instanceRange : instanceRanges)
+		{
+			const UINT64 destOffset = (m_MeshTypeInstanceOffsets[meshType] + instanceRange.m_FirstInstance) * elementSizeInBytes;
+			const UINT64 numBytesToCopy = instanceRange.m_NumInstances * elementSizeInBytes;
+
+			pCommandList->CopyBufferRegion(destBuffers[bufferIndex], destOffset, pUploadRing->GetBuffer(), uploadDataOffset, numBytesToCopy);
+			uploadDataOffset += numBytesToCopy;
+		}
+	}
+	pCommandList->ResourceBarrier(numBuffers, shaderResourceBarriers);
+}
+
+void MeshRenderResources::InitPerMeshTypeResources(RenderEnv* pRenderEnv, u32 numMeshTypes, MeshBatch** ppFirstMeshType, const u64* pGeometryBudgetInBytes)
 {
 	m_MeshTypeOffsets.resize(numMeshTypes);
 	m_VertexStrideInBytes.resize(numMeshTypes);
+	m_PositionVertexStrideInBytes.resize(numMeshTypes);
+	m_IndexStrideInBytes.resize(numMeshTypes);
+	m_VertexCapacities.resize(numMeshTypes);
+	m_IndexCapacities.resize(numMeshTypes);
+	m_VertexFormatFlags.resize(numMeshTypes);
+	m_VertexCompressionFlags.resize(numMeshTypes);
 	m_InputElements.resize(numMeshTypes);
 	m_InputLayouts.resize(numMeshTypes);
+	m_PositionInputElements.resize(numMeshTypes);
+	m_PositionInputLayouts.resize(numMeshTypes);
 	m_PrimitiveTopologyTypes.resize(numMeshTypes);
 	m_PrimitiveTopologies.resize(numMeshTypes);
 	m_VertexBuffers.resize(numMeshTypes);
+	m_PositionVertexBuffers.resize(numMeshTypes);
 	m_IndexBuffers.resize(numMeshTypes);
 
+	// The quantization ranges are needed to encode the vertices, so they are gathered before the vertex buffers are created.
+	// They are only calculated when the mesh batch has compressed positions or texture coordinates.
+	m_MeshVertexQuantizations.clear();
+	for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
+	{
+		const MeshBatch* pMeshBatch = ppFirstMeshType[meshType];
+		m_MeshTypeOffsets[meshType] = (u32)m_MeshVertexQuantizations.size();
+
+		if ((pMeshBatch->GetVertexCompressionFlags() & (VertexCompressionFlag_Position | VertexCompressionFlag_TexCoords)) != 0)
+		{
+			const VertexQuantization* pFirstQuantization = pMeshBatch->GetMeshVertexQuantizations();
+			m_MeshVertexQuantizations.insert(m_MeshVertexQuantizations.end(), pFirstQuantization, pFirstQuantization + pMeshBatch->GetNumMeshes());
+		}
+		else
+		{
+			m_MeshVertexQuantizations.resize(m_MeshVertexQuantizations.size() + pMeshBatch->GetNumMeshes());
+		}
+	}
+
 	for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
 	{
 		const MeshBatch* pMeshBatch = ppFirstMeshType[meshType];
 
 		m_PrimitiveTopologyTypes[meshType] = pMeshBatch->GetPrimitiveTopologyType();
 		m_PrimitiveTopologies[meshType] = pMeshBatch->GetPrimitiveTopology();
+		m_VertexFormatFlags[meshType] = pMeshBatch->GetVertexFormatFlags();
+		m_VertexCompressionFlags[meshType] = pMeshBatch->GetVertexCompressionFlags();
+		m_IndexStrideInBytes[meshType] = (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT) ? sizeof(u16) : sizeof(u32);
+
+		m_VertexCapacities[meshType] = pMeshBatch->GetNumVertices();
+		m_IndexCapacities[meshType] = pMeshBatch->GetNumIndices();
 
 		InitInputLayout(pRenderEnv, meshType, pMeshBatch);
-		InitVertexBuffer(pRenderEnv, meshType, pMeshBatch);
-		InitIndexBuffer(pRenderEnv, meshType, pMeshBatch);
+		if (pGeometryBudgetInBytes == nullptr)
+		{
+			InitVertexBuffer(pRenderEnv, meshType, pMeshBatch);
+			InitIndexBuffer(pRenderEnv, meshType, pMeshBatch);
+		}
+	}
+
+	if (pGeometryBudgetInBytes != nullptr)
+	{
+		// The budget is split between the mesh types, and between the vertex and index buffers of each mesh type,
+		// in proportion to the size of their full geometry. The capacity never exceeds the full geometry.
+		u64 totalSizeInBytes = 0;
+		for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
+		{
+			totalSizeInBytes += u64(m_VertexCapacities[meshType]) * (m_VertexStrideInBytes[meshType] + m_PositionVertexStrideInBytes[meshType]);
+			totalSizeInBytes += u64(m_IndexCapacities[meshType]) * m_IndexStrideInBytes[meshType];
+		}
+
+		const f64 budgetScale = std::min(f64(*pGeometryBudgetInBytes) / f64(totalSizeInBytes), 1.0);
+		for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
+		{
+			m_VertexCapacities[meshType] = Max(1u, u32(budgetScale * m_VertexCapacities[meshType]));
+			m_IndexCapacities[meshType] = Max(1u, u32(budgetScale * m_IndexCapacities[meshType]));
+			
+			InitEmptyGeometryBuffers(pRenderEnv, meshType, ppFirstMeshType[meshType]);
+		}
 	}
 }
 
 void MeshRenderResources::InitInputLayout(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch)
 {
 	const u8 vertexFormatFlags = pMeshBatch->GetVertexFormatFlags();
+	const u8 compressionFlags = pMeshBatch->GetVertexCompressionFlags();
 
 	assert(m_InputElements[meshType].empty());
 	m_InputElements[meshType].reserve(5);
@@ -194,14 +365,20 @@ void MeshRenderResources::InitInputLayout(RenderEnv* pRenderEnv, u32 meshType, c
 	u32 byteOffset = 0;
 	assert((vertexFormatFlags & VertexData::FormatFlag_Position) != 0);
 	{
-		const DXGI_FORMAT format = DXGI_FORMAT_R32G32B32_FLOAT;
+		const DXGI_FORMAT format = ((compressionFlags & VertexCompressionFlag_Position) != 0) ?
+			DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 		m_InputElements[meshType].emplace_back("POSITION", 0, format, 0, byteOffset);
 
+		assert(m_PositionInputElements[meshType].empty());
+		m_PositionInputElements[meshType].emplace_back("POSITION", 0, format, 0, 0);
+		m_PositionVertexStrideInBytes[meshType] = GetSizeInBytes(format);
+
 		byteOffset += GetSizeInBytes(format);
 	}
 	if ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
 	{
-		const DXGI_FORMAT format = DXGI_FORMAT_R32G32B32_FLOAT;
+		const DXGI_FORMAT format = ((compressionFlags & VertexCompressionFlag_Normal) != 0) ?
+			DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 		m_InputElements[meshType].emplace_back("NORMAL", 0, format, 0, byteOffset);
 
 		byteOffset += GetSizeInBytes(format);
@@ -215,14 +392,16 @@ void MeshRenderResources::InitInputLayout(RenderEnv* pRenderEnv, u32 meshType, c
 	}
 	if ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
 	{
-		const DXGI_FORMAT format = DXGI_FORMAT_R32G32B32_FLOAT;
+		const DXGI_FORMAT format = ((compressionFlags & VertexCompressionFlag_Tangent) != 0) ?
+			DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 		m_InputElements[meshType].emplace_back("TANGENT", 0, format, 0, byteOffset);
 
 		byteOffset += GetSizeInBytes(format);
 	}
 	if ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
 	{
-		const DXGI_FORMAT format = DXGI_FORMAT_R32G32_FLOAT;
+		const DXGI_FORMAT format = ((compressionFlags & VertexCompressionFlag_TexCoords) != 0) ?
+			DXGI_FORMAT_R16G16_UNORM : DXGI_FORMAT_R32G32_FLOAT;
 		m_InputElements[meshType].emplace_back("TEXCOORD", 0, format, 0, byteOffset);
 
 		byteOffset += GetSizeInBytes(format);
@@ -230,78 +409,151 @@ void MeshRenderResources::InitInputLayout(RenderEnv* pRenderEnv, u32 meshType, c
 
 	m_VertexStrideInBytes[meshType] = byteOffset;
 	m_InputLayouts[meshType] = InputLayoutDesc((UINT)m_InputElements[meshType].size(), m_InputElements[meshType].data());
+	m_PositionInputLayouts[meshType] = InputLayoutDesc((UINT)m_PositionInputElements[meshType].size(), m_PositionInputElements[meshType].data());
 }
 
 void MeshRenderResources::InitVertexBuffer(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch)
 {
 	const u32 numVertices = pMeshBatch->GetNumVertices();
 	const u8 vertexFormatFlags = pMeshBatch->GetVertexFormatFlags();
+	const u32 vertexStrideInBytes = m_VertexStrideInBytes[meshType];
+	const u32 positionStrideInBytes = m_PositionVertexStrideInBytes[meshType];
 
-	assert(m_VertexStrideInBytes[meshType] > 0);
-	const u32 sizeInBytes = numVertices * m_VertexStrideInBytes[meshType];
+	assert(vertexStrideInBytes > 0);
+	const u32 sizeInBytes = numVertices * vertexStrideInBytes;
+	const u32 positionSizeInBytes = numVertices * positionStrideInBytes;
 
-	u8* pVertexData = new u8[sizeInBytes];
-	u32 vertexOffset = 0;
+	u8* pPositionData = new u8[positionSizeInBytes];
 
-	assert((vertexFormatFlags & VertexData::FormatFlag_Position) != 0);
+	StructuredBufferDesc bufferDesc(numVertices, vertexStrideInBytes, false, false, true);
+	m_VertexBuffers[meshType] = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &bufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, L"MeshRenderResources::m_pVertexBuffer");
+	
+	// Vertex attributes are interleaved directly into the upload buffer.
+	// Every mesh is encoded separately as it has its own quantization ranges.
+	auto encodeVertexData = [&](void* pUploadData)
 	{
-		const Vector3f* pPositions = pMeshBatch->GetPositions();
-		const u32 elementSizeInBytes = sizeof(pPositions[0]);
+		const MeshInfo* pFirstMeshInfo = pMeshBatch->GetMeshInfos();
+		for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+		{
+			const MeshInfo& meshInfo = pFirstMeshInfo[meshIndex];
+			const u32 firstVertex = meshInfo.m_BaseVertexLocation;
+
+			MeshVertexStreams streams;
+			streams.m_pPositions = pMeshBatch->GetPositions() + firstVertex;
+			if ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
+				streams.m_pNormals = pMeshBatch->GetNormals() + firstVertex;
+			if ((vertexFormatFlags & VertexData::FormatFlag_Color) != 0)
+				streams.m_pColors = pMeshBatch->GetColors() + firstVertex;
+			if ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
+				streams.m_pTangents = pMeshBatch->GetTangents() + firstVertex;
+			if ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
+				streams.m_pTexCoords = pMeshBatch->GetTexCoords() + firstVertex;
+
+			EncodeVertices(meshType, meshIndex, meshInfo.m_VertexCount, streams,
+				(u8*)pUploadData + firstVertex * vertexStrideInBytes, pPositionData + firstVertex * positionStrideInBytes);
+		}
+	};
+	UploadDataInPlace(pRenderEnv, m_VertexBuffers[meshType], bufferDesc,
+		D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, sizeInBytes, encodeVertexData);
 
-		for (u32 index = 0; index < numVertices; ++index)
-			std::memcpy(pVertexData + index * m_VertexStrideInBytes[meshType] + vertexOffset, &pPositions[index], elementSizeInBytes);
+	StructuredBufferDesc positionBufferDesc(numVertices, positionStrideInBytes, false, false, true);
+	m_PositionVertexBuffers[meshType] = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &positionBufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, L"MeshRenderResources::m_pPositionVertexBuffer");
 
-		vertexOffset += elementSizeInBytes;
+	UploadData(pRenderEnv, m_PositionVertexBuffers[meshType], positionBufferDesc,
+		D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, pPositionData, positionSizeInBytes);
+	
+	SafeArrayDelete(pPositionData);
+}
+
+void MeshRenderResources::EncodeVertices(u32 meshType, u32 meshIndex, u32 numVertices, const MeshVertexStreams& streams, u8* pVertexData, u8* pPositionData) const
+{
+	const VertexQuantization& quantization = m_MeshVertexQuantizations[m_MeshTypeOffsets[meshType] + meshIndex];
+	const u8 vertexFormatFlags = m_VertexFormatFlags[meshType];
+	const u8 compressionFlags = m_VertexCompressionFlags[meshType];
+	const u32 vertexStrideInBytes = m_VertexStrideInBytes[meshType];
+	const u32 positionStrideInBytes = m_PositionVertexStrideInBytes[meshType];
+
+	// Positions are encoded once and written both to the interleaved vertex data and to the position only vertex data.
+	assert((vertexFormatFlags & VertexData::FormatFlag_Position) != 0);
+	{
+		if ((compressionFlags & VertexCompressionFlag_Position) != 0)
+		{
+			assert(positionStrideInBytes == 4 * sizeof(u16));
+			QuantizePositions(numVertices, streams.m_pPositions, quantization, (u16*)pPositionData);
+		}
+		else
+		{
+			assert(positionStrideInBytes == sizeof(streams.m_pPositions[0]));
+			std::memcpy(pPositionData, streams.m_pPositions, numVertices * positionStrideInBytes);
+		}
 	}
+
+	u32 vertexOffset = 0;
+
+	CopyVertexElements(numVertices, pPositionData, positionStrideInBytes, vertexStrideInBytes, vertexOffset, pVertexData);
+	vertexOffset += positionStrideInBytes;
+
 	if ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
 	{
-		const Vector3f* pNormals = pMeshBatch->GetNormals();
-		const u32 elementSizeInBytes = sizeof(pNormals[0]);
-
-		for (u32 index = 0; index < numVertices; ++index)
-			std::memcpy(pVertexData + index * m_VertexStrideInBytes[meshType] + vertexOffset, &pNormals[index], elementSizeInBytes);
+		const Vector3f* pNormals = streams.m_pNormals;
+		if ((compressionFlags & VertexCompressionFlag_Normal) != 0)
+		{
+			std::vector<i16> encodedNormals(2 * numVertices);
+			EncodeOctahedralUnitVectors(numVertices, pNormals, encodedNormals.data());
 
-		vertexOffset += elementSizeInBytes;
+			CopyVertexElements(numVertices, encodedNormals.data(), 2 * sizeof(i16), vertexStrideInBytes, vertexOffset, pVertexData);
+			vertexOffset += 2 * sizeof(i16);
+		}
+		else
+		{
+			CopyVertexElements(numVertices, pNormals, sizeof(pNormals[0]), vertexStrideInBytes, vertexOffset, pVertexData);
+			vertexOffset += sizeof(pNormals[0]);
+		}
 	}
 	if ((vertexFormatFlags & VertexData::FormatFlag_Color) != 0)
 	{
-		const Vector4f* pColors = pMeshBatch->GetColors();
-		const u32 elementSizeInBytes = sizeof(pColors[0]);
-
-		for (u32 index = 0; index < numVertices; ++index)
-			std::memcpy(pVertexData + index * m_VertexStrideInBytes[meshType] + vertexOffset, &pColors[index], elementSizeInBytes);
+		const Vector4f* pColors = streams.m_pColors;
 
-		vertexOffset += elementSizeInBytes;
+		CopyVertexElements(numVertices, pColors, sizeof(pColors[0]), vertexStrideInBytes, vertexOffset, pVertexData);
+		vertexOffset += sizeof(pColors[0]);
 	}
 	if ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
 	{
-		const Vector3f* pTangents = pMeshBatch->GetTangents();
-		const u32 elementSizeInBytes = sizeof(pTangents[0]);
-
-		for (u32 index = 0; index < numVertices; ++index)
-			std::memcpy(pVertexData + index * m_VertexStrideInBytes[meshType] + vertexOffset, &pTangents[index], elementSizeInBytes);
+		const Vector3f* pTangents = streams.m_pTangents;
+		if ((compressionFlags & VertexCompressionFlag_Tangent) != 0)
+		{
+			std::vector<i16> encodedTangents(2 * numVertices);
+			EncodeOctahedralUnitVectors(numVertices, pTangents, encodedTangents.data());
 
-		vertexOffset += elementSizeInBytes;
+			CopyVertexElements(numVertices, encodedTangents.data(), 2 * sizeof(i16), vertexStrideInBytes, vertexOffset, pVertexData);
+			vertexOffset += 2 * sizeof(i16);
+		}
+		else
+		{
+			CopyVertexElements(numVertices, pTangents, sizeof(pTangents[0]), vertexStrideInBytes, vertexOffset, pVertexData);
+			vertexOffset += sizeof(pTangents[0]);
+		}
 	}
 	if ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
 	{
-		const Vector2f* pTexCoords = pMeshBatch->GetTexCoords();
-		const u32 elementSizeInBytes = sizeof(pTexCoords[0]);
-
-		for (u32 index = 0; index < numVertices; ++index)
-			std::memcpy(pVertexData + index * m_VertexStrideInBytes[meshType] + vertexOffset, &pTexCoords[index], elementSizeInBytes);
+		const Vector2f* pTexCoords = streams.m_pTexCoords;
+		if ((compressionFlags & VertexCompressionFlag_TexCoords) != 0)
+		{
+			std::vector<u16> encodedTexCoords(2 * numVertices);
+			QuantizeTexCoords(numVertices, pTexCoords, quantization, encodedTexCoords.data());
 
-		vertexOffset += elementSizeInBytes;
+			CopyVertexElements(numVertices, encodedTexCoords.data(), 2 * sizeof(u16), vertexStrideInBytes, vertexOffset, pVertexData);
+			vertexOffset += 2 * sizeof(u16);
+		}
+		else
+		{
+			CopyVertexElements(numVertices, pTexCoords, sizeof(pTexCoords[0]), vertexStrideInBytes, vertexOffset, pVertexData);
+			vertexOffset += sizeof(pTexCoords[0]);
+		}
 	}
-
-	StructuredBufferDesc bufferDesc(numVertices, m_VertexStrideInBytes[meshType], false, false, true);
-	m_VertexBuffers[meshType] = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &bufferDesc,
-		D3D12_RESOURCE_STATE_COPY_DEST, L"MeshRenderResources::m_pVertexBuffer");
-	
-	UploadData(pRenderEnv, m_VertexBuffers[meshType], bufferDesc,
-		D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, pVertexData, sizeInBytes);
-	
-	SafeArrayDelete(pVertexData);
+	assert(vertexOffset == vertexStrideInBytes);
 }
 
 void MeshRenderResources::InitIndexBuffer(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch)
@@ -330,6 +582,149 @@ void MeshRenderResources::InitIndexBuffer(RenderEnv* pRenderEnv, u32 meshType, c
 		D3D12_RESOURCE_STATE_INDEX_BUFFER, pIndexData, sizeInBytes);
 }
 
+void MeshRenderResources::InitEmptyGeometryBuffers(RenderEnv* pRenderEnv, u32 meshType, const MeshBatch* pMeshBatch)
+{
+	const u32 vertexCapacity = m_VertexCapacities[meshType];
+	const u32 indexCapacity = m_IndexCapacities[meshType];
+
+	// The buffers are created in the states the passes expect, as UpdateStreamedMeshes transitions them to copy dest and back.
+	StructuredBufferDesc vertexBufferDesc(vertexCapacity, m_VertexStrideInBytes[meshType], false, false, true);
+	m_VertexBuffers[meshType] = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &vertexBufferDesc,
+		D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, L"MeshRenderResources::m_pVertexBuffer");
+
+	StructuredBufferDesc positionBufferDesc(vertexCapacity, m_PositionVertexStrideInBytes[meshType], false, false, true);
+	m_PositionVertexBuffers[meshType] = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &positionBufferDesc,
+		D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, L"MeshRenderResources::m_pPositionVertexBuffer");
+
+	FormattedBufferDesc indexBufferDesc(indexCapacity, pMeshBatch->GetIndexFormat(), false, false, true);
+	m_IndexBuffers[meshType] = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &indexBufferDesc,
+		D3D12_RESOURCE_STATE_INDEX_BUFFER, L"MeshRenderResources::m_pIndexBuffer");
+}
+
+void MeshRenderResources::UpdateStreamedMeshes(CommandList* pCommandList, UploadRingBuffer* pUploadRing, const std::vector<MeshGeometryUpload>& geometryUploads,
+	const std::vector<MeshRenderInfoUpdate>& meshInfoUpdates)
+{
+	if (geometryUploads.empty() && meshInfoUpdates.empty())
+		return;
+
+	// The upload buffer stores vertex, position and index data of each geometry upload one after another, followed by the mesh infos.
+	// Offsets are kept 4-byte aligned for the 16-bit index data.
+	std::vector<UINT64> geometryDataOffsets(geometryUploads.size());
+
+	UINT64 numUploadBytes = 0;
+	for (std::size_t uploadIndex = 0; uploadIndex < geometryUploads.size(); ++uploadIndex)
+	{
+		const MeshGeometryUpload& upload = geometryUploads[uploadIndex];
+		geometryDataOffsets[uploadIndex] = numUploadBytes;
+
+		numUploadBytes += upload.m_NumVertices * (m_VertexStrideInBytes[upload.m_MeshType] + m_PositionVertexStrideInBytes[upload.m_MeshType]);
+		numUploadBytes += upload.m_NumIndices * m_IndexStrideInBytes[upload.m_MeshType];
+		numUploadBytes = (numUploadBytes + 3) & ~UINT64(3);
+	}
+	const UINT64 meshInfoDataOffset = numUploadBytes;
+	numUploadBytes += meshInfoUpdates.size() * sizeof(MeshRenderInfo);
+
+	UINT64 uploadBufferOffset = 0;
+	u8* pUploadData = pUploadRing->Allocate(numUploadBytes, sizeof(u32), &uploadBufferOffset);
+	assert(pUploadData != nullptr && "The upload ring should have room for the chunk uploads of all frames in flight");
+
+	for (std::size_t uploadIndex = 0; uploadIndex < geometryUploads.size(); ++uploadIndex)
+	{
+		const MeshGeometryUpload& upload = geometryUploads[uploadIndex];
+		const u32 vertexSizeInBytes = upload.m_NumVertices * m_VertexStrideInBytes[upload.m_MeshType];
+		const u32 positionSizeInBytes = upload.m_NumVertices * m_PositionVertexStrideInBytes[upload.m_MeshType];
+		const u32 indexSizeInBytes = upload.m_NumIndices * m_IndexStrideInBytes[upload.m_MeshType];
+
+		u8* pGeometryData = pUploadData + geometryDataOffsets[uploadIndex];
+		std::memcpy(pGeometryData, upload.m_pVertexData, vertexSizeInBytes);
+		std::memcpy(pGeometryData + vertexSizeInBytes, upload.m_pPositionData, positionSizeInBytes);
+		std::memcpy(pGeometryData + vertexSizeInBytes + positionSizeInBytes, upload.m_pIndexData, indexSizeInBytes);
+	}
+
+	MeshRenderInfo* pMeshInfoData = (MeshRenderInfo*)(pUploadData + meshInfoDataOffset);
+	for (const MeshRenderInfoUpdate& update : meshInfoUpdates)
+	{
+		MeshRenderInfo& meshInfo = m_MeshInfos[update.m_MeshIndex];
+		meshInfo.m_NumInstances = update.m_NumInstances;
+		meshInfo.m_StartIndexLocation = update.m_StartIndexLocation;
+		meshInfo.m_BaseVertexLocation = update.m_BaseVertexLocation;
+
+		*pMeshInfoData++ = meshInfo;
+	}
+
+	std::vector<ResourceTransitionBarrier> copyDestBarriers;
+	std::vector<ResourceTransitionBarrier> restoreStateBarriers;
+	
+	auto addBarriers = [&](Buffer* pBuffer, D3D12_RESOURCE_STATES state)
+	{
+		copyDestBarriers.emplace_back(pBuffer, state, D3D12_RESOURCE_STATE_COPY_DEST);
+		restoreStateBarriers.emplace_back(pBuffer, D3D12_RESOURCE_STATE_COPY_DEST, state);
+	};
+	if (!meshInfoUpdates.empty())
+		addBarriers(m_pMeshInfoBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	
+	for (u32 meshType = 0; meshType < m_NumMeshTypes; ++meshType)
+	{
+		auto hasMeshTypeUploads = [meshType](const MeshGeometryUpload& upload)
+		{
+			return (upload.m_MeshType == meshType);
+		};
+		if (std::any_of(geometryUploads.cbegin(), geometryUploads.cend(), hasMeshTypeUploads))
+		{
+			addBarriers(m_VertexBuffers[meshType], D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+			addBarriers(m_PositionVertexBuffers[meshType], D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+			addBarriers(m_IndexBuffers[meshType], D3D12_RESOURCE_STATE_INDEX_BUFFER);
+		}
+	}
+
+	Buffer* pUploadBuffer = pUploadRing->GetBuffer();
+
+	pCommandList->ResourceBarrier((UINT)copyDestBarriers.size(), copyDestBarriers.data());
+	for (std::size_t uploadIndex = 0; uploadIndex < geometryUploads.size(); ++uploadIndex)
+	{
+		const MeshGeometryUpload& upload = geometryUploads[uploadIndex];
+		const u32 vertexStrideInBytes = m_VertexStrideInBytes[upload.m_MeshType];
+		const u32 positionStrideInBytes = m_PositionVertexStrideInBytes[upload.m_MeshType];
+		const u32 indexStrideInBytes = m_IndexStrideInBytes[upload.m_MeshType];
+
+		UINT64 uploadDataOffset = uploadBufferOffset + geometryDataOffsets[uploadIndex];
+		pCommandList->CopyBufferRegion(m_VertexBuffers[upload.m_MeshType], UINT64(upload.m_FirstVertex) * vertexStrideInBytes,
+			pUploadBuffer, uploadDataOffset, UINT64(upload.m_NumVertices) * vertexStrideInBytes);
+		uploadDataOffset += UINT64(upload.m_NumVertices) * vertexStrideInBytes;
+
+		pCommandList->CopyBufferRegion(m_PositionVertexBuffers[upload.m_MeshType], UINT64(upload.m_FirstVertex) * positionStrideInBytes,
+			pUploadBuffer, uploadDataOffset, UINT64(upload.m_NumVertices) * positionStrideInBytes);
+		uploadDataOffset += UINT64(upload.m_NumVertices) * positionStrideInBytes;
+
+		pCommandList->CopyBufferRegion(m_IndexBuffers[upload.m_MeshType], UINT64(upload.m_FirstIndex) * indexStrideInBytes,
+			pUploadBuffer, uploadDataOffset, UINT64(upload.m_NumIndices) * indexStrideInBytes);
+	}
+	for (std::size_t updateIndex = 0; updateIndex < meshInfoUpdates.size(); ++updateIndex)
+	{
+		pCommandList->CopyBufferRegion(m_pMeshInfoBuffer, UINT64(meshInfoUpdates[updateIndex].m_MeshIndex) * sizeof(MeshRenderInfo),
+			pUploadBuffer, uploadBufferOffset + meshInfoDataOffset + updateIndex * sizeof(MeshRenderInfo), sizeof(MeshRenderInfo));
+	}
+	pCommandList->ResourceBarrier((UINT)restoreStateBarriers.size(), restoreStateBarriers.data());
+}
+
+VertexDecodingDefines::VertexDecodingDefines(const MeshRenderResources* pMeshRenderResources, u32 meshType)
+{
+	const u8 compressionFlags = pMeshRenderResources->GetVertexCompressionFlags(meshType);
+
+	// UNORM positions and texture coordinates are mapped to the mesh ranges with the instance vertex quantization buffer.
+	m_PositionUNORM16Str = std::to_wstring(((compressionFlags & VertexCompressionFlag_Position) != 0) ? 1 : 0);
+	m_NormalOctahedralStr = std::to_wstring(((compressionFlags & VertexCompressionFlag_Normal) != 0) ? 1 : 0);
+	m_TangentOctahedralStr = std::to_wstring(((compressionFlags & VertexCompressionFlag_Tangent) != 0) ? 1 : 0);
+	m_TexCoordUNORM16Str = std::to_wstring(((compressionFlags & VertexCompressionFlag_TexCoords) != 0) ? 1 : 0);
+	m_HasTexCoordsStr = std::to_wstring(((pMeshRenderResources->GetVertexFormatFlags(meshType) & VertexData::FormatFlag_TexCoords) != 0) ? 1 : 0);
+
+	m_Defines.emplace_back(L"POSITION_FORMAT_UNORM16", m_PositionUNORM16Str.c_str());
+	m_Defines.emplace_back(L"NORMAL_FORMAT_OCTAHEDRAL", m_NormalOctahedralStr.c_str());
+	m_Defines.emplace_back(L"TANGENT_FORMAT_OCTAHEDRAL", m_TangentOctahedralStr.c_str());
+	m_Defines.emplace_back(L"TEXCOORD_FORMAT_UNORM16", m_TexCoordUNORM16Str.c_str());
+	m_Defines.emplace_back(L"VERTEX_HAS_TEXCOORDS", m_HasTexCoordsStr.c_str());
+}
+
 namespace
 {
 	u32 CalcMaxNumInstancesPerMesh(u32 numMeshTypes, MeshBatch** ppFirstMeshType)
@@ -353,4 +748,11 @@ namespace
 
 		return (scalingMatrix * rotationMatrix * translationMatrix);
 	}
-}
+
+	void CopyVertexElements(u32 numVertices, const void* pElements, u32 elementSizeInBytes, u32 vertexStrideInBytes, u32 vertexOffset, u8* pVertexData)
+	{
+		const u8* pElementBytes = (const u8*)pElements;
+		for (u32 index = 0; index < numVertices; ++index)
+			std::memcpy(pVertexData + index * vertexStrideInBytes + vertexOffset, pElementBytes + index * elementSizeInBytes, elementSizeInBytes);
+	}
+}
\ No newline at end of file
@@ -35,21 +35,21 @@ RenderGBufferPass::RenderGBufferPass(InitParams* pParams)
 RenderGBufferPass::~RenderGBufferPass()
 {
 	SafeDelete(m_pRootSignature);
-	SafeDelete(m_pPipelineState);
+	for (PipelineState* pPipelineState : m_PipelineStates)
+		SafeDelete(pPipelineState);
 	SafeDelete(m_pCommandSignature);
 }
 
 void RenderGBufferPass::Record(RenderParams* pParams)
 {
 	MeshRenderResources* pMeshRenderResources = pParams->m_pMeshRenderResources;
-	assert(pMeshRenderResources->GetNumMeshTypes() == 1);
-	const u32 meshType = 0;
+	assert(pMeshRenderResources->GetNumMeshTypes() == m_PipelineStates.size());
 
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
 	CommandList* pCommandList = pParams->m_pCommandList;
 	GPUProfiler* pGPUProfiler = pRenderEnv->m_pGPUProfiler;
 		
-	pCommandList->Begin(m_pPipelineState);
+	pCommandList->Begin(m_PipelineStates[0]);
 #ifdef ENABLE_PROFILING
 	u32 profileIndex = pGPUProfiler->StartProfile(pCommandList, m_Name.c_str());
 #endif // ENABLE_PROFILING
@@ -78,17 +78,24 @@ void RenderGBufferPass::Record(RenderParams* pParams)
 	pCommandList->SetGraphicsRootConstantBufferView(kRootCBVParamVS, pParams->m_pAppDataBuffer);
 	pCommandList->SetGraphicsRootDescriptorTable(kRootSRVTableParamVS, m_SRVHeapStartVS);
 	
-	pCommandList->IASetPrimitiveTopology(pMeshRenderResources->GetPrimitiveTopology(meshType));
-	pCommandList->IASetVertexBuffers(0, 1, pMeshRenderResources->GetVertexBuffer(meshType)->GetVBView());
-	pCommandList->IASetIndexBuffer(pMeshRenderResources->GetIndexBuffer(meshType)->GetIBView());
-	
 	Rect scissorRect(ExtractRect(pParams->m_pViewport));
 	pCommandList->RSSetViewports(1, pParams->m_pViewport);
 	pCommandList->RSSetScissorRects(1, &scissorRect);
 	
-	pCommandList->ExecuteIndirect(m_pCommandSignature, pMeshRenderResources->GetTotalNumMeshes(),
-		pParams->m_pDrawCommandBuffer, pMeshRenderResources->GetMeshTypeOffset(meshType) * sizeof(DrawCommand),
-		pParams->m_pNumVisibleMeshesPerTypeBuffer, meshType * sizeof(u32));
+	// Draw commands of each mesh type start at the mesh type offset and their count is at the mesh type index.
+	for (u32 meshType = 0; meshType < pMeshRenderResources->GetNumMeshTypes(); ++meshType)
+	{
+		if (meshType > 0)
+			pCommandList->SetPipelineState(m_PipelineStates[meshType]);
+
+		pCommandList->IASetPrimitiveTopology(pMeshRenderResources->GetPrimitiveTopology(meshType));
+		pCommandList->IASetVertexBuffers(0, 1, pMeshRenderResources->GetVertexBuffer(meshType)->GetVBView());
+		pCommandList->IASetIndexBuffer(pMeshRenderResources->GetIndexBuffer(meshType)->GetIBView());
+
+		pCommandList->ExecuteIndirect(m_pCommandSignature, pMeshRenderResources->GetNumMeshes(meshType),
+			pParams->m_pDrawCommandBuffer, pMeshRenderResources->GetMeshTypeOffset(meshType) * sizeof(DrawCommand),
+			pParams->m_pNumVisibleMeshesPerTypeBuffer, meshType * sizeof(u32));
+	}
 	
 #ifdef ENABLE_PROFILING
 	pGPUProfiler->EndProfile(pCommandList, profileIndex);
@@ -99,9 +106,6 @@ void RenderGBufferPass::Record(RenderParams* pParams)
 void RenderGBufferPass::InitResources(InitParams* pParams)
 {
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
-
-	const MeshRenderResources* pMeshRenderResources = pParams->m_pMeshRenderResources;
-	assert(pMeshRenderResources->GetNumMeshTypes() == 1);
 			
 	m_OutputResourceStates.m_GBuffer1State = D3D12_RESOURCE_STATE_RENDER_TARGET;
 	m_OutputResourceStates.m_GBuffer2State = D3D12_RESOURCE_STATE_RENDER_TARGET;
@@ -157,6 +161,10 @@ void RenderGBufferPass::InitResources(InitParams* pParams)
 	pRenderEnv->m_pDevice->CopyDescriptor(pRenderEnv->m_pShaderVisibleSRVHeap->Allocate(),
 		pParams->m_pInstanceWorldMatrixBuffer->GetSRVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+	// Stays in the shader resource state for the lifetime of the mesh render resources.
+	pRenderEnv->m_pDevice->CopyDescriptor(pRenderEnv->m_pShaderVisibleSRVHeap->Allocate(),
+		pParams->m_pMeshRenderResources->GetInstanceVertexQuantizationBuffer()->GetSRVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
 	m_RTVHeapStart = pRenderEnv->m_pShaderInvisibleRTVHeap->Allocate();
 	pRenderEnv->m_pDevice->CopyDescriptor(m_RTVHeapStart,
 		pParams->m_pGBuffer1->GetRTVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
@@ -181,7 +189,7 @@ void RenderGBufferPass::InitRootSignature(InitParams* pParams)
 	rootParams[kRoot32BitConstantParamVS] = Root32BitConstantsParameter(0, D3D12_SHADER_VISIBILITY_VERTEX, 1);
 	rootParams[kRootCBVParamVS] = RootCBVParameter(1, D3D12_SHADER_VISIBILITY_VERTEX);
 
-	D3D12_DESCRIPTOR_RANGE descriptorRangesVS[] = {SRVDescriptorRange(2, 0)};
+	D3D12_DESCRIPTOR_RANGE descriptorRangesVS[] = {SRVDescriptorRange(3, 0)};
 	rootParams[kRootSRVTableParamVS] = RootDescriptorTableParameter(ARRAYSIZE(descriptorRangesVS), descriptorRangesVS, D3D12_SHADER_VISIBILITY_VERTEX);
 
 	rootParams[kRoot32BitConstantParamPS] = Root32BitConstantsParameter(0, D3D12_SHADER_VISIBILITY_PIXEL, 1);
@@ -193,31 +201,13 @@ void RenderGBufferPass::InitRootSignature(InitParams* pParams)
 void RenderGBufferPass::InitPipelineState(InitParams* pParams)
 {
 	assert(m_pRootSignature != nullptr);
-	assert(m_pPipelineState == nullptr);
+	assert(m_PipelineStates.empty());
 	
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
-	
 	const MeshRenderResources* pMeshRenderResources = pParams->m_pMeshRenderResources;
-	assert(pMeshRenderResources->GetNumMeshTypes() == 1);
-	const u32 meshType = 0;
 
-	Shader vertexShader(L"Shaders//RenderGBufferVS.hlsl", L"Main", L"vs_6_1");
 	Shader pixelShader(L"Shaders//RenderGBufferPS.hlsl", L"Main", L"ps_6_1");
-
-	const InputLayoutDesc& inputLayout = pMeshRenderResources->GetInputLayout(meshType);
-	assert(inputLayout.NumElements == 3);
-	assert(HasVertexSemantic(inputLayout, "POSITION"));
-	assert(HasVertexSemantic(inputLayout, "NORMAL"));
-	assert(HasVertexSemantic(inputLayout, "TEXCOORD"));
-
-	GraphicsPipelineStateDesc pipelineStateDesc;
-	pipelineStateDesc.SetRootSignature(m_pRootSignature);
-	pipelineStateDesc.SetVertexShader(&vertexShader);
-	pipelineStateDesc.SetPixelShader(&pixelShader);
-	pipelineStateDesc.InputLayout = inputLayout;
-	pipelineStateDesc.PrimitiveTopologyType = pMeshRenderResources->GetPrimitiveTopologyType(meshType);
-	pipelineStateDesc.DepthStencilState = DepthStencilDesc(DepthStencilDesc::Enabled);
-
+	
 	const DXGI_FORMAT rtvFormats[] =
 	{
 		GetRenderTargetViewFormat(pParams->m_pGBuffer1->GetFormat()),
@@ -226,9 +216,31 @@ void RenderGBufferPass::InitPipelineState(InitParams* pParams)
 		GetRenderTargetViewFormat(pParams->m_pGBuffer4->GetFormat())
 	};
 	const DXGI_FORMAT dsvFormat = GetDepthStencilViewFormat(pParams->m_pDepthTexture->GetFormat());
-	pipelineStateDesc.SetRenderTargetFormats(ARRAYSIZE(rtvFormats), rtvFormats, dsvFormat);
+
+	// The vertex shader is compiled for the vertex format of each mesh type.
+	// The pixel shader and the G-buffer layout are shared by all of them.
+	m_PipelineStates.resize(pMeshRenderResources->GetNumMeshTypes());
+	for (u32 meshType = 0; meshType < pMeshRenderResources->GetNumMeshTypes(); ++meshType)
+	{
+		const VertexDecodingDefines vertexDecodingDefines(pMeshRenderResources, meshType);
+		Shader vertexShader(L"Shaders//RenderGBufferVS.hlsl", L"Main", L"vs_6_1",
+			vertexDecodingDefines.GetDefines(), vertexDecodingDefines.GetNumDefines());
+
+		const InputLayoutDesc& inputLayout = pMeshRenderResources->GetInputLayout(meshType);
+		assert(HasVertexSemantic(inputLayout, "POSITION"));
+		assert(HasVertexSemantic(inputLayout, "NORMAL"));
+
+		GraphicsPipelineStateDesc pipelineStateDesc;
+		pipelineStateDesc.SetRootSignature(m_pRootSignature);
+		pipelineStateDesc.SetVertexShader(&vertexShader);
+		pipelineStateDesc.SetPixelShader(&pixelShader);
+		pipelineStateDesc.InputLayout = inputLayout;
+		pipelineStateDesc.PrimitiveTopologyType = pMeshRenderResources->GetPrimitiveTopologyType(meshType);
+		pipelineStateDesc.DepthStencilState = DepthStencilDesc(DepthStencilDesc::Enabled);
+		pipelineStateDesc.SetRenderTargetFormats(ARRAYSIZE(rtvFormats), rtvFormats, dsvFormat);
 	
-	m_pPipelineState = new PipelineState(pRenderEnv->m_pDevice, &pipelineStateDesc, L"RenderGBufferPass::m_pPipelineState");
+		m_PipelineStates[meshType] = new PipelineState(pRenderEnv->m_pDevice, &pipelineStateDesc, L"RenderGBufferPass::m_PipelineStates");
+	}
 }
 
 void RenderGBufferPass::InitCommandSignature(InitParams* pParams)
@@ -29,7 +29,8 @@ RenderSpotLightShadowMapPass::RenderSpotLightShadowMapPass(InitParams* pParams)
 RenderSpotLightShadowMapPass::~RenderSpotLightShadowMapPass()
 {
 	SafeDelete(m_pCommandSignature);
-	SafeDelete(m_pPipelineState);
+	for (PipelineState* pPipelineState : m_PipelineStates)
+		SafeDelete(pPipelineState);
 	SafeDelete(m_pRootSignature);
 }
 
@@ -40,47 +41,56 @@ void RenderSpotLightShadowMapPass::Record(RenderParams* pParams)
 
 	DepthTexture* pSpotLightShadowMaps = pParams->m_pSpotLightShadowMaps;
 	MeshRenderResources* pMeshRenderResources = pParams->m_pMeshRenderResources;
-	assert(pMeshRenderResources->GetNumMeshTypes() == 1);
-	const u32 meshType = 0;
+	assert(pMeshRenderResources->GetNumMeshTypes() == m_PipelineStates.size());
 
 	GPUProfiler* pGPUProfiler = pRenderEnv->m_pGPUProfiler;
 #ifdef ENABLE_PROFILING
 	u32 profileIndex = pGPUProfiler->StartProfile(pCommandList, "RenderSpotLightShadowMapPass");
 #endif // ENABLE_PROFILING
 
-	const ResourceTransitionBarrier resourceBarriers[] =
-	{
-		ResourceTransitionBarrier(pParams->m_pSpotLightShadowMaps,
-			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-			D3D12_RESOURCE_STATE_DEPTH_WRITE,
-			pParams->m_ShadowMapIndex)
-	};
-
-	pCommandList->SetPipelineState(m_pPipelineState);
 	pCommandList->SetGraphicsRootSignature(m_pRootSignature);
 	pCommandList->SetDescriptorHeaps(pRenderEnv->m_pShaderVisibleSRVHeap);
-	pCommandList->ResourceBarrier(ARRAYSIZE(resourceBarriers), resourceBarriers);
+
+	if (pParams->m_SpotLightShadowMapState != m_OutputResourceStates.m_SpotLightShadowMapsState)
+	{
+		const ResourceTransitionBarrier resourceBarrier(pParams->m_pSpotLightShadowMaps,
+			pParams->m_SpotLightShadowMapState,
+			m_OutputResourceStates.m_SpotLightShadowMapsState,
+			pParams->m_ShadowMapIndex);
+		pCommandList->ResourceBarrier(1, &resourceBarrier);
+	}
 	
 	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = pSpotLightShadowMaps->GetDSVHandle(0/*mipSlice*/, pParams->m_ShadowMapIndex);
 	pCommandList->OMSetRenderTargets(0, nullptr, TRUE, &dsvHandle);
-	pCommandList->ClearDepthView(dsvHandle, 1.0f);
+	if (pParams->m_ClearShadowMap)
+		pCommandList->ClearDepthView(dsvHandle, 1.0f);
 	
 	pCommandList->SetGraphicsRoot32BitConstant(kRoot32BitConstantsParamVS, pParams->m_SpotLightIndex, 0);
 	pCommandList->SetGraphicsRootDescriptorTable(kRootSRVTableParamVS, m_SRVHeapStartVS);
 	
-	pCommandList->IASetPrimitiveTopology(pMeshRenderResources->GetPrimitiveTopology(meshType));
-	pCommandList->IASetVertexBuffers(0, 1, pMeshRenderResources->GetVertexBuffer(meshType)->GetVBView());
-	pCommandList->IASetIndexBuffer(pMeshRenderResources->GetIndexBuffer(meshType)->GetIBView());
-	
-	Viewport viewport(0.0f/*topLeftX*/, 0.0f/*topLeftY*/, FLOAT(pSpotLightShadowMaps->GetWidth()), FLOAT(pSpotLightShadowMaps->GetHeight()));
+	// Shadow map is rendered into the top-left corner of the slice, matching the size of the light tile in the shadow map atlas.
+	assert((pParams->m_ShadowMapSize > 0) && (pParams->m_ShadowMapSize <= pSpotLightShadowMaps->GetWidth()));
+	Viewport viewport(0.0f/*topLeftX*/, 0.0f/*topLeftY*/, FLOAT(pParams->m_ShadowMapSize), FLOAT(pParams->m_ShadowMapSize));
 	Rect scissorRect(ExtractRect(&viewport));
 	
 	pCommandList->RSSetViewports(1, &viewport);
 	pCommandList->RSSetScissorRects(1, &scissorRect);
 	
-	pCommandList->ExecuteIndirect(m_pCommandSignature, pParams->m_NumRenderCommands,
-		pParams->m_pRenderCommandBuffer, pParams->m_FirstRenderCommand * sizeof(ShadowMapCommand),
-		nullptr/*pCountBuffer*/, 0/*countBufferOffset*/);
+	for (u32 meshType = 0; meshType < pMeshRenderResources->GetNumMeshTypes(); ++meshType)
+	{
+		const ShadowMapCommandRange& commandRange = pParams->m_pRenderCommandRanges[meshType];
+		if (commandRange.m_NumCommands == 0)
+			continue;
+
+		pCommandList->SetPipelineState(m_PipelineStates[meshType]);
+		pCommandList->IASetPrimitiveTopology(pMeshRenderResources->GetPrimitiveTopology(meshType));
+		pCommandList->IASetVertexBuffers(0, 1, pMeshRenderResources->GetPositionVertexBuffer(meshType)->GetVBView());
+		pCommandList->IASetIndexBuffer(pMeshRenderResources->GetIndexBuffer(meshType)->GetIBView());
+
+		pCommandList->ExecuteIndirect(m_pCommandSignature, commandRange.m_NumCommands,
+			pParams->m_pRenderCommandBuffer, commandRange.m_FirstCommand * sizeof(ShadowMapCommand),
+			nullptr/*pCountBuffer*/, 0/*countBufferOffset*/);
+	}
 
 #ifdef ENABLE_PROFILING
 	pGPUProfiler->EndProfile(pCommandList, profileIndex);
@@ -114,6 +124,10 @@ void RenderSpotLightShadowMapPass::InitResources(InitParams* pParams)
 
 	pRenderEnv->m_pDevice->CopyDescriptor(pRenderEnv->m_pShaderVisibleSRVHeap->Allocate(),
 		pParams->m_pSpotLightViewProjMatrixBuffer->GetSRVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	// Stays in the shader resource state for the lifetime of the mesh render resources.
+	pRenderEnv->m_pDevice->CopyDescriptor(pRenderEnv->m_pShaderVisibleSRVHeap->Allocate(),
+		pParams->m_pMeshRenderResources->GetInstanceVertexQuantizationBuffer()->GetSRVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 }
 
 void RenderSpotLightShadowMapPass::InitRootSignature(InitParams* pParams)
@@ -123,7 +137,7 @@ void RenderSpotLightShadowMapPass::InitRootSignature(InitParams* pParams)
 	D3D12_ROOT_PARAMETER rootParams[kNumRootParams];
 	rootParams[kRoot32BitConstantsParamVS] = Root32BitConstantsParameter(0, D3D12_SHADER_VISIBILITY_VERTEX, 2);
 
-	D3D12_DESCRIPTOR_RANGE descriptorRanges[] = {SRVDescriptorRange(3, 0)};
+	D3D12_DESCRIPTOR_RANGE descriptorRanges[] = {SRVDescriptorRange(4, 0)};
 	rootParams[kRootSRVTableParamVS] = RootDescriptorTableParameter(ARRAYSIZE(descriptorRanges), descriptorRanges, D3D12_SHADER_VISIBILITY_VERTEX);
 
 	RootSignatureDesc rootSignatureDesc(kNumRootParams, rootParams, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
@@ -132,32 +146,33 @@ void RenderSpotLightShadowMapPass::InitRootSignature(InitParams* pParams)
 
 void RenderSpotLightShadowMapPass::InitPipelineState(InitParams* pParams)
 {
-	assert(m_pPipelineState == nullptr);
+	assert(m_PipelineStates.empty());
 	assert(m_pRootSignature != nullptr);
 
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
-	
 	const MeshRenderResources* pMeshRenderResources = pParams->m_pMeshRenderResources;
-	assert(pMeshRenderResources->GetNumMeshTypes() == 1);
-	const u32 meshType = 0;
 	
-	const InputLayoutDesc& inputLayout = pMeshRenderResources->GetInputLayout(meshType);
-	assert(inputLayout.NumElements == 3);
-	assert(HasVertexSemantic(inputLayout, "POSITION"));
-	assert(HasVertexSemantic(inputLayout, "NORMAL"));
-	assert(HasVertexSemantic(inputLayout, "TEXCOORD"));
+	m_PipelineStates.resize(pMeshRenderResources->GetNumMeshTypes());
+	for (u32 meshType = 0; meshType < pMeshRenderResources->GetNumMeshTypes(); ++meshType)
+	{
+		const InputLayoutDesc& inputLayout = pMeshRenderResources->GetPositionInputLayout(meshType);
+		assert(inputLayout.NumElements == 1);
+		assert(HasVertexSemantic(inputLayout, "POSITION"));
 
-	Shader vertexShader(L"Shaders//RenderSpotLightShadowMapVS.hlsl", L"Main", L"vs_6_1");
+		const VertexDecodingDefines vertexDecodingDefines(pMeshRenderResources, meshType);
+		Shader vertexShader(L"Shaders//RenderSpotLightShadowMapVS.hlsl", L"Main", L"vs_6_1",
+			vertexDecodingDefines.GetDefines(), vertexDecodingDefines.GetNumDefines());
 	
-	GraphicsPipelineStateDesc pipelineStateDesc;
-	pipelineStateDesc.SetRootSignature(m_pRootSignature);
-	pipelineStateDesc.SetVertexShader(&vertexShader);
-	pipelineStateDesc.InputLayout = inputLayout;
-	pipelineStateDesc.PrimitiveTopologyType = pMeshRenderResources->GetPrimitiveTopologyType(meshType);
-	pipelineStateDesc.DepthStencilState = DepthStencilDesc(DepthStencilDesc::Enabled);
-	pipelineStateDesc.SetRenderTargetFormats(0, nullptr, GetDepthStencilViewFormat(pParams->m_pSpotLightShadowMaps->GetFormat()));
+		GraphicsPipelineStateDesc pipelineStateDesc;
+		pipelineStateDesc.SetRootSignature(m_pRootSignature);
+		pipelineStateDesc.SetVertexShader(&vertexShader);
+		pipelineStateDesc.InputLayout = inputLayout;
+		pipelineStateDesc.PrimitiveTopologyType = pMeshRenderResources->GetPrimitiveTopologyType(meshType);
+		pipelineStateDesc.DepthStencilState = DepthStencilDesc(DepthStencilDesc::Enabled);
+		pipelineStateDesc.SetRenderTargetFormats(0, nullptr, GetDepthStencilViewFormat(pParams->m_pSpotLightShadowMaps->GetFormat()));
 	
-	m_pPipelineState = new PipelineState(pRenderEnv->m_pDevice, &pipelineStateDesc, L"RenderSpotLightShadowMapPass::m_pPipelineState");
+		m_PipelineStates[meshType] = new PipelineState(pRenderEnv->m_pDevice, &pipelineStateDesc, L"RenderSpotLightShadowMapPass::m_PipelineStates");
+	}
 }
 
 void RenderSpotLightShadowMapPass::InitCommandSignature(InitParams* pParams)
@@ -0,0 +1,549 @@
+#include "RenderPasses/SceneStreamer.h"
+#include "RenderPasses/MeshRenderResources.h"
+#include "D3DWrapper/Fence.h"
+#include "D3DWrapper/RenderEnv.h"
+#include "Scene/Scene.h"
+
+namespace
+{
+	const u32 kInvalidChunkIndex = ~0u;
+
+	f32 CalcDistanceToBox(const Vector3f& point, const AxisAlignedBox& box);
+	SceneChunkFile* OpenChunkFile(const wchar_t* pChunkFilePath, Scene* pScene, const std::vector<SceneChunk>& chunks);
+}
+
+SceneStreamer::SceneStreamer(RenderEnv* pRenderEnv, Scene* pScene, const wchar_t* pChunkFilePath, const SceneStreamingParams& params)
+	: m_Params(params)
+	, m_pScene(pScene)
+	, m_pMeshRenderResources(nullptr)
+	, m_pChunkFile(nullptr)
+	, m_NumResidentChunks(0)
+	, m_ResidentSizeInBytes(0)
+	, m_LoadingSizeInBytes(0)
+	, m_ExitWorkerThread(false)
+{
+	BuildSceneChunks(pScene, params.m_ChunkSize, &m_Chunks);
+
+	const u32 numMeshTypes = pScene->GetNumMeshBatches();
+	m_ChunkStates.resize(m_Chunks.size());
+	m_MaterialRefCounts.resize(pScene->GetNumMaterials(), 0);
+
+	m_pChunkFile = OpenChunkFile(pChunkFilePath, pScene, m_Chunks);
+	if (m_pChunkFile == nullptr)
+	{
+		// Without the chunk file there is nothing to stream from, so the geometry is uploaded in full and the worker thread is not started.
+		for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
+		{
+			MeshBatch* pMeshBatch = pScene->GetMeshBatches()[meshType];
+			if (!pMeshBatch->IsGeometryResident())
+			{
+				const bool geometryRead = pMeshBatch->MaterializeGeometry();
+				assert(geometryRead);
+			}
+		}
+		m_pMeshRenderResources = new MeshRenderResources(pRenderEnv, numMeshTypes, pScene->GetMeshBatches());
+
+		InitChunkSizes();
+		MakeAllChunksResident();
+		return;
+	}
+
+	m_pMeshRenderResources = new MeshRenderResources(pRenderEnv, numMeshTypes, pScene->GetMeshBatches(), params.m_GPUMemoryBudgetInBytes);
+
+	// Batches without a geometry source keep their streams.
+	if (params.m_ReleaseMeshBatchGeometry)
+	{
+		for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
+			pScene->GetMeshBatches()[meshType]->ReleaseGeometry();
+	}
+
+	m_VertexAllocators.reserve(numMeshTypes);
+	m_IndexAllocators.reserve(numMeshTypes);
+	for (u32 meshType = 0; meshType < numMeshTypes; ++meshType)
+	{
+		m_VertexAllocators.emplace_back(m_pMeshRenderResources->GetVertexCapacity(meshType));
+		m_IndexAllocators.emplace_back(m_pMeshRenderResources->GetIndexCapacity(meshType));
+	}
+
+	InitChunkSizes();
+
+	m_WorkerThread = std::thread(&SceneStreamer::RunWorkerThread, this);
+}
+
+SceneStreamer::~SceneStreamer()
+{
+	if (m_WorkerThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_ExitWorkerThread = true;
+		}
+		m_WorkerCondition.notify_one();
+		m_WorkerThread.join();
+	}
+
+	for (LoadedChunk* pLoadedChunk : m_LoadedChunks)
+		SafeDelete(pLoadedChunk);
+
+	SafeDelete(m_pMeshRenderResources);
+	SafeDelete(m_pChunkFile);
+}
+
+bool SceneStreamer::Update(RenderEnv* pRenderEnv, CommandList* pCommandList, UploadRingBuffer* pUploadRing, const Vector3f& cameraWorldPosition)
+{
+	if (!IsStreaming())
+		return false;
+
+	ReleaseCompletedFrees(pRenderEnv->m_pFence);
+
+	SelectWantedChunks(cameraWorldPosition);
+	CancelLoadRequests();
+
+	std::vector<MeshRenderInfoUpdate> meshInfoUpdates;
+	for (u32 chunkIndex = 0; chunkIndex < m_Chunks.size(); ++chunkIndex)
+	{
+		if ((m_ChunkStates[chunkIndex].m_State == ChunkState::Resident) && !m_ChunkStates[chunkIndex].m_Wanted)
+			EvictChunk(chunkIndex, &meshInfoUpdates);
+	}
+
+	std::vector<LoadedChunk*> loadedChunks;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		loadedChunks.swap(m_LoadedChunks);
+	}
+
+	// The nearest chunks get the space first, as they may evict farther chunks.
+	auto isNearer = [this](const LoadedChunk* pChunk1, const LoadedChunk* pChunk2)
+	{
+		return (m_ChunkStates[pChunk1->m_ChunkIndex].m_CameraDistance < m_ChunkStates[pChunk2->m_ChunkIndex].m_CameraDistance);
+	};
+	std::sort(loadedChunks.begin(), loadedChunks.end(), isNearer);
+
+	std::vector<MeshGeometryUpload> geometryUploads;
+	geometryUploads.reserve(loadedChunks.size());
+
+	std::vector<LoadedChunk*> retriedChunks;
+	for (LoadedChunk*& pLoadedChunk : loadedChunks)
+	{
+		const u32 chunkIndex = pLoadedChunk->m_ChunkIndex;
+		const SceneChunk& chunk = m_Chunks[chunkIndex];
+		ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+		assert(chunkState.m_State == ChunkState::Loading);
+
+		if (chunkState.m_Wanted && !AllocateChunk(chunkIndex, &meshInfoUpdates))
+		{
+			if (HasPendingFrees(chunk.m_MeshType))
+			{
+				// The chunk stays loading and is allocated again once the GPU has finished with the freed ranges.
+				retriedChunks.push_back(pLoadedChunk);
+				pLoadedChunk = nullptr;
+				continue;
+			}
+			// Requesting the chunk again would read it from the file every frame without a chance to fit.
+			chunkState.m_AwaitingFree = true;
+		}
+		
+		chunkState.m_State = ChunkState::Unloaded;
+		m_LoadingSizeInBytes -= chunkState.m_SizeInBytes;
+
+		if (chunkState.m_FirstVertex == RangeAllocator::kInvalidOffset)
+			continue;
+
+		MeshGeometryUpload upload;
+		upload.m_MeshType = chunk.m_MeshType;
+		upload.m_FirstVertex = chunkState.m_FirstVertex;
+		upload.m_NumVertices = chunk.m_NumVertices;
+		upload.m_FirstIndex = chunkState.m_FirstIndex;
+		upload.m_NumIndices = chunk.m_NumIndices;
+		upload.m_pVertexData = pLoadedChunk->m_VertexData.data();
+		upload.m_pPositionData = pLoadedChunk->m_PositionData.data();
+		upload.m_pIndexData = pLoadedChunk->m_IndexData.data();
+		geometryUploads.push_back(upload);
+
+		MakeChunkResident(chunkIndex, &meshInfoUpdates);
+	}
+
+	if (!meshInfoUpdates.empty())
+		m_pMeshRenderResources->UpdateStreamedMeshes(pCommandList, pUploadRing, geometryUploads, meshInfoUpdates);
+
+	for (LoadedChunk* pLoadedChunk : loadedChunks)
+		SafeDelete(pLoadedChunk);
+
+	if (!retriedChunks.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_LoadedChunks.insert(m_LoadedChunks.end(), retriedChunks.cbegin(), retriedChunks.cend());
+	}
+
+	RequestChunkLoads();
+
+	return !meshInfoUpdates.empty();
+}
+
+void SceneStreamer::FinishFrame(UINT64 fenceValue)
+{
+	for (PendingFree& pendingFree : m_UnsubmittedFrees)
+	{
+		pendingFree.m_FenceValue = fenceValue;
+		m_PendingFrees.push_back(pendingFree);
+	}
+	m_UnsubmittedFrees.clear();
+}
+
+void SceneStreamer::ReleaseCompletedFrees(Fence* pFence)
+{
+	// The frees are queued in the order of the frames, so the first pending frame is the first to complete.
+	std::vector<bool> freedMeshTypes(m_VertexAllocators.size(), false);
+	bool anyFreed = false;
+
+	while (!m_PendingFrees.empty() && pFence->ReceivedSignal(m_PendingFrees.front().m_FenceValue))
+	{
+		const PendingFree& pendingFree = m_PendingFrees.front();
+		m_VertexAllocators[pendingFree.m_MeshType].Free(pendingFree.m_FirstVertex, pendingFree.m_NumVertices);
+		m_IndexAllocators[pendingFree.m_MeshType].Free(pendingFree.m_FirstIndex, pendingFree.m_NumIndices);
+
+		freedMeshTypes[pendingFree.m_MeshType] = true;
+		anyFreed = true;
+
+		m_PendingFrees.pop_front();
+	}
+
+	// The chunks which did not fit can fit now that the free space of their mesh type has changed.
+	if (anyFreed)
+	{
+		for (u32 chunkIndex = 0; chunkIndex < m_Chunks.size(); ++chunkIndex)
+		{
+			if (freedMeshTypes[m_Chunks[chunkIndex].m_MeshType])
+				m_ChunkStates[chunkIndex].m_AwaitingFree = false;
+		}
+	}
+}
+
+bool SceneStreamer::HasPendingFrees(u32 meshType) const
+{
+	auto isOfMeshType = [meshType](const PendingFree& pendingFree)
+	{
+		return (pendingFree.m_MeshType == meshType);
+	};
+	return std::any_of(m_UnsubmittedFrees.cbegin(), m_UnsubmittedFrees.cend(), isOfMeshType) ||
+		std::any_of(m_PendingFrees.cbegin(), m_PendingFrees.cend(), isOfMeshType);
+}
+
+void SceneStreamer::InitChunkSizes()
+{
+	for (std::size_t chunkIndex = 0; chunkIndex < m_Chunks.size(); ++chunkIndex)
+	{
+		const SceneChunk& chunk = m_Chunks[chunkIndex];
+		const u32 vertexSizeInBytes = m_pMeshRenderResources->GetVertexStrideInBytes(chunk.m_MeshType) +
+			m_pMeshRenderResources->GetPositionVertexStrideInBytes(chunk.m_MeshType);
+
+		m_ChunkStates[chunkIndex].m_SizeInBytes = u64(chunk.m_NumVertices) * vertexSizeInBytes +
+			u64(chunk.m_NumIndices) * m_pMeshRenderResources->GetIndexStrideInBytes(chunk.m_MeshType);
+	}
+}
+
+void SceneStreamer::MakeAllChunksResident()
+{
+	// The mesh render resources draw every mesh from its place in the full geometry buffers, so no ranges are allocated.
+	for (std::size_t chunkIndex = 0; chunkIndex < m_Chunks.size(); ++chunkIndex)
+	{
+		ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+		chunkState.m_State = ChunkState::Resident;
+		chunkState.m_Wanted = true;
+
+		for (u32 materialID : m_Chunks[chunkIndex].m_MaterialIDs)
+			++m_MaterialRefCounts[materialID];
+
+		++m_NumResidentChunks;
+		m_ResidentSizeInBytes += chunkState.m_SizeInBytes;
+	}
+}
+
+void SceneStreamer::SelectWantedChunks(const Vector3f& cameraWorldPosition)
+{
+	m_ChunksByDistance.clear();
+	for (u32 chunkIndex = 0; chunkIndex < m_Chunks.size(); ++chunkIndex)
+	{
+		ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+		chunkState.m_CameraDistance = CalcDistanceToBox(cameraWorldPosition, m_Chunks[chunkIndex].m_WorldBounds);
+		chunkState.m_Wanted = false;
+
+		if (chunkState.m_CameraDistance <= m_Params.m_StreamingDistance)
+			m_ChunksByDistance.push_back(chunkIndex);
+	}
+
+	auto isNearer = [this](u32 chunkIndex1, u32 chunkIndex2)
+	{
+		return (m_ChunkStates[chunkIndex1].m_CameraDistance < m_ChunkStates[chunkIndex2].m_CameraDistance);
+	};
+	std::sort(m_ChunksByDistance.begin(), m_ChunksByDistance.end(), isNearer);
+
+	// The nearest chunks which together fit into the shared buffers are wanted, skipping the chunks which do not fit.
+	const u32 numMeshTypes = m_VertexAllocators.size();
+	std::vector<u32> numWantedVertices(numMeshTypes, 0);
+	std::vector<u32> numWantedIndices(numMeshTypes, 0);
+
+	for (u32 chunkIndex : m_ChunksByDistance)
+	{
+		const SceneChunk& chunk = m_Chunks[chunkIndex];
+		const u32 meshType = chunk.m_MeshType;
+
+		if ((numWantedVertices[meshType] + chunk.m_NumVertices <= m_VertexAllocators[meshType].GetCapacity()) &&
+			(numWantedIndices[meshType] + chunk.m_NumIndices <= m_IndexAllocators[meshType].GetCapacity()))
+		{
+			numWantedVertices[meshType] += chunk.m_NumVertices;
+			numWantedIndices[meshType] += chunk.m_NumIndices;
+			m_ChunkStates[chunkIndex].m_Wanted = true;
+		}
+	}
+}
+
+void SceneStreamer::CancelLoadRequests()
+{
+	// The requests which the worker thread has not started yet are issued again in the order of the new camera distances.
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (u32 chunkIndex : m_LoadRequests)
+	{
+		ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+		chunkState.m_State = ChunkState::Unloaded;
+		m_LoadingSizeInBytes -= chunkState.m_SizeInBytes;
+	}
+	m_LoadRequests.clear();
+}
+
+bool SceneStreamer::AllocateChunk(u32 chunkIndex, std::vector<MeshRenderInfoUpdate>* pMeshInfoUpdates)
+{
+	const SceneChunk& chunk = m_Chunks[chunkIndex];
+	ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+
+	RangeAllocator& vertexAllocator = m_VertexAllocators[chunk.m_MeshType];
+	RangeAllocator& indexAllocator = m_IndexAllocators[chunk.m_MeshType];
+
+	chunkState.m_FirstVertex = vertexAllocator.Allocate(chunk.m_NumVertices);
+	chunkState.m_FirstIndex = indexAllocator.Allocate(chunk.m_NumIndices);
+
+	if ((chunkState.m_FirstVertex != RangeAllocator::kInvalidOffset) && (chunkState.m_FirstIndex != RangeAllocator::kInvalidOffset))
+		return true;
+
+	if (chunkState.m_FirstVertex != RangeAllocator::kInvalidOffset)
+		vertexAllocator.Free(chunkState.m_FirstVertex, chunk.m_NumVertices);
+	if (chunkState.m_FirstIndex != RangeAllocator::kInvalidOffset)
+		indexAllocator.Free(chunkState.m_FirstIndex, chunk.m_NumIndices);
+
+	chunkState.m_FirstVertex = RangeAllocator::kInvalidOffset;
+	chunkState.m_FirstIndex = RangeAllocator::kInvalidOffset;
+	
+	// The wanted chunks fit into the buffers together, but the free space can be fragmented or still be read by the GPU.
+	// Until the ranges freed earlier have been released, no more chunks are evicted for the mesh type.
+	if (HasPendingFrees(chunk.m_MeshType))
+		return false;
+
+	// The farthest resident chunk of the mesh type is evicted to make room, if it is farther than the chunk.
+	u32 evictedChunkIndex = kInvalidChunkIndex;
+	for (u32 residentChunkIndex = 0; residentChunkIndex < m_Chunks.size(); ++residentChunkIndex)
+	{
+		const ChunkStreamingState& residentChunkState = m_ChunkStates[residentChunkIndex];
+		if ((residentChunkState.m_State != ChunkState::Resident) || (m_Chunks[residentChunkIndex].m_MeshType != chunk.m_MeshType))
+			continue;
+
+		if (residentChunkState.m_CameraDistance <= chunkState.m_CameraDistance)
+			continue;
+
+		if ((evictedChunkIndex == kInvalidChunkIndex) || (residentChunkState.m_CameraDistance > m_ChunkStates[evictedChunkIndex].m_CameraDistance))
+			evictedChunkIndex = residentChunkIndex;
+	}
+	if (evictedChunkIndex != kInvalidChunkIndex)
+		EvictChunk(evictedChunkIndex, pMeshInfoUpdates);
+
+	return false;
+}
+
+void SceneStreamer::MakeChunkResident(u32 chunkIndex, std::vector<MeshRenderInfoUpdate>* pMeshInfoUpdates)
+{
+	const SceneChunk& chunk = m_Chunks[chunkIndex];
+	ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+	
+	const MeshInfo* pMeshInfos = m_pScene->GetMeshBatches()[chunk.m_MeshType]->GetMeshInfos();
+	const u32 meshTypeOffset = m_pMeshRenderResources->GetMeshTypeOffset(chunk.m_MeshType);
+
+	// The chunk meshes are stored one after another in the chunk ranges of the shared buffers.
+	u32 baseVertexLocation = chunkState.m_FirstVertex;
+	u32 startIndexLocation = chunkState.m_FirstIndex;
+	
+	for (u32 meshIndex : chunk.m_MeshIndices)
+	{
+		const MeshInfo& meshInfo = pMeshInfos[meshIndex];
+		pMeshInfoUpdates->emplace_back(meshTypeOffset + meshIndex, meshInfo.m_InstanceCount, startIndexLocation, i32(baseVertexLocation));
+
+		baseVertexLocation += meshInfo.m_VertexCount;
+		startIndexLocation += meshInfo.m_IndexCount;
+	}
+
+	for (u32 materialID : chunk.m_MaterialIDs)
+		++m_MaterialRefCounts[materialID];
+
+	chunkState.m_State = ChunkState::Resident;
+	++m_NumResidentChunks;
+	m_ResidentSizeInBytes += chunkState.m_SizeInBytes;
+}
+
+void SceneStreamer::EvictChunk(u32 chunkIndex, std::vector<MeshRenderInfoUpdate>* pMeshInfoUpdates)
+{
+	const SceneChunk& chunk = m_Chunks[chunkIndex];
+	ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+	assert(chunkState.m_State == ChunkState::Resident);
+
+	const u32 meshTypeOffset = m_pMeshRenderResources->GetMeshTypeOffset(chunk.m_MeshType);
+	for (u32 meshIndex : chunk.m_MeshIndices)
+		pMeshInfoUpdates->emplace_back(meshTypeOffset + meshIndex, 0, 0, 0);
+
+	// Frames in flight can still draw from the buffer ranges, so they are freed once the frame giving the meshes zero instances has completed.
+	PendingFree pendingFree;
+	pendingFree.m_MeshType = chunk.m_MeshType;
+	pendingFree.m_FirstVertex = chunkState.m_FirstVertex;
+	pendingFree.m_NumVertices = chunk.m_NumVertices;
+	pendingFree.m_FirstIndex = chunkState.m_FirstIndex;
+	pendingFree.m_NumIndices = chunk.m_NumIndices;
+	m_UnsubmittedFrees.push_back(pendingFree);
+
+	chunkState.m_FirstVertex = RangeAllocator::kInvalidOffset;
+	chunkState.m_FirstIndex = RangeAllocator::kInvalidOffset;
+
+	for (u32 materialID : chunk.m_MaterialIDs)
+	{
+		assert(m_MaterialRefCounts[materialID] > 0);
+		--m_MaterialRefCounts[materialID];
+	}
+
+	chunkState.m_State = ChunkState::Unloaded;
+	--m_NumResidentChunks;
+	m_ResidentSizeInBytes -= chunkState.m_SizeInBytes;
+}
+
+void SceneStreamer::RequestChunkLoads()
+{
+	std::vector<u32> newRequests;
+	for (u32 chunkIndex : m_ChunksByDistance)
+	{
+		ChunkStreamingState& chunkState = m_ChunkStates[chunkIndex];
+		if (!chunkState.m_Wanted || (chunkState.m_State != ChunkState::Unloaded) || chunkState.m_AwaitingFree)
+			continue;
+
+		// A chunk larger than the whole budget is still loaded when nothing else is in flight, so that it cannot stall streaming.
+		if ((m_LoadingSizeInBytes > 0) && (m_LoadingSizeInBytes + chunkState.m_SizeInBytes > m_Params.m_CPUMemoryBudgetInBytes))
+			break;
+
+		chunkState.m_State = ChunkState::Loading;
+		m_LoadingSizeInBytes += chunkState.m_SizeInBytes;
+		newRequests.push_back(chunkIndex);
+	}
+
+	if (!newRequests.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_LoadRequests.insert(m_LoadRequests.end(), newRequests.cbegin(), newRequests.cend());
+		}
+		m_WorkerCondition.notify_one();
+	}
+}
+
+void SceneStreamer::RunWorkerThread()
+{
+	for (;;)
+	{
+		u32 chunkIndex = 0;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkerCondition.wait(lock, [this]() { return (m_ExitWorkerThread || !m_LoadRequests.empty()); });
+
+			if (m_ExitWorkerThread)
+				return;
+
+			chunkIndex = m_LoadRequests.front();
+			m_LoadRequests.pop_front();
+		}
+
+		LoadedChunk* pLoadedChunk = LoadChunk(chunkIndex);
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_LoadedChunks.push_back(pLoadedChunk);
+		}
+	}
+}
+
+SceneStreamer::LoadedChunk* SceneStreamer::LoadChunk(u32 chunkIndex) const
+{
+	const SceneChunk& chunk = m_Chunks[chunkIndex];
+	const SceneChunkGeometry& geometry = m_pChunkFile->GetChunkGeometry(chunkIndex);
+
+	LoadedChunk* pLoadedChunk = new LoadedChunk();
+	pLoadedChunk->m_ChunkIndex = chunkIndex;
+	pLoadedChunk->m_VertexData.resize(chunk.m_NumVertices * m_pMeshRenderResources->GetVertexStrideInBytes(chunk.m_MeshType));
+	pLoadedChunk->m_PositionData.resize(chunk.m_NumVertices * m_pMeshRenderResources->GetPositionVertexStrideInBytes(chunk.m_MeshType));
+	pLoadedChunk->m_IndexData.resize(chunk.m_NumIndices * m_pMeshRenderResources->GetIndexStrideInBytes(chunk.m_MeshType));
+
+	// Reading the streams from the memory mapped file pages the chunk in.
+	// The meshes are stored one after another and every mesh is encoded with its own quantization ranges.
+	const MeshInfo* pMeshInfos = m_pScene->GetMeshBatches()[chunk.m_MeshType]->GetMeshInfos();
+	const u32 vertexStrideInBytes = m_pMeshRenderResources->GetVertexStrideInBytes(chunk.m_MeshType);
+	const u32 positionStrideInBytes = m_pMeshRenderResources->GetPositionVertexStrideInBytes(chunk.m_MeshType);
+
+	u32 firstVertex = 0;
+	for (u32 meshIndex : chunk.m_MeshIndices)
+	{
+		const u32 numVertices = pMeshInfos[meshIndex].m_VertexCount;
+
+		MeshVertexStreams streams;
+		streams.m_pPositions = geometry.m_pPositions + firstVertex;
+		if (geometry.m_pNormals != nullptr)
+			streams.m_pNormals = geometry.m_pNormals + firstVertex;
+		if (geometry.m_pColors != nullptr)
+			streams.m_pColors = geometry.m_pColors + firstVertex;
+		if (geometry.m_pTangents != nullptr)
+			streams.m_pTangents = geometry.m_pTangents + firstVertex;
+		if (geometry.m_pTexCoords != nullptr)
+			streams.m_pTexCoords = geometry.m_pTexCoords + firstVertex;
+
+		m_pMeshRenderResources->EncodeVertices(chunk.m_MeshType, meshIndex, numVertices, streams,
+			pLoadedChunk->m_VertexData.data() + firstVertex * vertexStrideInBytes,
+			pLoadedChunk->m_PositionData.data() + firstVertex * positionStrideInBytes);
+
+		firstVertex += numVertices;
+	}
+	assert(firstVertex == chunk.m_NumVertices);
+	
+	std::memcpy(pLoadedChunk->m_IndexData.data(), geometry.m_pIndices, pLoadedChunk->m_IndexData.size());
+
+	return pLoadedChunk;
+}
+
+namespace
+{
+	f32 CalcDistanceToBox(const Vector3f& point, const AxisAlignedBox& box)
+	{
+		const f32 dx = Max(std::abs(point.m_X - box.m_Center.m_X) - box.m_Radius.m_X, 0.0f);
+		const f32 dy = Max(std::abs(point.m_Y - box.m_Center.m_Y) - box.m_Radius.m_Y, 0.0f);
+		const f32 dz = Max(std::abs(point.m_Z - box.m_Center.m_Z) - box.m_Radius.m_Z, 0.0f);
+
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+
+	SceneChunkFile* OpenChunkFile(const wchar_t* pChunkFilePath, Scene* pScene, const std::vector<SceneChunk>& chunks)
+	{
+		SceneChunkFile* pChunkFile = new SceneChunkFile();
+		if (pChunkFile->Open(pChunkFilePath, pScene, chunks))
+			return pChunkFile;
+
+		SafeDelete(pChunkFile);
+		if (!WriteSceneChunkFile(pChunkFilePath, pScene, chunks))
+			return nullptr;
+
+		pChunkFile = new SceneChunkFile();
+		if (pChunkFile->Open(pChunkFilePath, pScene, chunks))
+			return pChunkFile;
+
+		SafeDelete(pChunkFile);
+		return nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "RenderPasses/ShadowMapAtlas.h"
+#include "Math/Math.h"
+
+namespace
+{
+	u32 CalcNumQuadTreeNodes(u32 atlasSize, u32 minTileSize);
+	u32 RoundUpToPowerOf2(u32 value);
+}
+
+ShadowMapAtlas::ShadowMapAtlas(u32 atlasSize, u32 minTileSize, u32 maxTileSize, u32 numLights)
+	: m_AtlasSize(atlasSize)
+	, m_MinTileSize(minTileSize)
+	, m_MaxTileSize(maxTileSize)
+	, m_NodeStates(CalcNumQuadTreeNodes(atlasSize, minTileSize), NodeState_Free)
+	, m_LightTiles(numLights)
+	, m_LightRequestedTileSizes(numLights, 0)
+	, m_IsLightActive(numLights, 0)
+{
+	assert(IsPowerOf2(m_AtlasSize));
+	assert(IsPowerOf2(m_MinTileSize));
+	assert(IsPowerOf2(m_MaxTileSize));
+	assert(m_MinTileSize <= m_MaxTileSize);
+	assert(m_MaxTileSize <= m_AtlasSize);
+}
+
+void ShadowMapAtlas::Update(u32 numActiveLights, const u32* pActiveLightIndices, const u32* pRequestedTileSizes,
+	std::vector<u32>* pReallocatedLightIndices)
+{
+	pReallocatedLightIndices->clear();
+
+	for (u32 it = 0; it < numActiveLights; ++it)
+		m_IsLightActive[pActiveLightIndices[it]] = 1;
+
+	for (u32 lightIndex = 0; lightIndex < m_LightTiles.size(); ++lightIndex)
+	{
+		if (m_IsLightActive[lightIndex] == 0)
+		{
+			if (HasTile(lightIndex))
+			{
+				FreeTile(m_LightTiles[lightIndex]);
+				m_LightTiles[lightIndex] = ShadowMapTile();
+			}
+			m_LightRequestedTileSizes[lightIndex] = 0;
+		}
+	}
+
+	// Requested size is compared against the previous request rather than the tile size.
+	// Otherwise, lights which did not get the requested size would be reallocated every update.
+	std::vector<u32> pendingLightIndices;
+	for (u32 it = 0; it < numActiveLights; ++it)
+	{
+		const u32 lightIndex = pActiveLightIndices[it];
+		const u32 requestedTileSize = Clamp(m_MinTileSize, m_MaxTileSize, RoundUpToPowerOf2(pRequestedTileSizes[it]));
+
+		if (m_LightRequestedTileSizes[lightIndex] != requestedTileSize)
+		{
+			if (HasTile(lightIndex))
+			{
+				FreeTile(m_LightTiles[lightIndex]);
+				m_LightTiles[lightIndex] = ShadowMapTile();
+			}
+			m_LightRequestedTileSizes[lightIndex] = requestedTileSize;
+			pendingLightIndices.push_back(lightIndex);
+		}
+	}
+
+	// Placing larger tiles first reduces fragmentation of the quad-tree.
+	std::stable_sort(pendingLightIndices.begin(), pendingLightIndices.end(), [this](u32 lightIndex1, u32 lightIndex2)
+	{
+		return (m_LightRequestedTileSizes[lightIndex1] > m_LightRequestedTileSizes[lightIndex2]);
+	});
+
+	bool allocationFailed = false;
+	for (const u32 lightIndex : pendingLightIndices)
+	{
+		ShadowMapTile tile;
+		u32 tileSize = m_LightRequestedTileSizes[lightIndex];
+
+		while (!AllocateTile(tileSize, &tile) && (tileSize > m_MinTileSize))
+			tileSize /= 2;
+
+		if (tile.m_Size == 0)
+		{
+			allocationFailed = true;
+			break;
+		}
+
+		m_LightTiles[lightIndex] = tile;
+		pReallocatedLightIndices->push_back(lightIndex);
+	}
+
+	if (allocationFailed)
+		Repack(numActiveLights, pActiveLightIndices, pReallocatedLightIndices);
+
+	for (u32 it = 0; it < numActiveLights; ++it)
+		m_IsLightActive[pActiveLightIndices[it]] = 0;
+}
+
+void ShadowMapAtlas::Repack(u32 numActiveLights, const u32* pActiveLightIndices, std::vector<u32>* pReallocatedLightIndices)
+{
+	std::fill(m_NodeStates.begin(), m_NodeStates.end(), NodeState_Free);
+	for (ShadowMapTile& tile : m_LightTiles)
+		tile = ShadowMapTile();
+
+	pReallocatedLightIndices->assign(pActiveLightIndices, pActiveLightIndices + numActiveLights);
+	std::stable_sort(pReallocatedLightIndices->begin(), pReallocatedLightIndices->end(), [this](u32 lightIndex1, u32 lightIndex2)
+	{
+		return (m_LightRequestedTileSizes[lightIndex1] > m_LightRequestedTileSizes[lightIndex2]);
+	});
+
+	// Allocating tiles in decreasing size order leaves no holes in the quad-tree,
+	// so the allocation can only fail if the atlas area is exhausted. In that case, tiles are downsized.
+	for (const u32 lightIndex : *pReallocatedLightIndices)
+	{
+		ShadowMapTile tile;
+		u32 tileSize = m_LightRequestedTileSizes[lightIndex];
+
+		while (!AllocateTile(tileSize, &tile) && (tileSize > m_MinTileSize))
+			tileSize /= 2;
+
+		assert(tile.m_Size > 0);
+		m_LightTiles[lightIndex] = tile;
+	}
+}
+
+Vector4f ShadowMapAtlas::CalcTileTexCoordRect(u32 lightIndex) const
+{
+	assert(HasTile(lightIndex));
+	const ShadowMapTile& tile = m_LightTiles[lightIndex];
+	const f32 rcpAtlasSize = Rcp(f32(m_AtlasSize));
+
+	return Vector4f((f32(tile.m_X) + 0.5f) * rcpAtlasSize, (f32(tile.m_Y) + 0.5f) * rcpAtlasSize,
+		f32(tile.m_Size - 1) * rcpAtlasSize, f32(tile.m_Size - 1) * rcpAtlasSize);
+}
+
+bool ShadowMapAtlas::AllocateTile(u32 tileSize, ShadowMapTile* pTile)
+{
+	assert(IsPowerOf2(tileSize));
+	assert(IsInRange(m_MinTileSize, m_AtlasSize, tileSize));
+
+	return AllocateNode(0, 0, 0, m_AtlasSize, tileSize, pTile);
+}
+
+bool ShadowMapAtlas::AllocateNode(u32 nodeIndex, u32 nodeX, u32 nodeY, u32 nodeSize, u32 tileSize, ShadowMapTile* pTile)
+{
+	const u8 nodeState = m_NodeStates[nodeIndex];
+	if (nodeState == NodeState_Allocated)
+		return false;
+
+	if (nodeSize == tileSize)
+	{
+		if (nodeState != NodeState_Free)
+			return false;
+
+		m_NodeStates[nodeIndex] = NodeState_Allocated;
+
+		pTile->m_X = nodeX;
+		pTile->m_Y = nodeY;
+		pTile->m_Size = tileSize;
+
+		return true;
+	}
+
+	const u32 childSize = nodeSize / 2;
+	const u32 firstChildIndex = 4 * nodeIndex + 1;
+
+	// Prefer already split children to keep free nodes intact for larger tiles.
+	if (nodeState == NodeState_Split)
+	{
+		for (u32 childOffset = 0; childOffset < 4; ++childOffset)
+		{
+			const u32 childIndex = firstChildIndex + childOffset;
+			if (m_NodeStates[childIndex] != NodeState_Split)
+				continue;
+
+			const u32 childX = nodeX + (childOffset & 1) * childSize;
+			const u32 childY = nodeY + (childOffset >> 1) * childSize;
+
+			if (AllocateNode(childIndex, childX, childY, childSize, tileSize, pTile))
+				return true;
+		}
+	}
+	m_NodeStates[nodeIndex] = NodeState_Split;
+
+	for (u32 childOffset = 0; childOffset < 4; ++childOffset)
+	{
+		const u32 childIndex = firstChildIndex + childOffset;
+		if (m_NodeStates[childIndex] != NodeState_Free)
+			continue;
+
+		const u32 childX = nodeX + (childOffset & 1) * childSize;
+		const u32 childY = nodeY + (childOffset >> 1) * childSize;
+
+		if (AllocateNode(childIndex, childX, childY, childSize, tileSize, pTile))
+			return true;
+	}
+
+	return false;
+}
+
+void ShadowMapAtlas::FreeTile(const ShadowMapTile& tile)
+{
+	FreeNode(0, 0, 0, m_AtlasSize, tile);
+}
+
+void ShadowMapAtlas::FreeNode(u32 nodeIndex, u32 nodeX, u32 nodeY, u32 nodeSize, const ShadowMapTile& tile)
+{
+	if (nodeSize == tile.m_Size)
+	{
+		assert((nodeX == tile.m_X) && (nodeY == tile.m_Y));
+		assert(m_NodeStates[nodeIndex] == NodeState_Allocated);
+
+		m_NodeStates[nodeIndex] = NodeState_Free;
+		return;
+	}
+
+	assert(m_NodeStates[nodeIndex] == NodeState_Split);
+
+	const u32 childSize = nodeSize / 2;
+	const u32 childOffsetX = (tile.m_X >= nodeX + childSize) ? 1 : 0;
+	const u32 childOffsetY = (tile.m_Y >= nodeY + childSize) ? 1 : 0;
+
+	const u32 firstChildIndex = 4 * nodeIndex + 1;
+	FreeNode(firstChildIndex + childOffsetY * 2 + childOffsetX,
+		nodeX + childOffsetX * childSize, nodeY + childOffsetY * childSize, childSize, tile);
+
+	// Merge the children back once none of them is in use.
+	for (u32 childOffset = 0; childOffset < 4; ++childOffset)
+	{
+		if (m_NodeStates[firstChildIndex + childOffset] != NodeState_Free)
+			return;
+	}
+	m_NodeStates[nodeIndex] = NodeState_Free;
+}
+
+u32 CalcSpotLightShadowMapSize(const Sphere& lightWorldBounds, const Vector3f& cameraWorldPos, f32 cameraProjMatrix11,
+	u32 screenHeight, u32 minShadowMapSize, u32 maxShadowMapSize)
+{
+	const f32 squaredDistToCamera = LengthSquared(lightWorldBounds.m_Center - cameraWorldPos);
+	const f32 squaredRadius = Sqr(lightWorldBounds.m_Radius);
+
+	if (squaredDistToCamera <= squaredRadius)
+		return maxShadowMapSize;
+
+	// Projected radius of the sphere in normalized device coordinates. Covered screen height is radius * screenHeight.
+	const f32 projRadius = cameraProjMatrix11 * lightWorldBounds.m_Radius / Sqrt(squaredDistToCamera - squaredRadius);
+	const f32 coveredScreenHeight = projRadius * f32(screenHeight);
+
+	const u32 shadowMapSize = RoundUpToPowerOf2(u32(Min(coveredScreenHeight, f32(maxShadowMapSize))));
+	return Clamp(minShadowMapSize, maxShadowMapSize, shadowMapSize);
+}
+
+namespace
+{
+	u32 CalcNumQuadTreeNodes(u32 atlasSize, u32 minTileSize)
+	{
+		u32 numNodes = 0;
+		for (u32 numNodesPerLevel = 1; atlasSize >= minTileSize; atlasSize /= 2, numNodesPerLevel *= 4)
+			numNodes += numNodesPerLevel;
+
+		return numNodes;
+	}
+
+	u32 RoundUpToPowerOf2(u32 value)
+	{
+		u32 powerOf2 = 1;
+		while (powerOf2 < value)
+			powerOf2 *= 2;
+
+		return powerOf2;
+	}
+}
\ No newline at end of file
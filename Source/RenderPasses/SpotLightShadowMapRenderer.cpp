@@ -1,16 +1,24 @@
 #include "RenderPasses/SpotLightShadowMapRenderer.h"
-#include "RenderPasses/RenderSpotLightShadowMapPass.h"
 #include "RenderPasses/CreateExpShadowMapPass.h"
 #include "RenderPasses/FilterExpShadowMapPass.h"
+#include "RenderPasses/ShadowMapAtlas.h"
 #include "RenderPasses/Utils.h"
 #include "RenderPasses/MeshRenderResources.h"
 #include "D3DWrapper/RenderEnv.h"
 #include "D3DWrapper/CommandSignature.h"
-#include "Math/Frustum.h"
+#include "D3DWrapper/UploadRingBuffer.h"
 #include "Math/OverlapTest.h"
 #include "Math/Transform.h"
 #include "Scene/Light.h"
-#include "Scene/MeshBatch.h"
+
+namespace
+{
+	void GenerateShadowCasterCommands(const MeshBatch* pMeshBatch, const MeshRenderResources* pMeshRenderResources, u32 meshType,
+		const std::vector<u32>& shadowCasterInstanceIndices, const Frustum* pLightWorldFrustum, std::vector<u32>& visibleMeshInstanceIndices,
+		std::vector<ShadowMapCommand>& shadowMapCommands, std::vector<u32>& commandMeshIndices, std::vector<u32>& commandNumInstances);
+
+	void SetShadowMapCommandArgs(const MeshRenderInfo& meshInfo, u32 numVisibleMeshInstances, DrawIndexedArguments* pArgs);
+}
 
 SpotLightShadowMapRenderer::SpotLightShadowMapRenderer(InitParams* pParams)
 {
@@ -26,17 +34,118 @@ SpotLightShadowMapRenderer::~SpotLightShadowMapRenderer()
 	SafeDelete(m_pCreateExpShadowMapPass);
 	SafeDelete(m_pFilterExpShadowMapPass);
 	SafeDelete(m_pActiveShadowMaps);
-	SafeDelete(m_pStaticMeshCommandBuffer);
-	SafeDelete(m_pStaticMeshInstanceIndexBuffer);
+	SafeDelete(m_pStaticShadowMaps);
+	SafeDelete(m_pShadowCasterCommandBuffer);
+	SafeDelete(m_pShadowCasterInstanceIndexBuffer);
 	SafeDelete(m_pSpotLightShadowMaps);
+	SafeDelete(m_pShadowMapAtlas);
 	SafeDelete(m_pSpotLightViewProjMatrixBuffer);
 	SafeDelete(m_pCreateExpShadowMapParamsBuffer);
 }
 
+void SpotLightShadowMapRenderer::UpdateShadowMapAtlas(u32 numActiveSpotLights, const u32* pActiveSpotLightIndices, const u32* pRequestedShadowMapSizes)
+{
+	m_pShadowMapAtlas->Update(numActiveSpotLights, pActiveSpotLightIndices, pRequestedShadowMapSizes, &m_ReallocatedSpotLightIndices);
+
+	// Lights which have been given a new tile need their exp shadow maps regenerated in place.
+	for (const u32 lightIndex : m_ReallocatedSpotLightIndices)
+		m_SpotLightShadowMapStates[lightIndex] = ShadowMapState::Outdated;
+}
+
+Vector4f SpotLightShadowMapRenderer::CalcShadowMapAtlasRect(u32 lightIndex) const
+{
+	return m_pShadowMapAtlas->CalcTileTexCoordRect(lightIndex);
+}
+
+void SpotLightShadowMapRenderer::UpdateMeshResidency(CommandList* pCommandList, UploadRingBuffer* pUploadRing, const MeshRenderResources* pMeshRenderResources)
+{
+	std::vector<bool> changedCommands(m_ShadowCasterCommands.size(), false);
+	bool anyCommandChanged = false;
+
+	for (std::size_t commandIndex = 0; commandIndex < m_ShadowCasterCommands.size(); ++commandIndex)
+	{
+		DrawIndexedArguments args;
+		SetShadowMapCommandArgs(pMeshRenderResources->GetMeshRenderInfo(m_ShadowCasterCommandMeshIndices[commandIndex]),
+			m_ShadowCasterCommandNumInstances[commandIndex], &args);
+
+		DrawIndexedArguments& currentArgs = m_ShadowCasterCommands[commandIndex].m_Args;
+		if (std::memcmp(&args, &currentArgs, sizeof(args)) != 0)
+		{
+			currentArgs = args;
+			changedCommands[commandIndex] = true;
+			anyCommandChanged = true;
+		}
+	}
+	if (!anyCommandChanged)
+		return;
+
+	const UINT64 numUploadBytes = m_ShadowCasterCommands.size() * sizeof(ShadowMapCommand);
+
+	UINT64 uploadBufferOffset = 0;
+	u8* pUploadData = pUploadRing->Allocate(numUploadBytes, sizeof(u32), &uploadBufferOffset);
+	assert(pUploadData != nullptr);
+	std::memcpy(pUploadData, m_ShadowCasterCommands.data(), numUploadBytes);
+
+	const ResourceTransitionBarrier copyDestBarrier(m_pShadowCasterCommandBuffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST);
+	pCommandList->ResourceBarrier(1, &copyDestBarrier);
+	pCommandList->CopyBufferRegion(m_pShadowCasterCommandBuffer, 0, pUploadRing->GetBuffer(), uploadBufferOffset, numUploadBytes);
+
+	const ResourceTransitionBarrier indirectArgumentBarrier(m_pShadowCasterCommandBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+	pCommandList->ResourceBarrier(1, &indirectArgumentBarrier);
+
+	// The cached static shadow maps of the lights whose shadow casters have been loaded or evicted have to be rendered again.
+	const u32 numSpotLights = m_StaticShadowMapStates.size();
+	for (u32 lightIndex = 0; lightIndex < numSpotLights; ++lightIndex)
+	{
+		for (u32 meshType = 0; meshType < m_NumStaticMeshTypes; ++meshType)
+		{
+			const ShadowMapCommandRange& commandRange = m_StaticMeshCommandRanges[lightIndex * m_NumStaticMeshTypes + meshType];
+			const auto firstCommand = changedCommands.cbegin() + commandRange.m_FirstCommand;
+
+			if (std::find(firstCommand, firstCommand + commandRange.m_NumCommands, true) != firstCommand + commandRange.m_NumCommands)
+			{
+				m_StaticShadowMapStates[lightIndex] = ShadowMapState::Outdated;
+				m_SpotLightShadowMapStates[lightIndex] = ShadowMapState::Outdated;
+				break;
+			}
+		}
+	}
+}
+
+void SpotLightShadowMapRenderer::UpdateMeshInstances(u32 meshType, const AxisAlignedBox* pMeshInstanceWorldAABBs,
+	const std::vector<MeshBatch::MeshInstanceRange>& instanceRanges)
+{
+	const std::vector<u32>& dynamicInstanceIndices = m_DynamicMeshInstanceIndices[meshType];
+	std::vector<AxisAlignedBox>& dynamicInstanceWorldAABBs = m_DynamicMeshInstanceWorldAABBs[meshType];
+
+	const u32 numSpotLights = m_SpotLightWorldFrustums.size();
+	for (const MeshBatch::MeshInstanceRange& instanceRange : instanceRanges)
+	{
+		// Ranges can include static instances in the gaps between the moved ones.
+		auto instanceIt = std::lower_bound(dynamicInstanceIndices.cbegin(), dynamicInstanceIndices.cend(), instanceRange.m_FirstInstance);
+		for (; (instanceIt != dynamicInstanceIndices.cend()) && (*instanceIt < instanceRange.m_FirstInstance + instanceRange.m_NumInstances); ++instanceIt)
+		{
+			AxisAlignedBox& prevWorldAABB = dynamicInstanceWorldAABBs[instanceIt - dynamicInstanceIndices.cbegin()];
+			const AxisAlignedBox& newWorldAABB = pMeshInstanceWorldAABBs[*instanceIt];
+
+			// The shadow of the instance has to be removed from the lights it has left and added to the lights it has entered.
+			for (u32 lightIndex = 0; lightIndex < numSpotLights; ++lightIndex)
+			{
+				const Frustum& lightWorldFrustum = m_SpotLightWorldFrustums[lightIndex];
+				if (TestAABBAgainstFrustum(lightWorldFrustum, prevWorldAABB) || TestAABBAgainstFrustum(lightWorldFrustum, newWorldAABB))
+					m_SpotLightShadowMapStates[lightIndex] = ShadowMapState::Outdated;
+			}
+			prevWorldAABB = newWorldAABB;
+		}
+	}
+}
+
 void SpotLightShadowMapRenderer::Record(RenderParams* pParams)
 {
 	assert(pParams->m_NumActiveSpotLights <= m_OutdatedSpotLightShadowMapIndices.size());
 
+	// Only shadow maps of the lights affected by moved dynamic shadow casters, new atlas tiles or residency changes are refreshed.
+	// Static shadow casters are not re-rendered though. Their depth is restored from the cached static shadow maps.
 	u32 numOutdatedShadowMaps = 0;
 	for (u32 it = 0; it < pParams->m_NumActiveSpotLights; ++it)
 	{
@@ -48,22 +157,41 @@ void SpotLightShadowMapRenderer::Record(RenderParams* pParams)
 	CommandList* pCommandList = pParams->m_pCommandList;
 	pCommandList->Begin();
 
+	// The atlas is kept in unordered access state while the tiles of outdated lights are being updated.
+	if (numOutdatedShadowMaps > 0)
+	{
+		const ResourceTransitionBarrier resourceBarrier(m_pSpotLightShadowMaps,
+			m_OutputResourceStates.m_SpotLightShadowMapsState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		pCommandList->ResourceBarrier(1, &resourceBarrier);
+	}
+
 	for (u32 it = 0; it < numOutdatedShadowMaps; ++it)
 	{
 		const u32 shadowMapIndex = m_OutdatedSpotLightShadowMapIndices[it];
-		const CommandRange& commandRange = m_StaticMeshCommandRanges[shadowMapIndex];
+		assert(m_pShadowMapAtlas->HasTile(shadowMapIndex));
+		const ShadowMapTile& shadowMapTile = m_pShadowMapAtlas->GetTile(shadowMapIndex);
 
+		if ((m_StaticShadowMapStates[shadowMapIndex] == ShadowMapState::Outdated) || (m_StaticShadowMapSizes[shadowMapIndex] != shadowMapTile.m_Size))
+		{
+			RenderStaticShadowMap(pParams, shadowMapIndex, shadowMapTile.m_Size);
+
+			m_StaticShadowMapStates[shadowMapIndex] = ShadowMapState::UpToDate;
+			m_StaticShadowMapSizes[shadowMapIndex] = shadowMapTile.m_Size;
+		}
+		CopyStaticShadowMap(pParams, shadowMapIndex, it);
 		{
 			RenderSpotLightShadowMapPass::RenderParams params;
 			params.m_pRenderEnv = pParams->m_pRenderEnv;
 			params.m_pCommandList = pCommandList;
 			params.m_pMeshRenderResources = pParams->m_pStaticMeshRenderResources;
 			params.m_pSpotLightShadowMaps = m_pActiveShadowMaps;
-			params.m_pRenderCommandBuffer = m_pStaticMeshCommandBuffer;
-			params.m_FirstRenderCommand = commandRange.m_FirstCommand;
-			params.m_NumRenderCommands = commandRange.m_NumCommands;
+			params.m_SpotLightShadowMapState = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+			params.m_pRenderCommandBuffer = m_pShadowCasterCommandBuffer;
+			params.m_pRenderCommandRanges = m_DynamicMeshCommandRanges.data();
 			params.m_SpotLightIndex = shadowMapIndex;
 			params.m_ShadowMapIndex = it;
+			params.m_ShadowMapSize = shadowMapTile.m_Size;
+			params.m_ClearShadowMap = false;
 
 			m_pRenderSpotLightShadowMapPass->Record(&params);
 		}
@@ -75,6 +203,7 @@ void SpotLightShadowMapRenderer::Record(RenderParams* pParams)
 			params.m_pExpShadowMaps = m_pSpotLightShadowMaps;
 			params.m_StandardShadowMapIndex = it;
 			params.m_ExpShadowMapIndex = shadowMapIndex;
+			params.m_ExpShadowMapTile = shadowMapTile;
 
 			m_pCreateExpShadowMapPass->Record(&params);
 		}
@@ -83,7 +212,7 @@ void SpotLightShadowMapRenderer::Record(RenderParams* pParams)
 			params.m_pRenderEnv = pParams->m_pRenderEnv;
 			params.m_pCommandList = pCommandList;
 			params.m_pExpShadowMaps = m_pSpotLightShadowMaps;
-			params.m_ExpShadowMapIndex = shadowMapIndex;
+			params.m_ExpShadowMapTile = shadowMapTile;
 			params.m_IntermediateResultIndex = it;
 
 			m_pFilterExpShadowMapPass->Record(&params);
@@ -92,9 +221,72 @@ void SpotLightShadowMapRenderer::Record(RenderParams* pParams)
 		m_SpotLightShadowMapStates[shadowMapIndex] = ShadowMapState::UpToDate;
 	}
 
+	if (numOutdatedShadowMaps > 0)
+	{
+		const ResourceTransitionBarrier resourceBarrier(m_pSpotLightShadowMaps,
+			m_pFilterExpShadowMapPass->GetOutputResourceStates()->m_ExpShadowMapsState, m_OutputResourceStates.m_SpotLightShadowMapsState);
+		pCommandList->ResourceBarrier(1, &resourceBarrier);
+	}
+
 	pCommandList->End();
 }
 
+void SpotLightShadowMapRenderer::RenderStaticShadowMap(RenderParams* pParams, u32 lightIndex, u32 shadowMapSize)
+{
+	RenderSpotLightShadowMapPass::RenderParams params;
+	params.m_pRenderEnv = pParams->m_pRenderEnv;
+	params.m_pCommandList = pParams->m_pCommandList;
+	params.m_pMeshRenderResources = pParams->m_pStaticMeshRenderResources;
+	params.m_pSpotLightShadowMaps = m_pStaticShadowMaps;
+	params.m_SpotLightShadowMapState = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	params.m_pRenderCommandBuffer = m_pShadowCasterCommandBuffer;
+	params.m_pRenderCommandRanges = &m_StaticMeshCommandRanges[lightIndex * m_NumStaticMeshTypes];
+	params.m_SpotLightIndex = lightIndex;
+	params.m_ShadowMapIndex = lightIndex;
+	params.m_ShadowMapSize = shadowMapSize;
+	params.m_ClearShadowMap = true;
+
+	m_pRenderSpotLightShadowMapPass->Record(&params);
+}
+
+void SpotLightShadowMapRenderer::CopyStaticShadowMap(RenderParams* pParams, u32 lightIndex, u32 activeShadowMapIndex)
+{
+	CommandList* pCommandList = pParams->m_pCommandList;
+
+	const ResourceTransitionBarrier preCopyBarriers[] =
+	{
+		ResourceTransitionBarrier(m_pStaticShadowMaps,
+			D3D12_RESOURCE_STATE_DEPTH_WRITE,
+			D3D12_RESOURCE_STATE_COPY_SOURCE,
+			lightIndex),
+
+		ResourceTransitionBarrier(m_pActiveShadowMaps,
+			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			activeShadowMapIndex)
+	};
+	pCommandList->ResourceBarrier(ARRAYSIZE(preCopyBarriers), preCopyBarriers);
+
+	// Shadow maps have a single mip level, so subresource index matches array slice index.
+	const TextureCopyLocation destLocation(m_pActiveShadowMaps, activeShadowMapIndex);
+	const TextureCopyLocation sourceLocation(m_pStaticShadowMaps, lightIndex);
+	pCommandList->CopyTextureRegion(&destLocation, 0, 0, 0, &sourceLocation, nullptr);
+
+	const ResourceTransitionBarrier postCopyBarriers[] =
+	{
+		ResourceTransitionBarrier(m_pStaticShadowMaps,
+			D3D12_RESOURCE_STATE_COPY_SOURCE,
+			D3D12_RESOURCE_STATE_DEPTH_WRITE,
+			lightIndex),
+
+		ResourceTransitionBarrier(m_pActiveShadowMaps,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_DEPTH_WRITE,
+			activeShadowMapIndex)
+	};
+	pCommandList->ResourceBarrier(ARRAYSIZE(postCopyBarriers), postCopyBarriers);
+}
+
 void SpotLightShadowMapRenderer::InitResources(InitParams* pParams)
 {
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
@@ -106,32 +298,64 @@ void SpotLightShadowMapRenderer::InitResources(InitParams* pParams)
 		true/*createDSV*/, true/*createSRV*/, 1/*mipLevels*/, pParams->m_MaxNumActiveSpotLights/*arraySize*/);
 	m_pActiveShadowMaps = new DepthTexture(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &activeShadowMapsDesc,
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, &optimizedClearDepth, L"SpotLightShadowMapRenderer::m_pActiveShadowMaps");
+
+	// Static shadow maps are never read by shaders, so they stay in depth write state between the copies.
+	assert(m_pStaticShadowMaps == nullptr);
+	DepthTexture2DDesc staticShadowMapsDesc(DXGI_FORMAT_R32_TYPELESS, pParams->m_ShadowMapSize, pParams->m_ShadowMapSize,
+		true/*createDSV*/, false/*createSRV*/, 1/*mipLevels*/, pParams->m_NumSpotLights/*arraySize*/);
+	m_pStaticShadowMaps = new DepthTexture(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &staticShadowMapsDesc,
+		D3D12_RESOURCE_STATE_DEPTH_WRITE, &optimizedClearDepth, L"SpotLightShadowMapRenderer::m_pStaticShadowMaps");
 	
 	assert(m_pSpotLightShadowMaps == nullptr);
-	ColorTexture2DDesc shadowMapsDesc(DXGI_FORMAT_R32_FLOAT, pParams->m_ShadowMapSize, pParams->m_ShadowMapSize,
-		false/*createRTV*/, true/*createSRV*/, true/*createUAV*/, 1/*mipLevels*/, pParams->m_NumSpotLights/*arraySize*/);
+	ColorTexture2DDesc shadowMapsDesc(DXGI_FORMAT_R32_FLOAT, pParams->m_ShadowMapAtlasSize, pParams->m_ShadowMapAtlasSize,
+		false/*createRTV*/, true/*createSRV*/, true/*createUAV*/);
 	m_pSpotLightShadowMaps = new ColorTexture(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &shadowMapsDesc,
 		pParams->m_InputResourceStates.m_SpotLightShadowMapsState, nullptr/*optimizedClearColor*/, L"SpotLightShadowMapRenderer::m_pShadowMaps");
 
+	// Make sure all the active lights can get shadow maps of max size.
+	assert(pParams->m_MaxNumActiveSpotLights * pParams->m_ShadowMapSize * pParams->m_ShadowMapSize <=
+		pParams->m_ShadowMapAtlasSize * pParams->m_ShadowMapAtlasSize);
+
+	assert(m_pShadowMapAtlas == nullptr);
+	m_pShadowMapAtlas = new ShadowMapAtlas(pParams->m_ShadowMapAtlasSize, pParams->m_MinShadowMapSize,
+		pParams->m_ShadowMapSize, pParams->m_NumSpotLights);
+
 	m_SpotLightShadowMapStates.resize(pParams->m_NumSpotLights);
+	m_StaticShadowMapStates.resize(pParams->m_NumSpotLights);
+	m_StaticShadowMapSizes.resize(pParams->m_NumSpotLights, 0);
 	for (u32 lightIndex = 0; lightIndex < pParams->m_NumSpotLights; ++lightIndex)
+	{
 		m_SpotLightShadowMapStates[lightIndex] = ShadowMapState::Outdated;
+		m_StaticShadowMapStates[lightIndex] = ShadowMapState::Outdated;
+	}
 	m_OutdatedSpotLightShadowMapIndices.resize(pParams->m_MaxNumActiveSpotLights);
 
-	assert(pParams->m_NumStaticMeshTypes == 1);
-	u32 staticMeshType = 0;
-	MeshBatch* pStaticMeshBatch = pParams->m_ppStaticMeshBatches[staticMeshType];
+	const MeshRenderResources* pStaticMeshRenderResources = pParams->m_pStaticMeshRenderResources;
+	assert(pParams->m_NumStaticMeshTypes == pStaticMeshRenderResources->GetNumMeshTypes());
+	m_NumStaticMeshTypes = pParams->m_NumStaticMeshTypes;
 
-	const u32 numMeshes = pStaticMeshBatch->GetNumMeshes();
-	const MeshInfo* meshInfos = pStaticMeshBatch->GetMeshInfos();
-	const AxisAlignedBox* meshInstanceWorldAABBs = pStaticMeshBatch->GetMeshInstanceWorldAABBs();
+	std::vector<std::vector<u32>> staticMeshInstanceIndices(m_NumStaticMeshTypes);
+	std::vector<std::vector<u32>>& dynamicMeshInstanceIndices = m_DynamicMeshInstanceIndices;
+	dynamicMeshInstanceIndices.resize(m_NumStaticMeshTypes);
+	m_DynamicMeshInstanceWorldAABBs.resize(m_NumStaticMeshTypes);
+	for (u32 meshType = 0; meshType < m_NumStaticMeshTypes; ++meshType)
+	{
+		const MeshBatch* pMeshBatch = pParams->m_ppStaticMeshBatches[meshType];
+		pMeshBatch->ClassifyMeshInstances(&staticMeshInstanceIndices[meshType], &dynamicMeshInstanceIndices[meshType]);
+
+		for (const u32 instanceIndex : dynamicMeshInstanceIndices[meshType])
+			m_DynamicMeshInstanceWorldAABBs[meshType].push_back(pMeshBatch->GetMeshInstanceWorldAABBs()[instanceIndex]);
+	}
 
 	std::vector<u32> visibleMeshInstanceIndices;
-	std::vector<ShadowMapCommand> staticMeshCommands;
+	std::vector<ShadowMapCommand>& shadowCasterCommands = m_ShadowCasterCommands;
+	assert(shadowCasterCommands.empty());
 	assert(m_StaticMeshCommandRanges.empty());
+	m_StaticMeshCommandRanges.resize(pParams->m_NumSpotLights * m_NumStaticMeshTypes);
 
 	std::vector<Matrix4f> spotLightViewProjMatrices(pParams->m_NumSpotLights);
 	std::vector<CreateExpShadowMapParams> createExpShadowMapParams(pParams->m_NumSpotLights);
+	m_SpotLightWorldFrustums.reserve(pParams->m_NumSpotLights);
 	
 	for (u32 lightIndex = 0; lightIndex < pParams->m_NumSpotLights; ++lightIndex)
 	{
@@ -149,44 +373,35 @@ void SpotLightShadowMapRenderer::InitResources(InitParams* pParams)
 		createExpShadowMapParams[lightIndex].m_LightRcpViewClipRange = Rcp(pLight->GetRange() - pLight->GetShadowNearPlane());
 		createExpShadowMapParams[lightIndex].m_ExpShadowMapConstant = pLight->GetExpShadowMapConstant();
 
-		const Frustum lightWorldFrustum(viewProjMatrix);
-
-		CommandRange commandRange;
-		commandRange.m_FirstCommand = staticMeshCommands.size();
-		commandRange.m_NumCommands = 0;
+		m_SpotLightWorldFrustums.emplace_back(viewProjMatrix);
+		const Frustum& lightWorldFrustum = m_SpotLightWorldFrustums.back();
 
-		for (u32 meshIndex = 0; meshIndex < numMeshes; ++meshIndex)
+		for (u32 meshType = 0; meshType < m_NumStaticMeshTypes; ++meshType)
 		{
-			u32 numVisibleMeshInstances = 0;
+			ShadowMapCommandRange& commandRange = m_StaticMeshCommandRanges[lightIndex * m_NumStaticMeshTypes + meshType];
+			commandRange.m_FirstCommand = shadowCasterCommands.size();
 
-			const MeshInfo& meshInfo = meshInfos[meshIndex];
-			const u32 meshLastInstanceIndex = meshInfo.m_InstanceOffset + meshInfo.m_InstanceCount;
-
-			for (u32 meshInstanceIndex = meshInfo.m_InstanceOffset; meshInstanceIndex < meshLastInstanceIndex; ++meshInstanceIndex)
-			{
-				const AxisAlignedBox& meshInstanceWorldAABB = meshInstanceWorldAABBs[meshInstanceIndex];
-				if (TestAABBAgainstFrustum(lightWorldFrustum, meshInstanceWorldAABB))
-				{
-					++numVisibleMeshInstances;
-					visibleMeshInstanceIndices.push_back(meshInstanceIndex);
-				}
-			}
-			if (numVisibleMeshInstances > 0)
-			{
-				ShadowMapCommand shadowMapCommand;
-				shadowMapCommand.m_InstanceOffset = visibleMeshInstanceIndices.size() - numVisibleMeshInstances;
-				shadowMapCommand.m_Args.m_IndexCountPerInstance = meshInfo.m_IndexCount;
-				shadowMapCommand.m_Args.m_InstanceCount = numVisibleMeshInstances;
-				shadowMapCommand.m_Args.m_StartIndexLocation = meshInfo.m_StartIndexLocation;
-				shadowMapCommand.m_Args.m_BaseVertexLocation = meshInfo.m_BaseVertexLocation;
-				shadowMapCommand.m_Args.m_StartInstanceLocation = 0;
-
-				staticMeshCommands.push_back(shadowMapCommand);
-			}
+			GenerateShadowCasterCommands(pParams->m_ppStaticMeshBatches[meshType], pStaticMeshRenderResources, meshType,
+				staticMeshInstanceIndices[meshType], &lightWorldFrustum, visibleMeshInstanceIndices,
+				shadowCasterCommands, m_ShadowCasterCommandMeshIndices, m_ShadowCasterCommandNumInstances);
+		
+			commandRange.m_NumCommands = UINT(shadowCasterCommands.size() - commandRange.m_FirstCommand);
 		}
+	}
+
+	// World bounds of dynamic shadow casters are not known in advance. Skip culling and let the rasterizer clip them.
+	assert(m_DynamicMeshCommandRanges.empty());
+	m_DynamicMeshCommandRanges.resize(m_NumStaticMeshTypes);
+	for (u32 meshType = 0; meshType < m_NumStaticMeshTypes; ++meshType)
+	{
+		ShadowMapCommandRange& commandRange = m_DynamicMeshCommandRanges[meshType];
+		commandRange.m_FirstCommand = shadowCasterCommands.size();
+
+		GenerateShadowCasterCommands(pParams->m_ppStaticMeshBatches[meshType], pStaticMeshRenderResources, meshType,
+			dynamicMeshInstanceIndices[meshType], nullptr/*pLightWorldFrustum*/, visibleMeshInstanceIndices,
+			shadowCasterCommands, m_ShadowCasterCommandMeshIndices, m_ShadowCasterCommandNumInstances);
 
-		commandRange.m_NumCommands = staticMeshCommands.size() - commandRange.m_FirstCommand;
-		m_StaticMeshCommandRanges.push_back(commandRange);
+		commandRange.m_NumCommands = UINT(shadowCasterCommands.size() - commandRange.m_FirstCommand);
 	}
 
 	assert(m_pSpotLightViewProjMatrixBuffer == nullptr);
@@ -205,20 +420,20 @@ void SpotLightShadowMapRenderer::InitResources(InitParams* pParams)
 	UploadData(pRenderEnv, m_pCreateExpShadowMapParamsBuffer, createExpShadowMapParamsBufferDesc,
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, createExpShadowMapParams.data(), createExpShadowMapParams.size() * sizeof(createExpShadowMapParams[0]));
 
-	assert(m_pStaticMeshCommandBuffer == nullptr);
-	StructuredBufferDesc staticMeshCommandBufferDesc(staticMeshCommands.size(), sizeof(staticMeshCommands[0]), false/*createSRV*/, false/*createUAV*/);
-	m_pStaticMeshCommandBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &staticMeshCommandBufferDesc,
-		D3D12_RESOURCE_STATE_COPY_DEST, L"SpotLightShadowMapRenderer::m_pStaticMeshCommandBuffer");
+	assert(m_pShadowCasterCommandBuffer == nullptr);
+	StructuredBufferDesc shadowCasterCommandBufferDesc(shadowCasterCommands.size(), sizeof(shadowCasterCommands[0]), false/*createSRV*/, false/*createUAV*/);
+	m_pShadowCasterCommandBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &shadowCasterCommandBufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, L"SpotLightShadowMapRenderer::m_pShadowCasterCommandBuffer");
 
-	UploadData(pRenderEnv, m_pStaticMeshCommandBuffer, staticMeshCommandBufferDesc,
-		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, staticMeshCommands.data(), staticMeshCommands.size() * sizeof(staticMeshCommands[0]));
+	UploadData(pRenderEnv, m_pShadowCasterCommandBuffer, shadowCasterCommandBufferDesc,
+		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, shadowCasterCommands.data(), shadowCasterCommands.size() * sizeof(shadowCasterCommands[0]));
 
-	assert(m_pStaticMeshInstanceIndexBuffer == nullptr);
-	FormattedBufferDesc staticMeshInstanceIndexBufferDesc(visibleMeshInstanceIndices.size(), DXGI_FORMAT_R32_UINT, true/*createSRV*/, false/*createUAV*/);
-	m_pStaticMeshInstanceIndexBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &staticMeshInstanceIndexBufferDesc,
-		D3D12_RESOURCE_STATE_COPY_DEST, L"SpotLightShadowMapRenderer::m_pStaticMeshInstanceIndexBuffer");
+	assert(m_pShadowCasterInstanceIndexBuffer == nullptr);
+	FormattedBufferDesc shadowCasterInstanceIndexBufferDesc(visibleMeshInstanceIndices.size(), DXGI_FORMAT_R32_UINT, true/*createSRV*/, false/*createUAV*/);
+	m_pShadowCasterInstanceIndexBuffer = new Buffer(pRenderEnv, pRenderEnv->m_pDefaultHeapProps, &shadowCasterInstanceIndexBufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, L"SpotLightShadowMapRenderer::m_pShadowCasterInstanceIndexBuffer");
 
-	UploadData(pRenderEnv, m_pStaticMeshInstanceIndexBuffer, staticMeshInstanceIndexBufferDesc,
+	UploadData(pRenderEnv, m_pShadowCasterInstanceIndexBuffer, shadowCasterInstanceIndexBufferDesc,
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, visibleMeshInstanceIndices.data(), visibleMeshInstanceIndices.size() * sizeof(visibleMeshInstanceIndices[0]));
 }
 
@@ -236,8 +451,8 @@ void SpotLightShadowMapRenderer::InitRenderSpotLightShadowMapPass(InitParams* pP
 	params.m_InputResourceStates.m_SpotLightShadowMapsState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
 		
 	params.m_pMeshRenderResources = pParams->m_pStaticMeshRenderResources;
-	params.m_pRenderCommandBuffer = m_pStaticMeshCommandBuffer;
-	params.m_pMeshInstanceIndexBuffer = m_pStaticMeshInstanceIndexBuffer;
+	params.m_pRenderCommandBuffer = m_pShadowCasterCommandBuffer;
+	params.m_pMeshInstanceIndexBuffer = m_pShadowCasterInstanceIndexBuffer;
 	params.m_pMeshInstanceWorldMatrixBuffer = pParams->m_pStaticMeshRenderResources->GetInstanceWorldMatrixBuffer();
 	params.m_pSpotLightViewProjMatrixBuffer = m_pSpotLightViewProjMatrixBuffer;
 	params.m_pSpotLightShadowMaps = m_pActiveShadowMaps;
@@ -258,7 +473,7 @@ void SpotLightShadowMapRenderer::InitCreateExpShadowMapPass(InitParams* pParams)
 	
 	params.m_InputResourceStates.m_StandardShadowMapsState = pRenderSpotLightShadowMapPassStates->m_SpotLightShadowMapsState;
 	params.m_InputResourceStates.m_CreateExpShadowMapParamsBufferState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-	params.m_InputResourceStates.m_ExpShadowMapsState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	params.m_InputResourceStates.m_ExpShadowMapsState = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
 	
 	params.m_pStandardShadowMaps = m_pActiveShadowMaps;
 	params.m_pCreateExpShadowMapParamsBuffer = m_pCreateExpShadowMapParamsBuffer;
@@ -279,7 +494,72 @@ void SpotLightShadowMapRenderer::InitFilterExpShadowMapPass(InitParams* pParams)
 	params.m_pRenderEnv = pParams->m_pRenderEnv;
 	params.m_InputResourceStates.m_ExpShadowMapsState = pCreateExpShadowMapPassStates->m_ExpShadowMapsState;
 	params.m_MaxNumActiveExpShadowMaps = pParams->m_MaxNumActiveSpotLights;
+	params.m_MaxExpShadowMapSize = pParams->m_ShadowMapSize;
 	params.m_pExpShadowMaps = m_pSpotLightShadowMaps;
 
 	m_pFilterExpShadowMapPass = new FilterExpShadowMapPass(&params);
-}
\ No newline at end of file
+}
+
+namespace
+{
+	void GenerateShadowCasterCommands(const MeshBatch* pMeshBatch, const MeshRenderResources* pMeshRenderResources, u32 meshType,
+		const std::vector<u32>& shadowCasterInstanceIndices, const Frustum* pLightWorldFrustum, std::vector<u32>& visibleMeshInstanceIndices,
+		std::vector<ShadowMapCommand>& shadowMapCommands, std::vector<u32>& commandMeshIndices, std::vector<u32>& commandNumInstances)
+	{
+		const MeshInfo* meshInfos = pMeshBatch->GetMeshInfos();
+		const AxisAlignedBox* meshInstanceWorldAABBs = pMeshBatch->GetMeshInstanceWorldAABBs();
+		const u32 instanceOffset = pMeshRenderResources->GetMeshTypeInstanceOffset(meshType);
+		const u32 meshTypeOffset = pMeshRenderResources->GetMeshTypeOffset(meshType);
+
+		// Draw arguments come from the mesh render resources, which know where the geometry of the mesh is resident.
+		auto addShadowMapCommand = [&](u32 meshIndex, u32 numVisibleMeshInstances)
+		{
+			if (numVisibleMeshInstances == 0)
+				return;
+
+			ShadowMapCommand shadowMapCommand;
+			shadowMapCommand.m_InstanceOffset = visibleMeshInstanceIndices.size() - numVisibleMeshInstances;
+			SetShadowMapCommandArgs(pMeshRenderResources->GetMeshRenderInfo(meshTypeOffset + meshIndex), numVisibleMeshInstances, &shadowMapCommand.m_Args);
+
+			shadowMapCommands.push_back(shadowMapCommand);
+			commandMeshIndices.push_back(meshTypeOffset + meshIndex);
+			commandNumInstances.push_back(numVisibleMeshInstances);
+		};
+
+		// Instance indices are sorted and instances of the same mesh are stored contiguously,
+		// so walking the meshes in lockstep with the instances is enough to group them per mesh.
+		// Instances of the mesh batch start at instanceOffset in the instance buffers shared by all mesh types.
+		u32 meshIndex = 0;
+		u32 numVisibleMeshInstances = 0;
+
+		for (const u32 meshInstanceIndex : shadowCasterInstanceIndices)
+		{
+			while (meshInstanceIndex >= meshInfos[meshIndex].m_InstanceOffset + meshInfos[meshIndex].m_InstanceCount)
+			{
+				addShadowMapCommand(meshIndex, numVisibleMeshInstances);
+				numVisibleMeshInstances = 0;
+				++meshIndex;
+			}
+
+			if ((pLightWorldFrustum == nullptr) || TestAABBAgainstFrustum(*pLightWorldFrustum, meshInstanceWorldAABBs[meshInstanceIndex]))
+			{
+				++numVisibleMeshInstances;
+				visibleMeshInstanceIndices.push_back(instanceOffset + meshInstanceIndex);
+			}
+		}
+		if (!shadowCasterInstanceIndices.empty())
+			addShadowMapCommand(meshIndex, numVisibleMeshInstances);
+	}
+
+	void SetShadowMapCommandArgs(const MeshRenderInfo& meshInfo, u32 numVisibleMeshInstances, DrawIndexedArguments* pArgs)
+	{
+		// Meshes which are not resident keep their command with zero instances, so that the command ranges do not change.
+		const bool isResident = (meshInfo.m_NumInstances > 0);
+
+		pArgs->m_IndexCountPerInstance = meshInfo.m_IndexCountPerInstance;
+		pArgs->m_InstanceCount = isResident ? numVisibleMeshInstances : 0;
+		pArgs->m_StartIndexLocation = meshInfo.m_StartIndexLocation;
+		pArgs->m_BaseVertexLocation = meshInfo.m_BaseVertexLocation;
+		pArgs->m_StartInstanceLocation = 0;
+	}
+}
@@ -34,6 +34,7 @@ TiledShadingPass::~TiledShadingPass()
 
 void TiledShadingPass::Record(RenderParams* pParams)
 {
+	// Shading mesh type of MaterialRenderResources. All vertex format mesh types share it.
 	const UINT meshType = 0;
 	const UINT numMeshTypes = 1;
 	assert(meshType == 0);
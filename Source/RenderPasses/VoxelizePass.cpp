@@ -44,7 +44,8 @@ VoxelizePass::VoxelizePass(InitParams* pParams)
 VoxelizePass::~VoxelizePass()
 {
 	SafeDelete(m_pCommandSignature);
-	SafeDelete(m_pPipelineState);
+	for (PipelineState* pPipelineState : m_PipelineStates)
+		SafeDelete(pPipelineState);
 	SafeDelete(m_pRootSignature);
 	SafeDelete(m_pVoxelReflectanceTexture);
 	SafeDelete(m_pViewport);
@@ -53,18 +54,16 @@ VoxelizePass::~VoxelizePass()
 void VoxelizePass::Record(RenderParams* pParams)
 {
 #ifdef ENABLE_VOXELIZATION
-	assert(m_pPipelineState != nullptr);
 	assert(m_pRootSignature != nullptr);
 
 	MeshRenderResources* pMeshRenderResources = pParams->m_pMeshRenderResources;
-	assert(pMeshRenderResources->GetNumMeshTypes() == 1);
-	const u32 meshType = 0;
+	assert(pMeshRenderResources->GetNumMeshTypes() == m_PipelineStates.size());
 
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
 	CommandList* pCommandList = pParams->m_pCommandList;
 	GPUProfiler* pGPUProfiler = pRenderEnv->m_pGPUProfiler;
 
-	pCommandList->Begin(m_pPipelineState);
+	pCommandList->Begin(m_PipelineStates[0]);
 #ifdef ENABLE_PROFILING
 	u32 profileIndex = pGPUProfiler->StartProfile(pCommandList, "VoxelizePass");
 #endif // ENABLE_PROFILING
@@ -84,16 +83,24 @@ void VoxelizePass::Record(RenderParams* pParams)
 	pCommandList->SetGraphicsRootDescriptorTable(kRootSRVTableParamVS, m_SRVHeapStartVS);
 	pCommandList->SetGraphicsRootDescriptorTable(kRootSRVTableParamPS, m_SRVHeapStartPS);
 		
-	pCommandList->IASetPrimitiveTopology(pMeshRenderResources->GetPrimitiveTopology(meshType));
-	pCommandList->IASetVertexBuffers(0, 1, pMeshRenderResources->GetVertexBuffer(meshType)->GetVBView());
-	pCommandList->IASetIndexBuffer(pMeshRenderResources->GetIndexBuffer(meshType)->GetIBView());
-	
 	Rect scissorRect(ExtractRect(m_pViewport));
 	pCommandList->RSSetViewports(1, m_pViewport);
 	pCommandList->RSSetScissorRects(1, &scissorRect);
 	
-	pCommandList->ExecuteIndirect(m_pCommandSignature, pMeshRenderResources->GetTotalNumMeshes(),
-		pParams->m_pVoxelizeCommandBuffer, 0, pParams->m_pNumCommandsPerMeshTypeBuffer, meshType * sizeof(u32));
+	// Voxelize commands of each mesh type start at the mesh type offset and their count is at the mesh type index.
+	for (u32 meshType = 0; meshType < pMeshRenderResources->GetNumMeshTypes(); ++meshType)
+	{
+		if (meshType > 0)
+			pCommandList->SetPipelineState(m_PipelineStates[meshType]);
+
+		pCommandList->IASetPrimitiveTopology(pMeshRenderResources->GetPrimitiveTopology(meshType));
+		pCommandList->IASetVertexBuffers(0, 1, pMeshRenderResources->GetVertexBuffer(meshType)->GetVBView());
+		pCommandList->IASetIndexBuffer(pMeshRenderResources->GetIndexBuffer(meshType)->GetIBView());
+
+		pCommandList->ExecuteIndirect(m_pCommandSignature, pMeshRenderResources->GetNumMeshes(meshType),
+			pParams->m_pVoxelizeCommandBuffer, pMeshRenderResources->GetMeshTypeOffset(meshType) * sizeof(DrawCommand),
+			pParams->m_pNumCommandsPerMeshTypeBuffer, meshType * sizeof(u32));
+	}
 
 #ifdef ENABLE_PROFILING
 	pGPUProfiler->EndProfile(pCommandList, profileIndex);
@@ -183,6 +190,10 @@ void VoxelizePass::InitResources(InitParams* pParams)
 	pRenderEnv->m_pDevice->CopyDescriptor(pRenderEnv->m_pShaderVisibleSRVHeap->Allocate(),
 		pParams->m_pInstanceWorldMatrixBuffer->GetSRVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+	// Stays in the shader resource state for the lifetime of the mesh render resources.
+	pRenderEnv->m_pDevice->CopyDescriptor(pRenderEnv->m_pShaderVisibleSRVHeap->Allocate(),
+		pParams->m_pMeshRenderResources->GetInstanceVertexQuantizationBuffer()->GetSRVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
 	m_SRVHeapStartPS = pRenderEnv->m_pShaderVisibleSRVHeap->Allocate();
 	pRenderEnv->m_pDevice->CopyDescriptor(m_SRVHeapStartPS,
 		m_pVoxelReflectanceTexture->GetUAVHandle(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
@@ -218,7 +229,7 @@ void VoxelizePass::InitRootSignature(InitParams* pParams)
 	rootParams[kRootCBVParamAll] = RootCBVParameter(0, D3D12_SHADER_VISIBILITY_ALL);
 	rootParams[kRoot32BitConstantsParamVS] = Root32BitConstantsParameter(1, D3D12_SHADER_VISIBILITY_VERTEX, 1);
 
-	std::vector<D3D12_DESCRIPTOR_RANGE> srvRangesVS = {SRVDescriptorRange(2, 0)};
+	std::vector<D3D12_DESCRIPTOR_RANGE> srvRangesVS = {SRVDescriptorRange(3, 0)};
 	rootParams[kRootSRVTableParamVS] = RootDescriptorTableParameter((UINT)srvRangesVS.size(), srvRangesVS.data(), D3D12_SHADER_VISIBILITY_VERTEX);
 			
 	rootParams[kRoot32BitConstantsParamPS] = Root32BitConstantsParameter(1, D3D12_SHADER_VISIBILITY_PIXEL, 1);
@@ -244,47 +255,49 @@ void VoxelizePass::InitPipelineState(InitParams* pParams)
 {
 #ifdef ENABLE_VOXELIZATION
 	assert(m_pRootSignature != nullptr);
-	assert(m_pPipelineState == nullptr);
+	assert(m_PipelineStates.empty());
 	
 	RenderEnv* pRenderEnv = pParams->m_pRenderEnv;
-
 	const MeshRenderResources* pMeshRenderResources = pParams->m_pMeshRenderResources;
-	assert(pMeshRenderResources->GetNumMeshTypes() == 1);
-	const u32 meshType = 0;
 
-	std::string enableSpotLightsStr = std::to_string(pParams->m_EnableSpotLights ? 1 : 0);
-	std::string enableDirectionalLightStr = std::to_string(pParams->m_EnableDirectionalLight ? 1 : 0);
-	std::string numMaterialsStr = std::to_string(pParams->m_NumMaterialTextures);
+	std::wstring enableSpotLightsStr = std::to_wstring(pParams->m_EnableSpotLights ? 1 : 0);
+	std::wstring enableDirectionalLightStr = std::to_wstring(pParams->m_EnableDirectionalLight ? 1 : 0);
+	std::wstring numMaterialsStr = std::to_wstring(pParams->m_NumMaterialTextures);
 
-	const ShaderMacro shaderDefinesPS[] =
+	const ShaderDefine shaderDefinesPS[] =
 	{
-		ShaderMacro("ENABLE_SPOT_LIGHTS", enableSpotLightsStr.c_str()),
-		ShaderMacro("ENABLE_DIRECTIONAL_LIGHT", enableDirectionalLightStr.c_str()),
-		ShaderMacro("NUM_MATERIAL_TEXTURES", numMaterialsStr.c_str()),
-		ShaderMacro()
+		ShaderDefine(L"ENABLE_SPOT_LIGHTS", enableSpotLightsStr.c_str()),
+		ShaderDefine(L"ENABLE_DIRECTIONAL_LIGHT", enableDirectionalLightStr.c_str()),
+		ShaderDefine(L"NUM_MATERIAL_TEXTURES", numMaterialsStr.c_str())
 	};
 
-	Shader vertexShader(L"Shaders//VoxelizeVS.hlsl", "Main", "vs_6_1");
-	Shader geometryShader(L"Shaders//VoxelizeGS.hlsl", "Main", "gs_6_1");
-	Shader pixelShader(L"Shaders//VoxelizePS.hlsl", "Main", "ps_6_1", shaderDefinesPS);
-
-	const InputLayoutDesc& inputLayout = pMeshRenderResources->GetInputLayout(meshType);
-	assert(inputLayout.NumElements == 3);
-	assert(HasVertexSemantic(inputLayout, "POSITION"));
-	assert(HasVertexSemantic(inputLayout, "NORMAL"));
-	assert(HasVertexSemantic(inputLayout, "TEXCOORD"));
-
-	GraphicsPipelineStateDesc pipelineStateDesc;
-	pipelineStateDesc.SetRootSignature(m_pRootSignature);
-	pipelineStateDesc.SetVertexShader(&vertexShader);
-	pipelineStateDesc.SetGeometryShader(&geometryShader);
-	pipelineStateDesc.SetPixelShader(&pixelShader);
-	pipelineStateDesc.DepthStencilState = DepthStencilDesc(DepthStencilDesc::Disabled);
-	pipelineStateDesc.RasterizerState = RasterizerDesc(RasterizerDesc::CullNoneConservative);
-	pipelineStateDesc.InputLayout = inputLayout;
-	pipelineStateDesc.PrimitiveTopologyType = pMeshRenderResources->GetPrimitiveTopologyType(meshType);
-
-	m_pPipelineState = new PipelineState(pRenderEnv->m_pDevice, &pipelineStateDesc, L"VoxelizePass::m_pPipelineState");
+	Shader geometryShader(L"Shaders//VoxelizeGS.hlsl", L"Main", L"gs_6_1");
+	Shader pixelShader(L"Shaders//VoxelizePS.hlsl", L"Main", L"ps_6_1", shaderDefinesPS, ARRAYSIZE(shaderDefinesPS));
+
+	// The vertex shader is compiled for the vertex format of each mesh type.
+	m_PipelineStates.resize(pMeshRenderResources->GetNumMeshTypes());
+	for (u32 meshType = 0; meshType < pMeshRenderResources->GetNumMeshTypes(); ++meshType)
+	{
+		const VertexDecodingDefines vertexDecodingDefines(pMeshRenderResources, meshType);
+		Shader vertexShader(L"Shaders//VoxelizeVS.hlsl", L"Main", L"vs_6_1",
+			vertexDecodingDefines.GetDefines(), vertexDecodingDefines.GetNumDefines());
+
+		const InputLayoutDesc& inputLayout = pMeshRenderResources->GetInputLayout(meshType);
+		assert(HasVertexSemantic(inputLayout, "POSITION"));
+		assert(HasVertexSemantic(inputLayout, "NORMAL"));
+
+		GraphicsPipelineStateDesc pipelineStateDesc;
+		pipelineStateDesc.SetRootSignature(m_pRootSignature);
+		pipelineStateDesc.SetVertexShader(&vertexShader);
+		pipelineStateDesc.SetGeometryShader(&geometryShader);
+		pipelineStateDesc.SetPixelShader(&pixelShader);
+		pipelineStateDesc.DepthStencilState = DepthStencilDesc(DepthStencilDesc::Disabled);
+		pipelineStateDesc.RasterizerState = RasterizerDesc(RasterizerDesc::CullNoneConservative);
+		pipelineStateDesc.InputLayout = inputLayout;
+		pipelineStateDesc.PrimitiveTopologyType = pMeshRenderResources->GetPrimitiveTopologyType(meshType);
+
+		m_PipelineStates[meshType] = new PipelineState(pRenderEnv->m_pDevice, &pipelineStateDesc, L"VoxelizePass::m_PipelineStates");
+	}
 #endif
 }
 
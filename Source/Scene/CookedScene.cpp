@@ -0,0 +1,313 @@
+#include "Scene/CookedScene.h"
+#include "Scene/Scene.h"
+
+namespace
+{
+	struct CookedCamera
+	{
+		Vector3f m_WorldPosition;
+		BasisAxes m_WorldOrientation;
+		f32 m_FovYInRadians;
+		f32 m_AspectRatio;
+		f32 m_NearClipDist;
+		f32 m_FarClipDist;
+		Vector3f m_MoveSpeed;
+		Vector3f m_RotationSpeed;
+	};
+
+	struct CookedPointLight
+	{
+		Vector3f m_WorldPosition;
+		Vector3f m_RadiantPower;
+		f32 m_Range;
+		f32 m_ShadowNearPlane;
+		f32 m_ExpShadowMapConstant;
+	};
+
+	struct CookedSpotLight
+	{
+		Vector3f m_WorldPosition;
+		BasisAxes m_WorldOrientation;
+		Vector3f m_RadiantPower;
+		f32 m_Range;
+		f32 m_InnerConeAngleInRadians;
+		f32 m_OuterConeAngleInRadians;
+		f32 m_ShadowNearPlane;
+		f32 m_ExpShadowMapConstant;
+	};
+
+	std::size_t AlignToBlock(std::size_t sizeInBytes);
+}
+
+CookedSceneWriter::CookedSceneWriter()
+{
+	CookedSceneHeader header;
+	header.m_Magic = kCookedSceneMagic;
+	header.m_Version = kCookedSceneVersion;
+	header.m_SizeInBytes = 0;
+
+	WriteValue(header);
+}
+
+void CookedSceneWriter::WriteString(const std::wstring& str)
+{
+	WriteArray(str.size(), str.data());
+}
+
+bool CookedSceneWriter::SaveToFile(const wchar_t* pFilePath)
+{
+	CookedSceneHeader* pHeader = (CookedSceneHeader*)m_Data.data();
+	pHeader->m_SizeInBytes = m_Data.size();
+
+	// The file is written under a temporary name first, so that an interrupted write does not leave a truncated file behind.
+	std::filesystem::path tempFilePath(pFilePath);
+	tempFilePath += L".tmp";
+	{
+		std::ofstream fileStream(tempFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!fileStream)
+			return false;
+
+		fileStream.write((const char*)m_Data.data(), m_Data.size());
+		if (!fileStream)
+			return false;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempFilePath, pFilePath, errorCode);
+
+	return !errorCode;
+}
+
+void CookedSceneWriter::WriteBlock(const void* pData, std::size_t sizeInBytes)
+{
+	const std::size_t offset = m_Data.size();
+	m_Data.resize(offset + AlignToBlock(sizeInBytes), 0);
+
+	if (sizeInBytes > 0)
+		std::memcpy(m_Data.data() + offset, pData, sizeInBytes);
+}
+
+CookedSceneReader::CookedSceneReader()
+	: m_Offset(0)
+	, m_Failed(false)
+{
+}
+
+bool CookedSceneReader::Open(const wchar_t* pFilePath)
+{
+	if (!m_File.Open(pFilePath))
+		return false;
+
+	m_FilePath = pFilePath;
+	m_Offset = 0;
+	m_Failed = false;
+
+	if (m_File.GetSizeInBytes() < sizeof(CookedSceneHeader))
+		return false;
+
+	const CookedSceneHeader& header = ReadValue<CookedSceneHeader>();
+	if (HasFailed() || (header.m_Magic != kCookedSceneMagic) || (header.m_Version != kCookedSceneVersion) || (header.m_SizeInBytes != m_File.GetSizeInBytes()))
+		return false;
+
+	return true;
+}
+
+bool CookedSceneReader::Seek(u64 offset)
+{
+	if (m_Failed || (offset > m_File.GetSizeInBytes()))
+		return false;
+
+	m_Offset = offset;
+	return true;
+}
+
+const std::wstring CookedSceneReader::ReadString()
+{
+	std::size_t length = 0;
+	const wchar_t* pFirstChar = ReadArray<wchar_t>(&length);
+
+	return std::wstring(pFirstChar, length);
+}
+
+const u8* CookedSceneReader::ReadBlock(u64 numElements, std::size_t elementSizeInBytes)
+{
+	if (m_Failed)
+		return nullptr;
+
+	// The element count comes from the file, so the size is checked without overflowing.
+	const u64 numRemainingBytes = m_File.GetSizeInBytes() - m_Offset;
+	if (numElements > numRemainingBytes / elementSizeInBytes)
+	{
+		m_Failed = true;
+		return nullptr;
+	}
+
+	const std::size_t sizeInBytes = std::size_t(numElements * elementSizeInBytes);
+	const u64 alignedSizeInBytes = Min(u64(AlignToBlock(sizeInBytes)), numRemainingBytes);
+
+	const u8* pBlock = m_File.GetData() + m_Offset;
+	m_Offset += alignedSizeInBytes;
+
+	return pBlock;
+}
+
+bool WriteCookedScene(const wchar_t* pFilePath, Scene* pScene)
+{
+	CookedSceneWriter writer;
+
+	Camera* pCamera = pScene->GetCamera();
+	writer.WriteValue(u32((pCamera != nullptr) ? 1 : 0));
+	if (pCamera != nullptr)
+	{
+		CookedCamera camera;
+		camera.m_WorldPosition = pCamera->GetWorldPosition();
+		camera.m_WorldOrientation = pCamera->GetWorldOrientation();
+		camera.m_FovYInRadians = pCamera->GetFieldOfViewY();
+		camera.m_AspectRatio = pCamera->GetAspectRatio();
+		camera.m_NearClipDist = pCamera->GetNearClipDistance();
+		camera.m_FarClipDist = pCamera->GetFarClipDistance();
+		camera.m_MoveSpeed = pCamera->GetMoveSpeed();
+		camera.m_RotationSpeed = pCamera->GetRotationSpeed();
+
+		writer.WriteValue(camera);
+	}
+
+	writer.WriteValue(u32(pScene->GetNumMeshBatches()));
+	std::vector<u64> geometryOffsets(pScene->GetNumMeshBatches());
+	for (std::size_t batchIndex = 0; batchIndex < pScene->GetNumMeshBatches(); ++batchIndex)
+		geometryOffsets[batchIndex] = pScene->GetMeshBatches()[batchIndex]->Serialize(&writer);
+
+	writer.WriteValue(u32(pScene->GetNumMaterials()));
+	for (std::size_t materialIndex = 0; materialIndex < pScene->GetNumMaterials(); ++materialIndex)
+	{
+		// Slots of removed materials are written without texture files, so that the material IDs are kept.
+		const Material* pMaterial = pScene->GetMaterials()[materialIndex];
+
+		writer.WriteString((pMaterial != nullptr) ? pMaterial->m_Name : std::wstring());
+		for (u32 textureIndex = 0; textureIndex < Material::NumTextures; ++textureIndex)
+			writer.WriteString((pMaterial != nullptr) ? pMaterial->m_FilePaths[textureIndex] : std::wstring());
+	}
+
+	DirectionalLight* pDirectionalLight = pScene->GetDirectionalLight();
+	writer.WriteValue(u32((pDirectionalLight != nullptr) ? 1 : 0));
+	if (pDirectionalLight != nullptr)
+		writer.WriteValue(*pDirectionalLight);
+
+	std::vector<CookedPointLight> pointLights(pScene->GetNumPointLights());
+	for (std::size_t lightIndex = 0; lightIndex < pointLights.size(); ++lightIndex)
+	{
+		const PointLight* pPointLight = pScene->GetPointLights()[lightIndex];
+		CookedPointLight& pointLight = pointLights[lightIndex];
+
+		pointLight.m_WorldPosition = pPointLight->GetWorldPosition();
+		pointLight.m_RadiantPower = pPointLight->GetRadiantPower();
+		pointLight.m_Range = pPointLight->GetRange();
+		pointLight.m_ShadowNearPlane = pPointLight->GetShadowNearPlane();
+		pointLight.m_ExpShadowMapConstant = pPointLight->GetExpShadowMapConstant();
+	}
+	writer.WriteArray(pointLights);
+
+	std::vector<CookedSpotLight> spotLights(pScene->GetNumSpotLights());
+	for (std::size_t lightIndex = 0; lightIndex < spotLights.size(); ++lightIndex)
+	{
+		const SpotLight* pSpotLight = pScene->GetSpotLights()[lightIndex];
+		CookedSpotLight& spotLight = spotLights[lightIndex];
+
+		spotLight.m_WorldPosition = pSpotLight->GetWorldPosition();
+		spotLight.m_WorldOrientation = pSpotLight->GetWorldOrientation();
+		spotLight.m_RadiantPower = pSpotLight->GetRadiantPower();
+		spotLight.m_Range = pSpotLight->GetRange();
+		spotLight.m_InnerConeAngleInRadians = pSpotLight->GetInnerConeAngle();
+		spotLight.m_OuterConeAngleInRadians = pSpotLight->GetOuterConeAngle();
+		spotLight.m_ShadowNearPlane = pSpotLight->GetShadowNearPlane();
+		spotLight.m_ExpShadowMapConstant = pSpotLight->GetExpShadowMapConstant();
+	}
+	writer.WriteArray(spotLights);
+
+	if (!writer.SaveToFile(pFilePath))
+		return false;
+
+	for (std::size_t batchIndex = 0; batchIndex < pScene->GetNumMeshBatches(); ++batchIndex)
+		pScene->GetMeshBatches()[batchIndex]->SetGeometrySource(pFilePath, geometryOffsets[batchIndex]);
+
+	return true;
+}
+
+Scene* LoadCookedScene(const wchar_t* pFilePath)
+{
+	CookedSceneReader reader;
+	if (!reader.Open(pFilePath))
+		return nullptr;
+
+	Scene* pScene = new Scene();
+
+	if (reader.ReadValue<u32>() != 0)
+	{
+		const CookedCamera& camera = reader.ReadValue<CookedCamera>();
+		pScene->SetCamera(new Camera(camera.m_WorldPosition, camera.m_WorldOrientation,
+			camera.m_FovYInRadians, camera.m_AspectRatio, camera.m_NearClipDist, camera.m_FarClipDist,
+			camera.m_MoveSpeed, camera.m_RotationSpeed));
+	}
+
+	// The counts come from the file, so the loops stop as soon as the reader fails.
+	const u32 numMeshBatches = reader.ReadValue<u32>();
+	for (u32 batchIndex = 0; (batchIndex < numMeshBatches) && !reader.HasFailed(); ++batchIndex)
+		pScene->AddMeshBatch(MeshBatch::Deserialize(&reader));
+
+	std::vector<Material*> removedMaterials;
+	const u32 numMaterials = reader.ReadValue<u32>();
+	for (u32 materialIndex = 0; (materialIndex < numMaterials) && !reader.HasFailed(); ++materialIndex)
+	{
+		Material* pMaterial = new Material(reader.ReadString());
+		for (u32 textureIndex = 0; textureIndex < Material::NumTextures; ++textureIndex)
+			pMaterial->m_FilePaths[textureIndex] = reader.ReadString();
+
+		pScene->AddMaterial(pMaterial);
+		if (pMaterial->m_FilePaths[0].empty())
+			removedMaterials.push_back(pMaterial);
+	}
+
+	// Slots of removed materials are restored once all the materials have their IDs.
+	for (Material* pMaterial : removedMaterials)
+	{
+		pScene->RemoveMaterial(pMaterial);
+		SafeDelete(pMaterial);
+	}
+
+	if (reader.ReadValue<u32>() != 0)
+		pScene->SetDirectionalLight(new DirectionalLight(reader.ReadValue<DirectionalLight>()));
+
+	std::size_t numPointLights = 0;
+	const CookedPointLight* pPointLights = reader.ReadArray<CookedPointLight>(&numPointLights);
+	for (std::size_t lightIndex = 0; lightIndex < numPointLights; ++lightIndex)
+	{
+		const CookedPointLight& pointLight = pPointLights[lightIndex];
+		pScene->AddPointLight(new PointLight(pointLight.m_WorldPosition, pointLight.m_RadiantPower,
+			pointLight.m_Range, pointLight.m_ShadowNearPlane, pointLight.m_ExpShadowMapConstant));
+	}
+
+	std::size_t numSpotLights = 0;
+	const CookedSpotLight* pSpotLights = reader.ReadArray<CookedSpotLight>(&numSpotLights);
+	for (std::size_t lightIndex = 0; lightIndex < numSpotLights; ++lightIndex)
+	{
+		const CookedSpotLight& spotLight = pSpotLights[lightIndex];
+		pScene->AddSpotLight(new SpotLight(spotLight.m_WorldPosition, spotLight.m_WorldOrientation, spotLight.m_RadiantPower,
+			spotLight.m_Range, spotLight.m_InnerConeAngleInRadians, spotLight.m_OuterConeAngleInRadians,
+			spotLight.m_ShadowNearPlane, spotLight.m_ExpShadowMapConstant));
+	}
+
+	if (reader.HasFailed())
+	{
+		SafeDelete(pScene);
+		return nullptr;
+	}
+	return pScene;
+}
+
+namespace
+{
+	std::size_t AlignToBlock(std::size_t sizeInBytes)
+	{
+		return (sizeInBytes + kCookedSceneBlockAlignment - 1) & ~std::size_t(kCookedSceneBlockAlignment - 1);
+	}
+}
\ No newline at end of file
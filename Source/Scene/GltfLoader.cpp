@@ -0,0 +1,1227 @@
+#include "Scene/GltfLoader.h"
+#include "Common/FileUtilities.h"
+#include "Common/ParallelFor.h"
+#include "Common/StringUtilities.h"
+#include "Math/Math.h"
+#include "Math/Transform.h"
+#include "Scene/Mesh.h"
+#include "Scene/MeshInstancing.h"
+#include "Scene/MeshOptimizer.h"
+#include "Scene/MeshProcessing.h"
+#include "Scene/Scene.h"
+#include <emmintrin.h>
+#include <cfloat>
+#include <numeric>
+
+namespace
+{
+	static const u32 kGlbMagic = 0x46546C67;
+	static const u32 kGlbVersion = 2;
+	static const u32 kGlbHeaderSize = 12;
+	static const u32 kGlbChunkHeaderSize = 8;
+	static const u32 kGlbChunkTypeJson = 0x4E4F534A;
+	static const u32 kGlbChunkTypeBinary = 0x004E4942;
+	static const u32 kMaxJsonDepth = 64;
+	static const u32 kNotFound = ~0u;
+
+	enum GltfComponentType
+	{
+		GltfComponentType_Byte = 5120,
+		GltfComponentType_UnsignedByte = 5121,
+		GltfComponentType_Short = 5122,
+		GltfComponentType_UnsignedShort = 5123,
+		GltfComponentType_UnsignedInt = 5125,
+		GltfComponentType_Float = 5126
+	};
+
+	enum GltfPrimitiveMode
+	{
+		GltfPrimitiveMode_Triangles = 4
+	};
+
+	struct JsonValue
+	{
+		enum Type
+		{
+			Type_Null,
+			Type_Bool,
+			Type_Number,
+			Type_String,
+			Type_Array,
+			Type_Object
+		};
+
+		Type m_Type = Type_Null;
+		bool m_Bool = false;
+		f64 m_Number = 0.0;
+		std::string m_String;
+		// Elements of the array or values of the object members.
+		std::vector<JsonValue> m_Elements;
+		// Names of the object members, parallel to m_Elements.
+		std::vector<std::string> m_MemberNames;
+	};
+
+	struct GltfDocument
+	{
+		JsonValue m_Root;
+		std::vector<std::unique_ptr<MemoryMappedFile>> m_BufferFiles;
+		std::vector<const u8*> m_Buffers;
+		std::vector<u64> m_BufferSizes;
+	};
+
+	// Elements of the accessor are m_Stride bytes apart and consist of m_NumComponents components of m_ComponentType.
+	struct GltfAccessor
+	{
+		const u8* m_pData = nullptr;
+		u32 m_Count = 0;
+		u32 m_Stride = 0;
+		u32 m_ComponentType = 0;
+		u32 m_NumComponents = 0;
+		bool m_Normalized = false;
+	};
+
+	// KHR_texture_transform: uv' = offset + rotation * (scale * uv).
+	struct GltfTexCoordTransform
+	{
+		f32 m_Offset[2] = {0.0f, 0.0f};
+		f32 m_Rotation = 0.0f;
+		f32 m_Scale[2] = {1.0f, 1.0f};
+	};
+
+	struct GltfPrimitive
+	{
+		GltfAccessor m_Positions;
+		GltfAccessor m_Normals;
+		GltfAccessor m_TexCoords;
+		GltfAccessor m_Indices;
+		u32 m_MaterialID = 0;
+		const std::vector<Matrix4f>* m_pInstanceWorldMatrices = nullptr;
+		const std::vector<u8>* m_pInstanceFlags = nullptr;
+		u32 m_FirstInstance = 0;
+		u32 m_NumInstances = 0;
+	};
+
+	const char* ParseJsonValue(const char* pText, const char* pEnd, u32 depth, JsonValue* pValue);
+	const char* ParseJsonString(const char* pText, const char* pEnd, std::string* pString);
+	const char* SkipJsonSpaces(const char* pText, const char* pEnd);
+	void AppendUtf8(u32 codePoint, std::string* pString);
+
+	const JsonValue* FindMember(const JsonValue* pObject, const char* pName);
+	const JsonValue* GetElement(const JsonValue* pArray, u32 index);
+	u32 GetNumElements(const JsonValue* pArray);
+	f64 GetNumber(const JsonValue* pObject, const char* pName, f64 defaultValue);
+	u32 GetIndex(const JsonValue* pObject, const char* pName);
+	const std::string GetString(const JsonValue* pObject, const char* pName);
+
+	bool LoadGltfBuffers(const std::filesystem::path& directoryPath, const u8* pBinaryChunk, u64 binaryChunkSize, GltfDocument* pDocument);
+	bool ReadAccessor(const GltfDocument& document, u32 accessorIndex, GltfAccessor* pAccessor);
+	void ConvertAccessor(const GltfAccessor& accessor, u32 numOutputComponents, f32* pOutput);
+	// Checks that the accessor has an index component type and that every index refers to one of the vertices.
+	bool ValidateIndices(const GltfAccessor& accessor, u32 numVertices);
+	u32 ReadIndex(const GltfAccessor& accessor, u32 index);
+	void ConvertIndices(const GltfAccessor& accessor, u32* pOutput);
+	template <typename T>
+	void ConvertComponents(const GltfAccessor& accessor, u32 firstElement, u32 numOutputComponents, f32 scale, f32 minValue, f32* pOutput);
+	template <typename T>
+	void ConvertSmallIntComponentsSSE2(const GltfAccessor& accessor, u32 numOutputComponents, f32 scale, f32 minValue, f32* pOutput);
+
+	void CollectMeshInstances(const JsonValue& root, const Matrix4f& worldMatrix, const DynamicObjectParams& dynamicObjectParams,
+		std::vector<std::vector<Matrix4f>>* pMeshInstanceWorldMatrices, std::vector<std::vector<u8>>* pMeshInstanceFlags);
+	const Matrix4f CalcNodeLocalMatrix(const JsonValue* pNode);
+	const GltfTexCoordTransform ReadTexCoordTransform(const JsonValue* pTextureInfo);
+	void AddGltfMaterials(Scene* pScene, const GltfDocument& document, const std::filesystem::path& filePath, bool addDefaultMaterial);
+	const std::wstring GetImageFilePath(const GltfDocument& document, const std::filesystem::path& filePath, u32 textureIndex);
+	const std::string DecodeUri(const std::string& uri);
+}
+
+Scene* LoadGltfFile(const wchar_t* pFilePath, const Matrix4f& worldMatrix, const MeshProcessingParams& meshProcessingParams,
+	const DynamicObjectParams& dynamicObjectParams)
+{
+	MemoryMappedFile file;
+	if (!file.Open(pFilePath))
+		return nullptr;
+
+	const u8* pFileData = file.GetData();
+	const u64 fileSize = file.GetSizeInBytes();
+
+	// GLB starts with the header and is followed by the JSON chunk and the optional binary chunk.
+	// Anything else is read as a .gltf JSON document.
+	const char* pJsonBegin = (const char*)pFileData;
+	const char* pJsonEnd = pJsonBegin + fileSize;
+	const u8* pBinaryChunk = nullptr;
+	u64 binaryChunkSize = 0;
+
+	u32 header[3] = {};
+	if (fileSize >= kGlbHeaderSize)
+		std::memcpy(header, pFileData, kGlbHeaderSize);
+
+	if (header[0] == kGlbMagic)
+	{
+		if ((header[1] != kGlbVersion) || (header[2] > fileSize))
+		{
+			OutputDebugStringA("Unsupported GLB file\n");
+			return nullptr;
+		}
+
+		for (u64 chunkOffset = kGlbHeaderSize; chunkOffset + kGlbChunkHeaderSize <= header[2]; )
+		{
+			u32 chunkHeader[2];
+			std::memcpy(chunkHeader, pFileData + chunkOffset, kGlbChunkHeaderSize);
+
+			const u64 chunkDataOffset = chunkOffset + kGlbChunkHeaderSize;
+			if (chunkDataOffset + chunkHeader[0] > header[2])
+				break;
+
+			if (chunkHeader[1] == kGlbChunkTypeJson)
+			{
+				pJsonBegin = (const char*)(pFileData + chunkDataOffset);
+				pJsonEnd = pJsonBegin + chunkHeader[0];
+			}
+			else if ((chunkHeader[1] == kGlbChunkTypeBinary) && (pBinaryChunk == nullptr))
+			{
+				pBinaryChunk = pFileData + chunkDataOffset;
+				binaryChunkSize = chunkHeader[0];
+			}
+			chunkOffset = chunkDataOffset + chunkHeader[0];
+		}
+	}
+
+	GltfDocument document;
+	if (ParseJsonValue(pJsonBegin, pJsonEnd, 0, &document.m_Root) == nullptr)
+	{
+		OutputDebugStringA("Failed to parse glTF JSON\n");
+		return nullptr;
+	}
+	const JsonValue* pRoot = &document.m_Root;
+
+	const JsonValue* pRequiredExtensions = FindMember(pRoot, "extensionsRequired");
+	for (u32 extensionIndex = 0; extensionIndex < GetNumElements(pRequiredExtensions); ++extensionIndex)
+	{
+		const std::string& extension = GetElement(pRequiredExtensions, extensionIndex)->m_String;
+		if ((extension != "KHR_mesh_quantization") && (extension != "KHR_texture_transform"))
+		{
+			const std::string message = "Unsupported glTF extension " + extension + "\n";
+			OutputDebugStringA(message.c_str());
+			return nullptr;
+		}
+	}
+
+	std::filesystem::path directoryPath(pFilePath);
+	directoryPath.remove_filename();
+
+	if (!LoadGltfBuffers(directoryPath, pBinaryChunk, binaryChunkSize, &document))
+	{
+		OutputDebugStringA("Failed to load glTF buffers\n");
+		return nullptr;
+	}
+
+	std::vector<std::vector<Matrix4f>> meshInstanceWorldMatrices;
+	std::vector<std::vector<u8>> meshInstanceFlags;
+	CollectMeshInstances(document.m_Root, worldMatrix, dynamicObjectParams, &meshInstanceWorldMatrices, &meshInstanceFlags);
+
+	const JsonValue* pMeshes = FindMember(pRoot, "meshes");
+	const JsonValue* pMaterials = FindMember(pRoot, "materials");
+	const u32 numMaterials = GetNumElements(pMaterials);
+
+	std::vector<GltfTexCoordTransform> texCoordTransforms(numMaterials + 1);
+	for (u32 materialIndex = 0; materialIndex < numMaterials; ++materialIndex)
+	{
+		const JsonValue* pMaterial = GetElement(pMaterials, materialIndex);
+		texCoordTransforms[materialIndex] = ReadTexCoordTransform(FindMember(FindMember(pMaterial, "pbrMetallicRoughness"), "baseColorTexture"));
+	}
+
+	// Primitives are appended to the mesh batches in order and written in parallel, as in the Assimp mesh conversion.
+	// Meshes with more instances than a mesh can have are appended several times, each time with the next range of instances.
+	std::vector<GltfPrimitive> primitives;
+	bool usesDefaultMaterial = false;
+	u32 numQuantizedAttributes = 0;
+
+	for (u32 meshIndex = 0; meshIndex < GetNumElements(pMeshes); ++meshIndex)
+	{
+		const std::vector<Matrix4f>& instanceWorldMatrices = meshInstanceWorldMatrices[meshIndex];
+		const JsonValue* pPrimitives = FindMember(GetElement(pMeshes, meshIndex), "primitives");
+
+		for (u32 primitiveIndex = 0; primitiveIndex < GetNumElements(pPrimitives); ++primitiveIndex)
+		{
+			const JsonValue* pPrimitive = GetElement(pPrimitives, primitiveIndex);
+			if (GetNumber(pPrimitive, "mode", GltfPrimitiveMode_Triangles) != GltfPrimitiveMode_Triangles)
+				continue;
+
+			const JsonValue* pAttributes = FindMember(pPrimitive, "attributes");
+
+			GltfPrimitive primitive;
+			if (!ReadAccessor(document, GetIndex(pAttributes, "POSITION"), &primitive.m_Positions))
+				continue;
+
+			const u32 numVertices = primitive.m_Positions.m_Count;
+			ReadAccessor(document, GetIndex(pAttributes, "NORMAL"), &primitive.m_Normals);
+			ReadAccessor(document, GetIndex(pAttributes, "TEXCOORD_0"), &primitive.m_TexCoords);
+
+			if (((primitive.m_Normals.m_pData != nullptr) && (primitive.m_Normals.m_Count != numVertices)) ||
+				((primitive.m_TexCoords.m_pData != nullptr) && (primitive.m_TexCoords.m_Count != numVertices)))
+				continue;
+
+			// Out of range indices would read outside of the mesh in the shared vertex buffer, so the primitive is dropped.
+			const u32 indicesAccessorIndex = GetIndex(pPrimitive, "indices");
+			if ((indicesAccessorIndex != kNotFound) &&
+				(!ReadAccessor(document, indicesAccessorIndex, &primitive.m_Indices) || !ValidateIndices(primitive.m_Indices, numVertices)))
+			{
+				const std::string message = "Skipped glTF mesh " + std::to_string(meshIndex) + " primitive " + std::to_string(primitiveIndex) +
+					" with invalid indices\n";
+				OutputDebugStringA(message.c_str());
+				continue;
+			}
+
+			for (const GltfAccessor* pAccessor : {&primitive.m_Positions, &primitive.m_Normals, &primitive.m_TexCoords})
+			{
+				if ((pAccessor->m_pData != nullptr) && (pAccessor->m_ComponentType != GltfComponentType_Float))
+					++numQuantizedAttributes;
+			}
+
+			const u32 materialIndex = GetIndex(pPrimitive, "material");
+			primitive.m_MaterialID = (materialIndex < numMaterials) ? materialIndex : numMaterials;
+			usesDefaultMaterial |= (primitive.m_MaterialID == numMaterials);
+
+			primitive.m_pInstanceWorldMatrices = &instanceWorldMatrices;
+			primitive.m_pInstanceFlags = &meshInstanceFlags[meshIndex];
+			for (u32 firstInstance = 0; firstInstance < instanceWorldMatrices.size(); firstInstance += kMaxNumInstancesPerMesh)
+			{
+				primitive.m_FirstInstance = firstInstance;
+				primitive.m_NumInstances = Min(kMaxNumInstancesPerMesh, u32(instanceWorldMatrices.size()) - firstInstance);
+				primitives.emplace_back(primitive);
+			}
+		}
+	}
+
+	const D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	const D3D12_PRIMITIVE_TOPOLOGY primitiveTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+	auto getNumIndices = [](const GltfPrimitive& primitive)
+	{
+		const u32 numIndices = (primitive.m_Indices.m_pData != nullptr) ? primitive.m_Indices.m_Count : primitive.m_Positions.m_Count;
+		return numIndices - numIndices % 3;
+	};
+
+	// Normals are generated when missing. Primitives without texture coordinates get a vertex format without them.
+	auto getVertexFormat = [](const GltfPrimitive& primitive)
+	{
+		u8 vertexFormat = VertexData::FormatFlag_Position | VertexData::FormatFlag_Normal;
+		if (primitive.m_TexCoords.m_pData != nullptr)
+			vertexFormat |= VertexData::FormatFlag_TexCoords;
+		return vertexFormat;
+	};
+	auto getIndexFormat = [](const GltfPrimitive& primitive)
+	{
+		return (primitive.m_Positions.m_Count <= kMaxNumVerticesWith16BitIndices) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	};
+
+	// Primitives are grouped by vertex format and index format into separate batches, as in the Assimp mesh conversion.
+	struct BatchTotals
+	{
+		u32 m_NumMeshes = 0;
+		u32 m_NumVertices = 0;
+		u32 m_NumIndices = 0;
+		u32 m_NumInstances = 0;
+	};
+	struct BatchGroup
+	{
+		u8 m_VertexFormat;
+		DXGI_FORMAT m_IndexFormat;
+		BatchTotals m_Totals;
+		MeshBatch* m_pMeshBatch;
+	};
+	std::vector<BatchGroup> batchGroups;
+
+	auto findBatchGroup = [&](const GltfPrimitive& primitive)
+	{
+		return std::find_if(batchGroups.begin(), batchGroups.end(), [&](const BatchGroup& batchGroup)
+		{
+			return (batchGroup.m_VertexFormat == getVertexFormat(primitive)) && (batchGroup.m_IndexFormat == getIndexFormat(primitive));
+		});
+	};
+
+	for (const GltfPrimitive& primitive : primitives)
+	{
+		auto batchGroupIt = findBatchGroup(primitive);
+		if (batchGroupIt == batchGroups.end())
+		{
+			batchGroups.push_back({getVertexFormat(primitive), getIndexFormat(primitive), BatchTotals(), nullptr});
+			batchGroupIt = batchGroups.end() - 1;
+		}
+
+		BatchTotals& batchTotals = batchGroupIt->m_Totals;
+		++batchTotals.m_NumMeshes;
+		batchTotals.m_NumVertices += primitive.m_Positions.m_Count;
+		batchTotals.m_NumIndices += getNumIndices(primitive);
+		batchTotals.m_NumInstances += primitive.m_NumInstances;
+	}
+
+	std::sort(batchGroups.begin(), batchGroups.end(), [](const BatchGroup& batchGroup1, const BatchGroup& batchGroup2)
+	{
+		if (batchGroup1.m_VertexFormat != batchGroup2.m_VertexFormat)
+			return (batchGroup1.m_VertexFormat > batchGroup2.m_VertexFormat);
+		return (batchGroup1.m_IndexFormat == DXGI_FORMAT_R16_UINT) && (batchGroup2.m_IndexFormat != DXGI_FORMAT_R16_UINT);
+	});
+
+	for (BatchGroup& batchGroup : batchGroups)
+	{
+		const BatchTotals& batchTotals = batchGroup.m_Totals;
+
+		batchGroup.m_pMeshBatch = new MeshBatch(batchGroup.m_VertexFormat, batchGroup.m_IndexFormat, primitiveTopologyType, primitiveTopology);
+		batchGroup.m_pMeshBatch->Reserve(batchTotals.m_NumMeshes, batchTotals.m_NumVertices, batchTotals.m_NumIndices, batchTotals.m_NumInstances);
+	}
+
+	struct PrimitiveLocation
+	{
+		MeshBatch* m_pMeshBatch;
+		u32 m_MeshIndexInBatch;
+		MeshBatch::MeshStreams m_Streams;
+	};
+	std::vector<PrimitiveLocation> primitiveLocations(primitives.size());
+
+	for (u32 primitiveIndex = 0; primitiveIndex < primitives.size(); ++primitiveIndex)
+	{
+		const GltfPrimitive& primitive = primitives[primitiveIndex];
+		MeshBatch* pMeshBatch = findBatchGroup(primitive)->m_pMeshBatch;
+
+		PrimitiveLocation& location = primitiveLocations[primitiveIndex];
+		location.m_pMeshBatch = pMeshBatch;
+		location.m_MeshIndexInBatch = pMeshBatch->GetNumMeshes();
+		location.m_Streams = pMeshBatch->AppendMesh(primitive.m_Positions.m_Count, getNumIndices(primitive),
+			primitive.m_NumInstances, primitive.m_MaterialID);
+	}
+
+	ParallelFor(primitives.size(), [&](u32 primitiveIndex)
+	{
+		const GltfPrimitive& primitive = primitives[primitiveIndex];
+		const PrimitiveLocation& location = primitiveLocations[primitiveIndex];
+		const MeshBatch::MeshStreams& streams = location.m_Streams;
+
+		const u32 numVertices = primitive.m_Positions.m_Count;
+		const u32 numIndices = getNumIndices(primitive);
+
+		// Same conversions as the Assimp steps MakeLeftHanded and FlipWindingOrder.
+		// Texture coordinates of glTF already have the origin at the top left corner.
+		ConvertAccessor(primitive.m_Positions, 3, &streams.m_pPositions->m_X);
+		for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+			streams.m_pPositions[vertexIndex].m_Z = -streams.m_pPositions[vertexIndex].m_Z;
+
+		std::vector<u32> indices(numIndices);
+		if (primitive.m_Indices.m_pData != nullptr)
+			ConvertIndices(primitive.m_Indices, indices.data());
+		else
+			std::iota(indices.begin(), indices.end(), 0);
+
+		for (u32 index = 0; index < numIndices; index += 3)
+			std::swap(indices[index], indices[index + 2]);
+
+		if (primitive.m_Normals.m_pData != nullptr)
+		{
+			ConvertAccessor(primitive.m_Normals, 3, &streams.m_pNormals->m_X);
+			for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+				streams.m_pNormals[vertexIndex].m_Z = -streams.m_pNormals[vertexIndex].m_Z;
+		}
+		else
+		{
+			// The vertex count is fixed when the mesh is appended to the batch, so vertices cannot be split at creases.
+			// All the triangles at a position are smoothed together, which gives the corners of a vertex the same normal.
+			std::vector<Vector3f> cornerNormals(numIndices);
+			GenerateNormals(numVertices, streams.m_pPositions, numIndices, indices.data(), PI, cornerNormals.data());
+
+			std::fill_n(streams.m_pNormals, numVertices, Vector3f::UP);
+			for (u32 index = 0; index < numIndices; ++index)
+				streams.m_pNormals[indices[index]] = cornerNormals[index];
+		}
+
+		if (primitive.m_TexCoords.m_pData != nullptr)
+		{
+			ConvertAccessor(primitive.m_TexCoords, 2, &streams.m_pTexCoords->m_X);
+
+			const GltfTexCoordTransform& transform = texCoordTransforms[primitive.m_MaterialID];
+			if ((transform.m_Offset[0] != 0.0f) || (transform.m_Offset[1] != 0.0f) || (transform.m_Rotation != 0.0f) ||
+				(transform.m_Scale[0] != 1.0f) || (transform.m_Scale[1] != 1.0f))
+			{
+				const f32 cosRotation = Cos(transform.m_Rotation);
+				const f32 sinRotation = Sin(transform.m_Rotation);
+
+				for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+				{
+					Vector2f& texCoords = streams.m_pTexCoords[vertexIndex];
+					const f32 scaledU = transform.m_Scale[0] * texCoords.m_X;
+					const f32 scaledV = transform.m_Scale[1] * texCoords.m_Y;
+
+					texCoords.m_X = transform.m_Offset[0] + cosRotation * scaledU + sinRotation * scaledV;
+					texCoords.m_Y = transform.m_Offset[1] - sinRotation * scaledU + cosRotation * scaledV;
+				}
+			}
+		}
+
+		if (streams.m_p16BitIndices != nullptr)
+			std::copy(indices.begin(), indices.end(), streams.m_p16BitIndices);
+		else
+			std::copy(indices.begin(), indices.end(), streams.m_p32BitIndices);
+
+		const auto firstInstanceIt = primitive.m_pInstanceWorldMatrices->cbegin() + primitive.m_FirstInstance;
+		std::copy(firstInstanceIt, firstInstanceIt + primitive.m_NumInstances, streams.m_pInstanceWorldMatrices);
+
+		const auto firstInstanceFlagsIt = primitive.m_pInstanceFlags->cbegin() + primitive.m_FirstInstance;
+		std::copy(firstInstanceFlagsIt, firstInstanceFlagsIt + primitive.m_NumInstances, streams.m_pInstanceFlags);
+
+		location.m_pMeshBatch->FinishMesh(location.m_MeshIndexInBatch);
+	});
+
+	Scene* pScene = new Scene();
+	for (const BatchGroup& batchGroup : batchGroups)
+	{
+		MeshBatch* pMeshBatch = batchGroup.m_pMeshBatch;
+
+		pMeshBatch->SortByMortonCode(meshProcessingParams.m_SortMeshesByMortonCode);
+		pMeshBatch->BuildMeshClusters();
+		pMeshBatch->SelectVertexCompression(VertexPrecisionBudget());
+
+		pScene->AddMeshBatch(pMeshBatch);
+	}
+	AddGltfMaterials(pScene, document, pFilePath, usesDefaultMaterial);
+
+	u32 numInstances = 0;
+	for (const GltfPrimitive& primitive : primitives)
+		numInstances += primitive.m_NumInstances;
+
+	const u32 outputBufferSize = 256;
+	char outputBuffer[outputBufferSize];
+
+	std::snprintf(outputBuffer, outputBufferSize,
+		"glTF loading: %u meshes -> %u batch meshes, %u instances, %u quantized attributes\n",
+		GetNumElements(pMeshes), u32(primitives.size()), numInstances, numQuantizedAttributes);
+
+	OutputDebugStringA(outputBuffer);
+
+	return pScene;
+}
+
+namespace
+{
+	const char* SkipJsonSpaces(const char* pText, const char* pEnd)
+	{
+		while ((pText < pEnd) && ((*pText == ' ') || (*pText == '\t') || (*pText == '\n') || (*pText == '\r')))
+			++pText;
+		return pText;
+	}
+
+	const char* ParseJsonValue(const char* pText, const char* pEnd, u32 depth, JsonValue* pValue)
+	{
+		pText = SkipJsonSpaces(pText, pEnd);
+		if ((pText == pEnd) || (depth > kMaxJsonDepth))
+			return nullptr;
+
+		auto matchLiteral = [pEnd](const char* pText, const char* pLiteral)
+		{
+			const std::size_t length = std::strlen(pLiteral);
+			return ((std::size_t(pEnd - pText) >= length) && (std::memcmp(pText, pLiteral, length) == 0)) ? pText + length : nullptr;
+		};
+
+		if (*pText == '{')
+		{
+			pValue->m_Type = JsonValue::Type_Object;
+			pText = SkipJsonSpaces(pText + 1, pEnd);
+			if ((pText < pEnd) && (*pText == '}'))
+				return pText + 1;
+
+			while (true)
+			{
+				pValue->m_MemberNames.emplace_back();
+				pText = ParseJsonString(SkipJsonSpaces(pText, pEnd), pEnd, &pValue->m_MemberNames.back());
+				if (pText == nullptr)
+					return nullptr;
+
+				pText = SkipJsonSpaces(pText, pEnd);
+				if ((pText == pEnd) || (*pText != ':'))
+					return nullptr;
+
+				pValue->m_Elements.emplace_back();
+				pText = ParseJsonValue(pText + 1, pEnd, depth + 1, &pValue->m_Elements.back());
+				if (pText == nullptr)
+					return nullptr;
+
+				pText = SkipJsonSpaces(pText, pEnd);
+				if ((pText < pEnd) && (*pText == ','))
+					++pText;
+				else if ((pText < pEnd) && (*pText == '}'))
+					return pText + 1;
+				else
+					return nullptr;
+			}
+		}
+		if (*pText == '[')
+		{
+			pValue->m_Type = JsonValue::Type_Array;
+			pText = SkipJsonSpaces(pText + 1, pEnd);
+			if ((pText < pEnd) && (*pText == ']'))
+				return pText + 1;
+
+			while (true)
+			{
+				pValue->m_Elements.emplace_back();
+				pText = ParseJsonValue(pText, pEnd, depth + 1, &pValue->m_Elements.back());
+				if (pText == nullptr)
+					return nullptr;
+
+				pText = SkipJsonSpaces(pText, pEnd);
+				if ((pText < pEnd) && (*pText == ','))
+					++pText;
+				else if ((pText < pEnd) && (*pText == ']'))
+					return pText + 1;
+				else
+					return nullptr;
+			}
+		}
+		if (*pText == '"')
+		{
+			pValue->m_Type = JsonValue::Type_String;
+			return ParseJsonString(pText, pEnd, &pValue->m_String);
+		}
+		if (const char* pLiteralEnd = matchLiteral(pText, "true"))
+		{
+			pValue->m_Type = JsonValue::Type_Bool;
+			pValue->m_Bool = true;
+			return pLiteralEnd;
+		}
+		if (const char* pLiteralEnd = matchLiteral(pText, "false"))
+		{
+			pValue->m_Type = JsonValue::Type_Bool;
+			pValue->m_Bool = false;
+			return pLiteralEnd;
+		}
+		if (const char* pLiteralEnd = matchLiteral(pText, "null"))
+		{
+			pValue->m_Type = JsonValue::Type_Null;
+			return pLiteralEnd;
+		}
+
+		// The text is not null-terminated, so the number is copied before it is converted.
+		const char* pNumberEnd = pText;
+		while ((pNumberEnd < pEnd) && (std::strchr("+-0123456789.eE", *pNumberEnd) != nullptr) && (*pNumberEnd != '\0'))
+			++pNumberEnd;
+
+		const std::string number(pText, pNumberEnd);
+		char* pConvertedEnd = nullptr;
+		pValue->m_Type = JsonValue::Type_Number;
+		pValue->m_Number = std::strtod(number.c_str(), &pConvertedEnd);
+
+		return (!number.empty() && (pConvertedEnd == number.c_str() + number.size())) ? pNumberEnd : nullptr;
+	}
+
+	const char* ParseJsonString(const char* pText, const char* pEnd, std::string* pString)
+	{
+		if ((pText == pEnd) || (*pText != '"'))
+			return nullptr;
+
+		for (++pText; pText < pEnd; ++pText)
+		{
+			if (*pText == '"')
+				return pText + 1;
+
+			if (*pText != '\\')
+			{
+				pString->push_back(*pText);
+				continue;
+			}
+
+			if (++pText == pEnd)
+				return nullptr;
+
+			switch (*pText)
+			{
+				case 'b': pString->push_back('\b'); break;
+				case 'f': pString->push_back('\f'); break;
+				case 'n': pString->push_back('\n'); break;
+				case 'r': pString->push_back('\r'); break;
+				case 't': pString->push_back('\t'); break;
+				case 'u':
+				{
+					auto parseHex = [pEnd](const char* pHex, u32* pCodeUnit)
+					{
+						if (pEnd - pHex < 4)
+							return false;
+
+						*pCodeUnit = 0;
+						for (u32 digitIndex = 0; digitIndex < 4; ++digitIndex)
+						{
+							const char digit = pHex[digitIndex];
+							const u32 value = ((digit >= '0') && (digit <= '9')) ? u32(digit - '0') :
+								((digit >= 'a') && (digit <= 'f')) ? u32(digit - 'a' + 10) :
+								((digit >= 'A') && (digit <= 'F')) ? u32(digit - 'A' + 10) : 16;
+							if (value == 16)
+								return false;
+							*pCodeUnit = 16 * (*pCodeUnit) + value;
+						}
+						return true;
+					};
+
+					u32 codePoint = 0;
+					if (!parseHex(pText + 1, &codePoint))
+						return nullptr;
+					pText += 4;
+
+					// Characters outside the basic multilingual plane are encoded as surrogate pairs.
+					u32 lowSurrogate = 0;
+					if ((codePoint >= 0xD800) && (codePoint < 0xDC00) && (pEnd - pText > 2) && (pText[1] == '\\') && (pText[2] == 'u') &&
+						parseHex(pText + 3, &lowSurrogate) && (lowSurrogate >= 0xDC00) && (lowSurrogate < 0xE000))
+					{
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+						pText += 6;
+					}
+					AppendUtf8(codePoint, pString);
+					break;
+				}
+				default: pString->push_back(*pText); break;
+			}
+		}
+		return nullptr;
+	}
+
+	void AppendUtf8(u32 codePoint, std::string* pString)
+	{
+		if (codePoint < 0x80)
+		{
+			pString->push_back(char(codePoint));
+		}
+		else if (codePoint < 0x800)
+		{
+			pString->push_back(char(0xC0 | (codePoint >> 6)));
+			pString->push_back(char(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			pString->push_back(char(0xE0 | (codePoint >> 12)));
+			pString->push_back(char(0x80 | ((codePoint >> 6) & 0x3F)));
+			pString->push_back(char(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			pString->push_back(char(0xF0 | (codePoint >> 18)));
+			pString->push_back(char(0x80 | ((codePoint >> 12) & 0x3F)));
+			pString->push_back(char(0x80 | ((codePoint >> 6) & 0x3F)));
+			pString->push_back(char(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	const JsonValue* FindMember(const JsonValue* pObject, const char* pName)
+	{
+		if ((pObject == nullptr) || (pObject->m_Type != JsonValue::Type_Object))
+			return nullptr;
+
+		for (u32 memberIndex = 0; memberIndex < pObject->m_MemberNames.size(); ++memberIndex)
+		{
+			if (pObject->m_MemberNames[memberIndex] == pName)
+				return &pObject->m_Elements[memberIndex];
+		}
+		return nullptr;
+	}
+
+	const JsonValue* GetElement(const JsonValue* pArray, u32 index)
+	{
+		return (index < GetNumElements(pArray)) ? &pArray->m_Elements[index] : nullptr;
+	}
+
+	u32 GetNumElements(const JsonValue* pArray)
+	{
+		return ((pArray != nullptr) && (pArray->m_Type == JsonValue::Type_Array)) ? u32(pArray->m_Elements.size()) : 0;
+	}
+
+	f64 GetNumber(const JsonValue* pObject, const char* pName, f64 defaultValue)
+	{
+		const JsonValue* pValue = FindMember(pObject, pName);
+		return ((pValue != nullptr) && (pValue->m_Type == JsonValue::Type_Number)) ? pValue->m_Number : defaultValue;
+	}
+
+	u32 GetIndex(const JsonValue* pObject, const char* pName)
+	{
+		const f64 index = GetNumber(pObject, pName, -1.0);
+		return ((index >= 0.0) && (index < f64(kNotFound))) ? u32(index) : kNotFound;
+	}
+
+	const std::string GetString(const JsonValue* pObject, const char* pName)
+	{
+		const JsonValue* pValue = FindMember(pObject, pName);
+		return ((pValue != nullptr) && (pValue->m_Type == JsonValue::Type_String)) ? pValue->m_String : std::string();
+	}
+
+	bool LoadGltfBuffers(const std::filesystem::path& directoryPath, const u8* pBinaryChunk, u64 binaryChunkSize, GltfDocument* pDocument)
+	{
+		// The binary chunk of GLB is the buffer without uri. Other buffers are external files.
+		// Embedded base64 buffers are not supported.
+		const JsonValue* pBuffers = FindMember(&pDocument->m_Root, "buffers");
+		for (u32 bufferIndex = 0; bufferIndex < GetNumElements(pBuffers); ++bufferIndex)
+		{
+			const JsonValue* pBuffer = GetElement(pBuffers, bufferIndex);
+			const std::string uri = GetString(pBuffer, "uri");
+			const u64 byteLength = u64(GetNumber(pBuffer, "byteLength", 0.0));
+
+			if (uri.empty())
+			{
+				if ((pBinaryChunk == nullptr) || (byteLength > binaryChunkSize))
+					return false;
+
+				pDocument->m_Buffers.emplace_back(pBinaryChunk);
+				pDocument->m_BufferSizes.emplace_back(byteLength);
+				pBinaryChunk = nullptr;
+				continue;
+			}
+			if (uri.compare(0, 5, "data:") == 0)
+				return false;
+
+			std::unique_ptr<MemoryMappedFile> bufferFile(new MemoryMappedFile());
+			const std::filesystem::path bufferFilePath = directoryPath / AnsiToWideString(DecodeUri(uri).c_str());
+			if (!bufferFile->Open(bufferFilePath.c_str()) || (byteLength > bufferFile->GetSizeInBytes()))
+				return false;
+
+			pDocument->m_Buffers.emplace_back(bufferFile->GetData());
+			pDocument->m_BufferSizes.emplace_back(byteLength);
+			pDocument->m_BufferFiles.emplace_back(std::move(bufferFile));
+		}
+		return true;
+	}
+
+	bool ReadAccessor(const GltfDocument& document, u32 accessorIndex, GltfAccessor* pAccessor)
+	{
+		const JsonValue* pRoot = &document.m_Root;
+		const JsonValue* pAccessorObject = GetElement(FindMember(pRoot, "accessors"), accessorIndex);
+		if (pAccessorObject == nullptr)
+			return false;
+
+		// Accessors without buffer view are zero-filled and sparse accessors patch the data,
+		// neither of which is produced by the exporters we use.
+		const JsonValue* pBufferView = GetElement(FindMember(pRoot, "bufferViews"), GetIndex(pAccessorObject, "bufferView"));
+		if ((pBufferView == nullptr) || (FindMember(pAccessorObject, "sparse") != nullptr))
+			return false;
+
+		const u32 bufferIndex = GetIndex(pBufferView, "buffer");
+		if (bufferIndex >= document.m_Buffers.size())
+			return false;
+
+		const std::string type = GetString(pAccessorObject, "type");
+		const u32 numComponents = (type == "SCALAR") ? 1 : (type == "VEC2") ? 2 : (type == "VEC3") ? 3 : (type == "VEC4") ? 4 : 0;
+
+		const u32 componentType = GetIndex(pAccessorObject, "componentType");
+		const u32 componentSize = ((componentType == GltfComponentType_Byte) || (componentType == GltfComponentType_UnsignedByte)) ? 1 :
+			((componentType == GltfComponentType_Short) || (componentType == GltfComponentType_UnsignedShort)) ? 2 :
+			((componentType == GltfComponentType_UnsignedInt) || (componentType == GltfComponentType_Float)) ? 4 : 0;
+
+		if ((numComponents == 0) || (componentSize == 0))
+			return false;
+
+		const u32 count = GetIndex(pAccessorObject, "count");
+		const u32 elementSize = numComponents * componentSize;
+		const u32 stride = Max(u32(GetNumber(pBufferView, "byteStride", 0.0)), elementSize);
+		const u64 byteOffset = u64(GetNumber(pBufferView, "byteOffset", 0.0)) + u64(GetNumber(pAccessorObject, "byteOffset", 0.0));
+		const u64 byteLength = u64(GetNumber(pBufferView, "byteLength", 0.0));
+
+		// The buffer view should lie in the buffer and the accessor elements in the buffer view.
+		if (u64(GetNumber(pBufferView, "byteOffset", 0.0)) + byteLength > document.m_BufferSizes[bufferIndex])
+			return false;
+
+		if ((count == kNotFound) || (count == 0) ||
+			(byteLength < u64(GetNumber(pAccessorObject, "byteOffset", 0.0)) + u64(stride) * (count - 1) + elementSize) ||
+			(byteOffset + u64(stride) * (count - 1) + elementSize > document.m_BufferSizes[bufferIndex]))
+			return false;
+
+		const JsonValue* pNormalized = FindMember(pAccessorObject, "normalized");
+
+		pAccessor->m_pData = document.m_Buffers[bufferIndex] + byteOffset;
+		pAccessor->m_Count = count;
+		pAccessor->m_Stride = stride;
+		pAccessor->m_ComponentType = componentType;
+		pAccessor->m_NumComponents = numComponents;
+		pAccessor->m_Normalized = (pNormalized != nullptr) && pNormalized->m_Bool;
+
+		return true;
+	}
+
+	void ConvertAccessor(const GltfAccessor& accessor, u32 numOutputComponents, f32* pOutput)
+	{
+		// Tightly packed floats already have the layout of the mesh batch streams.
+		if ((accessor.m_ComponentType == GltfComponentType_Float) && (accessor.m_NumComponents == numOutputComponents) &&
+			(accessor.m_Stride == numOutputComponents * sizeof(f32)))
+		{
+			std::memcpy(pOutput, accessor.m_pData, accessor.m_Count * accessor.m_Stride);
+			return;
+		}
+
+		// Normalized signed values are clamped to -1, as the smallest integer maps slightly below it.
+		const bool normalized = accessor.m_Normalized;
+		switch (accessor.m_ComponentType)
+		{
+			case GltfComponentType_Float:
+				ConvertComponents<f32>(accessor, 0, numOutputComponents, 1.0f, -FLT_MAX, pOutput);
+				break;
+			case GltfComponentType_UnsignedInt:
+				ConvertComponents<u32>(accessor, 0, numOutputComponents, 1.0f, -FLT_MAX, pOutput);
+				break;
+			case GltfComponentType_Byte:
+				ConvertSmallIntComponentsSSE2<i8>(accessor, numOutputComponents, normalized ? 1.0f / 127.0f : 1.0f, normalized ? -1.0f : -FLT_MAX, pOutput);
+				break;
+			case GltfComponentType_UnsignedByte:
+				ConvertSmallIntComponentsSSE2<u8>(accessor, numOutputComponents, normalized ? 1.0f / 255.0f : 1.0f, -FLT_MAX, pOutput);
+				break;
+			case GltfComponentType_Short:
+				ConvertSmallIntComponentsSSE2<i16>(accessor, numOutputComponents, normalized ? 1.0f / 32767.0f : 1.0f, normalized ? -1.0f : -FLT_MAX, pOutput);
+				break;
+			case GltfComponentType_UnsignedShort:
+				ConvertSmallIntComponentsSSE2<u16>(accessor, numOutputComponents, normalized ? 1.0f / 65535.0f : 1.0f, -FLT_MAX, pOutput);
+				break;
+			default:
+				assert(false);
+		}
+	}
+
+	template <typename T>
+	void ConvertComponents(const GltfAccessor& accessor, u32 firstElement, u32 numOutputComponents, f32 scale, f32 minValue, f32* pOutput)
+	{
+		const u32 numComponents = Min(accessor.m_NumComponents, numOutputComponents);
+		for (u32 elementIndex = firstElement; elementIndex < accessor.m_Count; ++elementIndex)
+		{
+			const u8* pElement = accessor.m_pData + std::size_t(elementIndex) * accessor.m_Stride;
+			f32* pOutputElement = pOutput + std::size_t(elementIndex) * numOutputComponents;
+
+			for (u32 componentIndex = 0; componentIndex < numOutputComponents; ++componentIndex)
+			{
+				T value = T(0);
+				if (componentIndex < numComponents)
+					std::memcpy(&value, pElement + componentIndex * sizeof(T), sizeof(T));
+
+				pOutputElement[componentIndex] = Max(f32(value) * scale, minValue);
+			}
+		}
+	}
+
+	template <typename T>
+	void ConvertSmallIntComponentsSSE2(const GltfAccessor& accessor, u32 numOutputComponents, f32 scale, f32 minValue, f32* pOutput)
+	{
+		static_assert(sizeof(T) <= 2, "Only 8-bit and 16-bit components are supported");
+
+		// All 4 components of the element are loaded at once, which may read past the element into the stride padding.
+		// Elements without enough padding and the last element, which may end the buffer, are converted in scalar code.
+		const u32 loadSize = 4 * sizeof(T);
+		const u32 numVectorElements = (accessor.m_Stride >= loadSize) ? accessor.m_Count - 1 : 0;
+		const u32 numComponents = Min(accessor.m_NumComponents, numOutputComponents);
+
+		const __m128 scaleVector = _mm_set1_ps(scale);
+		const __m128 minVector = _mm_set1_ps(minValue);
+		const __m128i zero = _mm_setzero_si128();
+
+		f32 components[4];
+		for (u32 elementIndex = 0; elementIndex < numVectorElements; ++elementIndex)
+		{
+			const u8* pElement = accessor.m_pData + std::size_t(elementIndex) * accessor.m_Stride;
+
+			__m128i values;
+			if (sizeof(T) == 2)
+			{
+				values = _mm_loadl_epi64((const __m128i*)pElement);
+				values = std::is_signed<T>::value ? _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16) : _mm_unpacklo_epi16(values, zero);
+			}
+			else
+			{
+				i32 bits;
+				std::memcpy(&bits, pElement, sizeof(bits));
+				values = _mm_cvtsi32_si128(bits);
+
+				values = std::is_signed<T>::value ?
+					_mm_srai_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(values, values), _mm_unpacklo_epi8(values, values)), 24) :
+					_mm_unpacklo_epi16(_mm_unpacklo_epi8(values, zero), zero);
+			}
+			_mm_storeu_ps(components, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(values), scaleVector), minVector));
+
+			f32* pOutputElement = pOutput + std::size_t(elementIndex) * numOutputComponents;
+			for (u32 componentIndex = 0; componentIndex < numOutputComponents; ++componentIndex)
+				pOutputElement[componentIndex] = (componentIndex < numComponents) ? components[componentIndex] : 0.0f;
+		}
+		ConvertComponents<T>(accessor, numVectorElements, numOutputComponents, scale, minValue, pOutput);
+	}
+
+	bool ValidateIndices(const GltfAccessor& accessor, u32 numVertices)
+	{
+		if ((accessor.m_NumComponents != 1) || ((accessor.m_ComponentType != GltfComponentType_UnsignedByte) &&
+			(accessor.m_ComponentType != GltfComponentType_UnsignedShort) && (accessor.m_ComponentType != GltfComponentType_UnsignedInt)))
+			return false;
+
+		for (u32 index = 0; index < accessor.m_Count; ++index)
+		{
+			if (ReadIndex(accessor, index) >= numVertices)
+				return false;
+		}
+		return true;
+	}
+
+	u32 ReadIndex(const GltfAccessor& accessor, u32 index)
+	{
+		const u8* pIndex = accessor.m_pData + std::size_t(index) * accessor.m_Stride;
+		if (accessor.m_ComponentType == GltfComponentType_UnsignedByte)
+			return *pIndex;
+
+		if (accessor.m_ComponentType == GltfComponentType_UnsignedShort)
+		{
+			u16 value;
+			std::memcpy(&value, pIndex, sizeof(value));
+			return value;
+		}
+
+		u32 value;
+		std::memcpy(&value, pIndex, sizeof(value));
+		return value;
+	}
+
+	void ConvertIndices(const GltfAccessor& accessor, u32* pOutput)
+	{
+		// Trailing indices which do not form a triangle are dropped.
+		const u32 numIndices = accessor.m_Count - accessor.m_Count % 3;
+		for (u32 index = 0; index < numIndices; ++index)
+			pOutput[index] = ReadIndex(accessor, index);
+	}
+
+	void CollectMeshInstances(const JsonValue& root, const Matrix4f& worldMatrix, const DynamicObjectParams& dynamicObjectParams,
+		std::vector<std::vector<Matrix4f>>* pMeshInstanceWorldMatrices, std::vector<std::vector<u8>>* pMeshInstanceFlags)
+	{
+		const JsonValue* pNodes = FindMember(&root, "nodes");
+		const u32 numNodes = GetNumElements(pNodes);
+		pMeshInstanceWorldMatrices->resize(GetNumElements(FindMember(&root, "meshes")));
+		pMeshInstanceFlags->resize(pMeshInstanceWorldMatrices->size());
+
+		// Nodes targeted by animations and nodes selected by name are dynamic. Children inherit the flag while the hierarchy is traversed.
+		std::vector<bool> isDynamicNode(numNodes, false);
+		for (u32 nodeIndex = 0; nodeIndex < numNodes; ++nodeIndex)
+			isDynamicNode[nodeIndex] = dynamicObjectParams.IsDynamicName(GetString(GetElement(pNodes, nodeIndex), "name"));
+
+		const JsonValue* pAnimations = FindMember(&root, "animations");
+		for (u32 animationIndex = 0; animationIndex < GetNumElements(pAnimations); ++animationIndex)
+		{
+			const JsonValue* pChannels = FindMember(GetElement(pAnimations, animationIndex), "channels");
+			for (u32 channelIndex = 0; channelIndex < GetNumElements(pChannels); ++channelIndex)
+			{
+				const u32 nodeIndex = GetIndex(FindMember(GetElement(pChannels, channelIndex), "target"), "node");
+				if (nodeIndex < numNodes)
+					isDynamicNode[nodeIndex] = true;
+			}
+		}
+
+		// Nodes of the default scene are instanced. Without scenes, all nodes which are not children of other nodes are roots.
+		std::vector<u32> rootNodeIndices;
+		const JsonValue* pScenes = FindMember(&root, "scenes");
+		if (GetNumElements(pScenes) > 0)
+		{
+			const u32 sceneIndex = GetIndex(&root, "scene");
+			const JsonValue* pSceneNodes = FindMember(GetElement(pScenes, (sceneIndex != kNotFound) ? sceneIndex : 0), "nodes");
+
+			for (u32 index = 0; index < GetNumElements(pSceneNodes); ++index)
+				rootNodeIndices.emplace_back(u32(GetElement(pSceneNodes, index)->m_Number));
+		}
+		else
+		{
+			std::vector<bool> isChildNode(numNodes, false);
+			for (u32 nodeIndex = 0; nodeIndex < numNodes; ++nodeIndex)
+			{
+				const JsonValue* pChildren = FindMember(GetElement(pNodes, nodeIndex), "children");
+				for (u32 index = 0; index < GetNumElements(pChildren); ++index)
+				{
+					const u32 childIndex = u32(GetElement(pChildren, index)->m_Number);
+					if (childIndex < numNodes)
+						isChildNode[childIndex] = true;
+				}
+			}
+			for (u32 nodeIndex = 0; nodeIndex < numNodes; ++nodeIndex)
+			{
+				if (!isChildNode[nodeIndex])
+					rootNodeIndices.emplace_back(nodeIndex);
+			}
+		}
+
+		// glTF is right-handed. The mirror conjugates the node transforms, as the Assimp step MakeLeftHanded does.
+		const Matrix4f mirrorMatrix = CreateScalingMatrix(1.0f, 1.0f, -1.0f);
+
+		struct NodeEntry
+		{
+			u32 m_NodeIndex;
+			Matrix4f m_ParentWorldMatrix;
+			bool m_IsParentDynamic;
+		};
+		std::vector<NodeEntry> nodeStack;
+		for (auto it = rootNodeIndices.rbegin(); it != rootNodeIndices.rend(); ++it)
+			nodeStack.push_back({*it, Matrix4f::IDENTITY, false});
+
+		// The node hierarchy is a forest, so each node is visited once. The visit count guards against malformed files with cycles.
+		u32 numVisitedNodes = 0;
+		while (!nodeStack.empty() && (numVisitedNodes++ < numNodes))
+		{
+			const NodeEntry entry = nodeStack.back();
+			nodeStack.pop_back();
+
+			const JsonValue* pNode = GetElement(pNodes, entry.m_NodeIndex);
+			if (pNode == nullptr)
+				continue;
+
+			const Matrix4f nodeWorldMatrix = CalcNodeLocalMatrix(pNode) * entry.m_ParentWorldMatrix;
+			const bool isDynamic = entry.m_IsParentDynamic || isDynamicNode[entry.m_NodeIndex];
+
+			const u32 meshIndex = GetIndex(pNode, "mesh");
+			if (meshIndex < pMeshInstanceWorldMatrices->size())
+			{
+				(*pMeshInstanceWorldMatrices)[meshIndex].emplace_back(mirrorMatrix * nodeWorldMatrix * mirrorMatrix * worldMatrix);
+				(*pMeshInstanceFlags)[meshIndex].emplace_back(isDynamic ? MeshBatch::MeshInstanceFlag_Dynamic : MeshBatch::MeshInstanceFlag_None);
+			}
+
+			const JsonValue* pChildren = FindMember(pNode, "children");
+			for (u32 index = GetNumElements(pChildren); index > 0; --index)
+				nodeStack.push_back({u32(GetElement(pChildren, index - 1)->m_Number), nodeWorldMatrix, isDynamic});
+		}
+	}
+
+	const Matrix4f CalcNodeLocalMatrix(const JsonValue* pNode)
+	{
+		// glTF matrices are column-major for column vectors, which is the same memory layout as row-major for row vectors.
+		const JsonValue* pMatrix = FindMember(pNode, "matrix");
+		if (GetNumElements(pMatrix) == 16)
+		{
+			f32 values[16];
+			for (u32 index = 0; index < 16; ++index)
+				values[index] = f32(GetElement(pMatrix, index)->m_Number);
+
+			return Matrix4f(values[0], values[1], values[2], values[3],
+				values[4], values[5], values[6], values[7],
+				values[8], values[9], values[10], values[11],
+				values[12], values[13], values[14], values[15]);
+		}
+
+		auto getVector = [pNode](const char* pName, u32 numComponents, f32 defaultValue, f32* pValues)
+		{
+			const JsonValue* pVector = FindMember(pNode, pName);
+			for (u32 index = 0; index < numComponents; ++index)
+				pValues[index] = (GetNumElements(pVector) == numComponents) ? f32(GetElement(pVector, index)->m_Number) : defaultValue;
+		};
+
+		f32 scale[3];
+		getVector("scale", 3, 1.0f, scale);
+
+		f32 rotation[4];
+		getVector("rotation", 4, 0.0f, rotation);
+		if (GetNumElements(FindMember(pNode, "rotation")) != 4)
+			rotation[3] = 1.0f;
+
+		f32 translation[3];
+		getVector("translation", 3, 0.0f, translation);
+
+		return CreateScalingMatrix(scale[0], scale[1], scale[2]) *
+			CreateRotationMatrix(Quaternion(rotation[0], rotation[1], rotation[2], rotation[3])) *
+			CreateTranslationMatrix(translation[0], translation[1], translation[2]);
+	}
+
+	const GltfTexCoordTransform ReadTexCoordTransform(const JsonValue* pTextureInfo)
+	{
+		GltfTexCoordTransform transform;
+
+		const JsonValue* pTransform = FindMember(FindMember(pTextureInfo, "extensions"), "KHR_texture_transform");
+		if (pTransform == nullptr)
+			return transform;
+
+		const JsonValue* pOffset = FindMember(pTransform, "offset");
+		const JsonValue* pScale = FindMember(pTransform, "scale");
+
+		for (u32 index = 0; index < 2; ++index)
+		{
+			if (GetNumElements(pOffset) == 2)
+				transform.m_Offset[index] = f32(GetElement(pOffset, index)->m_Number);
+			if (GetNumElements(pScale) == 2)
+				transform.m_Scale[index] = f32(GetElement(pScale, index)->m_Number);
+		}
+		transform.m_Rotation = f32(GetNumber(pTransform, "rotation", 0.0));
+
+		return transform;
+	}
+
+	void AddGltfMaterials(Scene* pScene, const GltfDocument& document, const std::filesystem::path& filePath, bool addDefaultMaterial)
+	{
+		// The metallic-roughness texture of glTF packs roughness in the green channel and metalness in the blue channel,
+		// and it is referenced as both the metalness and the roughness texture.
+		const JsonValue* pMaterials = FindMember(&document.m_Root, "materials");
+		for (u32 materialIndex = 0; materialIndex < GetNumElements(pMaterials); ++materialIndex)
+		{
+			const JsonValue* pMaterialObject = GetElement(pMaterials, materialIndex);
+			const JsonValue* pMetallicRoughness = FindMember(pMaterialObject, "pbrMetallicRoughness");
+
+			std::string name = GetString(pMaterialObject, "name");
+			if (name.empty())
+				name = "Material" + std::to_string(materialIndex);
+
+			Material* pMaterial = new Material(AnsiToWideString(name.c_str()));
+
+			const u32 baseColorTextureIndex = GetIndex(FindMember(pMetallicRoughness, "baseColorTexture"), "index");
+			const u32 metallicRoughnessTextureIndex = GetIndex(FindMember(pMetallicRoughness, "metallicRoughnessTexture"), "index");
+
+			pMaterial->m_FilePaths[Material::BaseColorTextureIndex] = GetImageFilePath(document, filePath, baseColorTextureIndex);
+			pMaterial->m_FilePaths[Material::MetalnessTextureIndex] = GetImageFilePath(document, filePath, metallicRoughnessTextureIndex);
+			pMaterial->m_FilePaths[Material::RougnessTextureIndex] = pMaterial->m_FilePaths[Material::MetalnessTextureIndex];
+
+			pScene->AddMaterial(pMaterial);
+		}
+
+		if (addDefaultMaterial)
+			pScene->AddMaterial(new Material(L"DefaultMaterial"));
+	}
+
+	const std::wstring GetImageFilePath(const GltfDocument& document, const std::filesystem::path& filePath, u32 textureIndex)
+	{
+		const JsonValue* pRoot = &document.m_Root;
+		const u32 imageIndex = GetIndex(GetElement(FindMember(pRoot, "textures"), textureIndex), "source");
+
+		const JsonValue* pImage = GetElement(FindMember(pRoot, "images"), imageIndex);
+		if (pImage == nullptr)
+			return std::wstring();
+
+		std::filesystem::path imageFilePath(filePath);
+		imageFilePath.remove_filename();
+
+		const std::string uri = GetString(pImage, "uri");
+		if (!uri.empty())
+			return (uri.compare(0, 5, "data:") != 0) ? (imageFilePath / AnsiToWideString(DecodeUri(uri).c_str())).wstring() : std::wstring();
+
+		// Textures are loaded from files, so images stored in the buffers are extracted next to the glTF file once.
+		const JsonValue* pBufferView = GetElement(FindMember(pRoot, "bufferViews"), GetIndex(pImage, "bufferView"));
+		const u32 bufferIndex = GetIndex(pBufferView, "buffer");
+		if (bufferIndex >= document.m_Buffers.size())
+			return std::wstring();
+
+		const u64 byteOffset = u64(GetNumber(pBufferView, "byteOffset", 0.0));
+		const u64 byteLength = u64(GetNumber(pBufferView, "byteLength", 0.0));
+		if (byteOffset + byteLength > document.m_BufferSizes[bufferIndex])
+			return std::wstring();
+
+		const std::string mimeType = GetString(pImage, "mimeType");
+		const wchar_t* pExtension = (mimeType == "image/png") ? L".png" : (mimeType == "image/jpeg") ? L".jpg" : L".dds";
+
+		imageFilePath /= filePath.stem().wstring() + L".image" + std::to_wstring(imageIndex) + pExtension;
+		if (!std::filesystem::exists(imageFilePath))
+		{
+			std::ofstream imageFile(imageFilePath, std::ios::binary);
+			imageFile.write((const char*)document.m_Buffers[bufferIndex] + byteOffset, byteLength);
+		}
+		return imageFilePath.wstring();
+	}
+
+	const std::string DecodeUri(const std::string& uri)
+	{
+		std::string decodedUri;
+		for (std::size_t index = 0; index < uri.size(); ++index)
+		{
+			if ((uri[index] == '%') && (index + 2 < uri.size()) && std::isxdigit(u8(uri[index + 1])) && std::isxdigit(u8(uri[index + 2])))
+			{
+				decodedUri.push_back(char(std::stoi(uri.substr(index + 1, 2), nullptr, 16)));
+				index += 2;
+			}
+			else
+			{
+				decodedUri.push_back(uri[index]);
+			}
+		}
+		return decodedUri;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "Scene/InstanceCompression.h"
+#include "Math/Math.h"
+#include "Math/Quaternion.h"
+#include "Math/Transform.h"
+#include <emmintrin.h>
+
+namespace
+{
+	static_assert(sizeof(Matrix4f) == 16 * sizeof(f32), "Matrices are loaded as packed floats");
+
+	const Vector3f GetAxis(const Matrix4f& matrix, u32 axisIndex);
+}
+
+void PackAffineTransforms(u32 numInstances, const Matrix4f* pMatrices, AffineTransform* pTransforms)
+{
+	for (u32 instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
+	{
+		const f32* pMatrixData = &pMatrices[instanceIndex].m_00;
+		assert(AreEqual(pMatrices[instanceIndex].m_03, 0.0f, EPSILON));
+		assert(AreEqual(pMatrices[instanceIndex].m_13, 0.0f, EPSILON));
+		assert(AreEqual(pMatrices[instanceIndex].m_23, 0.0f, EPSILON));
+
+		__m128 row0 = _mm_loadu_ps(pMatrixData + 0);
+		__m128 row1 = _mm_loadu_ps(pMatrixData + 4);
+		__m128 row2 = _mm_loadu_ps(pMatrixData + 8);
+		__m128 row3 = _mm_loadu_ps(pMatrixData + 12);
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+		f32* pTransformData = &pTransforms[instanceIndex].m_Rows[0].m_X;
+		_mm_storeu_ps(pTransformData + 0, row0);
+		_mm_storeu_ps(pTransformData + 4, row1);
+		_mm_storeu_ps(pTransformData + 8, row2);
+	}
+}
+
+void QuantizeAABBs(u32 numInstances, const AxisAlignedBox* pAABBs, const AxisAlignedBox& sceneBounds, QuantizedAABB* pQuantizedAABBs)
+{
+	const Vector3f sceneMinPoint = sceneBounds.m_Center - sceneBounds.m_Radius;
+	const Vector3f sceneExtent = 2.0f * sceneBounds.m_Radius;
+
+	const __m128 sceneMinPointSIMD = _mm_setr_ps(sceneMinPoint.m_X, sceneMinPoint.m_Y, sceneMinPoint.m_Z, 0.0f);
+	const __m128 scaleSIMD = _mm_setr_ps(
+		(sceneExtent.m_X > 0.0f) ? 65535.0f / sceneExtent.m_X : 0.0f,
+		(sceneExtent.m_Y > 0.0f) ? 65535.0f / sceneExtent.m_Y : 0.0f,
+		(sceneExtent.m_Z > 0.0f) ? 65535.0f / sceneExtent.m_Z : 0.0f,
+		0.0f);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxValue = _mm_set1_ps(65535.0f);
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i bias = _mm_set1_epi32(32768);
+	const __m128i signFlip = _mm_set1_epi16(-32768);
+
+	for (u32 instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
+	{
+		const AxisAlignedBox& aabb = pAABBs[instanceIndex];
+
+		const __m128 center = _mm_setr_ps(aabb.m_Center.m_X, aabb.m_Center.m_Y, aabb.m_Center.m_Z, 0.0f);
+		const __m128 radius = _mm_setr_ps(aabb.m_Radius.m_X, aabb.m_Radius.m_Y, aabb.m_Radius.m_Z, 0.0f);
+
+		const __m128 normalizedMinPoint = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_sub_ps(center, radius), sceneMinPointSIMD), scaleSIMD), zero), maxValue);
+		const __m128 normalizedMaxPoint = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_add_ps(center, radius), sceneMinPointSIMD), scaleSIMD), zero), maxValue);
+
+		// The values are non-negative, so truncation rounds the min point down.
+		// The max point is rounded up by adding one where truncation has dropped a fraction.
+		const __m128i quantizedMinPoint = _mm_cvttps_epi32(normalizedMinPoint);
+		__m128i quantizedMaxPoint = _mm_cvttps_epi32(normalizedMaxPoint);
+		const __m128 hasFraction = _mm_cmplt_ps(_mm_cvtepi32_ps(quantizedMaxPoint), normalizedMaxPoint);
+		quantizedMaxPoint = _mm_add_epi32(quantizedMaxPoint, _mm_and_si128(_mm_castps_si128(hasFraction), one));
+
+		// Pack with signed saturation works on values biased to the signed range.
+		alignas(16) u16 packedPoints[8];
+		_mm_store_si128((__m128i*)packedPoints, _mm_xor_si128(
+			_mm_packs_epi32(_mm_sub_epi32(quantizedMinPoint, bias), _mm_sub_epi32(quantizedMaxPoint, bias)), signFlip));
+
+		QuantizedAABB& quantizedAABB = pQuantizedAABBs[instanceIndex];
+		std::memcpy(quantizedAABB.m_MinPoint, packedPoints + 0, sizeof(quantizedAABB.m_MinPoint));
+		std::memcpy(quantizedAABB.m_MaxPoint, packedPoints + 4, sizeof(quantizedAABB.m_MaxPoint));
+	}
+}
+
+void PackSimilarityTransforms(u32 numInstances, const Matrix4f* pMatrices, SimilarityTransform* pTransforms)
+{
+	for (u32 instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
+	{
+		const Matrix4f& matrix = pMatrices[instanceIndex];
+		assert(IsSimilarityTransform(matrix));
+
+		const f32 scale = (Length(GetAxis(matrix, 0)) + Length(GetAxis(matrix, 1)) + Length(GetAxis(matrix, 2))) / 3.0f;
+		const f32 rcpScale = 1.0f / scale;
+
+		const Matrix4f rotationMatrix(
+			rcpScale * matrix.m_00, rcpScale * matrix.m_01, rcpScale * matrix.m_02, 0.0f,
+			rcpScale * matrix.m_10, rcpScale * matrix.m_11, rcpScale * matrix.m_12, 0.0f,
+			rcpScale * matrix.m_20, rcpScale * matrix.m_21, rcpScale * matrix.m_22, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+
+		const Quaternion rotation = Normalize(Quaternion(rotationMatrix));
+
+		SimilarityTransform& transform = pTransforms[instanceIndex];
+		transform.m_Rotation = Vector4f(rotation.m_X, rotation.m_Y, rotation.m_Z, rotation.m_W);
+		transform.m_Translation = Vector3f(matrix.m_30, matrix.m_31, matrix.m_32);
+		transform.m_Scale = scale;
+	}
+}
+
+const Matrix4f UnpackAffineTransform(const AffineTransform& transform)
+{
+	const Vector4f* pRows = transform.m_Rows;
+	return Matrix4f(
+		pRows[0].m_X, pRows[1].m_X, pRows[2].m_X, 0.0f,
+		pRows[0].m_Y, pRows[1].m_Y, pRows[2].m_Y, 0.0f,
+		pRows[0].m_Z, pRows[1].m_Z, pRows[2].m_Z, 0.0f,
+		pRows[0].m_W, pRows[1].m_W, pRows[2].m_W, 1.0f);
+}
+
+const Matrix4f UnpackSimilarityTransform(const SimilarityTransform& transform)
+{
+	const Quaternion rotation(transform.m_Rotation.m_X, transform.m_Rotation.m_Y, transform.m_Rotation.m_Z, transform.m_Rotation.m_W);
+	return CreateScalingMatrix(transform.m_Scale) * CreateRotationMatrix(rotation) * CreateTranslationMatrix(transform.m_Translation);
+}
+
+const AxisAlignedBox DequantizeAABB(const QuantizedAABB& quantizedAABB, const AxisAlignedBox& sceneBounds)
+{
+	const Vector3f sceneMinPoint = sceneBounds.m_Center - sceneBounds.m_Radius;
+	const Vector3f step = (2.0f * sceneBounds.m_Radius) / 65535.0f;
+
+	const Vector3f minPoint = sceneMinPoint + step * Vector3f(quantizedAABB.m_MinPoint[0], quantizedAABB.m_MinPoint[1], quantizedAABB.m_MinPoint[2]);
+	const Vector3f maxPoint = sceneMinPoint + step * Vector3f(quantizedAABB.m_MaxPoint[0], quantizedAABB.m_MaxPoint[1], quantizedAABB.m_MaxPoint[2]);
+
+	return AxisAlignedBox(0.5f * (minPoint + maxPoint), 0.5f * (maxPoint - minPoint));
+}
+
+bool IsSimilarityTransform(const Matrix4f& matrix, f32 maxRelativeError)
+{
+	if (!AreEqual(matrix.m_03, 0.0f, EPSILON) || !AreEqual(matrix.m_13, 0.0f, EPSILON) ||
+		!AreEqual(matrix.m_23, 0.0f, EPSILON) || !AreEqual(matrix.m_33, 1.0f, EPSILON))
+		return false;
+
+	const Vector3f xAxis = GetAxis(matrix, 0);
+	const Vector3f yAxis = GetAxis(matrix, 1);
+	const Vector3f zAxis = GetAxis(matrix, 2);
+
+	const f32 scale = Length(xAxis);
+	if (scale < EPSILON)
+		return false;
+
+	const f32 maxError = maxRelativeError * scale;
+	if ((Abs(Length(yAxis) - scale) > maxError) || (Abs(Length(zAxis) - scale) > maxError))
+		return false;
+
+	const f32 maxDotError = maxRelativeError * scale * scale;
+	if ((Abs(Dot(xAxis, yAxis)) > maxDotError) || (Abs(Dot(xAxis, zAxis)) > maxDotError) || (Abs(Dot(yAxis, zAxis)) > maxDotError))
+		return false;
+
+	// Quaternion cannot encode a reflection.
+	return (Dot(Cross(xAxis, yAxis), zAxis) > 0.0f);
+}
+
+namespace
+{
+	const Vector3f GetAxis(const Matrix4f& matrix, u32 axisIndex)
+	{
+		const f32* pRow = &matrix.m_00 + 4 * axisIndex;
+		return Vector3f(pRow[0], pRow[1], pRow[2]);
+	}
+}
\ No newline at end of file
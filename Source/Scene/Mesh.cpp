@@ -11,167 +11,190 @@ VertexData::VertexData(u32 numVertices, const Vector3f* pPositions, const Vector
 	const Vector2f* pTexCoords, const Vector4f* pColors, const Vector3f* pTangents)
 	: m_NumVertices(numVertices)
 	, m_FormatFlags(0)
-	, m_pPositions(nullptr)
-	, m_pNormals(nullptr)
-	, m_pTexCoords(nullptr)
-	, m_pColors(nullptr)
-	, m_pTangents(nullptr)
 {
 	assert(m_NumVertices > 0);
 	assert(pPositions != nullptr);
 	{
-		m_pPositions = new Vector3f[numVertices];
-		std::memcpy(m_pPositions, pPositions, numVertices * sizeof(Vector3f));
-		
+		m_Positions.assign(pPositions, pPositions + numVertices);
 		m_FormatFlags |= FormatFlag_Position;
 	}
 	if (pColors != nullptr)
 	{
-		m_pColors = new Vector4f[numVertices];
-		std::memcpy(m_pColors, pColors, numVertices * sizeof(Vector4f));
-		
+		m_Colors.assign(pColors, pColors + numVertices);
 		m_FormatFlags |= FormatFlag_Color;
 	}
 	if (pNormals != nullptr)
 	{
-		m_pNormals = new Vector3f[numVertices];
-		std::memcpy(m_pNormals, pNormals, numVertices * sizeof(Vector3f));
-
+		m_Normals.assign(pNormals, pNormals + numVertices);
 		m_FormatFlags |= FormatFlag_Normal;
 	}
 	if (pTexCoords != nullptr)
 	{
-		m_pTexCoords = new Vector2f[numVertices];
-		std::memcpy(m_pTexCoords, pTexCoords, numVertices * sizeof(Vector2f));
-
+		m_TexCoords.assign(pTexCoords, pTexCoords + numVertices);
 		m_FormatFlags |= FormatFlag_TexCoords;
 	}
 	if (pTangents != nullptr)
 	{
-		m_pTangents = new Vector3f[numVertices];
-		std::memcpy(m_pTangents, pTangents, numVertices * sizeof(Vector3f));
+		m_Tangents.assign(pTangents, pTangents + numVertices);
+		m_FormatFlags |= FormatFlag_Tangent;
+	}
+}
 
+VertexData::VertexData(std::vector<Vector3f>&& positions, std::vector<Vector3f>&& normals,
+	std::vector<Vector2f>&& texCoords, std::vector<Vector4f>&& colors, std::vector<Vector3f>&& tangents)
+	: m_NumVertices(positions.size())
+	, m_FormatFlags(FormatFlag_Position)
+	, m_Positions(std::move(positions))
+	, m_Normals(std::move(normals))
+	, m_TexCoords(std::move(texCoords))
+	, m_Colors(std::move(colors))
+	, m_Tangents(std::move(tangents))
+{
+	assert(m_NumVertices > 0);
+	if (!m_Colors.empty())
+	{
+		assert(m_Colors.size() == m_NumVertices);
+		m_FormatFlags |= FormatFlag_Color;
+	}
+	if (!m_Normals.empty())
+	{
+		assert(m_Normals.size() == m_NumVertices);
+		m_FormatFlags |= FormatFlag_Normal;
+	}
+	if (!m_TexCoords.empty())
+	{
+		assert(m_TexCoords.size() == m_NumVertices);
+		m_FormatFlags |= FormatFlag_TexCoords;
+	}
+	if (!m_Tangents.empty())
+	{
+		assert(m_Tangents.size() == m_NumVertices);
 		m_FormatFlags |= FormatFlag_Tangent;
 	}
 }
 
 VertexData::~VertexData()
 {
-	SafeArrayDelete(m_pPositions);
-	SafeArrayDelete(m_pNormals);
-	SafeArrayDelete(m_pTexCoords);
-	SafeArrayDelete(m_pColors);
-	SafeArrayDelete(m_pTangents);
 }
 
 Vector3f* VertexData::GetPositions()
 {
 	assert((m_FormatFlags & FormatFlag_Position) != 0);
-	return m_pPositions;
+	return m_Positions.data();
 }
 
 const Vector3f* VertexData::GetPositions() const
 {
 	assert((m_FormatFlags & FormatFlag_Position) != 0);
-	return m_pPositions;
+	return m_Positions.data();
 }
 
 Vector3f* VertexData::GetNormals()
 {
 	assert((m_FormatFlags & FormatFlag_Normal) != 0);
-	return m_pNormals;
+	return m_Normals.data();
 }
 
 const Vector3f* VertexData::GetNormals() const
 {
 	assert((m_FormatFlags & FormatFlag_Normal) != 0);
-	return m_pNormals;
+	return m_Normals.data();
 }
 
 Vector2f* VertexData::GetTexCoords()
 {
 	assert((m_FormatFlags & FormatFlag_TexCoords) != 0);
-	return m_pTexCoords;
+	return m_TexCoords.data();
 }
 
 const Vector2f* VertexData::GetTexCoords() const
 {
 	assert((m_FormatFlags & FormatFlag_TexCoords) != 0);
-	return m_pTexCoords;
+	return m_TexCoords.data();
 }
 
 Vector4f* VertexData::GetColors()
 {
 	assert((m_FormatFlags & FormatFlag_Color) != 0);
-	return m_pColors;
+	return m_Colors.data();
 }
 
 const Vector4f* VertexData::GetColors() const
 {
 	assert((m_FormatFlags & FormatFlag_Color) != 0);
-	return m_pColors;
+	return m_Colors.data();
 }
 
 Vector3f* VertexData::GetTangents()
 {
 	assert((m_FormatFlags & FormatFlag_Tangent) != 0);
-	return m_pTangents;
+	return m_Tangents.data();
 }
 
 const Vector3f* VertexData::GetTangents() const
 {
 	assert((m_FormatFlags & FormatFlag_Tangent) != 0);
-	return m_pTangents;
+	return m_Tangents.data();
 }
 
 IndexData::IndexData(u32 numIndices, const u16* p16BitIndices)
 	: m_Format(DXGI_FORMAT_R16_UINT)
 	, m_NumIndices(numIndices)
-	, m_p16BitIndices(new u16[numIndices])
-	, m_p32BitIndices(nullptr)
+	, m_16BitIndices(p16BitIndices, p16BitIndices + numIndices)
 {
 	assert(((numIndices % 3) == 0) && (p16BitIndices != nullptr));
-	std::memcpy(m_p16BitIndices, p16BitIndices, numIndices * sizeof(u16));
 }
 
 IndexData::IndexData(u32 numIndices, const u32* p32BitIndices)
 	: m_Format(DXGI_FORMAT_R32_UINT)
 	, m_NumIndices(numIndices)
-	, m_p16BitIndices(nullptr)
-	, m_p32BitIndices(new u32[numIndices])
+	, m_32BitIndices(p32BitIndices, p32BitIndices + numIndices)
 {
 	assert(((numIndices % 3) == 0) && (p32BitIndices != nullptr));
-	std::memcpy(m_p32BitIndices, p32BitIndices, numIndices * sizeof(u32));
+}
+
+IndexData::IndexData(std::vector<u16>&& indices)
+	: m_Format(DXGI_FORMAT_R16_UINT)
+	, m_NumIndices(indices.size())
+	, m_16BitIndices(std::move(indices))
+{
+	assert((m_NumIndices % 3) == 0);
+}
+
+IndexData::IndexData(std::vector<u32>&& indices)
+	: m_Format(DXGI_FORMAT_R32_UINT)
+	, m_NumIndices(indices.size())
+	, m_32BitIndices(std::move(indices))
+{
+	assert((m_NumIndices % 3) == 0);
 }
 
 IndexData::~IndexData()
 {
-	SafeArrayDelete(m_p16BitIndices);
-	SafeArrayDelete(m_p32BitIndices);
 }
 
 u16* IndexData::Get16BitIndices()
 {
 	assert(m_Format == DXGI_FORMAT_R16_UINT);
-	return m_p16BitIndices;
+	return m_16BitIndices.data();
 }
 
 const u16* IndexData::Get16BitIndices() const
 {
 	assert(m_Format == DXGI_FORMAT_R16_UINT);
-	return m_p16BitIndices;
+	return m_16BitIndices.data();
 }
 
 u32* IndexData::Get32BitIndices()
 {
 	assert(m_Format == DXGI_FORMAT_R32_UINT);
-	return m_p32BitIndices;
+	return m_32BitIndices.data();
 }
 
 const u32* IndexData::Get32BitIndices() const
 {
 	assert(m_Format == DXGI_FORMAT_R32_UINT);
-	return m_p32BitIndices;
+	return m_32BitIndices.data();
 }
 
 Mesh::Mesh(VertexData* pVertexData, IndexData* pIndexData, u32 numInstances, Matrix4f* pInstanceWorldMatrices,
@@ -200,18 +223,14 @@ Mesh::~Mesh()
 
 void Mesh::RecalcInstanceWorldBounds()
 {
-	const u32 numVertices = m_pVertexData->GetNumVertices();
-	const Vector3f* localSpacePositions = m_pVertexData->GetPositions();
+	const AxisAlignedBox localAABB(m_pVertexData->GetNumVertices(), m_pVertexData->GetPositions());
+	const OrientedBox localOBB(localAABB.m_Center, BasisAxes(), localAABB.m_Radius);
 
-	std::vector<Vector3f> worldSpacePositions(numVertices);
 	for (u32 instanceIndex = 0; instanceIndex < m_NumInstances; ++instanceIndex)
 	{
 		const Matrix4f& instanceWorldMatrix = m_pInstanceWorldMatrices[instanceIndex];
 
-		for (u32 positionIndex = 0; positionIndex < numVertices; ++positionIndex)
-			worldSpacePositions[positionIndex] = TransformPoint(localSpacePositions[positionIndex], instanceWorldMatrix);
-		
-		m_pInstanceWorldAABBs[instanceIndex] = AxisAlignedBox(worldSpacePositions.size(), worldSpacePositions.data());
-		m_pInstanceWorldOBBs[instanceIndex] = OrientedBox(worldSpacePositions.size(), worldSpacePositions.data());
+		m_pInstanceWorldAABBs[instanceIndex] = TransformAxisAlignedBox(localAABB, instanceWorldMatrix);
+		m_pInstanceWorldOBBs[instanceIndex] = TransformOrientedBox(localOBB, instanceWorldMatrix);
 	}
 }
@@ -1,12 +1,33 @@
 #include "Scene/MeshBatch.h"
 #include "Scene/Mesh.h"
+#include "Scene/CookedScene.h"
+#include "Scene/MeshInstancing.h"
+#include "Scene/MeshOptimizer.h"
 #include "Math/Math.h"
+#include "Math/Transform.h"
+
+namespace
+{
+	template <typename T>
+	void GatherElements(const std::vector<u32>& sourceIndices, std::vector<T>* pElements);
+
+	u32 CalcMortonCode(const Vector3f& point, const Vector3f& minPoint, const Vector3f& scale);
+
+	template <typename Index>
+	u32 OptimizeMeshVertexFetch(u32 numVertices, u32 numIndices, Index* pIndices, std::vector<u32>* pVertexRemap);
+}
 
 MeshBatch::MeshBatch(u8 vertexFormatFlags, DXGI_FORMAT indexFormat, D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType, D3D12_PRIMITIVE_TOPOLOGY primitiveTopology)
 	: m_VertexFormatFlags(vertexFormatFlags)
+	, m_VertexCompressionFlags(VertexCompressionFlag_None)
 	, m_IndexFormat(indexFormat)
 	, m_PrimitiveTopologyType(primitiveTopologyType)
 	, m_PrimitiveTopology(primitiveTopology)
+	, m_NumVertices(0)
+	, m_NumIndices(0)
+	, m_GeometryResident(true)
+	, m_ReleasedGeometryHash(0)
+	, m_GeometrySourceOffset(0)
 	, m_MaxNumInstancesPerMesh(0)
 {
 	assert((m_IndexFormat == DXGI_FORMAT_R16_UINT) || (m_IndexFormat == DXGI_FORMAT_R32_UINT));
@@ -14,8 +35,6 @@ MeshBatch::MeshBatch(u8 vertexFormatFlags, DXGI_FORMAT indexFormat, D3D12_PRIMIT
 
 void MeshBatch::AddMesh(const Mesh* pMesh)
 {
-	m_MaxNumInstancesPerMesh = Max(m_MaxNumInstancesPerMesh, pMesh->GetNumInstances());
-
 	assert(m_PrimitiveTopology == pMesh->GetPrimitiveTopology());
 	assert(m_PrimitiveTopologyType == pMesh->GetPrimitiveTopologyType());
 
@@ -27,129 +46,669 @@ void MeshBatch::AddMesh(const Mesh* pMesh)
 	assert(pIndexData != nullptr);
 	assert(m_IndexFormat == pIndexData->GetFormat());
 
-	const i32 baseVertexLocation = (i32)GetNumVertices();
 	const u32 numVertices = pVertexData->GetNumVertices();
+	const u32 numIndices = pIndexData->GetNumIndices();
+	const u32 numInstances = pMesh->GetNumInstances();
+	
+	const MeshStreams streams = AppendMesh(numVertices, numIndices, numInstances, pMesh->GetMaterialID());
+
+	std::copy(pVertexData->GetPositions(), pVertexData->GetPositions() + numVertices, streams.m_pPositions);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
+		std::copy(pVertexData->GetNormals(), pVertexData->GetNormals() + numVertices, streams.m_pNormals);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
+		std::copy(pVertexData->GetTexCoords(), pVertexData->GetTexCoords() + numVertices, streams.m_pTexCoords);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_Color) != 0)
+		std::copy(pVertexData->GetColors(), pVertexData->GetColors() + numVertices, streams.m_pColors);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
+		std::copy(pVertexData->GetTangents(), pVertexData->GetTangents() + numVertices, streams.m_pTangents);
+
+	if (m_IndexFormat == DXGI_FORMAT_R16_UINT)
+		std::copy(pIndexData->Get16BitIndices(), pIndexData->Get16BitIndices() + numIndices, streams.m_p16BitIndices);
+	else
+		std::copy(pIndexData->Get32BitIndices(), pIndexData->Get32BitIndices() + numIndices, streams.m_p32BitIndices);
+
+	std::copy(pMesh->GetInstanceWorldMatrices(), pMesh->GetInstanceWorldMatrices() + numInstances, streams.m_pInstanceWorldMatrices);
+	FinishMesh(GetNumMeshes() - 1);
+}
+
+void MeshBatch::Reserve(u32 numMeshes, u32 numVertices, u32 numIndices, u32 numInstances)
+{
+	assert(IsGeometryResident());
 
+	m_Positions.reserve(numVertices);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
+		m_Normals.reserve(numVertices);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
+		m_TexCoords.reserve(numVertices);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_Color) != 0)
+		m_Colors.reserve(numVertices);
+	
+	if ((m_VertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
+		m_Tangents.reserve(numVertices);
+
+	if (m_IndexFormat == DXGI_FORMAT_R16_UINT)
+		m_16BitIndices.reserve(numIndices);
+	else
+		m_32BitIndices.reserve(numIndices);
+
+	m_MeshInfos.reserve(numMeshes);
+	m_MeshLocalAABBs.reserve(numMeshes);
+	m_MeshInstanceWorldAABBs.reserve(numInstances);
+	m_MeshInstanceWorldOBBs.reserve(numInstances);
+	m_MeshInstanceWorldMatrices.reserve(numInstances);
+	m_MeshInstanceFlags.reserve(numInstances);
+}
+
+MeshBatch::MeshStreams MeshBatch::AppendMesh(u32 numVertices, u32 numIndices, u32 numInstances, u32 materialID)
+{
+	assert(!HasMeshClusters());
+	assert(IsGeometryResident());
+	assert((numVertices > 0) && (numIndices > 0) && (numInstances > 0));
+	
+	m_MaxNumInstancesPerMesh = Max(m_MaxNumInstancesPerMesh, numInstances);
+	m_GeometrySourceFilePath.clear();
+
+	const u32 baseVertexLocation = GetNumVertices();
+	const u32 startIndexLocation = GetNumIndices();
+	const u32 instanceOffset = GetNumMeshInstances();
+
+	m_NumVertices += numVertices;
+	m_NumIndices += numIndices;
+
+	MeshStreams streams;
 	{
-		m_Positions.insert(m_Positions.end(),
-			pVertexData->GetPositions(),
-			pVertexData->GetPositions() + numVertices);
-	}	
+		m_Positions.resize(baseVertexLocation + numVertices);
+		streams.m_pPositions = &m_Positions[baseVertexLocation];
+	}
 	if ((m_VertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
 	{
-		m_Normals.insert(m_Normals.end(),
-			pVertexData->GetNormals(),
-			pVertexData->GetNormals() + numVertices);
+		m_Normals.resize(baseVertexLocation + numVertices);
+		streams.m_pNormals = &m_Normals[baseVertexLocation];
 	}
 	if ((m_VertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
 	{
-		m_TexCoords.insert(m_TexCoords.end(),
-			pVertexData->GetTexCoords(),
-			pVertexData->GetTexCoords() + numVertices);
+		m_TexCoords.resize(baseVertexLocation + numVertices);
+		streams.m_pTexCoords = &m_TexCoords[baseVertexLocation];
 	}
 	if ((m_VertexFormatFlags & VertexData::FormatFlag_Color) != 0)
 	{
-		m_Colors.insert(m_Colors.end(),
-			pVertexData->GetColors(),
-			pVertexData->GetColors() + numVertices);
+		m_Colors.resize(baseVertexLocation + numVertices);
+		streams.m_pColors = &m_Colors[baseVertexLocation];
 	}
 	if ((m_VertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
 	{
-		m_Tangents.insert(m_Tangents.end(),
-			pVertexData->GetTangents(),
-			pVertexData->GetTangents() + numVertices);
+		m_Tangents.resize(baseVertexLocation + numVertices);
+		streams.m_pTangents = &m_Tangents[baseVertexLocation];
 	}
 	
-	const u32 startIndexLocation = GetNumIndices();
-	const u32 numIndices = pIndexData->GetNumIndices();
-
 	if (m_IndexFormat == DXGI_FORMAT_R16_UINT)
 	{
-		m_16BitIndices.insert(m_16BitIndices.end(),
-			pIndexData->Get16BitIndices(),
-			pIndexData->Get16BitIndices() + numIndices);
+		m_16BitIndices.resize(startIndexLocation + numIndices);
+		streams.m_p16BitIndices = &m_16BitIndices[startIndexLocation];
 	}
 	else
 	{
-		m_32BitIndices.insert(m_32BitIndices.end(),
-			pIndexData->Get32BitIndices(),
-			pIndexData->Get32BitIndices() + numIndices);
+		m_32BitIndices.resize(startIndexLocation + numIndices);
+		streams.m_p32BitIndices = &m_32BitIndices[startIndexLocation];
 	}
 
-	const u32 numInstances = pMesh->GetNumInstances();
-	const u32 instanceOffset = GetNumMeshInstances();
-	
 	m_MeshInfos.emplace_back(numInstances,
 		instanceOffset,
 		numIndices,
 		numVertices,
 		startIndexLocation,
-		baseVertexLocation,
-		pMesh->GetMaterialID());
-	
-	m_MeshInstanceWorldAABBs.insert(m_MeshInstanceWorldAABBs.end(),
-		pMesh->GetInstanceWorldAABBs(),
-		pMesh->GetInstanceWorldAABBs() + numInstances);
+		(i32)baseVertexLocation,
+		materialID);
+	m_MeshLocalAABBs.emplace_back();
 
-	m_MeshInstanceWorldOBBs.insert(m_MeshInstanceWorldOBBs.end(),
-		pMesh->GetInstanceWorldOBBs(),
-		pMesh->GetInstanceWorldOBBs() + numInstances);
+	m_MeshInstanceWorldAABBs.resize(instanceOffset + numInstances);
+	m_MeshInstanceWorldOBBs.resize(instanceOffset + numInstances);
+	m_MeshInstanceWorldMatrices.resize(instanceOffset + numInstances);
+	m_MeshInstanceFlags.resize(instanceOffset + numInstances, MeshInstanceFlag_None);
+
+	streams.m_pInstanceWorldMatrices = &m_MeshInstanceWorldMatrices[instanceOffset];
+	streams.m_pInstanceFlags = &m_MeshInstanceFlags[instanceOffset];
 	
-	m_MeshInstanceWorldMatrices.insert(m_MeshInstanceWorldMatrices.end(),
-		pMesh->GetInstanceWorldMatrices(),
-		pMesh->GetInstanceWorldMatrices() + numInstances);
+	return streams;
+}
+
+void MeshBatch::FinishMesh(u32 meshIndex)
+{
+	const MeshInfo& meshInfo = m_MeshInfos[meshIndex];
+	m_MeshLocalAABBs[meshIndex] = AxisAlignedBox(meshInfo.m_VertexCount, &m_Positions[meshInfo.m_BaseVertexLocation]);
+
+	for (u32 instanceIndex = meshInfo.m_InstanceOffset; instanceIndex < meshInfo.m_InstanceOffset + meshInfo.m_InstanceCount; ++instanceIndex)
+		CalcMeshInstanceWorldBounds(meshIndex, instanceIndex);
+}
+
+void MeshBatch::SetMeshInstanceWorldMatrix(u32 meshIndex, u32 meshInstanceIndex, const Matrix4f& worldMatrix)
+{
+	const MeshInfo& meshInfo = m_MeshInfos[meshIndex];
+	assert(meshInstanceIndex < meshInfo.m_InstanceCount);
+
+	const u32 instanceIndex = meshInfo.m_InstanceOffset + meshInstanceIndex;
+	assert(IsMeshInstanceDynamic(instanceIndex));
+
+	m_MeshInstanceWorldMatrices[instanceIndex] = worldMatrix;
+	CalcMeshInstanceWorldBounds(meshIndex, instanceIndex);
+
+	m_DirtyMeshInstanceIndices.emplace_back(instanceIndex);
+}
+
+void MeshBatch::ExtractDirtyMeshInstanceRanges(std::vector<MeshInstanceRange>* pRanges, u32 maxGap)
+{
+	pRanges->clear();
+
+	std::sort(m_DirtyMeshInstanceIndices.begin(), m_DirtyMeshInstanceIndices.end());
+	m_DirtyMeshInstanceIndices.erase(std::unique(m_DirtyMeshInstanceIndices.begin(), m_DirtyMeshInstanceIndices.end()), m_DirtyMeshInstanceIndices.end());
+
+	for (u32 instanceIndex : m_DirtyMeshInstanceIndices)
+	{
+		if (!pRanges->empty())
+		{
+			MeshInstanceRange& lastRange = pRanges->back();
+			if (instanceIndex <= lastRange.m_FirstInstance + lastRange.m_NumInstances + maxGap)
+			{
+				lastRange.m_NumInstances = instanceIndex + 1 - lastRange.m_FirstInstance;
+				continue;
+			}
+		}
+		pRanges->push_back({instanceIndex, 1});
+	}
+
+	m_DirtyMeshInstanceIndices.clear();
+}
+
+void MeshBatch::CalcMeshInstanceWorldBounds(u32 meshIndex, u32 instanceIndex)
+{
+	const AxisAlignedBox& localAABB = m_MeshLocalAABBs[meshIndex];
+	const Matrix4f& worldMatrix = m_MeshInstanceWorldMatrices[instanceIndex];
+
+	m_MeshInstanceWorldAABBs[instanceIndex] = TransformAxisAlignedBox(localAABB, worldMatrix);
+	m_MeshInstanceWorldOBBs[instanceIndex] = TransformOrientedBox(OrientedBox(localAABB.m_Center, BasisAxes(), localAABB.m_Radius), worldMatrix);
+}
+
+void MeshBatch::ClassifyMeshInstances(std::vector<u32>* pStaticMeshInstanceIndices, std::vector<u32>* pDynamicMeshInstanceIndices) const
+{
+	assert(pStaticMeshInstanceIndices != nullptr);
+	assert(pDynamicMeshInstanceIndices != nullptr);
+
+	pStaticMeshInstanceIndices->clear();
+	pDynamicMeshInstanceIndices->clear();
+
+	for (u32 instanceIndex = 0; instanceIndex < GetNumMeshInstances(); ++instanceIndex)
+	{
+		if (IsMeshInstanceDynamic(instanceIndex))
+			pDynamicMeshInstanceIndices->push_back(instanceIndex);
+		else
+			pStaticMeshInstanceIndices->push_back(instanceIndex);
+	}
+}
+
+void MeshBatch::SortByMortonCode(bool sortMeshes)
+{
+	const u32 numMeshes = GetNumMeshes();
+	const u32 numInstances = GetNumMeshInstances();
+	if (numInstances == 0)
+		return;
+
+	std::vector<Vector3f> instanceCenters(numInstances);
+	for (u32 instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
+		instanceCenters[instanceIndex] = m_MeshInstanceWorldAABBs[instanceIndex].m_Center;
+
+	const AxisAlignedBox centerBounds(numInstances, instanceCenters.data());
+	const Vector3f minPoint = centerBounds.m_Center - centerBounds.m_Radius;
+	const Vector3f extent = 2.0f * centerBounds.m_Radius;
+	const Vector3f scale(
+		(extent.m_X > 0.0f) ? 1023.0f / extent.m_X : 0.0f,
+		(extent.m_Y > 0.0f) ? 1023.0f / extent.m_Y : 0.0f,
+		(extent.m_Z > 0.0f) ? 1023.0f / extent.m_Z : 0.0f);
+
+	std::vector<u32> instanceMortonCodes(numInstances);
+	for (u32 instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
+		instanceMortonCodes[instanceIndex] = CalcMortonCode(instanceCenters[instanceIndex], minPoint, scale);
+
+	std::vector<u32> sourceMeshIndices(numMeshes);
+	for (u32 meshIndex = 0; meshIndex < numMeshes; ++meshIndex)
+		sourceMeshIndices[meshIndex] = meshIndex;
+
+	if (sortMeshes)
+	{
+		std::vector<u32> meshMortonCodes(numMeshes);
+		for (u32 meshIndex = 0; meshIndex < numMeshes; ++meshIndex)
+		{
+			const MeshInfo& meshInfo = m_MeshInfos[meshIndex];
+			assert(meshInfo.m_InstanceCount > 0);
+
+			AxisAlignedBox meshBounds = m_MeshInstanceWorldAABBs[meshInfo.m_InstanceOffset];
+			for (u32 instanceIndex = meshInfo.m_InstanceOffset + 1; instanceIndex < meshInfo.m_InstanceOffset + meshInfo.m_InstanceCount; ++instanceIndex)
+				meshBounds = AxisAlignedBox(meshBounds, m_MeshInstanceWorldAABBs[instanceIndex]);
+
+			meshMortonCodes[meshIndex] = CalcMortonCode(meshBounds.m_Center, minPoint, scale);
+		}
+
+		std::stable_sort(sourceMeshIndices.begin(), sourceMeshIndices.end(), [&meshMortonCodes](u32 meshIndex1, u32 meshIndex2)
+		{
+			return (meshMortonCodes[meshIndex1] < meshMortonCodes[meshIndex2]);
+		});
+	}
+
+	// Instances are regrouped in the new mesh order, so the instance offsets of the meshes need to be updated.
+	std::vector<u32> sourceInstanceIndices;
+	sourceInstanceIndices.reserve(numInstances);
+	for (u32 meshIndex : sourceMeshIndices)
+	{
+		MeshInfo& meshInfo = m_MeshInfos[meshIndex];
+
+		const u32 instanceOffset = sourceInstanceIndices.size();
+		for (u32 instanceIndex = meshInfo.m_InstanceOffset; instanceIndex < meshInfo.m_InstanceOffset + meshInfo.m_InstanceCount; ++instanceIndex)
+			sourceInstanceIndices.push_back(instanceIndex);
+
+		std::stable_sort(sourceInstanceIndices.begin() + instanceOffset, sourceInstanceIndices.end(), [&instanceMortonCodes](u32 instanceIndex1, u32 instanceIndex2)
+		{
+			return (instanceMortonCodes[instanceIndex1] < instanceMortonCodes[instanceIndex2]);
+		});
+		meshInfo.m_InstanceOffset = instanceOffset;
+	}
+
+	GatherElements(sourceMeshIndices, &m_MeshInfos);
+	GatherElements(sourceMeshIndices, &m_MeshLocalAABBs);
+	if (!m_MeshVertexQuantizations.empty())
+		GatherElements(sourceMeshIndices, &m_MeshVertexQuantizations);
+	if (!m_MeshClusterRanges.empty())
+		GatherElements(sourceMeshIndices, &m_MeshClusterRanges);
+
+	GatherElements(sourceInstanceIndices, &m_MeshInstanceWorldAABBs);
+	GatherElements(sourceInstanceIndices, &m_MeshInstanceWorldOBBs);
+	GatherElements(sourceInstanceIndices, &m_MeshInstanceWorldMatrices);
+	GatherElements(sourceInstanceIndices, &m_MeshInstanceFlags);
+
+	std::vector<u32> newInstanceIndices(numInstances);
+	for (u32 instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
+		newInstanceIndices[sourceInstanceIndices[instanceIndex]] = instanceIndex;
+
+	for (u32& instanceIndex : m_DirtyMeshInstanceIndices)
+		instanceIndex = newInstanceIndices[instanceIndex];
+}
+
+void MeshBatch::BuildMeshClusters(u32 maxNumVerticesPerCluster, u32 maxNumTrianglesPerCluster)
+{
+	assert(m_PrimitiveTopology == D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	assert(IsGeometryResident());
+
+	// Triangles are reordered, so the geometry no longer matches the source.
+	m_GeometrySourceFilePath.clear();
+
+	m_MeshClusters.clear();
+	m_MeshClusterRanges.clear();
+	m_MeshClusterRanges.reserve(m_MeshInfos.size());
+
+	std::vector<MeshCluster> meshClusters;
+	std::vector<u32> vertexRemap;
+	for (const MeshInfo& meshInfo : m_MeshInfos)
+	{
+		const Vector3f* pMeshPositions = &m_Positions[meshInfo.m_BaseVertexLocation];
+		
+		// Triangles are stored in cluster order now, so the vertices are renumbered again in the order of first use.
+		// Positions referenced by the indices do not change, so the cluster bounds and cones stay valid.
+		u32 numRemappedVertices = 0;
+		if (m_IndexFormat == DXGI_FORMAT_R16_UINT)
+		{
+			u16* pMeshIndices = &m_16BitIndices[meshInfo.m_StartIndexLocation];
+			::BuildMeshClusters(pMeshPositions, meshInfo.m_IndexCount, pMeshIndices,
+				maxNumVerticesPerCluster, maxNumTrianglesPerCluster, &meshClusters);
+			numRemappedVertices = OptimizeMeshVertexFetch(meshInfo.m_VertexCount, meshInfo.m_IndexCount, pMeshIndices, &vertexRemap);
+		}
+		else
+		{
+			u32* pMeshIndices = &m_32BitIndices[meshInfo.m_StartIndexLocation];
+			::BuildMeshClusters(pMeshPositions, meshInfo.m_IndexCount, pMeshIndices,
+				maxNumVerticesPerCluster, maxNumTrianglesPerCluster, &meshClusters);
+			numRemappedVertices = OptimizeMeshVertexFetch(meshInfo.m_VertexCount, meshInfo.m_IndexCount, pMeshIndices, &vertexRemap);
+		}
+
+		// Vertices which are not referenced keep their old data past the remapped ones and are never fetched.
+		const u32 baseVertex = meshInfo.m_BaseVertexLocation;
+		RemapVertices(meshInfo.m_VertexCount, &m_Positions[baseVertex], numRemappedVertices, vertexRemap.data());
+		
+		if ((m_VertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
+			RemapVertices(meshInfo.m_VertexCount, &m_Normals[baseVertex], numRemappedVertices, vertexRemap.data());
+		
+		if ((m_VertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
+			RemapVertices(meshInfo.m_VertexCount, &m_TexCoords[baseVertex], numRemappedVertices, vertexRemap.data());
+		
+		if ((m_VertexFormatFlags & VertexData::FormatFlag_Color) != 0)
+			RemapVertices(meshInfo.m_VertexCount, &m_Colors[baseVertex], numRemappedVertices, vertexRemap.data());
+		
+		if ((m_VertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
+			RemapVertices(meshInfo.m_VertexCount, &m_Tangents[baseVertex], numRemappedVertices, vertexRemap.data());
+
+		MeshClusterRange clusterRange;
+		clusterRange.m_FirstCluster = m_MeshClusters.size();
+		clusterRange.m_NumClusters = meshClusters.size();
+		m_MeshClusterRanges.push_back(clusterRange);
+
+		for (MeshCluster& cluster : meshClusters)
+		{
+			cluster.m_StartIndexLocation += meshInfo.m_StartIndexLocation;
+			m_MeshClusters.push_back(cluster);
+		}
+	}
+}
+
+void MeshBatch::SelectVertexCompression(const VertexPrecisionBudget& budget)
+{
+	assert(IsGeometryResident());
+
+	m_VertexCompressionFlags = VertexCompressionFlag_None;
+
+	const u32 numVertices = GetNumVertices();
+	if (numVertices == 0)
+		return;
+
+	// Positions and texture coordinates are quantized to the ranges of each mesh, so that a large or tiled mesh
+	// does not take the precision of the other meshes. The batch shares a vertex format, so every mesh has to fit the budget.
+	const bool hasTexCoords = ((m_VertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0);
+	bool positionsFitBudget = true;
+	bool texCoordsFitBudget = hasTexCoords;
+
+	m_MeshVertexQuantizations.resize(m_MeshInfos.size());
+	for (u32 meshIndex = 0; meshIndex < m_MeshInfos.size(); ++meshIndex)
+	{
+		const MeshInfo& meshInfo = m_MeshInfos[meshIndex];
+		const Vector2f* pTexCoords = hasTexCoords ? &m_TexCoords[meshInfo.m_BaseVertexLocation] : nullptr;
+
+		VertexQuantization& quantization = m_MeshVertexQuantizations[meshIndex];
+		quantization = CalcVertexQuantization(meshInfo.m_VertexCount, &m_Positions[meshInfo.m_BaseVertexLocation], pTexCoords);
+
+		// The error grows with the largest scale the instances apply to the local space positions.
+		f32 maxSquaredInstanceScale = 0.0f;
+		for (u32 instanceIndex = meshInfo.m_InstanceOffset; instanceIndex < meshInfo.m_InstanceOffset + meshInfo.m_InstanceCount; ++instanceIndex)
+		{
+			const Matrix4f& worldMatrix = m_MeshInstanceWorldMatrices[instanceIndex];
+			maxSquaredInstanceScale = Max(maxSquaredInstanceScale, Sqr(worldMatrix.m_00) + Sqr(worldMatrix.m_01) + Sqr(worldMatrix.m_02));
+			maxSquaredInstanceScale = Max(maxSquaredInstanceScale, Sqr(worldMatrix.m_10) + Sqr(worldMatrix.m_11) + Sqr(worldMatrix.m_12));
+			maxSquaredInstanceScale = Max(maxSquaredInstanceScale, Sqr(worldMatrix.m_20) + Sqr(worldMatrix.m_21) + Sqr(worldMatrix.m_22));
+		}
+
+		positionsFitBudget &= (CalcPositionQuantizationError(quantization) * Sqrt(maxSquaredInstanceScale) <= budget.m_MaxPositionError);
+		texCoordsFitBudget &= (CalcTexCoordQuantizationError(quantization) <= budget.m_MaxTexCoordError);
+	}
+
+	if (positionsFitBudget)
+		m_VertexCompressionFlags |= VertexCompressionFlag_Position;
+
+	if (((m_VertexFormatFlags & VertexData::FormatFlag_Normal) != 0) &&
+		(CalcOctahedralEncodingErrorInDegrees(numVertices, m_Normals.data()) <= budget.m_MaxNormalErrorInDegrees))
+		m_VertexCompressionFlags |= VertexCompressionFlag_Normal;
+
+	if (((m_VertexFormatFlags & VertexData::FormatFlag_Tangent) != 0) &&
+		(CalcOctahedralEncodingErrorInDegrees(numVertices, m_Tangents.data()) <= budget.m_MaxNormalErrorInDegrees))
+		m_VertexCompressionFlags |= VertexCompressionFlag_Tangent;
+
+	if (texCoordsFitBudget)
+		m_VertexCompressionFlags |= VertexCompressionFlag_TexCoords;
 }
 
 u32 MeshBatch::GetNumVertices() const
 {
-	return m_Positions.size();
+	return m_NumVertices;
 }
 
 const Vector3f* MeshBatch::GetPositions() const
 {
+	assert(IsGeometryResident());
 	assert((m_VertexFormatFlags & VertexData::FormatFlag_Position) != 0);
 	return &m_Positions[0];
 }
 
 const Vector3f* MeshBatch::GetNormals() const
 {
+	assert(IsGeometryResident());
 	assert((m_VertexFormatFlags & VertexData::FormatFlag_Normal) != 0);
 	return &m_Normals[0];
 }
 
 const Vector2f* MeshBatch::GetTexCoords() const
 {
+	assert(IsGeometryResident());
 	assert((m_VertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0);
 	return &m_TexCoords[0];
 }
 
 const Vector4f* MeshBatch::GetColors() const
 {
+	assert(IsGeometryResident());
 	assert((m_VertexFormatFlags & VertexData::FormatFlag_Color) != 0);
 	return &m_Colors[0];
 }
 
 const Vector3f* MeshBatch::GetTangents() const
 {
+	assert(IsGeometryResident());
 	assert((m_VertexFormatFlags & VertexData::FormatFlag_Tangent) != 0);
 	return &m_Tangents[0];
 }
 
 u32 MeshBatch::GetNumIndices() const
 {
-	if (m_IndexFormat == DXGI_FORMAT_R16_UINT)
-		return m_16BitIndices.size();
-	return m_32BitIndices.size();
+	return m_NumIndices;
 }
 
 const u16* MeshBatch::Get16BitIndices() const
 {
+	assert(IsGeometryResident());
 	assert(m_IndexFormat == DXGI_FORMAT_R16_UINT);
 	return &m_16BitIndices[0];
 }
 
 const u32* MeshBatch::Get32BitIndices() const
 {
+	assert(IsGeometryResident());
 	assert(m_IndexFormat == DXGI_FORMAT_R32_UINT);
 	return &m_32BitIndices[0];
 }
+
+void MeshBatch::SetGeometrySource(const wchar_t* pCookedSceneFilePath, u64 geometryOffset)
+{
+	m_GeometrySourceFilePath = pCookedSceneFilePath;
+	m_GeometrySourceOffset = geometryOffset;
+}
+
+bool MeshBatch::ReleaseGeometry()
+{
+	if (!HasGeometrySource())
+		return false;
+
+	if (IsGeometryResident())
+	{
+		m_ReleasedGeometryHash = CalcGeometryHash();
+		FreeGeometry();
+		m_GeometryResident = false;
+	}
+	return true;
+}
+
+u64 MeshBatch::CalcGeometryHash() const
+{
+	if (!IsGeometryResident())
+		return m_ReleasedGeometryHash;
+
+	u64 hash = HashBytes(&m_VertexFormatFlags, sizeof(m_VertexFormatFlags));
+	hash = HashBytes(&m_IndexFormat, sizeof(m_IndexFormat), hash);
+	for (const MeshInfo& meshInfo : m_MeshInfos)
+	{
+		hash = HashBytes(&meshInfo.m_IndexCount, sizeof(meshInfo.m_IndexCount), hash);
+		hash = HashBytes(&meshInfo.m_VertexCount, sizeof(meshInfo.m_VertexCount), hash);
+		hash = HashBytes(&meshInfo.m_StartIndexLocation, sizeof(meshInfo.m_StartIndexLocation), hash);
+		hash = HashBytes(&meshInfo.m_BaseVertexLocation, sizeof(meshInfo.m_BaseVertexLocation), hash);
+	}
+
+	hash = HashBytes(m_Positions.data(), m_Positions.size() * sizeof(m_Positions[0]), hash);
+	hash = HashBytes(m_Normals.data(), m_Normals.size() * sizeof(m_Normals[0]), hash);
+	hash = HashBytes(m_TexCoords.data(), m_TexCoords.size() * sizeof(m_TexCoords[0]), hash);
+	hash = HashBytes(m_Colors.data(), m_Colors.size() * sizeof(m_Colors[0]), hash);
+	hash = HashBytes(m_Tangents.data(), m_Tangents.size() * sizeof(m_Tangents[0]), hash);
+	hash = HashBytes(m_16BitIndices.data(), m_16BitIndices.size() * sizeof(m_16BitIndices[0]), hash);
+	hash = HashBytes(m_32BitIndices.data(), m_32BitIndices.size() * sizeof(m_32BitIndices[0]), hash);
+
+	return hash;
+}
+
+bool MeshBatch::MaterializeGeometry()
+{
+	if (IsGeometryResident())
+		return true;
+
+	assert(HasGeometrySource());
+	CookedSceneReader reader;
+	if (!reader.Open(m_GeometrySourceFilePath.c_str()) || !reader.Seek(m_GeometrySourceOffset))
+		return false;
+
+	// The file could have been cooked again since the batch was read from it.
+	// Streams of the same size are told apart by the hash recorded at release.
+	ReadGeometry(&reader);
+
+	const std::size_t numIndices = (m_IndexFormat == DXGI_FORMAT_R16_UINT) ? m_16BitIndices.size() : m_32BitIndices.size();
+	if (reader.HasFailed() || (m_Positions.size() != m_NumVertices) || (numIndices != m_NumIndices))
+	{
+		FreeGeometry();
+		return false;
+	}
+
+	m_GeometryResident = true;
+	if (CalcGeometryHash() != m_ReleasedGeometryHash)
+	{
+		FreeGeometry();
+		m_GeometryResident = false;
+		return false;
+	}
+	return true;
+}
+
+u64 MeshBatch::Serialize(CookedSceneWriter* pWriter) const
+{
+	assert(IsGeometryResident());
+
+	pWriter->WriteValue(m_VertexFormatFlags);
+	pWriter->WriteValue(m_IndexFormat);
+	pWriter->WriteValue(m_PrimitiveTopologyType);
+	pWriter->WriteValue(m_PrimitiveTopology);
+	pWriter->WriteValue(m_VertexCompressionFlags);
+	pWriter->WriteValue(m_MaxNumInstancesPerMesh);
+
+	const u64 geometryOffset = pWriter->GetOffset();
+	pWriter->WriteArray(m_Positions);
+	pWriter->WriteArray(m_Normals);
+	pWriter->WriteArray(m_TexCoords);
+	pWriter->WriteArray(m_Colors);
+	pWriter->WriteArray(m_Tangents);
+	pWriter->WriteArray(m_16BitIndices);
+	pWriter->WriteArray(m_32BitIndices);
+
+	pWriter->WriteArray(m_MeshInfos);
+	pWriter->WriteArray(m_MeshLocalAABBs);
+	pWriter->WriteArray(m_MeshVertexQuantizations);
+	pWriter->WriteArray(m_MeshClusterRanges);
+	pWriter->WriteArray(m_MeshClusters);
+	pWriter->WriteArray(m_MeshInstanceWorldAABBs);
+	pWriter->WriteArray(m_MeshInstanceWorldOBBs);
+	pWriter->WriteArray(m_MeshInstanceWorldMatrices);
+	pWriter->WriteArray(m_MeshInstanceFlags);
+
+	return geometryOffset;
+}
+
+MeshBatch* MeshBatch::Deserialize(CookedSceneReader* pReader)
+{
+	const u8 vertexFormatFlags = pReader->ReadValue<u8>();
+	const DXGI_FORMAT indexFormat = pReader->ReadValue<DXGI_FORMAT>();
+	const D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType = pReader->ReadValue<D3D12_PRIMITIVE_TOPOLOGY_TYPE>();
+	const D3D12_PRIMITIVE_TOPOLOGY primitiveTopology = pReader->ReadValue<D3D12_PRIMITIVE_TOPOLOGY>();
+
+	MeshBatch* pMeshBatch = new MeshBatch(vertexFormatFlags, indexFormat, primitiveTopologyType, primitiveTopology);
+	pMeshBatch->m_VertexCompressionFlags = pReader->ReadValue<u8>();
+	pMeshBatch->m_MaxNumInstancesPerMesh = pReader->ReadValue<u32>();
+
+	pMeshBatch->SetGeometrySource(pReader->GetFilePath().c_str(), pReader->GetOffset());
+	pMeshBatch->ReadGeometry(pReader);
+	pMeshBatch->m_NumVertices = pMeshBatch->m_Positions.size();
+	pMeshBatch->m_NumIndices = (indexFormat == DXGI_FORMAT_R16_UINT) ? pMeshBatch->m_16BitIndices.size() : pMeshBatch->m_32BitIndices.size();
+
+	pReader->ReadArray(&pMeshBatch->m_MeshInfos);
+	pReader->ReadArray(&pMeshBatch->m_MeshLocalAABBs);
+	pReader->ReadArray(&pMeshBatch->m_MeshVertexQuantizations);
+	pReader->ReadArray(&pMeshBatch->m_MeshClusterRanges);
+	pReader->ReadArray(&pMeshBatch->m_MeshClusters);
+	pReader->ReadArray(&pMeshBatch->m_MeshInstanceWorldAABBs);
+	pReader->ReadArray(&pMeshBatch->m_MeshInstanceWorldOBBs);
+	pReader->ReadArray(&pMeshBatch->m_MeshInstanceWorldMatrices);
+	pReader->ReadArray(&pMeshBatch->m_MeshInstanceFlags);
+
+	return pMeshBatch;
+}
+
+void MeshBatch::ReadGeometry(CookedSceneReader* pReader)
+{
+	pReader->ReadArray(&m_Positions);
+	pReader->ReadArray(&m_Normals);
+	pReader->ReadArray(&m_TexCoords);
+	pReader->ReadArray(&m_Colors);
+	pReader->ReadArray(&m_Tangents);
+	pReader->ReadArray(&m_16BitIndices);
+	pReader->ReadArray(&m_32BitIndices);
+}
+
+void MeshBatch::FreeGeometry()
+{
+	// Swapping with empty vectors frees the memory, which clear would keep.
+	std::vector<Vector3f>().swap(m_Positions);
+	std::vector<Vector3f>().swap(m_Normals);
+	std::vector<Vector2f>().swap(m_TexCoords);
+	std::vector<Vector4f>().swap(m_Colors);
+	std::vector<Vector3f>().swap(m_Tangents);
+	std::vector<u16>().swap(m_16BitIndices);
+	std::vector<u32>().swap(m_32BitIndices);
+}
+
+namespace
+{
+	template <typename T>
+	void GatherElements(const std::vector<u32>& sourceIndices, std::vector<T>* pElements)
+	{
+		assert(sourceIndices.size() == pElements->size());
+
+		std::vector<T> gatheredElements;
+		gatheredElements.reserve(sourceIndices.size());
+
+		for (u32 sourceIndex : sourceIndices)
+			gatheredElements.push_back((*pElements)[sourceIndex]);
+
+		pElements->swap(gatheredElements);
+	}
+
+	u32 CalcMortonCode(const Vector3f& point, const Vector3f& minPoint, const Vector3f& scale)
+	{
+		const Vector3f normalizedPoint = (point - minPoint) * scale;
+		return EncodeMortonCode(u32(normalizedPoint.m_X + 0.5f), u32(normalizedPoint.m_Y + 0.5f), u32(normalizedPoint.m_Z + 0.5f));
+	}
+
+	template <typename Index>
+	u32 OptimizeMeshVertexFetch(u32 numVertices, u32 numIndices, Index* pIndices, std::vector<u32>* pVertexRemap)
+	{
+		std::vector<u32> indices(pIndices, pIndices + numIndices);
+		const u32 numRemappedVertices = OptimizeVertexFetch(numVertices, numIndices, indices.data(), pVertexRemap);
+
+		for (u32 it = 0; it < numIndices; ++it)
+			pIndices[it] = Index(indices[it]);
+
+		return numRemappedVertices;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,442 @@
+#include "Scene/MeshCluster.h"
+#include "Scene/MeshBatch.h"
+#include "Scene/MeshOptimizer.h"
+#include "Math/Frustum.h"
+#include "Math/Matrix4.h"
+#include "Math/Vector4.h"
+#include "Math/OverlapTest.h"
+#include "Math/Math.h"
+
+namespace
+{
+	static const f32 kDisabledConeCutoff = 2.0f;
+	static const u32 kInvalidIndex = ~0u;
+
+	template <typename Index>
+	void BuildMeshClustersImpl(const Vector3f* pPositions, u32 numIndices, Index* pIndices,
+		u32 maxNumVerticesPerCluster, u32 maxNumTrianglesPerCluster, std::vector<MeshCluster>* pClusters);
+
+	MeshCluster CreateMeshCluster(const Vector3f* pPositions, u32 startIndexLocation, u32 numIndices, const u32* pIndices,
+		u32 numVertices, const u32* pVertexIndices);
+
+	bool IsUniformScale(const Matrix4f& worldMatrix);
+	f32 CalcMaxScale(const Matrix4f& worldMatrix);
+	bool IsOccluded(const AxisAlignedBox& worldAABB, const Matrix4f& viewProjMatrix, const OcclusionDepthBuffer& depthBuffer);
+}
+
+void BuildMeshClusters(const Vector3f* pPositions, u32 numIndices, u16* pIndices,
+	u32 maxNumVerticesPerCluster, u32 maxNumTrianglesPerCluster, std::vector<MeshCluster>* pClusters)
+{
+	BuildMeshClustersImpl(pPositions, numIndices, pIndices, maxNumVerticesPerCluster, maxNumTrianglesPerCluster, pClusters);
+}
+
+void BuildMeshClusters(const Vector3f* pPositions, u32 numIndices, u32* pIndices,
+	u32 maxNumVerticesPerCluster, u32 maxNumTrianglesPerCluster, std::vector<MeshCluster>* pClusters)
+{
+	BuildMeshClustersImpl(pPositions, numIndices, pIndices, maxNumVerticesPerCluster, maxNumTrianglesPerCluster, pClusters);
+}
+
+void CullMeshClusters(const MeshBatch* pMeshBatch, const MeshClusterCullingParams& params,
+	std::vector<VisibleMeshCluster>* pVisibleClusters, MeshClusterCullingStats* pStats)
+{
+	assert(pMeshBatch->HasMeshClusters());
+	assert(params.m_pCameraWorldFrustum != nullptr);
+	assert((params.m_pOcclusionDepthBuffer == nullptr) || (params.m_pCameraViewProjMatrix != nullptr));
+
+	pVisibleClusters->clear();
+
+	MeshClusterCullingStats stats;
+	const MeshInfo* pMeshInfos = pMeshBatch->GetMeshInfos();
+	const MeshClusterRange* pClusterRanges = pMeshBatch->GetMeshClusterRanges();
+	const MeshCluster* pClusters = pMeshBatch->GetMeshClusters();
+	const Matrix4f* pInstanceWorldMatrices = pMeshBatch->GetMeshInstanceWorldMatrices();
+
+	for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+	{
+		const MeshInfo& meshInfo = pMeshInfos[meshIndex];
+		const MeshClusterRange& clusterRange = pClusterRanges[meshIndex];
+
+		for (u32 instanceIndex = meshInfo.m_InstanceOffset; instanceIndex < meshInfo.m_InstanceOffset + meshInfo.m_InstanceCount; ++instanceIndex)
+		{
+			const Matrix4f& worldMatrix = pInstanceWorldMatrices[instanceIndex];
+			const f32 maxScale = CalcMaxScale(worldMatrix);
+
+			// Normal cone is transformed as a direction, which is only valid if the scale is uniform.
+			const bool enableConeCulling = params.m_EnableConeCulling && IsUniformScale(worldMatrix);
+
+			for (u32 clusterIndex = clusterRange.m_FirstCluster; clusterIndex < clusterRange.m_FirstCluster + clusterRange.m_NumClusters; ++clusterIndex)
+			{
+				const MeshCluster& cluster = pClusters[clusterIndex];
+				const u32 numTriangles = cluster.m_IndexCount / 3;
+
+				++stats.m_NumTestedClusters;
+				stats.m_NumTestedTriangles += numTriangles;
+
+				const Sphere worldSphere(TransformPoint(cluster.m_BoundingSphere.m_Center, worldMatrix), maxScale * cluster.m_BoundingSphere.m_Radius);
+				if (!TestSphereAgainstFrustum(*params.m_pCameraWorldFrustum, worldSphere))
+				{
+					++stats.m_NumFrustumCulledClusters;
+					stats.m_NumFrustumCulledTriangles += numTriangles;
+					continue;
+				}
+
+				const Vector3f& center = cluster.m_AABB.m_Center;
+				const Vector3f& radius = cluster.m_AABB.m_Radius;
+				const Vector3f worldCorners[] =
+				{
+					TransformPoint(center + Vector3f(-radius.m_X, -radius.m_Y, -radius.m_Z), worldMatrix),
+					TransformPoint(center + Vector3f( radius.m_X, -radius.m_Y, -radius.m_Z), worldMatrix),
+					TransformPoint(center + Vector3f(-radius.m_X,  radius.m_Y, -radius.m_Z), worldMatrix),
+					TransformPoint(center + Vector3f( radius.m_X,  radius.m_Y, -radius.m_Z), worldMatrix),
+					TransformPoint(center + Vector3f(-radius.m_X, -radius.m_Y,  radius.m_Z), worldMatrix),
+					TransformPoint(center + Vector3f( radius.m_X, -radius.m_Y,  radius.m_Z), worldMatrix),
+					TransformPoint(center + Vector3f(-radius.m_X,  radius.m_Y,  radius.m_Z), worldMatrix),
+					TransformPoint(center + Vector3f( radius.m_X,  radius.m_Y,  radius.m_Z), worldMatrix)
+				};
+				const AxisAlignedBox worldAABB(ARRAYSIZE(worldCorners), worldCorners);
+				if (!TestAABBAgainstFrustum(*params.m_pCameraWorldFrustum, worldAABB))
+				{
+					++stats.m_NumFrustumCulledClusters;
+					stats.m_NumFrustumCulledTriangles += numTriangles;
+					continue;
+				}
+
+				if (enableConeCulling && (cluster.m_ConeCutoff <= 1.0f))
+				{
+					const Vector3f worldConeApex = TransformPoint(cluster.m_ConeApex, worldMatrix);
+					const Vector3f worldConeAxis = Normalize(TransformPoint(cluster.m_ConeAxis, worldMatrix) - TransformPoint(Vector3f::ZERO, worldMatrix));
+
+					if (Dot(Normalize(worldConeApex - params.m_CameraWorldPos), worldConeAxis) >= cluster.m_ConeCutoff)
+					{
+						++stats.m_NumBackfaceCulledClusters;
+						stats.m_NumBackfaceCulledTriangles += numTriangles;
+						continue;
+					}
+				}
+
+				if ((params.m_pOcclusionDepthBuffer != nullptr) && IsOccluded(worldAABB, *params.m_pCameraViewProjMatrix, *params.m_pOcclusionDepthBuffer))
+				{
+					++stats.m_NumOccludedClusters;
+					stats.m_NumOccludedTriangles += numTriangles;
+					continue;
+				}
+
+				VisibleMeshCluster visibleCluster;
+				visibleCluster.m_MeshInstanceIndex = instanceIndex;
+				visibleCluster.m_ClusterIndex = clusterIndex;
+
+				pVisibleClusters->push_back(visibleCluster);
+			}
+		}
+	}
+
+	if (pStats != nullptr)
+		*pStats = stats;
+}
+
+namespace
+{
+	template <typename Index>
+	void BuildMeshClustersImpl(const Vector3f* pPositions, u32 numIndices, Index* pIndices,
+		u32 maxNumVerticesPerCluster, u32 maxNumTrianglesPerCluster, std::vector<MeshCluster>* pClusters)
+	{
+		assert(numIndices % 3 == 0);
+		assert(maxNumVerticesPerCluster >= 3);
+		assert(maxNumTrianglesPerCluster >= 1);
+
+		pClusters->clear();
+
+		const u32 numTriangles = numIndices / 3;
+		if (numTriangles == 0)
+			return;
+
+		u32 numVertices = 0;
+		for (u32 it = 0; it < numIndices; ++it)
+			numVertices = Max(numVertices, u32(pIndices[it]) + 1);
+
+		// Triangles adjacent to vertex v are adjacentTriangles[adjacencyOffsets[v]], ..., adjacentTriangles[adjacencyOffsets[v + 1] - 1].
+		std::vector<u32> adjacencyOffsets(numVertices + 1, 0);
+		for (u32 it = 0; it < numIndices; ++it)
+			++adjacencyOffsets[pIndices[it] + 1];
+		for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+			adjacencyOffsets[vertexIndex + 1] += adjacencyOffsets[vertexIndex];
+
+		std::vector<u32> adjacentTriangles(numIndices);
+		{
+			std::vector<u32> insertOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (u32 it = 0; it < numIndices; ++it)
+				adjacentTriangles[insertOffsets[pIndices[it]]++] = it / 3;
+		}
+
+		std::vector<u8> isTriangleEmitted(numTriangles, 0);
+		// Position of the vertex in the current cluster or kInvalidIndex if the vertex is not in the cluster.
+		std::vector<u32> clusterVertexSlots(numVertices, kInvalidIndex);
+
+		std::vector<u32> clusterVertices;
+		clusterVertices.reserve(maxNumVerticesPerCluster);
+
+		std::vector<u32> clusterIndices;
+		clusterIndices.reserve(3 * maxNumTrianglesPerCluster);
+
+		std::vector<u32> localClusterIndices;
+		localClusterIndices.reserve(3 * maxNumTrianglesPerCluster);
+
+		std::vector<u32> reorderedIndices;
+		reorderedIndices.reserve(numIndices);
+
+		auto CountNewVertices = [&](u32 triangleIndex)
+		{
+			const u32 index0 = pIndices[3 * triangleIndex + 0];
+			const u32 index1 = pIndices[3 * triangleIndex + 1];
+			const u32 index2 = pIndices[3 * triangleIndex + 2];
+
+			u32 numNewVertices = (clusterVertexSlots[index0] == kInvalidIndex) ? 1 : 0;
+			if ((clusterVertexSlots[index1] == kInvalidIndex) && (index1 != index0))
+				++numNewVertices;
+			if ((clusterVertexSlots[index2] == kInvalidIndex) && (index2 != index0) && (index2 != index1))
+				++numNewVertices;
+
+			return numNewVertices;
+		};
+
+		auto FlushCluster = [&]()
+		{
+			// Greedy growth does not preserve the vertex cache order of the input triangles. Restore it inside the cluster.
+			localClusterIndices.clear();
+			for (const u32 vertexIndex : clusterIndices)
+				localClusterIndices.push_back(clusterVertexSlots[vertexIndex]);
+
+			OptimizeVertexCache(clusterVertices.size(), localClusterIndices.size(), localClusterIndices.data());
+			for (u32 it = 0; it < localClusterIndices.size(); ++it)
+				clusterIndices[it] = clusterVertices[localClusterIndices[it]];
+
+			pClusters->emplace_back(CreateMeshCluster(pPositions, reorderedIndices.size(), clusterIndices.size(), clusterIndices.data(),
+				clusterVertices.size(), clusterVertices.data()));
+
+			reorderedIndices.insert(reorderedIndices.end(), clusterIndices.begin(), clusterIndices.end());
+			for (const u32 vertexIndex : clusterVertices)
+				clusterVertexSlots[vertexIndex] = kInvalidIndex;
+
+			clusterVertices.clear();
+			clusterIndices.clear();
+		};
+
+		u32 nextSeedTriangle = 0;
+		while (true)
+		{
+			// Grow the cluster with the adjacent triangle which adds the fewest new vertices.
+			u32 bestTriangle = kInvalidIndex;
+			u32 bestNumNewVertices = 4;
+
+			for (u32 it = 0; (it < clusterVertices.size()) && (bestNumNewVertices > 0); ++it)
+			{
+				const u32 vertexIndex = clusterVertices[it];
+				for (u32 adjacencyIndex = adjacencyOffsets[vertexIndex]; adjacencyIndex < adjacencyOffsets[vertexIndex + 1]; ++adjacencyIndex)
+				{
+					const u32 triangleIndex = adjacentTriangles[adjacencyIndex];
+					if (isTriangleEmitted[triangleIndex] != 0)
+						continue;
+
+					const u32 numNewVertices = CountNewVertices(triangleIndex);
+					if (numNewVertices < bestNumNewVertices)
+					{
+						bestTriangle = triangleIndex;
+						bestNumNewVertices = numNewVertices;
+
+						if (numNewVertices == 0)
+							break;
+					}
+				}
+			}
+
+			if (bestTriangle == kInvalidIndex)
+			{
+				// No connected triangles left. Small clusters continue with the next triangle in index order,
+				// which is usually close in space, to avoid fragmenting meshes with many small disconnected parts.
+				if (!clusterIndices.empty() && (4 * clusterIndices.size() >= 3 * maxNumTrianglesPerCluster))
+				{
+					FlushCluster();
+					continue;
+				}
+
+				while ((nextSeedTriangle < numTriangles) && (isTriangleEmitted[nextSeedTriangle] != 0))
+					++nextSeedTriangle;
+
+				if (nextSeedTriangle == numTriangles)
+					break;
+
+				bestTriangle = nextSeedTriangle;
+				bestNumNewVertices = CountNewVertices(bestTriangle);
+			}
+
+			if ((clusterVertices.size() + bestNumNewVertices > maxNumVerticesPerCluster) ||
+				(clusterIndices.size() + 3 > 3 * maxNumTrianglesPerCluster))
+			{
+				FlushCluster();
+				continue;
+			}
+
+			isTriangleEmitted[bestTriangle] = 1;
+			for (u32 it = 0; it < 3; ++it)
+			{
+				const u32 vertexIndex = pIndices[3 * bestTriangle + it];
+				if (clusterVertexSlots[vertexIndex] == kInvalidIndex)
+				{
+					clusterVertexSlots[vertexIndex] = clusterVertices.size();
+					clusterVertices.push_back(vertexIndex);
+				}
+				clusterIndices.push_back(vertexIndex);
+			}
+		}
+
+		if (!clusterIndices.empty())
+			FlushCluster();
+
+		assert(reorderedIndices.size() == numIndices);
+		for (u32 it = 0; it < numIndices; ++it)
+			pIndices[it] = Index(reorderedIndices[it]);
+	}
+
+	MeshCluster CreateMeshCluster(const Vector3f* pPositions, u32 startIndexLocation, u32 numIndices, const u32* pIndices,
+		u32 numVertices, const u32* pVertexIndices)
+	{
+		std::vector<Vector3f> clusterPositions(numVertices);
+		for (u32 it = 0; it < numVertices; ++it)
+			clusterPositions[it] = pPositions[pVertexIndices[it]];
+
+		MeshCluster cluster;
+		cluster.m_StartIndexLocation = startIndexLocation;
+		cluster.m_IndexCount = numIndices;
+		cluster.m_VertexCount = numVertices;
+		cluster.m_BoundingSphere = Sphere(numVertices, clusterPositions.data());
+		cluster.m_AABB = AxisAlignedBox(numVertices, clusterPositions.data());
+		cluster.m_ConeApex = cluster.m_BoundingSphere.m_Center;
+		cluster.m_ConeAxis = Vector3f(0.0f, 0.0f, 1.0f);
+		cluster.m_ConeCutoff = kDisabledConeCutoff;
+
+		// Front faces have clockwise winding order.
+		const u32 numTriangles = numIndices / 3;
+		std::vector<Vector3f> triangleNormals;
+		triangleNormals.reserve(numTriangles);
+
+		Vector3f normalSum = Vector3f::ZERO;
+		for (u32 triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+		{
+			const Vector3f& position0 = pPositions[pIndices[3 * triangleIndex + 0]];
+			const Vector3f& position1 = pPositions[pIndices[3 * triangleIndex + 1]];
+			const Vector3f& position2 = pPositions[pIndices[3 * triangleIndex + 2]];
+
+			const Vector3f normal = Cross(position1 - position0, position2 - position0);
+			const f32 normalLength = Length(normal);
+			if (normalLength < EPSILON)
+				continue;
+
+			triangleNormals.emplace_back(normal / normalLength);
+			normalSum += triangleNormals.back();
+		}
+
+		const f32 normalSumLength = Length(normalSum);
+		if (triangleNormals.empty() || (normalSumLength < EPSILON))
+			return cluster;
+
+		const Vector3f coneAxis = normalSum / normalSumLength;
+
+		f32 minDotProduct = 1.0f;
+		for (const Vector3f& normal : triangleNormals)
+			minDotProduct = Min(minDotProduct, Dot(coneAxis, normal));
+
+		// The cone would reject almost no view directions when the normals spread over a hemisphere.
+		if (minDotProduct <= 0.1f)
+			return cluster;
+
+		// Move the apex behind the cluster so that the apex lies in the back half-space of every triangle.
+		f32 maxApexOffset = 0.0f;
+		u32 normalIndex = 0;
+		for (u32 triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+		{
+			const Vector3f& position0 = pPositions[pIndices[3 * triangleIndex + 0]];
+			const Vector3f& position1 = pPositions[pIndices[3 * triangleIndex + 1]];
+			const Vector3f& position2 = pPositions[pIndices[3 * triangleIndex + 2]];
+
+			if (Length(Cross(position1 - position0, position2 - position0)) < EPSILON)
+				continue;
+
+			const Vector3f& normal = triangleNormals[normalIndex++];
+			const f32 apexOffset = Dot(cluster.m_BoundingSphere.m_Center - position0, normal) / Dot(coneAxis, normal);
+			maxApexOffset = Max(maxApexOffset, apexOffset);
+		}
+
+		cluster.m_ConeApex = cluster.m_BoundingSphere.m_Center - maxApexOffset * coneAxis;
+		cluster.m_ConeAxis = coneAxis;
+		cluster.m_ConeCutoff = Sqrt(1.0f - Sqr(minDotProduct));
+
+		return cluster;
+	}
+
+	f32 CalcMaxScale(const Matrix4f& worldMatrix)
+	{
+		const f32 sqScaleX = Sqr(worldMatrix.m_00) + Sqr(worldMatrix.m_01) + Sqr(worldMatrix.m_02);
+		const f32 sqScaleY = Sqr(worldMatrix.m_10) + Sqr(worldMatrix.m_11) + Sqr(worldMatrix.m_12);
+		const f32 sqScaleZ = Sqr(worldMatrix.m_20) + Sqr(worldMatrix.m_21) + Sqr(worldMatrix.m_22);
+
+		return Sqrt(Max(sqScaleX, Max(sqScaleY, sqScaleZ)));
+	}
+
+	bool IsUniformScale(const Matrix4f& worldMatrix)
+	{
+		const f32 sqScaleX = Sqr(worldMatrix.m_00) + Sqr(worldMatrix.m_01) + Sqr(worldMatrix.m_02);
+		const f32 sqScaleY = Sqr(worldMatrix.m_10) + Sqr(worldMatrix.m_11) + Sqr(worldMatrix.m_12);
+		const f32 sqScaleZ = Sqr(worldMatrix.m_20) + Sqr(worldMatrix.m_21) + Sqr(worldMatrix.m_22);
+
+		const f32 tolerance = 1e-3f * Max(sqScaleX, Max(sqScaleY, sqScaleZ));
+		return (Abs(sqScaleX - sqScaleY) <= tolerance) && (Abs(sqScaleX - sqScaleZ) <= tolerance);
+	}
+
+	bool IsOccluded(const AxisAlignedBox& worldAABB, const Matrix4f& viewProjMatrix, const OcclusionDepthBuffer& depthBuffer)
+	{
+		const Vector3f minPoint = worldAABB.m_Center - worldAABB.m_Radius;
+		const Vector3f maxPoint = worldAABB.m_Center + worldAABB.m_Radius;
+
+		f32 minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+		f32 minDepth = 1.0f;
+
+		for (u32 cornerIndex = 0; cornerIndex < 8; ++cornerIndex)
+		{
+			const Vector4f corner(((cornerIndex & 1) != 0) ? maxPoint.m_X : minPoint.m_X,
+				((cornerIndex & 2) != 0) ? maxPoint.m_Y : minPoint.m_Y,
+				((cornerIndex & 4) != 0) ? maxPoint.m_Z : minPoint.m_Z,
+				1.0f);
+
+			const Vector4f clipSpaceCorner = corner * viewProjMatrix;
+
+			// The box crosses the near plane. Projected bounds are unreliable, treat the box as visible.
+			if (clipSpaceCorner.m_W <= EPSILON)
+				return false;
+
+			const f32 rcpW = Rcp(clipSpaceCorner.m_W);
+			minX = Min(minX, clipSpaceCorner.m_X * rcpW);
+			maxX = Max(maxX, clipSpaceCorner.m_X * rcpW);
+			minY = Min(minY, clipSpaceCorner.m_Y * rcpW);
+			maxY = Max(maxY, clipSpaceCorner.m_Y * rcpW);
+			minDepth = Min(minDepth, clipSpaceCorner.m_Z * rcpW);
+		}
+
+		// Normalized device coordinates to texels. Texture space y axis points down.
+		const i32 minTexelX = Clamp(0, i32(depthBuffer.m_Width) - 1, i32((0.5f * minX + 0.5f) * f32(depthBuffer.m_Width)));
+		const i32 maxTexelX = Clamp(0, i32(depthBuffer.m_Width) - 1, i32((0.5f * maxX + 0.5f) * f32(depthBuffer.m_Width)));
+		const i32 minTexelY = Clamp(0, i32(depthBuffer.m_Height) - 1, i32((0.5f - 0.5f * maxY) * f32(depthBuffer.m_Height)));
+		const i32 maxTexelY = Clamp(0, i32(depthBuffer.m_Height) - 1, i32((0.5f - 0.5f * minY) * f32(depthBuffer.m_Height)));
+
+		for (i32 texelY = minTexelY; texelY <= maxTexelY; ++texelY)
+		{
+			const f32* pRowMaxDepths = depthBuffer.m_pMaxDepths + texelY * depthBuffer.m_Width;
+			for (i32 texelX = minTexelX; texelX <= maxTexelX; ++texelX)
+			{
+				if (minDepth <= pRowMaxDepths[texelX])
+					return false;
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "Scene/MeshInstancing.h"
+#include "Math/Vector4.h"
+
+namespace
+{
+	struct Vector3d
+	{
+		f64 m_X, m_Y, m_Z;
+	};
+
+	Vector3d ToVector3d(const Vector3f& vec);
+	Vector3d Subtract(const Vector3d& vec1, const Vector3d& vec2);
+	Vector3d Cross(const Vector3d& vec1, const Vector3d& vec2);
+	f64 Dot(const Vector3d& vec1, const Vector3d& vec2);
+	Vector3d ScaleToSqrtLength(const Vector3d& vec);
+	bool IsSimilarityTransform(const Vector3d linearTransform[3]);
+
+	// Solves edges * linearTransform = instanceEdges for the 3x3 linear transform, all matrices stored by rows.
+	bool SolveLinearTransform(const Vector3d edges[3], const Vector3d instanceEdges[3], Vector3d linearTransform[3]);
+}
+
+u64 HashBytes(const void* pData, std::size_t sizeInBytes, u64 hash)
+{
+	const u64 prime = 0x100000001B3ull;
+
+	const u8* pBytes = (const u8*)pData;
+	for (std::size_t byteIndex = 0; byteIndex < sizeInBytes; ++byteIndex)
+	{
+		hash ^= pBytes[byteIndex];
+		hash *= prime;
+	}
+	return hash;
+}
+
+bool FindInstanceTransform(u32 numVertices, const Vector3f* pCanonicalPositions, const Vector3f* pPositions,
+	f32 maxError, Matrix4f* pInstanceMatrix)
+{
+	assert(numVertices > 0);
+
+	// Pick the vertices which span the mesh: the first vertex, the vertex farthest from it,
+	// the vertex farthest from the line through them and the vertex farthest from the plane through the three.
+	const Vector3d origin = ToVector3d(pCanonicalPositions[0]);
+	const Vector3d instanceOrigin = ToVector3d(pPositions[0]);
+
+	u32 basisIndices[3] = {0, 0, 0};
+	f64 maxMeasures[3] = {0.0, 0.0, 0.0};
+
+	for (u32 vertexIndex = 1; vertexIndex < numVertices; ++vertexIndex)
+	{
+		const Vector3d edge = Subtract(ToVector3d(pCanonicalPositions[vertexIndex]), origin);
+		const f64 measure = Dot(edge, edge);
+		if (measure > maxMeasures[0])
+		{
+			maxMeasures[0] = measure;
+			basisIndices[0] = vertexIndex;
+		}
+	}
+	
+	// All the vertices are at the same point. Only translation can be recovered.
+	if (maxMeasures[0] == 0.0)
+	{
+		*pInstanceMatrix = Matrix4f::IDENTITY;
+		pInstanceMatrix->m_30 = f32(instanceOrigin.m_X - origin.m_X);
+		pInstanceMatrix->m_31 = f32(instanceOrigin.m_Y - origin.m_Y);
+		pInstanceMatrix->m_32 = f32(instanceOrigin.m_Z - origin.m_Z);
+	}
+	else
+	{
+		const Vector3d firstEdge = Subtract(ToVector3d(pCanonicalPositions[basisIndices[0]]), origin);
+		for (u32 vertexIndex = 1; vertexIndex < numVertices; ++vertexIndex)
+		{
+			const Vector3d normal = Cross(firstEdge, Subtract(ToVector3d(pCanonicalPositions[vertexIndex]), origin));
+			const f64 measure = Dot(normal, normal);
+			if (measure > maxMeasures[1])
+			{
+				maxMeasures[1] = measure;
+				basisIndices[1] = vertexIndex;
+			}
+		}
+		
+		// All the vertices lie on a line. Rotation around the line is ambiguous.
+		const f64 epsilon = 1e-10;
+		if (maxMeasures[1] <= epsilon * maxMeasures[0] * maxMeasures[0])
+			return false;
+
+		const Vector3d secondEdge = Subtract(ToVector3d(pCanonicalPositions[basisIndices[1]]), origin);
+		const Vector3d planeNormal = Cross(firstEdge, secondEdge);
+
+		for (u32 vertexIndex = 1; vertexIndex < numVertices; ++vertexIndex)
+		{
+			const f64 measure = std::abs(Dot(planeNormal, Subtract(ToVector3d(pCanonicalPositions[vertexIndex]), origin)));
+			if (measure > maxMeasures[2])
+			{
+				maxMeasures[2] = measure;
+				basisIndices[2] = vertexIndex;
+			}
+		}
+
+		Vector3d edges[3];
+		Vector3d instanceEdges[3];
+
+		edges[0] = firstEdge;
+		edges[1] = secondEdge;
+		instanceEdges[0] = Subtract(ToVector3d(pPositions[basisIndices[0]]), instanceOrigin);
+		instanceEdges[1] = Subtract(ToVector3d(pPositions[basisIndices[1]]), instanceOrigin);
+
+		const f64 volume = maxMeasures[2];
+		const f64 planeNormalLength = std::sqrt(Dot(planeNormal, planeNormal));
+		
+		if (volume > std::sqrt(epsilon) * planeNormalLength * std::sqrt(maxMeasures[0]))
+		{
+			edges[2] = Subtract(ToVector3d(pCanonicalPositions[basisIndices[2]]), origin);
+			instanceEdges[2] = Subtract(ToVector3d(pPositions[basisIndices[2]]), instanceOrigin);
+		}
+		else
+		{
+			// Flat mesh. The third edge is taken along the plane normals, scaled so that
+			// it is mapped consistently by rotation and uniform scaling of the mesh.
+			edges[2] = ScaleToSqrtLength(planeNormal);
+			instanceEdges[2] = ScaleToSqrtLength(Cross(instanceEdges[0], instanceEdges[1]));
+		}
+
+		Vector3d linearTransform[3];
+		if (!SolveLinearTransform(edges, instanceEdges, linearTransform))
+			return false;
+
+		const f64 determinant = Dot(linearTransform[0], Cross(linearTransform[1], linearTransform[2]));
+		if (determinant <= 0.0)
+			return false;
+
+		if (!IsSimilarityTransform(linearTransform))
+			return false;
+
+		const Vector3d translation =
+		{
+			instanceOrigin.m_X - (origin.m_X * linearTransform[0].m_X + origin.m_Y * linearTransform[1].m_X + origin.m_Z * linearTransform[2].m_X),
+			instanceOrigin.m_Y - (origin.m_X * linearTransform[0].m_Y + origin.m_Y * linearTransform[1].m_Y + origin.m_Z * linearTransform[2].m_Y),
+			instanceOrigin.m_Z - (origin.m_X * linearTransform[0].m_Z + origin.m_Y * linearTransform[1].m_Z + origin.m_Z * linearTransform[2].m_Z)
+		};
+
+		*pInstanceMatrix = Matrix4f(
+			f32(linearTransform[0].m_X), f32(linearTransform[0].m_Y), f32(linearTransform[0].m_Z), 0.0f,
+			f32(linearTransform[1].m_X), f32(linearTransform[1].m_Y), f32(linearTransform[1].m_Z), 0.0f,
+			f32(linearTransform[2].m_X), f32(linearTransform[2].m_Y), f32(linearTransform[2].m_Z), 0.0f,
+			f32(translation.m_X), f32(translation.m_Y), f32(translation.m_Z), 1.0f);
+	}
+
+	const f32 maxErrorSquared = maxError * maxError;
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+	{
+		const Vector3f error = TransformPoint(pCanonicalPositions[vertexIndex], *pInstanceMatrix) - pPositions[vertexIndex];
+		if (LengthSquared(error) > maxErrorSquared)
+			return false;
+	}
+	return true;
+}
+
+bool AreInstanceNormals(u32 numVertices, const Vector3f* pCanonicalNormals, const Vector3f* pNormals,
+	const Matrix4f& instanceMatrix, f32 maxAngleInDegrees)
+{
+	const Matrix4f normalMatrix = Transpose(Inverse(instanceMatrix));
+	const f32 minCosAngle = std::cos(ToRadians(maxAngleInDegrees));
+
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+	{
+		const Vector4f canonicalNormal(pCanonicalNormals[vertexIndex].m_X, pCanonicalNormals[vertexIndex].m_Y, pCanonicalNormals[vertexIndex].m_Z, 0.0f);
+		const Vector3f transformedNormal = Normalize(ToCartesianVector(canonicalNormal * normalMatrix));
+
+		if (Dot(transformedNormal, Normalize(pNormals[vertexIndex])) < minCosAngle)
+			return false;
+	}
+	return true;
+}
+
+namespace
+{
+	Vector3d ToVector3d(const Vector3f& vec)
+	{
+		return {f64(vec.m_X), f64(vec.m_Y), f64(vec.m_Z)};
+	}
+
+	Vector3d Subtract(const Vector3d& vec1, const Vector3d& vec2)
+	{
+		return {vec1.m_X - vec2.m_X, vec1.m_Y - vec2.m_Y, vec1.m_Z - vec2.m_Z};
+	}
+
+	Vector3d Cross(const Vector3d& vec1, const Vector3d& vec2)
+	{
+		return {vec1.m_Y * vec2.m_Z - vec1.m_Z * vec2.m_Y,
+			vec1.m_Z * vec2.m_X - vec1.m_X * vec2.m_Z,
+			vec1.m_X * vec2.m_Y - vec1.m_Y * vec2.m_X};
+	}
+
+	f64 Dot(const Vector3d& vec1, const Vector3d& vec2)
+	{
+		return vec1.m_X * vec2.m_X + vec1.m_Y * vec2.m_Y + vec1.m_Z * vec2.m_Z;
+	}
+
+	Vector3d ScaleToSqrtLength(const Vector3d& vec)
+	{
+		// For v = a x b and transform s * R: (a * sR) x (b * sR) = s^2 * (v * R).
+		// Dividing by the square root of the length maps it to s * (v * R) / sqrt(|v|), the same as the transformed vector.
+		const f64 scale = 1.0 / std::sqrt(std::sqrt(Dot(vec, vec)));
+		return {vec.m_X * scale, vec.m_Y * scale, vec.m_Z * scale};
+	}
+
+	bool IsSimilarityTransform(const Vector3d linearTransform[3])
+	{
+		// Rows of a similarity transform are orthogonal and of equal length.
+		// The tolerance is relative to the squared scale and covers the error of solving from float positions.
+		const f64 tolerance = 1e-3;
+		const f64 squaredScale = Dot(linearTransform[0], linearTransform[0]);
+
+		for (u32 row = 1; row < 3; ++row)
+		{
+			if (std::abs(Dot(linearTransform[row], linearTransform[row]) - squaredScale) > tolerance * squaredScale)
+				return false;
+		}
+		for (u32 row = 0; row < 3; ++row)
+		{
+			if (std::abs(Dot(linearTransform[row], linearTransform[(row + 1) % 3])) > tolerance * squaredScale)
+				return false;
+		}
+		return true;
+	}
+
+	bool SolveLinearTransform(const Vector3d edges[3], const Vector3d instanceEdges[3], Vector3d linearTransform[3])
+	{
+		// Rows of the inverse are the cross products of the columns, divided by the determinant.
+		const Vector3d column0 = {edges[0].m_X, edges[1].m_X, edges[2].m_X};
+		const Vector3d column1 = {edges[0].m_Y, edges[1].m_Y, edges[2].m_Y};
+		const Vector3d column2 = {edges[0].m_Z, edges[1].m_Z, edges[2].m_Z};
+
+		const f64 determinant = Dot(column0, Cross(column1, column2));
+		if (determinant == 0.0)
+			return false;
+
+		const f64 rcpDeterminant = 1.0 / determinant;
+		const Vector3d inverseRows[3] = {Cross(column1, column2), Cross(column2, column0), Cross(column0, column1)};
+
+		for (u32 row = 0; row < 3; ++row)
+		{
+			const Vector3d& inverseRow = inverseRows[row];
+			linearTransform[row].m_X = rcpDeterminant * (inverseRow.m_X * instanceEdges[0].m_X + inverseRow.m_Y * instanceEdges[1].m_X + inverseRow.m_Z * instanceEdges[2].m_X);
+			linearTransform[row].m_Y = rcpDeterminant * (inverseRow.m_X * instanceEdges[0].m_Y + inverseRow.m_Y * instanceEdges[1].m_Y + inverseRow.m_Z * instanceEdges[2].m_Y);
+			linearTransform[row].m_Z = rcpDeterminant * (inverseRow.m_X * instanceEdges[0].m_Z + inverseRow.m_Y * instanceEdges[1].m_Z + inverseRow.m_Z * instanceEdges[2].m_Z);
+		}
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "Scene/MeshOptimizer.h"
+#include "Math/Math.h"
+
+namespace
+{
+	static const u32 kInvalidIndex = ~0u;
+
+	// Forsyth's algorithm models LRU cache, which is larger than the FIFO cache used for analysis.
+	static const u32 kForsythCacheSize = 32;
+
+	f32 CalcForsythVertexScore(i32 cachePosition, u32 numRemainingTriangles);
+
+	// FIFO cache simulation. A vertex is in the cache if fewer than cacheSize vertices have been added since its last insertion.
+	struct VertexCacheSimulator
+	{
+		VertexCacheSimulator(u32 numVertices, u32 cacheSize);
+
+		void Reset();
+		u32 AddTriangle(u32 index0, u32 index1, u32 index2);
+
+		std::vector<u32> m_Timestamps;
+		u32 m_CacheSize;
+		u32 m_Timestamp;
+	};
+}
+
+VertexCacheStats AnalyzeVertexCache(u32 numVertices, u32 numIndices, const u32* pIndices, u32 cacheSize)
+{
+	assert(numIndices % 3 == 0);
+
+	VertexCacheSimulator cacheSimulator(numVertices, cacheSize);
+	std::vector<u8> isVertexReferenced(numVertices, 0);
+
+	VertexCacheStats stats;
+	for (u32 it = 0; it < numIndices; it += 3)
+	{
+		stats.m_NumTransformedVertices += cacheSimulator.AddTriangle(pIndices[it + 0], pIndices[it + 1], pIndices[it + 2]);
+
+		isVertexReferenced[pIndices[it + 0]] = 1;
+		isVertexReferenced[pIndices[it + 1]] = 1;
+		isVertexReferenced[pIndices[it + 2]] = 1;
+	}
+
+	stats.m_NumTriangles = numIndices / 3;
+	stats.m_NumReferencedVertices = u32(std::count(isVertexReferenced.begin(), isVertexReferenced.end(), 1));
+
+	if (stats.m_NumTriangles > 0)
+		stats.m_ACMR = f32(stats.m_NumTransformedVertices) / f32(stats.m_NumTriangles);
+	if (stats.m_NumReferencedVertices > 0)
+		stats.m_ATVR = f32(stats.m_NumTransformedVertices) / f32(stats.m_NumReferencedVertices);
+
+	return stats;
+}
+
+void AccumulateVertexCacheStats(const VertexCacheStats& meshStats, VertexCacheStats* pTotalStats)
+{
+	pTotalStats->m_NumTransformedVertices += meshStats.m_NumTransformedVertices;
+	pTotalStats->m_NumTriangles += meshStats.m_NumTriangles;
+	pTotalStats->m_NumReferencedVertices += meshStats.m_NumReferencedVertices;
+
+	if (pTotalStats->m_NumTriangles > 0)
+		pTotalStats->m_ACMR = f32(pTotalStats->m_NumTransformedVertices) / f32(pTotalStats->m_NumTriangles);
+	if (pTotalStats->m_NumReferencedVertices > 0)
+		pTotalStats->m_ATVR = f32(pTotalStats->m_NumTransformedVertices) / f32(pTotalStats->m_NumReferencedVertices);
+}
+
+void OptimizeVertexCache(u32 numVertices, u32 numIndices, u32* pIndices)
+{
+	assert(numIndices % 3 == 0);
+
+	const u32 numTriangles = numIndices / 3;
+	if (numTriangles == 0)
+		return;
+
+	// Triangles adjacent to vertex v which have not been emitted yet are
+	// adjacentTriangles[adjacencyOffsets[v]], ..., adjacentTriangles[adjacencyOffsets[v] + numRemainingTriangles[v] - 1].
+	std::vector<u32> adjacencyOffsets(numVertices + 1, 0);
+	for (u32 it = 0; it < numIndices; ++it)
+		++adjacencyOffsets[pIndices[it] + 1];
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+		adjacencyOffsets[vertexIndex + 1] += adjacencyOffsets[vertexIndex];
+
+	std::vector<u32> numRemainingTriangles(numVertices, 0);
+	std::vector<u32> adjacentTriangles(numIndices);
+	for (u32 it = 0; it < numIndices; ++it)
+	{
+		const u32 vertexIndex = pIndices[it];
+		adjacentTriangles[adjacencyOffsets[vertexIndex] + numRemainingTriangles[vertexIndex]++] = it / 3;
+	}
+
+	std::vector<i32> cachePositions(numVertices, -1);
+	std::vector<f32> vertexScores(numVertices);
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+		vertexScores[vertexIndex] = CalcForsythVertexScore(-1, numRemainingTriangles[vertexIndex]);
+
+	u32 bestTriangle = 0;
+	std::vector<f32> triangleScores(numTriangles);
+	for (u32 triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+	{
+		triangleScores[triangleIndex] = vertexScores[pIndices[3 * triangleIndex + 0]] +
+			vertexScores[pIndices[3 * triangleIndex + 1]] +
+			vertexScores[pIndices[3 * triangleIndex + 2]];
+
+		if (triangleScores[triangleIndex] > triangleScores[bestTriangle])
+			bestTriangle = triangleIndex;
+	}
+
+	std::vector<u8> isTriangleEmitted(numTriangles, 0);
+	std::vector<u32> optimizedIndices;
+	optimizedIndices.reserve(numIndices);
+
+	u32 cache[kForsythCacheSize + 3];
+	u32 cacheSize = 0;
+
+	u32 nextSeedTriangle = 0;
+	while (bestTriangle != kInvalidIndex)
+	{
+		isTriangleEmitted[bestTriangle] = 1;
+
+		const u32* pTriangleIndices = &pIndices[3 * bestTriangle];
+		optimizedIndices.insert(optimizedIndices.end(), pTriangleIndices, pTriangleIndices + 3);
+
+		for (u32 it = 0; it < 3; ++it)
+		{
+			const u32 vertexIndex = pTriangleIndices[it];
+			u32* pFirstTriangle = &adjacentTriangles[adjacencyOffsets[vertexIndex]];
+			u32* pLastTriangle = pFirstTriangle + numRemainingTriangles[vertexIndex] - 1;
+
+			u32* pTriangle = std::find(pFirstTriangle, pLastTriangle + 1, bestTriangle);
+			assert(pTriangle != pLastTriangle + 1);
+
+			std::swap(*pTriangle, *pLastTriangle);
+			--numRemainingTriangles[vertexIndex];
+		}
+
+		// Vertices of the emitted triangle move to the front of the cache.
+		u32 newCache[kForsythCacheSize + 3];
+		u32 newCacheSize = 0;
+
+		for (u32 it = 0; it < 3; ++it)
+		{
+			const u32 vertexIndex = pTriangleIndices[it];
+			if (std::find(newCache, newCache + newCacheSize, vertexIndex) == newCache + newCacheSize)
+				newCache[newCacheSize++] = vertexIndex;
+		}
+		for (u32 it = 0; it < cacheSize; ++it)
+		{
+			const u32 vertexIndex = cache[it];
+			if (std::find(pTriangleIndices, pTriangleIndices + 3, vertexIndex) == pTriangleIndices + 3)
+				newCache[newCacheSize++] = vertexIndex;
+		}
+
+		// Vertices beyond the cache size have just been evicted. Their scores need an update as well.
+		for (u32 it = 0; it < newCacheSize; ++it)
+		{
+			const u32 vertexIndex = newCache[it];
+			cachePositions[vertexIndex] = (it < kForsythCacheSize) ? i32(it) : -1;
+			vertexScores[vertexIndex] = CalcForsythVertexScore(cachePositions[vertexIndex], numRemainingTriangles[vertexIndex]);
+		}
+
+		bestTriangle = kInvalidIndex;
+		f32 bestTriangleScore = -1.0f;
+
+		for (u32 it = 0; it < newCacheSize; ++it)
+		{
+			const u32 vertexIndex = newCache[it];
+			for (u32 adjacencyIndex = adjacencyOffsets[vertexIndex]; adjacencyIndex < adjacencyOffsets[vertexIndex] + numRemainingTriangles[vertexIndex]; ++adjacencyIndex)
+			{
+				const u32 triangleIndex = adjacentTriangles[adjacencyIndex];
+				triangleScores[triangleIndex] = vertexScores[pIndices[3 * triangleIndex + 0]] +
+					vertexScores[pIndices[3 * triangleIndex + 1]] +
+					vertexScores[pIndices[3 * triangleIndex + 2]];
+
+				if (triangleScores[triangleIndex] > bestTriangleScore)
+				{
+					bestTriangle = triangleIndex;
+					bestTriangleScore = triangleScores[triangleIndex];
+				}
+			}
+		}
+
+		cacheSize = Min(newCacheSize, kForsythCacheSize);
+		std::copy(newCache, newCache + cacheSize, cache);
+
+		// None of the cached vertices has remaining triangles. Continue with the next triangle in index order.
+		if (bestTriangle == kInvalidIndex)
+		{
+			while ((nextSeedTriangle < numTriangles) && (isTriangleEmitted[nextSeedTriangle] != 0))
+				++nextSeedTriangle;
+
+			if (nextSeedTriangle < numTriangles)
+				bestTriangle = nextSeedTriangle;
+		}
+	}
+
+	assert(optimizedIndices.size() == numIndices);
+	std::copy(optimizedIndices.begin(), optimizedIndices.end(), pIndices);
+}
+
+void OptimizeOverdraw(const Vector3f* pPositions, u32 numVertices, u32 numIndices, u32* pIndices, f32 threshold, u32 cacheSize)
+{
+	assert(numIndices % 3 == 0);
+	assert(threshold >= 1.0f);
+
+	const u32 numTriangles = numIndices / 3;
+	if (numTriangles == 0)
+		return;
+
+	VertexCacheSimulator cacheSimulator(numVertices, cacheSize);
+
+	// Hard boundaries are the triangles which miss the cache for all vertices.
+	// Clusters can be reordered around them without affecting the cache hit rate.
+	std::vector<u32> hardClusterStarts;
+	for (u32 triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+	{
+		const u32* pTriangleIndices = &pIndices[3 * triangleIndex];
+		const u32 numMisses = cacheSimulator.AddTriangle(pTriangleIndices[0], pTriangleIndices[1], pTriangleIndices[2]);
+
+		if ((triangleIndex == 0) || (numMisses == 3))
+			hardClusterStarts.push_back(triangleIndex);
+	}
+	hardClusterStarts.push_back(numTriangles);
+
+	// Soft boundaries split the hard clusters further as long as the miss ratio of
+	// the resulting clusters stays within the threshold of the miss ratio of the hard cluster.
+	std::vector<u32> clusterStarts;
+	for (u32 hardClusterIndex = 0; hardClusterIndex + 1 < hardClusterStarts.size(); ++hardClusterIndex)
+	{
+		const u32 firstTriangle = hardClusterStarts[hardClusterIndex];
+		const u32 lastTriangle = hardClusterStarts[hardClusterIndex + 1];
+
+		u32 numClusterMisses = 0;
+		cacheSimulator.Reset();
+		for (u32 triangleIndex = firstTriangle; triangleIndex < lastTriangle; ++triangleIndex)
+		{
+			const u32* pTriangleIndices = &pIndices[3 * triangleIndex];
+			numClusterMisses += cacheSimulator.AddTriangle(pTriangleIndices[0], pTriangleIndices[1], pTriangleIndices[2]);
+		}
+
+		const f32 maxACMR = threshold * f32(numClusterMisses) / f32(lastTriangle - firstTriangle);
+
+		u32 softClusterStart = firstTriangle;
+		u32 numSoftClusterMisses = 0;
+
+		clusterStarts.push_back(firstTriangle);
+		cacheSimulator.Reset();
+
+		for (u32 triangleIndex = firstTriangle; triangleIndex + 1 < lastTriangle; ++triangleIndex)
+		{
+			const u32* pTriangleIndices = &pIndices[3 * triangleIndex];
+			numSoftClusterMisses += cacheSimulator.AddTriangle(pTriangleIndices[0], pTriangleIndices[1], pTriangleIndices[2]);
+
+			if (f32(numSoftClusterMisses) <= maxACMR * f32(triangleIndex + 1 - softClusterStart))
+			{
+				softClusterStart = triangleIndex + 1;
+				numSoftClusterMisses = 0;
+
+				clusterStarts.push_back(softClusterStart);
+				cacheSimulator.Reset();
+			}
+		}
+	}
+	clusterStarts.push_back(numTriangles);
+
+	const u32 numClusters = clusterStarts.size() - 1;
+	std::vector<Vector3f> clusterCentroids(numClusters, Vector3f::ZERO);
+	std::vector<Vector3f> clusterNormals(numClusters, Vector3f::ZERO);
+
+	Vector3f meshCentroid = Vector3f::ZERO;
+	f32 meshArea = 0.0f;
+
+	for (u32 clusterIndex = 0; clusterIndex < numClusters; ++clusterIndex)
+	{
+		f32 clusterArea = 0.0f;
+		for (u32 triangleIndex = clusterStarts[clusterIndex]; triangleIndex < clusterStarts[clusterIndex + 1]; ++triangleIndex)
+		{
+			const Vector3f& position0 = pPositions[pIndices[3 * triangleIndex + 0]];
+			const Vector3f& position1 = pPositions[pIndices[3 * triangleIndex + 1]];
+			const Vector3f& position2 = pPositions[pIndices[3 * triangleIndex + 2]];
+
+			// Length of the cross product is twice the triangle area. Area weights keep the units consistent.
+			const Vector3f areaNormal = Cross(position1 - position0, position2 - position0);
+			const f32 area = Length(areaNormal);
+			const Vector3f centroid = (position0 + position1 + position2) / 3.0f;
+
+			clusterCentroids[clusterIndex] += area * centroid;
+			clusterNormals[clusterIndex] += areaNormal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroids[clusterIndex];
+		meshArea += clusterArea;
+
+		if (clusterArea > 0.0f)
+			clusterCentroids[clusterIndex] /= clusterArea;
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	// Clusters which face away from the mesh center are more likely to occlude the others.
+	std::vector<f32> occlusionPotentials(numClusters);
+	for (u32 clusterIndex = 0; clusterIndex < numClusters; ++clusterIndex)
+	{
+		const f32 normalLength = Length(clusterNormals[clusterIndex]);
+		occlusionPotentials[clusterIndex] = (normalLength > 0.0f) ?
+			Dot(clusterCentroids[clusterIndex] - meshCentroid, clusterNormals[clusterIndex]) / normalLength : 0.0f;
+	}
+
+	std::vector<u32> sortedClusterIndices(numClusters);
+	for (u32 clusterIndex = 0; clusterIndex < numClusters; ++clusterIndex)
+		sortedClusterIndices[clusterIndex] = clusterIndex;
+
+	std::stable_sort(sortedClusterIndices.begin(), sortedClusterIndices.end(), [&occlusionPotentials](u32 clusterIndex1, u32 clusterIndex2)
+	{
+		return (occlusionPotentials[clusterIndex1] > occlusionPotentials[clusterIndex2]);
+	});
+
+	std::vector<u32> optimizedIndices;
+	optimizedIndices.reserve(numIndices);
+
+	for (const u32 clusterIndex : sortedClusterIndices)
+	{
+		optimizedIndices.insert(optimizedIndices.end(),
+			pIndices + 3 * clusterStarts[clusterIndex],
+			pIndices + 3 * clusterStarts[clusterIndex + 1]);
+	}
+	std::copy(optimizedIndices.begin(), optimizedIndices.end(), pIndices);
+}
+
+u32 OptimizeVertexFetch(u32 numVertices, u32 numIndices, u32* pIndices, std::vector<u32>* pVertexRemap)
+{
+	pVertexRemap->assign(numVertices, kUnusedVertex);
+
+	u32 numRemappedVertices = 0;
+	for (u32 it = 0; it < numIndices; ++it)
+	{
+		u32& remappedIndex = (*pVertexRemap)[pIndices[it]];
+		if (remappedIndex == kUnusedVertex)
+			remappedIndex = numRemappedVertices++;
+
+		pIndices[it] = remappedIndex;
+	}
+
+	return numRemappedVertices;
+}
+
+namespace
+{
+	f32 CalcForsythVertexScore(i32 cachePosition, u32 numRemainingTriangles)
+	{
+		if (numRemainingTriangles == 0)
+			return -1.0f;
+
+		f32 score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// Vertices of the last triangle get a fixed score to discourage using them again immediately.
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = Pow(1.0f - f32(cachePosition - 3) / f32(kForsythCacheSize - 3), 1.5f);
+		}
+
+		// Vertices with few remaining triangles are preferred to get rid of them quickly.
+		score += 2.0f * Pow(f32(numRemainingTriangles), -0.5f);
+
+		return score;
+	}
+
+	VertexCacheSimulator::VertexCacheSimulator(u32 numVertices, u32 cacheSize)
+		: m_Timestamps(numVertices, 0)
+		, m_CacheSize(cacheSize)
+		, m_Timestamp(cacheSize + 1)
+	{
+	}
+
+	void VertexCacheSimulator::Reset()
+	{
+		m_Timestamp += m_CacheSize + 1;
+	}
+
+	u32 VertexCacheSimulator::AddTriangle(u32 index0, u32 index1, u32 index2)
+	{
+		u32 numMisses = 0;
+		for (const u32 vertexIndex : {index0, index1, index2})
+		{
+			if (m_Timestamp - m_Timestamps[vertexIndex] > m_CacheSize)
+			{
+				m_Timestamps[vertexIndex] = m_Timestamp++;
+				++numMisses;
+			}
+		}
+		return numMisses;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "Scene/MeshProcessing.h"
+#include "Math/Math.h"
+
+namespace
+{
+	static const u32 kEmptySlot = ~0u;
+
+	u32 HashFloats(const f32* pValues, u32 numValues, u32 hash);
+	bool AreEqualFloats(const f32* pValues1, const f32* pValues2, u32 numValues);
+	f32 CalcAngleBetween(const Vector3f& vec1, const Vector3f& vec2);
+	const Vector3f ProjectOntoPlane(const Vector3f& vec, const Vector3f& planeNormal);
+}
+
+u32 WeldVertices(u32 numVertices, const Vector3f* pPositions, const Vector3f* pNormals, const Vector2f* pTexCoords, const Vector3f* pTangents,
+	std::vector<u32>* pVertexRemap)
+{
+	auto isSameVertex = [pPositions, pNormals, pTexCoords, pTangents](u32 vertexIndex1, u32 vertexIndex2)
+	{
+		if (!AreEqualFloats(&pPositions[vertexIndex1].m_X, &pPositions[vertexIndex2].m_X, 3))
+			return false;
+		if ((pNormals != nullptr) && !AreEqualFloats(&pNormals[vertexIndex1].m_X, &pNormals[vertexIndex2].m_X, 3))
+			return false;
+		if ((pTexCoords != nullptr) && !AreEqualFloats(&pTexCoords[vertexIndex1].m_X, &pTexCoords[vertexIndex2].m_X, 2))
+			return false;
+		if ((pTangents != nullptr) && !AreEqualFloats(&pTangents[vertexIndex1].m_X, &pTangents[vertexIndex2].m_X, 3))
+			return false;
+		return true;
+	};
+
+	// Open addressing table with linear probing, kept at most half full.
+	u32 tableSize = 1;
+	while (tableSize < 2 * numVertices)
+		tableSize *= 2;
+
+	std::vector<u32> table(tableSize, kEmptySlot);
+	std::vector<u32>& vertexRemap = *pVertexRemap;
+	vertexRemap.resize(numVertices);
+
+	u32 numUniqueVertices = 0;
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+	{
+		u32 hash = HashFloats(&pPositions[vertexIndex].m_X, 3, 0);
+		if (pNormals != nullptr)
+			hash = HashFloats(&pNormals[vertexIndex].m_X, 3, hash);
+		if (pTexCoords != nullptr)
+			hash = HashFloats(&pTexCoords[vertexIndex].m_X, 2, hash);
+		if (pTangents != nullptr)
+			hash = HashFloats(&pTangents[vertexIndex].m_X, 3, hash);
+
+		u32 slot = hash & (tableSize - 1);
+		while ((table[slot] != kEmptySlot) && !isSameVertex(table[slot], vertexIndex))
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == kEmptySlot)
+		{
+			table[slot] = vertexIndex;
+			vertexRemap[vertexIndex] = numUniqueVertices++;
+		}
+		else
+		{
+			vertexRemap[vertexIndex] = vertexRemap[table[slot]];
+		}
+	}
+	return numUniqueVertices;
+}
+
+void GenerateNormals(u32 numVertices, const Vector3f* pPositions, u32 numIndices, const u32* pIndices, f32 maxSmoothingAngleInRadians,
+	Vector3f* pCornerNormals)
+{
+	assert(numIndices % 3 == 0);
+
+	std::vector<u32> positionRemap;
+	const u32 numUniquePositions = WeldVertices(numVertices, pPositions, nullptr, nullptr, nullptr, &positionRemap);
+
+	// Degenerate triangles keep zero normal and contribute nothing.
+	std::vector<Vector3f> triangleNormals(numIndices / 3, Vector3f::ZERO);
+	std::vector<Vector3f> weightedCornerNormals(numIndices, Vector3f::ZERO);
+	for (u32 index = 0; index < numIndices; index += 3)
+	{
+		const Vector3f& position0 = pPositions[pIndices[index + 0]];
+		const Vector3f& position1 = pPositions[pIndices[index + 1]];
+		const Vector3f& position2 = pPositions[pIndices[index + 2]];
+
+		const Vector3f triangleNormal = Cross(position1 - position0, position2 - position0);
+		if (LengthSquared(triangleNormal) < EPSILON * EPSILON)
+			continue;
+
+		const Vector3f unitTriangleNormal = Normalize(triangleNormal);
+		triangleNormals[index / 3] = unitTriangleNormal;
+
+		weightedCornerNormals[index + 0] = CalcAngleBetween(position1 - position0, position2 - position0) * unitTriangleNormal;
+		weightedCornerNormals[index + 1] = CalcAngleBetween(position2 - position1, position0 - position1) * unitTriangleNormal;
+		weightedCornerNormals[index + 2] = CalcAngleBetween(position0 - position2, position1 - position2) * unitTriangleNormal;
+	}
+
+	// Corners are bucketed by position, so that each corner visits only the corners at its position.
+	std::vector<u32> firstPositionCorners(numUniquePositions + 1, 0);
+	for (u32 index = 0; index < numIndices; ++index)
+		++firstPositionCorners[positionRemap[pIndices[index]] + 1];
+	for (u32 positionIndex = 0; positionIndex < numUniquePositions; ++positionIndex)
+		firstPositionCorners[positionIndex + 1] += firstPositionCorners[positionIndex];
+
+	std::vector<u32> positionCorners(numIndices);
+	std::vector<u32> nextPositionCorners(firstPositionCorners.cbegin(), firstPositionCorners.cend() - 1);
+	for (u32 index = 0; index < numIndices; ++index)
+		positionCorners[nextPositionCorners[positionRemap[pIndices[index]]]++] = index;
+
+	// The corners of the triangles smoothed together sum the same normals in the same order, so their normals are exactly equal.
+	const f32 minCosAngle = Cos(maxSmoothingAngleInRadians) - EPSILON;
+	for (u32 index = 0; index < numIndices; ++index)
+	{
+		const Vector3f& triangleNormal = triangleNormals[index / 3];
+		const bool isDegenerate = (LengthSquared(triangleNormal) == 0.0f);
+		const u32 positionIndex = positionRemap[pIndices[index]];
+
+		Vector3f normal = Vector3f::ZERO;
+		for (u32 offset = firstPositionCorners[positionIndex]; offset < firstPositionCorners[positionIndex + 1]; ++offset)
+		{
+			const u32 otherIndex = positionCorners[offset];
+			if (isDegenerate || (Dot(triangleNormal, triangleNormals[otherIndex / 3]) >= minCosAngle))
+				normal += weightedCornerNormals[otherIndex];
+		}
+		pCornerNormals[index] = (LengthSquared(normal) > 0.0f) ? Normalize(normal) : Vector3f::UP;
+	}
+}
+
+void GenerateTangents(u32 numVertices, const Vector3f* pPositions, const Vector3f* pNormals, const Vector2f* pTexCoords,
+	u32 numIndices, const u32* pIndices, Vector3f* pCornerTangents)
+{
+	assert(numIndices % 3 == 0);
+
+	// Tangents are summed separately for the triangles with positive and negative texture space area at each vertex.
+	std::vector<Vector3f> tangents(2 * numVertices, Vector3f::ZERO);
+	std::vector<u8> mirroredTriangles(numIndices / 3, 0);
+	for (u32 index = 0; index < numIndices; index += 3)
+	{
+		const u32 triangleIndices[3] = {pIndices[index + 0], pIndices[index + 1], pIndices[index + 2]};
+
+		const Vector3f edge1 = pPositions[triangleIndices[1]] - pPositions[triangleIndices[0]];
+		const Vector3f edge2 = pPositions[triangleIndices[2]] - pPositions[triangleIndices[0]];
+		const Vector2f texEdge1 = pTexCoords[triangleIndices[1]] - pTexCoords[triangleIndices[0]];
+		const Vector2f texEdge2 = pTexCoords[triangleIndices[2]] - pTexCoords[triangleIndices[0]];
+
+		// Sign of the texture space area gives the handedness and orients the tangent, so its magnitude does not matter.
+		const f32 texArea = texEdge1.m_X * texEdge2.m_Y - texEdge2.m_X * texEdge1.m_Y;
+		const u8 mirrored = (texArea < 0.0f) ? 1 : 0;
+		const Vector3f triangleTangent = (mirrored ? -1.0f : 1.0f) * (edge1 * texEdge2.m_Y - edge2 * texEdge1.m_Y);
+		mirroredTriangles[index / 3] = mirrored;
+
+		for (u32 corner = 0; corner < 3; ++corner)
+		{
+			const u32 vertexIndex = triangleIndices[corner];
+			const Vector3f& position = pPositions[vertexIndex];
+			const Vector3f& normal = pNormals[vertexIndex];
+
+			const Vector3f projectedTangent = ProjectOntoPlane(triangleTangent, normal);
+			if (LengthSquared(projectedTangent) < EPSILON * EPSILON)
+				continue;
+
+			const Vector3f toNext = ProjectOntoPlane(pPositions[triangleIndices[(corner + 1) % 3]] - position, normal);
+			const Vector3f toPrev = ProjectOntoPlane(pPositions[triangleIndices[(corner + 2) % 3]] - position, normal);
+
+			tangents[2 * vertexIndex + mirrored] += CalcAngleBetween(toNext, toPrev) * Normalize(projectedTangent);
+		}
+	}
+
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+	{
+		const Vector3f& normal = pNormals[vertexIndex];
+		for (u32 mirrored = 0; mirrored < 2; ++mirrored)
+		{
+			Vector3f tangent = ProjectOntoPlane(tangents[2 * vertexIndex + mirrored], normal);
+
+			// Any vector in the tangent plane will do when the texture coordinates are degenerate.
+			if (LengthSquared(tangent) < EPSILON * EPSILON)
+			{
+				tangent = ProjectOntoPlane(Vector3f::RIGHT, normal);
+				if (LengthSquared(tangent) < EPSILON * EPSILON)
+					tangent = ProjectOntoPlane(Vector3f::FORWARD, normal);
+			}
+			tangents[2 * vertexIndex + mirrored] = Normalize(tangent);
+		}
+	}
+
+	for (u32 index = 0; index < numIndices; ++index)
+		pCornerTangents[index] = tangents[2 * pIndices[index] + mirroredTriangles[index / 3]];
+}
+
+namespace
+{
+	u32 HashFloats(const f32* pValues, u32 numValues, u32 hash)
+	{
+		for (u32 index = 0; index < numValues; ++index)
+		{
+			// Adding zero turns -0 into +0, so that the values which compare equal have the same hash.
+			const f32 value = pValues[index] + 0.0f;
+
+			u32 word;
+			std::memcpy(&word, &value, sizeof(word));
+
+			// MurmurHash3 mixing step.
+			word *= 0xCC9E2D51;
+			word = (word << 15) | (word >> 17);
+			word *= 0x1B873593;
+
+			hash ^= word;
+			hash = (hash << 13) | (hash >> 19);
+			hash = hash * 5 + 0xE6546B64;
+		}
+
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+		
+		return hash;
+	}
+
+	bool AreEqualFloats(const f32* pValues1, const f32* pValues2, u32 numValues)
+	{
+		return std::equal(pValues1, pValues1 + numValues, pValues2);
+	}
+
+	f32 CalcAngleBetween(const Vector3f& vec1, const Vector3f& vec2)
+	{
+		const f32 lengthProduct = Length(vec1) * Length(vec2);
+		if (lengthProduct < EPSILON * EPSILON)
+			return 0.0f;
+
+		return ArcCos(Clamp(-1.0f, 1.0f, Dot(vec1, vec2) / lengthProduct));
+	}
+
+	const Vector3f ProjectOntoPlane(const Vector3f& vec, const Vector3f& planeNormal)
+	{
+		return vec - Dot(vec, planeNormal) * planeNormal;
+	}
+}
\ No newline at end of file
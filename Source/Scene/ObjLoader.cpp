@@ -0,0 +1,778 @@
+#include "Scene/ObjLoader.h"
+#include "Common/FileUtilities.h"
+#include "Common/ParallelFor.h"
+#include "Math/Math.h"
+#include "Math/Vector2.h"
+#include "Math/Vector3.h"
+#include "assimp/scene.h"
+
+namespace
+{
+	static const u32 kMissingIndex = ~0u;
+	static const u64 kMinChunkSizeInBytes = 1 << 20;
+	static const u32 kNumChunksPerThread = 4;
+	static const u32 kMaxNumMantissaDigits = 19;
+
+	// Indices of the face vertex attributes as parsed from the chunk.
+	// Positive indices are absolute and 1-based, 0 means the attribute is missing.
+	// Negative indices count back from the last element defined before the face and are stored
+	// relative to the first element of the chunk, as the number of elements in the previous chunks is not known during parsing.
+	struct ObjFaceVertex
+	{
+		i32 m_Indices[3];
+		u32 m_RelativeIndexMask;
+	};
+
+	// Resolved 0-based indices of the face vertex attributes.
+	struct ObjVertexKey
+	{
+		u32 m_PositionIndex;
+		u32 m_TexCoordIndex;
+		u32 m_NormalIndex;
+	};
+
+	// Meshes are split at each usemtl, o and g statement.
+	struct ObjMeshBreak
+	{
+		u32 m_FirstFace;
+		bool m_SetsMaterial;
+		std::string m_MaterialName;
+		std::string m_MeshName;
+	};
+
+	struct ObjChunk
+	{
+		const char* m_pBegin = nullptr;
+		const char* m_pEnd = nullptr;
+
+		std::vector<Vector3f> m_Positions;
+		std::vector<Vector2f> m_TexCoords;
+		std::vector<Vector3f> m_Normals;
+		std::vector<ObjFaceVertex> m_FaceVertices;
+		std::vector<u32> m_FirstFaceVertices;
+		std::vector<ObjMeshBreak> m_MeshBreaks;
+		std::vector<std::string> m_MaterialLibraries;
+
+		u32 m_FirstPosition = 0;
+		u32 m_FirstTexCoord = 0;
+		u32 m_FirstNormal = 0;
+		u32 m_FirstFace = 0;
+		u32 m_FirstFaceVertex = 0;
+	};
+
+	// Attributes of the whole file. The face vertices of face i are in [m_FirstFaceVertices[i], m_FirstFaceVertices[i + 1]).
+	struct ObjGeometry
+	{
+		std::vector<Vector3f> m_Positions;
+		std::vector<Vector2f> m_TexCoords;
+		std::vector<Vector3f> m_Normals;
+		std::vector<ObjVertexKey> m_FaceVertices;
+		std::vector<u32> m_FirstFaceVertices;
+	};
+
+	struct ObjMeshRange
+	{
+		u32 m_FirstFace;
+		u32 m_NumFaces;
+		std::string m_MaterialName;
+		// Name of the last o or g statement.
+		std::string m_MeshName;
+	};
+
+	struct ObjMaterial
+	{
+		std::string m_Name;
+		std::string m_DiffuseMapPath;
+		std::string m_AmbientMapPath;
+		std::string m_ShininessMapPath;
+	};
+
+	void ParseObjChunk(ObjChunk* pChunk);
+	void GatherObjGeometry(std::vector<ObjChunk>* pChunks, ObjGeometry* pGeometry);
+	void FindObjMeshRanges(const std::vector<ObjChunk>& chunks, u32 numFaces, std::vector<ObjMeshRange>* pMeshRanges);
+	bool LoadMtlFile(const std::filesystem::path& filePath, std::vector<ObjMaterial>* pMaterials);
+	aiMesh* CreateAssimpMesh(const ObjGeometry& geometry, const ObjMeshRange& meshRange, u32 materialIndex);
+	aiMaterial* CreateAssimpMaterial(const ObjMaterial& material);
+
+	const char* SkipSpaces(const char* pText, const char* pEnd);
+	const char* FindLineEnd(const char* pText, const char* pEnd);
+	const char* TrimLineEnd(const char* pLineBegin, const char* pLineEnd);
+	bool MatchKeyword(const char* pText, const char* pLineEnd, const char* pKeyword, const char** ppArguments);
+	const char* ParseFloat(const char* pText, const char* pEnd, f32* pValue);
+	const char* ParseInt(const char* pText, const char* pEnd, i32* pValue);
+	const char* ParseFaceVertex(const char* pText, const char* pEnd, const ObjChunk& chunk, ObjFaceVertex* pFaceVertex);
+	u32 ResolveIndex(const ObjFaceVertex& faceVertex, u32 attributeIndex, u32 firstChunkElement, u32 numElements);
+	u32 HashVertexKey(const ObjVertexKey& key);
+}
+
+aiScene* LoadObjFile(const wchar_t* pFilePath)
+{
+	MemoryMappedFile file;
+	if (!file.Open(pFilePath))
+		return nullptr;
+
+	const char* pFileBegin = (const char*)file.GetData();
+	const char* pFileEnd = pFileBegin + file.GetSizeInBytes();
+
+	// Chunks end at line boundaries. There are several chunks per thread, so that chunks with more faces than others are balanced.
+	const u64 chunkSizeInBytes = Max(kMinChunkSizeInBytes, file.GetSizeInBytes() / (kNumChunksPerThread * GetNumWorkerThreads()) + 1);
+
+	std::vector<ObjChunk> chunks;
+	for (const char* pChunkBegin = pFileBegin; pChunkBegin < pFileEnd; )
+	{
+		const char* pChunkEnd = FindLineEnd(pChunkBegin + Min(chunkSizeInBytes, u64(pFileEnd - pChunkBegin)) - 1, pFileEnd);
+		if (pChunkEnd < pFileEnd)
+			++pChunkEnd;
+
+		chunks.emplace_back();
+		chunks.back().m_pBegin = pChunkBegin;
+		chunks.back().m_pEnd = pChunkEnd;
+
+		pChunkBegin = pChunkEnd;
+	}
+
+	ParallelFor(chunks.size(), [&chunks](u32 chunkIndex)
+	{
+		ParseObjChunk(&chunks[chunkIndex]);
+	});
+
+	ObjGeometry geometry;
+	GatherObjGeometry(&chunks, &geometry);
+
+	const u32 numFaces = geometry.m_FirstFaceVertices.size() - 1;
+	std::vector<ObjMeshRange> meshRanges;
+	FindObjMeshRanges(chunks, numFaces, &meshRanges);
+
+	std::filesystem::path directoryPath(pFilePath);
+	directoryPath.remove_filename();
+
+	std::vector<ObjMaterial> materials;
+	for (const ObjChunk& chunk : chunks)
+	{
+		for (const std::string& materialLibrary : chunk.m_MaterialLibraries)
+		{
+			if (!LoadMtlFile(directoryPath / materialLibrary, &materials))
+			{
+				const std::string message = "Failed to load material library " + materialLibrary + "\n";
+				OutputDebugStringA(message.c_str());
+			}
+		}
+	}
+
+	// Only the referenced materials are kept, in the order of the material libraries.
+	// Faces with unknown or no material get the default material, which comes last.
+	std::unordered_map<std::string, u32> materialIndicesPerName;
+	for (u32 materialIndex = 0; materialIndex < materials.size(); ++materialIndex)
+		materialIndicesPerName.emplace(materials[materialIndex].m_Name, materialIndex);
+
+	const u32 defaultMaterialIndex = materials.size();
+	std::vector<u32> meshMaterialIndices(meshRanges.size());
+	std::vector<u32> remappedMaterialIndices(materials.size() + 1, kMissingIndex);
+
+	for (u32 meshIndex = 0; meshIndex < meshRanges.size(); ++meshIndex)
+	{
+		auto it = materialIndicesPerName.find(meshRanges[meshIndex].m_MaterialName);
+		meshMaterialIndices[meshIndex] = (it != materialIndicesPerName.end()) ? it->second : defaultMaterialIndex;
+		remappedMaterialIndices[meshMaterialIndices[meshIndex]] = 0;
+	}
+
+	u32 numUsedMaterials = 0;
+	for (u32& materialIndex : remappedMaterialIndices)
+	{
+		if (materialIndex != kMissingIndex)
+			materialIndex = numUsedMaterials++;
+	}
+
+	aiScene* pScene = new aiScene();
+	pScene->mRootNode = new aiNode();
+	pScene->mRootNode->mName.Set("<OBJRoot>");
+
+	pScene->mNumMaterials = numUsedMaterials;
+	pScene->mMaterials = new aiMaterial*[numUsedMaterials];
+
+	ObjMaterial defaultMaterial;
+	defaultMaterial.m_Name = "DefaultMaterial";
+
+	for (u32 materialIndex = 0; materialIndex < remappedMaterialIndices.size(); ++materialIndex)
+	{
+		const u32 remappedMaterialIndex = remappedMaterialIndices[materialIndex];
+		if (remappedMaterialIndex == kMissingIndex)
+			continue;
+
+		pScene->mMaterials[remappedMaterialIndex] = CreateAssimpMaterial((materialIndex == defaultMaterialIndex) ? defaultMaterial : materials[materialIndex]);
+	}
+
+	pScene->mNumMeshes = meshRanges.size();
+	pScene->mMeshes = new aiMesh*[meshRanges.size()];
+
+	ParallelFor(meshRanges.size(), [&](u32 meshIndex)
+	{
+		const u32 materialIndex = remappedMaterialIndices[meshMaterialIndices[meshIndex]];
+		pScene->mMeshes[meshIndex] = CreateAssimpMesh(geometry, meshRanges[meshIndex], materialIndex);
+	});
+
+	pScene->mRootNode->mNumMeshes = pScene->mNumMeshes;
+	pScene->mRootNode->mMeshes = new u32[pScene->mNumMeshes];
+	for (u32 meshIndex = 0; meshIndex < pScene->mNumMeshes; ++meshIndex)
+		pScene->mRootNode->mMeshes[meshIndex] = meshIndex;
+
+	u32 numVertices = 0;
+	u32 numTriangles = 0;
+	for (u32 meshIndex = 0; meshIndex < pScene->mNumMeshes; ++meshIndex)
+	{
+		numVertices += pScene->mMeshes[meshIndex]->mNumVertices;
+		numTriangles += pScene->mMeshes[meshIndex]->mNumFaces;
+	}
+
+	const u32 outputBufferSize = 256;
+	char outputBuffer[outputBufferSize];
+
+	std::snprintf(outputBuffer, outputBufferSize,
+		"OBJ loading: %.2f MB in %u chunks, %u meshes, %u materials, %u vertices, %u triangles\n",
+		f32(file.GetSizeInBytes()) / (1024.0f * 1024.0f), u32(chunks.size()),
+		pScene->mNumMeshes, pScene->mNumMaterials, numVertices, numTriangles);
+
+	OutputDebugStringA(outputBuffer);
+
+	return pScene;
+}
+
+namespace
+{
+	void ParseObjChunk(ObjChunk* pChunk)
+	{
+		const char* pEnd = pChunk->m_pEnd;
+		for (const char* pText = pChunk->m_pBegin; pText < pEnd; )
+		{
+			const char* pLineBegin = SkipSpaces(pText, pEnd);
+			const char* pNextLine = FindLineEnd(pLineBegin, pEnd);
+			const char* pLineEnd = TrimLineEnd(pLineBegin, pNextLine);
+			pText = (pNextLine < pEnd) ? pNextLine + 1 : pEnd;
+
+			const char* pArguments = nullptr;
+			if (MatchKeyword(pLineBegin, pLineEnd, "v", &pArguments))
+			{
+				Vector3f position;
+				pArguments = ParseFloat(pArguments, pLineEnd, &position.m_X);
+				pArguments = ParseFloat(pArguments, pLineEnd, &position.m_Y);
+				pArguments = ParseFloat(pArguments, pLineEnd, &position.m_Z);
+				pChunk->m_Positions.emplace_back(position);
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "vt", &pArguments))
+			{
+				Vector2f texCoords;
+				pArguments = ParseFloat(pArguments, pLineEnd, &texCoords.m_X);
+				pArguments = ParseFloat(pArguments, pLineEnd, &texCoords.m_Y);
+				pChunk->m_TexCoords.emplace_back(texCoords);
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "vn", &pArguments))
+			{
+				Vector3f normal;
+				pArguments = ParseFloat(pArguments, pLineEnd, &normal.m_X);
+				pArguments = ParseFloat(pArguments, pLineEnd, &normal.m_Y);
+				pArguments = ParseFloat(pArguments, pLineEnd, &normal.m_Z);
+				pChunk->m_Normals.emplace_back(normal);
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "f", &pArguments))
+			{
+				const u32 firstFaceVertex = pChunk->m_FaceVertices.size();
+				while (pArguments < pLineEnd)
+				{
+					ObjFaceVertex faceVertex;
+					const char* pNextArgument = ParseFaceVertex(pArguments, pLineEnd, *pChunk, &faceVertex);
+
+					// Skip the tokens which are not face vertices.
+					if (pNextArgument == pArguments)
+					{
+						while ((pNextArgument < pLineEnd) && (*pNextArgument != ' ') && (*pNextArgument != '\t'))
+							++pNextArgument;
+					}
+					else
+					{
+						pChunk->m_FaceVertices.emplace_back(faceVertex);
+					}
+					pArguments = SkipSpaces(pNextArgument, pLineEnd);
+				}
+
+				// Points and lines are not rendered.
+				if (pChunk->m_FaceVertices.size() - firstFaceVertex >= 3)
+					pChunk->m_FirstFaceVertices.emplace_back(firstFaceVertex);
+				else
+					pChunk->m_FaceVertices.resize(firstFaceVertex);
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "usemtl", &pArguments))
+			{
+				ObjMeshBreak meshBreak;
+				meshBreak.m_FirstFace = pChunk->m_FirstFaceVertices.size();
+				meshBreak.m_SetsMaterial = true;
+				meshBreak.m_MaterialName.assign(pArguments, pLineEnd);
+				pChunk->m_MeshBreaks.emplace_back(std::move(meshBreak));
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "o", &pArguments) || MatchKeyword(pLineBegin, pLineEnd, "g", &pArguments))
+			{
+				ObjMeshBreak meshBreak;
+				meshBreak.m_FirstFace = pChunk->m_FirstFaceVertices.size();
+				meshBreak.m_SetsMaterial = false;
+				meshBreak.m_MeshName.assign(pArguments, pLineEnd);
+				pChunk->m_MeshBreaks.emplace_back(std::move(meshBreak));
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "mtllib", &pArguments))
+			{
+				// File names may contain spaces, so the rest of the line is taken as a single file name.
+				pChunk->m_MaterialLibraries.emplace_back(pArguments, pLineEnd);
+			}
+		}
+	}
+
+	void GatherObjGeometry(std::vector<ObjChunk>* pChunks, ObjGeometry* pGeometry)
+	{
+		std::vector<ObjChunk>& chunks = *pChunks;
+
+		u32 numPositions = 0;
+		u32 numTexCoords = 0;
+		u32 numNormals = 0;
+		u32 numFaces = 0;
+		u32 numFaceVertices = 0;
+
+		for (ObjChunk& chunk : chunks)
+		{
+			chunk.m_FirstPosition = numPositions;
+			chunk.m_FirstTexCoord = numTexCoords;
+			chunk.m_FirstNormal = numNormals;
+			chunk.m_FirstFace = numFaces;
+			chunk.m_FirstFaceVertex = numFaceVertices;
+
+			numPositions += chunk.m_Positions.size();
+			numTexCoords += chunk.m_TexCoords.size();
+			numNormals += chunk.m_Normals.size();
+			numFaces += chunk.m_FirstFaceVertices.size();
+			numFaceVertices += chunk.m_FaceVertices.size();
+		}
+
+		pGeometry->m_Positions.resize(numPositions);
+		pGeometry->m_TexCoords.resize(numTexCoords);
+		pGeometry->m_Normals.resize(numNormals);
+		pGeometry->m_FaceVertices.resize(numFaceVertices);
+		pGeometry->m_FirstFaceVertices.resize(numFaces + 1);
+		pGeometry->m_FirstFaceVertices[numFaces] = numFaceVertices;
+
+		ParallelFor(chunks.size(), [&](u32 chunkIndex)
+		{
+			const ObjChunk& chunk = chunks[chunkIndex];
+
+			std::copy(chunk.m_Positions.cbegin(), chunk.m_Positions.cend(), pGeometry->m_Positions.begin() + chunk.m_FirstPosition);
+			std::copy(chunk.m_TexCoords.cbegin(), chunk.m_TexCoords.cend(), pGeometry->m_TexCoords.begin() + chunk.m_FirstTexCoord);
+			std::copy(chunk.m_Normals.cbegin(), chunk.m_Normals.cend(), pGeometry->m_Normals.begin() + chunk.m_FirstNormal);
+
+			for (u32 faceIndex = 0; faceIndex < chunk.m_FirstFaceVertices.size(); ++faceIndex)
+				pGeometry->m_FirstFaceVertices[chunk.m_FirstFace + faceIndex] = chunk.m_FirstFaceVertex + chunk.m_FirstFaceVertices[faceIndex];
+
+			for (u32 faceVertexIndex = 0; faceVertexIndex < chunk.m_FaceVertices.size(); ++faceVertexIndex)
+			{
+				const ObjFaceVertex& faceVertex = chunk.m_FaceVertices[faceVertexIndex];
+
+				ObjVertexKey& key = pGeometry->m_FaceVertices[chunk.m_FirstFaceVertex + faceVertexIndex];
+				key.m_PositionIndex = ResolveIndex(faceVertex, 0, chunk.m_FirstPosition, numPositions);
+				key.m_TexCoordIndex = ResolveIndex(faceVertex, 1, chunk.m_FirstTexCoord, numTexCoords);
+				key.m_NormalIndex = ResolveIndex(faceVertex, 2, chunk.m_FirstNormal, numNormals);
+			}
+		});
+	}
+
+	void FindObjMeshRanges(const std::vector<ObjChunk>& chunks, u32 numFaces, std::vector<ObjMeshRange>* pMeshRanges)
+	{
+		std::string materialName;
+		std::string meshName;
+		u32 firstFace = 0;
+
+		auto addMeshRange = [&](u32 endFace)
+		{
+			if (endFace > firstFace)
+			{
+				ObjMeshRange meshRange;
+				meshRange.m_FirstFace = firstFace;
+				meshRange.m_NumFaces = endFace - firstFace;
+				meshRange.m_MaterialName = materialName;
+				meshRange.m_MeshName = meshName;
+
+				pMeshRanges->emplace_back(std::move(meshRange));
+			}
+			firstFace = endFace;
+		};
+
+		for (const ObjChunk& chunk : chunks)
+		{
+			for (const ObjMeshBreak& meshBreak : chunk.m_MeshBreaks)
+			{
+				addMeshRange(chunk.m_FirstFace + meshBreak.m_FirstFace);
+				if (meshBreak.m_SetsMaterial)
+					materialName = meshBreak.m_MaterialName;
+				else
+					meshName = meshBreak.m_MeshName;
+			}
+		}
+		addMeshRange(numFaces);
+	}
+
+	bool LoadMtlFile(const std::filesystem::path& filePath, std::vector<ObjMaterial>* pMaterials)
+	{
+		MemoryMappedFile file;
+		if (!file.Open(filePath.c_str()))
+			return false;
+
+		const char* pText = (const char*)file.GetData();
+		const char* pEnd = pText + file.GetSizeInBytes();
+
+		ObjMaterial* pMaterial = nullptr;
+		while (pText < pEnd)
+		{
+			const char* pLineBegin = SkipSpaces(pText, pEnd);
+			const char* pNextLine = FindLineEnd(pLineBegin, pEnd);
+			const char* pLineEnd = TrimLineEnd(pLineBegin, pNextLine);
+			pText = (pNextLine < pEnd) ? pNextLine + 1 : pEnd;
+
+			// Texture options are not supported, so the rest of the line is taken as the texture path.
+			const char* pArguments = nullptr;
+			if (MatchKeyword(pLineBegin, pLineEnd, "newmtl", &pArguments))
+			{
+				pMaterials->emplace_back();
+				pMaterial = &pMaterials->back();
+				pMaterial->m_Name.assign(pArguments, pLineEnd);
+			}
+			else if (pMaterial == nullptr)
+			{
+				continue;
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "map_Kd", &pArguments))
+			{
+				pMaterial->m_DiffuseMapPath.assign(pArguments, pLineEnd);
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "map_Ka", &pArguments))
+			{
+				pMaterial->m_AmbientMapPath.assign(pArguments, pLineEnd);
+			}
+			else if (MatchKeyword(pLineBegin, pLineEnd, "map_Ns", &pArguments))
+			{
+				pMaterial->m_ShininessMapPath.assign(pArguments, pLineEnd);
+			}
+		}
+		return true;
+	}
+
+	aiMesh* CreateAssimpMesh(const ObjGeometry& geometry, const ObjMeshRange& meshRange, u32 materialIndex)
+	{
+		const u32 firstFaceVertex = geometry.m_FirstFaceVertices[meshRange.m_FirstFace];
+		const u32 numFaceVertices = geometry.m_FirstFaceVertices[meshRange.m_FirstFace + meshRange.m_NumFaces] - firstFaceVertex;
+
+		// Face vertices with the same attribute indices share the vertex.
+		// Open addressing table with linear probing, kept at most half full.
+		u32 tableSize = 1;
+		while (tableSize < 2 * numFaceVertices)
+			tableSize *= 2;
+
+		std::vector<u32> table(tableSize, kMissingIndex);
+		std::vector<ObjVertexKey> vertexKeys;
+		std::vector<u32> vertexIndices(numFaceVertices);
+		bool hasNormals = true;
+		bool hasTexCoords = false;
+
+		for (u32 faceVertexIndex = 0; faceVertexIndex < numFaceVertices; ++faceVertexIndex)
+		{
+			const ObjVertexKey& key = geometry.m_FaceVertices[firstFaceVertex + faceVertexIndex];
+			if (key.m_NormalIndex == kMissingIndex)
+				hasNormals = false;
+			if (key.m_TexCoordIndex != kMissingIndex)
+				hasTexCoords = true;
+
+			u32 slot = HashVertexKey(key) & (tableSize - 1);
+			while (table[slot] != kMissingIndex)
+			{
+				const ObjVertexKey& otherKey = vertexKeys[table[slot]];
+				if ((otherKey.m_PositionIndex == key.m_PositionIndex) &&
+					(otherKey.m_TexCoordIndex == key.m_TexCoordIndex) &&
+					(otherKey.m_NormalIndex == key.m_NormalIndex))
+					break;
+
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if (table[slot] == kMissingIndex)
+			{
+				table[slot] = vertexKeys.size();
+				vertexKeys.emplace_back(key);
+			}
+			vertexIndices[faceVertexIndex] = table[slot];
+		}
+
+		const u32 numVertices = vertexKeys.size();
+		const u32 numTriangles = numFaceVertices - 2 * meshRange.m_NumFaces;
+
+		aiMesh* pMesh = new aiMesh();
+		pMesh->mName.Set(meshRange.m_MeshName);
+		pMesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		pMesh->mMaterialIndex = materialIndex;
+		pMesh->mNumVertices = numVertices;
+		pMesh->mVertices = new aiVector3D[numVertices];
+		if (hasTexCoords)
+		{
+			pMesh->mTextureCoords[0] = new aiVector3D[numVertices];
+			pMesh->mNumUVComponents[0] = 2;
+		}
+		if (hasNormals)
+			pMesh->mNormals = new aiVector3D[numVertices];
+
+		// Same conversions as the Assimp steps MakeLeftHanded and FlipUVs.
+		for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+		{
+			const ObjVertexKey& key = vertexKeys[vertexIndex];
+
+			const Vector3f position = (key.m_PositionIndex != kMissingIndex) ? geometry.m_Positions[key.m_PositionIndex] : Vector3f::ZERO;
+			pMesh->mVertices[vertexIndex].Set(position.m_X, position.m_Y, -position.m_Z);
+
+			if (hasTexCoords)
+			{
+				// Face vertices without vt in a mesh with texture coordinates get zero, as in the Assimp OBJ importer.
+				const Vector2f texCoords = (key.m_TexCoordIndex != kMissingIndex) ? geometry.m_TexCoords[key.m_TexCoordIndex] : Vector2f::ZERO;
+				pMesh->mTextureCoords[0][vertexIndex].Set(texCoords.m_X, 1.0f - texCoords.m_Y, 0.0f);
+			}
+
+			if (hasNormals)
+			{
+				const Vector3f& normal = geometry.m_Normals[key.m_NormalIndex];
+				pMesh->mNormals[vertexIndex].Set(normal.m_X, normal.m_Y, -normal.m_Z);
+			}
+		}
+
+		// Polygons are triangulated as fans, with the winding order flipped as by the Assimp step FlipWindingOrder.
+		pMesh->mNumFaces = numTriangles;
+		pMesh->mFaces = new aiFace[numTriangles];
+
+		u32 triangleIndex = 0;
+		for (u32 faceIndex = meshRange.m_FirstFace; faceIndex < meshRange.m_FirstFace + meshRange.m_NumFaces; ++faceIndex)
+		{
+			const u32 firstIndex = geometry.m_FirstFaceVertices[faceIndex] - firstFaceVertex;
+			const u32 lastIndex = geometry.m_FirstFaceVertices[faceIndex + 1] - firstFaceVertex - 1;
+
+			for (u32 index = firstIndex + 1; index < lastIndex; ++index)
+			{
+				aiFace& face = pMesh->mFaces[triangleIndex++];
+				face.mNumIndices = 3;
+				face.mIndices = new u32[3];
+				face.mIndices[0] = vertexIndices[index + 1];
+				face.mIndices[1] = vertexIndices[index];
+				face.mIndices[2] = vertexIndices[firstIndex];
+			}
+		}
+		assert(triangleIndex == numTriangles);
+
+		return pMesh;
+	}
+
+	aiMaterial* CreateAssimpMaterial(const ObjMaterial& material)
+	{
+		aiMaterial* pMaterial = new aiMaterial();
+
+		const aiString name(material.m_Name);
+		pMaterial->AddProperty(&name, AI_MATKEY_NAME);
+
+		// Texture types follow the Assimp OBJ importer.
+		if (!material.m_DiffuseMapPath.empty())
+		{
+			const aiString mapPath(material.m_DiffuseMapPath);
+			pMaterial->AddProperty(&mapPath, AI_MATKEY_TEXTURE(aiTextureType_DIFFUSE, 0));
+		}
+		if (!material.m_AmbientMapPath.empty())
+		{
+			const aiString mapPath(material.m_AmbientMapPath);
+			pMaterial->AddProperty(&mapPath, AI_MATKEY_TEXTURE(aiTextureType_AMBIENT, 0));
+		}
+		if (!material.m_ShininessMapPath.empty())
+		{
+			const aiString mapPath(material.m_ShininessMapPath);
+			pMaterial->AddProperty(&mapPath, AI_MATKEY_TEXTURE(aiTextureType_SHININESS, 0));
+		}
+		return pMaterial;
+	}
+
+	const char* SkipSpaces(const char* pText, const char* pEnd)
+	{
+		while ((pText < pEnd) && ((*pText == ' ') || (*pText == '\t')))
+			++pText;
+		return pText;
+	}
+
+	const char* FindLineEnd(const char* pText, const char* pEnd)
+	{
+		const void* pLineEnd = std::memchr(pText, '\n', pEnd - pText);
+		return (pLineEnd != nullptr) ? (const char*)pLineEnd : pEnd;
+	}
+
+	const char* TrimLineEnd(const char* pLineBegin, const char* pLineEnd)
+	{
+		while ((pLineEnd > pLineBegin) && ((pLineEnd[-1] == ' ') || (pLineEnd[-1] == '\t') || (pLineEnd[-1] == '\r')))
+			--pLineEnd;
+		return pLineEnd;
+	}
+
+	bool MatchKeyword(const char* pText, const char* pLineEnd, const char* pKeyword, const char** ppArguments)
+	{
+		const std::size_t keywordLength = std::strlen(pKeyword);
+		if ((std::size_t(pLineEnd - pText) < keywordLength) || (std::memcmp(pText, pKeyword, keywordLength) != 0))
+			return false;
+
+		const char* pArguments = pText + keywordLength;
+		if ((pArguments < pLineEnd) && (*pArguments != ' ') && (*pArguments != '\t'))
+			return false;
+
+		*ppArguments = SkipSpaces(pArguments, pLineEnd);
+		return true;
+	}
+
+	const char* ParseFloat(const char* pText, const char* pEnd, f32* pValue)
+	{
+		static const f64 kPowersOf10[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+		static const i32 kMaxExactPowerOf10 = ARRAYSIZE(kPowersOf10) - 1;
+
+		pText = SkipSpaces(pText, pEnd);
+
+		bool isNegative = false;
+		if ((pText < pEnd) && ((*pText == '-') || (*pText == '+')))
+			isNegative = (*pText++ == '-');
+
+		// Significant digits are accumulated in an integer mantissa and scaled by an exact power of 10 in double precision.
+		// Digits beyond the mantissa precision only shift the exponent.
+		u64 mantissa = 0;
+		u32 numMantissaDigits = 0;
+		i32 exponent = 0;
+
+		for (; (pText < pEnd) && (*pText >= '0') && (*pText <= '9'); ++pText)
+		{
+			if (numMantissaDigits < kMaxNumMantissaDigits)
+			{
+				mantissa = 10 * mantissa + u64(*pText - '0');
+				if (mantissa != 0)
+					++numMantissaDigits;
+			}
+			else
+			{
+				++exponent;
+			}
+		}
+		if ((pText < pEnd) && (*pText == '.'))
+		{
+			for (++pText; (pText < pEnd) && (*pText >= '0') && (*pText <= '9'); ++pText)
+			{
+				if (numMantissaDigits < kMaxNumMantissaDigits)
+				{
+					mantissa = 10 * mantissa + u64(*pText - '0');
+					if (mantissa != 0)
+						++numMantissaDigits;
+					--exponent;
+				}
+			}
+		}
+		if ((pText < pEnd) && ((*pText == 'e') || (*pText == 'E')))
+		{
+			i32 exponentValue = 0;
+			const char* pExponentEnd = ParseInt(pText + 1, pEnd, &exponentValue);
+			if (pExponentEnd != pText + 1)
+			{
+				exponent += exponentValue;
+				pText = pExponentEnd;
+			}
+		}
+
+		f64 value = f64(mantissa);
+		if ((exponent >= 0) && (exponent <= kMaxExactPowerOf10))
+			value *= kPowersOf10[exponent];
+		else if ((exponent < 0) && (exponent >= -kMaxExactPowerOf10))
+			value /= kPowersOf10[-exponent];
+		else
+			value *= std::pow(10.0, exponent);
+
+		*pValue = f32(isNegative ? -value : value);
+		return pText;
+	}
+
+	const char* ParseInt(const char* pText, const char* pEnd, i32* pValue)
+	{
+		const char* pBegin = pText;
+
+		bool isNegative = false;
+		if ((pText < pEnd) && ((*pText == '-') || (*pText == '+')))
+			isNegative = (*pText++ == '-');
+
+		const char* pDigits = pText;
+		i32 value = 0;
+		for (; (pText < pEnd) && (*pText >= '0') && (*pText <= '9'); ++pText)
+			value = 10 * value + i32(*pText - '0');
+
+		if (pText == pDigits)
+			return pBegin;
+
+		*pValue = isNegative ? -value : value;
+		return pText;
+	}
+
+	const char* ParseFaceVertex(const char* pText, const char* pEnd, const ObjChunk& chunk, ObjFaceVertex* pFaceVertex)
+	{
+		// Face vertex is one of v, v/vt, v//vn and v/vt/vn.
+		const u32 numElements[] = {u32(chunk.m_Positions.size()), u32(chunk.m_TexCoords.size()), u32(chunk.m_Normals.size())};
+
+		pFaceVertex->m_Indices[0] = pFaceVertex->m_Indices[1] = pFaceVertex->m_Indices[2] = 0;
+		pFaceVertex->m_RelativeIndexMask = 0;
+
+		const char* pBegin = pText;
+		for (u32 attributeIndex = 0; attributeIndex < 3; ++attributeIndex)
+		{
+			if (attributeIndex > 0)
+			{
+				if ((pText == pEnd) || (*pText != '/'))
+					break;
+				++pText;
+			}
+
+			i32 index = 0;
+			const char* pIndexEnd = ParseInt(pText, pEnd, &index);
+			if (pIndexEnd == pText)
+			{
+				if (attributeIndex == 0)
+					return pBegin;
+				continue;
+			}
+			pText = pIndexEnd;
+
+			if (index < 0)
+			{
+				pFaceVertex->m_Indices[attributeIndex] = i32(numElements[attributeIndex]) + index;
+				pFaceVertex->m_RelativeIndexMask |= 1 << attributeIndex;
+			}
+			else
+			{
+				pFaceVertex->m_Indices[attributeIndex] = index;
+			}
+		}
+		return pText;
+	}
+
+	u32 ResolveIndex(const ObjFaceVertex& faceVertex, u32 attributeIndex, u32 firstChunkElement, u32 numElements)
+	{
+		const i64 index = ((faceVertex.m_RelativeIndexMask & (1 << attributeIndex)) != 0) ?
+			i64(firstChunkElement) + faceVertex.m_Indices[attributeIndex] :
+			i64(faceVertex.m_Indices[attributeIndex]) - 1;
+
+		return ((index >= 0) && (index < i64(numElements))) ? u32(index) : kMissingIndex;
+	}
+
+	u32 HashVertexKey(const ObjVertexKey& key)
+	{
+		u32 hash = key.m_PositionIndex * 0x9e3779b1u;
+		hash = (hash ^ (hash >> 15) ^ key.m_TexCoordIndex) * 0x85ebca6bu;
+		hash = (hash ^ (hash >> 13) ^ key.m_NormalIndex) * 0xc2b2ae35u;
+		return hash ^ (hash >> 16);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "Scene/ProceduralScene.h"
+#include "Scene/Scene.h"
+#include "Scene/Mesh.h"
+#include "Scene/MeshInstancing.h"
+#include "Common/ParallelFor.h"
+#include "Math/Transform.h"
+#include "Math/Random.h"
+
+namespace
+{
+	enum class ProceduralShape
+	{
+		Box,
+		Sphere
+	};
+
+	struct ProceduralMesh
+	{
+		ProceduralShape m_Shape;
+		Vector3f m_Size;
+		u32 m_NumVertices;
+		u32 m_NumIndices;
+		u32 m_NumInstances;
+		u32 m_MaterialID;
+	};
+
+	const u64 kGlobalStreamIndex = 0;
+	const u64 kFirstMeshStreamIndex = 1;
+
+	const Vector3f GeneratePosition(Random& random, const ProceduralSceneParams& params, const std::vector<Vector3f>& clusterCenters);
+	void WriteBoxGeometry(const Vector3f& size, const MeshBatch::MeshStreams& streams);
+	void WriteSphereGeometry(const Vector3f& size, u32 numSegments, const MeshBatch::MeshStreams& streams);
+}
+
+Scene* GenerateProceduralScene(const ProceduralSceneParams& params)
+{
+	assert(params.m_NumMeshes > 0);
+	assert(params.m_NumMaterials > 0);
+	assert((params.m_NumSphereSegments >= 3) && (params.m_NumSphereSegments <= 256));
+	assert(params.m_MinMeshSize <= params.m_MaxMeshSize);
+	assert(params.m_MinLightRange <= params.m_MaxLightRange);
+
+	Scene* pScene = new Scene();
+	Random random(params.m_Seed, kGlobalStreamIndex);
+
+	std::vector<Vector3f> clusterCenters(params.m_NumClusters);
+	for (Vector3f& clusterCenter : clusterCenters)
+		clusterCenter = GeneratePosition(random, params, std::vector<Vector3f>());
+
+	const u32 maxNumInstancesPerMesh = Clamp(1u, kMaxNumInstancesPerMesh, params.m_MaxNumInstancesPerMesh);
+	const u32 numSphereLongitudes = params.m_NumSphereSegments;
+	const u32 numSphereLatitudes = Max(2u, params.m_NumSphereSegments / 2);
+
+	std::vector<ProceduralMesh> meshes(params.m_NumMeshes);
+	std::vector<Random> meshRandoms;
+	meshRandoms.reserve(params.m_NumMeshes);
+
+	u32 totalNumVertices = 0;
+	u32 totalNumIndices = 0;
+	u32 totalNumInstances = 0;
+
+	for (u32 meshIndex = 0; meshIndex < params.m_NumMeshes; ++meshIndex)
+	{
+		meshRandoms.emplace_back(params.m_Seed, kFirstMeshStreamIndex + meshIndex);
+		Random& meshRandom = meshRandoms.back();
+		ProceduralMesh& mesh = meshes[meshIndex];
+
+		mesh.m_Shape = (meshRandom.NextU32(2) == 0) ? ProceduralShape::Box : ProceduralShape::Sphere;
+		mesh.m_Size = Vector3f(meshRandom.NextFloat(params.m_MinMeshSize, params.m_MaxMeshSize),
+			meshRandom.NextFloat(params.m_MinMeshSize, params.m_MaxMeshSize),
+			meshRandom.NextFloat(params.m_MinMeshSize, params.m_MaxMeshSize));
+		mesh.m_NumInstances = 1 + meshRandom.NextU32(maxNumInstancesPerMesh);
+		mesh.m_MaterialID = meshRandom.NextU32(params.m_NumMaterials);
+
+		if (mesh.m_Shape == ProceduralShape::Box)
+		{
+			mesh.m_NumVertices = 24;
+			mesh.m_NumIndices = 36;
+		}
+		else
+		{
+			// Triangles which collapse at the poles are not emitted.
+			mesh.m_NumVertices = (numSphereLongitudes + 1) * (numSphereLatitudes + 1);
+			mesh.m_NumIndices = 6 * numSphereLongitudes * (numSphereLatitudes - 1);
+		}
+
+		totalNumVertices += mesh.m_NumVertices;
+		totalNumIndices += mesh.m_NumIndices;
+		totalNumInstances += mesh.m_NumInstances;
+	}
+
+	const u8 vertexFormat = VertexData::FormatFlag_Position | VertexData::FormatFlag_Normal | VertexData::FormatFlag_TexCoords;
+	MeshBatch* pMeshBatch = new MeshBatch(vertexFormat, DXGI_FORMAT_R16_UINT, D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	pMeshBatch->Reserve(params.m_NumMeshes, totalNumVertices, totalNumIndices, totalNumInstances);
+
+	std::vector<MeshBatch::MeshStreams> meshStreams(params.m_NumMeshes);
+	for (u32 meshIndex = 0; meshIndex < params.m_NumMeshes; ++meshIndex)
+	{
+		const ProceduralMesh& mesh = meshes[meshIndex];
+		meshStreams[meshIndex] = pMeshBatch->AppendMesh(mesh.m_NumVertices, mesh.m_NumIndices, mesh.m_NumInstances, mesh.m_MaterialID);
+	}
+
+	auto writeMesh = [&](u32 meshIndex)
+	{
+		const ProceduralMesh& mesh = meshes[meshIndex];
+		const MeshBatch::MeshStreams& streams = meshStreams[meshIndex];
+
+		if (mesh.m_Shape == ProceduralShape::Box)
+			WriteBoxGeometry(mesh.m_Size, streams);
+		else
+			WriteSphereGeometry(mesh.m_Size, numSphereLongitudes, streams);
+
+		// The mesh random sequence continues after the values used for the mesh description.
+		Random& meshRandom = meshRandoms[meshIndex];
+		for (u32 instanceIndex = 0; instanceIndex < mesh.m_NumInstances; ++instanceIndex)
+		{
+			const f32 scale = meshRandom.NextFloat(0.5f, 2.0f);
+			const f32 yawAngle = meshRandom.NextFloat(0.0f, TWO_PI);
+			const Vector3f position = GeneratePosition(meshRandom, params, clusterCenters);
+
+			streams.m_pInstanceWorldMatrices[instanceIndex] = CreateScalingMatrix(scale) * CreateRotationYMatrix(yawAngle) * CreateTranslationMatrix(position);
+		}
+		pMeshBatch->FinishMesh(meshIndex);
+	};
+	ParallelFor(params.m_NumMeshes, writeMesh);
+
+	if (params.m_PrepareMeshBatch)
+	{
+		pMeshBatch->SortByMortonCode(true);
+		pMeshBatch->BuildMeshClusters();
+		pMeshBatch->SelectVertexCompression(VertexPrecisionBudget());
+	}
+	pScene->AddMeshBatch(pMeshBatch);
+
+	for (u32 materialIndex = 0; materialIndex < params.m_NumMaterials; ++materialIndex)
+	{
+		Material* pMaterial = new Material(L"ProceduralMaterial" + std::to_wstring(materialIndex));
+		pMaterial->m_FilePaths[Material::BaseColorTextureIndex] = params.m_TextureDirectoryPath + L"\\Default_Albedo.dds";
+		pMaterial->m_FilePaths[Material::MetalnessTextureIndex] = params.m_TextureDirectoryPath + L"\\Default_Metallic.dds";
+		pMaterial->m_FilePaths[Material::RougnessTextureIndex] = params.m_TextureDirectoryPath + L"\\Default_Roughness.dds";
+
+		pScene->AddMaterial(pMaterial);
+	}
+
+	for (u32 lightIndex = 0; lightIndex < params.m_NumSpotLights; ++lightIndex)
+	{
+		const Vector3f radiantPower(random.NextFloat(10.0f, 30.0f), random.NextFloat(10.0f, 30.0f), random.NextFloat(10.0f, 30.0f));
+		const f32 range = random.NextFloat(params.m_MinLightRange, params.m_MaxLightRange);
+		const f32 outerConeAngle = random.NextFloat(ToRadians(45.0f), ToRadians(90.0f));
+		const Vector3f position = GeneratePosition(random, params, clusterCenters);
+
+		SpotLight* pSpotLight = new SpotLight(
+			position/*worldPosition*/,
+			BasisAxes(Vector3f::RIGHT, Vector3f::FORWARD, Vector3f::DOWN)/*worldOrientation*/,
+			radiantPower/*radiantPower*/,
+			range/*range*/,
+			0.75f * outerConeAngle/*innerConeAngleInRadians*/,
+			outerConeAngle/*outerConeAngleInRadians*/,
+			0.1f/*shadowNearPlane*/,
+			80.0f/*expShadowMapConstant*/
+		);
+		pScene->AddSpotLight(pSpotLight);
+	}
+
+	for (u32 lightIndex = 0; lightIndex < params.m_NumPointLights; ++lightIndex)
+	{
+		const Vector3f radiantPower(random.NextFloat(10.0f, 30.0f), random.NextFloat(10.0f, 30.0f), random.NextFloat(10.0f, 30.0f));
+		const f32 range = random.NextFloat(params.m_MinLightRange, params.m_MaxLightRange);
+		const Vector3f position = GeneratePosition(random, params, clusterCenters);
+
+		PointLight* pPointLight = new PointLight(
+			position/*worldPosition*/,
+			radiantPower/*radiantPower*/,
+			range/*range*/,
+			0.1f/*shadowNearPlane*/,
+			80.0f/*expShadowMapConstant*/
+		);
+		pScene->AddPointLight(pPointLight);
+	}
+
+	const AxisAlignedBox& worldBounds = pScene->GetWorldBounds();
+	const f32 sceneDiameter = 2.0f * Length(worldBounds.m_Radius);
+
+	Camera* pCamera = new Camera(
+		Vector3f(worldBounds.m_Center.m_X, worldBounds.m_Center.m_Y, worldBounds.m_Center.m_Z - worldBounds.m_Radius.m_Z)/*worldPosition*/,
+		BasisAxes()/*worldOrientation*/,
+		PI_DIV_4/*fovYInRadians*/,
+		1.0f/*aspectRatio*/,
+		0.1f/*nearClipDist*/,
+		sceneDiameter/*farClipDist*/,
+		Vector3f(0.001f * sceneDiameter)/*moveSpeed*/,
+		Vector3f(0.001f)/*rotationSpeed*/
+	);
+	pScene->SetCamera(pCamera);
+
+	DirectionalLight* pDirectionalLight = new DirectionalLight(
+		Normalize(Vector3f(0.25f, -1.0f, 0.5f))/*worldDirection*/,
+		Vector3f(2.0f)/*irradiancePerpToLightDirection*/
+	);
+	pScene->SetDirectionalLight(pDirectionalLight);
+
+	return pScene;
+}
+
+namespace
+{
+	const Vector3f GeneratePosition(Random& random, const ProceduralSceneParams& params, const std::vector<Vector3f>& clusterCenters)
+	{
+		const Vector3f minPoint = params.m_WorldBounds.m_Center - params.m_WorldBounds.m_Radius;
+		const Vector3f maxPoint = params.m_WorldBounds.m_Center + params.m_WorldBounds.m_Radius;
+
+		if (clusterCenters.empty())
+		{
+			return Vector3f(random.NextFloat(minPoint.m_X, maxPoint.m_X),
+				random.NextFloat(minPoint.m_Y, maxPoint.m_Y),
+				random.NextFloat(minPoint.m_Z, maxPoint.m_Z));
+		}
+
+		const Vector3f& clusterCenter = clusterCenters[random.NextU32(u32(clusterCenters.size()))];
+		const f32 x = clusterCenter.m_X + params.m_ClusterRadius * random.NextGaussian();
+		const f32 y = clusterCenter.m_Y + params.m_ClusterRadius * random.NextGaussian();
+		const f32 z = clusterCenter.m_Z + params.m_ClusterRadius * random.NextGaussian();
+
+		return Vector3f(Clamp(minPoint.m_X, maxPoint.m_X, x), Clamp(minPoint.m_Y, maxPoint.m_Y, y), Clamp(minPoint.m_Z, maxPoint.m_Z, z));
+	}
+
+	void WriteBoxGeometry(const Vector3f& size, const MeshBatch::MeshStreams& streams)
+	{
+		const Vector3f axes[] = {Vector3f::RIGHT, Vector3f::UP, Vector3f::FORWARD};
+		const Vector3f halfSize = 0.5f * size;
+
+		u32 vertexIndex = 0;
+		u32 indexIndex = 0;
+
+		for (u32 axisIndex = 0; axisIndex < 3; ++axisIndex)
+		{
+			for (f32 sign : {1.0f, -1.0f})
+			{
+				// Cross(uAxis, vAxis) == normal, so the triangles face outwards with clockwise winding.
+				const Vector3f normal = sign * axes[axisIndex];
+				Vector3f uAxis = axes[(axisIndex + 1) % 3];
+				Vector3f vAxis = axes[(axisIndex + 2) % 3];
+				if (sign < 0.0f)
+					std::swap(uAxis, vAxis);
+
+				const Vector3f faceCenter = normal * halfSize;
+				const Vector3f uOffset = uAxis * halfSize;
+				const Vector3f vOffset = vAxis * halfSize;
+
+				const Vector3f corners[] = {faceCenter - uOffset - vOffset, faceCenter + uOffset - vOffset, faceCenter + uOffset + vOffset, faceCenter - uOffset + vOffset};
+				const Vector2f texCoords[] = {Vector2f(0.0f, 1.0f), Vector2f(1.0f, 1.0f), Vector2f(1.0f, 0.0f), Vector2f(0.0f, 0.0f)};
+
+				const u16 firstVertex = u16(vertexIndex);
+				for (u32 cornerIndex = 0; cornerIndex < 4; ++cornerIndex)
+				{
+					streams.m_pPositions[vertexIndex] = corners[cornerIndex];
+					streams.m_pNormals[vertexIndex] = normal;
+					streams.m_pTexCoords[vertexIndex] = texCoords[cornerIndex];
+					++vertexIndex;
+				}
+
+				const u16 faceIndices[] = {0, 1, 2, 0, 2, 3};
+				for (u16 faceIndex : faceIndices)
+					streams.m_p16BitIndices[indexIndex++] = firstVertex + faceIndex;
+			}
+		}
+	}
+
+	void WriteSphereGeometry(const Vector3f& size, u32 numSegments, const MeshBatch::MeshStreams& streams)
+	{
+		// Ellipsoid with the size as diameters. Latitudes go from the top pole to the bottom pole.
+		const u32 numLongitudes = numSegments;
+		const u32 numLatitudes = Max(2u, numSegments / 2);
+		const Vector3f radius = 0.5f * size;
+		const Vector3f rcpRadius = Vector3f(1.0f / radius.m_X, 1.0f / radius.m_Y, 1.0f / radius.m_Z);
+
+		u32 vertexIndex = 0;
+		for (u32 latitude = 0; latitude <= numLatitudes; ++latitude)
+		{
+			const f32 polarAngle = PI * f32(latitude) / f32(numLatitudes);
+			for (u32 longitude = 0; longitude <= numLongitudes; ++longitude)
+			{
+				const f32 azimuthAngle = TWO_PI * f32(longitude) / f32(numLongitudes);
+				const Vector3f unitPosition(std::sin(polarAngle) * std::cos(azimuthAngle), std::cos(polarAngle), std::sin(polarAngle) * std::sin(azimuthAngle));
+
+				streams.m_pPositions[vertexIndex] = unitPosition * radius;
+				streams.m_pNormals[vertexIndex] = Normalize(unitPosition * rcpRadius);
+				streams.m_pTexCoords[vertexIndex] = Vector2f(f32(longitude) / f32(numLongitudes), f32(latitude) / f32(numLatitudes));
+				++vertexIndex;
+			}
+		}
+
+		u32 indexIndex = 0;
+		for (u32 latitude = 0; latitude < numLatitudes; ++latitude)
+		{
+			for (u32 longitude = 0; longitude < numLongitudes; ++longitude)
+			{
+				const u16 vertex0 = u16(latitude * (numLongitudes + 1) + longitude);
+				const u16 vertex1 = vertex0 + 1;
+				const u16 vertex2 = vertex1 + u16(numLongitudes + 1);
+				const u16 vertex3 = vertex0 + u16(numLongitudes + 1);
+
+				if (latitude != 0)
+				{
+					streams.m_p16BitIndices[indexIndex++] = vertex0;
+					streams.m_p16BitIndices[indexIndex++] = vertex1;
+					streams.m_p16BitIndices[indexIndex++] = vertex2;
+				}
+				if (latitude != numLatitudes - 1)
+				{
+					streams.m_p16BitIndices[indexIndex++] = vertex0;
+					streams.m_p16BitIndices[indexIndex++] = vertex2;
+					streams.m_p16BitIndices[indexIndex++] = vertex3;
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
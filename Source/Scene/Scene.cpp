@@ -1,5 +1,11 @@
 #include "Scene/Scene.h"
 
+namespace
+{
+	template <typename T>
+	bool RemoveObject(std::vector<T*>& objects, T* pObject);
+}
+
 Scene::Scene()
 	: m_WorldBounds(Vector3f::ZERO, Vector3f::ZERO)
 	, m_pCamera(nullptr)
@@ -72,9 +78,41 @@ MeshBatch** Scene::GetMeshBatches()
 	return m_MeshBatches.data();
 }
 
-void Scene::AddMaterial(Material* pMaterial)
+bool Scene::RemoveMeshBatch(MeshBatch* pMeshBatch)
 {
+	if (!RemoveObject(m_MeshBatches, pMeshBatch))
+		return false;
+
+	m_WorldBounds = AxisAlignedBox(Vector3f::ZERO, Vector3f::ZERO);
+	for (decltype(m_MeshBatches.size()) batchIndex = 0; batchIndex < m_MeshBatches.size(); ++batchIndex)
+	{
+		const u32 numMeshInstances = m_MeshBatches[batchIndex]->GetNumMeshInstances();
+		const AxisAlignedBox* instanceWorldAABBs = m_MeshBatches[batchIndex]->GetMeshInstanceWorldAABBs();
+
+		u32 instanceIndex = 0;
+		if (batchIndex == 0)
+			m_WorldBounds = instanceWorldAABBs[instanceIndex++];
+
+		while (instanceIndex < numMeshInstances)
+			m_WorldBounds = AxisAlignedBox(m_WorldBounds, instanceWorldAABBs[instanceIndex++]);
+	}
+	return true;
+}
+
+u32 Scene::AddMaterial(Material* pMaterial)
+{
+	assert(pMaterial != nullptr);
+	if (!m_FreeMaterialSlots.empty())
+	{
+		const u32 materialID = m_FreeMaterialSlots.back();
+		m_FreeMaterialSlots.pop_back();
+
+		m_Materials[materialID] = pMaterial;
+		return materialID;
+	}
+
 	m_Materials.emplace_back(pMaterial);
+	return u32(m_Materials.size() - 1);
 }
 
 std::size_t Scene::GetNumMaterials() const
@@ -87,6 +125,18 @@ Material** Scene::GetMaterials()
 	return m_Materials.data();
 }
 
+bool Scene::RemoveMaterial(Material* pMaterial)
+{
+	auto it = std::find(m_Materials.begin(), m_Materials.end(), pMaterial);
+	if ((pMaterial == nullptr) || (it == m_Materials.end()))
+		return false;
+
+	// The slot is kept, so that the material IDs of the other materials do not change.
+	*it = nullptr;
+	m_FreeMaterialSlots.push_back(u32(it - m_Materials.begin()));
+	return true;
+}
+
 void Scene::AddPointLight(PointLight* pPointLight)
 {
 	m_PointLights.emplace_back(pPointLight);
@@ -102,6 +152,11 @@ PointLight** Scene::GetPointLights()
 	return m_PointLights.data();
 }
 
+bool Scene::RemovePointLight(PointLight* pPointLight)
+{
+	return RemoveObject(m_PointLights, pPointLight);
+}
+
 void Scene::AddSpotLight(SpotLight* pSpotLight)
 {
 	m_SpotLights.emplace_back(pSpotLight);
@@ -117,6 +172,11 @@ SpotLight** Scene::GetSpotLights()
 	return m_SpotLights.data();
 }
 
+bool Scene::RemoveSpotLight(SpotLight* pSpotLight)
+{
+	return RemoveObject(m_SpotLights, pSpotLight);
+}
+
 DirectionalLight* Scene::GetDirectionalLight()
 {
 	return m_pDirectionalLight;
@@ -129,4 +189,26 @@ void Scene::SetDirectionalLight(DirectionalLight* pDirectionalLight)
 		SafeDelete(m_pDirectionalLight);
 		m_pDirectionalLight = pDirectionalLight;
 	}
+}
+
+DirectionalLight* Scene::RemoveDirectionalLight()
+{
+	DirectionalLight* pDirectionalLight = m_pDirectionalLight;
+	m_pDirectionalLight = nullptr;
+	return pDirectionalLight;
+}
+
+namespace
+{
+	template <typename T>
+	bool RemoveObject(std::vector<T*>& objects, T* pObject)
+	{
+		auto it = std::find(objects.begin(), objects.end(), pObject);
+		if (it == objects.end())
+			return false;
+
+		// Keeps the order of the remaining objects
+		objects.erase(it);
+		return true;
+	}
 }
\ No newline at end of file
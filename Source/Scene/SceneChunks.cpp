@@ -0,0 +1,314 @@
+#include "Scene/SceneChunks.h"
+#include "Scene/Scene.h"
+#include "Scene/Mesh.h"
+#include "Scene/MeshInstancing.h"
+
+namespace
+{
+	// Describes the layout of the chunk in the chunk file. The table of all chunks is written after the version and the geometry hash
+	// and compared with the chunks the file is opened for before any geometry is read.
+	struct CookedChunkLayout
+	{
+		u32 m_MeshType;
+		u32 m_NumMeshes;
+		u32 m_NumVertices;
+		u32 m_NumIndices;
+	};
+
+	u64 CalcGridCellKey(const Vector3f& point, const Vector3f& gridOrigin, f32 cellSize);
+	void ExtractChunkLayouts(const std::vector<SceneChunk>& chunks, std::vector<CookedChunkLayout>* pLayouts);
+
+	u64 CalcSceneGeometryHash(Scene* pScene);
+
+	template <typename T>
+	void GatherChunkVertexElements(const MeshBatch* pMeshBatch, const SceneChunk& chunk, const T* pBatchElements, std::vector<T>* pChunkElements);
+
+	template <typename T>
+	void GatherChunkIndices(const MeshBatch* pMeshBatch, const SceneChunk& chunk, const T* pBatchIndices, std::vector<T>* pChunkIndices);
+}
+
+void BuildSceneChunks(Scene* pScene, f32 chunkSize, std::vector<SceneChunk>* pChunks)
+{
+	assert(chunkSize > 0.0f);
+	pChunks->clear();
+
+	const AxisAlignedBox& sceneBounds = pScene->GetWorldBounds();
+	const Vector3f gridOrigin = sceneBounds.m_Center - sceneBounds.m_Radius;
+
+	MeshBatch** ppMeshBatches = pScene->GetMeshBatches();
+	for (u32 meshType = 0; meshType < pScene->GetNumMeshBatches(); ++meshType)
+	{
+		const MeshBatch* pMeshBatch = ppMeshBatches[meshType];
+		const MeshInfo* pMeshInfos = pMeshBatch->GetMeshInfos();
+		const AxisAlignedBox* pInstanceWorldAABBs = pMeshBatch->GetMeshInstanceWorldAABBs();
+		
+		const u32 numMeshes = pMeshBatch->GetNumMeshes();
+		std::vector<AxisAlignedBox> meshWorldAABBs(numMeshes);
+		std::vector<std::pair<u64, u32>> meshCellKeys(numMeshes);
+
+		for (u32 meshIndex = 0; meshIndex < numMeshes; ++meshIndex)
+		{
+			const MeshInfo& meshInfo = pMeshInfos[meshIndex];
+
+			AxisAlignedBox meshBounds = pInstanceWorldAABBs[meshInfo.m_InstanceOffset];
+			for (u32 instanceIndex = meshInfo.m_InstanceOffset + 1; instanceIndex < meshInfo.m_InstanceOffset + meshInfo.m_InstanceCount; ++instanceIndex)
+				meshBounds = AxisAlignedBox(meshBounds, pInstanceWorldAABBs[instanceIndex]);
+
+			meshWorldAABBs[meshIndex] = meshBounds;
+			meshCellKeys[meshIndex] = std::make_pair(CalcGridCellKey(meshBounds.m_Center, gridOrigin, chunkSize), meshIndex);
+		}
+
+		// Meshes of a chunk keep the batch order, which already places spatially adjacent meshes next to each other.
+		std::sort(meshCellKeys.begin(), meshCellKeys.end());
+
+		for (u32 keyIndex = 0; keyIndex < numMeshes; ++keyIndex)
+		{
+			const u32 meshIndex = meshCellKeys[keyIndex].second;
+			const MeshInfo& meshInfo = pMeshInfos[meshIndex];
+
+			if ((keyIndex == 0) || (meshCellKeys[keyIndex].first != meshCellKeys[keyIndex - 1].first))
+			{
+				pChunks->emplace_back();
+				
+				SceneChunk& newChunk = pChunks->back();
+				newChunk.m_MeshType = meshType;
+				newChunk.m_WorldBounds = meshWorldAABBs[meshIndex];
+				newChunk.m_NumVertices = 0;
+				newChunk.m_NumIndices = 0;
+				newChunk.m_NumInstances = 0;
+			}
+
+			SceneChunk& chunk = pChunks->back();
+			chunk.m_WorldBounds = AxisAlignedBox(chunk.m_WorldBounds, meshWorldAABBs[meshIndex]);
+			chunk.m_MeshIndices.push_back(meshIndex);
+			chunk.m_MaterialIDs.push_back(meshInfo.m_MaterialID);
+			chunk.m_NumVertices += meshInfo.m_VertexCount;
+			chunk.m_NumIndices += meshInfo.m_IndexCount;
+			chunk.m_NumInstances += meshInfo.m_InstanceCount;
+		}
+	}
+
+	for (SceneChunk& chunk : *pChunks)
+	{
+		std::sort(chunk.m_MaterialIDs.begin(), chunk.m_MaterialIDs.end());
+		chunk.m_MaterialIDs.erase(std::unique(chunk.m_MaterialIDs.begin(), chunk.m_MaterialIDs.end()), chunk.m_MaterialIDs.end());
+	}
+}
+
+bool WriteSceneChunkFile(const wchar_t* pFilePath, Scene* pScene, const std::vector<SceneChunk>& chunks)
+{
+	std::vector<CookedChunkLayout> chunkLayouts;
+	ExtractChunkLayouts(chunks, &chunkLayouts);
+
+	CookedSceneWriter writer;
+	writer.WriteValue(kSceneChunkFileVersion);
+	writer.WriteValue(CalcSceneGeometryHash(pScene));
+	writer.WriteArray(chunkLayouts);
+
+	// Released geometry is read back for the duration of the write.
+	MeshBatch** ppMeshBatches = pScene->GetMeshBatches();
+	std::vector<MeshBatch*> releasedMeshBatches;
+	for (std::size_t batchIndex = 0; batchIndex < pScene->GetNumMeshBatches(); ++batchIndex)
+	{
+		if (!ppMeshBatches[batchIndex]->IsGeometryResident())
+			releasedMeshBatches.push_back(ppMeshBatches[batchIndex]);
+	}
+
+	bool result = true;
+	for (MeshBatch* pMeshBatch : releasedMeshBatches)
+		result &= pMeshBatch->MaterializeGeometry();
+
+	for (std::size_t chunkIndex = 0; result && (chunkIndex < chunks.size()); ++chunkIndex)
+	{
+		const SceneChunk& chunk = chunks[chunkIndex];
+		const MeshBatch* pMeshBatch = ppMeshBatches[chunk.m_MeshType];
+		const u8 vertexFormatFlags = pMeshBatch->GetVertexFormatFlags();
+		
+		std::vector<Vector3f> positions;
+		GatherChunkVertexElements(pMeshBatch, chunk, pMeshBatch->GetPositions(), &positions);
+		writer.WriteArray(positions);
+
+		if ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
+		{
+			std::vector<Vector3f> normals;
+			GatherChunkVertexElements(pMeshBatch, chunk, pMeshBatch->GetNormals(), &normals);
+			writer.WriteArray(normals);
+		}
+		if ((vertexFormatFlags & VertexData::FormatFlag_Color) != 0)
+		{
+			std::vector<Vector4f> colors;
+			GatherChunkVertexElements(pMeshBatch, chunk, pMeshBatch->GetColors(), &colors);
+			writer.WriteArray(colors);
+		}
+		if ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
+		{
+			std::vector<Vector3f> tangents;
+			GatherChunkVertexElements(pMeshBatch, chunk, pMeshBatch->GetTangents(), &tangents);
+			writer.WriteArray(tangents);
+		}
+		if ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
+		{
+			std::vector<Vector2f> texCoords;
+			GatherChunkVertexElements(pMeshBatch, chunk, pMeshBatch->GetTexCoords(), &texCoords);
+			writer.WriteArray(texCoords);
+		}
+
+		if (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT)
+		{
+			std::vector<u16> indices;
+			GatherChunkIndices(pMeshBatch, chunk, pMeshBatch->Get16BitIndices(), &indices);
+			writer.WriteArray(indices);
+		}
+		else
+		{
+			std::vector<u32> indices;
+			GatherChunkIndices(pMeshBatch, chunk, pMeshBatch->Get32BitIndices(), &indices);
+			writer.WriteArray(indices);
+		}
+	}
+
+	if (result)
+		result = writer.SaveToFile(pFilePath);
+
+	for (MeshBatch* pMeshBatch : releasedMeshBatches)
+		pMeshBatch->ReleaseGeometry();
+
+	return result;
+}
+
+bool SceneChunkFile::Open(const wchar_t* pFilePath, Scene* pScene, const std::vector<SceneChunk>& chunks)
+{
+	m_ChunkGeometry.clear();
+
+	if (!m_Reader.Open(pFilePath))
+		return false;
+
+	// The chunk file is derived from the mesh batches, so it is stale once the scene has been cooked again with different geometry.
+	const u32 version = m_Reader.ReadValue<u32>();
+	const u64 fileGeometryHash = m_Reader.ReadValue<u64>();
+	if (m_Reader.HasFailed() || (version != kSceneChunkFileVersion))
+		return false;
+
+	if (fileGeometryHash != CalcSceneGeometryHash(pScene))
+		return false;
+
+	std::vector<CookedChunkLayout> chunkLayouts;
+	ExtractChunkLayouts(chunks, &chunkLayouts);
+
+	std::size_t numFileChunks = 0;
+	const CookedChunkLayout* pFileChunkLayouts = m_Reader.ReadArray<CookedChunkLayout>(&numFileChunks);
+	if (m_Reader.HasFailed() || (numFileChunks != chunkLayouts.size()) || (std::memcmp(pFileChunkLayouts, chunkLayouts.data(), numFileChunks * sizeof(CookedChunkLayout)) != 0))
+		return false;
+
+	m_ChunkGeometry.resize(chunks.size());
+
+	MeshBatch** ppMeshBatches = pScene->GetMeshBatches();
+	for (std::size_t chunkIndex = 0; chunkIndex < chunks.size(); ++chunkIndex)
+	{
+		const MeshBatch* pMeshBatch = ppMeshBatches[chunks[chunkIndex].m_MeshType];
+		const u8 vertexFormatFlags = pMeshBatch->GetVertexFormatFlags();
+		
+		SceneChunkGeometry& geometry = m_ChunkGeometry[chunkIndex];
+		std::size_t numElements = 0;
+
+		geometry.m_pPositions = m_Reader.ReadArray<Vector3f>(&numElements);
+		if ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
+			geometry.m_pNormals = m_Reader.ReadArray<Vector3f>(&numElements);
+		if ((vertexFormatFlags & VertexData::FormatFlag_Color) != 0)
+			geometry.m_pColors = m_Reader.ReadArray<Vector4f>(&numElements);
+		if ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
+			geometry.m_pTangents = m_Reader.ReadArray<Vector3f>(&numElements);
+		if ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
+			geometry.m_pTexCoords = m_Reader.ReadArray<Vector2f>(&numElements);
+
+		if (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT)
+			geometry.m_pIndices = m_Reader.ReadArray<u16>(&numElements);
+		else
+			geometry.m_pIndices = m_Reader.ReadArray<u32>(&numElements);
+	}
+
+	if (m_Reader.HasFailed())
+	{
+		m_ChunkGeometry.clear();
+		return false;
+	}
+	return true;
+}
+
+namespace
+{
+	u64 CalcGridCellKey(const Vector3f& point, const Vector3f& gridOrigin, f32 cellSize)
+	{
+		// 21 bits per axis cover two million cells along each axis of the scene bounds.
+		const u64 maxCellCoord = (1ull << 21) - 1;
+		auto calcCellCoord = [cellSize, maxCellCoord](f32 coord, f32 originCoord)
+		{
+			return std::min(u64(Max(coord - originCoord, 0.0f) / cellSize), maxCellCoord);
+		};
+
+		const u64 x = calcCellCoord(point.m_X, gridOrigin.m_X);
+		const u64 y = calcCellCoord(point.m_Y, gridOrigin.m_Y);
+		const u64 z = calcCellCoord(point.m_Z, gridOrigin.m_Z);
+
+		return (x | (y << 21) | (z << 42));
+	}
+
+	void ExtractChunkLayouts(const std::vector<SceneChunk>& chunks, std::vector<CookedChunkLayout>* pLayouts)
+	{
+		pLayouts->resize(chunks.size());
+		for (std::size_t chunkIndex = 0; chunkIndex < chunks.size(); ++chunkIndex)
+		{
+			const SceneChunk& chunk = chunks[chunkIndex];
+
+			CookedChunkLayout& layout = (*pLayouts)[chunkIndex];
+			layout.m_MeshType = chunk.m_MeshType;
+			layout.m_NumMeshes = chunk.m_MeshIndices.size();
+			layout.m_NumVertices = chunk.m_NumVertices;
+			layout.m_NumIndices = chunk.m_NumIndices;
+		}
+	}
+
+	u64 CalcSceneGeometryHash(Scene* pScene)
+	{
+		// Released mesh batches return the hash recorded at release, so their geometry is not read back.
+		u64 hash = kHashOffsetBasis;
+
+		MeshBatch** ppMeshBatches = pScene->GetMeshBatches();
+		for (std::size_t batchIndex = 0; batchIndex < pScene->GetNumMeshBatches(); ++batchIndex)
+		{
+			const u64 batchHash = ppMeshBatches[batchIndex]->CalcGeometryHash();
+			hash = HashBytes(&batchHash, sizeof(batchHash), hash);
+		}
+		return hash;
+	}
+
+	template <typename T>
+	void GatherChunkVertexElements(const MeshBatch* pMeshBatch, const SceneChunk& chunk, const T* pBatchElements, std::vector<T>* pChunkElements)
+	{
+		pChunkElements->clear();
+		pChunkElements->reserve(chunk.m_NumVertices);
+
+		for (u32 meshIndex : chunk.m_MeshIndices)
+		{
+			const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+			const T* pFirstElement = pBatchElements + meshInfo.m_BaseVertexLocation;
+
+			pChunkElements->insert(pChunkElements->end(), pFirstElement, pFirstElement + meshInfo.m_VertexCount);
+		}
+	}
+
+	template <typename T>
+	void GatherChunkIndices(const MeshBatch* pMeshBatch, const SceneChunk& chunk, const T* pBatchIndices, std::vector<T>* pChunkIndices)
+	{
+		pChunkIndices->clear();
+		pChunkIndices->reserve(chunk.m_NumIndices);
+
+		for (u32 meshIndex : chunk.m_MeshIndices)
+		{
+			const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+			const T* pFirstIndex = pBatchIndices + meshInfo.m_StartIndexLocation;
+
+			pChunkIndices->insert(pChunkIndices->end(), pFirstIndex, pFirstIndex + meshInfo.m_IndexCount);
+		}
+	}
+}
\ No newline at end of file
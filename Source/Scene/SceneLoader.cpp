@@ -1,31 +1,148 @@
 #include "Scene/SceneLoader.h"
 #include "Common/FileUtilities.h"
+#include "Common/ParallelFor.h"
 #include "Common/StringUtilities.h"
 #include "D3DWrapper/Common.h"
 #include "Math/Transform.h"
 #include "Scene/Light.h"
 #include "Scene/Scene.h"
+#include "Scene/CookedScene.h"
+#include "Scene/GltfLoader.h"
 #include "Scene/Material.h"
 #include "Scene/Mesh.h"
 #include "Scene/MeshBatch.h"
+#include "Scene/MeshInstancing.h"
+#include "Scene/MeshOptimizer.h"
+#include "Scene/MeshProcessing.h"
+#include "Scene/ObjLoader.h"
 #include "Scene/Scene.h"
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
+#include <numeric>
 
 namespace
 {
+	// Bump when a change to the loaders changes the cooked scenes, so that the scenes are cooked again.
+	static const u32 kSceneLoaderVersion = 3;
+
+	// Materials without a texture map, such as the default material of the OBJ faces without usemtl, get the neutral textures of Sponza.
+#ifdef ENABLE_EXTERNAL_TOOL_DEBUGGING
+	const wchar_t* kDefaultTextureDirectoryPath = L"..\\..\\..\\Resources\\CrytekSponza\\Textures";
+#else
+	const wchar_t* kDefaultTextureDirectoryPath = L"..\\..\\Resources\\CrytekSponza\\Textures";
+#endif
+	const wchar_t* kDefaultTextureFileNames[Material::NumTextures] = {L"Default_Albedo.dds", L"Default_Metallic.dds", L"Default_Roughness.dds"};
+
 	const Vector3f ToVector3f(const aiVector3D& assimpVec);
 	const Vector3f ToVector3f(const aiColor3D& assimpColor);
 	const Vector2f ToVector2f(const aiVector3D& assimpVec);
 
-	void AddAssimpMeshes(Scene* pScene, const aiScene* pAssimpScene, const Matrix4f& worldMatrix, bool use32BitIndices);
+	// World matrix, camera and lights the scene is set up with in code. They end up in the cooked scene,
+	// so their hash is part of the cooked file name. Objects which are not moved to the scene are deleted with the setup.
+	struct SceneSetup
+	{
+		SceneSetup() = default;
+		SceneSetup(const SceneSetup&) = delete;
+		SceneSetup& operator= (const SceneSetup&) = delete;
+		~SceneSetup();
+
+		u64 CalcHash() const;
+		void MoveToScene(Scene* pScene);
+
+		Matrix4f m_WorldMatrix = Matrix4f::IDENTITY;
+		Camera* m_pCamera = nullptr;
+		std::vector<SpotLight*> m_SpotLights;
+	};
+
+	struct AssimpMeshInstances
+	{
+		// Assimp meshes which provide the geometry for all the instances. Merged meshes have more than one.
+		std::vector<u32> m_MeshIndices;
+		std::vector<Matrix4f> m_InstanceWorldMatrices;
+		std::vector<u8> m_InstanceFlags;
+	};
+
+	struct PreparedAssimpMesh
+	{
+		// Optimized triangles of the mesh and the source vertex of each mesh vertex, in the order of first use.
+		// Source vertex indices refer to the vertices of the Assimp meshes, numbered consecutively.
+		std::vector<u32> m_Indices;
+		std::vector<u32> m_SourceVertexIndices;
+		// 16-bit if the mesh vertices can be addressed with them, as in the glTF loader.
+		DXGI_FORMAT m_IndexFormat;
+		std::vector<const aiMesh*> m_SourceMeshes;
+		std::vector<u32> m_FirstSourceVertices;
+		u8 m_VertexFormat;
+		// Vertex attributes after native processing. Source vertex indices refer to these instead when they are present.
+		std::vector<Vector3f> m_Positions;
+		std::vector<Vector3f> m_Normals;
+		std::vector<Vector2f> m_TexCoords;
+		std::vector<Vector3f> m_Tangents;
+		VertexCacheStats m_StatsBefore;
+	};
+
+	void PrepareAssimpMesh(const aiScene* pAssimpScene, const AssimpMeshInstances& mesh, const MeshProcessingParams& meshProcessingParams,
+		PreparedAssimpMesh* pPreparedMesh);
+
+	// Meshes without texture coordinates get a vertex format without them and without tangents,
+	// and end up in a separate mesh batch.
+	u8 SelectAssimpMeshVertexFormat(const aiMesh* pAssimpMesh, const MeshProcessingParams& meshProcessingParams);
+
+	// Welds the vertices of the Assimp meshes, numbered consecutively, and generates missing normals and requested tangents.
+	// Positions and indices are updated in place. Returns the number of welded vertices.
+	u32 ProcessAssimpMeshVertices(const std::vector<const aiMesh*>& sourceMeshes, const MeshProcessingParams& meshProcessingParams,
+		std::vector<Vector3f>* pPositions, std::vector<u32>* pIndices, std::vector<Vector3f>* pNormals, std::vector<Vector2f>* pTexCoords, std::vector<Vector3f>* pTangents);
+	// Welds the vertices with equal attributes and rewrites the indices. Tangents are optional.
+	u32 WeldMeshVertices(std::vector<Vector3f>* pPositions, std::vector<Vector3f>* pNormals, std::vector<Vector2f>* pTexCoords,
+		std::vector<Vector3f>* pTangents, std::vector<u32>* pIndices);
+	// Gives each index its own copy of the vertex attributes, so that attributes generated per triangle corner can be welded.
+	template <typename T>
+	void ExpandToTriangleCorners(const std::vector<u32>& indices, std::vector<T>* pVertexAttributes);
+
+	// Finds the meshes which are copies of the same geometry and groups them as instances of the first copy.
+	// Each instance keeps the flags of the mesh it was found in.
+	void FindAssimpMeshInstances(const aiScene* pAssimpScene, const Matrix4f& worldMatrix, const std::vector<u8>& meshInstanceFlags,
+		std::vector<AssimpMeshInstances>* pUniqueMeshes);
+	u64 HashAssimpMeshGeometry(const aiMesh* pAssimpMesh);
+	bool IsAssimpMeshInstance(const aiMesh* pCanonicalMesh, const aiMesh* pAssimpMesh, Matrix4f* pInstanceMatrix);
+
+	void MergeStaticAssimpMeshes(const aiScene* pAssimpScene, const MeshMergingParams& meshMergingParams, std::vector<AssimpMeshInstances>* pMeshes);
+	const AxisAlignedBox CalcAssimpMeshWorldBounds(const aiMesh* pAssimpMesh, const Matrix4f& worldMatrix);
+
+	void AddAssimpMeshes(Scene* pScene, const aiScene* pAssimpScene, const Matrix4f& worldMatrix,
+		const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams, const DynamicObjectParams& dynamicObjectParams);
 	void AddAssimpMaterials(Scene* pScene, const aiScene* pAssimpScene, const std::filesystem::path& materialDirectoryPath);
 
-	Scene* LoadSceneFromFile(const wchar_t* pFilePath, const Matrix4f& worldMatrix, bool use32BitIndices = false);
+	VertexCacheStats AnalyzeMeshBatchVertexCache(const MeshBatch* pMeshBatch);
+	void OutputVertexCacheStats(const VertexCacheStats& statsBefore, const VertexCacheStats& statsAfter);
+	void OutputIndexFormatStats(const std::vector<MeshBatch*>& meshBatches);
+	void OutputInstancingStats(u32 numSourceMeshes, const std::vector<AssimpMeshInstances>& uniqueMeshes);
+
+	Scene* LoadSceneFromFile(const wchar_t* pFilePath, const Matrix4f& worldMatrix,
+		const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams, const DynamicObjectParams& dynamicObjectParams);
+
+	// Cooked scene is stored next to the source file and is used until the source file is modified.
+	// Scenes imported with mesh merging, native mesh processing, dynamic objects or a different scene setup
+	// or loader version are cooked into a separate file.
+	const std::wstring GetCookedSceneFilePath(const wchar_t* pFilePath, const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+		const DynamicObjectParams& dynamicObjectParams, const SceneSetup& sceneSetup);
+	Scene* LoadCookedSceneIfUpToDate(const wchar_t* pFilePath, const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+		const DynamicObjectParams& dynamicObjectParams, const SceneSetup& sceneSetup);
+	void CookScene(const wchar_t* pFilePath, const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+		const DynamicObjectParams& dynamicObjectParams, const SceneSetup& sceneSetup, Scene* pScene);
+}
+
+bool DynamicObjectParams::IsDynamicName(const std::string& name) const
+{
+	return std::any_of(m_NamePrefixes.cbegin(), m_NamePrefixes.cend(), [&name](const std::string& prefix)
+	{
+		return (name.compare(0, prefix.size(), prefix) == 0);
+	});
 }
 
-Scene* SceneLoader::LoadCrytekSponza()
+Scene* SceneLoader::LoadCrytekSponza(const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+	const DynamicObjectParams& dynamicObjectParams)
 {
 #ifdef ENABLE_EXTERNAL_TOOL_DEBUGGING
 	const wchar_t* pFilePath = L"..\\..\\..\\Resources\\CrytekSponza\\sponza.obj";
@@ -36,17 +153,14 @@ Scene* SceneLoader::LoadCrytekSponza()
 	Matrix4f matrix2 = CreateScalingMatrix(0.01f);
 	Matrix4f matrix3 = CreateRotationYMatrix(PI_DIV_2);
 	Matrix4f matrix4 = CreateTranslationMatrix(0.0f, 7.8f, 18.7f);
-	Matrix4f worldMatrix = matrix1 * matrix2 * matrix3 * matrix4;
-
-	Scene* pScene = LoadSceneFromFile(pFilePath, worldMatrix);
 
-	const AxisAlignedBox& worldBounds = pScene->GetWorldBounds();
-	// {-11.4411659, 0.020621, 0.095729}
-	const Vector3f minPoint = worldBounds.m_Center - worldBounds.m_Radius;
-	// {11.4411659, 15.5793781, 37.304271}
-	const Vector3f maxPoint = worldBounds.m_Center + worldBounds.m_Radius;
+	// World bounds of the scene after the transform:
+	// min point {-11.4411659, 0.020621, 0.095729}
+	// max point {11.4411659, 15.5793781, 37.304271}
+	SceneSetup sceneSetup;
+	sceneSetup.m_WorldMatrix = matrix1 * matrix2 * matrix3 * matrix4;
 
-	Camera* pCamera = new Camera(
+	sceneSetup.m_pCamera = new Camera(
 		Vector3f(0.0f, 2.8f, 9.32f)/*worldPosition*/,
 		BasisAxes()/*worldOrientation*/,
 		PI_DIV_4/*fovYInRadians*/,
@@ -56,10 +170,9 @@ Scene* SceneLoader::LoadCrytekSponza()
 		Vector3f(0.01f)/*moveSpeed*/,
 		Vector3f(0.001f)/*rotationSpeed*/
 	);
-	pScene->SetCamera(pCamera);
 
 #if 1
-	SpotLight* pSpotLight1 = new SpotLight(
+	sceneSetup.m_SpotLights.emplace_back(new SpotLight(
 		Vector3f(0.0f, 5.5f, 16.5f)/*worldPosition*/,
 		BasisAxes(Vector3f::RIGHT, Vector3f::FORWARD, Vector3f::DOWN)/*worldOrientation*/,
 		Vector3f(20.0f, 20.0f, 20.0f)/*radiantPower*/,
@@ -68,12 +181,11 @@ Scene* SceneLoader::LoadCrytekSponza()
 		ToRadians(90.0f)/*outerConeAngleInRadians*/,
 		0.1f/*shadowNearPlane*/,
 		80.0f/*expShadowMapConstant*/
-	);
-	pScene->AddSpotLight(pSpotLight1);
+	));
 #endif
 
 #if 1
-	SpotLight* pSpotLight2 = new SpotLight(
+	sceneSetup.m_SpotLights.emplace_back(new SpotLight(
 		Vector3f(0.0f, 7.0f, 23.5f)/*worldPosition*/,
 		BasisAxes(Vector3f::RIGHT, Vector3f::FORWARD, Vector3f::DOWN)/*worldOrientation*/,
 		Vector3f(20.0f, 20.0f, 20.0f)/*radiantPower*/,
@@ -82,12 +194,11 @@ Scene* SceneLoader::LoadCrytekSponza()
 		ToRadians(70.0f)/*outerConeAngleInRadians*/,
 		0.1f/*shadowNearPlane*/,
 		80.0f/*expShadowMapConstant*/
-	);
-	pScene->AddSpotLight(pSpotLight2);
+	));
 #endif
 
 #if 1
-	SpotLight* pSpotLight3 = new SpotLight(
+	sceneSetup.m_SpotLights.emplace_back(new SpotLight(
 		Vector3f(0.0f, 5.5f, 31.5f)/*worldPosition*/,
 		BasisAxes(Vector3f::RIGHT, Vector3f::FORWARD, Vector3f::DOWN)/*worldOrientation*/,
 		Vector3f(20.0f, 20.0f, 20.0f)/*radiantPower*/,
@@ -96,12 +207,11 @@ Scene* SceneLoader::LoadCrytekSponza()
 		ToRadians(90.0f)/*outerConeAngleInRadians*/,
 		0.1f/*shadowNearPlane*/,
 		80.0f/*expShadowMapConstant*/
-	);
-	pScene->AddSpotLight(pSpotLight3);
+	));
 #endif
 
 #if 1
-	SpotLight* pSpotLight4 = new SpotLight(
+	sceneSetup.m_SpotLights.emplace_back(new SpotLight(
 		Vector3f(0.0f, 7.5f, 23.9312f)/*worldPosition*/,
 		BasisAxes()/*worldOrientation*/,
 		Vector3f(20.0f, 20.0f, 20.0f)/*radiantPower*/,
@@ -110,12 +220,11 @@ Scene* SceneLoader::LoadCrytekSponza()
 		ToRadians(75.0f)/*outerConeAngleInRadians*/,
 		0.1f/*shadowNearPlane*/,
 		80.0f/*expShadowMapConstant*/
-	);
-	pScene->AddSpotLight(pSpotLight4);
+	));
 #endif
 
 #if 1
-	SpotLight* pSpotLight5 = new SpotLight(
+	sceneSetup.m_SpotLights.emplace_back(new SpotLight(
 		Vector3f(0.0f, 7.5f, 23.9312f)/*worldPosition*/,
 		BasisAxes(Vector3f::BACK, Vector3f::UP, Vector3f::RIGHT)/*worldOrientation*/,
 		Vector3f(20.0f, 20.0f, 20.0f)/*radiantPower*/,
@@ -124,12 +233,11 @@ Scene* SceneLoader::LoadCrytekSponza()
 		ToRadians(90.0f)/*outerConeAngleInRadians*/,
 		0.1f/*shadowNearPlane*/,
 		80.0f/*expShadowMapConstant*/
-	);
-	pScene->AddSpotLight(pSpotLight5);
+	));
 #endif
 
 #if 1
-	SpotLight* pSpotLight6 = new SpotLight(
+	sceneSetup.m_SpotLights.emplace_back(new SpotLight(
 		Vector3f(0.0f, 7.5f, 23.9312f)/*worldPosition*/,
 		BasisAxes(Vector3f::FORWARD, Vector3f::UP, Vector3f::LEFT)/*worldOrientation*/,
 		Vector3f(20.0f, 20.0f, 20.0f)/*radiantPower*/,
@@ -138,28 +246,62 @@ Scene* SceneLoader::LoadCrytekSponza()
 		ToRadians(90.0f)/*outerConeAngleInRadians*/,
 		0.1f/*shadowNearPlane*/,
 		80.0f/*expShadowMapConstant*/
-	);
-	pScene->AddSpotLight(pSpotLight6);
+	));
 #endif
 
+	Scene* pScene = LoadCookedSceneIfUpToDate(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup);
+	if (pScene != nullptr)
+		return pScene;
+
+	pScene = LoadSceneFromFile(pFilePath, sceneSetup.m_WorldMatrix, meshMergingParams, meshProcessingParams, dynamicObjectParams);
+	if (pScene == nullptr)
+		return nullptr;
+
+	sceneSetup.MoveToScene(pScene);
+
+	CookScene(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup, pScene);
 	return pScene;
 }
 
-Scene* SceneLoader::LoadLivingRoom()
+Scene* SceneLoader::LoadLivingRoom(const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+	const DynamicObjectParams& dynamicObjectParams)
 {
 #ifdef ENABLE_EXTERNAL_TOOL_DEBUGGING
 	const wchar_t* pFilePath = L"..\\..\\..\\Resources\\Living Room\\living_room.obj";
 #else
 	const wchar_t* pFilePath = L"..\\..\\Resources\\Living Room\\living_room.obj";
 #endif
+	SceneSetup sceneSetup;
+
+	Scene* pScene = LoadCookedSceneIfUpToDate(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup);
+	if (pScene != nullptr)
+		return pScene;
 
-	Matrix4f worldMatrix = Matrix4f::IDENTITY;
-	Scene* pScene = LoadSceneFromFile(pFilePath, worldMatrix, true);
+	pScene = LoadSceneFromFile(pFilePath, sceneSetup.m_WorldMatrix, meshMergingParams, meshProcessingParams, dynamicObjectParams);
+	if (pScene == nullptr)
+		return nullptr;
 
-	const AxisAlignedBox& worldBounds = pScene->GetWorldBounds();
-	const Vector3f minPoint = worldBounds.m_Center - worldBounds.m_Radius;
-	const Vector3f maxPoint = worldBounds.m_Center + worldBounds.m_Radius;
+	sceneSetup.MoveToScene(pScene);
 
+	CookScene(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup, pScene);
+	return pScene;
+}
+
+Scene* SceneLoader::LoadGltfScene(const wchar_t* pFilePath, const MeshProcessingParams& meshProcessingParams, const DynamicObjectParams& dynamicObjectParams)
+{
+	const MeshMergingParams meshMergingParams;
+
+	const SceneSetup sceneSetup;
+
+	Scene* pScene = LoadCookedSceneIfUpToDate(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup);
+	if (pScene != nullptr)
+		return pScene;
+
+	pScene = LoadGltfFile(pFilePath, sceneSetup.m_WorldMatrix, meshProcessingParams, dynamicObjectParams);
+	if (pScene == nullptr)
+		return nullptr;
+
+	CookScene(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup, pScene);
 	return pScene;
 }
 
@@ -180,100 +322,732 @@ namespace
 		return Vector2f(assimpVec.x, assimpVec.y);
 	}
 
-	void AddAssimpMeshes(Scene* pScene, const aiScene* pAssimpScene, const Matrix4f& worldMatrix, bool use32BitIndices)
+	void PrepareAssimpMesh(const aiScene* pAssimpScene, const AssimpMeshInstances& mesh, const MeshProcessingParams& meshProcessingParams,
+		PreparedAssimpMesh* pPreparedMesh)
 	{
-		assert(pAssimpScene->HasMeshes());
+		// Merged meshes are optimized as one mesh, with the vertices of the Assimp meshes numbered consecutively.
+		u32 numSourceVertices = 0;
+		u32 numIndices = 0;
 
-		const u8 vertexFormat = VertexData::FormatFlag_Position | VertexData::FormatFlag_Normal | VertexData::FormatFlag_TexCoords;
-		const DXGI_FORMAT indexFormat = use32BitIndices ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
-		const D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-		const D3D12_PRIMITIVE_TOPOLOGY primitiveTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-
-		MeshBatch* pMeshBatch = new MeshBatch(vertexFormat, indexFormat, primitiveTopologyType, primitiveTopology);
-
-		for (decltype(pAssimpScene->mNumMeshes) meshIndex = 0; meshIndex < pAssimpScene->mNumMeshes; ++meshIndex)
+		for (u32 meshIndex : mesh.m_MeshIndices)
 		{
 			const aiMesh* pAssimpMesh = pAssimpScene->mMeshes[meshIndex];
 
 			assert(pAssimpMesh->HasPositions());
-			assert(pAssimpMesh->HasNormals());
-			assert(pAssimpMesh->HasTextureCoords(0));
+			assert(pAssimpMesh->HasNormals() || meshProcessingParams.m_UseNativeProcessing);
 			assert(pAssimpMesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE);
 
-			Vector3f* pPositions = new Vector3f[pAssimpMesh->mNumVertices];
-			Vector3f* pNormals = new Vector3f[pAssimpMesh->mNumVertices];
-			Vector2f* pTexCoords = new Vector2f[pAssimpMesh->mNumVertices];
+			// Merged meshes are only grouped together if they have the same vertex attributes.
+			const u8 vertexFormat = SelectAssimpMeshVertexFormat(pAssimpMesh, meshProcessingParams);
+			assert(pPreparedMesh->m_SourceMeshes.empty() || (pPreparedMesh->m_VertexFormat == vertexFormat));
+			pPreparedMesh->m_VertexFormat = vertexFormat;
+
+			pPreparedMesh->m_SourceMeshes.emplace_back(pAssimpMesh);
+			pPreparedMesh->m_FirstSourceVertices.emplace_back(numSourceVertices);
+
+			numSourceVertices += pAssimpMesh->mNumVertices;
+			numIndices += 3 * pAssimpMesh->mNumFaces;
+		}
+
+		std::vector<u32> indices;
+		indices.reserve(numIndices);
+
+		// Positions are needed by the overdraw optimizer. The other attributes are read from the Assimp mesh only once,
+		// when they are written into the mesh batch.
+		std::vector<Vector3f> positions;
+		positions.reserve(numSourceVertices);
+
+		for (u32 sourceMeshIndex = 0; sourceMeshIndex < pPreparedMesh->m_SourceMeshes.size(); ++sourceMeshIndex)
+		{
+			const aiMesh* pAssimpMesh = pPreparedMesh->m_SourceMeshes[sourceMeshIndex];
+			const u32 firstSourceVertex = pPreparedMesh->m_FirstSourceVertices[sourceMeshIndex];
+
+			for (decltype(pAssimpMesh->mNumFaces) faceIndex = 0; faceIndex < pAssimpMesh->mNumFaces; ++faceIndex)
+			{
+				const aiFace& face = pAssimpMesh->mFaces[faceIndex];
+				assert(face.mNumIndices == 3);
+
+				indices.emplace_back(firstSourceVertex + face.mIndices[0]);
+				indices.emplace_back(firstSourceVertex + face.mIndices[1]);
+				indices.emplace_back(firstSourceVertex + face.mIndices[2]);
+			}
 
 			for (decltype(pAssimpMesh->mNumVertices) vertexIndex = 0; vertexIndex < pAssimpMesh->mNumVertices; ++vertexIndex)
-				pPositions[vertexIndex] = ToVector3f(pAssimpMesh->mVertices[vertexIndex]);
-			
-			for (decltype(pAssimpMesh->mNumVertices) vertexIndex = 0; vertexIndex < pAssimpMesh->mNumVertices; ++vertexIndex)
-				pNormals[vertexIndex] = ToVector3f(pAssimpMesh->mNormals[vertexIndex]);
-			
-			for (decltype(pAssimpMesh->mNumVertices) vertexIndex = 0; vertexIndex < pAssimpMesh->mNumVertices; ++vertexIndex)
-				pTexCoords[vertexIndex] = ToVector2f(pAssimpMesh->mTextureCoords[0][vertexIndex]);
-			
-			const u32 numIndices = 3 * pAssimpMesh->mNumFaces;
+				positions.emplace_back(ToVector3f(pAssimpMesh->mVertices[vertexIndex]));
+		}
+
+		if (meshProcessingParams.m_UseNativeProcessing)
+		{
+			numSourceVertices = ProcessAssimpMeshVertices(pPreparedMesh->m_SourceMeshes, meshProcessingParams, &positions, &indices,
+				&pPreparedMesh->m_Normals, &pPreparedMesh->m_TexCoords, &pPreparedMesh->m_Tangents);
+		}
+
+		pPreparedMesh->m_StatsBefore = AnalyzeVertexCache(numSourceVertices, numIndices, indices.data());
+
+		// Assimp keeps the triangles in file order. Reorder them for the post-transform vertex cache and overdraw,
+		// and then reorder the vertices in the order of first use.
+		OptimizeVertexCache(numSourceVertices, numIndices, indices.data());
+		OptimizeOverdraw(positions.data(), numSourceVertices, numIndices, indices.data());
+
+		std::vector<u32> vertexRemap;
+		const u32 numVertices = OptimizeVertexFetch(numSourceVertices, numIndices, indices.data(), &vertexRemap);
+
+		// Instead of moving the attributes to the new locations, each new vertex looks up its source vertex.
+		std::vector<u32> sourceVertexIndices(numVertices);
+		for (u32 vertexIndex = 0; vertexIndex < numSourceVertices; ++vertexIndex)
+		{
+			if (vertexRemap[vertexIndex] != kUnusedVertex)
+				sourceVertexIndices[vertexRemap[vertexIndex]] = vertexIndex;
+		}
+
+		pPreparedMesh->m_Indices.swap(indices);
+		pPreparedMesh->m_SourceVertexIndices.swap(sourceVertexIndices);
+		pPreparedMesh->m_IndexFormat = (numVertices <= kMaxNumVerticesWith16BitIndices) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+		if (meshProcessingParams.m_UseNativeProcessing)
+			pPreparedMesh->m_Positions.swap(positions);
+	}
+
+	u32 ProcessAssimpMeshVertices(const std::vector<const aiMesh*>& sourceMeshes, const MeshProcessingParams& meshProcessingParams,
+		std::vector<Vector3f>* pPositions, std::vector<u32>* pIndices, std::vector<Vector3f>* pNormals, std::vector<Vector2f>* pTexCoords, std::vector<Vector3f>* pTangents)
+	{
+		const u32 numSourceVertices = pPositions->size();
+		const u32 numIndices = pIndices->size();
+
+		const bool hasTexCoords = std::all_of(sourceMeshes.cbegin(), sourceMeshes.cend(), [](const aiMesh* pAssimpMesh)
+		{
+			return pAssimpMesh->HasTextureCoords(0);
+		});
+
+		// Welding compares texture coordinates as well. Meshes without them are welded with zero texture coordinates,
+		// which are dropped afterwards.
+		if (hasTexCoords)
+		{
+			pTexCoords->reserve(numSourceVertices);
+			for (const aiMesh* pAssimpMesh : sourceMeshes)
+			{
+				for (decltype(pAssimpMesh->mNumVertices) vertexIndex = 0; vertexIndex < pAssimpMesh->mNumVertices; ++vertexIndex)
+					pTexCoords->emplace_back(ToVector2f(pAssimpMesh->mTextureCoords[0][vertexIndex]));
+			}
+		}
+		else
+		{
+			pTexCoords->resize(numSourceVertices, Vector2f::ZERO);
+		}
+
+		const bool hasNormals = std::all_of(sourceMeshes.cbegin(), sourceMeshes.cend(), [](const aiMesh* pAssimpMesh)
+		{
+			return pAssimpMesh->HasNormals();
+		});
+		
+		if (hasNormals)
+		{
+			pNormals->reserve(numSourceVertices);
+			for (const aiMesh* pAssimpMesh : sourceMeshes)
+			{
+				for (decltype(pAssimpMesh->mNumVertices) vertexIndex = 0; vertexIndex < pAssimpMesh->mNumVertices; ++vertexIndex)
+					pNormals->emplace_back(ToVector3f(pAssimpMesh->mNormals[vertexIndex]));
+			}
+		}
+		else
+		{
+			// Normals are generated per triangle corner and the corners are then welded,
+			// so that vertices are split at creases and vertices which differ only in the missing normal are joined.
+			pNormals->resize(numIndices);
+			GenerateNormals(numSourceVertices, pPositions->data(), numIndices, pIndices->data(),
+				ToRadians(meshProcessingParams.m_MaxSmoothingAngleInDegrees), pNormals->data());
+
+			ExpandToTriangleCorners(*pIndices, pPositions);
+			ExpandToTriangleCorners(*pIndices, pTexCoords);
+			std::iota(pIndices->begin(), pIndices->end(), 0);
+		}
+
+		u32 numVertices = WeldMeshVertices(pPositions, pNormals, pTexCoords, nullptr, pIndices);
+
+		if (meshProcessingParams.m_GenerateTangents && hasTexCoords)
+		{
+			// Tangents are generated per triangle corner as well, so that welding splits the vertices where mirrored texture mapping meets.
+			pTangents->resize(numIndices);
+			GenerateTangents(numVertices, pPositions->data(), pNormals->data(), pTexCoords->data(), numIndices, pIndices->data(), pTangents->data());
 
-			u16* p16BitIndices = nullptr;
-			u32* p32BitIndices = nullptr;
+			ExpandToTriangleCorners(*pIndices, pPositions);
+			ExpandToTriangleCorners(*pIndices, pNormals);
+			ExpandToTriangleCorners(*pIndices, pTexCoords);
+			std::iota(pIndices->begin(), pIndices->end(), 0);
+
+			numVertices = WeldMeshVertices(pPositions, pNormals, pTexCoords, pTangents, pIndices);
+		}
+		if (!hasTexCoords)
+			std::vector<Vector2f>().swap(*pTexCoords);
+
+		return numVertices;
+	}
+
+	u32 WeldMeshVertices(std::vector<Vector3f>* pPositions, std::vector<Vector3f>* pNormals, std::vector<Vector2f>* pTexCoords,
+		std::vector<Vector3f>* pTangents, std::vector<u32>* pIndices)
+	{
+		const u32 numSourceVertices = pPositions->size();
+		Vector3f* pTangentData = (pTangents != nullptr) ? pTangents->data() : nullptr;
 
-			if (use32BitIndices)
+		std::vector<u32> vertexRemap;
+		const u32 numVertices = WeldVertices(numSourceVertices, pPositions->data(), pNormals->data(), pTexCoords->data(), pTangentData, &vertexRemap);
+
+		RemapVertices(numSourceVertices, pPositions->data(), numVertices, vertexRemap.data());
+		RemapVertices(numSourceVertices, pNormals->data(), numVertices, vertexRemap.data());
+		RemapVertices(numSourceVertices, pTexCoords->data(), numVertices, vertexRemap.data());
+
+		pPositions->resize(numVertices);
+		pNormals->resize(numVertices);
+		pTexCoords->resize(numVertices);
+
+		if (pTangents != nullptr)
+		{
+			RemapVertices(numSourceVertices, pTangentData, numVertices, vertexRemap.data());
+			pTangents->resize(numVertices);
+		}
+
+		for (u32& index : *pIndices)
+			index = vertexRemap[index];
+
+		return numVertices;
+	}
+
+	template <typename T>
+	void ExpandToTriangleCorners(const std::vector<u32>& indices, std::vector<T>* pVertexAttributes)
+	{
+		std::vector<T> cornerAttributes(indices.size());
+		for (std::size_t index = 0; index < indices.size(); ++index)
+			cornerAttributes[index] = (*pVertexAttributes)[indices[index]];
+
+		pVertexAttributes->swap(cornerAttributes);
+	}
+
+	void FindAssimpMeshInstances(const aiScene* pAssimpScene, const Matrix4f& worldMatrix, const std::vector<u8>& meshInstanceFlags,
+		std::vector<AssimpMeshInstances>* pUniqueMeshes)
+	{
+		// Hash is computed from the data which does not change with the transform.
+		// Meshes with the same hash are compared in full and the transform between them is recovered from the positions.
+		std::vector<u64> geometryHashes(pAssimpScene->mNumMeshes);
+		ParallelFor(pAssimpScene->mNumMeshes, [&](u32 meshIndex)
+		{
+			geometryHashes[meshIndex] = HashAssimpMeshGeometry(pAssimpScene->mMeshes[meshIndex]);
+		});
+
+		std::unordered_map<u64, std::vector<u32>> uniqueMeshIndicesPerHash;
+		for (decltype(pAssimpScene->mNumMeshes) meshIndex = 0; meshIndex < pAssimpScene->mNumMeshes; ++meshIndex)
+		{
+			std::vector<u32>& uniqueMeshIndices = uniqueMeshIndicesPerHash[geometryHashes[meshIndex]];
+
+			bool foundInstance = false;
+			for (u32 uniqueMeshIndex : uniqueMeshIndices)
 			{
-				p32BitIndices = new u32[numIndices];
-				for (decltype(pAssimpMesh->mNumFaces) faceIndex = 0; faceIndex < pAssimpMesh->mNumFaces; ++faceIndex)
+				AssimpMeshInstances& uniqueMesh = (*pUniqueMeshes)[uniqueMeshIndex];
+				if (uniqueMesh.m_InstanceWorldMatrices.size() == kMaxNumInstancesPerMesh)
+					continue;
+
+				Matrix4f instanceMatrix;
+				if (IsAssimpMeshInstance(pAssimpScene->mMeshes[uniqueMesh.m_MeshIndices[0]], pAssimpScene->mMeshes[meshIndex], &instanceMatrix))
 				{
-					const aiFace& face = pAssimpMesh->mFaces[faceIndex];
-					assert(face.mNumIndices == 3);
+					uniqueMesh.m_InstanceWorldMatrices.emplace_back(instanceMatrix * worldMatrix);
+					uniqueMesh.m_InstanceFlags.emplace_back(meshInstanceFlags[meshIndex]);
+					foundInstance = true;
+					break;
+				}
+			}
+
+			if (!foundInstance)
+			{
+				uniqueMeshIndices.emplace_back(pUniqueMeshes->size());
+				
+				AssimpMeshInstances uniqueMesh;
+				uniqueMesh.m_MeshIndices.emplace_back(meshIndex);
+				uniqueMesh.m_InstanceWorldMatrices.emplace_back(worldMatrix);
+				uniqueMesh.m_InstanceFlags.emplace_back(meshInstanceFlags[meshIndex]);
+				
+				pUniqueMeshes->emplace_back(std::move(uniqueMesh));
+			}
+		}
+	}
+
+	u64 HashAssimpMeshGeometry(const aiMesh* pAssimpMesh)
+	{
+		u64 hash = HashBytes(&pAssimpMesh->mMaterialIndex, sizeof(pAssimpMesh->mMaterialIndex));
+		hash = HashBytes(&pAssimpMesh->mNumVertices, sizeof(pAssimpMesh->mNumVertices), hash);
+		hash = HashBytes(&pAssimpMesh->mNumFaces, sizeof(pAssimpMesh->mNumFaces), hash);
+		
+		for (decltype(pAssimpMesh->mNumFaces) faceIndex = 0; faceIndex < pAssimpMesh->mNumFaces; ++faceIndex)
+		{
+			const aiFace& face = pAssimpMesh->mFaces[faceIndex];
+			hash = HashBytes(face.mIndices, face.mNumIndices * sizeof(face.mIndices[0]), hash);
+		}
+
+		if (pAssimpMesh->HasTextureCoords(0))
+			hash = HashBytes(pAssimpMesh->mTextureCoords[0], pAssimpMesh->mNumVertices * sizeof(pAssimpMesh->mTextureCoords[0][0]), hash);
+
+		return hash;
+	}
 
-					p32BitIndices[3 * faceIndex + 0] = face.mIndices[0];
-					p32BitIndices[3 * faceIndex + 1] = face.mIndices[1];
-					p32BitIndices[3 * faceIndex + 2] = face.mIndices[2];
+	bool IsAssimpMeshInstance(const aiMesh* pCanonicalMesh, const aiMesh* pAssimpMesh, Matrix4f* pInstanceMatrix)
+	{
+		if ((pCanonicalMesh->mMaterialIndex != pAssimpMesh->mMaterialIndex) ||
+			(pCanonicalMesh->mNumVertices != pAssimpMesh->mNumVertices) ||
+			(pCanonicalMesh->mNumFaces != pAssimpMesh->mNumFaces) ||
+			(pCanonicalMesh->HasTextureCoords(0) != pAssimpMesh->HasTextureCoords(0)) ||
+			(pCanonicalMesh->HasNormals() != pAssimpMesh->HasNormals()))
+			return false;
+
+		for (decltype(pAssimpMesh->mNumFaces) faceIndex = 0; faceIndex < pAssimpMesh->mNumFaces; ++faceIndex)
+		{
+			const aiFace& canonicalFace = pCanonicalMesh->mFaces[faceIndex];
+			const aiFace& face = pAssimpMesh->mFaces[faceIndex];
+
+			if ((canonicalFace.mNumIndices != face.mNumIndices) ||
+				!std::equal(face.mIndices, face.mIndices + face.mNumIndices, canonicalFace.mIndices))
+				return false;
+		}
+
+		if (pAssimpMesh->HasTextureCoords(0) &&
+			!std::equal(pAssimpMesh->mTextureCoords[0], pAssimpMesh->mTextureCoords[0] + pAssimpMesh->mNumVertices, pCanonicalMesh->mTextureCoords[0]))
+			return false;
+
+		static_assert(sizeof(aiVector3D) == sizeof(Vector3f), "Assimp vectors are read as Vector3f");
+		const Vector3f* pCanonicalPositions = (const Vector3f*)pCanonicalMesh->mVertices;
+		const Vector3f* pPositions = (const Vector3f*)pAssimpMesh->mVertices;
+
+		// Tolerance is relative to the size of the mesh, as the copies have been transformed in floating point by the exporter.
+		const AxisAlignedBox canonicalBounds(pCanonicalMesh->mNumVertices, pCanonicalPositions);
+		const f32 maxPositionError = 1e-4f * Max(Length(canonicalBounds.m_Radius), EPSILON);
+
+		if (!FindInstanceTransform(pAssimpMesh->mNumVertices, pCanonicalPositions, pPositions, maxPositionError, pInstanceMatrix))
+			return false;
+
+		if (pAssimpMesh->HasNormals())
+		{
+			const f32 maxNormalErrorInDegrees = 1.0f;
+			const Vector3f* pCanonicalNormals = (const Vector3f*)pCanonicalMesh->mNormals;
+			const Vector3f* pNormals = (const Vector3f*)pAssimpMesh->mNormals;
+			
+			if (!AreInstanceNormals(pAssimpMesh->mNumVertices, pCanonicalNormals, pNormals, *pInstanceMatrix, maxNormalErrorInDegrees))
+				return false;
+		}
+		return true;
+	}
+
+	void MergeStaticAssimpMeshes(const aiScene* pAssimpScene, const MeshMergingParams& meshMergingParams, std::vector<AssimpMeshInstances>* pMeshes)
+	{
+		std::vector<AssimpMeshInstances>& meshes = *pMeshes;
+
+		// Only the static meshes with a single instance are merged. They all use the scene world matrix.
+		auto isMergeCandidate = [](const AssimpMeshInstances& mesh)
+		{
+			return (mesh.m_InstanceWorldMatrices.size() == 1) && ((mesh.m_InstanceFlags[0] & MeshBatch::MeshInstanceFlag_Dynamic) == 0);
+		};
+
+		std::vector<AxisAlignedBox> worldBounds(meshes.size());
+		ParallelFor(meshes.size(), [&](u32 meshIndex)
+		{
+			const AssimpMeshInstances& mesh = meshes[meshIndex];
+			if (isMergeCandidate(mesh))
+				worldBounds[meshIndex] = CalcAssimpMeshWorldBounds(pAssimpScene->mMeshes[mesh.m_MeshIndices[0]], mesh.m_InstanceWorldMatrices[0]);
+		});
+
+		std::vector<u32> candidates;
+		Vector3f minCenter(std::numeric_limits<f32>::max());
+		Vector3f maxCenter(std::numeric_limits<f32>::lowest());
+
+		for (u32 meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+		{
+			if (isMergeCandidate(meshes[meshIndex]))
+			{
+				candidates.emplace_back(meshIndex);
+				minCenter = Min(minCenter, worldBounds[meshIndex].m_Center);
+				maxCenter = Max(maxCenter, worldBounds[meshIndex].m_Center);
+			}
+		}
+
+		// Candidates are sorted by material and then along the Morton curve through the mesh centers,
+		// so that the meshes next to each other in the order are likely to be close in space.
+		const Vector3f centerScale = 1023.0f * Rcp(Max(maxCenter - minCenter, Vector3f(EPSILON)));
+
+		std::vector<u32> mortonCodes(meshes.size(), 0);
+		for (u32 meshIndex : candidates)
+		{
+			const Vector3f gridPosition = (worldBounds[meshIndex].m_Center - minCenter) * centerScale;
+			mortonCodes[meshIndex] = EncodeMortonCode(u32(gridPosition.m_X), u32(gridPosition.m_Y), u32(gridPosition.m_Z));
+		}
+
+		auto getMaterialID = [&](u32 meshIndex)
+		{
+			return pAssimpScene->mMeshes[meshes[meshIndex].m_MeshIndices[0]]->mMaterialIndex;
+		};
+		// Meshes with and without texture coordinates go to different mesh batches, so they are not merged.
+		auto hasTexCoords = [&](u32 meshIndex)
+		{
+			return pAssimpScene->mMeshes[meshes[meshIndex].m_MeshIndices[0]]->HasTextureCoords(0);
+		};
+		std::sort(candidates.begin(), candidates.end(), [&](u32 meshIndex1, u32 meshIndex2)
+		{
+			if (getMaterialID(meshIndex1) != getMaterialID(meshIndex2))
+				return (getMaterialID(meshIndex1) < getMaterialID(meshIndex2));
+			if (hasTexCoords(meshIndex1) != hasTexCoords(meshIndex2))
+				return hasTexCoords(meshIndex2);
+			if (mortonCodes[meshIndex1] != mortonCodes[meshIndex2])
+				return (mortonCodes[meshIndex1] < mortonCodes[meshIndex2]);
+			return (meshIndex1 < meshIndex2);
+		});
+
+		// Consecutive candidates are merged while the merged bounds fit the size limit
+		// and the merged mesh can still be addressed with 16-bit indices.
+		std::vector<std::vector<u32>> clusters;
+		std::vector<AxisAlignedBox> clusterBounds;
+		u32 clusterNumVertices = 0;
+
+		for (u32 meshIndex : candidates)
+		{
+			const u32 numVertices = pAssimpScene->mMeshes[meshes[meshIndex].m_MeshIndices[0]]->mNumVertices;
+			if (!clusters.empty() && (getMaterialID(clusters.back().front()) == getMaterialID(meshIndex)) &&
+				(hasTexCoords(clusters.back().front()) == hasTexCoords(meshIndex)) &&
+				(clusterNumVertices + numVertices <= kMaxNumVerticesWith16BitIndices))
+			{
+				const AxisAlignedBox mergedBounds(clusterBounds.back(), worldBounds[meshIndex]);
+				const Vector3f mergedSize = 2.0f * mergedBounds.m_Radius;
+				
+				if (Max(Max(mergedSize.m_X, mergedSize.m_Y), mergedSize.m_Z) <= meshMergingParams.m_MaxBoundsSize)
+				{
+					clusters.back().emplace_back(meshIndex);
+					clusterBounds.back() = mergedBounds;
+					clusterNumVertices += numVertices;
+					continue;
 				}
 			}
-			else
+			clusters.emplace_back(1, meshIndex);
+			clusterBounds.emplace_back(worldBounds[meshIndex]);
+			clusterNumVertices = numVertices;
+		}
+
+		// Merged mesh takes the place of its first mesh in the mesh order.
+		const u32 kNoCluster = ~0u;
+		std::vector<u32> clusterIndices(meshes.size(), kNoCluster);
+		
+		for (u32 clusterIndex = 0; clusterIndex < clusters.size(); ++clusterIndex)
+		{
+			std::vector<u32>& cluster = clusters[clusterIndex];
+			std::sort(cluster.begin(), cluster.end());
+			
+			for (u32 meshIndex : cluster)
+				clusterIndices[meshIndex] = clusterIndex;
+		}
+
+		f32 sourceBoundsArea = 0.0f;
+		f32 mergedBoundsArea = 0.0f;
+		u32 numMergedClusters = 0;
+		u32 numMergedSourceMeshes = 0;
+
+		auto calcSurfaceArea = [](const AxisAlignedBox& box)
+		{
+			const Vector3f& radius = box.m_Radius;
+			return 8.0f * (radius.m_X * radius.m_Y + radius.m_Y * radius.m_Z + radius.m_Z * radius.m_X);
+		};
+
+		std::vector<AssimpMeshInstances> mergedMeshes;
+		mergedMeshes.reserve(meshes.size());
+
+		for (u32 meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+		{
+			const u32 clusterIndex = clusterIndices[meshIndex];
+			if (clusterIndex == kNoCluster)
 			{
-				p16BitIndices = new u16[numIndices];
-				const u32 u16Max = std::numeric_limits<u16>::max();
+				mergedMeshes.emplace_back(std::move(meshes[meshIndex]));
+				continue;
+			}
+
+			const std::vector<u32>& cluster = clusters[clusterIndex];
+			if (cluster.front() != meshIndex)
+				continue;
+
+			AssimpMeshInstances mergedMesh;
+			mergedMesh.m_InstanceWorldMatrices = meshes[meshIndex].m_InstanceWorldMatrices;
+			mergedMesh.m_InstanceFlags = meshes[meshIndex].m_InstanceFlags;
+
+			for (u32 clusterMeshIndex : cluster)
+				mergedMesh.m_MeshIndices.emplace_back(meshes[clusterMeshIndex].m_MeshIndices[0]);
+
+			if (cluster.size() > 1)
+			{
+				++numMergedClusters;
+				numMergedSourceMeshes += cluster.size();
+				
+				for (u32 clusterMeshIndex : cluster)
+					sourceBoundsArea += calcSurfaceArea(worldBounds[clusterMeshIndex]);
+				mergedBoundsArea += calcSurfaceArea(clusterBounds[clusterIndex]);
+			}
+
+			mergedMeshes.emplace_back(std::move(mergedMesh));
+		}
+
+		// Bounds occupancy estimates culling efficiency of the merged meshes.
+		// Low occupancy means the merged bounds cover a lot of empty space and pass the culling tests more often than the source bounds would.
+		const f32 boundsOccupancy = (mergedBoundsArea > 0.0f) ? Min(1.0f, sourceBoundsArea / mergedBoundsArea) : 1.0f;
+
+		const u32 outputBufferSize = 256;
+		char outputBuffer[outputBufferSize];
+
+		std::snprintf(outputBuffer, outputBufferSize,
+			"Mesh merging (max bounds size %.2f): %u meshes -> %u meshes, %u meshes merged into %u, merged bounds occupancy %.1f%%\n",
+			meshMergingParams.m_MaxBoundsSize, u32(meshes.size()), u32(mergedMeshes.size()),
+			numMergedSourceMeshes, numMergedClusters, 100.0f * boundsOccupancy);
+
+		OutputDebugStringA(outputBuffer);
+
+		meshes.swap(mergedMeshes);
+	}
+
+	const AxisAlignedBox CalcAssimpMeshWorldBounds(const aiMesh* pAssimpMesh, const Matrix4f& worldMatrix)
+	{
+		const AxisAlignedBox localBounds(pAssimpMesh->mNumVertices, (const Vector3f*)pAssimpMesh->mVertices);
+		const Vector3f& center = localBounds.m_Center;
+		const Vector3f& radius = localBounds.m_Radius;
+
+		Vector3f worldCorners[8];
+		for (u32 cornerIndex = 0; cornerIndex < 8; ++cornerIndex)
+		{
+			const Vector3f corner(
+				center.m_X + (((cornerIndex & 1) != 0) ? radius.m_X : -radius.m_X),
+				center.m_Y + (((cornerIndex & 2) != 0) ? radius.m_Y : -radius.m_Y),
+				center.m_Z + (((cornerIndex & 4) != 0) ? radius.m_Z : -radius.m_Z));
+
+			worldCorners[cornerIndex] = TransformPoint(corner, worldMatrix);
+		}
+		return AxisAlignedBox(8, worldCorners);
+	}
+
+	void AddAssimpMeshes(Scene* pScene, const aiScene* pAssimpScene, const Matrix4f& worldMatrix,
+		const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams, const DynamicObjectParams& dynamicObjectParams)
+	{
+		assert(pAssimpScene->HasMeshes());
+
+		const D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		const D3D12_PRIMITIVE_TOPOLOGY primitiveTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+		std::vector<u8> meshInstanceFlags(pAssimpScene->mNumMeshes, MeshBatch::MeshInstanceFlag_None);
+		u32 numDynamicMeshes = 0;
+		for (decltype(pAssimpScene->mNumMeshes) meshIndex = 0; meshIndex < pAssimpScene->mNumMeshes; ++meshIndex)
+		{
+			if (dynamicObjectParams.IsDynamicName(pAssimpScene->mMeshes[meshIndex]->mName.C_Str()))
+			{
+				meshInstanceFlags[meshIndex] = MeshBatch::MeshInstanceFlag_Dynamic;
+				++numDynamicMeshes;
+			}
+		}
+
+		std::vector<AssimpMeshInstances> uniqueMeshes;
+		FindAssimpMeshInstances(pAssimpScene, worldMatrix, meshInstanceFlags, &uniqueMeshes);
+		OutputInstancingStats(pAssimpScene->mNumMeshes, uniqueMeshes);
+
+		if (numDynamicMeshes > 0)
+		{
+			const std::string message = "Dynamic objects: " + std::to_string(numDynamicMeshes) + " of " + std::to_string(pAssimpScene->mNumMeshes) + " meshes\n";
+			OutputDebugStringA(message.c_str());
+		}
+
+		if (meshMergingParams.m_Enabled)
+			MergeStaticAssimpMeshes(pAssimpScene, meshMergingParams, &uniqueMeshes);
+
+		// Meshes are converted in three passes, so the expensive work runs in parallel and the meshes keep the order of the serial conversion.
+		// 1. Optimize each unique Assimp mesh in parallel.
+		// 2. Append the meshes to the mesh batches in order. The batch streams are reserved with the exact totals,
+		// so the offsets of the meshes are a prefix sum over their sizes and the stream pointers stay valid.
+		// 3. Write vertices, indices and instance bounds of each mesh in parallel.
+		std::vector<PreparedAssimpMesh> preparedMeshes(uniqueMeshes.size());
+		ParallelFor(uniqueMeshes.size(), [&](u32 uniqueMeshIndex)
+		{
+			PrepareAssimpMesh(pAssimpScene, uniqueMeshes[uniqueMeshIndex], meshProcessingParams, &preparedMeshes[uniqueMeshIndex]);
+		});
+
+		// Vertex and index buffers of the mesh batch have a single format, so meshes are grouped
+		// by vertex format and index format into separate batches. Each batch becomes a mesh type.
+		struct BatchTotals
+		{
+			u32 m_NumMeshes = 0;
+			u32 m_NumVertices = 0;
+			u32 m_NumIndices = 0;
+			u32 m_NumInstances = 0;
+		};
+		struct BatchGroup
+		{
+			u8 m_VertexFormat;
+			DXGI_FORMAT m_IndexFormat;
+			BatchTotals m_Totals;
+			MeshBatch* m_pMeshBatch;
+		};
+		std::vector<BatchGroup> batchGroups;
 
-				for (decltype(pAssimpMesh->mNumFaces) faceIndex = 0; faceIndex < pAssimpMesh->mNumFaces; ++faceIndex)
+		auto findBatchGroup = [&](u8 vertexFormat, DXGI_FORMAT indexFormat)
+		{
+			return std::find_if(batchGroups.begin(), batchGroups.end(), [&](const BatchGroup& batchGroup)
+			{
+				return (batchGroup.m_VertexFormat == vertexFormat) && (batchGroup.m_IndexFormat == indexFormat);
+			});
+		};
+
+		VertexCacheStats statsBefore;
+		for (u32 uniqueMeshIndex = 0; uniqueMeshIndex < uniqueMeshes.size(); ++uniqueMeshIndex)
+		{
+			const PreparedAssimpMesh& preparedMesh = preparedMeshes[uniqueMeshIndex];
+			const u32 numInstances = uniqueMeshes[uniqueMeshIndex].m_InstanceWorldMatrices.size();
+
+			AccumulateVertexCacheStats(preparedMesh.m_StatsBefore, &statsBefore);
+
+			auto batchGroupIt = findBatchGroup(preparedMesh.m_VertexFormat, preparedMesh.m_IndexFormat);
+			if (batchGroupIt == batchGroups.end())
+			{
+				batchGroups.push_back({preparedMesh.m_VertexFormat, preparedMesh.m_IndexFormat, BatchTotals(), nullptr});
+				batchGroupIt = batchGroups.end() - 1;
+			}
+
+			BatchTotals& batchTotals = batchGroupIt->m_Totals;
+			++batchTotals.m_NumMeshes;
+			batchTotals.m_NumVertices += preparedMesh.m_SourceVertexIndices.size();
+			batchTotals.m_NumIndices += preparedMesh.m_Indices.size();
+			batchTotals.m_NumInstances += numInstances;
+		}
+
+		// Batches are ordered by vertex format and then with 16-bit indices first, independent of the mesh order.
+		std::sort(batchGroups.begin(), batchGroups.end(), [](const BatchGroup& batchGroup1, const BatchGroup& batchGroup2)
+		{
+			if (batchGroup1.m_VertexFormat != batchGroup2.m_VertexFormat)
+				return (batchGroup1.m_VertexFormat > batchGroup2.m_VertexFormat);
+			return (batchGroup1.m_IndexFormat == DXGI_FORMAT_R16_UINT) && (batchGroup2.m_IndexFormat != DXGI_FORMAT_R16_UINT);
+		});
+
+		for (BatchGroup& batchGroup : batchGroups)
+		{
+			const BatchTotals& batchTotals = batchGroup.m_Totals;
+
+			batchGroup.m_pMeshBatch = new MeshBatch(batchGroup.m_VertexFormat, batchGroup.m_IndexFormat, primitiveTopologyType, primitiveTopology);
+			batchGroup.m_pMeshBatch->Reserve(batchTotals.m_NumMeshes, batchTotals.m_NumVertices, batchTotals.m_NumIndices, batchTotals.m_NumInstances);
+		}
+
+		struct MeshLocation
+		{
+			const PreparedAssimpMesh* m_pPreparedMesh;
+			const std::vector<Matrix4f>* m_pInstanceWorldMatrices;
+			const std::vector<u8>* m_pInstanceFlags;
+			MeshBatch* m_pMeshBatch;
+			u32 m_MeshIndexInBatch;
+			MeshBatch::MeshStreams m_Streams;
+		};
+		std::vector<MeshLocation> meshLocations;
+		meshLocations.reserve(uniqueMeshes.size());
+
+		for (u32 uniqueMeshIndex = 0; uniqueMeshIndex < uniqueMeshes.size(); ++uniqueMeshIndex)
+		{
+			const PreparedAssimpMesh& preparedMesh = preparedMeshes[uniqueMeshIndex];
+			const u32 materialID = preparedMesh.m_SourceMeshes[0]->mMaterialIndex;
+			const std::vector<Matrix4f>& instanceWorldMatrices = uniqueMeshes[uniqueMeshIndex].m_InstanceWorldMatrices;
+
+			MeshBatch* pMeshBatch = findBatchGroup(preparedMesh.m_VertexFormat, preparedMesh.m_IndexFormat)->m_pMeshBatch;
+
+			MeshLocation location;
+			location.m_pPreparedMesh = &preparedMesh;
+			location.m_pInstanceWorldMatrices = &instanceWorldMatrices;
+			location.m_pInstanceFlags = &uniqueMeshes[uniqueMeshIndex].m_InstanceFlags;
+			location.m_pMeshBatch = pMeshBatch;
+			location.m_MeshIndexInBatch = pMeshBatch->GetNumMeshes();
+			location.m_Streams = pMeshBatch->AppendMesh(preparedMesh.m_SourceVertexIndices.size(), preparedMesh.m_Indices.size(),
+				instanceWorldMatrices.size(), materialID);
+
+			meshLocations.emplace_back(location);
+		}
+
+		ParallelFor(meshLocations.size(), [&](u32 meshIndex)
+		{
+			const MeshLocation& location = meshLocations[meshIndex];
+			const PreparedAssimpMesh& preparedMesh = *location.m_pPreparedMesh;
+			const MeshBatch::MeshStreams& streams = location.m_Streams;
+
+			if (!preparedMesh.m_Positions.empty())
+			{
+				for (u32 vertexIndex = 0; vertexIndex < preparedMesh.m_SourceVertexIndices.size(); ++vertexIndex)
 				{
-					const aiFace& face = pAssimpMesh->mFaces[faceIndex];
-					assert(face.mNumIndices == 3);
-					assert(face.mIndices[0] <= u16Max);
-					assert(face.mIndices[1] <= u16Max);
-					assert(face.mIndices[2] <= u16Max);
-
-					p16BitIndices[3 * faceIndex + 0] = u16(face.mIndices[0]);
-					p16BitIndices[3 * faceIndex + 1] = u16(face.mIndices[1]);
-					p16BitIndices[3 * faceIndex + 2] = u16(face.mIndices[2]);
+					const u32 sourceVertexIndex = preparedMesh.m_SourceVertexIndices[vertexIndex];
+
+					streams.m_pPositions[vertexIndex] = preparedMesh.m_Positions[sourceVertexIndex];
+					streams.m_pNormals[vertexIndex] = preparedMesh.m_Normals[sourceVertexIndex];
+					if (streams.m_pTexCoords != nullptr)
+						streams.m_pTexCoords[vertexIndex] = preparedMesh.m_TexCoords[sourceVertexIndex];
+					if (streams.m_pTangents != nullptr)
+						streams.m_pTangents[vertexIndex] = preparedMesh.m_Tangents[sourceVertexIndex];
 				}
 			}
+			else for (u32 vertexIndex = 0; vertexIndex < preparedMesh.m_SourceVertexIndices.size(); ++vertexIndex)
+			{
+				// Find the Assimp mesh the source vertex comes from.
+				const u32 sourceVertexIndex = preparedMesh.m_SourceVertexIndices[vertexIndex];
+				const auto firstSourceVertexIt = std::upper_bound(preparedMesh.m_FirstSourceVertices.cbegin(),
+					preparedMesh.m_FirstSourceVertices.cend(), sourceVertexIndex) - 1;
 
-			VertexData* pVertexData = new VertexData(pAssimpMesh->mNumVertices, pPositions, pNormals, pTexCoords);
+				const aiMesh* pAssimpMesh = preparedMesh.m_SourceMeshes[firstSourceVertexIt - preparedMesh.m_FirstSourceVertices.cbegin()];
+				const u32 assimpVertexIndex = sourceVertexIndex - *firstSourceVertexIt;
 
-			IndexData* pIndexData = nullptr;
-			if (use32BitIndices)
-				pIndexData = new IndexData(numIndices, p32BitIndices);
+				streams.m_pPositions[vertexIndex] = ToVector3f(pAssimpMesh->mVertices[assimpVertexIndex]);
+				streams.m_pNormals[vertexIndex] = ToVector3f(pAssimpMesh->mNormals[assimpVertexIndex]);
+				if (streams.m_pTexCoords != nullptr)
+					streams.m_pTexCoords[vertexIndex] = ToVector2f(pAssimpMesh->mTextureCoords[0][assimpVertexIndex]);
+				if (streams.m_pTangents != nullptr)
+					streams.m_pTangents[vertexIndex] = ToVector3f(pAssimpMesh->mTangents[assimpVertexIndex]);
+			}
+
+			if (streams.m_p16BitIndices != nullptr)
+				std::copy(preparedMesh.m_Indices.begin(), preparedMesh.m_Indices.end(), streams.m_p16BitIndices);
 			else
-				pIndexData = new IndexData(numIndices, p16BitIndices);
+				std::copy(preparedMesh.m_Indices.begin(), preparedMesh.m_Indices.end(), streams.m_p32BitIndices);
+
+			std::copy(location.m_pInstanceWorldMatrices->begin(), location.m_pInstanceWorldMatrices->end(), streams.m_pInstanceWorldMatrices);
+			std::copy(location.m_pInstanceFlags->begin(), location.m_pInstanceFlags->end(), streams.m_pInstanceFlags);
+			location.m_pMeshBatch->FinishMesh(location.m_MeshIndexInBatch);
+		});
+
+		VertexCacheStats statsAfter;
+		std::vector<MeshBatch*> meshBatches;
+		for (const BatchGroup& batchGroup : batchGroups)
+		{
+			MeshBatch* pMeshBatch = batchGroup.m_pMeshBatch;
+
+			pMeshBatch->SortByMortonCode(meshProcessingParams.m_SortMeshesByMortonCode);
+			pMeshBatch->BuildMeshClusters();
+			pMeshBatch->SelectVertexCompression(VertexPrecisionBudget());
 
-			const u8 numInstances = 1;
-			Matrix4f* pInstanceWorldMatrices = new Matrix4f[numInstances];
-			pInstanceWorldMatrices[0] = worldMatrix;
+			AccumulateVertexCacheStats(AnalyzeMeshBatchVertexCache(pMeshBatch), &statsAfter);
+			pScene->AddMeshBatch(pMeshBatch);
+			meshBatches.emplace_back(pMeshBatch);
+		}
+		OutputVertexCacheStats(statsBefore, statsAfter);
+		OutputIndexFormatStats(meshBatches);
+	}
 
-			Mesh mesh(pVertexData, pIndexData, numInstances, pInstanceWorldMatrices,
-				pAssimpMesh->mMaterialIndex, primitiveTopologyType, primitiveTopology);
+	u8 SelectAssimpMeshVertexFormat(const aiMesh* pAssimpMesh, const MeshProcessingParams& meshProcessingParams)
+	{
+		// Missing normals are generated either by Assimp or by the native processing.
+		u8 vertexFormat = VertexData::FormatFlag_Position | VertexData::FormatFlag_Normal;
+		if (pAssimpMesh->HasTextureCoords(0))
+		{
+			vertexFormat |= VertexData::FormatFlag_TexCoords;
 
-			pMeshBatch->AddMesh(&mesh);
+			// Tangents are derived from the texture coordinates.
+			if (meshProcessingParams.m_GenerateTangents)
+				vertexFormat |= VertexData::FormatFlag_Tangent;
 		}
-		pScene->AddMeshBatch(pMeshBatch);
+		return vertexFormat;
 	}
 
 	void AddAssimpMaterials(Scene* pScene, const aiScene* pAssimpScene, const std::filesystem::path& materialDirectoryPath)
 	{
 		assert(pAssimpScene->HasMaterials());
 
+		// Texture types follow the Assimp OBJ importer.
+		const aiTextureType textureTypes[Material::NumTextures] = {aiTextureType_DIFFUSE, aiTextureType_AMBIENT, aiTextureType_SHININESS};
+
 		aiString assimpName;
 		aiString assimpMapPath;
 
@@ -285,46 +1059,62 @@ namespace
 			assert(result == aiReturn_SUCCESS);
 			Material* pMaterial = new Material(AnsiToWideString(assimpName.C_Str()));
 
-			result = pAssimpMaterial->Get(AI_MATKEY_TEXTURE(aiTextureType_DIFFUSE, 0), assimpMapPath);
-			assert(result == aiReturn_SUCCESS);
-			pMaterial->m_FilePaths[Material::BaseColorTextureIndex] = materialDirectoryPath / assimpMapPath.C_Str();
-			
-			result = pAssimpMaterial->Get(AI_MATKEY_TEXTURE(aiTextureType_AMBIENT, 0), assimpMapPath);
-			assert(result == aiReturn_SUCCESS);
-			pMaterial->m_FilePaths[Material::MetalnessTextureIndex] = materialDirectoryPath / assimpMapPath.C_Str();
-			
-			result = pAssimpMaterial->Get(AI_MATKEY_TEXTURE(aiTextureType_SHININESS, 0), assimpMapPath);
-			assert(result == aiReturn_SUCCESS);
-			pMaterial->m_FilePaths[Material::RougnessTextureIndex] = materialDirectoryPath / assimpMapPath.C_Str();
-				
+			for (u32 textureIndex = 0; textureIndex < Material::NumTextures; ++textureIndex)
+			{
+				result = pAssimpMaterial->Get(AI_MATKEY_TEXTURE(textureTypes[textureIndex], 0), assimpMapPath);
+				if (result == aiReturn_SUCCESS)
+					pMaterial->m_FilePaths[textureIndex] = materialDirectoryPath / assimpMapPath.C_Str();
+				else
+					pMaterial->m_FilePaths[textureIndex] = std::filesystem::path(kDefaultTextureDirectoryPath) / kDefaultTextureFileNames[textureIndex];
+			}
 			pScene->AddMaterial(pMaterial);
 		}
 	}
 
-	Scene* LoadSceneFromFile(const wchar_t* pFilePath, const Matrix4f& worldMatrix, bool use32BitIndices)
+	Scene* LoadSceneFromFile(const wchar_t* pFilePath, const Matrix4f& worldMatrix,
+		const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams, const DynamicObjectParams& dynamicObjectParams)
 	{
 		Assimp::Importer importer;
 
-		const u32 importFlags = aiProcess_CalcTangentSpace |
-			aiProcess_GenNormals |
-			aiProcess_Triangulate |
+		u32 importFlags = aiProcess_Triangulate |
 			aiProcess_SortByPType |
 			aiProcess_MakeLeftHanded |
 			aiProcess_FlipUVs |
 			aiProcess_FlipWindingOrder |
-			aiProcess_JoinIdenticalVertices |
-			aiProcess_OptimizeMeshes |
 			aiProcess_RemoveRedundantMaterials;
 
-		const aiScene* pAssimpScene = importer.ReadFile(WideToAnsiString(pFilePath), importFlags);
-		if (pAssimpScene == nullptr)
+		if (!meshProcessingParams.m_UseNativeProcessing)
 		{
-			OutputDebugStringA(importer.GetErrorString());
-			return nullptr;
+			importFlags |= aiProcess_GenNormals | aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes;
+			if (meshProcessingParams.m_GenerateTangents)
+				importFlags |= aiProcess_CalcTangentSpace;
+		}
+
+		std::unique_ptr<aiScene> objScene;
+		const aiScene* pAssimpScene = nullptr;
+
+		if (meshProcessingParams.m_UseNativeProcessing && meshProcessingParams.m_UseNativeObjLoader && (ExtractFileExtension(pFilePath) == L"obj"))
+		{
+			objScene.reset(LoadObjFile(pFilePath));
+			pAssimpScene = objScene.get();
+			if (pAssimpScene == nullptr)
+			{
+				OutputDebugStringA("Failed to load OBJ file\n");
+				return nullptr;
+			}
+		}
+		else
+		{
+			pAssimpScene = importer.ReadFile(WideToAnsiString(pFilePath), importFlags);
+			if (pAssimpScene == nullptr)
+			{
+				OutputDebugStringA(importer.GetErrorString());
+				return nullptr;
+			}
 		}
 
 		Scene* pScene = new Scene();
-		AddAssimpMeshes(pScene, pAssimpScene, worldMatrix, use32BitIndices);
+		AddAssimpMeshes(pScene, pAssimpScene, worldMatrix, meshMergingParams, meshProcessingParams, dynamicObjectParams);
 
 		std::filesystem::path materialDirectoryPath(pFilePath);
 		materialDirectoryPath.remove_filename();
@@ -333,4 +1123,226 @@ namespace
 
 		return pScene;
 	}
+
+	VertexCacheStats AnalyzeMeshBatchVertexCache(const MeshBatch* pMeshBatch)
+	{
+		VertexCacheStats stats;
+		std::vector<u32> meshIndices;
+
+		for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+		{
+			const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+			meshIndices.resize(meshInfo.m_IndexCount);
+
+			if (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT)
+			{
+				const u16* pFirstIndex = pMeshBatch->Get16BitIndices() + meshInfo.m_StartIndexLocation;
+				std::copy(pFirstIndex, pFirstIndex + meshInfo.m_IndexCount, meshIndices.begin());
+			}
+			else
+			{
+				const u32* pFirstIndex = pMeshBatch->Get32BitIndices() + meshInfo.m_StartIndexLocation;
+				std::copy(pFirstIndex, pFirstIndex + meshInfo.m_IndexCount, meshIndices.begin());
+			}
+
+			AccumulateVertexCacheStats(AnalyzeVertexCache(meshInfo.m_VertexCount, meshInfo.m_IndexCount, meshIndices.data()), &stats);
+		}
+
+		return stats;
+	}
+
+	void OutputVertexCacheStats(const VertexCacheStats& statsBefore, const VertexCacheStats& statsAfter)
+	{
+		const u32 outputBufferSize = 256;
+		char outputBuffer[outputBufferSize];
+
+		std::snprintf(outputBuffer, outputBufferSize,
+			"Vertex cache (FIFO %u): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, transformed vertices %u -> %u\n",
+			kDefaultVertexCacheSize,
+			statsBefore.m_ACMR, statsAfter.m_ACMR,
+			statsBefore.m_ATVR, statsAfter.m_ATVR,
+			statsBefore.m_NumTransformedVertices, statsAfter.m_NumTransformedVertices);
+
+		OutputDebugStringA(outputBuffer);
+	}
+
+	void OutputIndexFormatStats(const std::vector<MeshBatch*>& meshBatches)
+	{
+		u32 num16BitIndexMeshes = 0;
+		u32 num32BitIndexMeshes = 0;
+		u32 num16BitIndices = 0;
+		u32 num32BitIndices = 0;
+
+		for (const MeshBatch* pMeshBatch : meshBatches)
+		{
+			if (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT)
+			{
+				num16BitIndexMeshes += pMeshBatch->GetNumMeshes();
+				num16BitIndices += pMeshBatch->GetNumIndices();
+			}
+			else
+			{
+				num32BitIndexMeshes += pMeshBatch->GetNumMeshes();
+				num32BitIndices += pMeshBatch->GetNumIndices();
+			}
+		}
+
+		const u32 outputBufferSize = 256;
+		char outputBuffer[outputBufferSize];
+
+		std::snprintf(outputBuffer, outputBufferSize,
+			"Index formats: %u meshes with 16-bit indices, %u with 32-bit indices, index data %.2f MB (%.2f MB if all 32-bit)\n",
+			num16BitIndexMeshes, num32BitIndexMeshes,
+			f32(num16BitIndices * sizeof(u16) + num32BitIndices * sizeof(u32)) / (1024.0f * 1024.0f),
+			f32((num16BitIndices + num32BitIndices) * sizeof(u32)) / (1024.0f * 1024.0f));
+
+		OutputDebugStringA(outputBuffer);
+	}
+
+	void OutputInstancingStats(u32 numSourceMeshes, const std::vector<AssimpMeshInstances>& uniqueMeshes)
+	{
+		u32 numInstancedMeshes = 0;
+		u32 maxNumInstances = 0;
+
+		for (const AssimpMeshInstances& uniqueMesh : uniqueMeshes)
+		{
+			const u32 numInstances = uniqueMesh.m_InstanceWorldMatrices.size();
+			if (numInstances > 1)
+				++numInstancedMeshes;
+			
+			maxNumInstances = Max(maxNumInstances, numInstances);
+		}
+
+		const u32 numRemovedCopies = numSourceMeshes - u32(uniqueMeshes.size());
+
+		const u32 outputBufferSize = 256;
+		char outputBuffer[outputBufferSize];
+
+		std::snprintf(outputBuffer, outputBufferSize,
+			"Instancing: %u meshes -> %u unique meshes, %u of them instanced, %u copies removed, max %u instances per mesh\n",
+			numSourceMeshes, u32(uniqueMeshes.size()), numInstancedMeshes, numRemovedCopies, maxNumInstances);
+
+		OutputDebugStringA(outputBuffer);
+	}
+
+	const std::wstring GetCookedSceneFilePath(const wchar_t* pFilePath, const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+		const DynamicObjectParams& dynamicObjectParams, const SceneSetup& sceneSetup)
+	{
+		std::wstring extension;
+		if (meshMergingParams.m_Enabled)
+			extension += L".merged" + std::to_wstring(meshMergingParams.m_MaxBoundsSize);
+		if (meshProcessingParams.m_UseNativeProcessing)
+		{
+			extension += meshProcessingParams.m_UseNativeObjLoader ? L".native.objloader" : L".native";
+			extension += L".smooth" + std::to_wstring(meshProcessingParams.m_MaxSmoothingAngleInDegrees);
+		}
+		if (meshProcessingParams.m_GenerateTangents)
+			extension += L".tangents";
+		if (!meshProcessingParams.m_SortMeshesByMortonCode)
+			extension += L".filemeshorder";
+		if (!dynamicObjectParams.m_NamePrefixes.empty())
+		{
+			u64 prefixesHash = kHashOffsetBasis;
+			for (const std::string& prefix : dynamicObjectParams.m_NamePrefixes)
+				prefixesHash = HashBytes(prefix.c_str(), prefix.size() + 1, prefixesHash);
+
+			extension += L".dynamic" + std::to_wstring(u32(prefixesHash));
+		}
+		extension += L".setup" + std::to_wstring(u32(sceneSetup.CalcHash()));
+		extension += L".cookedscene";
+
+		std::filesystem::path cookedFilePath(pFilePath);
+		cookedFilePath.replace_extension(extension);
+		
+		return cookedFilePath.wstring();
+	}
+
+	Scene* LoadCookedSceneIfUpToDate(const wchar_t* pFilePath, const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+		const DynamicObjectParams& dynamicObjectParams, const SceneSetup& sceneSetup)
+	{
+		const std::wstring cookedFilePath = GetCookedSceneFilePath(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup);
+
+		std::error_code errorCode;
+		const auto cookedFileTime = std::filesystem::last_write_time(cookedFilePath, errorCode);
+		if (errorCode)
+			return nullptr;
+
+		const auto sourceFileTime = std::filesystem::last_write_time(pFilePath, errorCode);
+		if (!errorCode && (sourceFileTime > cookedFileTime))
+			return nullptr;
+
+		// A truncated or corrupted file is not used, and the scene is loaded from the source file and cooked again.
+		Scene* pScene = LoadCookedScene(cookedFilePath.c_str());
+		if (pScene == nullptr)
+			OutputDebugStringA("Failed to load cooked scene, loading the source file\n");
+
+		return pScene;
+	}
+
+	void CookScene(const wchar_t* pFilePath, const MeshMergingParams& meshMergingParams, const MeshProcessingParams& meshProcessingParams,
+		const DynamicObjectParams& dynamicObjectParams, const SceneSetup& sceneSetup, Scene* pScene)
+	{
+		if (pScene == nullptr)
+			return;
+
+		const std::wstring cookedFilePath = GetCookedSceneFilePath(pFilePath, meshMergingParams, meshProcessingParams, dynamicObjectParams, sceneSetup);
+		if (!WriteCookedScene(cookedFilePath.c_str(), pScene))
+			OutputDebugStringA("Failed to write cooked scene\n");
+	}
+
+	SceneSetup::~SceneSetup()
+	{
+		SafeDelete(m_pCamera);
+		for (SpotLight* pSpotLight : m_SpotLights)
+			SafeDelete(pSpotLight);
+	}
+
+	u64 SceneSetup::CalcHash() const
+	{
+		auto hashValue = [](const auto& value, u64 hash)
+		{
+			return HashBytes(&value, sizeof(value), hash);
+		};
+
+		u64 hash = hashValue(kSceneLoaderVersion, kHashOffsetBasis);
+		hash = hashValue(m_WorldMatrix, hash);
+
+		hash = hashValue(u32((m_pCamera != nullptr) ? 1 : 0), hash);
+		if (m_pCamera != nullptr)
+		{
+			hash = hashValue(m_pCamera->GetWorldPosition(), hash);
+			hash = hashValue(m_pCamera->GetWorldOrientation(), hash);
+			hash = hashValue(m_pCamera->GetFieldOfViewY(), hash);
+			hash = hashValue(m_pCamera->GetAspectRatio(), hash);
+			hash = hashValue(m_pCamera->GetNearClipDistance(), hash);
+			hash = hashValue(m_pCamera->GetFarClipDistance(), hash);
+			hash = hashValue(m_pCamera->GetMoveSpeed(), hash);
+			hash = hashValue(m_pCamera->GetRotationSpeed(), hash);
+		}
+
+		hash = hashValue(u32(m_SpotLights.size()), hash);
+		for (const SpotLight* pSpotLight : m_SpotLights)
+		{
+			hash = hashValue(pSpotLight->GetWorldPosition(), hash);
+			hash = hashValue(pSpotLight->GetWorldOrientation(), hash);
+			hash = hashValue(pSpotLight->GetRadiantPower(), hash);
+			hash = hashValue(pSpotLight->GetRange(), hash);
+			hash = hashValue(pSpotLight->GetInnerConeAngle(), hash);
+			hash = hashValue(pSpotLight->GetOuterConeAngle(), hash);
+			hash = hashValue(pSpotLight->GetShadowNearPlane(), hash);
+			hash = hashValue(pSpotLight->GetExpShadowMapConstant(), hash);
+		}
+		return hash;
+	}
+
+	void SceneSetup::MoveToScene(Scene* pScene)
+	{
+		if (m_pCamera != nullptr)
+			pScene->SetCamera(m_pCamera);
+		m_pCamera = nullptr;
+
+		for (SpotLight* pSpotLight : m_SpotLights)
+			pScene->AddSpotLight(pSpotLight);
+		m_SpotLights.clear();
+	}
 }
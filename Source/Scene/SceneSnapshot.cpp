@@ -0,0 +1,295 @@
+#include "Scene/SceneSnapshot.h"
+#include <algorithm>
+
+namespace
+{
+	template <typename T>
+	void AppendObjects(std::vector<T*>& destObjects, std::vector<T*>& srcObjects);
+
+	template <typename T>
+	void DeleteObjectList(std::vector<T*>& objects);
+}
+
+SceneSnapshotStore::SceneSnapshotStore(Scene* pScene)
+	: m_pScene(pScene)
+	, m_HasEdits(false)
+{
+	m_Snapshots.push_back(CreateSnapshot(0, nullptr));
+}
+
+SceneSnapshotStore::~SceneSnapshotStore()
+{
+	for (SceneSnapshot* pSnapshot : m_Snapshots)
+	{
+		assert(pSnapshot->m_NumReaders == 0);
+		SafeDelete(pSnapshot);
+	}
+	for (RetiredObjectsAtEpoch& retiredObjects : m_RetiredObjects)
+		DeleteObjects(&retiredObjects.m_Objects);
+
+	DeleteObjects(&m_PendingRetiredObjects);
+	SafeDelete(m_pScene);
+}
+
+void SceneSnapshotStore::AddMeshBatch(MeshBatch* pMeshBatch)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	m_pScene->AddMeshBatch(pMeshBatch);
+	m_HasEdits = true;
+}
+
+bool SceneSnapshotStore::RemoveMeshBatch(MeshBatch* pMeshBatch)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	if (!m_pScene->RemoveMeshBatch(pMeshBatch))
+		return false;
+
+	m_PendingRetiredObjects.m_MeshBatches.push_back(pMeshBatch);
+	m_HasEdits = true;
+	return true;
+}
+
+void SceneSnapshotStore::SetMeshInstanceWorldMatrix(MeshBatch* pMeshBatch, u32 meshIndex, u32 meshInstanceIndex, const Matrix4f& worldMatrix)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	pMeshBatch->SetMeshInstanceWorldMatrix(meshIndex, meshInstanceIndex, worldMatrix);
+	m_HasEdits = true;
+}
+
+u32 SceneSnapshotStore::AddMaterial(Material* pMaterial)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	const u32 materialID = m_pScene->AddMaterial(pMaterial);
+	m_HasEdits = true;
+	return materialID;
+}
+
+bool SceneSnapshotStore::RemoveMaterial(Material* pMaterial)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	if (!m_pScene->RemoveMaterial(pMaterial))
+		return false;
+
+	m_PendingRetiredObjects.m_Materials.push_back(pMaterial);
+	m_HasEdits = true;
+	return true;
+}
+
+void SceneSnapshotStore::SetDirectionalLight(DirectionalLight* pDirectionalLight)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	if (m_pScene->GetDirectionalLight() != pDirectionalLight)
+	{
+		DirectionalLight* pPrevDirectionalLight = m_pScene->RemoveDirectionalLight();
+		if (pPrevDirectionalLight != nullptr)
+			m_PendingRetiredObjects.m_DirectionalLights.push_back(pPrevDirectionalLight);
+
+		m_pScene->SetDirectionalLight(pDirectionalLight);
+		m_HasEdits = true;
+	}
+}
+
+void SceneSnapshotStore::AddPointLight(PointLight* pPointLight)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	m_pScene->AddPointLight(pPointLight);
+	m_HasEdits = true;
+}
+
+bool SceneSnapshotStore::RemovePointLight(PointLight* pPointLight)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	if (!m_pScene->RemovePointLight(pPointLight))
+		return false;
+
+	m_PendingRetiredObjects.m_PointLights.push_back(pPointLight);
+	m_HasEdits = true;
+	return true;
+}
+
+void SceneSnapshotStore::AddSpotLight(SpotLight* pSpotLight)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	m_pScene->AddSpotLight(pSpotLight);
+	m_HasEdits = true;
+}
+
+bool SceneSnapshotStore::RemoveSpotLight(SpotLight* pSpotLight)
+{
+	std::lock_guard<std::mutex> lock(m_EditMutex);
+	if (!m_pScene->RemoveSpotLight(pSpotLight))
+		return false;
+
+	m_PendingRetiredObjects.m_SpotLights.push_back(pSpotLight);
+	m_HasEdits = true;
+	return true;
+}
+
+u64 SceneSnapshotStore::Publish()
+{
+	std::vector<SceneSnapshot*> unreferencedSnapshots;
+	RetiredObjects unreferencedObjects;
+	u64 epoch = 0;
+	{
+		std::lock_guard<std::mutex> editLock(m_EditMutex);
+		if (!m_HasEdits)
+		{
+			std::lock_guard<std::mutex> snapshotLock(m_SnapshotMutex);
+			return m_Snapshots.back()->m_Epoch;
+		}
+
+		// Only Publish adds snapshots, so the latest snapshot cannot change or be deleted while the edit lock is held.
+		const SceneSnapshot* pPrevSnapshot = nullptr;
+		{
+			std::lock_guard<std::mutex> snapshotLock(m_SnapshotMutex);
+			pPrevSnapshot = m_Snapshots.back();
+			epoch = pPrevSnapshot->m_Epoch + 1;
+		}
+
+		// The copy is made outside of the snapshot lock so that the readers are not blocked by it.
+		SceneSnapshot* pSnapshot = CreateSnapshot(epoch, pPrevSnapshot);
+
+		RetiredObjectsAtEpoch retiredObjects;
+		retiredObjects.m_Epoch = epoch;
+		retiredObjects.m_Objects = std::move(m_PendingRetiredObjects);
+		m_PendingRetiredObjects = RetiredObjects();
+		m_HasEdits = false;
+
+		std::lock_guard<std::mutex> snapshotLock(m_SnapshotMutex);
+		m_Snapshots.push_back(pSnapshot);
+		m_RetiredObjects.push_back(std::move(retiredObjects));
+
+		CollectUnreferenced(&unreferencedSnapshots, &unreferencedObjects);
+	}
+
+	for (SceneSnapshot* pSnapshot : unreferencedSnapshots)
+		SafeDelete(pSnapshot);
+
+	DeleteObjects(&unreferencedObjects);
+	return epoch;
+}
+
+const SceneSnapshot* SceneSnapshotStore::AcquireSnapshot()
+{
+	std::lock_guard<std::mutex> lock(m_SnapshotMutex);
+
+	SceneSnapshot* pSnapshot = m_Snapshots.back();
+	++pSnapshot->m_NumReaders;
+
+	return pSnapshot;
+}
+
+void SceneSnapshotStore::ReleaseSnapshot(const SceneSnapshot* pSnapshot)
+{
+	std::vector<SceneSnapshot*> unreferencedSnapshots;
+	RetiredObjects unreferencedObjects;
+	{
+		std::lock_guard<std::mutex> lock(m_SnapshotMutex);
+
+		SceneSnapshot* pReleasedSnapshot = const_cast<SceneSnapshot*>(pSnapshot);
+		assert(pReleasedSnapshot->m_NumReaders > 0);
+		--pReleasedSnapshot->m_NumReaders;
+
+		CollectUnreferenced(&unreferencedSnapshots, &unreferencedObjects);
+	}
+
+	for (SceneSnapshot* pUnreferencedSnapshot : unreferencedSnapshots)
+		SafeDelete(pUnreferencedSnapshot);
+
+	DeleteObjects(&unreferencedObjects);
+}
+
+SceneSnapshot* SceneSnapshotStore::CreateSnapshot(u64 epoch, const SceneSnapshot* pPrevSnapshot)
+{
+	SceneSnapshot* pSnapshot = new SceneSnapshot();
+	pSnapshot->m_Epoch = epoch;
+	pSnapshot->m_WorldBounds = m_pScene->GetWorldBounds();
+	pSnapshot->m_MeshBatches.assign(m_pScene->GetMeshBatches(), m_pScene->GetMeshBatches() + m_pScene->GetNumMeshBatches());
+
+	pSnapshot->m_MovedMeshInstanceRanges.resize(pSnapshot->m_MeshBatches.size());
+	pSnapshot->m_MeshInstances.resize(pSnapshot->m_MeshBatches.size());
+	for (std::size_t meshBatchIndex = 0; meshBatchIndex < pSnapshot->m_MeshBatches.size(); ++meshBatchIndex)
+	{
+		const MeshBatch* pMeshBatch = pSnapshot->m_MeshBatches[meshBatchIndex];
+		pSnapshot->m_MeshBatches[meshBatchIndex]->ExtractDirtyMeshInstanceRanges(&pSnapshot->m_MovedMeshInstanceRanges[meshBatchIndex]);
+
+		// Mesh batches whose instances have not moved share the copy of the previous snapshot.
+		if ((pPrevSnapshot != nullptr) && pSnapshot->m_MovedMeshInstanceRanges[meshBatchIndex].empty())
+		{
+			auto prevIt = std::find(pPrevSnapshot->m_MeshBatches.cbegin(), pPrevSnapshot->m_MeshBatches.cend(), pMeshBatch);
+			if (prevIt != pPrevSnapshot->m_MeshBatches.cend())
+			{
+				pSnapshot->m_MeshInstances[meshBatchIndex] = pPrevSnapshot->m_MeshInstances[prevIt - pPrevSnapshot->m_MeshBatches.cbegin()];
+				continue;
+			}
+		}
+
+		std::shared_ptr<SceneSnapshot::MeshInstances> meshInstances = std::make_shared<SceneSnapshot::MeshInstances>();
+		const u32 numInstances = pMeshBatch->GetNumMeshInstances();
+		meshInstances->m_WorldMatrices.assign(pMeshBatch->GetMeshInstanceWorldMatrices(), pMeshBatch->GetMeshInstanceWorldMatrices() + numInstances);
+		meshInstances->m_WorldAABBs.assign(pMeshBatch->GetMeshInstanceWorldAABBs(), pMeshBatch->GetMeshInstanceWorldAABBs() + numInstances);
+		meshInstances->m_WorldOBBs.assign(pMeshBatch->GetMeshInstanceWorldOBBs(), pMeshBatch->GetMeshInstanceWorldOBBs() + numInstances);
+
+		pSnapshot->m_MeshInstances[meshBatchIndex] = std::move(meshInstances);
+	}
+
+	pSnapshot->m_Materials.assign(m_pScene->GetMaterials(), m_pScene->GetMaterials() + m_pScene->GetNumMaterials());
+	pSnapshot->m_pDirectionalLight = m_pScene->GetDirectionalLight();
+	pSnapshot->m_PointLights.assign(m_pScene->GetPointLights(), m_pScene->GetPointLights() + m_pScene->GetNumPointLights());
+	pSnapshot->m_SpotLights.assign(m_pScene->GetSpotLights(), m_pScene->GetSpotLights() + m_pScene->GetNumSpotLights());
+
+	return pSnapshot;
+}
+
+void SceneSnapshotStore::CollectUnreferenced(std::vector<SceneSnapshot*>* pSnapshots, RetiredObjects* pObjects)
+{
+	// A snapshot newer than one still in use may already be unreferenced, but it is kept
+	// until the older ones are gone, so that the oldest snapshot bounds the epochs of the referenced objects.
+	while ((m_Snapshots.size() > 1) && (m_Snapshots.front()->m_NumReaders == 0))
+	{
+		pSnapshots->push_back(m_Snapshots.front());
+		m_Snapshots.pop_front();
+	}
+
+	const u64 oldestEpoch = m_Snapshots.front()->m_Epoch;
+	while (!m_RetiredObjects.empty() && (m_RetiredObjects.front().m_Epoch <= oldestEpoch))
+	{
+		RetiredObjects& retiredObjects = m_RetiredObjects.front().m_Objects;
+
+		AppendObjects(pObjects->m_MeshBatches, retiredObjects.m_MeshBatches);
+		AppendObjects(pObjects->m_Materials, retiredObjects.m_Materials);
+		AppendObjects(pObjects->m_DirectionalLights, retiredObjects.m_DirectionalLights);
+		AppendObjects(pObjects->m_PointLights, retiredObjects.m_PointLights);
+		AppendObjects(pObjects->m_SpotLights, retiredObjects.m_SpotLights);
+
+		m_RetiredObjects.pop_front();
+	}
+}
+
+void SceneSnapshotStore::DeleteObjects(RetiredObjects* pObjects)
+{
+	DeleteObjectList(pObjects->m_MeshBatches);
+	DeleteObjectList(pObjects->m_Materials);
+	DeleteObjectList(pObjects->m_DirectionalLights);
+	DeleteObjectList(pObjects->m_PointLights);
+	DeleteObjectList(pObjects->m_SpotLights);
+}
+
+namespace
+{
+	template <typename T>
+	void AppendObjects(std::vector<T*>& destObjects, std::vector<T*>& srcObjects)
+	{
+		destObjects.insert(destObjects.end(), srcObjects.begin(), srcObjects.end());
+		srcObjects.clear();
+	}
+
+	template <typename T>
+	void DeleteObjectList(std::vector<T*>& objects)
+	{
+		for (decltype(objects.size()) index = 0; index < objects.size(); ++index)
+			SafeDelete(objects[index]);
+
+		objects.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,457 @@
+#include "Scene/SceneStats.h"
+#include "Scene/Scene.h"
+#include "Scene/Mesh.h"
+#include "Scene/MeshInstancing.h"
+#include "Scene/VertexCompression.h"
+#include "Common/ParallelFor.h"
+#include "Math/AxisAlignedBox.h"
+#include "Math/Sphere.h"
+
+namespace
+{
+	struct MeshGeometry
+	{
+		u32 m_NumVertices;
+		const Vector3f* m_pPositions;
+		const Vector3f* m_pNormals;
+		const Vector2f* m_pTexCoords;
+		const Vector4f* m_pColors;
+		const Vector3f* m_pTangents;
+		std::vector<u32> m_Indices;
+	};
+
+	void GetMeshGeometry(const MeshBatch* pMeshBatch, u32 meshIndex, MeshGeometry* pGeometry);
+	bool HaveSameGeometry(const MeshGeometry& geometry1, const MeshGeometry& geometry2);
+	u64 CalcGeometryHash(const MeshGeometry& geometry);
+
+	void CountBadTriangles(const MeshGeometry& geometry, f32 zeroAreaEpsilon, u32* pNumDegenerateTriangles, u32* pNumZeroAreaTriangles);
+	u32 CountDuplicateVertices(const MeshGeometry& geometry);
+	f32 CalcPrincipalOrientedBoxVolume(u32 numPoints, const Vector3f* pPoints);
+	
+	u32 CalcCPUVertexStrideInBytes(u8 vertexFormatFlags, MeshStream stream);
+	u32 CalcGPUVertexStrideInBytes(u8 vertexFormatFlags, u8 vertexCompressionFlags);
+}
+
+const char* GetMeshStreamName(MeshStream stream)
+{
+	static const char* streamNames[kNumMeshStreams] =
+	{
+		"Positions",
+		"Normals",
+		"TexCoords",
+		"Colors",
+		"Tangents",
+		"Indices",
+		"InstanceWorldMatrices"
+	};
+	assert(stream < kNumMeshStreams);
+	return streamNames[stream];
+}
+
+const MeshBatchStats AnalyzeMeshBatch(const MeshBatch* pMeshBatch, const SceneStatsParams& params)
+{
+	MeshBatchStats batchStats;
+	batchStats.m_VertexFormatFlags = pMeshBatch->GetVertexFormatFlags();
+	batchStats.m_VertexCompressionFlags = pMeshBatch->GetVertexCompressionFlags();
+	batchStats.m_IndexStrideInBytes = (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT) ? sizeof(u16) : sizeof(u32);
+
+	const u32 numMeshes = pMeshBatch->GetNumMeshes();
+	batchStats.m_MeshStats.resize(numMeshes);
+
+	std::vector<u64> geometryHashes(numMeshes);
+
+	auto analyzeMesh = [&](u32 meshIndex)
+	{
+		const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+		MeshStats& meshStats = batchStats.m_MeshStats[meshIndex];
+
+		MeshGeometry geometry;
+		GetMeshGeometry(pMeshBatch, meshIndex, &geometry);
+
+		meshStats.m_MaterialID = meshInfo.m_MaterialID;
+		meshStats.m_NumVertices = meshInfo.m_VertexCount;
+		meshStats.m_NumTriangles = meshInfo.m_IndexCount / 3;
+		meshStats.m_NumInstances = meshInfo.m_InstanceCount;
+		meshStats.m_VertexCacheStats = AnalyzeVertexCache(meshInfo.m_VertexCount, meshInfo.m_IndexCount, geometry.m_Indices.data(), params.m_VertexCacheSize);
+
+		CountBadTriangles(geometry, params.m_ZeroAreaEpsilon, &meshStats.m_NumDegenerateTriangles, &meshStats.m_NumZeroAreaTriangles);
+		meshStats.m_NumDuplicateVertices = CountDuplicateVertices(geometry);
+
+		if (geometry.m_NumVertices > 0)
+		{
+			const AxisAlignedBox aabb(geometry.m_NumVertices, geometry.m_pPositions);
+			meshStats.m_AABBVolume = 8.0f * aabb.m_Radius.m_X * aabb.m_Radius.m_Y * aabb.m_Radius.m_Z;
+
+			// The axis-aligned box is an oriented box too, so the principal axes are used only when they give a tighter fit.
+			meshStats.m_OBBVolume = Min(meshStats.m_AABBVolume, CalcPrincipalOrientedBoxVolume(geometry.m_NumVertices, geometry.m_pPositions));
+
+			const Sphere sphere(geometry.m_NumVertices, geometry.m_pPositions);
+			meshStats.m_SphereVolume = (4.0f / 3.0f) * PI * sphere.m_Radius * sphere.m_Radius * sphere.m_Radius;
+		}
+
+		for (u32 stream = MeshStream_Positions; stream <= MeshStream_Tangents; ++stream)
+			meshStats.m_StreamSizesInBytes[stream] = u64(meshInfo.m_VertexCount) * CalcCPUVertexStrideInBytes(batchStats.m_VertexFormatFlags, MeshStream(stream));
+		
+		meshStats.m_StreamSizesInBytes[MeshStream_Indices] = u64(meshInfo.m_IndexCount) * batchStats.m_IndexStrideInBytes;
+		meshStats.m_StreamSizesInBytes[MeshStream_InstanceWorldMatrices] = u64(meshInfo.m_InstanceCount) * sizeof(Matrix4f);
+
+		geometryHashes[meshIndex] = CalcGeometryHash(geometry);
+	};
+	ParallelFor(numMeshes, analyzeMesh);
+
+	// Meshes with the same hash are compared in full, so hash collisions are not counted as duplicates.
+	std::unordered_map<u64, std::vector<u32>> hashToMeshIndices;
+	MeshGeometry geometry;
+	MeshGeometry candidateGeometry;
+
+	for (u32 meshIndex = 0; meshIndex < numMeshes; ++meshIndex)
+	{
+		MeshStats& meshStats = batchStats.m_MeshStats[meshIndex];
+		std::vector<u32>& candidateMeshIndices = hashToMeshIndices[geometryHashes[meshIndex]];
+
+		if (!candidateMeshIndices.empty())
+		{
+			GetMeshGeometry(pMeshBatch, meshIndex, &geometry);
+			for (u32 candidateMeshIndex : candidateMeshIndices)
+			{
+				GetMeshGeometry(pMeshBatch, candidateMeshIndex, &candidateGeometry);
+				if (HaveSameGeometry(geometry, candidateGeometry))
+				{
+					meshStats.m_DuplicateOfMeshIndex = candidateMeshIndex;
+					break;
+				}
+			}
+		}
+		
+		// Only the first mesh of each set of duplicates needs to be compared against.
+		if (meshStats.m_DuplicateOfMeshIndex == kNotDuplicateMesh)
+			candidateMeshIndices.push_back(meshIndex);
+	}
+
+	for (u32 instanceIndex = 0; instanceIndex < pMeshBatch->GetNumMeshInstances(); ++instanceIndex)
+	{
+		if (pMeshBatch->IsMeshInstanceDynamic(instanceIndex))
+			++batchStats.m_NumDynamicInstances;
+	}
+
+	for (const MeshStats& meshStats : batchStats.m_MeshStats)
+	{
+		batchStats.m_NumVertices += meshStats.m_NumVertices;
+		batchStats.m_NumTriangles += meshStats.m_NumTriangles;
+		batchStats.m_NumInstances += meshStats.m_NumInstances;
+		AccumulateVertexCacheStats(meshStats.m_VertexCacheStats, &batchStats.m_VertexCacheStats);
+
+		batchStats.m_NumDegenerateTriangles += meshStats.m_NumDegenerateTriangles;
+		batchStats.m_NumZeroAreaTriangles += meshStats.m_NumZeroAreaTriangles;
+		batchStats.m_NumDuplicateVertices += meshStats.m_NumDuplicateVertices;
+
+		if (meshStats.m_DuplicateOfMeshIndex != kNotDuplicateMesh)
+		{
+			++batchStats.m_NumDuplicateMeshes;
+			for (u32 stream = MeshStream_Positions; stream <= MeshStream_Indices; ++stream)
+				batchStats.m_DuplicateMeshSizeInBytes += meshStats.m_StreamSizesInBytes[stream];
+		}
+
+		batchStats.m_MaxNumInstancesPerMesh = Max(batchStats.m_MaxNumInstancesPerMesh, meshStats.m_NumInstances);
+		if (meshStats.m_NumInstances == 1)
+			++batchStats.m_NumSingleInstanceMeshes;
+		if (meshStats.m_NumInstances >= kMaxNumInstancesPerMesh)
+			++batchStats.m_NumMeshesAtInstanceLimit;
+
+		for (u32 stream = 0; stream < kNumMeshStreams; ++stream)
+			batchStats.m_StreamSizesInBytes[stream] += meshStats.m_StreamSizesInBytes[stream];
+	}
+
+	batchStats.m_GPUVertexSizeInBytes = u64(pMeshBatch->GetNumVertices()) *
+		CalcGPUVertexStrideInBytes(batchStats.m_VertexFormatFlags, batchStats.m_VertexCompressionFlags);
+
+	return batchStats;
+}
+
+const SceneStats AnalyzeScene(Scene* pScene, const SceneStatsParams& params)
+{
+	SceneStats sceneStats;
+
+	sceneStats.m_MeshBatchStats.reserve(pScene->GetNumMeshBatches());
+	for (std::size_t meshBatchIndex = 0; meshBatchIndex < pScene->GetNumMeshBatches(); ++meshBatchIndex)
+		sceneStats.m_MeshBatchStats.emplace_back(AnalyzeMeshBatch(pScene->GetMeshBatches()[meshBatchIndex], params));
+
+	sceneStats.m_NumMaterials = u32(pScene->GetNumMaterials());
+	sceneStats.m_NumPointLights = u32(pScene->GetNumPointLights());
+	sceneStats.m_NumSpotLights = u32(pScene->GetNumSpotLights());
+
+	return sceneStats;
+}
+
+namespace
+{
+	void GetMeshGeometry(const MeshBatch* pMeshBatch, u32 meshIndex, MeshGeometry* pGeometry)
+	{
+		const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+		const u8 vertexFormatFlags = pMeshBatch->GetVertexFormatFlags();
+		const u32 baseVertex = u32(meshInfo.m_BaseVertexLocation);
+
+		pGeometry->m_NumVertices = meshInfo.m_VertexCount;
+		pGeometry->m_pPositions = pMeshBatch->GetPositions() + baseVertex;
+		pGeometry->m_pNormals = ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0) ? pMeshBatch->GetNormals() + baseVertex : nullptr;
+		pGeometry->m_pTexCoords = ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0) ? pMeshBatch->GetTexCoords() + baseVertex : nullptr;
+		pGeometry->m_pColors = ((vertexFormatFlags & VertexData::FormatFlag_Color) != 0) ? pMeshBatch->GetColors() + baseVertex : nullptr;
+		pGeometry->m_pTangents = ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0) ? pMeshBatch->GetTangents() + baseVertex : nullptr;
+
+		pGeometry->m_Indices.resize(meshInfo.m_IndexCount);
+		if (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT)
+		{
+			const u16* pFirstIndex = pMeshBatch->Get16BitIndices() + meshInfo.m_StartIndexLocation;
+			std::copy(pFirstIndex, pFirstIndex + meshInfo.m_IndexCount, pGeometry->m_Indices.begin());
+		}
+		else
+		{
+			const u32* pFirstIndex = pMeshBatch->Get32BitIndices() + meshInfo.m_StartIndexLocation;
+			std::copy(pFirstIndex, pFirstIndex + meshInfo.m_IndexCount, pGeometry->m_Indices.begin());
+		}
+	}
+
+	template <typename T>
+	bool AreStreamsEqual(u32 numVertices, const T* pVertices1, const T* pVertices2)
+	{
+		if (pVertices1 == nullptr)
+			return (pVertices2 == nullptr);
+		
+		return std::memcmp(pVertices1, pVertices2, numVertices * sizeof(T)) == 0;
+	}
+
+	bool HaveSameGeometry(const MeshGeometry& geometry1, const MeshGeometry& geometry2)
+	{
+		return (geometry1.m_NumVertices == geometry2.m_NumVertices) &&
+			(geometry1.m_Indices == geometry2.m_Indices) &&
+			AreStreamsEqual(geometry1.m_NumVertices, geometry1.m_pPositions, geometry2.m_pPositions) &&
+			AreStreamsEqual(geometry1.m_NumVertices, geometry1.m_pNormals, geometry2.m_pNormals) &&
+			AreStreamsEqual(geometry1.m_NumVertices, geometry1.m_pTexCoords, geometry2.m_pTexCoords) &&
+			AreStreamsEqual(geometry1.m_NumVertices, geometry1.m_pColors, geometry2.m_pColors) &&
+			AreStreamsEqual(geometry1.m_NumVertices, geometry1.m_pTangents, geometry2.m_pTangents);
+	}
+
+	u64 CalcGeometryHash(const MeshGeometry& geometry)
+	{
+		u64 hash = HashBytes(&geometry.m_NumVertices, sizeof(geometry.m_NumVertices));
+		hash = HashBytes(geometry.m_Indices.data(), geometry.m_Indices.size() * sizeof(u32), hash);
+		
+		// Positions and indices tell apart all but the meshes which differ only in the other attributes.
+		// Those are told apart by the full comparison.
+		hash = HashBytes(geometry.m_pPositions, geometry.m_NumVertices * sizeof(Vector3f), hash);
+
+		return hash;
+	}
+
+	void CountBadTriangles(const MeshGeometry& geometry, f32 zeroAreaEpsilon, u32* pNumDegenerateTriangles, u32* pNumZeroAreaTriangles)
+	{
+		u32 numDegenerateTriangles = 0;
+		u32 numZeroAreaTriangles = 0;
+
+		for (std::size_t index = 0; index + 2 < geometry.m_Indices.size(); index += 3)
+		{
+			const u32 index0 = geometry.m_Indices[index + 0];
+			const u32 index1 = geometry.m_Indices[index + 1];
+			const u32 index2 = geometry.m_Indices[index + 2];
+
+			if ((index0 == index1) || (index1 == index2) || (index0 == index2))
+			{
+				++numDegenerateTriangles;
+				continue;
+			}
+
+			const Vector3f edge01 = geometry.m_pPositions[index1] - geometry.m_pPositions[index0];
+			const Vector3f edge02 = geometry.m_pPositions[index2] - geometry.m_pPositions[index0];
+			const Vector3f edge12 = geometry.m_pPositions[index2] - geometry.m_pPositions[index1];
+
+			const f32 doubleArea = Length(Cross(edge01, edge02));
+			const f32 maxSqEdgeLength = Max(LengthSquared(edge01), Max(LengthSquared(edge02), LengthSquared(edge12)));
+			
+			if (doubleArea <= 2.0f * zeroAreaEpsilon * maxSqEdgeLength)
+				++numZeroAreaTriangles;
+		}
+
+		*pNumDegenerateTriangles = numDegenerateTriangles;
+		*pNumZeroAreaTriangles = numZeroAreaTriangles;
+	}
+
+	template <typename T>
+	void PackVertexAttribute(u32 numVertices, const T* pVertices, u32 vertexStrideInBytes, u32* pByteOffset, u8* pPackedVertices)
+	{
+		if (pVertices == nullptr)
+			return;
+
+		for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+			std::memcpy(pPackedVertices + vertexIndex * vertexStrideInBytes + *pByteOffset, pVertices + vertexIndex, sizeof(T));
+		
+		*pByteOffset += sizeof(T);
+	}
+
+	u32 CountDuplicateVertices(const MeshGeometry& geometry)
+	{
+		if (geometry.m_NumVertices < 2)
+			return 0;
+		
+		const u32 vertexStrideInBytes = sizeof(Vector3f) +
+			((geometry.m_pNormals != nullptr) ? sizeof(Vector3f) : 0) +
+			((geometry.m_pTexCoords != nullptr) ? sizeof(Vector2f) : 0) +
+			((geometry.m_pColors != nullptr) ? sizeof(Vector4f) : 0) +
+			((geometry.m_pTangents != nullptr) ? sizeof(Vector3f) : 0);
+
+		// Vertices are compared bitwise.
+		std::vector<u8> packedVertices(std::size_t(geometry.m_NumVertices) * vertexStrideInBytes);
+		u32 byteOffset = 0;
+		PackVertexAttribute(geometry.m_NumVertices, geometry.m_pPositions, vertexStrideInBytes, &byteOffset, packedVertices.data());
+		PackVertexAttribute(geometry.m_NumVertices, geometry.m_pNormals, vertexStrideInBytes, &byteOffset, packedVertices.data());
+		PackVertexAttribute(geometry.m_NumVertices, geometry.m_pTexCoords, vertexStrideInBytes, &byteOffset, packedVertices.data());
+		PackVertexAttribute(geometry.m_NumVertices, geometry.m_pColors, vertexStrideInBytes, &byteOffset, packedVertices.data());
+		PackVertexAttribute(geometry.m_NumVertices, geometry.m_pTangents, vertexStrideInBytes, &byteOffset, packedVertices.data());
+		assert(byteOffset == vertexStrideInBytes);
+
+		std::vector<u32> sortedVertexIndices(geometry.m_NumVertices);
+		for (u32 vertexIndex = 0; vertexIndex < geometry.m_NumVertices; ++vertexIndex)
+			sortedVertexIndices[vertexIndex] = vertexIndex;
+
+		auto compareVertices = [&](u32 vertexIndex1, u32 vertexIndex2)
+		{
+			return std::memcmp(&packedVertices[vertexIndex1 * vertexStrideInBytes], &packedVertices[vertexIndex2 * vertexStrideInBytes], vertexStrideInBytes) < 0;
+		};
+		std::sort(sortedVertexIndices.begin(), sortedVertexIndices.end(), compareVertices);
+
+		u32 numDuplicateVertices = 0;
+		for (u32 index = 1; index < geometry.m_NumVertices; ++index)
+		{
+			if (!compareVertices(sortedVertexIndices[index - 1], sortedVertexIndices[index]))
+				++numDuplicateVertices;
+		}
+		return numDuplicateVertices;
+	}
+
+	// Box aligned with the eigenvectors of the covariance matrix of the points.
+	// The eigenvectors are found with the Jacobi eigenvalue algorithm.
+	f32 CalcPrincipalOrientedBoxVolume(u32 numPoints, const Vector3f* pPoints)
+	{
+		f64 mean[3] = {0.0, 0.0, 0.0};
+		for (u32 pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+		{
+			for (u8 axis = 0; axis < 3; ++axis)
+				mean[axis] += pPoints[pointIndex][axis];
+		}
+		for (u8 axis = 0; axis < 3; ++axis)
+			mean[axis] /= f64(numPoints);
+
+		f64 covariance[3][3] = {};
+		for (u32 pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+		{
+			const f64 offset[3] = {pPoints[pointIndex].m_X - mean[0], pPoints[pointIndex].m_Y - mean[1], pPoints[pointIndex].m_Z - mean[2]};
+			for (u8 row = 0; row < 3; ++row)
+			{
+				for (u8 column = 0; column < 3; ++column)
+					covariance[row][column] += offset[row] * offset[column];
+			}
+		}
+
+		f64 eigenvectors[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+		const u32 maxNumSweeps = 32;
+
+		for (u32 sweepIndex = 0; sweepIndex < maxNumSweeps; ++sweepIndex)
+		{
+			const f64 offDiagonalSum = std::abs(covariance[0][1]) + std::abs(covariance[0][2]) + std::abs(covariance[1][2]);
+			if (offDiagonalSum < 1e-12 * (std::abs(covariance[0][0]) + std::abs(covariance[1][1]) + std::abs(covariance[2][2])))
+				break;
+
+			for (u8 p = 0; p < 2; ++p)
+			{
+				for (u8 q = p + 1; q < 3; ++q)
+				{
+					if (covariance[p][q] == 0.0)
+						continue;
+
+					// Rotation which zeroes the element (p, q).
+					const f64 theta = (covariance[q][q] - covariance[p][p]) / (2.0 * covariance[p][q]);
+					const f64 t = ((theta >= 0.0) ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+					const f64 c = 1.0 / std::sqrt(t * t + 1.0);
+					const f64 s = t * c;
+
+					for (u8 k = 0; k < 3; ++k)
+					{
+						const f64 kp = covariance[k][p];
+						const f64 kq = covariance[k][q];
+						covariance[k][p] = c * kp - s * kq;
+						covariance[k][q] = s * kp + c * kq;
+					}
+					for (u8 k = 0; k < 3; ++k)
+					{
+						const f64 pk = covariance[p][k];
+						const f64 qk = covariance[q][k];
+						covariance[p][k] = c * pk - s * qk;
+						covariance[q][k] = s * pk + c * qk;
+					}
+					for (u8 k = 0; k < 3; ++k)
+					{
+						const f64 kp = eigenvectors[k][p];
+						const f64 kq = eigenvectors[k][q];
+						eigenvectors[k][p] = c * kp - s * kq;
+						eigenvectors[k][q] = s * kp + c * kq;
+					}
+				}
+			}
+		}
+
+		f32 volume = 1.0f;
+		for (u8 column = 0; column < 3; ++column)
+		{
+			const Vector3f axis(f32(eigenvectors[0][column]), f32(eigenvectors[1][column]), f32(eigenvectors[2][column]));
+
+			f32 minProjection = Dot(axis, pPoints[0]);
+			f32 maxProjection = minProjection;
+			for (u32 pointIndex = 1; pointIndex < numPoints; ++pointIndex)
+			{
+				const f32 projection = Dot(axis, pPoints[pointIndex]);
+				minProjection = Min(minProjection, projection);
+				maxProjection = Max(maxProjection, projection);
+			}
+			volume *= maxProjection - minProjection;
+		}
+		return volume;
+	}
+
+	u32 CalcCPUVertexStrideInBytes(u8 vertexFormatFlags, MeshStream stream)
+	{
+		switch (stream)
+		{
+			case MeshStream_Positions:
+				return ((vertexFormatFlags & VertexData::FormatFlag_Position) != 0) ? sizeof(Vector3f) : 0;
+			case MeshStream_Normals:
+				return ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0) ? sizeof(Vector3f) : 0;
+			case MeshStream_TexCoords:
+				return ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0) ? sizeof(Vector2f) : 0;
+			case MeshStream_Colors:
+				return ((vertexFormatFlags & VertexData::FormatFlag_Color) != 0) ? sizeof(Vector4f) : 0;
+			case MeshStream_Tangents:
+				return ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0) ? sizeof(Vector3f) : 0;
+			default:
+				break;
+		}
+		assert(false);
+		return 0;
+	}
+
+	// Mirrors the vertex layouts of MeshRenderResources: the interleaved vertex buffer and the position-only vertex buffer.
+	u32 CalcGPUVertexStrideInBytes(u8 vertexFormatFlags, u8 vertexCompressionFlags)
+	{
+		const u32 positionStrideInBytes = ((vertexCompressionFlags & VertexCompressionFlag_Position) != 0) ? 8 : 12;
+
+		u32 strideInBytes = positionStrideInBytes;
+		if ((vertexFormatFlags & VertexData::FormatFlag_Normal) != 0)
+			strideInBytes += ((vertexCompressionFlags & VertexCompressionFlag_Normal) != 0) ? 4 : 12;
+		if ((vertexFormatFlags & VertexData::FormatFlag_Color) != 0)
+			strideInBytes += 16;
+		if ((vertexFormatFlags & VertexData::FormatFlag_Tangent) != 0)
+			strideInBytes += ((vertexCompressionFlags & VertexCompressionFlag_Tangent) != 0) ? 4 : 12;
+		if ((vertexFormatFlags & VertexData::FormatFlag_TexCoords) != 0)
+			strideInBytes += ((vertexCompressionFlags & VertexCompressionFlag_TexCoords) != 0) ? 4 : 8;
+
+		return strideInBytes + positionStrideInBytes;
+	}
+}
\ No newline at end of file
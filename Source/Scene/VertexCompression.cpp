@@ -0,0 +1,269 @@
+#include "Scene/VertexCompression.h"
+#include "Math/Math.h"
+#include "Math/AxisAlignedBox.h"
+#include <emmintrin.h>
+
+namespace
+{
+	static_assert(sizeof(Vector2f) == 2 * sizeof(f32), "Texture coordinates are loaded as packed floats");
+	static_assert(sizeof(Vector3f) == 3 * sizeof(f32), "Positions are loaded as packed floats");
+
+	static const u32 kNumVerticesPerBatch = 4;
+
+	void QuantizePositions4(const Vector3f* pPositions, __m128 minPoint, __m128 scale, u16* pQuantizedPositions);
+	void QuantizeTexCoords4(const Vector2f* pTexCoords, __m128 minPoint, __m128 scale, u16* pQuantizedTexCoords);
+	void EncodeOctahedralUnitVectors4(const Vector3f* pUnitVectors, i16* pEncodedUnitVectors);
+
+	__m128i PackUNORM16(__m128i values1, __m128i values2);
+	f32 CalcQuantizationScale(f32 extent);
+	__m128 Select(__m128 mask, __m128 value1, __m128 value2);
+	void LoadSoA4(const Vector3f* pVectors, __m128* pX, __m128* pY, __m128* pZ);
+
+	// Runs the 4-wide encoder on the last numVertices % 4 vertices through padded copies.
+	template <typename InputType, typename OutputType, u32 numOutputsPerVertex, typename Encoder>
+	void EncodeRemainingVertices(u32 numVertices, const InputType* pInputs, OutputType* pOutputs, const Encoder& encoder);
+}
+
+const VertexQuantization CalcVertexQuantization(u32 numVertices, const Vector3f* pPositions, const Vector2f* pTexCoords)
+{
+	VertexQuantization quantization;
+	if (numVertices == 0)
+		return quantization;
+
+	const AxisAlignedBox bounds(numVertices, pPositions);
+	quantization.m_PositionScale = 2.0f * bounds.m_Radius;
+	quantization.m_PositionBias = bounds.m_Center - bounds.m_Radius;
+
+	if (pTexCoords != nullptr)
+	{
+		Vector2f minTexCoords = pTexCoords[0];
+		Vector2f maxTexCoords = pTexCoords[0];
+		for (u32 vertexIndex = 1; vertexIndex < numVertices; ++vertexIndex)
+		{
+			minTexCoords = Min(minTexCoords, pTexCoords[vertexIndex]);
+			maxTexCoords = Max(maxTexCoords, pTexCoords[vertexIndex]);
+		}
+		quantization.m_TexCoordScale = maxTexCoords - minTexCoords;
+		quantization.m_TexCoordBias = minTexCoords;
+	}
+	return quantization;
+}
+
+void QuantizePositions(u32 numVertices, const Vector3f* pPositions, const VertexQuantization& quantization, u16* pQuantizedPositions)
+{
+	const Vector3f& minPoint = quantization.m_PositionBias;
+	const Vector3f& extent = quantization.m_PositionScale;
+
+	const __m128 minPointSIMD = _mm_setr_ps(minPoint.m_X, minPoint.m_Y, minPoint.m_Z, 0.0f);
+	const __m128 scaleSIMD = _mm_setr_ps(CalcQuantizationScale(extent.m_X), CalcQuantizationScale(extent.m_Y), CalcQuantizationScale(extent.m_Z), 0.0f);
+
+	const u32 numBatchedVertices = numVertices - numVertices % kNumVerticesPerBatch;
+	for (u32 vertexIndex = 0; vertexIndex < numBatchedVertices; vertexIndex += kNumVerticesPerBatch)
+		QuantizePositions4(pPositions + vertexIndex, minPointSIMD, scaleSIMD, pQuantizedPositions + 4 * vertexIndex);
+
+	EncodeRemainingVertices<Vector3f, u16, 4>(numVertices, pPositions, pQuantizedPositions,
+		[minPointSIMD, scaleSIMD](const Vector3f* pInputs, u16* pOutputs)
+	{
+		QuantizePositions4(pInputs, minPointSIMD, scaleSIMD, pOutputs);
+	});
+}
+
+void QuantizeTexCoords(u32 numVertices, const Vector2f* pTexCoords, const VertexQuantization& quantization, u16* pQuantizedTexCoords)
+{
+	const Vector2f& minPoint = quantization.m_TexCoordBias;
+	const Vector2f& extent = quantization.m_TexCoordScale;
+
+	// Each register holds the texture coordinates of two vertices.
+	const __m128 minPointSIMD = _mm_setr_ps(minPoint.m_X, minPoint.m_Y, minPoint.m_X, minPoint.m_Y);
+	const __m128 scaleSIMD = _mm_setr_ps(CalcQuantizationScale(extent.m_X), CalcQuantizationScale(extent.m_Y),
+		CalcQuantizationScale(extent.m_X), CalcQuantizationScale(extent.m_Y));
+
+	const u32 numBatchedVertices = numVertices - numVertices % kNumVerticesPerBatch;
+	for (u32 vertexIndex = 0; vertexIndex < numBatchedVertices; vertexIndex += kNumVerticesPerBatch)
+		QuantizeTexCoords4(pTexCoords + vertexIndex, minPointSIMD, scaleSIMD, pQuantizedTexCoords + 2 * vertexIndex);
+
+	EncodeRemainingVertices<Vector2f, u16, 2>(numVertices, pTexCoords, pQuantizedTexCoords,
+		[minPointSIMD, scaleSIMD](const Vector2f* pInputs, u16* pOutputs)
+	{
+		QuantizeTexCoords4(pInputs, minPointSIMD, scaleSIMD, pOutputs);
+	});
+}
+
+void EncodeOctahedralUnitVectors(u32 numVertices, const Vector3f* pUnitVectors, i16* pEncodedUnitVectors)
+{
+	const u32 numBatchedVertices = numVertices - numVertices % kNumVerticesPerBatch;
+	for (u32 vertexIndex = 0; vertexIndex < numBatchedVertices; vertexIndex += kNumVerticesPerBatch)
+		EncodeOctahedralUnitVectors4(pUnitVectors + vertexIndex, pEncodedUnitVectors + 2 * vertexIndex);
+
+	EncodeRemainingVertices<Vector3f, i16, 2>(numVertices, pUnitVectors, pEncodedUnitVectors, EncodeOctahedralUnitVectors4);
+}
+
+const Vector3f DequantizePosition(const u16* pQuantizedPosition, const VertexQuantization& quantization)
+{
+	const Vector3f normalizedPosition = Vector3f(pQuantizedPosition[0], pQuantizedPosition[1], pQuantizedPosition[2]) / 65535.0f;
+	return quantization.m_PositionBias + normalizedPosition * quantization.m_PositionScale;
+}
+
+const Vector2f DequantizeTexCoords(const u16* pQuantizedTexCoords, const VertexQuantization& quantization)
+{
+	const Vector2f normalizedTexCoords = Vector2f(pQuantizedTexCoords[0], pQuantizedTexCoords[1]) / 65535.0f;
+	return quantization.m_TexCoordBias + normalizedTexCoords * quantization.m_TexCoordScale;
+}
+
+const Vector3f DecodeOctahedralUnitVector(const i16* pEncodedUnitVector)
+{
+	f32 x = Max(f32(pEncodedUnitVector[0]) / 32767.0f, -1.0f);
+	f32 y = Max(f32(pEncodedUnitVector[1]) / 32767.0f, -1.0f);
+	const f32 z = 1.0f - Abs(x) - Abs(y);
+
+	if (z < 0.0f)
+	{
+		const f32 foldedX = (1.0f - Abs(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		const f32 foldedY = (1.0f - Abs(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+
+		x = foldedX;
+		y = foldedY;
+	}
+	return Normalize(Vector3f(x, y, z));
+}
+
+f32 CalcPositionQuantizationError(const VertexQuantization& quantization)
+{
+	// Rounding to the nearest of 65536 steps over the extent is off by at most half a step on each axis.
+	return 0.5f * Length(quantization.m_PositionScale) / 65535.0f;
+}
+
+f32 CalcTexCoordQuantizationError(const VertexQuantization& quantization)
+{
+	return 0.5f * Max(quantization.m_TexCoordScale.m_X, quantization.m_TexCoordScale.m_Y) / 65535.0f;
+}
+
+f32 CalcOctahedralEncodingErrorInDegrees(u32 numVertices, const Vector3f* pUnitVectors)
+{
+	std::vector<i16> encodedUnitVectors(2 * numVertices);
+	EncodeOctahedralUnitVectors(numVertices, pUnitVectors, encodedUnitVectors.data());
+
+	f32 minCosAngle = 1.0f;
+	for (u32 vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+	{
+		const Vector3f decodedUnitVector = DecodeOctahedralUnitVector(&encodedUnitVectors[2 * vertexIndex]);
+		minCosAngle = Min(minCosAngle, Dot(Normalize(pUnitVectors[vertexIndex]), decodedUnitVector));
+	}
+	return ToDegrees(ArcCos(Clamp(-1.0f, 1.0f, minCosAngle)));
+}
+
+namespace
+{
+	void QuantizePositions4(const Vector3f* pPositions, __m128 minPoint, __m128 scale, u16* pQuantizedPositions)
+	{
+		const __m128 maxValue = _mm_set1_ps(65535.0f);
+
+		// Each register holds xyz of one vertex. w ends up 0.
+		__m128i quantizedPositions[kNumVerticesPerBatch];
+		for (u32 it = 0; it < kNumVerticesPerBatch; ++it)
+		{
+			const __m128 position = _mm_setr_ps(pPositions[it].m_X, pPositions[it].m_Y, pPositions[it].m_Z, 0.0f);
+			const __m128 normalizedPosition = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(position, minPoint), scale), _mm_setzero_ps()), maxValue);
+
+			quantizedPositions[it] = _mm_cvtps_epi32(normalizedPosition);
+		}
+
+		_mm_storeu_si128((__m128i*)(pQuantizedPositions + 0), PackUNORM16(quantizedPositions[0], quantizedPositions[1]));
+		_mm_storeu_si128((__m128i*)(pQuantizedPositions + 8), PackUNORM16(quantizedPositions[2], quantizedPositions[3]));
+	}
+
+	void QuantizeTexCoords4(const Vector2f* pTexCoords, __m128 minPoint, __m128 scale, u16* pQuantizedTexCoords)
+	{
+		const __m128 maxValue = _mm_set1_ps(65535.0f);
+
+		const __m128 texCoords01 = _mm_loadu_ps(&pTexCoords[0].m_X);
+		const __m128 texCoords23 = _mm_loadu_ps(&pTexCoords[2].m_X);
+
+		const __m128 normalizedTexCoords01 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(texCoords01, minPoint), scale), _mm_setzero_ps()), maxValue);
+		const __m128 normalizedTexCoords23 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(texCoords23, minPoint), scale), _mm_setzero_ps()), maxValue);
+
+		_mm_storeu_si128((__m128i*)pQuantizedTexCoords, PackUNORM16(_mm_cvtps_epi32(normalizedTexCoords01), _mm_cvtps_epi32(normalizedTexCoords23)));
+	}
+
+	void EncodeOctahedralUnitVectors4(const Vector3f* pUnitVectors, i16* pEncodedUnitVectors)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		__m128 x, y, z;
+		LoadSoA4(pUnitVectors, &x, &y, &z);
+
+		const __m128 absX = _mm_andnot_ps(signMask, x);
+		const __m128 absY = _mm_andnot_ps(signMask, y);
+		const __m128 absZ = _mm_andnot_ps(signMask, z);
+
+		// Project onto the octahedron |x| + |y| + |z| = 1.
+		const __m128 rcpL1Norm = _mm_div_ps(one, _mm_max_ps(_mm_add_ps(absX, _mm_add_ps(absY, absZ)), _mm_set1_ps(EPSILON)));
+		x = _mm_mul_ps(x, rcpL1Norm);
+		y = _mm_mul_ps(y, rcpL1Norm);
+
+		// Fold the lower hemisphere over the diagonals.
+		const __m128 signX = _mm_or_ps(one, _mm_and_ps(signMask, x));
+		const __m128 signY = _mm_or_ps(one, _mm_and_ps(signMask, y));
+
+		const __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, y)), signX);
+		const __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), signY);
+
+		const __m128 isLowerHemisphere = _mm_cmplt_ps(z, _mm_setzero_ps());
+		x = Select(isLowerHemisphere, foldedX, x);
+		y = Select(isLowerHemisphere, foldedY, y);
+
+		const __m128 snormScale = _mm_set1_ps(32767.0f);
+		const __m128i encodedX = _mm_cvtps_epi32(_mm_mul_ps(x, snormScale));
+		const __m128i encodedY = _mm_cvtps_epi32(_mm_mul_ps(y, snormScale));
+
+		const __m128i encodedX16 = _mm_packs_epi32(encodedX, encodedX);
+		const __m128i encodedY16 = _mm_packs_epi32(encodedY, encodedY);
+
+		_mm_storeu_si128((__m128i*)pEncodedUnitVectors, _mm_unpacklo_epi16(encodedX16, encodedY16));
+	}
+
+	// Packs 32-bit values in [0, 65535] to 16 bits. Pack with signed saturation works on values biased to the signed range.
+	__m128i PackUNORM16(__m128i values1, __m128i values2)
+	{
+		const __m128i bias = _mm_set1_epi32(32768);
+		const __m128i signFlip = _mm_set1_epi16(-32768);
+
+		return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(values1, bias), _mm_sub_epi32(values2, bias)), signFlip);
+	}
+
+	f32 CalcQuantizationScale(f32 extent)
+	{
+		return (extent > 0.0f) ? 65535.0f / extent : 0.0f;
+	}
+
+	__m128 Select(__m128 mask, __m128 value1, __m128 value2)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, value1), _mm_andnot_ps(mask, value2));
+	}
+
+	void LoadSoA4(const Vector3f* pVectors, __m128* pX, __m128* pY, __m128* pZ)
+	{
+		*pX = _mm_setr_ps(pVectors[0].m_X, pVectors[1].m_X, pVectors[2].m_X, pVectors[3].m_X);
+		*pY = _mm_setr_ps(pVectors[0].m_Y, pVectors[1].m_Y, pVectors[2].m_Y, pVectors[3].m_Y);
+		*pZ = _mm_setr_ps(pVectors[0].m_Z, pVectors[1].m_Z, pVectors[2].m_Z, pVectors[3].m_Z);
+	}
+
+	template <typename InputType, typename OutputType, u32 numOutputsPerVertex, typename Encoder>
+	void EncodeRemainingVertices(u32 numVertices, const InputType* pInputs, OutputType* pOutputs, const Encoder& encoder)
+	{
+		const u32 firstVertex = numVertices - numVertices % kNumVerticesPerBatch;
+		const u32 numRemainingVertices = numVertices - firstVertex;
+		if (numRemainingVertices == 0)
+			return;
+
+		InputType inputs[kNumVerticesPerBatch];
+		for (u32 it = 0; it < kNumVerticesPerBatch; ++it)
+			inputs[it] = pInputs[firstVertex + Min(it, numRemainingVertices - 1)];
+
+		OutputType outputs[kNumVerticesPerBatch * numOutputsPerVertex];
+		encoder(inputs, outputs);
+
+		std::copy(outputs, outputs + numRemainingVertices * numOutputsPerVertex, pOutputs + firstVertex * numOutputsPerVertex);
+	}
+}
\ No newline at end of file
@@ -7,7 +7,6 @@
 #include "assimp/scene.h"
 
 // ToDo
-// When loading assimp model SceneLoader should automatically figure out optimal index format
 // Remove unnecessary import flags from SceneLoader
 // Add support for opaque/transparent textures
 
@@ -0,0 +1,62 @@
+#include "ClusterCullingAnalysis.h"
+#include "Scene/Scene.h"
+#include "Scene/MeshBatch.h"
+#include "Scene/MeshCluster.h"
+#include "Common/ParallelFor.h"
+#include "Math/Frustum.h"
+#include "Math/Matrix4.h"
+
+const ClusterCullingStats AnalyzeClusterCulling(Scene* pScene, const std::vector<Viewpoint>& viewpoints, const OverdrawParams& params)
+{
+	assert((params.m_Width > 0) && (params.m_Height > 0));
+
+	ClusterCullingStats stats;
+	for (u32 meshBatchIndex = 0; meshBatchIndex < pScene->GetNumMeshBatches(); ++meshBatchIndex)
+	{
+		if (!pScene->GetMeshBatches()[meshBatchIndex]->HasMeshClusters())
+			++stats.m_NumMeshBatchesWithoutClusters;
+	}
+
+	const u32 numViewpoints = u32(viewpoints.size());
+	stats.m_ViewpointStats.resize(numViewpoints);
+
+	auto analyzeViewpoint = [&](u32 viewpointIndex)
+	{
+		const Viewpoint& viewpoint = viewpoints[viewpointIndex];
+		
+		Matrix4f viewProjMatrix;
+		CalcViewProjMatrix(pScene, viewpoint, params, &viewProjMatrix);
+		const Frustum frustum(viewProjMatrix);
+
+		MeshClusterCullingParams cullingParams;
+		cullingParams.m_pCameraWorldFrustum = &frustum;
+		cullingParams.m_CameraWorldPos = viewpoint.m_WorldPosition;
+
+		ViewpointClusterCullingStats& viewpointStats = stats.m_ViewpointStats[viewpointIndex];
+		viewpointStats.m_Viewpoint = viewpoint;
+
+		std::vector<VisibleMeshCluster> visibleClusters;
+		for (u32 meshBatchIndex = 0; meshBatchIndex < pScene->GetNumMeshBatches(); ++meshBatchIndex)
+		{
+			const MeshBatch* pMeshBatch = pScene->GetMeshBatches()[meshBatchIndex];
+			if (!pMeshBatch->HasMeshClusters())
+				continue;
+
+			MeshClusterCullingStats batchStats;
+			CullMeshClusters(pMeshBatch, cullingParams, &visibleClusters, &batchStats);
+
+			viewpointStats.m_NumTestedClusters += batchStats.m_NumTestedClusters;
+			viewpointStats.m_NumFrustumCulledClusters += batchStats.m_NumFrustumCulledClusters;
+			viewpointStats.m_NumBackfaceCulledClusters += batchStats.m_NumBackfaceCulledClusters;
+			viewpointStats.m_NumVisibleClusters += visibleClusters.size();
+
+			viewpointStats.m_NumTestedTriangles += batchStats.m_NumTestedTriangles;
+			viewpointStats.m_NumFrustumCulledTriangles += batchStats.m_NumFrustumCulledTriangles;
+			viewpointStats.m_NumBackfaceCulledTriangles += batchStats.m_NumBackfaceCulledTriangles;
+			viewpointStats.m_NumVisibleTriangles += batchStats.m_NumTestedTriangles - batchStats.m_NumFrustumCulledTriangles - batchStats.m_NumBackfaceCulledTriangles;
+		}
+	};
+	ParallelFor(numViewpoints, analyzeViewpoint);
+
+	return stats;
+}
\ No newline at end of file
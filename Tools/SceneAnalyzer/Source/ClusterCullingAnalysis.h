@@ -0,0 +1,27 @@
+#pragma once
+
+#include "OverdrawAnalysis.h"
+
+struct ViewpointClusterCullingStats
+{
+	Viewpoint m_Viewpoint;
+	u64 m_NumTestedClusters = 0;
+	u64 m_NumFrustumCulledClusters = 0;
+	u64 m_NumBackfaceCulledClusters = 0;
+	u64 m_NumVisibleClusters = 0;
+	u64 m_NumTestedTriangles = 0;
+	u64 m_NumFrustumCulledTriangles = 0;
+	u64 m_NumBackfaceCulledTriangles = 0;
+	u64 m_NumVisibleTriangles = 0;
+};
+
+struct ClusterCullingStats
+{
+	// Mesh batches without clusters are skipped.
+	u32 m_NumMeshBatchesWithoutClusters = 0;
+	std::vector<ViewpointClusterCullingStats> m_ViewpointStats;
+};
+
+// Culls the mesh clusters of each mesh batch by bounds and normal cone from each viewpoint with CullMeshClusters,
+// using the same view projection as AnalyzeOverdraw. Viewpoints are processed in parallel.
+const ClusterCullingStats AnalyzeClusterCulling(Scene* pScene, const std::vector<Viewpoint>& viewpoints, const OverdrawParams& params);
\ No newline at end of file
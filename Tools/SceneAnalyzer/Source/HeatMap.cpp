@@ -0,0 +1,62 @@
+#include "HeatMap.h"
+#include "Math/Math.h"
+#include "DirectXTex/DirectXTex.h"
+
+namespace
+{
+	void CalcHeatColor(u32 value, u32 maxValue, u8* pColor);
+}
+
+bool WriteHeatMap(const wchar_t* pFilePath, u32 width, u32 height, const u16* pValues, u32 maxValue)
+{
+	assert(maxValue > 0);
+
+	std::vector<u8> pixelBytes(4 * width * height);
+	for (u32 pixelIndex = 0; pixelIndex < width * height; ++pixelIndex)
+		CalcHeatColor(pValues[pixelIndex], maxValue, &pixelBytes[4 * pixelIndex]);
+
+	DirectX::Image image;
+	image.width = width;
+	image.height = height;
+	image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	image.rowPitch = 4 * width;
+	image.slicePitch = height * image.rowPitch;
+	image.pixels = pixelBytes.data();
+
+	return SUCCEEDED(DirectX::SaveToWICFile(image, DirectX::WIC_FLAGS_NONE, DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), pFilePath));
+}
+
+namespace
+{
+	void CalcHeatColor(u32 value, u32 maxValue, u8* pColor)
+	{
+		pColor[3] = 255;
+		if (value == 0)
+		{
+			pColor[0] = pColor[1] = pColor[2] = 0;
+			return;
+		}
+		if (value > maxValue)
+		{
+			pColor[0] = pColor[1] = pColor[2] = 255;
+			return;
+		}
+
+		static const f32 ramp[][3] =
+		{
+			{0.0f, 0.0f, 1.0f},
+			{0.0f, 1.0f, 1.0f},
+			{0.0f, 1.0f, 0.0f},
+			{1.0f, 1.0f, 0.0f},
+			{1.0f, 0.0f, 0.0f}
+		};
+		const u32 numRampColors = ARRAYSIZE(ramp);
+
+		const f32 rampPos = (maxValue > 1) ? f32(numRampColors - 1) * f32(value - 1) / f32(maxValue - 1) : 0.0f;
+		const u32 rampIndex = Min(u32(rampPos), numRampColors - 2);
+		const f32 t = rampPos - f32(rampIndex);
+
+		for (u32 channel = 0; channel < 3; ++channel)
+			pColor[channel] = u8(255.0f * ((1.0f - t) * ramp[rampIndex][channel] + t * ramp[rampIndex + 1][channel]) + 0.5f);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Common/Common.h"
+
+// Writes the per pixel counts as a PNG image. Zero is black and the counts from 1 to maxValue go
+// through blue, cyan, green, yellow and red. Counts above maxValue are white.
+// COM must be initialized on the calling thread. Returns false if the image cannot be written.
+bool WriteHeatMap(const wchar_t* pFilePath, u32 width, u32 height, const u16* pValues, u32 maxValue);
\ No newline at end of file
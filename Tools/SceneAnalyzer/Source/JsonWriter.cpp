@@ -0,0 +1,151 @@
+#include "JsonWriter.h"
+#include <cmath>
+
+JsonWriter::JsonWriter(std::ostream& outputStream)
+	: m_OutputStream(outputStream)
+{
+}
+
+void JsonWriter::BeginObject()
+{
+	BeginValue();
+	m_OutputStream << "{";
+	m_HasElementsStack.push_back(false);
+}
+
+void JsonWriter::EndObject()
+{
+	assert(!m_HasElementsStack.empty() && !m_AfterKey);
+	const bool hasElements = m_HasElementsStack.back();
+	m_HasElementsStack.pop_back();
+
+	if (hasElements)
+	{
+		m_OutputStream << "\n";
+		WriteIndent();
+	}
+	m_OutputStream << "}";
+
+	if (m_HasElementsStack.empty())
+		m_OutputStream << "\n";
+}
+
+void JsonWriter::BeginArray()
+{
+	BeginValue();
+	m_OutputStream << "[";
+	m_HasElementsStack.push_back(false);
+}
+
+void JsonWriter::EndArray()
+{
+	assert(!m_HasElementsStack.empty() && !m_AfterKey);
+	const bool hasElements = m_HasElementsStack.back();
+	m_HasElementsStack.pop_back();
+
+	if (hasElements)
+	{
+		m_OutputStream << "\n";
+		WriteIndent();
+	}
+	m_OutputStream << "]";
+}
+
+void JsonWriter::WriteKey(const char* pKey)
+{
+	assert(!m_HasElementsStack.empty() && !m_AfterKey);
+	
+	// Keys are identifiers chosen by the caller, so they are not escaped.
+	BeginValue();
+	m_OutputStream << "\"" << pKey << "\": ";
+	m_AfterKey = true;
+}
+
+void JsonWriter::WriteString(const char* pValue)
+{
+	BeginValue();
+
+	m_OutputStream << "\"";
+	for (const char* pChar = pValue; *pChar != '\0'; ++pChar)
+	{
+		switch (*pChar)
+		{
+			case '"': m_OutputStream << "\\\""; break;
+			case '\\': m_OutputStream << "\\\\"; break;
+			case '\n': m_OutputStream << "\\n"; break;
+			case '\r': m_OutputStream << "\\r"; break;
+			case '\t': m_OutputStream << "\\t"; break;
+			default:
+			{
+				if (u8(*pChar) < 0x20)
+				{
+					char escapedChar[8];
+					std::snprintf(escapedChar, sizeof(escapedChar), "\\u%04x", u32(u8(*pChar)));
+					m_OutputStream << escapedChar;
+				}
+				else
+				{
+					m_OutputStream << *pChar;
+				}
+			}
+		}
+	}
+	m_OutputStream << "\"";
+}
+
+void JsonWriter::WriteBool(bool value)
+{
+	BeginValue();
+	m_OutputStream << (value ? "true" : "false");
+}
+
+void JsonWriter::WriteU64(u64 value)
+{
+	BeginValue();
+	m_OutputStream << value;
+}
+
+void JsonWriter::WriteF64(f64 value)
+{
+	if (!std::isfinite(value))
+	{
+		WriteNull();
+		return;
+	}
+
+	BeginValue();
+
+	char valueString[32];
+	std::snprintf(valueString, sizeof(valueString), "%.9g", value);
+	m_OutputStream << valueString;
+}
+
+void JsonWriter::WriteNull()
+{
+	BeginValue();
+	m_OutputStream << "null";
+}
+
+void JsonWriter::BeginValue()
+{
+	if (m_AfterKey)
+	{
+		m_AfterKey = false;
+		return;
+	}
+	if (m_HasElementsStack.empty())
+		return;
+
+	if (m_HasElementsStack.back())
+		m_OutputStream << ",";
+	m_HasElementsStack.back() = true;
+
+	m_OutputStream << "\n";
+	WriteIndent();
+}
+
+void JsonWriter::WriteIndent()
+{
+	for (std::size_t level = 0; level < m_HasElementsStack.size(); ++level)
+		m_OutputStream << "  ";
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Common/Common.h"
+
+// Streaming writer of indented JSON. Commas between the members and the elements are inserted by the writer.
+class JsonWriter
+{
+public:
+	JsonWriter(std::ostream& outputStream);
+
+	void BeginObject();
+	void EndObject();
+
+	void BeginArray();
+	void EndArray();
+
+	// Starts an object member. The next call writes its value.
+	void WriteKey(const char* pKey);
+
+	void WriteString(const char* pValue);
+	void WriteBool(bool value);
+	void WriteU64(u64 value);
+	// Non-finite numbers are not representable in JSON and are written as null.
+	void WriteF64(f64 value);
+	void WriteNull();
+
+	template <typename T>
+	void WriteMember(const char* pKey, T value)
+	{
+		WriteKey(pKey);
+		WriteValue(value);
+	}
+
+private:
+	void WriteValue(const char* pValue) { WriteString(pValue); }
+	void WriteValue(bool value) { WriteBool(value); }
+	void WriteValue(u32 value) { WriteU64(value); }
+	void WriteValue(u64 value) { WriteU64(value); }
+	void WriteValue(f32 value) { WriteF64(value); }
+	void WriteValue(f64 value) { WriteF64(value); }
+
+	void BeginValue();
+	void WriteIndent();
+
+private:
+	std::ostream& m_OutputStream;
+	// For each open object or array, whether it has any members or elements yet.
+	std::vector<bool> m_HasElementsStack;
+	bool m_AfterKey = false;
+};
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "LoaderComparison.h"
+#include "Scene/Scene.h"
+#include "Scene/MeshBatch.h"
+#include "Common/StringUtilities.h"
+#include "Math/Math.h"
+
+namespace
+{
+	template <typename T>
+	void CompareTotal(const std::string& name, T referenceValue, T testedValue, std::vector<std::string>* pDifferences);
+
+	u64 FindNumTriangles(const LoadedSceneSummary& summary, const std::string& materialName);
+	bool AreBoundsEqual(const AxisAlignedBox& referenceBounds, const AxisAlignedBox& testedBounds, f32 epsilon);
+	const std::string ToString(const AxisAlignedBox& bounds);
+}
+
+const LoadedSceneSummary SummarizeLoadedScene(Scene* pScene)
+{
+	LoadedSceneSummary summary;
+	summary.m_NumMeshBatches = u32(pScene->GetNumMeshBatches());
+	summary.m_WorldBounds = pScene->GetWorldBounds();
+
+	// Slots of removed materials are nullptr.
+	for (u32 materialID = 0; materialID < pScene->GetNumMaterials(); ++materialID)
+	{
+		if (pScene->GetMaterials()[materialID] != nullptr)
+			++summary.m_NumMaterials;
+	}
+
+	for (u32 meshBatchIndex = 0; meshBatchIndex < pScene->GetNumMeshBatches(); ++meshBatchIndex)
+	{
+		const MeshBatch* pMeshBatch = pScene->GetMeshBatches()[meshBatchIndex];
+		summary.m_NumMeshes += pMeshBatch->GetNumMeshes();
+		summary.m_NumInstances += pMeshBatch->GetNumMeshInstances();
+		summary.m_NumVertices += pMeshBatch->GetNumVertices();
+		summary.m_NumTriangles += pMeshBatch->GetNumIndices() / 3;
+
+		for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+		{
+			const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+			const Material* pMaterial = pScene->GetMaterials()[meshInfo.m_MaterialID];
+			assert(pMaterial != nullptr);
+
+			const std::string materialName = WideToAnsiString(pMaterial->m_Name.c_str());
+			summary.m_NumTrianglesPerMaterial[materialName] += u64(meshInfo.m_IndexCount / 3) * meshInfo.m_InstanceCount;
+		}
+	}
+	return summary;
+}
+
+const LoaderComparison CompareLoadedScenes(Scene* pReferenceScene, Scene* pTestedScene, f32 boundsEpsilon)
+{
+	LoaderComparison comparison;
+	comparison.m_ReferenceSummary = SummarizeLoadedScene(pReferenceScene);
+	comparison.m_TestedSummary = SummarizeLoadedScene(pTestedScene);
+
+	const LoadedSceneSummary& reference = comparison.m_ReferenceSummary;
+	const LoadedSceneSummary& tested = comparison.m_TestedSummary;
+	std::vector<std::string>* pDifferences = &comparison.m_Differences;
+
+	CompareTotal("numMeshBatches", reference.m_NumMeshBatches, tested.m_NumMeshBatches, pDifferences);
+	CompareTotal("numMeshes", reference.m_NumMeshes, tested.m_NumMeshes, pDifferences);
+	CompareTotal("numInstances", reference.m_NumInstances, tested.m_NumInstances, pDifferences);
+	CompareTotal("numVertices", reference.m_NumVertices, tested.m_NumVertices, pDifferences);
+	CompareTotal("numTriangles", reference.m_NumTriangles, tested.m_NumTriangles, pDifferences);
+	CompareTotal("numMaterials", reference.m_NumMaterials, tested.m_NumMaterials, pDifferences);
+
+	if (!AreBoundsEqual(reference.m_WorldBounds, tested.m_WorldBounds, boundsEpsilon))
+		pDifferences->push_back("worldBounds: " + ToString(reference.m_WorldBounds) + " vs " + ToString(tested.m_WorldBounds));
+
+	// A material used by one of the scenes only is reported with zero triangles in the other.
+	std::map<std::string, u64> materialNames = reference.m_NumTrianglesPerMaterial;
+	materialNames.insert(tested.m_NumTrianglesPerMaterial.cbegin(), tested.m_NumTrianglesPerMaterial.cend());
+
+	for (const auto& material : materialNames)
+	{
+		CompareTotal("numTriangles[" + material.first + "]", FindNumTriangles(reference, material.first),
+			FindNumTriangles(tested, material.first), pDifferences);
+	}
+	return comparison;
+}
+
+namespace
+{
+	template <typename T>
+	void CompareTotal(const std::string& name, T referenceValue, T testedValue, std::vector<std::string>* pDifferences)
+	{
+		if (referenceValue != testedValue)
+			pDifferences->push_back(name + ": " + std::to_string(referenceValue) + " vs " + std::to_string(testedValue));
+	}
+
+	u64 FindNumTriangles(const LoadedSceneSummary& summary, const std::string& materialName)
+	{
+		const auto it = summary.m_NumTrianglesPerMaterial.find(materialName);
+		return (it != summary.m_NumTrianglesPerMaterial.cend()) ? it->second : 0;
+	}
+
+	bool AreBoundsEqual(const AxisAlignedBox& referenceBounds, const AxisAlignedBox& testedBounds, f32 epsilon)
+	{
+		const Vector3f referenceSize = 2.0f * referenceBounds.m_Radius;
+		const f32 maxDistance = epsilon * Max(referenceSize.m_X, Max(referenceSize.m_Y, referenceSize.m_Z));
+
+		const Vector3f centerDistance = Abs(referenceBounds.m_Center - testedBounds.m_Center);
+		const Vector3f radiusDistance = Abs(referenceBounds.m_Radius - testedBounds.m_Radius);
+
+		return (Max(centerDistance.m_X, Max(centerDistance.m_Y, centerDistance.m_Z)) <= maxDistance) &&
+			(Max(radiusDistance.m_X, Max(radiusDistance.m_Y, radiusDistance.m_Z)) <= maxDistance);
+	}
+
+	const std::string ToString(const AxisAlignedBox& bounds)
+	{
+		const Vector3f minPoint = bounds.m_Center - bounds.m_Radius;
+		const Vector3f maxPoint = bounds.m_Center + bounds.m_Radius;
+
+		return "{" + std::to_string(minPoint.m_X) + ", " + std::to_string(minPoint.m_Y) + ", " + std::to_string(minPoint.m_Z) + "} - {" +
+			std::to_string(maxPoint.m_X) + ", " + std::to_string(maxPoint.m_Y) + ", " + std::to_string(maxPoint.m_Z) + "}";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Math/AxisAlignedBox.h"
+#include <map>
+
+class Scene;
+
+// Totals of the scene content which should not depend on the loader that produced it.
+struct LoadedSceneSummary
+{
+	u32 m_NumMeshBatches = 0;
+	u32 m_NumMeshes = 0;
+	u32 m_NumInstances = 0;
+	u64 m_NumVertices = 0;
+	u64 m_NumTriangles = 0;
+	u32 m_NumMaterials = 0;
+	AxisAlignedBox m_WorldBounds;
+	// Instanced triangles per material name, which do not depend on how the meshes are split or merged.
+	std::map<std::string, u64> m_NumTrianglesPerMaterial;
+};
+
+struct LoaderComparison
+{
+	LoadedSceneSummary m_ReferenceSummary;
+	LoadedSceneSummary m_TestedSummary;
+	// One entry per total which differs. Empty if the scenes match.
+	std::vector<std::string> m_Differences;
+};
+
+const LoadedSceneSummary SummarizeLoadedScene(Scene* pScene);
+
+// Compares the scene loaded by a native loader with the same scene loaded by Assimp.
+// World bounds match if each coordinate differs by at most the epsilon times the size of the reference bounds.
+// Vertex counts are compared as is, although a different welding or normal smoothing changes them legitimately.
+const LoaderComparison CompareLoadedScenes(Scene* pReferenceScene, Scene* pTestedScene, f32 boundsEpsilon = 1e-4f);
\ No newline at end of file
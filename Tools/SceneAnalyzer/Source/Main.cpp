@@ -0,0 +1,668 @@
+#include "JsonWriter.h"
+#include "OverdrawAnalysis.h"
+#include "ClusterCullingAnalysis.h"
+#include "LoaderComparison.h"
+#include "HeatMap.h"
+#include "Scene/SceneStats.h"
+#include "Scene/SceneLoader.h"
+#include "Scene/CookedScene.h"
+#include "Scene/ProceduralScene.h"
+#include "Scene/MeshInstancing.h"
+#include "Scene/VertexCompression.h"
+#include "Scene/Mesh.h"
+#include "Scene/Scene.h"
+#include "Common/StringUtilities.h"
+
+namespace
+{
+	struct AnalyzerParams
+	{
+		std::string m_SceneName;
+		std::string m_OutputFilePath;
+		u32 m_Seed = 1;
+		bool m_WriteMeshStats = true;
+		SceneStatsParams m_SceneStatsParams;
+		MeshMergingParams m_MeshMergingParams;
+		MeshProcessingParams m_MeshProcessingParams;
+		DynamicObjectParams m_DynamicObjectParams;
+		bool m_CompareWithAssimp = false;
+
+		bool m_AnalyzeOverdraw = false;
+		bool m_AnalyzeClusterCulling = false;
+		u32 m_NumSampledViewpoints = 8;
+		std::string m_ViewpointFilePath;
+		std::string m_HeatMapDirectoryPath;
+		u32 m_MaxHeatMapValue = 8;
+		OverdrawParams m_OverdrawParams;
+	};
+
+	void PrintUsage();
+	Scene* LoadScene(const AnalyzerParams& params);
+	bool WriteHeatMaps(const AnalyzerParams& params, const OverdrawStats& overdrawStats);
+	void WriteSceneStats(const AnalyzerParams& params, const SceneStats& sceneStats, const OverdrawStats* pOverdrawStats,
+		const ClusterCullingStats* pClusterCullingStats, const LoaderComparison* pLoaderComparison, std::ostream& outputStream);
+	void WriteLoaderComparison(const LoaderComparison& loaderComparison, JsonWriter* pWriter);
+	void WriteLoadedSceneSummary(const LoadedSceneSummary& summary, JsonWriter* pWriter);
+	void WriteOverdrawStats(const AnalyzerParams& params, const OverdrawStats& overdrawStats, JsonWriter* pWriter);
+	void WriteClusterCullingStats(const ClusterCullingStats& clusterCullingStats, JsonWriter* pWriter);
+	void WriteMeshBatchStats(const MeshBatchStats& batchStats, bool writeMeshStats, JsonWriter* pWriter);
+	void WriteMeshStats(const MeshStats& meshStats, JsonWriter* pWriter);
+	void WriteVertexCacheStats(const VertexCacheStats& stats, JsonWriter* pWriter);
+	void WriteStreamSizes(const u64* pStreamSizesInBytes, JsonWriter* pWriter);
+	void WriteVector3(const Vector3f& vec, JsonWriter* pWriter);
+	f64 CalcVolumeRatio(f32 volume, f32 aabbVolume);
+	f64 CalcRatio(u64 numerator, u64 denominator);
+	const std::string GetHeatMapFileName(u32 viewpointIndex, const char* pSuffix);
+}
+
+// Usage: SceneAnalyzer <sponza | livingroom | procedural | file.glb | file.gltf | file.cookedscene>
+//                      [-out path] [-cachesize N] [-seed N] [-nomeshes] [-merge maxBoundsSize] [-native] [-objloader] [-smoothangle degrees] [-tangents]
+//                      [-filemeshorder] [-dynamic prefix]... [-compare]
+//                      [-overdraw] [-clusters] [-viewpoints N] [-viewpointfile path] [-width N] [-height N] [-heatmaps directory] [-heatmapmax N]
+// Writes the statistics of the scene geometry as JSON to the output file or to the standard output.
+// With -merge, static meshes of OBJ scenes are merged up to the given bounds size (see MeshMergingParams).
+// With -native, OBJ scenes are welded and missing normals are generated by the native processing instead of Assimp,
+// smoothing up to the -smoothangle, and -tangents adds tangents to the vertex format (see MeshProcessingParams).
+// With -objloader, OBJ files are also read by the native loader, which implies -native.
+// With -filemeshorder, the meshes of OBJ and glTF scenes keep the file order instead of being sorted by Morton code.
+// Instances of the meshes whose name starts with a -dynamic prefix are loaded as dynamic.
+// With -compare, sponza and livingroom are loaded by Assimp as well, which requires -native or -objloader,
+// and the mesh, instance, vertex, triangle and material counts and the world bounds of the two scenes are compared.
+// With -overdraw, the scene is also rasterized on the CPU from the scene camera and the sampled viewpoints,
+// or from the viewpoints recorded in the file (see LoadViewpoints), and the overdraw statistics are added.
+// Heat maps of each viewpoint are written to the directory if it is given.
+// With -clusters, the mesh clusters are culled by bounds and normal cone from the same viewpoints,
+// and the tested, culled and visible cluster and triangle counts are added.
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	AnalyzerParams params;
+	params.m_SceneName = argv[1];
+
+	for (int argIndex = 2; argIndex < argc; ++argIndex)
+	{
+		const char* pArgName = argv[argIndex];
+		if (AreEqual(pArgName, "-nomeshes"))
+		{
+			params.m_WriteMeshStats = false;
+			continue;
+		}
+		if (AreEqual(pArgName, "-overdraw"))
+		{
+			params.m_AnalyzeOverdraw = true;
+			continue;
+		}
+		if (AreEqual(pArgName, "-clusters"))
+		{
+			params.m_AnalyzeClusterCulling = true;
+			continue;
+		}
+		if (AreEqual(pArgName, "-native"))
+		{
+			params.m_MeshProcessingParams.m_UseNativeProcessing = true;
+			continue;
+		}
+		if (AreEqual(pArgName, "-objloader"))
+		{
+			params.m_MeshProcessingParams.m_UseNativeProcessing = true;
+			params.m_MeshProcessingParams.m_UseNativeObjLoader = true;
+			continue;
+		}
+		if (AreEqual(pArgName, "-tangents"))
+		{
+			params.m_MeshProcessingParams.m_GenerateTangents = true;
+			continue;
+		}
+		if (AreEqual(pArgName, "-filemeshorder"))
+		{
+			params.m_MeshProcessingParams.m_SortMeshesByMortonCode = false;
+			continue;
+		}
+		if (AreEqual(pArgName, "-compare"))
+		{
+			params.m_CompareWithAssimp = true;
+			continue;
+		}
+		if (argIndex + 1 == argc)
+		{
+			PrintUsage();
+			return 1;
+		}
+		const char* pArgValue = argv[++argIndex];
+
+		if (AreEqual(pArgName, "-out"))
+			params.m_OutputFilePath = pArgValue;
+		else if (AreEqual(pArgName, "-cachesize"))
+			params.m_SceneStatsParams.m_VertexCacheSize = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-merge"))
+		{
+			params.m_MeshMergingParams.m_Enabled = true;
+			params.m_MeshMergingParams.m_MaxBoundsSize = std::strtof(pArgValue, nullptr);
+		}
+		else if (AreEqual(pArgName, "-smoothangle"))
+			params.m_MeshProcessingParams.m_MaxSmoothingAngleInDegrees = std::strtof(pArgValue, nullptr);
+		else if (AreEqual(pArgName, "-dynamic"))
+			params.m_DynamicObjectParams.m_NamePrefixes.emplace_back(pArgValue);
+		else if (AreEqual(pArgName, "-seed"))
+			params.m_Seed = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-viewpoints"))
+			params.m_NumSampledViewpoints = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-viewpointfile"))
+			params.m_ViewpointFilePath = pArgValue;
+		else if (AreEqual(pArgName, "-width"))
+			params.m_OverdrawParams.m_Width = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-height"))
+			params.m_OverdrawParams.m_Height = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-heatmaps"))
+			params.m_HeatMapDirectoryPath = pArgValue;
+		else if (AreEqual(pArgName, "-heatmapmax"))
+			params.m_MaxHeatMapValue = std::strtoul(pArgValue, nullptr, 10);
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	const bool validParams = (params.m_SceneStatsParams.m_VertexCacheSize > 0) && (params.m_MeshMergingParams.m_MaxBoundsSize > 0.0f) &&
+		(params.m_MeshProcessingParams.m_MaxSmoothingAngleInDegrees >= 0.0f) && (params.m_MeshProcessingParams.m_MaxSmoothingAngleInDegrees <= 180.0f) &&
+		(params.m_OverdrawParams.m_Width > 0) && (params.m_OverdrawParams.m_Height > 0) && (params.m_MaxHeatMapValue > 0) &&
+		(!params.m_CompareWithAssimp || (params.m_MeshProcessingParams.m_UseNativeProcessing && ((params.m_SceneName == "sponza") || (params.m_SceneName == "livingroom"))));
+	if (!validParams)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Scene* pScene = LoadScene(params);
+	if (pScene == nullptr)
+	{
+		std::cerr << "Failed to load " << params.m_SceneName << std::endl;
+		return 1;
+	}
+
+	const SceneStats sceneStats = AnalyzeScene(pScene, params.m_SceneStatsParams);
+
+	LoaderComparison loaderComparison;
+	if (params.m_CompareWithAssimp)
+	{
+		AnalyzerParams referenceParams = params;
+		referenceParams.m_MeshProcessingParams.m_UseNativeProcessing = false;
+		referenceParams.m_MeshProcessingParams.m_UseNativeObjLoader = false;
+
+		Scene* pReferenceScene = LoadScene(referenceParams);
+		if (pReferenceScene == nullptr)
+		{
+			std::cerr << "Failed to load " << params.m_SceneName << " with Assimp" << std::endl;
+			return 1;
+		}
+		loaderComparison = CompareLoadedScenes(pReferenceScene, pScene);
+		SafeDelete(pReferenceScene);
+	}
+
+	std::vector<Viewpoint> viewpoints;
+	if (params.m_AnalyzeOverdraw || params.m_AnalyzeClusterCulling)
+	{
+		if (params.m_ViewpointFilePath.empty())
+		{
+			SampleViewpoints(pScene, params.m_NumSampledViewpoints, params.m_Seed, &viewpoints);
+		}
+		else if (!LoadViewpoints(params.m_ViewpointFilePath.c_str(), &viewpoints))
+		{
+			std::cerr << "Failed to load viewpoints from " << params.m_ViewpointFilePath << std::endl;
+			return 1;
+		}
+	}
+
+	OverdrawStats overdrawStats;
+	if (params.m_AnalyzeOverdraw)
+	{
+		const bool keepPixelStats = !params.m_HeatMapDirectoryPath.empty();
+		overdrawStats = AnalyzeOverdraw(pScene, viewpoints, params.m_OverdrawParams, keepPixelStats);
+
+		if (keepPixelStats && !WriteHeatMaps(params, overdrawStats))
+		{
+			std::cerr << "Failed to write heat maps to " << params.m_HeatMapDirectoryPath << std::endl;
+			return 1;
+		}
+	}
+
+	ClusterCullingStats clusterCullingStats;
+	if (params.m_AnalyzeClusterCulling)
+		clusterCullingStats = AnalyzeClusterCulling(pScene, viewpoints, params.m_OverdrawParams);
+	
+	SafeDelete(pScene);
+
+	const OverdrawStats* pOverdrawStats = params.m_AnalyzeOverdraw ? &overdrawStats : nullptr;
+	const ClusterCullingStats* pClusterCullingStats = params.m_AnalyzeClusterCulling ? &clusterCullingStats : nullptr;
+	const LoaderComparison* pLoaderComparison = params.m_CompareWithAssimp ? &loaderComparison : nullptr;
+	if (params.m_OutputFilePath.empty())
+	{
+		WriteSceneStats(params, sceneStats, pOverdrawStats, pClusterCullingStats, pLoaderComparison, std::cout);
+	}
+	else
+	{
+		std::ofstream outputFile(params.m_OutputFilePath);
+		if (!outputFile)
+		{
+			std::cerr << "Failed to open " << params.m_OutputFilePath << std::endl;
+			return 1;
+		}
+		WriteSceneStats(params, sceneStats, pOverdrawStats, pClusterCullingStats, pLoaderComparison, outputFile);
+	}
+
+	return 0;
+}
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cerr << "Usage: SceneAnalyzer <sponza | livingroom | procedural | file.glb | file.gltf | file.cookedscene>"
+			" [-out path] [-cachesize N] [-seed N] [-nomeshes] [-merge maxBoundsSize] [-native] [-objloader] [-smoothangle degrees] [-tangents] [-filemeshorder] [-dynamic prefix]... [-compare]"
+			" [-overdraw] [-clusters] [-viewpoints N] [-viewpointfile path] [-width N] [-height N] [-heatmaps directory] [-heatmapmax N]" << std::endl;
+	}
+
+	Scene* LoadScene(const AnalyzerParams& params)
+	{
+		if (params.m_SceneName == "sponza")
+			return SceneLoader::LoadCrytekSponza(params.m_MeshMergingParams, params.m_MeshProcessingParams, params.m_DynamicObjectParams);
+		
+		if (params.m_SceneName == "livingroom")
+			return SceneLoader::LoadLivingRoom(params.m_MeshMergingParams, params.m_MeshProcessingParams, params.m_DynamicObjectParams);
+		
+		if (params.m_SceneName == "procedural")
+		{
+			ProceduralSceneParams sceneParams;
+			sceneParams.m_Seed = params.m_Seed;
+			return GenerateProceduralScene(sceneParams);
+		}
+
+		const std::wstring filePath = AnsiToWideString(params.m_SceneName.c_str());
+		const std::wstring extension = std::filesystem::path(filePath).extension().wstring();
+
+		if ((extension == L".glb") || (extension == L".gltf"))
+			return SceneLoader::LoadGltfScene(filePath.c_str(), params.m_MeshProcessingParams, params.m_DynamicObjectParams);
+		
+		if (extension == L".cookedscene")
+			return LoadCookedScene(filePath.c_str());
+
+		return nullptr;
+	}
+
+	bool WriteHeatMaps(const AnalyzerParams& params, const OverdrawStats& overdrawStats)
+	{
+		if (FAILED(CoInitializeEx(nullptr, COINITBASE_MULTITHREADED)))
+			return false;
+
+		std::error_code errorCode;
+		std::filesystem::create_directories(params.m_HeatMapDirectoryPath, errorCode);
+		if (errorCode)
+			return false;
+
+		const u32 width = params.m_OverdrawParams.m_Width;
+		const u32 height = params.m_OverdrawParams.m_Height;
+
+		bool result = true;
+		for (u32 viewpointIndex = 0; viewpointIndex < overdrawStats.m_ViewpointStats.size(); ++viewpointIndex)
+		{
+			const ViewpointOverdrawStats& viewpointStats = overdrawStats.m_ViewpointStats[viewpointIndex];
+			const std::pair<const char*, const u16*> heatMaps[] =
+			{
+				{"DepthComplexity", viewpointStats.m_DepthComplexity.data()},
+				{"Overdraw", viewpointStats.m_Overdraw.data()},
+				{"OverdrawSorted", viewpointStats.m_OverdrawSorted.data()},
+				{"HelperLanes", viewpointStats.m_HelperLanes.data()}
+			};
+			for (const auto& heatMap : heatMaps)
+			{
+				const std::filesystem::path filePath = std::filesystem::path(params.m_HeatMapDirectoryPath) / GetHeatMapFileName(viewpointIndex, heatMap.first);
+				result &= WriteHeatMap(filePath.wstring().c_str(), width, height, heatMap.second, params.m_MaxHeatMapValue);
+			}
+		}
+
+		CoUninitialize();
+		return result;
+	}
+
+	void WriteSceneStats(const AnalyzerParams& params, const SceneStats& sceneStats, const OverdrawStats* pOverdrawStats,
+		const ClusterCullingStats* pClusterCullingStats, const LoaderComparison* pLoaderComparison, std::ostream& outputStream)
+	{
+		JsonWriter writer(outputStream);
+		writer.BeginObject();
+
+		writer.WriteMember("scene", params.m_SceneName.c_str());
+		writer.WriteMember("vertexCacheSize", params.m_SceneStatsParams.m_VertexCacheSize);
+		writer.WriteMember("maxNumInstancesPerMesh", kMaxNumInstancesPerMesh);
+		writer.WriteMember("numMaterials", sceneStats.m_NumMaterials);
+		writer.WriteMember("numPointLights", sceneStats.m_NumPointLights);
+		writer.WriteMember("numSpotLights", sceneStats.m_NumSpotLights);
+
+		writer.WriteKey("meshBatches");
+		writer.BeginArray();
+		for (const MeshBatchStats& batchStats : sceneStats.m_MeshBatchStats)
+			WriteMeshBatchStats(batchStats, params.m_WriteMeshStats, &writer);
+		writer.EndArray();
+
+		if (pOverdrawStats != nullptr)
+		{
+			writer.WriteKey("overdraw");
+			WriteOverdrawStats(params, *pOverdrawStats, &writer);
+		}
+
+		if (pClusterCullingStats != nullptr)
+		{
+			writer.WriteKey("clusterCulling");
+			WriteClusterCullingStats(*pClusterCullingStats, &writer);
+		}
+
+		if (pLoaderComparison != nullptr)
+		{
+			writer.WriteKey("loaderComparison");
+			WriteLoaderComparison(*pLoaderComparison, &writer);
+		}
+
+		writer.EndObject();
+	}
+
+	void WriteOverdrawStats(const AnalyzerParams& params, const OverdrawStats& overdrawStats, JsonWriter* pWriter)
+	{
+		pWriter->BeginObject();
+
+		pWriter->WriteMember("width", params.m_OverdrawParams.m_Width);
+		pWriter->WriteMember("height", params.m_OverdrawParams.m_Height);
+		pWriter->WriteMember("cullBackFaces", params.m_OverdrawParams.m_CullBackFaces);
+
+		// Ratios are relative to the covered pixels, so that 1 is the minimum overdraw.
+		// Quad utilization is the fraction of the pixel shader lanes of the shaded quads that shade a pixel.
+		pWriter->WriteKey("viewpoints");
+		pWriter->BeginArray();
+		for (u32 viewpointIndex = 0; viewpointIndex < overdrawStats.m_ViewpointStats.size(); ++viewpointIndex)
+		{
+			const ViewpointOverdrawStats& viewpointStats = overdrawStats.m_ViewpointStats[viewpointIndex];
+			pWriter->BeginObject();
+
+			pWriter->WriteKey("position");
+			WriteVector3(viewpointStats.m_Viewpoint.m_WorldPosition, pWriter);
+			pWriter->WriteKey("forward");
+			WriteVector3(viewpointStats.m_Viewpoint.m_WorldForward, pWriter);
+
+			pWriter->WriteMember("numVisibleInstances", viewpointStats.m_NumVisibleInstances);
+			pWriter->WriteMember("numCoveredPixels", viewpointStats.m_NumCoveredPixels);
+			pWriter->WriteMember("maxDepthComplexity", viewpointStats.m_MaxDepthComplexity);
+			pWriter->WriteMember("avgDepthComplexity", CalcRatio(viewpointStats.m_NumFragments, viewpointStats.m_NumCoveredPixels));
+			pWriter->WriteMember("overdraw", CalcRatio(viewpointStats.m_NumShadedFragments, viewpointStats.m_NumCoveredPixels));
+			pWriter->WriteMember("overdrawSorted", CalcRatio(viewpointStats.m_NumShadedFragmentsSorted, viewpointStats.m_NumCoveredPixels));
+			pWriter->WriteMember("quadUtilization", CalcRatio(viewpointStats.m_NumShadedFragments, 4 * viewpointStats.m_NumShadedQuads));
+
+			if (!params.m_HeatMapDirectoryPath.empty())
+			{
+				pWriter->WriteKey("heatMaps");
+				pWriter->BeginArray();
+				for (const char* pSuffix : {"DepthComplexity", "Overdraw", "OverdrawSorted", "HelperLanes"})
+					pWriter->WriteString(GetHeatMapFileName(viewpointIndex, pSuffix).c_str());
+				pWriter->EndArray();
+			}
+
+			pWriter->EndObject();
+		}
+		pWriter->EndArray();
+
+		// Meshes are listed from the most to the least pixel shader lanes launched in the batch order.
+		std::vector<const MeshOverdrawStats*> sortedMeshStats;
+		for (const MeshOverdrawStats& meshStats : overdrawStats.m_MeshStats)
+			sortedMeshStats.push_back(&meshStats);
+
+		auto hasMoreLanes = [](const MeshOverdrawStats* pMeshStats1, const MeshOverdrawStats* pMeshStats2)
+		{
+			return pMeshStats1->m_NumShadedQuads > pMeshStats2->m_NumShadedQuads;
+		};
+		std::stable_sort(sortedMeshStats.begin(), sortedMeshStats.end(), hasMoreLanes);
+
+		pWriter->WriteKey("meshes");
+		pWriter->BeginArray();
+		for (const MeshOverdrawStats* pMeshStats : sortedMeshStats)
+		{
+			pWriter->BeginObject();
+			pWriter->WriteMember("meshBatch", pMeshStats->m_MeshBatchIndex);
+			pWriter->WriteMember("mesh", pMeshStats->m_MeshIndex);
+			pWriter->WriteMember("materialID", pMeshStats->m_MaterialID);
+			pWriter->WriteMember("numFragments", pMeshStats->m_NumFragments);
+			pWriter->WriteMember("numShadedFragments", pMeshStats->m_NumShadedFragments);
+			pWriter->WriteMember("numShadedFragmentsSorted", pMeshStats->m_NumShadedFragmentsSorted);
+			pWriter->WriteMember("numPixelShaderLanes", 4 * pMeshStats->m_NumShadedQuads);
+			pWriter->WriteMember("quadUtilization", CalcRatio(pMeshStats->m_NumShadedFragments, 4 * pMeshStats->m_NumShadedQuads));
+			pWriter->EndObject();
+		}
+		pWriter->EndArray();
+
+		pWriter->EndObject();
+	}
+
+	void WriteLoaderComparison(const LoaderComparison& loaderComparison, JsonWriter* pWriter)
+	{
+		pWriter->BeginObject();
+
+		pWriter->WriteKey("assimp");
+		WriteLoadedSceneSummary(loaderComparison.m_ReferenceSummary, pWriter);
+		pWriter->WriteKey("native");
+		WriteLoadedSceneSummary(loaderComparison.m_TestedSummary, pWriter);
+
+		pWriter->WriteMember("identical", loaderComparison.m_Differences.empty());
+		pWriter->WriteKey("differences");
+		pWriter->BeginArray();
+		for (const std::string& difference : loaderComparison.m_Differences)
+			pWriter->WriteString(difference.c_str());
+		pWriter->EndArray();
+
+		pWriter->EndObject();
+	}
+
+	void WriteLoadedSceneSummary(const LoadedSceneSummary& summary, JsonWriter* pWriter)
+	{
+		pWriter->BeginObject();
+
+		pWriter->WriteMember("numMeshBatches", summary.m_NumMeshBatches);
+		pWriter->WriteMember("numMeshes", summary.m_NumMeshes);
+		pWriter->WriteMember("numInstances", summary.m_NumInstances);
+		pWriter->WriteMember("numVertices", summary.m_NumVertices);
+		pWriter->WriteMember("numTriangles", summary.m_NumTriangles);
+		pWriter->WriteMember("numMaterials", summary.m_NumMaterials);
+
+		pWriter->WriteKey("worldBoundsMin");
+		WriteVector3(summary.m_WorldBounds.m_Center - summary.m_WorldBounds.m_Radius, pWriter);
+		pWriter->WriteKey("worldBoundsMax");
+		WriteVector3(summary.m_WorldBounds.m_Center + summary.m_WorldBounds.m_Radius, pWriter);
+
+		pWriter->WriteKey("numTrianglesPerMaterial");
+		pWriter->BeginObject();
+		for (const auto& material : summary.m_NumTrianglesPerMaterial)
+			pWriter->WriteMember(material.first.c_str(), material.second);
+		pWriter->EndObject();
+
+		pWriter->EndObject();
+	}
+
+	void WriteClusterCullingStats(const ClusterCullingStats& clusterCullingStats, JsonWriter* pWriter)
+	{
+		pWriter->BeginObject();
+
+		pWriter->WriteMember("numMeshBatchesWithoutClusters", clusterCullingStats.m_NumMeshBatchesWithoutClusters);
+
+		// Ratios are relative to the tested clusters and triangles.
+		pWriter->WriteKey("viewpoints");
+		pWriter->BeginArray();
+		for (const ViewpointClusterCullingStats& viewpointStats : clusterCullingStats.m_ViewpointStats)
+		{
+			pWriter->BeginObject();
+
+			pWriter->WriteKey("position");
+			WriteVector3(viewpointStats.m_Viewpoint.m_WorldPosition, pWriter);
+			pWriter->WriteKey("forward");
+			WriteVector3(viewpointStats.m_Viewpoint.m_WorldForward, pWriter);
+
+			pWriter->WriteMember("numTestedClusters", viewpointStats.m_NumTestedClusters);
+			pWriter->WriteMember("numFrustumCulledClusters", viewpointStats.m_NumFrustumCulledClusters);
+			pWriter->WriteMember("numBackfaceCulledClusters", viewpointStats.m_NumBackfaceCulledClusters);
+			pWriter->WriteMember("numVisibleClusters", viewpointStats.m_NumVisibleClusters);
+			pWriter->WriteMember("visibleClusterRatio", CalcRatio(viewpointStats.m_NumVisibleClusters, viewpointStats.m_NumTestedClusters));
+
+			pWriter->WriteMember("numTestedTriangles", viewpointStats.m_NumTestedTriangles);
+			pWriter->WriteMember("numFrustumCulledTriangles", viewpointStats.m_NumFrustumCulledTriangles);
+			pWriter->WriteMember("numBackfaceCulledTriangles", viewpointStats.m_NumBackfaceCulledTriangles);
+			pWriter->WriteMember("numVisibleTriangles", viewpointStats.m_NumVisibleTriangles);
+			pWriter->WriteMember("visibleTriangleRatio", CalcRatio(viewpointStats.m_NumVisibleTriangles, viewpointStats.m_NumTestedTriangles));
+
+			pWriter->EndObject();
+		}
+		pWriter->EndArray();
+
+		pWriter->EndObject();
+	}
+
+	void WriteMeshBatchStats(const MeshBatchStats& batchStats, bool writeMeshStats, JsonWriter* pWriter)
+	{
+		pWriter->BeginObject();
+
+		pWriter->WriteKey("vertexFormat");
+		pWriter->BeginArray();
+		{
+			const std::pair<u8, const char*> formatFlags[] =
+			{
+				{VertexData::FormatFlag_Position, "Position"},
+				{VertexData::FormatFlag_Normal, "Normal"},
+				{VertexData::FormatFlag_Color, "Color"},
+				{VertexData::FormatFlag_Tangent, "Tangent"},
+				{VertexData::FormatFlag_TexCoords, "TexCoords"}
+			};
+			for (const auto& formatFlag : formatFlags)
+			{
+				if ((batchStats.m_VertexFormatFlags & formatFlag.first) != 0)
+					pWriter->WriteString(formatFlag.second);
+			}
+		}
+		pWriter->EndArray();
+
+		pWriter->WriteKey("vertexCompression");
+		pWriter->BeginArray();
+		{
+			const std::pair<u8, const char*> compressionFlags[] =
+			{
+				{VertexCompressionFlag_Position, "Position"},
+				{VertexCompressionFlag_Normal, "Normal"},
+				{VertexCompressionFlag_Tangent, "Tangent"},
+				{VertexCompressionFlag_TexCoords, "TexCoords"}
+			};
+			for (const auto& compressionFlag : compressionFlags)
+			{
+				if ((batchStats.m_VertexCompressionFlags & compressionFlag.first) != 0)
+					pWriter->WriteString(compressionFlag.second);
+			}
+		}
+		pWriter->EndArray();
+
+		pWriter->WriteMember("indexStrideInBytes", batchStats.m_IndexStrideInBytes);
+		pWriter->WriteMember("numMeshes", u32(batchStats.m_MeshStats.size()));
+		pWriter->WriteMember("numVertices", batchStats.m_NumVertices);
+		pWriter->WriteMember("numTriangles", batchStats.m_NumTriangles);
+		pWriter->WriteMember("numInstances", batchStats.m_NumInstances);
+		pWriter->WriteMember("numDynamicInstances", batchStats.m_NumDynamicInstances);
+		WriteVertexCacheStats(batchStats.m_VertexCacheStats, pWriter);
+		pWriter->WriteMember("numDegenerateTriangles", batchStats.m_NumDegenerateTriangles);
+		pWriter->WriteMember("numZeroAreaTriangles", batchStats.m_NumZeroAreaTriangles);
+		pWriter->WriteMember("numDuplicateVertices", batchStats.m_NumDuplicateVertices);
+		pWriter->WriteMember("numDuplicateMeshes", batchStats.m_NumDuplicateMeshes);
+		pWriter->WriteMember("duplicateMeshSizeInBytes", batchStats.m_DuplicateMeshSizeInBytes);
+		pWriter->WriteMember("maxNumInstancesPerMesh", batchStats.m_MaxNumInstancesPerMesh);
+		pWriter->WriteMember("numSingleInstanceMeshes", batchStats.m_NumSingleInstanceMeshes);
+		pWriter->WriteMember("numMeshesAtInstanceLimit", batchStats.m_NumMeshesAtInstanceLimit);
+		WriteStreamSizes(batchStats.m_StreamSizesInBytes, pWriter);
+		pWriter->WriteMember("gpuVertexSizeInBytes", batchStats.m_GPUVertexSizeInBytes);
+
+		if (writeMeshStats)
+		{
+			pWriter->WriteKey("meshes");
+			pWriter->BeginArray();
+			for (const MeshStats& meshStats : batchStats.m_MeshStats)
+				WriteMeshStats(meshStats, pWriter);
+			pWriter->EndArray();
+		}
+
+		pWriter->EndObject();
+	}
+
+	void WriteMeshStats(const MeshStats& meshStats, JsonWriter* pWriter)
+	{
+		pWriter->BeginObject();
+
+		pWriter->WriteMember("materialID", meshStats.m_MaterialID);
+		pWriter->WriteMember("numVertices", meshStats.m_NumVertices);
+		pWriter->WriteMember("numTriangles", meshStats.m_NumTriangles);
+		pWriter->WriteMember("numInstances", meshStats.m_NumInstances);
+		WriteVertexCacheStats(meshStats.m_VertexCacheStats, pWriter);
+		pWriter->WriteMember("numDegenerateTriangles", meshStats.m_NumDegenerateTriangles);
+		pWriter->WriteMember("numZeroAreaTriangles", meshStats.m_NumZeroAreaTriangles);
+		pWriter->WriteMember("numDuplicateVertices", meshStats.m_NumDuplicateVertices);
+
+		pWriter->WriteKey("duplicateOfMesh");
+		if (meshStats.m_DuplicateOfMeshIndex != kNotDuplicateMesh)
+			pWriter->WriteU64(meshStats.m_DuplicateOfMeshIndex);
+		else
+			pWriter->WriteNull();
+
+		pWriter->WriteMember("aabbVolume", meshStats.m_AABBVolume);
+		pWriter->WriteMember("obbVolume", meshStats.m_OBBVolume);
+		pWriter->WriteMember("sphereVolume", meshStats.m_SphereVolume);
+		pWriter->WriteMember("obbToAABBVolumeRatio", CalcVolumeRatio(meshStats.m_OBBVolume, meshStats.m_AABBVolume));
+		pWriter->WriteMember("sphereToAABBVolumeRatio", CalcVolumeRatio(meshStats.m_SphereVolume, meshStats.m_AABBVolume));
+		WriteStreamSizes(meshStats.m_StreamSizesInBytes, pWriter);
+
+		pWriter->EndObject();
+	}
+
+	void WriteVertexCacheStats(const VertexCacheStats& stats, JsonWriter* pWriter)
+	{
+		pWriter->WriteMember("acmr", stats.m_ACMR);
+		pWriter->WriteMember("atvr", stats.m_ATVR);
+		pWriter->WriteMember("numTransformedVertices", stats.m_NumTransformedVertices);
+		pWriter->WriteMember("numReferencedVertices", stats.m_NumReferencedVertices);
+	}
+
+	void WriteStreamSizes(const u64* pStreamSizesInBytes, JsonWriter* pWriter)
+	{
+		pWriter->WriteKey("streamSizesInBytes");
+		pWriter->BeginObject();
+		for (u32 stream = 0; stream < kNumMeshStreams; ++stream)
+			pWriter->WriteMember(GetMeshStreamName(MeshStream(stream)), pStreamSizesInBytes[stream]);
+		pWriter->EndObject();
+	}
+
+	void WriteVector3(const Vector3f& vec, JsonWriter* pWriter)
+	{
+		pWriter->BeginArray();
+		pWriter->WriteF64(vec.m_X);
+		pWriter->WriteF64(vec.m_Y);
+		pWriter->WriteF64(vec.m_Z);
+		pWriter->EndArray();
+	}
+
+	// Flat meshes have no AABB volume, in which case the ratio is written as null.
+	f64 CalcVolumeRatio(f32 volume, f32 aabbVolume)
+	{
+		return (aabbVolume > 0.0f) ? f64(volume) / f64(aabbVolume) : std::numeric_limits<f64>::quiet_NaN();
+	}
+
+	f64 CalcRatio(u64 numerator, u64 denominator)
+	{
+		return (denominator > 0) ? f64(numerator) / f64(denominator) : std::numeric_limits<f64>::quiet_NaN();
+	}
+
+	const std::string GetHeatMapFileName(u32 viewpointIndex, const char* pSuffix)
+	{
+		return "Viewpoint" + std::to_string(viewpointIndex) + pSuffix + ".png";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,536 @@
+#include "OverdrawAnalysis.h"
+#include "Scene/Scene.h"
+#include "Scene/Camera.h"
+#include "Common/ParallelFor.h"
+#include "Math/Frustum.h"
+#include "Math/OverlapTest.h"
+#include "Math/Transform.h"
+#include "Math/Random.h"
+
+namespace
+{
+	struct RasterCounters
+	{
+		u64 m_NumFragments = 0;
+		u64 m_NumShadedFragments = 0;
+		u64 m_NumShadedQuads = 0;
+	};
+
+	struct DrawItem
+	{
+		u32 m_MeshBatchIndex;
+		u32 m_MeshIndex;
+		u32 m_InstanceIndex;
+		// Index of the mesh across all the mesh batches.
+		u32 m_SceneMeshIndex;
+		f32 m_SqDistanceToCamera;
+	};
+
+	struct ScreenVertex
+	{
+		f32 m_X;
+		f32 m_Y;
+		f32 m_Depth;
+	};
+
+	class Rasterizer
+	{
+	public:
+		Rasterizer(u32 width, u32 height, bool cullBackFaces);
+
+		// Clears the depth buffer and sets the per pixel counters the following draws increment. Any of them can be null.
+		void Reset(u16* pFragmentCounts, u16* pShadedCounts, u16* pHelperLaneCounts);
+
+		void DrawMesh(const MeshBatch* pMeshBatch, u32 meshIndex, const Matrix4f& worldViewProjMatrix, RasterCounters* pCounters);
+
+	private:
+		void DrawTriangle(const Vector4f& clipPosition0, const Vector4f& clipPosition1, const Vector4f& clipPosition2, RasterCounters* pCounters);
+		void RasterizeTriangle(const ScreenVertex& vertex0, const ScreenVertex& vertex1, const ScreenVertex& vertex2, RasterCounters* pCounters);
+		const ScreenVertex ProjectToScreen(const Vector4f& clipPosition) const;
+
+	private:
+		u32 m_Width;
+		u32 m_Height;
+		bool m_CullBackFaces;
+
+		std::vector<f32> m_DepthBuffer;
+		std::vector<Vector4f> m_ClipPositions;
+		
+		u16* m_pFragmentCounts = nullptr;
+		u16* m_pShadedCounts = nullptr;
+		u16* m_pHelperLaneCounts = nullptr;
+	};
+
+	void AnalyzeViewpoint(Scene* pScene, const Matrix4f& viewProjMatrix, const Vector3f& cameraWorldPosition, const OverdrawParams& params,
+		bool keepPixelStats, ViewpointOverdrawStats* pViewpointStats, std::vector<MeshOverdrawStats>* pMeshStats);
+	
+	void IncrementSaturated(u16* pCounts, u32 pixelIndex);
+}
+
+void SampleViewpoints(Scene* pScene, u32 numViewpoints, u32 seed, std::vector<Viewpoint>* pViewpoints)
+{
+	pViewpoints->clear();
+	pViewpoints->reserve(numViewpoints + 1);
+
+	const Camera* pCamera = pScene->GetCamera();
+	if (pCamera != nullptr)
+		pViewpoints->push_back({pCamera->GetWorldPosition(), pCamera->GetWorldOrientation().m_ZAxis});
+
+	Random random(seed, 0/*streamIndex*/);
+
+	// Viewpoints are kept away from the bounds, where there is usually little to see.
+	const AxisAlignedBox& worldBounds = pScene->GetWorldBounds();
+	const Vector3f sampledRadius = 0.8f * worldBounds.m_Radius;
+
+	for (u32 viewpointIndex = 0; viewpointIndex < numViewpoints; ++viewpointIndex)
+	{
+		const Vector3f offset(random.NextFloat(-sampledRadius.m_X, sampledRadius.m_X),
+			random.NextFloat(-sampledRadius.m_Y, sampledRadius.m_Y),
+			random.NextFloat(-sampledRadius.m_Z, sampledRadius.m_Z));
+		const f32 yawAngle = random.NextFloat(0.0f, TWO_PI);
+
+		pViewpoints->push_back({worldBounds.m_Center + offset, Vector3f(std::sin(yawAngle), 0.0f, std::cos(yawAngle))});
+	}
+}
+
+bool LoadViewpoints(const char* pFilePath, std::vector<Viewpoint>* pViewpoints)
+{
+	std::ifstream file(pFilePath);
+	if (!file)
+		return false;
+
+	pViewpoints->clear();
+	
+	std::string line;
+	while (std::getline(file, line))
+	{
+		const std::size_t firstCharPos = line.find_first_not_of(" \t\r");
+		if ((firstCharPos == std::string::npos) || (line[firstCharPos] == '#'))
+			continue;
+
+		Viewpoint viewpoint;
+		std::istringstream lineStream(line);
+		lineStream >> viewpoint.m_WorldPosition.m_X >> viewpoint.m_WorldPosition.m_Y >> viewpoint.m_WorldPosition.m_Z;
+		lineStream >> viewpoint.m_WorldForward.m_X >> viewpoint.m_WorldForward.m_Y >> viewpoint.m_WorldForward.m_Z;
+
+		if (lineStream.fail() || (LengthSquared(viewpoint.m_WorldForward) == 0.0f))
+			return false;
+
+		viewpoint.m_WorldForward = Normalize(viewpoint.m_WorldForward);
+		pViewpoints->push_back(viewpoint);
+	}
+	return true;
+}
+
+const OverdrawStats AnalyzeOverdraw(Scene* pScene, const std::vector<Viewpoint>& viewpoints, const OverdrawParams& params, bool keepPixelStats)
+{
+	assert((params.m_Width > 0) && (params.m_Height > 0));
+
+	std::vector<MeshOverdrawStats> sceneMeshStats;
+	for (u32 meshBatchIndex = 0; meshBatchIndex < pScene->GetNumMeshBatches(); ++meshBatchIndex)
+	{
+		const MeshBatch* pMeshBatch = pScene->GetMeshBatches()[meshBatchIndex];
+		for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+		{
+			MeshOverdrawStats meshStats;
+			meshStats.m_MeshBatchIndex = meshBatchIndex;
+			meshStats.m_MeshIndex = meshIndex;
+			meshStats.m_MaterialID = pMeshBatch->GetMeshInfos()[meshIndex].m_MaterialID;
+
+			sceneMeshStats.push_back(meshStats);
+		}
+	}
+
+	const u32 numViewpoints = u32(viewpoints.size());
+	
+	OverdrawStats stats;
+	stats.m_ViewpointStats.resize(numViewpoints);
+
+	// Each viewpoint counts the mesh fragments separately, so that the viewpoints do not share any state.
+	std::vector<std::vector<MeshOverdrawStats>> viewpointMeshStats(numViewpoints, sceneMeshStats);
+
+	auto analyzeViewpoint = [&](u32 viewpointIndex)
+	{
+		const Viewpoint& viewpoint = viewpoints[viewpointIndex];
+		
+		Matrix4f viewProjMatrix;
+		CalcViewProjMatrix(pScene, viewpoint, params, &viewProjMatrix);
+
+		stats.m_ViewpointStats[viewpointIndex].m_Viewpoint = viewpoint;
+		AnalyzeViewpoint(pScene, viewProjMatrix, viewpoint.m_WorldPosition, params, keepPixelStats,
+			&stats.m_ViewpointStats[viewpointIndex], &viewpointMeshStats[viewpointIndex]);
+	};
+	ParallelFor(numViewpoints, analyzeViewpoint);
+
+	for (const std::vector<MeshOverdrawStats>& meshStats : viewpointMeshStats)
+	{
+		for (std::size_t sceneMeshIndex = 0; sceneMeshIndex < meshStats.size(); ++sceneMeshIndex)
+		{
+			sceneMeshStats[sceneMeshIndex].m_NumFragments += meshStats[sceneMeshIndex].m_NumFragments;
+			sceneMeshStats[sceneMeshIndex].m_NumShadedFragments += meshStats[sceneMeshIndex].m_NumShadedFragments;
+			sceneMeshStats[sceneMeshIndex].m_NumShadedFragmentsSorted += meshStats[sceneMeshIndex].m_NumShadedFragmentsSorted;
+			sceneMeshStats[sceneMeshIndex].m_NumShadedQuads += meshStats[sceneMeshIndex].m_NumShadedQuads;
+		}
+	}
+
+	for (const MeshOverdrawStats& meshStats : sceneMeshStats)
+	{
+		if (meshStats.m_NumFragments > 0)
+			stats.m_MeshStats.push_back(meshStats);
+	}
+
+	return stats;
+}
+
+void CalcViewProjMatrix(Scene* pScene, const Viewpoint& viewpoint, const OverdrawParams& params, Matrix4f* pViewProjMatrix)
+{
+	const AxisAlignedBox& worldBounds = pScene->GetWorldBounds();
+	const Camera* pCamera = pScene->GetCamera();
+
+	const f32 fovYInRadians = (pCamera != nullptr) ? pCamera->GetFieldOfViewY() : PI_DIV_4;
+	const f32 nearClipDist = (pCamera != nullptr) ? pCamera->GetNearClipDistance() : 0.1f;
+	const f32 farClipDist = (pCamera != nullptr) ? pCamera->GetFarClipDistance() : 2.0f * Length(worldBounds.m_Radius);
+	const f32 aspectRatio = f32(params.m_Width) / f32(params.m_Height);
+
+	// The up direction is replaced when looking straight up or down.
+	const Vector3f upDir = (std::abs(viewpoint.m_WorldForward.m_Y) < 0.999f) ? Vector3f::UP : Vector3f::FORWARD;
+	
+	const Matrix4f viewMatrix = CreateLookAtMatrix(viewpoint.m_WorldPosition, viewpoint.m_WorldPosition + viewpoint.m_WorldForward, upDir);
+	const Matrix4f projMatrix = CreatePerspectiveFovProjMatrix(fovYInRadians, aspectRatio, nearClipDist, farClipDist);
+
+	*pViewProjMatrix = viewMatrix * projMatrix;
+}
+
+namespace
+{
+	Rasterizer::Rasterizer(u32 width, u32 height, bool cullBackFaces)
+		: m_Width(width)
+		, m_Height(height)
+		, m_CullBackFaces(cullBackFaces)
+		, m_DepthBuffer(width * height)
+	{
+	}
+
+	void Rasterizer::Reset(u16* pFragmentCounts, u16* pShadedCounts, u16* pHelperLaneCounts)
+	{
+		std::fill(m_DepthBuffer.begin(), m_DepthBuffer.end(), 1.0f);
+
+		m_pFragmentCounts = pFragmentCounts;
+		m_pShadedCounts = pShadedCounts;
+		m_pHelperLaneCounts = pHelperLaneCounts;
+	}
+
+	void Rasterizer::DrawMesh(const MeshBatch* pMeshBatch, u32 meshIndex, const Matrix4f& worldViewProjMatrix, RasterCounters* pCounters)
+	{
+		const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+		const Vector3f* pPositions = pMeshBatch->GetPositions() + meshInfo.m_BaseVertexLocation;
+
+		m_ClipPositions.resize(meshInfo.m_VertexCount);
+		for (u32 vertexIndex = 0; vertexIndex < meshInfo.m_VertexCount; ++vertexIndex)
+		{
+			const Vector3f& position = pPositions[vertexIndex];
+			m_ClipPositions[vertexIndex] = Vector4f(position.m_X, position.m_Y, position.m_Z, 1.0f) * worldViewProjMatrix;
+		}
+
+		const bool use16BitIndices = (pMeshBatch->GetIndexFormat() == DXGI_FORMAT_R16_UINT);
+		const u16* p16BitIndices = use16BitIndices ? pMeshBatch->Get16BitIndices() + meshInfo.m_StartIndexLocation : nullptr;
+		const u32* p32BitIndices = use16BitIndices ? nullptr : pMeshBatch->Get32BitIndices() + meshInfo.m_StartIndexLocation;
+
+		for (u32 index = 0; index + 2 < meshInfo.m_IndexCount; index += 3)
+		{
+			const u32 index0 = use16BitIndices ? p16BitIndices[index + 0] : p32BitIndices[index + 0];
+			const u32 index1 = use16BitIndices ? p16BitIndices[index + 1] : p32BitIndices[index + 1];
+			const u32 index2 = use16BitIndices ? p16BitIndices[index + 2] : p32BitIndices[index + 2];
+
+			DrawTriangle(m_ClipPositions[index0], m_ClipPositions[index1], m_ClipPositions[index2], pCounters);
+		}
+	}
+
+	void Rasterizer::DrawTriangle(const Vector4f& clipPosition0, const Vector4f& clipPosition1, const Vector4f& clipPosition2, RasterCounters* pCounters)
+	{
+		const Vector4f* clipPositions[] = {&clipPosition0, &clipPosition1, &clipPosition2};
+
+		// Triangles outside of a clip plane are rejected. Only the near plane (z >= 0) is clipped against,
+		// as the other planes are handled by the screen bounds and the depth range of the fragments.
+		bool outsideAllPlanes[] = {true, true, true, true, true, true};
+		bool crossesNearPlane = false;
+		for (const Vector4f* pClipPosition : clipPositions)
+		{
+			const Vector4f& clipPosition = *pClipPosition;
+			outsideAllPlanes[0] &= (clipPosition.m_X < -clipPosition.m_W);
+			outsideAllPlanes[1] &= (clipPosition.m_X > clipPosition.m_W);
+			outsideAllPlanes[2] &= (clipPosition.m_Y < -clipPosition.m_W);
+			outsideAllPlanes[3] &= (clipPosition.m_Y > clipPosition.m_W);
+			outsideAllPlanes[4] &= (clipPosition.m_Z < 0.0f);
+			outsideAllPlanes[5] &= (clipPosition.m_Z > clipPosition.m_W);
+			crossesNearPlane |= (clipPosition.m_Z < 0.0f);
+		}
+		for (bool outsidePlane : outsideAllPlanes)
+		{
+			if (outsidePlane)
+				return;
+		}
+
+		if (!crossesNearPlane)
+		{
+			RasterizeTriangle(ProjectToScreen(clipPosition0), ProjectToScreen(clipPosition1), ProjectToScreen(clipPosition2), pCounters);
+			return;
+		}
+
+		// Sutherland-Hodgman clipping against the near plane gives a triangle or a quad.
+		Vector4f clippedPositions[4];
+		u32 numClippedPositions = 0;
+		
+		for (u32 edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+		{
+			const Vector4f& startPosition = *clipPositions[edgeIndex];
+			const Vector4f& endPosition = *clipPositions[(edgeIndex + 1) % 3];
+
+			if (startPosition.m_Z >= 0.0f)
+				clippedPositions[numClippedPositions++] = startPosition;
+			
+			if ((startPosition.m_Z >= 0.0f) != (endPosition.m_Z >= 0.0f))
+			{
+				const f32 t = startPosition.m_Z / (startPosition.m_Z - endPosition.m_Z);
+				clippedPositions[numClippedPositions++] = Vector4f(
+					startPosition.m_X + t * (endPosition.m_X - startPosition.m_X),
+					startPosition.m_Y + t * (endPosition.m_Y - startPosition.m_Y),
+					0.0f,
+					startPosition.m_W + t * (endPosition.m_W - startPosition.m_W));
+			}
+		}
+		assert((numClippedPositions == 3) || (numClippedPositions == 4));
+
+		const ScreenVertex vertex0 = ProjectToScreen(clippedPositions[0]);
+		for (u32 vertexIndex = 2; vertexIndex < numClippedPositions; ++vertexIndex)
+			RasterizeTriangle(vertex0, ProjectToScreen(clippedPositions[vertexIndex - 1]), ProjectToScreen(clippedPositions[vertexIndex]), pCounters);
+	}
+
+	const ScreenVertex Rasterizer::ProjectToScreen(const Vector4f& clipPosition) const
+	{
+		const f32 rcpW = 1.0f / clipPosition.m_W;
+
+		ScreenVertex vertex;
+		vertex.m_X = (0.5f + 0.5f * clipPosition.m_X * rcpW) * f32(m_Width);
+		vertex.m_Y = (0.5f - 0.5f * clipPosition.m_Y * rcpW) * f32(m_Height);
+		vertex.m_Depth = clipPosition.m_Z * rcpW;
+
+		return vertex;
+	}
+
+	void Rasterizer::RasterizeTriangle(const ScreenVertex& vertex0, const ScreenVertex& vertex1, const ScreenVertex& vertex2, RasterCounters* pCounters)
+	{
+		// With the y axis pointing down, clockwise triangles have positive area. Clockwise triangles are front facing, as in RasterizerDesc::Default.
+		const f32 doubleArea = (vertex1.m_X - vertex0.m_X) * (vertex2.m_Y - vertex0.m_Y) - (vertex1.m_Y - vertex0.m_Y) * (vertex2.m_X - vertex0.m_X);
+		if ((doubleArea == 0.0f) || (m_CullBackFaces && (doubleArea < 0.0f)))
+			return;
+
+		const ScreenVertex* vertices[] = {&vertex0, (doubleArea > 0.0f) ? &vertex1 : &vertex2, (doubleArea > 0.0f) ? &vertex2 : &vertex1};
+		const f32 rcpDoubleArea = 1.0f / std::abs(doubleArea);
+
+		// Edge i goes from vertex i to vertex i + 1. Its edge function is positive inside the triangle
+		// and is the barycentric weight of the vertex opposite to the edge.
+		f32 edgeDeltaX[3];
+		f32 edgeDeltaY[3];
+		bool isTopLeftEdge[3];
+		for (u32 edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+		{
+			const ScreenVertex& startVertex = *vertices[edgeIndex];
+			const ScreenVertex& endVertex = *vertices[(edgeIndex + 1) % 3];
+
+			edgeDeltaX[edgeIndex] = endVertex.m_X - startVertex.m_X;
+			edgeDeltaY[edgeIndex] = endVertex.m_Y - startVertex.m_Y;
+			
+			// Top-left fill rule: pixel centers exactly on an edge belong to the triangle only if it is a top or a left edge.
+			isTopLeftEdge[edgeIndex] = ((edgeDeltaY[edgeIndex] == 0.0f) && (edgeDeltaX[edgeIndex] > 0.0f)) || (edgeDeltaY[edgeIndex] < 0.0f);
+		}
+
+		const f32 minX = Min(vertices[0]->m_X, Min(vertices[1]->m_X, vertices[2]->m_X));
+		const f32 maxX = Max(vertices[0]->m_X, Max(vertices[1]->m_X, vertices[2]->m_X));
+		const f32 minY = Min(vertices[0]->m_Y, Min(vertices[1]->m_Y, vertices[2]->m_Y));
+		const f32 maxY = Max(vertices[0]->m_Y, Max(vertices[1]->m_Y, vertices[2]->m_Y));
+
+		if ((maxX < 0.0f) || (maxY < 0.0f) || (minX >= f32(m_Width)) || (minY >= f32(m_Height)))
+			return;
+
+		// Quads start at even pixel coordinates, as on the GPU.
+		const i32 firstQuadX = i32(Max(0.0f, std::floor(minX))) & ~1;
+		const i32 firstQuadY = i32(Max(0.0f, std::floor(minY))) & ~1;
+		const i32 lastPixelX = Min(i32(m_Width) - 1, i32(std::floor(maxX)));
+		const i32 lastPixelY = Min(i32(m_Height) - 1, i32(std::floor(maxY)));
+
+		for (i32 quadY = firstQuadY; quadY <= lastPixelY; quadY += 2)
+		{
+			for (i32 quadX = firstQuadX; quadX <= lastPixelX; quadX += 2)
+			{
+				u32 numShadedLanes = 0;
+				u32 pixelIndices[4];
+				bool inScreen[4];
+				bool shaded[4];
+
+				for (u32 laneIndex = 0; laneIndex < 4; ++laneIndex)
+				{
+					const i32 pixelX = quadX + i32(laneIndex & 1);
+					const i32 pixelY = quadY + i32(laneIndex >> 1);
+
+					inScreen[laneIndex] = (pixelX < i32(m_Width)) && (pixelY < i32(m_Height));
+					shaded[laneIndex] = false;
+					if (!inScreen[laneIndex])
+						continue;
+					
+					pixelIndices[laneIndex] = u32(pixelY) * m_Width + u32(pixelX);
+
+					const f32 pixelCenterX = f32(pixelX) + 0.5f;
+					const f32 pixelCenterY = f32(pixelY) + 0.5f;
+
+					f32 edgeValues[3];
+					bool covered = true;
+					for (u32 edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+					{
+						const ScreenVertex& startVertex = *vertices[edgeIndex];
+						edgeValues[edgeIndex] = edgeDeltaX[edgeIndex] * (pixelCenterY - startVertex.m_Y) - edgeDeltaY[edgeIndex] * (pixelCenterX - startVertex.m_X);
+						covered &= (edgeValues[edgeIndex] > 0.0f) || ((edgeValues[edgeIndex] == 0.0f) && isTopLeftEdge[edgeIndex]);
+					}
+					if (!covered)
+						continue;
+
+					const f32 depth = rcpDoubleArea * (edgeValues[1] * vertices[0]->m_Depth + edgeValues[2] * vertices[1]->m_Depth + edgeValues[0] * vertices[2]->m_Depth);
+					if ((depth < 0.0f) || (depth > 1.0f))
+						continue;
+
+					++pCounters->m_NumFragments;
+					if (m_pFragmentCounts != nullptr)
+						IncrementSaturated(m_pFragmentCounts, pixelIndices[laneIndex]);
+
+					if (depth < m_DepthBuffer[pixelIndices[laneIndex]])
+					{
+						m_DepthBuffer[pixelIndices[laneIndex]] = depth;
+						shaded[laneIndex] = true;
+						++numShadedLanes;
+
+						if (m_pShadedCounts != nullptr)
+							IncrementSaturated(m_pShadedCounts, pixelIndices[laneIndex]);
+					}
+				}
+
+				if (numShadedLanes == 0)
+					continue;
+
+				pCounters->m_NumShadedFragments += numShadedLanes;
+				++pCounters->m_NumShadedQuads;
+
+				if (m_pHelperLaneCounts != nullptr)
+				{
+					for (u32 laneIndex = 0; laneIndex < 4; ++laneIndex)
+					{
+						if (inScreen[laneIndex] && !shaded[laneIndex])
+							IncrementSaturated(m_pHelperLaneCounts, pixelIndices[laneIndex]);
+					}
+				}
+			}
+		}
+	}
+
+	void AnalyzeViewpoint(Scene* pScene, const Matrix4f& viewProjMatrix, const Vector3f& cameraWorldPosition, const OverdrawParams& params,
+		bool keepPixelStats, ViewpointOverdrawStats* pViewpointStats, std::vector<MeshOverdrawStats>* pMeshStats)
+	{
+		const Frustum frustum(viewProjMatrix);
+		
+		std::vector<DrawItem> drawItems;
+		u32 firstSceneMeshIndex = 0;
+
+		for (u32 meshBatchIndex = 0; meshBatchIndex < pScene->GetNumMeshBatches(); ++meshBatchIndex)
+		{
+			const MeshBatch* pMeshBatch = pScene->GetMeshBatches()[meshBatchIndex];
+			const AxisAlignedBox* pInstanceWorldAABBs = pMeshBatch->GetMeshInstanceWorldAABBs();
+
+			for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+			{
+				const MeshInfo& meshInfo = pMeshBatch->GetMeshInfos()[meshIndex];
+				for (u32 meshInstanceIndex = 0; meshInstanceIndex < meshInfo.m_InstanceCount; ++meshInstanceIndex)
+				{
+					const u32 instanceIndex = meshInfo.m_InstanceOffset + meshInstanceIndex;
+					const AxisAlignedBox& instanceWorldAABB = pInstanceWorldAABBs[instanceIndex];
+					
+					if (TestAABBAgainstFrustum(frustum, instanceWorldAABB))
+					{
+						const f32 sqDistanceToCamera = LengthSquared(instanceWorldAABB.m_Center - cameraWorldPosition);
+						drawItems.push_back({meshBatchIndex, meshIndex, instanceIndex, firstSceneMeshIndex + meshIndex, sqDistanceToCamera});
+					}
+				}
+			}
+			firstSceneMeshIndex += pMeshBatch->GetNumMeshes();
+		}
+
+		const u32 numPixels = params.m_Width * params.m_Height;
+		std::vector<u16> fragmentCounts(numPixels, 0);
+		std::vector<u16> shadedCounts(numPixels, 0);
+		std::vector<u16> shadedCountsSorted(numPixels, 0);
+		std::vector<u16> helperLaneCounts(numPixels, 0);
+
+		Rasterizer rasterizer(params.m_Width, params.m_Height, params.m_CullBackFaces);
+
+		auto drawItemsInOrder = [&](bool sorted)
+		{
+			for (const DrawItem& drawItem : drawItems)
+			{
+				const MeshBatch* pMeshBatch = pScene->GetMeshBatches()[drawItem.m_MeshBatchIndex];
+				const Matrix4f worldViewProjMatrix = pMeshBatch->GetMeshInstanceWorldMatrices()[drawItem.m_InstanceIndex] * viewProjMatrix;
+
+				RasterCounters counters;
+				rasterizer.DrawMesh(pMeshBatch, drawItem.m_MeshIndex, worldViewProjMatrix, &counters);
+
+				MeshOverdrawStats& meshStats = (*pMeshStats)[drawItem.m_SceneMeshIndex];
+				if (sorted)
+				{
+					meshStats.m_NumShadedFragmentsSorted += counters.m_NumShadedFragments;
+					pViewpointStats->m_NumShadedFragmentsSorted += counters.m_NumShadedFragments;
+				}
+				else
+				{
+					meshStats.m_NumFragments += counters.m_NumFragments;
+					meshStats.m_NumShadedFragments += counters.m_NumShadedFragments;
+					meshStats.m_NumShadedQuads += counters.m_NumShadedQuads;
+
+					pViewpointStats->m_NumFragments += counters.m_NumFragments;
+					pViewpointStats->m_NumShadedFragments += counters.m_NumShadedFragments;
+					pViewpointStats->m_NumShadedQuads += counters.m_NumShadedQuads;
+				}
+			}
+		};
+
+		rasterizer.Reset(fragmentCounts.data(), shadedCounts.data(), helperLaneCounts.data());
+		drawItemsInOrder(false);
+
+		auto isCloser = [](const DrawItem& drawItem1, const DrawItem& drawItem2)
+		{
+			return drawItem1.m_SqDistanceToCamera < drawItem2.m_SqDistanceToCamera;
+		};
+		std::stable_sort(drawItems.begin(), drawItems.end(), isCloser);
+		
+		rasterizer.Reset(nullptr, shadedCountsSorted.data(), nullptr);
+		drawItemsInOrder(true);
+
+		pViewpointStats->m_NumVisibleInstances = u32(drawItems.size());
+		for (u16 fragmentCount : fragmentCounts)
+		{
+			if (fragmentCount > 0)
+				++pViewpointStats->m_NumCoveredPixels;
+			pViewpointStats->m_MaxDepthComplexity = Max(pViewpointStats->m_MaxDepthComplexity, u32(fragmentCount));
+		}
+
+		if (keepPixelStats)
+		{
+			pViewpointStats->m_DepthComplexity = std::move(fragmentCounts);
+			pViewpointStats->m_Overdraw = std::move(shadedCounts);
+			pViewpointStats->m_OverdrawSorted = std::move(shadedCountsSorted);
+			pViewpointStats->m_HelperLanes = std::move(helperLaneCounts);
+		}
+	}
+
+	void IncrementSaturated(u16* pCounts, u32 pixelIndex)
+	{
+		if (pCounts[pixelIndex] < 0xFFFF)
+			++pCounts[pixelIndex];
+	}
+}
\ No newline at end of file
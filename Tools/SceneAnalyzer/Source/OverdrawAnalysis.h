@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Math/Vector3.h"
+
+struct Matrix4f;
+class Scene;
+
+struct Viewpoint
+{
+	Vector3f m_WorldPosition;
+	Vector3f m_WorldForward;
+};
+
+struct OverdrawParams
+{
+	u32 m_Width = 640;
+	u32 m_Height = 360;
+	// Back faces are culled and the depth test is LESS, as in RenderGBufferPass.
+	bool m_CullBackFaces = true;
+};
+
+// Fragment counts of a mesh, summed over its instances.
+struct MeshOverdrawStats
+{
+	u32 m_MeshBatchIndex = 0;
+	u32 m_MeshIndex = 0;
+	u32 m_MaterialID = 0;
+	// Fragments covered by the triangles, whether they pass the depth test or not.
+	u64 m_NumFragments = 0;
+	// Fragments passing the depth test, which run the pixel shader, in the batch order and in the front-to-back order.
+	u64 m_NumShadedFragments = 0;
+	u64 m_NumShadedFragmentsSorted = 0;
+	// 2x2 quads with at least one shaded fragment in the batch order. Each of them runs 4 pixel shader lanes.
+	u64 m_NumShadedQuads = 0;
+};
+
+struct ViewpointOverdrawStats
+{
+	Viewpoint m_Viewpoint;
+	u32 m_NumVisibleInstances = 0;
+	// Pixels covered by at least one fragment.
+	u32 m_NumCoveredPixels = 0;
+	u32 m_MaxDepthComplexity = 0;
+	u64 m_NumFragments = 0;
+	u64 m_NumShadedFragments = 0;
+	u64 m_NumShadedFragmentsSorted = 0;
+	u64 m_NumShadedQuads = 0;
+
+	// Per pixel, row by row. Filled only if requested.
+	std::vector<u16> m_DepthComplexity;
+	std::vector<u16> m_Overdraw;
+	std::vector<u16> m_OverdrawSorted;
+	// Helper lanes: pixels which are not shaded but run the pixel shader as part of a shaded quad.
+	std::vector<u16> m_HelperLanes;
+};
+
+struct OverdrawStats
+{
+	std::vector<ViewpointOverdrawStats> m_ViewpointStats;
+	// Meshes with at least one fragment from any viewpoint, in the order of the mesh batches and meshes.
+	std::vector<MeshOverdrawStats> m_MeshStats;
+};
+
+// Viewpoints spread over the scene world bounds, looking horizontally in random directions, together with the scene camera.
+// The same seed gives the same viewpoints.
+void SampleViewpoints(Scene* pScene, u32 numViewpoints, u32 seed, std::vector<Viewpoint>* pViewpoints);
+
+// Reads viewpoints recorded as lines "px py pz fx fy fz" of the world position and the forward direction.
+// Empty lines and lines starting with # are skipped. Returns false if the file cannot be read or a line is malformed.
+bool LoadViewpoints(const char* pFilePath, std::vector<Viewpoint>* pViewpoints);
+
+// View projection matrix of the viewpoint with the field of view and the clip distances of the scene camera.
+void CalcViewProjMatrix(Scene* pScene, const Viewpoint& viewpoint, const OverdrawParams& params, Matrix4f* pViewProjMatrix);
+
+// Rasterizes the instances of the mesh batches which pass the frustum test from each viewpoint on the CPU,
+// using the field of view and the clip distances of the scene camera.
+// The instances are drawn twice: in the batch order, as RenderGBufferPass draws them, and sorted front to back by their bounds center.
+// Viewpoints are processed in parallel.
+const OverdrawStats AnalyzeOverdraw(Scene* pScene, const std::vector<Viewpoint>& viewpoints, const OverdrawParams& params, bool keepPixelStats);
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "SceneBenchmark.h"
+#include "Common/StringUtilities.h"
+
+namespace
+{
+	void PrintUsage();
+}
+
+// Usage: SceneBenchmark [-seed N] [-minmeshes N] [-maxmeshes N] [-instances N] [-minlights N] [-maxlights N]
+//                       [-clusters N] [-repeat N] [-cooked path] [-out path]
+int main(int argc, char** argv)
+{
+	SceneBenchmarkParams params;
+	std::string outputFilePath;
+
+	for (int argIndex = 1; argIndex < argc; ++argIndex)
+	{
+		const char* pArgName = argv[argIndex];
+		if (argIndex + 1 == argc)
+		{
+			PrintUsage();
+			return 1;
+		}
+		const char* pArgValue = argv[++argIndex];
+		
+		if (AreEqual(pArgName, "-seed"))
+			params.m_Seed = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-minmeshes"))
+			params.m_MinNumMeshes = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-maxmeshes"))
+			params.m_MaxNumMeshes = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-instances"))
+			params.m_MaxNumInstancesPerMesh = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-minlights"))
+			params.m_MinNumLights = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-maxlights"))
+			params.m_MaxNumLights = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-clusters"))
+			params.m_NumClusters = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-repeat"))
+			params.m_NumRepeats = std::strtoul(pArgValue, nullptr, 10);
+		else if (AreEqual(pArgName, "-cooked"))
+			params.m_CookedSceneFilePath = AnsiToWideString(pArgValue);
+		else if (AreEqual(pArgName, "-out"))
+			outputFilePath = pArgValue;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	const bool validParams = (params.m_MinNumMeshes > 0) && (params.m_MinNumMeshes <= params.m_MaxNumMeshes) &&
+		(params.m_MinNumLights > 0) && (params.m_MinNumLights <= params.m_MaxNumLights) &&
+		(params.m_MaxNumInstancesPerMesh > 0) && (params.m_NumRepeats > 0);
+	if (!validParams)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (outputFilePath.empty())
+	{
+		RunSceneBenchmark(params, std::cout);
+	}
+	else
+	{
+		std::ofstream outputFile(outputFilePath);
+		if (!outputFile)
+		{
+			std::cerr << "Failed to open " << outputFilePath << std::endl;
+			return 1;
+		}
+		RunSceneBenchmark(params, outputFile);
+	}
+	
+	return 0;
+}
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cerr << "Usage: SceneBenchmark [-seed N] [-minmeshes N] [-maxmeshes N] [-instances N] [-minlights N] [-maxlights N]"
+			" [-clusters N] [-repeat N] [-cooked path] [-out path]" << std::endl;
+	}
+}
\ No newline at end of file
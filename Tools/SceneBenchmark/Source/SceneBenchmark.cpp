@@ -0,0 +1,278 @@
+#include "SceneBenchmark.h"
+#include "Scene/ProceduralScene.h"
+#include "Scene/CookedScene.h"
+#include "Scene/SceneChunks.h"
+#include "Scene/Scene.h"
+#include "Scene/Camera.h"
+#include "Scene/Light.h"
+#include "Math/Frustum.h"
+#include "Math/Sphere.h"
+#include "Math/OverlapTest.h"
+#include "Math/Transform.h"
+
+namespace
+{
+	enum BenchmarkStep
+	{
+		BenchmarkStep_Generate = 0,
+		BenchmarkStep_SortByMortonCode,
+		BenchmarkStep_BuildMeshClusters,
+		BenchmarkStep_SelectVertexCompression,
+		BenchmarkStep_WriteCookedScene,
+		BenchmarkStep_LoadCookedScene,
+		BenchmarkStep_BuildSceneChunks,
+		BenchmarkStep_CullMeshInstances,
+		BenchmarkStep_CullLights,
+		BenchmarkStep_UpdateMeshInstances,
+		kNumBenchmarkSteps
+	};
+
+	const char* kBenchmarkStepNames[kNumBenchmarkSteps] =
+	{
+		"GenerateMs",
+		"SortByMortonCodeMs",
+		"BuildMeshClustersMs",
+		"SelectVertexCompressionMs",
+		"WriteCookedSceneMs",
+		"LoadCookedSceneMs",
+		"BuildSceneChunksMs",
+		"CullMeshInstancesMs",
+		"CullLightsMs",
+		"UpdateMeshInstancesMs"
+	};
+
+	// Chunk size used by the scene streaming defaults (see SceneStreamingParams).
+	const f32 kChunkSize = 100.0f;
+	
+	// Every n-th mesh instance is made dynamic and moved in the instance update step.
+	const u32 kDynamicMeshInstanceInterval = 8;
+
+	struct BenchmarkCase
+	{
+		const char* m_pDistributionName;
+		u32 m_NumClusters;
+		u32 m_NumMeshes;
+		u32 m_NumLights;
+	};
+
+	struct SceneStats
+	{
+		u32 m_NumMeshes = 0;
+		u32 m_NumInstances = 0;
+		u32 m_NumVertices = 0;
+		u32 m_NumIndices = 0;
+		u32 m_NumMeshClusters = 0;
+		u32 m_NumChunks = 0;
+		u32 m_NumVisibleInstances = 0;
+		u32 m_NumVisibleLights = 0;
+	};
+
+	class Timer
+	{
+	public:
+		Timer();
+		f64 GetElapsedTimeInMilliseconds() const;
+
+	private:
+		LARGE_INTEGER m_StartCounter;
+	};
+
+	void RunBenchmarkCase(const SceneBenchmarkParams& params, const BenchmarkCase& benchmarkCase, std::ostream& outputStream);
+	f64 CalcMedian(std::vector<f64> values);
+}
+
+void RunSceneBenchmark(const SceneBenchmarkParams& params, std::ostream& outputStream)
+{
+	assert((params.m_MinNumMeshes > 0) && (params.m_MinNumMeshes <= params.m_MaxNumMeshes));
+	assert((params.m_MinNumLights > 0) && (params.m_MinNumLights <= params.m_MaxNumLights));
+	assert(params.m_NumRepeats > 0);
+
+	std::vector<BenchmarkCase> benchmarkCases;
+	for (u32 numClusters : {0u, params.m_NumClusters})
+	{
+		const char* pDistributionName = (numClusters == 0) ? "Scattered" : "Clustered";
+
+		for (u32 numMeshes = params.m_MinNumMeshes; numMeshes <= params.m_MaxNumMeshes; numMeshes *= 2)
+			benchmarkCases.push_back({pDistributionName, numClusters, numMeshes, params.m_MinNumLights});
+
+		for (u32 numLights = 2 * params.m_MinNumLights; numLights <= params.m_MaxNumLights; numLights *= 2)
+			benchmarkCases.push_back({pDistributionName, numClusters, params.m_MinNumMeshes, numLights});
+	}
+
+	outputStream << "Distribution,NumMeshes,NumInstances,NumVertices,NumIndices,NumLights,NumMeshClusters,NumChunks,NumVisibleInstances,NumVisibleLights";
+	for (const char* pStepName : kBenchmarkStepNames)
+		outputStream << "," << pStepName;
+	outputStream << std::endl;
+
+	for (const BenchmarkCase& benchmarkCase : benchmarkCases)
+		RunBenchmarkCase(params, benchmarkCase, outputStream);
+
+	std::error_code errorCode;
+	std::filesystem::remove(params.m_CookedSceneFilePath, errorCode);
+}
+
+namespace
+{
+	Timer::Timer()
+	{
+		VerifyWinAPIResult(QueryPerformanceCounter(&m_StartCounter));
+	}
+
+	f64 Timer::GetElapsedTimeInMilliseconds() const
+	{
+		LARGE_INTEGER frequency;
+		VerifyWinAPIResult(QueryPerformanceFrequency(&frequency));
+
+		LARGE_INTEGER endCounter;
+		VerifyWinAPIResult(QueryPerformanceCounter(&endCounter));
+
+		return (f64(endCounter.QuadPart - m_StartCounter.QuadPart) / f64(frequency.QuadPart)) * 1000.0;
+	}
+
+	void RunBenchmarkCase(const SceneBenchmarkParams& params, const BenchmarkCase& benchmarkCase, std::ostream& outputStream)
+	{
+		ProceduralSceneParams sceneParams;
+		sceneParams.m_Seed = params.m_Seed;
+		sceneParams.m_NumClusters = benchmarkCase.m_NumClusters;
+		sceneParams.m_NumMeshes = benchmarkCase.m_NumMeshes;
+		sceneParams.m_MaxNumInstancesPerMesh = params.m_MaxNumInstancesPerMesh;
+		sceneParams.m_NumSpotLights = benchmarkCase.m_NumLights / 2;
+		sceneParams.m_NumPointLights = benchmarkCase.m_NumLights - sceneParams.m_NumSpotLights;
+		sceneParams.m_PrepareMeshBatch = false;
+
+		std::vector<f64> stepTimes[kNumBenchmarkSteps];
+		SceneStats sceneStats;
+
+		for (u32 repeatIndex = 0; repeatIndex < params.m_NumRepeats; ++repeatIndex)
+		{
+			Timer generateTimer;
+			Scene* pScene = GenerateProceduralScene(sceneParams);
+			stepTimes[BenchmarkStep_Generate].push_back(generateTimer.GetElapsedTimeInMilliseconds());
+
+			assert(pScene->GetNumMeshBatches() == 1);
+			MeshBatch* pMeshBatch = pScene->GetMeshBatches()[0];
+
+			Timer sortTimer;
+			pMeshBatch->SortByMortonCode(true);
+			stepTimes[BenchmarkStep_SortByMortonCode].push_back(sortTimer.GetElapsedTimeInMilliseconds());
+
+			Timer buildClustersTimer;
+			pMeshBatch->BuildMeshClusters();
+			stepTimes[BenchmarkStep_BuildMeshClusters].push_back(buildClustersTimer.GetElapsedTimeInMilliseconds());
+
+			Timer compressionTimer;
+			pMeshBatch->SelectVertexCompression(VertexPrecisionBudget());
+			stepTimes[BenchmarkStep_SelectVertexCompression].push_back(compressionTimer.GetElapsedTimeInMilliseconds());
+
+			Timer writeTimer;
+			const bool writeResult = WriteCookedScene(params.m_CookedSceneFilePath.c_str(), pScene);
+			stepTimes[BenchmarkStep_WriteCookedScene].push_back(writeTimer.GetElapsedTimeInMilliseconds());
+			assert(writeResult);
+
+			Timer loadTimer;
+			Scene* pLoadedScene = LoadCookedScene(params.m_CookedSceneFilePath.c_str());
+			stepTimes[BenchmarkStep_LoadCookedScene].push_back(loadTimer.GetElapsedTimeInMilliseconds());
+			assert(pLoadedScene != nullptr);
+			SafeDelete(pLoadedScene);
+
+			std::vector<SceneChunk> chunks;
+			Timer buildChunksTimer;
+			BuildSceneChunks(pScene, kChunkSize, &chunks);
+			stepTimes[BenchmarkStep_BuildSceneChunks].push_back(buildChunksTimer.GetElapsedTimeInMilliseconds());
+
+			const Frustum cameraFrustum(pScene->GetCamera()->GetViewProjMatrix());
+
+			u32 numVisibleInstances = 0;
+			Timer cullInstancesTimer;
+			{
+				const AxisAlignedBox* pInstanceWorldAABBs = pMeshBatch->GetMeshInstanceWorldAABBs();
+				for (u32 instanceIndex = 0; instanceIndex < pMeshBatch->GetNumMeshInstances(); ++instanceIndex)
+				{
+					if (TestAABBAgainstFrustum(cameraFrustum, pInstanceWorldAABBs[instanceIndex]))
+						++numVisibleInstances;
+				}
+			}
+			stepTimes[BenchmarkStep_CullMeshInstances].push_back(cullInstancesTimer.GetElapsedTimeInMilliseconds());
+
+			u32 numVisibleLights = 0;
+			Timer cullLightsTimer;
+			{
+				for (std::size_t lightIndex = 0; lightIndex < pScene->GetNumSpotLights(); ++lightIndex)
+				{
+					const SpotLight* pSpotLight = pScene->GetSpotLights()[lightIndex];
+					if (TestSphereAgainstFrustum(cameraFrustum, Sphere(pSpotLight->GetWorldPosition(), pSpotLight->GetRange())))
+						++numVisibleLights;
+				}
+				for (std::size_t lightIndex = 0; lightIndex < pScene->GetNumPointLights(); ++lightIndex)
+				{
+					const PointLight* pPointLight = pScene->GetPointLights()[lightIndex];
+					if (TestSphereAgainstFrustum(cameraFrustum, Sphere(pPointLight->GetWorldPosition(), pPointLight->GetRange())))
+						++numVisibleLights;
+				}
+			}
+			stepTimes[BenchmarkStep_CullLights].push_back(cullLightsTimer.GetElapsedTimeInMilliseconds());
+
+			for (u32 instanceIndex = 0; instanceIndex < pMeshBatch->GetNumMeshInstances(); instanceIndex += kDynamicMeshInstanceInterval)
+				pMeshBatch->SetMeshInstanceFlags(instanceIndex, MeshBatch::MeshInstanceFlag_Dynamic);
+
+			std::vector<MeshBatch::MeshInstanceRange> dirtyInstanceRanges;
+			Timer updateInstancesTimer;
+			{
+				const Matrix4f offsetMatrix = CreateTranslationMatrix(0.0f, 0.1f, 0.0f);
+				const MeshInfo* pMeshInfos = pMeshBatch->GetMeshInfos();
+				
+				for (u32 meshIndex = 0; meshIndex < pMeshBatch->GetNumMeshes(); ++meshIndex)
+				{
+					const MeshInfo& meshInfo = pMeshInfos[meshIndex];
+					for (u32 meshInstanceIndex = 0; meshInstanceIndex < meshInfo.m_InstanceCount; ++meshInstanceIndex)
+					{
+						const u32 instanceIndex = meshInfo.m_InstanceOffset + meshInstanceIndex;
+						if (pMeshBatch->IsMeshInstanceDynamic(instanceIndex))
+						{
+							const Matrix4f worldMatrix = pMeshBatch->GetMeshInstanceWorldMatrices()[instanceIndex] * offsetMatrix;
+							pMeshBatch->SetMeshInstanceWorldMatrix(meshIndex, meshInstanceIndex, worldMatrix);
+						}
+					}
+				}
+				pMeshBatch->ExtractDirtyMeshInstanceRanges(&dirtyInstanceRanges);
+			}
+			stepTimes[BenchmarkStep_UpdateMeshInstances].push_back(updateInstancesTimer.GetElapsedTimeInMilliseconds());
+
+			sceneStats.m_NumMeshes = pMeshBatch->GetNumMeshes();
+			sceneStats.m_NumInstances = pMeshBatch->GetNumMeshInstances();
+			sceneStats.m_NumVertices = pMeshBatch->GetNumVertices();
+			sceneStats.m_NumIndices = pMeshBatch->GetNumIndices();
+			sceneStats.m_NumMeshClusters = pMeshBatch->GetNumMeshClusters();
+			sceneStats.m_NumChunks = u32(chunks.size());
+			sceneStats.m_NumVisibleInstances = numVisibleInstances;
+			sceneStats.m_NumVisibleLights = numVisibleLights;
+
+			SafeDelete(pScene);
+		}
+
+		outputStream << benchmarkCase.m_pDistributionName
+			<< "," << sceneStats.m_NumMeshes
+			<< "," << sceneStats.m_NumInstances
+			<< "," << sceneStats.m_NumVertices
+			<< "," << sceneStats.m_NumIndices
+			<< "," << benchmarkCase.m_NumLights
+			<< "," << sceneStats.m_NumMeshClusters
+			<< "," << sceneStats.m_NumChunks
+			<< "," << sceneStats.m_NumVisibleInstances
+			<< "," << sceneStats.m_NumVisibleLights;
+
+		for (u32 stepIndex = 0; stepIndex < kNumBenchmarkSteps; ++stepIndex)
+			outputStream << "," << CalcMedian(stepTimes[stepIndex]);
+		outputStream << std::endl;
+	}
+
+	f64 CalcMedian(std::vector<f64> values)
+	{
+		assert(!values.empty());
+		
+		const std::size_t middleIndex = values.size() / 2;
+		std::nth_element(values.begin(), values.begin() + middleIndex, values.end());
+		
+		return values[middleIndex];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Common/Common.h"
+
+struct SceneBenchmarkParams
+{
+	u32 m_Seed = 1;
+	
+	// The mesh count doubles from the min to the max count, with the min light count.
+	u32 m_MinNumMeshes = 1024;
+	u32 m_MaxNumMeshes = 65536;
+	u32 m_MaxNumInstancesPerMesh = 16;
+
+	// The light count doubles from the min to the max count, with the min mesh count.
+	// Lights are split evenly between spot and point lights.
+	u32 m_MinNumLights = 64;
+	u32 m_MaxNumLights = 16384;
+
+	// Every scene size is measured with instances and lights scattered over the world bounds
+	// and again with them grouped into the clusters.
+	u32 m_NumClusters = 16;
+
+	// The median time over the repeats is reported for each step.
+	u32 m_NumRepeats = 3;
+
+	// The cooked scene is written to and loaded from the file, which is deleted at the end.
+	std::wstring m_CookedSceneFilePath = L"SceneBenchmark.cooked";
+};
+
+// Measures the CPU-side scene pipeline on procedural scenes of growing size:
+// generation, mesh batch preparation, cooked scene writing and loading, chunk building, frustum culling of mesh instances
+// and lights, and dynamic mesh instance updates. Writes a CSV header and a row per scene with the scene statistics
+// and the time of each step in milliseconds, so that the rows can be plotted as scaling curves.
+void RunSceneBenchmark(const SceneBenchmarkParams& params, std::ostream& outputStream);
\ No newline at end of file